@@ -0,0 +1,116 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__BAG_INDEX__BAG_INDEX_HPP_
+#define AUTOWARE__BAG_INDEX__BAG_INDEX_HPP_
+
+#include <rcutils/time.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::bag_index
+{
+using Stamp = rcutils_time_point_value_t;
+
+struct IndexEntry
+{
+  // the time the message was recorded at, which the reader seeks with
+  Stamp stamp;
+  // index of the split file of the bag in BagIndex::getFilePaths
+  uint32_t file_index;
+};
+
+/**
+ * @brief stamps and split files of the messages of some topics of a bag, which are sorted by the
+ * stamps, so that a message is found with a binary search instead of a scan of the bag
+ */
+class BagIndex
+{
+public:
+  // called with the progress in [0, 1] while building, which is cancelled if it returns false
+  using ProgressCallback = std::function<bool(const double)>;
+  using EntryIterator = std::vector<IndexEntry>::const_iterator;
+
+  BagIndex() = default;
+  BagIndex(
+    const std::string & storage_id, const std::vector<std::string> & file_paths,
+    const std::vector<std::string> & topics);
+
+  /**
+   * @brief build the index by reading the split files of the bag in parallel
+   * @param [in] uri directory of the bag, or a bag file
+   * @param [in] topics topics to index
+   * @param [in] thread_num number of the files read at once
+   * @return nullopt if cancelled by the progress callback
+   */
+  static std::optional<BagIndex> build(
+    const std::string & uri, const std::vector<std::string> & topics, const size_t thread_num = 1,
+    const ProgressCallback & progress_callback = {});
+
+  /**
+   * @brief load the index cached next to the bag if it is for the same files and contains the
+   * topics, otherwise build the index and cache it
+   */
+  static std::optional<BagIndex> loadOrBuild(
+    const std::string & uri, const std::vector<std::string> & topics, const size_t thread_num = 1,
+    const ProgressCallback & progress_callback = {});
+
+  static std::optional<BagIndex> load(const std::string & path);
+  bool save(const std::string & path) const;
+
+  /**
+   * @brief path of the index cached for the bag by loadOrBuild
+   */
+  static std::string getCachePath(const std::string & uri);
+
+  /**
+   * @brief storage id and paths of the split files of the bag
+   */
+  static std::pair<std::string, std::vector<std::string>> getBagFiles(const std::string & uri);
+
+  void addEntry(const std::string & topic, const IndexEntry & entry);
+  // to be called after adding the entries
+  void sortEntries();
+
+  const std::string & getStorageId() const { return storage_id_; }
+  const std::vector<std::string> & getFilePaths() const { return file_paths_; }
+  const std::vector<std::string> & getTopics() const { return topics_; }
+  bool hasTopic(const std::string & topic) const;
+
+  const std::vector<IndexEntry> & getEntries(const std::string & topic) const;
+  // the first entry at or after the stamp, which the reader returns after a seek to the stamp
+  std::optional<IndexEntry> lowerBound(const std::string & topic, const Stamp stamp) const;
+  std::optional<IndexEntry> last(const std::string & topic) const;
+  // the entries in [begin, end)
+  std::pair<EntryIterator, EntryIterator> range(
+    const std::string & topic, const Stamp begin, const Stamp end) const;
+
+private:
+  std::string storage_id_;
+  std::vector<std::string> file_paths_;
+  // the sizes of the files when indexed, to find that a cached index is outdated
+  std::vector<uint64_t> file_sizes_;
+  std::vector<std::string> topics_;
+  std::map<std::string, std::vector<IndexEntry>> entries_;
+};
+
+}  // namespace autoware::bag_index
+
+#endif  // AUTOWARE__BAG_INDEX__BAG_INDEX_HPP_
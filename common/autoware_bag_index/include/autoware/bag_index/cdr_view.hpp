@@ -0,0 +1,467 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__BAG_INDEX__CDR_VIEW_HPP_
+#define AUTOWARE__BAG_INDEX__CDR_VIEW_HPP_
+
+#include <rcutils/types/uint8_array.h>
+
+#include <builtin_interfaces/msg/time.hpp>
+#include <geometry_msgs/msg/point.hpp>
+#include <geometry_msgs/msg/quaternion.hpp>
+#include <geometry_msgs/msg/vector3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace autoware::bag_index::cdr
+{
+/**
+ * @brief read a primitive in the byte order of the buffer
+ */
+template <class T>
+T readValue(const uint8_t * data, const bool is_little_endian)
+{
+  uint8_t bytes[sizeof(T)];
+  std::memcpy(bytes, data, sizeof(T));
+  constexpr uint16_t endian_check = 1;
+  const bool is_host_little_endian = *reinterpret_cast<const uint8_t *>(&endian_check) == 1;
+  if (is_little_endian != is_host_little_endian) {
+    for (size_t i = 0; i < sizeof(T) / 2; ++i) {
+      std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+    }
+  }
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+/**
+ * @brief cursor over a CDR buffer, which reads the fields in place in the order of the message
+ * without deserializing or allocating anything. A read past the end of the buffer fails, and so
+ * do all the reads after it.
+ */
+class CdrView
+{
+public:
+  // the encapsulation header, whose second byte is 1 for little endian
+  static constexpr size_t encapsulation_size = 4;
+
+  /**
+   * @return nullopt if the buffer is not plain CDR
+   */
+  static std::optional<CdrView> create(const rcutils_uint8_array_t & buffer)
+  {
+    if (!buffer.buffer || buffer.buffer_length < encapsulation_size) {
+      return std::nullopt;
+    }
+    if (buffer.buffer[0] != 0 || buffer.buffer[1] > 1) {
+      return std::nullopt;
+    }
+    return CdrView(buffer.buffer, buffer.buffer_length, buffer.buffer[1] == 1);
+  }
+
+  bool ok() const { return ok_; }
+
+  bool isLittleEndian() const { return is_little_endian_; }
+
+  /**
+   * @brief align the cursor to the size of a primitive, relative to the end of the encapsulation
+   */
+  void align(const size_t alignment)
+  {
+    const size_t relative = offset_ - encapsulation_size;
+    offset_ = encapsulation_size + (relative + alignment - 1) / alignment * alignment;
+  }
+
+  template <class T>
+  bool read(T & value)
+  {
+    align(sizeof(T));
+    if (!reserve(sizeof(T))) {
+      return false;
+    }
+    value = readValue<T>(data_ + offset_, is_little_endian_);
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  /**
+   * @brief the string refers to the buffer, without the null terminator
+   */
+  bool readString(std::string_view & value)
+  {
+    uint32_t length = 0;
+    if (!read(length) || !reserve(length)) {
+      return false;
+    }
+    const auto * chars = reinterpret_cast<const char *>(data_ + offset_);
+    value = std::string_view(chars, 0 < length ? length - 1 : 0);
+    offset_ += length;
+    return true;
+  }
+
+  /**
+   * @brief pointer to a block of fixed size aligned to the primitive of alignment, whose fields
+   * are read at the offsets of a layout below
+   */
+  const uint8_t * readBlock(const size_t size, const size_t alignment = 8)
+  {
+    align(alignment);
+    if (!reserve(size)) {
+      return nullptr;
+    }
+    const auto * block = data_ + offset_;
+    offset_ += size;
+    return block;
+  }
+
+private:
+  CdrView(const uint8_t * data, const size_t size, const bool is_little_endian)
+  : data_(data), size_(size), offset_(encapsulation_size), is_little_endian_(is_little_endian)
+  {
+  }
+
+  bool reserve(const size_t size)
+  {
+    ok_ = ok_ && offset_ <= size_ && size <= size_ - offset_;
+    return ok_;
+  }
+
+  const uint8_t * data_;
+  size_t size_;
+  size_t offset_;
+  bool is_little_endian_;
+  bool ok_{true};
+};
+
+/**
+ * @brief offsets of the fields of the fixed-size parts of the messages, from their start aligned
+ * to 8 bytes. All their fields are float64, so that there is no padding inside them.
+ */
+namespace layout
+{
+struct Pose
+{
+  static constexpr size_t position = 0;
+  static constexpr size_t orientation = position + 3 * 8;
+  static constexpr size_t size = orientation + 4 * 8;
+};
+
+struct PoseWithCovariance
+{
+  static constexpr size_t pose = 0;
+  static constexpr size_t covariance = pose + Pose::size;
+  static constexpr size_t size = covariance + 36 * 8;
+};
+
+struct Twist
+{
+  static constexpr size_t linear = 0;
+  static constexpr size_t angular = linear + 3 * 8;
+  static constexpr size_t size = angular + 3 * 8;
+};
+
+struct TwistWithCovariance
+{
+  static constexpr size_t twist = 0;
+  static constexpr size_t covariance = twist + Twist::size;
+  static constexpr size_t size = covariance + 36 * 8;
+};
+
+// nav_msgs::msg::Odometry after child_frame_id
+struct Odometry
+{
+  static constexpr size_t pose = 0;
+  static constexpr size_t twist = pose + PoseWithCovariance::size;
+  static constexpr size_t size = twist + TwistWithCovariance::size;
+};
+
+// sensor_msgs::msg::Imu after the header
+struct Imu
+{
+  static constexpr size_t orientation = 0;
+  static constexpr size_t orientation_covariance = orientation + 4 * 8;
+  static constexpr size_t angular_velocity = orientation_covariance + 9 * 8;
+  static constexpr size_t angular_velocity_covariance = angular_velocity + 3 * 8;
+  static constexpr size_t linear_acceleration = angular_velocity_covariance + 9 * 8;
+  static constexpr size_t linear_acceleration_covariance = linear_acceleration + 3 * 8;
+  static constexpr size_t size = linear_acceleration_covariance + 9 * 8;
+};
+
+struct Transform
+{
+  static constexpr size_t translation = 0;
+  static constexpr size_t rotation = translation + 3 * 8;
+  static constexpr size_t size = rotation + 4 * 8;
+};
+}  // namespace layout
+
+/**
+ * @brief fixed-size part of a message, whose fields are read at the offsets of its layout
+ */
+class Block
+{
+public:
+  Block() = default;
+  Block(const uint8_t * data, const bool is_little_endian)
+  : data_(data), is_little_endian_(is_little_endian)
+  {
+  }
+
+  double float64(const size_t offset) const
+  {
+    return readValue<double>(data_ + offset, is_little_endian_);
+  }
+
+  geometry_msgs::msg::Point point(const size_t offset) const
+  {
+    geometry_msgs::msg::Point p;
+    p.x = float64(offset);
+    p.y = float64(offset + 8);
+    p.z = float64(offset + 16);
+    return p;
+  }
+
+  geometry_msgs::msg::Vector3 vector3(const size_t offset) const
+  {
+    geometry_msgs::msg::Vector3 v;
+    v.x = float64(offset);
+    v.y = float64(offset + 8);
+    v.z = float64(offset + 16);
+    return v;
+  }
+
+  geometry_msgs::msg::Quaternion quaternion(const size_t offset) const
+  {
+    geometry_msgs::msg::Quaternion q;
+    q.x = float64(offset);
+    q.y = float64(offset + 8);
+    q.z = float64(offset + 16);
+    q.w = float64(offset + 24);
+    return q;
+  }
+
+private:
+  const uint8_t * data_{nullptr};
+  bool is_little_endian_{true};
+};
+
+/**
+ * @brief std_msgs::msg::Header, whose frame_id refers to the buffer
+ */
+struct HeaderView
+{
+  builtin_interfaces::msg::Time stamp;
+  std::string_view frame_id;
+
+  static std::optional<HeaderView> read(CdrView & view)
+  {
+    HeaderView header;
+    if (
+      !view.read(header.stamp.sec) || !view.read(header.stamp.nanosec) ||
+      !view.readString(header.frame_id)) {
+      return std::nullopt;
+    }
+    return header;
+  }
+};
+
+/**
+ * @brief views of the messages whose part after the header and the strings has a fixed size.
+ * parse() returns nullopt if the buffer is not CDR or is too short, and the fields are read from
+ * the buffer when they are accessed.
+ */
+struct OdometryView
+{
+  HeaderView header;
+  std::string_view child_frame_id;
+  Block block;
+
+  static std::optional<OdometryView> parse(const rcutils_uint8_array_t & buffer)
+  {
+    auto view = CdrView::create(buffer);
+    if (!view) return std::nullopt;
+    OdometryView out;
+    const auto header = HeaderView::read(*view);
+    if (!header || !view->readString(out.child_frame_id)) return std::nullopt;
+    out.header = *header;
+    const auto * block = view->readBlock(layout::Odometry::size);
+    if (!block) return std::nullopt;
+    out.block = Block(block, view->isLittleEndian());
+    return out;
+  }
+
+  geometry_msgs::msg::Point position() const
+  {
+    return block.point(
+      layout::Odometry::pose + layout::PoseWithCovariance::pose + layout::Pose::position);
+  }
+  geometry_msgs::msg::Quaternion orientation() const
+  {
+    return block.quaternion(
+      layout::Odometry::pose + layout::PoseWithCovariance::pose + layout::Pose::orientation);
+  }
+  geometry_msgs::msg::Vector3 linear_velocity() const
+  {
+    return block.vector3(
+      layout::Odometry::twist + layout::TwistWithCovariance::twist + layout::Twist::linear);
+  }
+  geometry_msgs::msg::Vector3 angular_velocity() const
+  {
+    return block.vector3(
+      layout::Odometry::twist + layout::TwistWithCovariance::twist + layout::Twist::angular);
+  }
+};
+
+struct ImuView
+{
+  HeaderView header;
+  Block block;
+
+  static std::optional<ImuView> parse(const rcutils_uint8_array_t & buffer)
+  {
+    auto view = CdrView::create(buffer);
+    if (!view) return std::nullopt;
+    ImuView out;
+    const auto header = HeaderView::read(*view);
+    if (!header) return std::nullopt;
+    out.header = *header;
+    const auto * block = view->readBlock(layout::Imu::size);
+    if (!block) return std::nullopt;
+    out.block = Block(block, view->isLittleEndian());
+    return out;
+  }
+
+  geometry_msgs::msg::Quaternion orientation() const
+  {
+    return block.quaternion(layout::Imu::orientation);
+  }
+  geometry_msgs::msg::Vector3 angular_velocity() const
+  {
+    return block.vector3(layout::Imu::angular_velocity);
+  }
+  geometry_msgs::msg::Vector3 linear_acceleration() const
+  {
+    return block.vector3(layout::Imu::linear_acceleration);
+  }
+};
+
+// geometry_msgs::msg::PoseWithCovarianceStamped
+struct PoseWithCovarianceStampedView
+{
+  HeaderView header;
+  Block block;
+
+  static std::optional<PoseWithCovarianceStampedView> parse(const rcutils_uint8_array_t & buffer)
+  {
+    auto view = CdrView::create(buffer);
+    if (!view) return std::nullopt;
+    PoseWithCovarianceStampedView out;
+    const auto header = HeaderView::read(*view);
+    if (!header) return std::nullopt;
+    out.header = *header;
+    const auto * block = view->readBlock(layout::PoseWithCovariance::size);
+    if (!block) return std::nullopt;
+    out.block = Block(block, view->isLittleEndian());
+    return out;
+  }
+
+  geometry_msgs::msg::Point position() const
+  {
+    return block.point(layout::PoseWithCovariance::pose + layout::Pose::position);
+  }
+  geometry_msgs::msg::Quaternion orientation() const
+  {
+    return block.quaternion(layout::PoseWithCovariance::pose + layout::Pose::orientation);
+  }
+};
+
+// geometry_msgs::msg::TwistWithCovarianceStamped
+struct TwistWithCovarianceStampedView
+{
+  HeaderView header;
+  Block block;
+
+  static std::optional<TwistWithCovarianceStampedView> parse(const rcutils_uint8_array_t & buffer)
+  {
+    auto view = CdrView::create(buffer);
+    if (!view) return std::nullopt;
+    TwistWithCovarianceStampedView out;
+    const auto header = HeaderView::read(*view);
+    if (!header) return std::nullopt;
+    out.header = *header;
+    const auto * block = view->readBlock(layout::TwistWithCovariance::size);
+    if (!block) return std::nullopt;
+    out.block = Block(block, view->isLittleEndian());
+    return out;
+  }
+
+  geometry_msgs::msg::Vector3 linear() const
+  {
+    return block.vector3(layout::TwistWithCovariance::twist + layout::Twist::linear);
+  }
+  geometry_msgs::msg::Vector3 angular() const
+  {
+    return block.vector3(layout::TwistWithCovariance::twist + layout::Twist::angular);
+  }
+};
+
+// geometry_msgs::msg::TransformStamped in a TFMessage
+struct TransformStampedView
+{
+  HeaderView header;
+  std::string_view child_frame_id;
+  Block block;
+
+  geometry_msgs::msg::Vector3 translation() const
+  {
+    return block.vector3(layout::Transform::translation);
+  }
+  geometry_msgs::msg::Quaternion rotation() const
+  {
+    return block.quaternion(layout::Transform::rotation);
+  }
+};
+
+/**
+ * @brief call func with each transform of a tf2_msgs::msg::TFMessage in order
+ * @return false if the buffer is not CDR or is too short, after calling func with the transforms
+ * before the end of the buffer
+ */
+template <class F>
+bool forEachTransform(const rcutils_uint8_array_t & buffer, F && func)
+{
+  auto view = CdrView::create(buffer);
+  uint32_t size = 0;
+  if (!view || !view->read(size)) return false;
+  for (uint32_t i = 0; i < size; ++i) {
+    TransformStampedView transform;
+    const auto header = HeaderView::read(*view);
+    if (!header || !view->readString(transform.child_frame_id)) return false;
+    transform.header = *header;
+    const auto * block = view->readBlock(layout::Transform::size);
+    if (!block) return false;
+    transform.block = Block(block, view->isLittleEndian());
+    func(transform);
+  }
+  return true;
+}
+}  // namespace autoware::bag_index::cdr
+
+#endif  // AUTOWARE__BAG_INDEX__CDR_VIEW_HPP_
@@ -0,0 +1,115 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__BAG_INDEX__INDEXED_BAG_READER_HPP_
+#define AUTOWARE__BAG_INDEX__INDEXED_BAG_READER_HPP_
+
+#include "autoware/bag_index/bag_index.hpp"
+#include "autoware/bag_index/serialization.hpp"
+
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/serialized_bag_message.hpp>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::bag_index
+{
+using SerializedBagMessagePtr = std::shared_ptr<rosbag2_storage::SerializedBagMessage>;
+
+/**
+ * @brief reader of the messages of a bag through its index, which opens each split file with its
+ * own reader, so that a seek reads a single file and the files are read in parallel
+ */
+class IndexedBagReader
+{
+public:
+  explicit IndexedBagReader(std::shared_ptr<const BagIndex> index);
+
+  const BagIndex & getIndex() const { return *index_; }
+
+  /**
+   * @brief read the first message of the topic at or after the stamp
+   * @return nullptr if there is no such message
+   */
+  SerializedBagMessagePtr readAt(const std::string & topic, const Stamp stamp);
+  SerializedBagMessagePtr readLast(const std::string & topic);
+
+  /**
+   * @brief read the messages of the topic in [begin, end) in the order of the stamps
+   * @param [in] thread_num number of the split files read at once
+   */
+  std::vector<SerializedBagMessagePtr> readRange(
+    const std::string & topic, const Stamp begin, const Stamp end, const size_t thread_num = 1);
+
+  template <class T>
+  std::optional<T> readMessageAt(const std::string & topic, const Stamp stamp)
+  {
+    const auto message = readAt(topic, stamp);
+    if (!message) {
+      return std::nullopt;
+    }
+    return deserialize<T>(*message);
+  }
+
+  template <class T>
+  std::optional<T> readLastMessage(const std::string & topic)
+  {
+    const auto message = readLast(topic);
+    if (!message) {
+      return std::nullopt;
+    }
+    return deserialize<T>(*message);
+  }
+
+  template <class T>
+  std::vector<T> readMessages(
+    const std::string & topic, const Stamp begin, const Stamp end, const size_t thread_num = 1)
+  {
+    std::vector<T> messages;
+    for (const auto & message : readRange(topic, begin, end, thread_num)) {
+      messages.push_back(deserialize<T>(*message));
+    }
+    return messages;
+  }
+
+private:
+  struct FileReader
+  {
+    std::mutex mutex;
+    std::unique_ptr<rosbag2_cpp::readers::SequentialReader> reader;
+    std::string filter_topic;
+  };
+
+  SerializedBagMessagePtr readEntry(const std::string & topic, const IndexEntry & entry);
+  // read message_num messages of the topic from the stamp in a split file
+  std::vector<SerializedBagMessagePtr> readFile(
+    const uint32_t file_index, const std::string & topic, const Stamp stamp,
+    const size_t message_num);
+
+  std::shared_ptr<const BagIndex> index_;
+  std::vector<std::unique_ptr<FileReader>> file_readers_;
+
+  // the last message read for each topic, which is reused if the same one is read again
+  std::mutex cache_mutex_;
+  std::unordered_map<std::string, SerializedBagMessagePtr> cached_messages_;
+};
+
+}  // namespace autoware::bag_index
+
+#endif  // AUTOWARE__BAG_INDEX__INDEXED_BAG_READER_HPP_
@@ -0,0 +1,49 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__BAG_INDEX__SERIALIZATION_HPP_
+#define AUTOWARE__BAG_INDEX__SERIALIZATION_HPP_
+
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+#include <rosbag2_storage/serialized_bag_message.hpp>
+
+#include <builtin_interfaces/msg/time.hpp>
+
+#include <optional>
+
+namespace autoware::bag_index
+{
+
+template <class T>
+T deserialize(const rosbag2_storage::SerializedBagMessage & message)
+{
+  rclcpp::Serialization<T> serializer;
+  rclcpp::SerializedMessage serialized_msg(*message.serialized_data);
+  T deserialized_message;
+  serializer.deserialize_message(&serialized_msg, &deserialized_message);
+  return deserialized_message;
+}
+
+/**
+ * @brief read the stamp of the header, which is the first field of a stamped message, directly
+ * from the CDR buffer without deserializing the message
+ * @return nullopt if the buffer is too short or is not CDR
+ */
+std::optional<builtin_interfaces::msg::Time> getHeaderStamp(
+  const rosbag2_storage::SerializedBagMessage & message);
+
+}  // namespace autoware::bag_index
+
+#endif  // AUTOWARE__BAG_INDEX__SERIALIZATION_HPP_
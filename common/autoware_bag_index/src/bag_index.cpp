@@ -0,0 +1,402 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/bag_index/bag_index.hpp"
+
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/metadata_io.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+#include <rosbag2_storage/storage_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::bag_index
+{
+namespace
+{
+constexpr char index_magic[8] = "BAGINDX";
+constexpr uint32_t index_version = 1;
+
+template <class T>
+void writeValue(std::ofstream & ofs, const T & value)
+{
+  ofs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::ifstream & ifs, T & value)
+{
+  return static_cast<bool>(ifs.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+void writeString(std::ofstream & ofs, const std::string & value)
+{
+  writeValue(ofs, static_cast<uint32_t>(value.size()));
+  ofs.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+bool readString(std::ifstream & ifs, std::string & value)
+{
+  uint32_t size = 0;
+  if (!readValue(ifs, size)) {
+    return false;
+  }
+  value.resize(size);
+  return static_cast<bool>(ifs.read(value.data(), size));
+}
+
+uint64_t getFileSize(const std::string & path)
+{
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+  return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+std::vector<uint64_t> getFileSizes(const std::vector<std::string> & file_paths)
+{
+  std::vector<uint64_t> file_sizes;
+  for (const auto & path : file_paths) {
+    file_sizes.push_back(getFileSize(path));
+  }
+  return file_sizes;
+}
+
+const std::vector<IndexEntry> empty_entries{};
+}  // namespace
+
+BagIndex::BagIndex(
+  const std::string & storage_id, const std::vector<std::string> & file_paths,
+  const std::vector<std::string> & topics)
+: storage_id_(storage_id),
+  file_paths_(file_paths),
+  file_sizes_(getFileSizes(file_paths)),
+  topics_(topics)
+{
+  for (const auto & topic : topics_) {
+    entries_[topic];
+  }
+}
+
+std::pair<std::string, std::vector<std::string>> BagIndex::getBagFiles(const std::string & uri)
+{
+  namespace fs = std::filesystem;
+
+  rosbag2_storage::MetadataIo metadata_io;
+  if (metadata_io.metadata_file_exists(uri)) {
+    const auto metadata = metadata_io.read_metadata(uri);
+    std::vector<std::string> file_paths;
+    for (const auto & relative_path : metadata.relative_file_paths) {
+      // the paths are relative to the bag directory, or to its parent in the old bags
+      const auto path = fs::path(uri) / relative_path;
+      const auto parent_path = fs::path(uri).parent_path() / relative_path;
+      if (fs::exists(path)) {
+        file_paths.push_back(path.string());
+      } else if (fs::exists(parent_path)) {
+        file_paths.push_back(parent_path.string());
+      } else {
+        file_paths.push_back(relative_path);
+      }
+    }
+    return {metadata.storage_identifier, file_paths};
+  }
+
+  // a bag file without the metadata
+  const auto storage_id = fs::path(uri).extension() == ".mcap" ? "mcap" : "sqlite3";
+  return {storage_id, {uri}};
+}
+
+std::optional<BagIndex> BagIndex::build(
+  const std::string & uri, const std::vector<std::string> & topics, const size_t thread_num,
+  const ProgressCallback & progress_callback)
+{
+  const auto [storage_id, file_paths] = getBagFiles(uri);
+  BagIndex index(storage_id, file_paths, topics);
+
+  // the progress is the ratio of the read messages, if the metadata has the message counts
+  uint64_t total_message_num = 0;
+  rosbag2_storage::MetadataIo metadata_io;
+  if (metadata_io.metadata_file_exists(uri)) {
+    for (const auto & topic_info : metadata_io.read_metadata(uri).topics_with_message_count) {
+      if (std::find(topics.begin(), topics.end(), topic_info.topic_metadata.name) != topics.end()) {
+        total_message_num += topic_info.message_count;
+      }
+    }
+  }
+
+  // Each split file is read by its own reader, and the entries of the files are merged in the
+  // order of the files, so that the entries of the same stamp keep the order of the bag
+  std::vector<std::vector<std::pair<size_t, Stamp>>> file_entries(file_paths.size());
+  std::atomic<size_t> next_file_index{0};
+  std::atomic<size_t> read_file_num{0};
+  std::atomic<uint64_t> read_message_num{0};
+  std::atomic<bool> is_cancelled{false};
+  std::mutex exception_mutex;
+  std::exception_ptr exception;
+
+  const auto read_files = [&]() {
+    try {
+      for (auto i = next_file_index++; i < file_paths.size() && !is_cancelled;
+           i = next_file_index++) {
+        rosbag2_cpp::readers::SequentialReader reader;
+        rosbag2_storage::StorageOptions storage_options;
+        storage_options.uri = file_paths.at(i);
+        storage_options.storage_id = storage_id;
+        reader.open(storage_options, rosbag2_cpp::ConverterOptions{});
+
+        rosbag2_storage::StorageFilter filter;
+        filter.topics = topics;
+        reader.set_filter(filter);
+
+        std::vector<std::pair<size_t, Stamp>> entries;
+        while (reader.has_next() && !is_cancelled) {
+          const auto message = reader.read_next();
+          const auto topic_itr = std::find(topics.begin(), topics.end(), message->topic_name);
+          if (topic_itr != topics.end()) {
+            entries.emplace_back(std::distance(topics.begin(), topic_itr), message->time_stamp);
+          }
+          ++read_message_num;
+        }
+        file_entries.at(i) = std::move(entries);
+        ++read_file_num;
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(exception_mutex);
+      exception = std::current_exception();
+      is_cancelled = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < std::clamp<size_t>(thread_num, 1, std::max<size_t>(file_paths.size(), 1));
+       ++i) {
+    threads.emplace_back(read_files);
+  }
+
+  // the progress is reported and the cancellation is requested by the calling thread
+  while (read_file_num < file_paths.size() && !is_cancelled) {
+    const double progress =
+      total_message_num > 0
+        ? std::min(static_cast<double>(read_message_num) / total_message_num, 1.0)
+        : static_cast<double>(read_file_num) / file_paths.size();
+    if (progress_callback && !progress_callback(progress)) {
+      is_cancelled = true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+  if (is_cancelled) {
+    return std::nullopt;
+  }
+
+  for (uint32_t i = 0; i < file_entries.size(); ++i) {
+    for (const auto & [topic_index, stamp] : file_entries.at(i)) {
+      index.addEntry(topics.at(topic_index), IndexEntry{stamp, i});
+    }
+  }
+  index.sortEntries();
+  return index;
+}
+
+std::string BagIndex::getCachePath(const std::string & uri)
+{
+  namespace fs = std::filesystem;
+  if (fs::is_directory(uri)) {
+    return (fs::path(uri) / ".autoware_bag_index").string();
+  }
+  return uri + ".autoware_bag_index";
+}
+
+std::optional<BagIndex> BagIndex::loadOrBuild(
+  const std::string & uri, const std::vector<std::string> & topics, const size_t thread_num,
+  const ProgressCallback & progress_callback)
+{
+  const auto cache_path = getCachePath(uri);
+  const auto cached_index = load(cache_path);
+  if (cached_index.has_value()) {
+    const auto & index = cached_index.value();
+    const auto file_paths = getBagFiles(uri).second;
+    const auto has_topics = std::all_of(
+      topics.begin(), topics.end(), [&](const auto & topic) { return index.hasTopic(topic); });
+    if (
+      index.file_paths_ == file_paths && index.file_sizes_ == getFileSizes(file_paths) &&
+      has_topics) {
+      return cached_index;
+    }
+  }
+
+  auto index = build(uri, topics, thread_num, progress_callback);
+  if (index.has_value()) {
+    // the bag may be read only, and then the index is built every time
+    index->save(cache_path);
+  }
+  return index;
+}
+
+bool BagIndex::save(const std::string & path) const
+{
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs.is_open()) {
+    return false;
+  }
+
+  ofs.write(index_magic, sizeof(index_magic));
+  writeValue(ofs, index_version);
+  writeString(ofs, storage_id_);
+  writeValue(ofs, static_cast<uint32_t>(file_paths_.size()));
+  for (size_t i = 0; i < file_paths_.size(); ++i) {
+    writeString(ofs, file_paths_.at(i));
+    writeValue(ofs, file_sizes_.at(i));
+  }
+  writeValue(ofs, static_cast<uint32_t>(topics_.size()));
+  for (const auto & topic : topics_) {
+    const auto & entries = getEntries(topic);
+    writeString(ofs, topic);
+    writeValue(ofs, static_cast<uint64_t>(entries.size()));
+    for (const auto & entry : entries) {
+      writeValue(ofs, entry.stamp);
+      writeValue(ofs, entry.file_index);
+    }
+  }
+  return ofs.good();
+}
+
+std::optional<BagIndex> BagIndex::load(const std::string & path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) {
+    return std::nullopt;
+  }
+
+  char magic[sizeof(index_magic)];
+  uint32_t version = 0;
+  if (
+    !ifs.read(magic, sizeof(magic)) || std::memcmp(magic, index_magic, sizeof(magic)) != 0 ||
+    !readValue(ifs, version) || version != index_version) {
+    return std::nullopt;
+  }
+
+  BagIndex index;
+  uint32_t file_num = 0;
+  if (!readString(ifs, index.storage_id_) || !readValue(ifs, file_num)) {
+    return std::nullopt;
+  }
+  index.file_paths_.resize(file_num);
+  index.file_sizes_.resize(file_num);
+  for (uint32_t i = 0; i < file_num; ++i) {
+    if (!readString(ifs, index.file_paths_.at(i)) || !readValue(ifs, index.file_sizes_.at(i))) {
+      return std::nullopt;
+    }
+  }
+
+  uint32_t topic_num = 0;
+  if (!readValue(ifs, topic_num)) {
+    return std::nullopt;
+  }
+  for (uint32_t i = 0; i < topic_num; ++i) {
+    std::string topic;
+    uint64_t entry_num = 0;
+    if (!readString(ifs, topic) || !readValue(ifs, entry_num)) {
+      return std::nullopt;
+    }
+    index.topics_.push_back(topic);
+    auto & entries = index.entries_[topic];
+    entries.resize(entry_num);
+    for (auto & entry : entries) {
+      if (
+        !readValue(ifs, entry.stamp) || !readValue(ifs, entry.file_index) ||
+        entry.file_index >= file_num) {
+        return std::nullopt;
+      }
+    }
+  }
+  return index;
+}
+
+void BagIndex::addEntry(const std::string & topic, const IndexEntry & entry)
+{
+  if (!hasTopic(topic)) {
+    topics_.push_back(topic);
+  }
+  entries_[topic].push_back(entry);
+}
+
+void BagIndex::sortEntries()
+{
+  for (auto & [topic, entries] : entries_) {
+    std::stable_sort(entries.begin(), entries.end(), [](const auto & a, const auto & b) {
+      return a.stamp < b.stamp;
+    });
+  }
+}
+
+bool BagIndex::hasTopic(const std::string & topic) const
+{
+  return entries_.count(topic) != 0;
+}
+
+const std::vector<IndexEntry> & BagIndex::getEntries(const std::string & topic) const
+{
+  const auto itr = entries_.find(topic);
+  return itr == entries_.end() ? empty_entries : itr->second;
+}
+
+std::optional<IndexEntry> BagIndex::lowerBound(const std::string & topic, const Stamp stamp) const
+{
+  const auto & entries = getEntries(topic);
+  const auto itr = std::lower_bound(
+    entries.begin(), entries.end(), stamp,
+    [](const auto & entry, const auto stamp) { return entry.stamp < stamp; });
+  if (itr == entries.end()) {
+    return std::nullopt;
+  }
+  return *itr;
+}
+
+std::optional<IndexEntry> BagIndex::last(const std::string & topic) const
+{
+  const auto & entries = getEntries(topic);
+  if (entries.empty()) {
+    return std::nullopt;
+  }
+  return entries.back();
+}
+
+std::pair<BagIndex::EntryIterator, BagIndex::EntryIterator> BagIndex::range(
+  const std::string & topic, const Stamp begin, const Stamp end) const
+{
+  const auto & entries = getEntries(topic);
+  const auto compare = [](const auto & entry, const auto stamp) { return entry.stamp < stamp; };
+  const auto begin_itr = std::lower_bound(entries.begin(), entries.end(), begin, compare);
+  const auto end_itr = std::lower_bound(begin_itr, entries.end(), std::max(begin, end), compare);
+  return {begin_itr, end_itr};
+}
+
+}  // namespace autoware::bag_index
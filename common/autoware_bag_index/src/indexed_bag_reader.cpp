@@ -0,0 +1,167 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/bag_index/indexed_bag_reader.hpp"
+
+#include <rosbag2_storage/storage_filter.hpp>
+#include <rosbag2_storage/storage_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::bag_index
+{
+
+IndexedBagReader::IndexedBagReader(std::shared_ptr<const BagIndex> index) : index_(std::move(index))
+{
+  for (size_t i = 0; i < index_->getFilePaths().size(); ++i) {
+    file_readers_.push_back(std::make_unique<FileReader>());
+  }
+}
+
+SerializedBagMessagePtr IndexedBagReader::readAt(const std::string & topic, const Stamp stamp)
+{
+  const auto entry = index_->lowerBound(topic, stamp);
+  if (!entry.has_value()) {
+    return nullptr;
+  }
+  return readEntry(topic, entry.value());
+}
+
+SerializedBagMessagePtr IndexedBagReader::readLast(const std::string & topic)
+{
+  const auto entry = index_->last(topic);
+  if (!entry.has_value()) {
+    return nullptr;
+  }
+  return readEntry(topic, entry.value());
+}
+
+SerializedBagMessagePtr IndexedBagReader::readEntry(
+  const std::string & topic, const IndexEntry & entry)
+{
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    const auto itr = cached_messages_.find(topic);
+    if (itr != cached_messages_.end() && itr->second->time_stamp == entry.stamp) {
+      return itr->second;
+    }
+  }
+
+  const auto messages = readFile(entry.file_index, topic, entry.stamp, 1);
+  if (messages.empty()) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+  cached_messages_[topic] = messages.front();
+  return messages.front();
+}
+
+std::vector<SerializedBagMessagePtr> IndexedBagReader::readRange(
+  const std::string & topic, const Stamp begin, const Stamp end, const size_t thread_num)
+{
+  // the entries of a file in the range are read by one seek to the first of them
+  const auto [begin_itr, end_itr] = index_->range(topic, begin, end);
+  std::map<uint32_t, std::pair<Stamp, size_t>> file_ranges;
+  for (auto itr = begin_itr; itr != end_itr; ++itr) {
+    ++file_ranges.try_emplace(itr->file_index, itr->stamp, 0).first->second.second;
+  }
+  const std::vector<std::pair<uint32_t, std::pair<Stamp, size_t>>> ranges(
+    file_ranges.begin(), file_ranges.end());
+
+  std::vector<std::vector<SerializedBagMessagePtr>> file_messages(ranges.size());
+  std::atomic<size_t> next_range_index{0};
+  std::mutex exception_mutex;
+  std::exception_ptr exception;
+  const auto read_ranges = [&]() {
+    try {
+      for (auto i = next_range_index++; i < ranges.size(); i = next_range_index++) {
+        const auto & [file_index, range] = ranges.at(i);
+        file_messages.at(i) = readFile(file_index, topic, range.first, range.second);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(exception_mutex);
+      exception = std::current_exception();
+    }
+  };
+
+  const size_t worker_num = std::clamp<size_t>(thread_num, 1, std::max<size_t>(ranges.size(), 1));
+  if (worker_num == 1) {
+    read_ranges();
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < worker_num; ++i) {
+      threads.emplace_back(read_ranges);
+    }
+    for (auto & thread : threads) {
+      thread.join();
+    }
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+
+  // the messages of the same stamp keep the order of the files, as the entries of the index do
+  std::vector<SerializedBagMessagePtr> messages;
+  for (auto & file_message : file_messages) {
+    messages.insert(messages.end(), file_message.begin(), file_message.end());
+  }
+  std::stable_sort(messages.begin(), messages.end(), [](const auto & a, const auto & b) {
+    return a->time_stamp < b->time_stamp;
+  });
+  return messages;
+}
+
+std::vector<SerializedBagMessagePtr> IndexedBagReader::readFile(
+  const uint32_t file_index, const std::string & topic, const Stamp stamp,
+  const size_t message_num)
+{
+  auto & file_reader = *file_readers_.at(file_index);
+  std::lock_guard<std::mutex> lock(file_reader.mutex);
+
+  if (!file_reader.reader) {
+    rosbag2_storage::StorageOptions storage_options;
+    storage_options.uri = index_->getFilePaths().at(file_index);
+    storage_options.storage_id = index_->getStorageId();
+    auto reader = std::make_unique<rosbag2_cpp::readers::SequentialReader>();
+    reader->open(storage_options, rosbag2_cpp::ConverterOptions{});
+    file_reader.reader = std::move(reader);
+    file_reader.filter_topic.clear();
+  }
+
+  auto & reader = *file_reader.reader;
+  if (file_reader.filter_topic != topic) {
+    rosbag2_storage::StorageFilter filter;
+    filter.topics.emplace_back(topic);
+    reader.set_filter(filter);
+    file_reader.filter_topic = topic;
+  }
+  reader.seek(stamp);
+
+  std::vector<SerializedBagMessagePtr> messages;
+  while (messages.size() < message_num && reader.has_next()) {
+    messages.push_back(reader.read_next());
+  }
+  return messages;
+}
+
+}  // namespace autoware::bag_index
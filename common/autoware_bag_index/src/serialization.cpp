@@ -0,0 +1,37 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/bag_index/serialization.hpp"
+
+#include "autoware/bag_index/cdr_view.hpp"
+
+namespace autoware::bag_index
+{
+std::optional<builtin_interfaces::msg::Time> getHeaderStamp(
+  const rosbag2_storage::SerializedBagMessage & message)
+{
+  // the stamp is the int32 sec and the uint32 nanosec right after the encapsulation header, which
+  // are aligned without any padding
+  if (!message.serialized_data) {
+    return std::nullopt;
+  }
+  auto view = cdr::CdrView::create(*message.serialized_data);
+  builtin_interfaces::msg::Time stamp;
+  if (!view || !view->read(stamp.sec) || !view->read(stamp.nanosec)) {
+    return std::nullopt;
+  }
+  return stamp;
+}
+
+}  // namespace autoware::bag_index
@@ -0,0 +1,234 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/bag_index/bag_index.hpp"
+#include "autoware/bag_index/cdr_view.hpp"
+#include "autoware/bag_index/serialization.hpp"
+
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+
+#include <nav_msgs/msg/odometry.hpp>
+#include <sensor_msgs/msg/imu.hpp>
+#include <std_msgs/msg/header.hpp>
+#include <tf2_msgs/msg/tf_message.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using autoware::bag_index::BagIndex;
+using autoware::bag_index::IndexEntry;
+
+namespace
+{
+BagIndex createIndex()
+{
+  BagIndex index("sqlite3", {"bag_0.db3", "bag_1.db3"}, {"/a", "/b", "/c"});
+  index.addEntry("/a", IndexEntry{30, 1});
+  index.addEntry("/a", IndexEntry{10, 0});
+  index.addEntry("/a", IndexEntry{20, 0});
+  index.addEntry("/a", IndexEntry{20, 1});
+  index.addEntry("/b", IndexEntry{15, 0});
+  index.sortEntries();
+  return index;
+}
+
+template <class T>
+rclcpp::SerializedMessage serialize(const T & msg)
+{
+  rclcpp::Serialization<T> serializer;
+  rclcpp::SerializedMessage serialized_msg;
+  serializer.serialize_message(&msg, &serialized_msg);
+  return serialized_msg;
+}
+}  // namespace
+
+TEST(bag_index, sortEntries)
+{
+  const auto index = createIndex();
+  const auto & entries = index.getEntries("/a");
+  ASSERT_EQ(entries.size(), 4u);
+  EXPECT_EQ(entries.at(0).stamp, 10);
+  EXPECT_EQ(entries.at(1).stamp, 20);
+  // the entries of the same stamp keep the order they were added in
+  EXPECT_EQ(entries.at(1).file_index, 0u);
+  EXPECT_EQ(entries.at(2).file_index, 1u);
+  EXPECT_EQ(entries.at(3).stamp, 30);
+}
+
+TEST(bag_index, query)
+{
+  const auto index = createIndex();
+  EXPECT_TRUE(index.hasTopic("/c"));
+  EXPECT_TRUE(index.getEntries("/c").empty());
+  EXPECT_FALSE(index.hasTopic("/d"));
+
+  ASSERT_TRUE(index.lowerBound("/a", 11).has_value());
+  EXPECT_EQ(index.lowerBound("/a", 11)->stamp, 20);
+  EXPECT_EQ(index.lowerBound("/a", 20)->file_index, 0u);
+  EXPECT_FALSE(index.lowerBound("/a", 31).has_value());
+  EXPECT_FALSE(index.lowerBound("/d", 0).has_value());
+
+  ASSERT_TRUE(index.last("/a").has_value());
+  EXPECT_EQ(index.last("/a")->stamp, 30);
+  EXPECT_FALSE(index.last("/c").has_value());
+
+  const auto [begin, end] = index.range("/a", 15, 30);
+  ASSERT_EQ(std::distance(begin, end), 2);
+  EXPECT_EQ(begin->stamp, 20);
+  const auto [empty_begin, empty_end] = index.range("/a", 30, 15);
+  EXPECT_EQ(empty_begin, empty_end);
+}
+
+TEST(bag_index, saveAndLoad)
+{
+  const auto index = createIndex();
+  const std::string path = testing::TempDir() + "test_bag_index.autoware_bag_index";
+  ASSERT_TRUE(index.save(path));
+
+  const auto loaded_index = BagIndex::load(path);
+  std::remove(path.c_str());
+  ASSERT_TRUE(loaded_index.has_value());
+  EXPECT_EQ(loaded_index->getStorageId(), "sqlite3");
+  EXPECT_EQ(loaded_index->getFilePaths(), index.getFilePaths());
+  EXPECT_EQ(loaded_index->getTopics(), index.getTopics());
+  for (const auto & topic : index.getTopics()) {
+    const auto & entries = index.getEntries(topic);
+    const auto & loaded_entries = loaded_index->getEntries(topic);
+    ASSERT_EQ(loaded_entries.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      EXPECT_EQ(loaded_entries.at(i).stamp, entries.at(i).stamp);
+      EXPECT_EQ(loaded_entries.at(i).file_index, entries.at(i).file_index);
+    }
+  }
+
+  EXPECT_FALSE(BagIndex::load(testing::TempDir() + "not_existing_index").has_value());
+}
+
+TEST(serialization, getHeaderStamp)
+{
+  std_msgs::msg::Header header;
+  header.stamp.sec = 1700000000;
+  header.stamp.nanosec = 123456789;
+  header.frame_id = "map";
+
+  rclcpp::Serialization<std_msgs::msg::Header> serializer;
+  rclcpp::SerializedMessage serialized_msg;
+  serializer.serialize_message(&header, &serialized_msg);
+
+  rosbag2_storage::SerializedBagMessage message;
+  message.serialized_data = std::make_shared<rcutils_uint8_array_t>(
+    serialized_msg.get_rcl_serialized_message());
+
+  const auto stamp = autoware::bag_index::getHeaderStamp(message);
+  ASSERT_TRUE(stamp.has_value());
+  EXPECT_EQ(stamp->sec, header.stamp.sec);
+  EXPECT_EQ(stamp->nanosec, header.stamp.nanosec);
+
+  const auto deserialized = autoware::bag_index::deserialize<std_msgs::msg::Header>(message);
+  EXPECT_EQ(deserialized.frame_id, "map");
+
+  // the buffer is owned by serialized_msg
+  message.serialized_data->buffer = nullptr;
+  EXPECT_FALSE(autoware::bag_index::getHeaderStamp(message).has_value());
+}
+
+TEST(cdr_view, odometry)
+{
+  nav_msgs::msg::Odometry odometry;
+  odometry.header.stamp.sec = 1700000000;
+  odometry.header.stamp.nanosec = 5;
+  odometry.header.frame_id = "map";
+  odometry.child_frame_id = "base_link";
+  odometry.pose.pose.position.x = 1.0;
+  odometry.pose.pose.position.y = 2.0;
+  odometry.pose.pose.position.z = 3.0;
+  odometry.pose.pose.orientation.z = 0.6;
+  odometry.pose.pose.orientation.w = 0.8;
+  odometry.twist.twist.linear.x = 4.0;
+  odometry.twist.twist.angular.z = 0.5;
+
+  auto serialized_msg = serialize(odometry);
+  const auto view =
+    autoware::bag_index::cdr::OdometryView::parse(serialized_msg.get_rcl_serialized_message());
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(view->header.stamp.sec, odometry.header.stamp.sec);
+  EXPECT_EQ(view->header.stamp.nanosec, odometry.header.stamp.nanosec);
+  EXPECT_EQ(view->header.frame_id, "map");
+  EXPECT_EQ(view->child_frame_id, "base_link");
+  EXPECT_EQ(view->position(), odometry.pose.pose.position);
+  EXPECT_EQ(view->orientation(), odometry.pose.pose.orientation);
+  EXPECT_EQ(view->linear_velocity(), odometry.twist.twist.linear);
+  EXPECT_EQ(view->angular_velocity(), odometry.twist.twist.angular);
+
+  // a truncated buffer
+  auto truncated = serialized_msg.get_rcl_serialized_message();
+  truncated.buffer_length -= 8;
+  EXPECT_FALSE(autoware::bag_index::cdr::OdometryView::parse(truncated).has_value());
+}
+
+TEST(cdr_view, imu)
+{
+  sensor_msgs::msg::Imu imu;
+  imu.header.stamp.sec = 10;
+  imu.header.frame_id = "imu_link";
+  imu.orientation.w = 1.0;
+  imu.orientation_covariance.fill(0.1);
+  imu.angular_velocity.x = 0.01;
+  imu.angular_velocity.y = -0.02;
+  imu.angular_velocity.z = 0.03;
+  imu.linear_acceleration.z = 9.8;
+
+  const auto serialized_msg = serialize(imu);
+  const auto view =
+    autoware::bag_index::cdr::ImuView::parse(serialized_msg.get_rcl_serialized_message());
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(view->header.frame_id, "imu_link");
+  EXPECT_EQ(view->orientation(), imu.orientation);
+  EXPECT_EQ(view->angular_velocity(), imu.angular_velocity);
+  EXPECT_EQ(view->linear_acceleration(), imu.linear_acceleration);
+}
+
+TEST(cdr_view, forEachTransform)
+{
+  tf2_msgs::msg::TFMessage tf;
+  for (size_t i = 0; i < 3; ++i) {
+    geometry_msgs::msg::TransformStamped transform;
+    transform.header.stamp.sec = static_cast<int32_t>(i);
+    transform.header.frame_id = std::string(i + 1, 'p');
+    transform.child_frame_id = "child_" + std::to_string(i);
+    transform.transform.translation.x = static_cast<double>(i);
+    transform.transform.rotation.z = 0.1 * static_cast<double>(i);
+    tf.transforms.push_back(transform);
+  }
+
+  const auto serialized_msg = serialize(tf);
+  size_t i = 0;
+  EXPECT_TRUE(autoware::bag_index::cdr::forEachTransform(
+    serialized_msg.get_rcl_serialized_message(),
+    [&](const autoware::bag_index::cdr::TransformStampedView & view) {
+      const auto & transform = tf.transforms.at(i++);
+      EXPECT_EQ(view.header.stamp.sec, transform.header.stamp.sec);
+      EXPECT_EQ(view.header.frame_id, transform.header.frame_id);
+      EXPECT_EQ(view.child_frame_id, transform.child_frame_id);
+      EXPECT_EQ(view.translation(), transform.transform.translation);
+      EXPECT_EQ(view.rotation(), transform.transform.rotation);
+    }));
+  EXPECT_EQ(i, tf.transforms.size());
+}
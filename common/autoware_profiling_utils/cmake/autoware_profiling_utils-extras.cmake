@@ -0,0 +1,5 @@
+# The profiling macros are empty unless the packages are built with -DAUTOWARE_PROFILING=ON
+option(AUTOWARE_PROFILING "Enable the AUTOWARE_PROFILE_* macros of autoware_profiling_utils" OFF)
+if(AUTOWARE_PROFILING)
+  add_compile_definitions(AUTOWARE_PROFILING_ENABLED)
+endif()
@@ -0,0 +1,43 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__PROFILING_UTILS__PROCESSING_TIME_PUBLISHER_HPP_
+#define AUTOWARE__PROFILING_UTILS__PROCESSING_TIME_PUBLISHER_HPP_
+
+#include "autoware/profiling_utils/profiler.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <autoware_internal_debug_msgs/msg/processing_time_tree.hpp>
+
+#include <string>
+#include <vector>
+
+namespace autoware::profiling_utils
+{
+
+/**
+ * @brief publish the tree of the scoped timers of a thread to the topic when its outermost scope
+ * ends, and write the trace file given by the environment variable AUTOWARE_PROFILING_TRACE_FILE.
+ * Both are stopped when the context of the node is shut down
+ */
+void initializeProfiler(
+  rclcpp::Node & node, const std::string & topic_name = "~/debug/processing_time_detail_ms");
+
+autoware_internal_debug_msgs::msg::ProcessingTimeTree toProcessingTimeTree(
+  const std::vector<TimeNode> & nodes);
+
+}  // namespace autoware::profiling_utils
+
+#endif  // AUTOWARE__PROFILING_UTILS__PROCESSING_TIME_PUBLISHER_HPP_
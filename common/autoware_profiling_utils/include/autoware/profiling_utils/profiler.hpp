@@ -0,0 +1,108 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__PROFILING_UTILS__PROFILER_HPP_
+#define AUTOWARE__PROFILING_UTILS__PROFILER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace autoware::profiling_utils
+{
+
+struct TimeNode
+{
+  // from 1 in the order the scopes began, and the parent of the root scope is 0
+  int32_t id;
+  int32_t parent_id;
+  std::string name;
+  double processing_time_ms;
+};
+
+/**
+ * @brief process-wide recorder of the scoped timers and the counters, which reports the tree of
+ * the scopes of a thread when its outermost scope ends, and writes the scopes and the counters to
+ * a trace file in the Chrome trace event format, which Perfetto also opens
+ */
+class Profiler
+{
+public:
+  using Reporter = std::function<void(const std::vector<TimeNode> &)>;
+
+  static Profiler & instance();
+
+  Profiler(const Profiler &) = delete;
+  Profiler & operator=(const Profiler &) = delete;
+
+  /**
+   * @brief start writing the trace, a trace file already open is kept
+   * @param [in] process_name name of the process shown in the trace viewer
+   */
+  bool openTraceFile(const std::string & path, const std::string & process_name);
+  void closeTraceFile();
+
+  // return the id to remove the reporter with
+  size_t addReporter(const Reporter & reporter);
+  void removeReporter(const size_t id);
+
+  void beginScope(const std::string & name);
+  void endScope();
+  void recordCounter(const std::string & name, const double value);
+
+private:
+  Profiler();
+  ~Profiler();
+
+  int64_t getTimeUs(const std::chrono::steady_clock::time_point & time) const;
+  void writeTraceEvent(const std::string & event);
+
+  // the trees of the threads are not reported beyond this number of scopes
+  static constexpr size_t max_tree_node_num_ = 10000;
+
+  const std::chrono::steady_clock::time_point start_time_;
+  const int pid_;
+
+  std::mutex trace_mutex_;
+  std::ofstream trace_file_;
+  // to skip formatting the events if the trace file is not open
+  std::atomic<bool> is_tracing_{false};
+
+  std::mutex reporter_mutex_;
+  std::map<size_t, Reporter> reporters_;
+  size_t next_reporter_id_{0};
+};
+
+/**
+ * @brief measures the processing time from the construction to the destruction
+ */
+class ScopedTimer
+{
+public:
+  explicit ScopedTimer(const std::string & name) { Profiler::instance().beginScope(name); }
+  ~ScopedTimer() { Profiler::instance().endScope(); }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer & operator=(const ScopedTimer &) = delete;
+};
+
+}  // namespace autoware::profiling_utils
+
+#endif  // AUTOWARE__PROFILING_UTILS__PROFILER_HPP_
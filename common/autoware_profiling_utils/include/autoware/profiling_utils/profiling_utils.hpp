@@ -0,0 +1,48 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__PROFILING_UTILS__PROFILING_UTILS_HPP_
+#define AUTOWARE__PROFILING_UTILS__PROFILING_UTILS_HPP_
+
+// The macros are empty unless AUTOWARE_PROFILING_ENABLED is defined, which is done for the
+// packages built with -DAUTOWARE_PROFILING=ON, so that the tools are instrumented without overhead
+
+#ifdef AUTOWARE_PROFILING_ENABLED
+
+#include "autoware/profiling_utils/processing_time_publisher.hpp"
+#include "autoware/profiling_utils/profiler.hpp"
+
+#define AUTOWARE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define AUTOWARE_PROFILE_CONCAT(a, b) AUTOWARE_PROFILE_CONCAT_IMPL(a, b)
+
+#define AUTOWARE_PROFILE_INIT(node) ::autoware::profiling_utils::initializeProfiler(node)
+#define AUTOWARE_PROFILE_SCOPE(name)           \
+  const ::autoware::profiling_utils::ScopedTimer \
+  AUTOWARE_PROFILE_CONCAT(autoware_profile_scope_, __LINE__)(name)
+#define AUTOWARE_PROFILE_FUNCTION() AUTOWARE_PROFILE_SCOPE(__func__)
+#define AUTOWARE_PROFILE_COUNTER(name, value) \
+  ::autoware::profiling_utils::Profiler::instance().recordCounter(name, value)
+
+#else
+
+// the arguments are not evaluated, but are referred to in sizeof not to be unused
+#define AUTOWARE_PROFILE_INIT(node) static_cast<void>(sizeof(node))
+#define AUTOWARE_PROFILE_SCOPE(name) static_cast<void>(sizeof(name))
+#define AUTOWARE_PROFILE_FUNCTION() static_cast<void>(0)
+#define AUTOWARE_PROFILE_COUNTER(name, value) \
+  (static_cast<void>(sizeof(name)), static_cast<void>(sizeof(value)))
+
+#endif  // AUTOWARE_PROFILING_ENABLED
+
+#endif  // AUTOWARE__PROFILING_UTILS__PROFILING_UTILS_HPP_
@@ -0,0 +1,66 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/profiling_utils/processing_time_publisher.hpp"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autoware::profiling_utils
+{
+
+autoware_internal_debug_msgs::msg::ProcessingTimeTree toProcessingTimeTree(
+  const std::vector<TimeNode> & nodes)
+{
+  autoware_internal_debug_msgs::msg::ProcessingTimeTree tree;
+  for (const auto & node : nodes) {
+    autoware_internal_debug_msgs::msg::ProcessingTimeNode tree_node;
+    tree_node.id = node.id;
+    tree_node.parent_id = node.parent_id;
+    tree_node.name = node.name;
+    tree_node.processing_time = node.processing_time_ms;
+    tree.nodes.push_back(tree_node);
+  }
+  return tree;
+}
+
+void initializeProfiler(rclcpp::Node & node, const std::string & topic_name)
+{
+  using autoware_internal_debug_msgs::msg::ProcessingTimeTree;
+  auto & profiler = Profiler::instance();
+
+  const auto publisher = node.create_publisher<ProcessingTimeTree>(topic_name, rclcpp::QoS(1));
+  const auto reporter_id = profiler.addReporter([publisher](const std::vector<TimeNode> & nodes) {
+    publisher->publish(toProcessingTimeTree(nodes));
+  });
+
+  const char * trace_path = std::getenv("AUTOWARE_PROFILING_TRACE_FILE");
+  if (trace_path && *trace_path != '\0') {
+    if (profiler.openTraceFile(trace_path, node.get_fully_qualified_name())) {
+      RCLCPP_INFO(node.get_logger(), "Writing the processing time trace to %s", trace_path);
+    } else {
+      RCLCPP_WARN(node.get_logger(), "Failed to open the trace file %s", trace_path);
+    }
+  }
+
+  // the profiler outlives the node, and its trace file is completed at the shutdown
+  node.get_node_base_interface()->get_context()->add_on_shutdown_callback([reporter_id]() {
+    Profiler::instance().removeReporter(reporter_id);
+    Profiler::instance().closeTraceFile();
+  });
+}
+
+}  // namespace autoware::profiling_utils
@@ -0,0 +1,212 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/profiling_utils/profiler.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::profiling_utils
+{
+namespace
+{
+struct ThreadState
+{
+  ThreadState() : tid(next_tid++) {}
+
+  static inline std::atomic<uint32_t> next_tid{1};
+
+  struct OpenScope
+  {
+    // npos if the scope is beyond the limit of the tree
+    size_t node_index;
+    // the id of the node, or of the parent node if the scope is not in the tree
+    int32_t id;
+    // the name of the scope not in the tree
+    std::string name;
+    std::chrono::steady_clock::time_point begin_time;
+  };
+
+  const uint32_t tid;
+  std::vector<TimeNode> nodes;
+  std::vector<OpenScope> open_scopes;
+};
+
+ThreadState & getThreadState()
+{
+  thread_local ThreadState state;
+  return state;
+}
+
+std::string escapeJson(const std::string & str)
+{
+  std::string escaped;
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char code[8];
+      std::snprintf(code, sizeof(code), "\\u%04x", c);
+      escaped += code;
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+}  // namespace
+
+Profiler & Profiler::instance()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler() : start_time_(std::chrono::steady_clock::now()), pid_(getpid())
+{
+}
+
+Profiler::~Profiler()
+{
+  closeTraceFile();
+}
+
+bool Profiler::openTraceFile(const std::string & path, const std::string & process_name)
+{
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  if (trace_file_.is_open()) {
+    return true;
+  }
+  trace_file_.open(path);
+  if (!trace_file_.is_open()) {
+    return false;
+  }
+  // the events are written as they end, and the viewers accept the array without the last ']'
+  is_tracing_ = true;
+  trace_file_ << "[\n";
+  trace_file_ << R"({"name":"process_name","ph":"M","pid":)" << pid_ << R"(,"args":{"name":")"
+              << escapeJson(process_name) << "\"}}";
+  return true;
+}
+
+void Profiler::closeTraceFile()
+{
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  if (!trace_file_.is_open()) {
+    return;
+  }
+  is_tracing_ = false;
+  trace_file_ << "\n]\n";
+  trace_file_.close();
+}
+
+size_t Profiler::addReporter(const Reporter & reporter)
+{
+  std::lock_guard<std::mutex> lock(reporter_mutex_);
+  reporters_.emplace(next_reporter_id_, reporter);
+  return next_reporter_id_++;
+}
+
+void Profiler::removeReporter(const size_t id)
+{
+  std::lock_guard<std::mutex> lock(reporter_mutex_);
+  reporters_.erase(id);
+}
+
+void Profiler::beginScope(const std::string & name)
+{
+  auto & state = getThreadState();
+  const int32_t parent_id = state.open_scopes.empty() ? 0 : state.open_scopes.back().id;
+  if (state.nodes.size() < max_tree_node_num_) {
+    const auto id = static_cast<int32_t>(state.nodes.size()) + 1;
+    state.nodes.push_back(TimeNode{id, parent_id, name, 0.0});
+    state.open_scopes.push_back(
+      ThreadState::OpenScope{state.nodes.size() - 1, id, {}, std::chrono::steady_clock::now()});
+  } else {
+    state.open_scopes.push_back(
+      ThreadState::OpenScope{std::string::npos, parent_id, name, std::chrono::steady_clock::now()});
+  }
+}
+
+void Profiler::endScope()
+{
+  const auto end_time = std::chrono::steady_clock::now();
+  auto & state = getThreadState();
+  if (state.open_scopes.empty()) {
+    return;
+  }
+  const auto scope = std::move(state.open_scopes.back());
+  state.open_scopes.pop_back();
+  const bool is_in_tree = scope.node_index != std::string::npos;
+  if (is_in_tree) {
+    state.nodes.at(scope.node_index).processing_time_ms =
+      std::chrono::duration<double, std::milli>(end_time - scope.begin_time).count();
+  }
+
+  if (is_tracing_) {
+    const auto & name = is_in_tree ? state.nodes.at(scope.node_index).name : scope.name;
+    std::ostringstream event;
+    event << R"({"name":")" << escapeJson(name) << R"(","ph":"X","ts":)"
+          << getTimeUs(scope.begin_time) << R"(,"dur":)"
+          << getTimeUs(end_time) - getTimeUs(scope.begin_time) << R"(,"pid":)" << pid_
+          << R"(,"tid":)" << state.tid << "}";
+    writeTraceEvent(event.str());
+  }
+
+  if (!state.open_scopes.empty()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(reporter_mutex_);
+    for (const auto & [id, reporter] : reporters_) {
+      reporter(state.nodes);
+    }
+  }
+  state.nodes.clear();
+}
+
+void Profiler::recordCounter(const std::string & name, const double value)
+{
+  if (!is_tracing_) {
+    return;
+  }
+  std::ostringstream event;
+  event << R"({"name":")" << escapeJson(name) << R"(","ph":"C","ts":)"
+        << getTimeUs(std::chrono::steady_clock::now()) << R"(,"pid":)" << pid_
+        << R"(,"args":{"value":)" << value << "}}";
+  writeTraceEvent(event.str());
+}
+
+int64_t Profiler::getTimeUs(const std::chrono::steady_clock::time_point & time) const
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(time - start_time_).count();
+}
+
+void Profiler::writeTraceEvent(const std::string & event)
+{
+  std::lock_guard<std::mutex> lock(trace_mutex_);
+  if (trace_file_.is_open()) {
+    trace_file_ << ",\n" << event;
+  }
+}
+
+}  // namespace autoware::profiling_utils
@@ -0,0 +1,84 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/profiling_utils/profiling_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using autoware::profiling_utils::Profiler;
+using autoware::profiling_utils::TimeNode;
+
+TEST(profiler, reportTree)
+{
+  std::vector<std::vector<TimeNode>> trees;
+  const auto id = Profiler::instance().addReporter(
+    [&trees](const std::vector<TimeNode> & nodes) { trees.push_back(nodes); });
+
+  {
+    AUTOWARE_PROFILE_SCOPE("root");
+    {
+      AUTOWARE_PROFILE_SCOPE("child");
+      AUTOWARE_PROFILE_SCOPE("grandchild");
+    }
+    AUTOWARE_PROFILE_SCOPE("second_child");
+    EXPECT_TRUE(trees.empty());
+  }
+  Profiler::instance().removeReporter(id);
+
+  ASSERT_EQ(trees.size(), 1u);
+  const auto & nodes = trees.front();
+  ASSERT_EQ(nodes.size(), 4u);
+  EXPECT_EQ(nodes.at(0).name, "root");
+  EXPECT_EQ(nodes.at(0).id, 1);
+  EXPECT_EQ(nodes.at(0).parent_id, 0);
+  EXPECT_EQ(nodes.at(1).parent_id, 1);
+  EXPECT_EQ(nodes.at(2).parent_id, 2);
+  EXPECT_EQ(nodes.at(3).name, "second_child");
+  EXPECT_EQ(nodes.at(3).parent_id, 1);
+  EXPECT_GE(nodes.at(0).processing_time_ms, nodes.at(1).processing_time_ms);
+
+  // the removed reporter is not called
+  { AUTOWARE_PROFILE_SCOPE("root"); }
+  EXPECT_EQ(trees.size(), 1u);
+}
+
+TEST(profiler, writeTrace)
+{
+  const std::string path = testing::TempDir() + "test_profiler_trace.json";
+  ASSERT_TRUE(Profiler::instance().openTraceFile(path, "test\"process"));
+  {
+    AUTOWARE_PROFILE_FUNCTION();
+    AUTOWARE_PROFILE_COUNTER("point_num", 42.0);
+  }
+  Profiler::instance().closeTraceFile();
+
+  std::ifstream ifs(path);
+  std::stringstream trace;
+  trace << ifs.rdbuf();
+  std::remove(path.c_str());
+
+  const auto str = trace.str();
+  EXPECT_EQ(str.front(), '[');
+  EXPECT_NE(str.find(R"("name":"test\"process")"), std::string::npos);
+  EXPECT_NE(str.find(R"("name":"TestBody","ph":"X")"), std::string::npos);
+  EXPECT_NE(str.find(R"("name":"point_num","ph":"C")"), std::string::npos);
+  EXPECT_NE(str.find(R"("args":{"value":42})"), std::string::npos);
+  EXPECT_EQ(str.substr(str.size() - 3), "\n]\n");
+}
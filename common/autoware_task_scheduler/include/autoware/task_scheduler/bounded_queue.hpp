@@ -0,0 +1,84 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__TASK_SCHEDULER__BOUNDED_QUEUE_HPP_
+#define AUTOWARE__TASK_SCHEDULER__BOUNDED_QUEUE_HPP_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace autoware::task_scheduler
+{
+// Queue between the stages of a pipeline. push() blocks while the queue is full, so that a fast
+// stage does not buffer more than capacity items ahead of a slow one, and pop() returns
+// std::nullopt once the queue is closed and empty
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(const size_t capacity) : capacity_(std::max<size_t>(capacity, 1)) {}
+
+  // Return false, without pushing the item, if the queue is closed
+  bool push(T && item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return queue_.size() < capacity_ || closed_; });
+
+    if (closed_) {
+      return false;
+    }
+
+    queue_.push_back(std::move(item));
+    cv_.notify_all();
+    return true;
+  }
+
+  std::optional<T> pop()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !queue_.empty() || closed_; });
+
+    if (queue_.empty()) {
+      return std::nullopt;
+    }
+
+    std::optional<T> item(std::move(queue_.front()));
+    queue_.pop_front();
+    cv_.notify_all();
+    return item;
+  }
+
+  // The items in the queue are still popped, and the blocked pushes return false
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<T> queue_;
+  const size_t capacity_;
+  bool closed_{false};
+};
+}  // namespace autoware::task_scheduler
+
+#endif  // AUTOWARE__TASK_SCHEDULER__BOUNDED_QUEUE_HPP_
@@ -0,0 +1,107 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__TASK_SCHEDULER__BUDGET_HPP_
+#define AUTOWARE__TASK_SCHEDULER__BUDGET_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace autoware::task_scheduler
+{
+// Number of threads that the tools of the process may use in total. It is AUTOWARE_THREAD_BUDGET
+// if the variable is a positive number, and the number of hardware threads otherwise, unless it is
+// set by set_thread_budget
+size_t thread_budget();
+
+// Override the budget, e.g. by a parameter. The global scheduler takes the budget when it is first
+// used, so this has to be called before
+void set_thread_budget(size_t thread_num);
+
+// Number of threads for a requested number, e.g. the thread_num parameter of a tool: the budget if
+// requested is not positive, and requested up to the budget otherwise
+size_t resolve_thread_num(int64_t requested);
+
+// Bytes that the buffers of the tools may take in total, from AUTOWARE_MEMORY_BUDGET_MB. 0 is no
+// limit
+size_t memory_budget();
+
+// Bytes reserved by the stages of pipelines before they allocate, so that the buffers in flight
+// do not exceed a limit
+class MemoryBudget
+{
+public:
+  // 0 is no limit
+  explicit MemoryBudget(size_t limit_bytes) : limit_(limit_bytes) {}
+
+  MemoryBudget(const MemoryBudget &) = delete;
+  MemoryBudget & operator=(const MemoryBudget &) = delete;
+
+  // Budget of the process with memory_budget() bytes
+  static MemoryBudget & global();
+
+  // Block until the bytes fit into the limit. A reservation larger than the limit is let through
+  // when nothing else is reserved, so that it does not wait forever
+  void acquire(size_t bytes);
+  bool try_acquire(size_t bytes);
+  void release(size_t bytes);
+
+  size_t limit() const { return limit_; }
+  size_t reserved() const;
+
+private:
+  bool fits(size_t bytes) const
+  {
+    return limit_ == 0 || reserved_ == 0 || reserved_ + bytes <= limit_;
+  }
+
+  const size_t limit_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  size_t reserved_{0};
+};
+
+// Bytes of a MemoryBudget reserved until the end of the scope
+class MemoryReservation
+{
+public:
+  MemoryReservation(MemoryBudget & budget, size_t bytes) : budget_(&budget), bytes_(bytes)
+  {
+    budget_->acquire(bytes_);
+  }
+
+  ~MemoryReservation()
+  {
+    if (budget_) budget_->release(bytes_);
+  }
+
+  MemoryReservation(MemoryReservation && other) noexcept
+  : budget_(other.budget_), bytes_(other.bytes_)
+  {
+    other.budget_ = nullptr;
+  }
+
+  MemoryReservation(const MemoryReservation &) = delete;
+  MemoryReservation & operator=(const MemoryReservation &) = delete;
+  MemoryReservation & operator=(MemoryReservation &&) = delete;
+
+private:
+  MemoryBudget * budget_;
+  size_t bytes_;
+};
+}  // namespace autoware::task_scheduler
+
+#endif  // AUTOWARE__TASK_SCHEDULER__BUDGET_HPP_
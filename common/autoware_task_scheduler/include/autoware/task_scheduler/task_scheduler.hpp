@@ -0,0 +1,146 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__TASK_SCHEDULER__TASK_SCHEDULER_HPP_
+#define AUTOWARE__TASK_SCHEDULER__TASK_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace autoware::task_scheduler
+{
+class TaskScheduler;
+
+// Tasks that are waited for together. A waiting thread runs the queued tasks in the meantime, so
+// that the tasks can start and wait for groups of their own without blocking the workers
+class TaskGroup
+{
+public:
+  explicit TaskGroup(TaskScheduler & scheduler) : scheduler_(scheduler) {}
+
+  // The tasks may refer to the variables of the scope of the group, so they are waited for here
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup & operator=(const TaskGroup &) = delete;
+
+  void run(std::function<void()> task);
+
+  // Wait for all the tasks, and rethrow the first exception thrown by them
+  void wait();
+
+private:
+  friend class TaskScheduler;
+
+  TaskScheduler & scheduler_;
+  std::atomic<size_t> pending_{0};
+  std::mutex error_mutex_;
+  std::exception_ptr error_{nullptr};
+};
+
+// Work-stealing thread pool. Each worker takes the newest task of its own queue, and steals the
+// oldest one of another queue when its own is empty. The threads that are not workers share a
+// queue of their own
+class TaskScheduler
+{
+public:
+  // thread_num includes the thread that waits for the tasks, so thread_num - 1 workers are created
+  explicit TaskScheduler(size_t thread_num);
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler & operator=(const TaskScheduler &) = delete;
+
+  // Scheduler of the process with thread_budget() threads, created when it is first used. The
+  // tools of a process share it instead of creating threads of their own
+  static TaskScheduler & global();
+
+  size_t thread_num() const { return workers_.size() + 1; }
+
+  // Call func(i) for i in [0, size) on at most max_concurrency threads (0 is all of them),
+  // including this one, and wait for all of them. The indices are taken one by one from a shared
+  // counter, so that fast threads take over the work of slow ones. An exception thrown by func is
+  // rethrown here, after the other indices are processed
+  void parallel_for(
+    size_t size, const std::function<void(size_t)> & func, size_t max_concurrency = 0);
+
+  // Combine map(begin, end) of the chunks of grain indices of [0, size) in the order of the
+  // chunks, so that the result does not depend on the threads
+  template <class T, class MapFunc, class CombineFunc>
+  T parallel_reduce(
+    size_t size, size_t grain, T identity, const MapFunc & map, const CombineFunc & combine,
+    size_t max_concurrency = 0)
+  {
+    grain = std::max<size_t>(grain, 1);
+
+    const size_t chunk_num = (size + grain - 1) / grain;
+    std::vector<T> partials(chunk_num, identity);
+
+    parallel_for(
+      chunk_num,
+      [&](size_t c) { partials[c] = map(c * grain, std::min(size, (c + 1) * grain)); },
+      max_concurrency);
+
+    T result = std::move(identity);
+
+    for (auto & partial : partials) {
+      result = combine(std::move(result), std::move(partial));
+    }
+
+    return result;
+  }
+
+private:
+  friend class TaskGroup;
+
+  struct Task
+  {
+    std::function<void()> func;
+    TaskGroup * group;
+  };
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void push(Task task);
+  bool pop(Task & task);
+  bool run_one();
+  void wait(TaskGroup & group);
+  void work(size_t queue_index);
+  size_t queue_index() const;
+
+  std::vector<std::unique_ptr<Queue>> queues_;  // [0] is for the threads that are not workers
+  std::vector<std::thread> workers_;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable cv_;
+  std::atomic<size_t> queued_{0};  // increased with sleep_mutex_, so that no wakeup is lost
+  bool stop_{false};
+};
+}  // namespace autoware::task_scheduler
+
+#endif  // AUTOWARE__TASK_SCHEDULER__TASK_SCHEDULER_HPP_
@@ -0,0 +1,123 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/task_scheduler/budget.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace autoware::task_scheduler
+{
+namespace
+{
+// Positive value of an environment variable, or 0
+size_t read_positive_env(const char * name)
+{
+  const char * value = std::getenv(name);
+
+  if (!value) {
+    return 0;
+  }
+
+  try {
+    const int64_t n = std::stoll(value);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  } catch (const std::exception &) {
+    return 0;
+  }
+}
+
+std::atomic<size_t> & budget_override()
+{
+  static std::atomic<size_t> thread_num{0};
+  return thread_num;
+}
+}  // namespace
+
+size_t thread_budget()
+{
+  if (const size_t overridden = budget_override().load()) {
+    return overridden;
+  }
+
+  static const size_t budget = [] {
+    const size_t env = read_positive_env("AUTOWARE_THREAD_BUDGET");
+    return env ? env : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }();
+
+  return budget;
+}
+
+void set_thread_budget(size_t thread_num)
+{
+  budget_override() = thread_num;
+}
+
+size_t resolve_thread_num(int64_t requested)
+{
+  const size_t budget = thread_budget();
+  return requested > 0 ? std::min(static_cast<size_t>(requested), budget) : budget;
+}
+
+size_t memory_budget()
+{
+  static const size_t budget = read_positive_env("AUTOWARE_MEMORY_BUDGET_MB") << 20;
+  return budget;
+}
+
+MemoryBudget & MemoryBudget::global()
+{
+  static MemoryBudget budget(memory_budget());
+  return budget;
+}
+
+void MemoryBudget::acquire(size_t bytes)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this, bytes] { return fits(bytes); });
+  reserved_ += bytes;
+}
+
+bool MemoryBudget::try_acquire(size_t bytes)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (!fits(bytes)) {
+    return false;
+  }
+
+  reserved_ += bytes;
+  return true;
+}
+
+void MemoryBudget::release(size_t bytes)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved_ -= std::min(bytes, reserved_);
+  }
+
+  cv_.notify_all();
+}
+
+size_t MemoryBudget::reserved() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return reserved_;
+}
+}  // namespace autoware::task_scheduler
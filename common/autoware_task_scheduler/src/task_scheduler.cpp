@@ -0,0 +1,248 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/task_scheduler/task_scheduler.hpp"
+
+#include "autoware/task_scheduler/budget.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace autoware::task_scheduler
+{
+namespace
+{
+// Scheduler and queue of the worker running on this thread
+thread_local const TaskScheduler * current_scheduler = nullptr;
+thread_local size_t current_queue_index = 0;
+}  // namespace
+
+TaskGroup::~TaskGroup()
+{
+  try {
+    wait();
+  } catch (...) {
+    // The exceptions are only rethrown by an explicit wait
+  }
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+  ++pending_;
+  scheduler_.push(TaskScheduler::Task{std::move(task), this});
+}
+
+void TaskGroup::wait()
+{
+  scheduler_.wait(*this);
+
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    std::swap(error, error_);
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+TaskScheduler::TaskScheduler(size_t thread_num)
+{
+  thread_num = std::max<size_t>(thread_num, 1);
+
+  for (size_t i = 0; i < thread_num; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+
+  for (size_t i = 1; i < thread_num; ++i) {
+    workers_.emplace_back([this, i] { work(i); });
+  }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stop_ = true;
+  }
+
+  cv_.notify_all();
+
+  for (auto & worker : workers_) {
+    worker.join();
+  }
+}
+
+TaskScheduler & TaskScheduler::global()
+{
+  static TaskScheduler scheduler(thread_budget());
+  return scheduler;
+}
+
+void TaskScheduler::parallel_for(
+  size_t size, const std::function<void(size_t)> & func, size_t max_concurrency)
+{
+  size_t runner_num = std::min(size, thread_num());
+
+  if (max_concurrency > 0) {
+    runner_num = std::min(runner_num, max_concurrency);
+  }
+
+  if (runner_num <= 1) {
+    for (size_t i = 0; i < size; ++i) {
+      func(i);
+    }
+
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto runner = [&]() {
+    for (size_t i = next++; i < size; i = next++) {
+      try {
+        func(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+      }
+    }
+  };
+
+  TaskGroup group(*this);
+
+  for (size_t i = 1; i < runner_num; ++i) {
+    group.run(runner);
+  }
+
+  runner();
+  group.wait();
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+size_t TaskScheduler::queue_index() const
+{
+  return current_scheduler == this ? current_queue_index : 0;
+}
+
+void TaskScheduler::push(Task task)
+{
+  {
+    auto & queue = *queues_[queue_index()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    ++queued_;
+  }
+
+  cv_.notify_one();
+}
+
+// The newest task of the own queue, which is likely to be in the cache, or the oldest task of
+// another queue, which is likely to be the largest
+bool TaskScheduler::pop(Task & task)
+{
+  const size_t own = queue_index();
+
+  for (size_t k = 0; k < queues_.size(); ++k) {
+    auto & queue = *queues_[(own + k) % queues_.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.tasks.empty()) {
+      continue;
+    }
+
+    if (k == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+
+    --queued_;
+    return true;
+  }
+
+  return false;
+}
+
+bool TaskScheduler::run_one()
+{
+  Task task;
+
+  if (!pop(task)) {
+    return false;
+  }
+
+  try {
+    task.func();
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(task.group->error_mutex_);
+    if (!task.group->error_) task.group->error_ = std::current_exception();
+  }
+
+  // The group may be destroyed as soon as its last task is done, so it is not touched after
+  if (--task.group->pending_ == 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    cv_.notify_all();
+  }
+
+  return true;
+}
+
+void TaskScheduler::wait(TaskGroup & group)
+{
+  while (group.pending_ > 0) {
+    if (run_one()) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    cv_.wait(lock, [this, &group] { return group.pending_ == 0 || queued_ > 0; });
+  }
+}
+
+void TaskScheduler::work(size_t queue_index)
+{
+  current_scheduler = this;
+  current_queue_index = queue_index;
+
+  while (true) {
+    if (run_one()) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    cv_.wait(lock, [this] { return stop_ || queued_ > 0; });
+
+    if (stop_ && queued_ == 0) {
+      return;
+    }
+  }
+}
+}  // namespace autoware::task_scheduler
@@ -0,0 +1,190 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/task_scheduler/bounded_queue.hpp"
+#include "autoware/task_scheduler/budget.hpp"
+#include "autoware/task_scheduler/task_scheduler.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using autoware::task_scheduler::BoundedQueue;
+using autoware::task_scheduler::MemoryBudget;
+using autoware::task_scheduler::MemoryReservation;
+using autoware::task_scheduler::TaskGroup;
+using autoware::task_scheduler::TaskScheduler;
+
+TEST(TaskScheduler, ParallelForVisitsEveryIndexOnce)
+{
+  TaskScheduler scheduler(4);
+  std::vector<std::atomic<int>> counts(10000);
+
+  scheduler.parallel_for(counts.size(), [&](size_t i) { ++counts[i]; });
+
+  for (const auto & count : counts) {
+    EXPECT_EQ(count, 1);
+  }
+}
+
+TEST(TaskScheduler, MaxConcurrency)
+{
+  TaskScheduler scheduler(4);
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+
+  scheduler.parallel_for(
+    64,
+    [&](size_t) {
+      const int n = ++running;
+      int expected = max_running;
+      while (n > expected && !max_running.compare_exchange_weak(expected, n)) {
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      --running;
+    },
+    2);
+
+  EXPECT_LE(max_running, 2);
+}
+
+TEST(TaskScheduler, NestedParallelFor)
+{
+  TaskScheduler scheduler(3);
+  std::atomic<int64_t> sum{0};
+
+  // The workers wait for the inner loops of their own tasks without blocking the pool
+  scheduler.parallel_for(16, [&](size_t i) {
+    scheduler.parallel_for(100, [&](size_t j) { sum += static_cast<int64_t>(i * 100 + j); });
+  });
+
+  EXPECT_EQ(sum, 1600 * 1599 / 2);
+}
+
+TEST(TaskScheduler, ParallelReduceIsInOrder)
+{
+  TaskScheduler scheduler(4);
+  std::vector<int> values(1000);
+  std::iota(values.begin(), values.end(), 0);
+
+  const auto concatenated = scheduler.parallel_reduce(
+    values.size(), 7, std::vector<int>{},
+    [&](size_t begin, size_t end) {
+      return std::vector<int>(values.begin() + begin, values.begin() + end);
+    },
+    [](std::vector<int> a, std::vector<int> b) {
+      a.insert(a.end(), b.begin(), b.end());
+      return a;
+    });
+
+  EXPECT_EQ(concatenated, values);
+}
+
+TEST(TaskScheduler, ExceptionIsRethrownAfterTheOtherIndices)
+{
+  TaskScheduler scheduler(4);
+  std::atomic<int> count{0};
+
+  EXPECT_THROW(
+    scheduler.parallel_for(
+      100,
+      [&](size_t i) {
+        ++count;
+        if (i == 10) throw std::runtime_error("failed");
+      }),
+    std::runtime_error);
+  EXPECT_EQ(count, 100);
+
+  TaskGroup group(scheduler);
+  group.run([] { throw std::runtime_error("failed"); });
+  EXPECT_THROW(group.wait(), std::runtime_error);
+}
+
+TEST(TaskScheduler, SingleThread)
+{
+  TaskScheduler scheduler(1);
+  int sum = 0;
+
+  TaskGroup group(scheduler);
+  for (int i = 0; i < 10; ++i) {
+    group.run([&sum, i] { sum += i; });
+  }
+  group.wait();
+
+  EXPECT_EQ(scheduler.thread_num(), 1u);
+  EXPECT_EQ(sum, 45);
+}
+
+TEST(BoundedQueue, Close)
+{
+  BoundedQueue<int> queue(2);
+  std::vector<int> popped;
+
+  std::thread consumer([&] {
+    while (auto item = queue.pop()) {
+      popped.push_back(*item);
+    }
+  });
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(queue.push(int{i}));
+  }
+  queue.close();
+  consumer.join();
+
+  EXPECT_EQ(popped.size(), 100u);
+  EXPECT_EQ(popped.back(), 99);
+  EXPECT_FALSE(queue.push(0));
+}
+
+TEST(MemoryBudget, OversizedReservationWhenEmpty)
+{
+  MemoryBudget budget(100);
+
+  {
+    MemoryReservation large(budget, 1000);
+    EXPECT_EQ(budget.reserved(), 1000u);
+    EXPECT_FALSE(budget.try_acquire(1));
+  }
+
+  EXPECT_TRUE(budget.try_acquire(60));
+  EXPECT_FALSE(budget.try_acquire(60));
+  budget.release(60);
+  EXPECT_EQ(budget.reserved(), 0u);
+
+  // The release of another thread lets the blocked reservation through
+  budget.acquire(80);
+  std::thread releaser([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    budget.release(80);
+  });
+  budget.acquire(50);
+  releaser.join();
+  EXPECT_EQ(budget.reserved(), 50u);
+}
+
+TEST(Budget, ResolveThreadNum)
+{
+  autoware::task_scheduler::set_thread_budget(4);
+
+  EXPECT_EQ(autoware::task_scheduler::resolve_thread_num(0), 4u);
+  EXPECT_EQ(autoware::task_scheduler::resolve_thread_num(2), 2u);
+  EXPECT_EQ(autoware::task_scheduler::resolve_thread_num(16), 4u);
+}
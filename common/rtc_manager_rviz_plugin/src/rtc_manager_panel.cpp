@@ -24,8 +24,12 @@
 #include <unique_identifier_msgs/msg/uuid.hpp>
 
 #include <algorithm>
+#include <iomanip>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace rviz_plugins
 {
@@ -37,6 +41,9 @@ inline bool uint2bool(uint8_t var)
 {
   return var == static_cast<uint8_t>(0) ? false : true;
 }
+static const QColor COLOR_GREEN("#3dff3d");
+static const QColor COLOR_YELLOW("#ffff3d");
+static const QColor COLOR_RED("#ff3d3d");
 using std::placeholders::_1;
 using std::placeholders::_2;
 
@@ -243,17 +250,22 @@ RTCManagerPanel::RTCManagerPanel(QWidget * parent) : rviz_common::Panel(parent)
     vertical_header->hide();
     auto horizontal_header = new QHeaderView(Qt::Horizontal);
     horizontal_header->setSectionResizeMode(QHeaderView::Stretch);
-    rtc_table_ = new QTableWidget();
-    rtc_table_->setColumnCount(column_size_);
-    rtc_table_->setHorizontalHeaderLabels(
+    rtc_table_model_ = new RTCStatusTableModel(
       {"ID", "Module", "AW\nSafe", "Recv\nCmd", "Auto\nMode", "State", "Start\nDistance",
-       "Finish\nDistance"});
+       "Finish\nDistance"},
+      this);
+    rtc_table_ = new QTableView();
+    rtc_table_->setModel(rtc_table_model_);
     rtc_table_->setVerticalHeader(vertical_header);
     rtc_table_->setHorizontalHeader(horizontal_header);
     rtc_table_layout->addWidget(rtc_table_);
     v_layout->addLayout(rtc_table_layout);
   }
   setLayout(v_layout);
+
+  refresh_timer_ = new QTimer(this);
+  connect(refresh_timer_, &QTimer::timeout, this, &RTCManagerPanel::onTimer);
+  refresh_timer_->start(refresh_period_ms_);
 }
 
 void RTCManagerPanel::onInitialize()
@@ -296,7 +308,7 @@ void RTCAutoMode::onChangeToManualMode()
   auto_module_button_ptr->setChecked(false);
 }
 
-CooperateCommand setRTCCommandFromStatus(CooperateStatus & status)
+CooperateCommand setRTCCommandFromStatus(const CooperateStatus & status)
 {
   CooperateCommand cooperate_command;
   cooperate_command.uuid = status.uuid;
@@ -312,7 +324,7 @@ void RTCManagerPanel::onClickChangeRequest(const bool is_path_change, const uint
   auto executable_cooperate_commands_request = std::make_shared<CooperateCommands::Request>();
   executable_cooperate_commands_request->stamp = cooperate_statuses_ptr_->stamp;
   // send coop request
-  for (auto status : cooperate_statuses_ptr_->statuses) {
+  for (const auto & status : cooperate_statuses_ptr_->statuses) {
     if (is_path_change ^ isPathChangeModule(status.module.type)) continue;
     CooperateCommand cooperate_command = setRTCCommandFromStatus(status);
     cooperate_command.command.type = command;
@@ -332,7 +344,7 @@ void RTCManagerPanel::onClickCommandRequest(const uint8_t command)
   auto executable_cooperate_commands_request = std::make_shared<CooperateCommands::Request>();
   executable_cooperate_commands_request->stamp = cooperate_statuses_ptr_->stamp;
   // send coop request
-  for (auto status : cooperate_statuses_ptr_->statuses) {
+  for (const auto & status : cooperate_statuses_ptr_->statuses) {
     CooperateCommand cooperate_command = setRTCCommandFromStatus(status);
     cooperate_command.command.type = command;
     executable_cooperate_commands_request->commands.emplace_back(cooperate_command);
@@ -367,139 +379,117 @@ void RTCManagerPanel::onClickWait()
 
 void RTCManagerPanel::onRTCStatus(const CooperateStatusArray::ConstSharedPtr msg)
 {
-  cooperate_statuses_ptr_ = std::make_shared<CooperateStatusArray>(*msg);
-  rtc_table_->clearContents();
-  num_rtc_status_ptr_->setText(
-    QString::fromStdString("The Number of RTC Statuses: " + std::to_string(msg->statuses.size())));
-  if (msg->statuses.empty()) {
-    rtc_table_->update();
-    return;
-  }
-  // this is to stable rtc display not to occupy too much
-  size_t min_display_size{5};
-  size_t max_display_size{10};
-  // rtc messages are already sorted by distance
-  rtc_table_->setRowCount(
-    std::max(min_display_size, std::min(msg->statuses.size(), max_display_size)));
-  int cnt = 0;
-
-  auto sorted_statuses = msg->statuses;
-  std::partition(sorted_statuses.begin(), sorted_statuses.end(), [](const auto & status) {
-    return !status.auto_mode && !uint2bool(status.command_status.type);
-  });
+  cooperate_statuses_ptr_ = msg;
+  is_rtc_status_updated_ = true;
+}
 
-  for (auto status : sorted_statuses) {
-    if (static_cast<size_t>(cnt) >= max_display_size) {
-      rtc_table_->update();
-      return;
-    }
-    // uuid
-    {
-      std::stringstream uuid;
-      uuid << std::setw(4) << std::setfill('0') << static_cast<int>(status.uuid.uuid.at(0));
-      auto label = new QLabel(QString::fromStdString(uuid.str()));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(uuid.str()));
-      rtc_table_->setCellWidget(cnt, 0, label);
-    }
+RTCStatusTableModel::Row createRow(const CooperateStatus & status)
+{
+  RTCStatusTableModel::Row row;
+  std::copy(status.uuid.uuid.begin(), status.uuid.uuid.end(), row.uuid.begin());
 
-    // module name
-    {
-      std::string module_name = getModuleName(status.module.type);
-      auto label = new QLabel(QString::fromStdString(module_name));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(module_name));
-      rtc_table_->setCellWidget(cnt, 1, label);
-    }
+  // uuid
+  {
+    std::stringstream uuid;
+    uuid << std::setw(4) << std::setfill('0') << static_cast<int>(status.uuid.uuid.at(0));
+    row.texts.at(0) = QString::fromStdString(uuid.str());
+  }
 
-    // is aw safe
-    bool is_aw_safe = status.safe;
-    {
-      std::string is_safe = Bool2String(is_aw_safe);
-      auto label = new QLabel(QString::fromStdString(is_safe));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(is_safe));
-      rtc_table_->setCellWidget(cnt, 2, label);
-    }
+  // module name
+  row.texts.at(1) = QString::fromStdString(getModuleName(status.module.type));
 
-    // is operator safe
-    const bool is_execute = uint2bool(status.command_status.type);
-    {
-      std::string text = is_execute ? "EXECUTE" : "WAIT";
-      if (status.auto_mode) text = "NONE";
-      auto label = new QLabel(QString::fromStdString(text));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(text));
-      rtc_table_->setCellWidget(cnt, 3, label);
-    }
+  // is aw safe
+  const bool is_aw_safe = status.safe;
+  row.texts.at(2) = QString::fromStdString(Bool2String(is_aw_safe));
 
-    // is auto mode
-    const bool is_rtc_auto_mode = status.auto_mode;
-    {
-      std::string is_auto_mode = Bool2String(is_rtc_auto_mode);
-      auto label = new QLabel(QString::fromStdString(is_auto_mode));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(is_auto_mode));
-      rtc_table_->setCellWidget(cnt, 4, label);
-    }
+  // is operator safe
+  const bool is_execute = uint2bool(status.command_status.type);
+  {
+    std::string text = is_execute ? "EXECUTE" : "WAIT";
+    if (status.auto_mode) text = "NONE";
+    row.texts.at(3) = QString::fromStdString(text);
+  }
+
+  // is auto mode
+  const bool is_rtc_auto_mode = status.auto_mode;
+  row.texts.at(4) = QString::fromStdString(Bool2String(is_rtc_auto_mode));
 
-    // State
+  // State
+  {
     std::string module_state = "NONE";
-    {
-      switch (status.state.type) {
-        case State::WAITING_FOR_EXECUTION:
-          module_state = "Waiting";
-          break;
-        case State::RUNNING:
-          module_state = "Running";
-          break;
-        case State::ABORTING:
-          module_state = "Aborting";
-          break;
-        case State::SUCCEEDED:
-          module_state = "Succeeded";
-          break;
-        case State::FAILED:
-          module_state = "Failed";
-          break;
-        default:
-          break;
-      }
-      auto label = new QLabel(QString::fromStdString(module_state));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(module_state));
-      rtc_table_->setCellWidget(cnt, 5, label);
-    }
+    switch (status.state.type) {
+      case State::WAITING_FOR_EXECUTION:
+        module_state = "Waiting";
+        break;
+      case State::RUNNING:
+        module_state = "Running";
+        break;
+      case State::ABORTING:
+        module_state = "Aborting";
+        break;
+      case State::SUCCEEDED:
+        module_state = "Succeeded";
+        break;
+      case State::FAILED:
+        module_state = "Failed";
+        break;
+      default:
+        break;
+    }
+    row.texts.at(5) = QString::fromStdString(module_state);
+  }
 
-    // start distance
-    {
-      std::string start_distance = std::to_string(status.start_distance);
-      auto label = new QLabel(QString::fromStdString(start_distance));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(start_distance));
-      rtc_table_->setCellWidget(cnt, 6, label);
-    }
+  // start distance
+  row.texts.at(6) = QString::fromStdString(std::to_string(status.start_distance));
 
-    // finish distance
-    {
-      std::string finish_distance = std::to_string(status.finish_distance);
-      auto label = new QLabel(QString::fromStdString(finish_distance));
-      label->setAlignment(Qt::AlignCenter);
-      label->setText(QString::fromStdString(finish_distance));
-      rtc_table_->setCellWidget(cnt, 7, label);
-    }
+  // finish distance
+  row.texts.at(7) = QString::fromStdString(std::to_string(status.finish_distance));
+
+  // add color for recognition
+  if (is_rtc_auto_mode || (is_aw_safe && is_execute)) {
+    row.module_color = COLOR_GREEN;
+  } else if (is_aw_safe || is_execute) {
+    row.module_color = COLOR_YELLOW;
+  } else {
+    row.module_color = COLOR_RED;
+  }
+  return row;
+}
+
+void RTCManagerPanel::onTimer()
+{
+  if (!is_rtc_status_updated_ || !cooperate_statuses_ptr_) {
+    return;
+  }
+  is_rtc_status_updated_ = false;
+
+  const auto & statuses = cooperate_statuses_ptr_->statuses;
+  num_rtc_status_ptr_->setText(
+    QString::fromStdString("The Number of RTC Statuses: " + std::to_string(statuses.size())));
 
-    // add color for recognition
-    if (is_rtc_auto_mode || (is_aw_safe && is_execute)) {
-      rtc_table_->cellWidget(cnt, 1)->setStyleSheet(BG_GREEN);
-    } else if (is_aw_safe || is_execute) {
-      rtc_table_->cellWidget(cnt, 1)->setStyleSheet(BG_YELLOW);
-    } else {
-      rtc_table_->cellWidget(cnt, 1)->setStyleSheet(BG_RED);
+  // this is to stable rtc display not to occupy too much
+  size_t min_display_size{5};
+  size_t max_display_size{10};
+
+  // rtc messages are already sorted by distance, and the ones waiting for the operator come first
+  std::vector<const CooperateStatus *> sorted_statuses;
+  sorted_statuses.reserve(statuses.size());
+  for (const auto & status : statuses) {
+    sorted_statuses.push_back(&status);
+  }
+  std::partition(sorted_statuses.begin(), sorted_statuses.end(), [](const auto * status) {
+    return !status->auto_mode && !uint2bool(status->command_status.type);
+  });
+
+  std::vector<RTCStatusTableModel::Row> rows;
+  rows.reserve(std::min(sorted_statuses.size(), max_display_size));
+  for (const auto * status : sorted_statuses) {
+    if (max_display_size <= rows.size()) {
+      break;
     }
-    cnt++;
+    rows.push_back(createRow(*status));
   }
-  rtc_table_->update();
+  rtc_table_model_->setRows(std::move(rows), min_display_size);
 }
 }  // namespace rviz_plugins
 
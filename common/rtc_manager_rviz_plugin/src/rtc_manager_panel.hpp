@@ -21,7 +21,9 @@
 #include <QPushButton>
 #include <QSpinBox>
 #include <QString>
+#include <QTableView>
 #include <QTableWidget>
+#include <QTimer>
 
 #ifndef Q_MOC_RUN
 // cpp
@@ -46,6 +48,8 @@
 #include <tier4_rtc_msgs/srv/cooperate_commands.hpp>
 #endif
 
+#include "rtc_status_table_model.hpp"
+
 namespace rviz_plugins
 {
 using tier4_rtc_msgs::msg::Command;
@@ -93,6 +97,7 @@ public Q_SLOTS:
   void onClickWaitPathChange();
   void onClickExecuteVelChange();
   void onClickWaitVelChange();
+  void onTimer();
 
 public:
   explicit RTCManagerPanel(QWidget * parent = nullptr);
@@ -112,8 +117,12 @@ private:
   rclcpp::Client<AutoMode>::SharedPtr enable_auto_mode_cli_;
   std::vector<RTCAutoMode *> auto_modes_;
 
-  std::shared_ptr<CooperateStatusArray> cooperate_statuses_ptr_;
-  QTableWidget * rtc_table_;
+  CooperateStatusArray::ConstSharedPtr cooperate_statuses_ptr_;
+  // the statuses are received more often than the table needs to be refreshed
+  bool is_rtc_status_updated_{false};
+  QTimer * refresh_timer_;
+  RTCStatusTableModel * rtc_table_model_;
+  QTableView * rtc_table_;
   QTableWidget * auto_mode_table_;
   QPushButton * path_change_button_ptr_ = {nullptr};
   QPushButton * velocity_change_button_ptr_ = {nullptr};
@@ -125,7 +134,7 @@ private:
   QPushButton * wait_button_ptr_ = {nullptr};
   QLabel * num_rtc_status_ptr_ = {nullptr};
 
-  size_t column_size_ = {8};
+  int refresh_period_ms_ = {100};
   std::string enable_auto_mode_namespace_ = "/planning/enable_auto_mode";
 };
 
@@ -0,0 +1,115 @@
+//
+//  Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "rtc_status_table_model.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+RTCStatusTableModel::RTCStatusTableModel(const QStringList & headers, QObject * parent)
+: QAbstractTableModel(parent), headers_(headers)
+{
+}
+
+int RTCStatusTableModel::rowCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : static_cast<int>(rows_.size());
+}
+
+int RTCStatusTableModel::columnCount(const QModelIndex & parent) const
+{
+  return parent.isValid() ? 0 : column_size;
+}
+
+QVariant RTCStatusTableModel::data(const QModelIndex & index, int role) const
+{
+  if (!index.isValid() || rows_.size() <= static_cast<size_t>(index.row())) {
+    return {};
+  }
+
+  const auto & row = rows_.at(index.row());
+  switch (role) {
+    case Qt::DisplayRole:
+      return row.texts.at(index.column());
+    case Qt::TextAlignmentRole:
+      return static_cast<int>(Qt::AlignCenter);
+    case Qt::BackgroundRole:
+      // only the module name is colored for recognition
+      if (index.column() == 1 && row.module_color.isValid()) {
+        return row.module_color;
+      }
+      return {};
+    default:
+      return {};
+  }
+}
+
+QVariant RTCStatusTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+  if (role != Qt::DisplayRole || orientation != Qt::Horizontal || headers_.size() <= section) {
+    return {};
+  }
+  return headers_.at(section);
+}
+
+void RTCStatusTableModel::setRows(std::vector<Row> rows, const size_t min_row_num)
+{
+  if (rows.size() < min_row_num) {
+    rows.resize(min_row_num);
+  }
+
+  const int current_row_num = static_cast<int>(rows_.size());
+  const int new_row_num = static_cast<int>(rows.size());
+  if (new_row_num < current_row_num) {
+    beginRemoveRows(QModelIndex(), new_row_num, current_row_num - 1);
+    rows_.resize(new_row_num);
+    endRemoveRows();
+  }
+
+  // the order of the rows is that of the statuses, and a row of the same UUID as before notifies
+  // its changed cells only
+  for (int i = 0; i < std::min(current_row_num, new_row_num); ++i) {
+    auto & row = rows_.at(i);
+    auto & new_row = rows.at(i);
+    const bool is_same_status = row.uuid == new_row.uuid;
+    int first_column = column_size;
+    int last_column = -1;
+    for (int j = 0; j < column_size; ++j) {
+      const bool is_color_changed = j == 1 && row.module_color != new_row.module_color;
+      if (!is_same_status || row.texts.at(j) != new_row.texts.at(j) || is_color_changed) {
+        first_column = std::min(first_column, j);
+        last_column = j;
+      }
+    }
+    row = std::move(new_row);
+    if (first_column <= last_column) {
+      Q_EMIT dataChanged(index(i, first_column), index(i, last_column));
+    }
+  }
+
+  if (current_row_num < new_row_num) {
+    beginInsertRows(QModelIndex(), current_row_num, new_row_num - 1);
+    for (int i = current_row_num; i < new_row_num; ++i) {
+      rows_.push_back(std::move(rows.at(i)));
+    }
+    endInsertRows();
+  }
+}
+
+}  // namespace rviz_plugins
@@ -0,0 +1,74 @@
+//
+//  Copyright 2020 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef RTC_STATUS_TABLE_MODEL_HPP_
+#define RTC_STATUS_TABLE_MODEL_HPP_
+
+#include <QAbstractTableModel>
+#include <QColor>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+#ifndef Q_MOC_RUN
+#include <array>
+#include <cstdint>
+#include <vector>
+#endif
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief table of the RTC statuses, which notifies the view of the changed cells only
+ */
+class RTCStatusTableModel : public QAbstractTableModel
+{
+  Q_OBJECT
+
+public:
+  static constexpr int column_size = 8;
+
+  struct Row
+  {
+    std::array<uint8_t, 16> uuid{};
+    std::array<QString, column_size> texts;
+    QColor module_color;
+  };
+
+  explicit RTCStatusTableModel(const QStringList & headers, QObject * parent = nullptr);
+
+  int rowCount(const QModelIndex & parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex & parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex & index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(
+    int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+  /**
+   * @brief replace the rows, where the changed cells of a row of the same UUID as the current one
+   * and the whole rows of the other UUIDs are notified
+   * @param [in] rows new rows, which are padded with empty rows up to min_row_num
+   */
+  void setRows(std::vector<Row> rows, const size_t min_row_num);
+
+private:
+  QStringList headers_;
+  std::vector<Row> rows_;
+};
+
+}  // namespace rviz_plugins
+
+#endif  // RTC_STATUS_TABLE_MODEL_HPP_
@@ -271,6 +271,7 @@ void AutowareAutomaticGoalPanel::onAppendCheckpoint(const PoseStamped::ConstShar
   }
 
   goals_list_.at(current_goal_).checkpoint_pose_ptrs.push_back(pose);
+  clearRouteRequests();
   publishMarkers();
 }
 
@@ -80,22 +80,43 @@ void AutowareAutomaticGoalSender::initCommunication(rclcpp::Node * node)
   cli_clear_route_ = node->create_client<ClearRoute>("/api/routing/clear_route");
 
   cli_set_route_ = node->create_client<SetRoutePoints>("/api/routing/set_route_points");
+
+  sub_route_data_ = node->create_subscription<RouteMsg>(
+    "/api/routing/route", rclcpp::QoS{1}.transient_local(),
+    std::bind(&AutowareAutomaticGoalSender::onRouteData, this, std::placeholders::_1));
+
+  cli_set_planned_route_ = node->create_client<SetRoute>("/api/routing/set_route");
 }
 
 // Sub
 void AutowareAutomaticGoalSender::onRoute(const RouteState::ConstSharedPtr msg)
 {
+  const auto prev_state = state_;
   if (msg->state == RouteState::UNSET && state_ == State::CLEARING)
     state_ = State::CLEARED;
   else if (msg->state == RouteState::SET && state_ == State::PLANNING)
     state_ = State::PLANNED;
-  else if (msg->state == RouteState::ARRIVED && state_ == State::STARTED)
+  else if (msg->state == RouteState::ARRIVED && state_ == State::STARTED) {
     state_ = State::ARRIVED;
+    last_arrived_goal_ = current_goal_;
+  }
   onRouteUpdated(msg);
+
+  // do not wait for the timer to go on to the next step
+  if (state_ != prev_state) updateAutoExecutionTimerTick();
+}
+
+void AutowareAutomaticGoalSender::onRouteData(const RouteMsg::ConstSharedPtr msg)
+{
+  if (!planning_route_key_ || msg->data.empty()) return;
+  planned_routes_[*planning_route_key_] = msg->data.front().segments;
+  planning_route_key_.reset();
 }
 
 void AutowareAutomaticGoalSender::onOperationMode(const OperationModeState::ConstSharedPtr msg)
 {
+  const auto prev_state = state_;
+  const bool was_autonomous_mode_available = is_autonomous_mode_available_;
   if (msg->mode == OperationModeState::STOP && state_ == State::INITIALIZING)
     state_ = State::EDITING;
   else if (msg->mode == OperationModeState::STOP && state_ == State::STOPPING)
@@ -104,11 +125,68 @@ void AutowareAutomaticGoalSender::onOperationMode(const OperationModeState::Cons
     state_ = State::STARTED;
   is_autonomous_mode_available_ = msg->is_autonomous_mode_available;
   onOperationModeUpdated(msg);
+
+  // the route to the next goal is ready before arriving at the current one
+  if (state_ == State::STARTED && prev_state != State::STARTED && !goals_list_.empty())
+    prepareRouteRequest((current_goal_ + 1) % goals_list_.size());
+
+  // do not wait for the timer to go on to the next step
+  if (state_ != prev_state || is_autonomous_mode_available_ != was_autonomous_mode_available)
+    updateAutoExecutionTimerTick();
+}
+
+AutowareAutomaticGoalSender::SetRoutePoints::Request::SharedPtr
+AutowareAutomaticGoalSender::getRouteRequest(const unsigned goal_index)
+{
+  auto & req = route_requests_[goal_index];
+  if (!req) {
+    req = std::make_shared<SetRoutePoints::Request>();
+    req->header = goals_list_.at(goal_index).goal_pose_ptr->header;
+    req->goal = goals_list_.at(goal_index).goal_pose_ptr->pose;
+    for (const auto & checkpoint : goals_list_.at(goal_index).checkpoint_pose_ptrs) {
+      req->waypoints.push_back(checkpoint->pose);
+    }
+  }
+  return req;
+}
+
+bool AutowareAutomaticGoalSender::callSetPlannedRoute(const unsigned goal_index)
+{
+  if (!last_arrived_goal_) return false;
+  const auto key = std::make_pair(*last_arrived_goal_, goal_index);
+  const auto route = planned_routes_.find(key);
+  if (route == planned_routes_.end() || !cli_set_planned_route_->service_is_ready()) return false;
+
+  const auto points_req = getRouteRequest(goal_index);
+  auto req = std::make_shared<SetRoute::Request>();
+  req->header = points_req->header;
+  req->goal = points_req->goal;
+  req->segments = route->second;
+  planning_route_key_.reset();
+
+  cli_set_planned_route_->async_send_request(
+    req, [this, key, goal_index](rclcpp::Client<SetRoute>::SharedFuture result) {
+      if (result.get()->status.code != 0) {
+        // e.g. the vehicle has been moved off the route, which is then planned again
+        RCLCPP_WARN(
+          get_logger(), "Planned route is rejected: %s. Replanning...",
+          result.get()->status.message.c_str());
+        planned_routes_.erase(key);
+        if (goal_index >= goals_list_.size() || !callPlanToGoalIndex(cli_set_route_, goal_index))
+          state_ = State::ERROR;
+      } else {
+        printCallResult<SetRoute>(result);
+      }
+      onCallResult();
+      updateAutoExecutionTimerTick();
+    });
+  return true;
 }
 
 // Update
 void AutowareAutomaticGoalSender::updateGoalsList()
 {
+  clearRouteRequests();
   unsigned i = 0;
   for (const auto & goal : goals_list_) {
     std::stringstream ss;
@@ -119,6 +197,10 @@ void AutowareAutomaticGoalSender::updateGoalsList()
     ss << goal.goal_pose_ptr->pose.position.y << ", " << tf2::getYaw(tf2_quat) << ")";
     goals_achieved_.insert({i++, std::make_pair(ss.str(), 0)});
   }
+  // the requests of the whole list are built at once rather than between the goals
+  for (unsigned goal_index = 0; goal_index < goals_list_.size(); ++goal_index) {
+    prepareRouteRequest(goal_index);
+  }
   onGoalListUpdated();
 }
 
@@ -132,6 +214,7 @@ void AutowareAutomaticGoalSender::updateAutoExecutionTimerTick()
 
   } else if (state_ == State::EDITING) {  // skip the editing step by default
     state_ = State::AUTO_NEXT;
+    updateAutoExecutionTimerTick();
 
   } else if (state_ == State::AUTO_NEXT) {  // plan to next goal
     RCLCPP_INFO_STREAM(get_logger(), goal << ": Goal set as the next. Planning in progress...");
@@ -157,6 +240,7 @@ void AutowareAutomaticGoalSender::updateAutoExecutionTimerTick()
     current_goal_++;
     current_goal_ = current_goal_ % goals_list_.size();
     state_ = State::AUTO_NEXT;
+    updateAutoExecutionTimerTick();
 
   } else if (state_ == State::STOPPED) {
     RCLCPP_WARN_STREAM(
@@ -193,25 +277,33 @@ void AutowareAutomaticGoalSender::loadGoalsList(const std::string & file_path)
 
 void AutowareAutomaticGoalSender::updateAchievedGoalsFile(const unsigned goal_index)
 {
-  if (!goals_achieved_file_path_.empty()) {
-    std::ofstream out(goals_achieved_file_path_, std::fstream::app);
-    std::stringstream ss;
-    ss << "[" << getTimestamp() << "] Achieved: " << goals_achieved_[goal_index].first;
-    ss << ", Current number of achievements: " << goals_achieved_[goal_index].second << "\n";
-    out << ss.str();
-    out.close();
-  }
+  std::stringstream ss;
+  ss << "[" << getTimestamp() << "] Achieved: " << goals_achieved_[goal_index].first;
+  ss << ", Current number of achievements: " << goals_achieved_[goal_index].second << "\n";
+  appendToAchievedGoalsFile(ss.str());
 }
 
 void AutowareAutomaticGoalSender::resetAchievedGoals()
 {
   goals_achieved_.clear();
-  if (!goals_achieved_file_path_.empty()) {
-    std::ofstream out(goals_achieved_file_path_, std::fstream::app);
-    out << "[" << getTimestamp()
-        << "] GoalsList was loaded from a file or a goal was removed - counters have been reset\n";
-    out.close();
+  appendToAchievedGoalsFile(
+    "[" + getTimestamp() +
+    "] GoalsList was loaded from a file or a goal was removed - counters have been reset\n");
+}
+
+void AutowareAutomaticGoalSender::appendToAchievedGoalsFile(const std::string & line)
+{
+  if (goals_achieved_file_path_.empty()) return;
+
+  // the file is reopened only when its path is changed
+  if (opened_goals_achieved_file_path_ != goals_achieved_file_path_ || !goals_achieved_file_) {
+    goals_achieved_file_.close();
+    goals_achieved_file_.clear();
+    goals_achieved_file_.open(goals_achieved_file_path_, std::fstream::app);
+    opened_goals_achieved_file_path_ = goals_achieved_file_path_;
   }
+  // flushed at each line not to lose the achievements when the process is killed
+  goals_achieved_file_ << line << std::flush;
 }
 }  // namespace automatic_goal
 
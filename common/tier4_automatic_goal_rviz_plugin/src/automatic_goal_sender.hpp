@@ -17,9 +17,11 @@
 #include <rclcpp/rclcpp.hpp>
 
 #include <autoware_adapi_v1_msgs/msg/operation_mode_state.hpp>
+#include <autoware_adapi_v1_msgs/msg/route.hpp>
 #include <autoware_adapi_v1_msgs/msg/route_state.hpp>
 #include <autoware_adapi_v1_msgs/srv/change_operation_mode.hpp>
 #include <autoware_adapi_v1_msgs/srv/clear_route.hpp>
+#include <autoware_adapi_v1_msgs/srv/set_route.hpp>
 #include <autoware_adapi_v1_msgs/srv/set_route_points.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
@@ -32,6 +34,7 @@
 #include <fstream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -61,6 +64,9 @@ class AutowareAutomaticGoalSender : public rclcpp::Node
   using OperationModeState = autoware_adapi_v1_msgs::msg::OperationModeState;
   using ChangeOperationMode = autoware_adapi_v1_msgs::srv::ChangeOperationMode;
   using RouteState = autoware_adapi_v1_msgs::msg::RouteState;
+  using RouteMsg = autoware_adapi_v1_msgs::msg::Route;
+  using RouteSegment = autoware_adapi_v1_msgs::msg::RouteSegment;
+  using SetRoute = autoware_adapi_v1_msgs::srv::SetRoute;
   using SetRoutePoints = autoware_adapi_v1_msgs::srv::SetRoutePoints;
   using ClearRoute = autoware_adapi_v1_msgs::srv::ClearRoute;
 
@@ -74,25 +80,44 @@ protected:
   bool callPlanToGoalIndex(
     const rclcpp::Client<SetRoutePoints>::SharedPtr client, const unsigned goal_index)
   {
+    if (callSetPlannedRoute(goal_index)) return true;
+
     if (!client->service_is_ready()) {
       RCLCPP_WARN(get_logger(), "SetRoutePoints client is unavailable");
       return false;
     }
 
-    auto req = std::make_shared<SetRoutePoints::Request>();
-    req->header = goals_list_.at(goal_index).goal_pose_ptr->header;
-    req->goal = goals_list_.at(goal_index).goal_pose_ptr->pose;
-    for (const auto & checkpoint : goals_list_.at(goal_index).checkpoint_pose_ptrs) {
-      req->waypoints.push_back(checkpoint->pose);
-    }
+    // the route is kept once it is planned, if the vehicle starts from a goal
+    planning_route_key_.reset();
+    if (last_arrived_goal_) planning_route_key_ = std::make_pair(*last_arrived_goal_, goal_index);
+
     client->async_send_request(
-      req, [this](typename rclcpp::Client<SetRoutePoints>::SharedFuture result) {
-        if (result.get()->status.code != 0) state_ = State::ERROR;
+      getRouteRequest(goal_index),
+      [this](typename rclcpp::Client<SetRoutePoints>::SharedFuture result) {
+        if (result.get()->status.code != 0) {
+          state_ = State::ERROR;
+          planning_route_key_.reset();
+        }
         printCallResult<SetRoutePoints>(result);
         onCallResult();
+        updateAutoExecutionTimerTick();
       });
     return true;
   }
+  // the route requests are built in advance, e.g. for the next goal while driving to the current
+  SetRoutePoints::Request::SharedPtr getRouteRequest(const unsigned goal_index);
+  void prepareRouteRequest(const unsigned goal_index) { getRouteRequest(goal_index); }
+  // to be called when the goals or their checkpoints are changed
+  void clearRouteRequests()
+  {
+    route_requests_.clear();
+    planned_routes_.clear();
+    planning_route_key_.reset();
+    last_arrived_goal_.reset();
+  }
+  // reissue the route planned before from the last arrived goal, falling back to planning it with
+  // the route points if it is not kept or it is rejected
+  bool callSetPlannedRoute(const unsigned goal_index);
   template <typename T>
   bool callService(const typename rclcpp::Client<T>::SharedPtr client)
   {
@@ -106,6 +131,7 @@ protected:
       if (result.get()->status.code != 0) state_ = State::ERROR;
       printCallResult<T>(result);
       onCallResult();
+      updateAutoExecutionTimerTick();
     });
     return true;
   }
@@ -132,12 +158,14 @@ protected:
 
   // Update
   void updateGoalsList();
+  // advance the state machine, which is called at each state change as well as by the timer
   virtual void updateAutoExecutionTimerTick();
 
   // File
   void loadGoalsList(const std::string & file_path);
   void updateAchievedGoalsFile(const unsigned goal_index);
   void resetAchievedGoals();
+  void appendToAchievedGoalsFile(const std::string & line);
   static std::string getTimestamp()
   {
     char buffer[128];
@@ -148,6 +176,7 @@ protected:
 
   // Sub
   void onRoute(const RouteState::ConstSharedPtr msg);
+  void onRouteData(const RouteMsg::ConstSharedPtr msg);
   void onOperationMode(const OperationModeState::ConstSharedPtr msg);
 
   // Interface
@@ -161,6 +190,7 @@ protected:
   rclcpp::Client<ChangeOperationMode>::SharedPtr cli_change_to_stop_{nullptr};
   rclcpp::Client<ClearRoute>::SharedPtr cli_clear_route_{nullptr};
   rclcpp::Client<SetRoutePoints>::SharedPtr cli_set_route_{nullptr};
+  rclcpp::Client<SetRoute>::SharedPtr cli_set_planned_route_{nullptr};
 
   // Containers
   unsigned current_goal_{0};
@@ -175,11 +205,21 @@ private:
 
   // Sub
   rclcpp::Subscription<RouteState>::SharedPtr sub_route_{nullptr};
+  rclcpp::Subscription<RouteMsg>::SharedPtr sub_route_data_{nullptr};
   rclcpp::Subscription<OperationModeState>::SharedPtr sub_operation_mode_{nullptr};
 
   // Containers
   std::string goals_list_file_path_{};
   rclcpp::TimerBase::SharedPtr timer_{nullptr};
+  std::map<unsigned, SetRoutePoints::Request::SharedPtr> route_requests_{};
+  // the segments of the routes planned from a goal to a goal with its checkpoints, by the indices
+  // of the goals, which are reissued on the later loops of the list without planning
+  std::map<std::pair<unsigned, unsigned>, std::vector<RouteSegment>> planned_routes_{};
+  std::optional<std::pair<unsigned, unsigned>> planning_route_key_{};
+  std::optional<unsigned> last_arrived_goal_{};
+  // the achieved goals file is kept open and only appended to
+  std::ofstream goals_achieved_file_{};
+  std::string opened_goals_achieved_file_path_{};
 };
 }  // namespace automatic_goal
 #endif  // AUTOMATIC_GOAL_SENDER_HPP_
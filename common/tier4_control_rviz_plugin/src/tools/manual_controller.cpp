@@ -22,6 +22,11 @@
 #include <QVBoxLayout>
 #include <rviz_common/display_context.hpp>
 
+#include <pthread.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <string>
 
@@ -88,20 +93,138 @@ ManualController::ManualController(QWidget * parent) : rviz_common::Panel(parent
   cruise_velocity_layout->addWidget(steering_angle_ptr_);
   cruise_velocity_layout->addWidget(new QLabel("  [deg]"));
 
+  auto * publish_layout = new QHBoxLayout();
+  // Publish Rate
+  {
+    publish_rate_input_ = new QSpinBox();
+    publish_rate_input_->setRange(1, 100);
+    publish_rate_input_->setValue(static_cast<int>(publish_rate_));
+    connect(publish_rate_input_, SIGNAL(valueChanged(int)), this, SLOT(onPublishRateChange(int)));
+    period_statistics_label_ptr_ = new QLabel("period: -");
+    publish_layout->addWidget(new QLabel("publish rate "));
+    publish_layout->addWidget(publish_rate_input_);
+    publish_layout->addWidget(new QLabel("  [Hz]"));
+    publish_layout->addWidget(period_statistics_label_ptr_);
+  }
+
   // Layout
   auto * v_layout = new QVBoxLayout;
   v_layout->addLayout(state_layout);
   v_layout->addLayout(cruise_velocity_layout);
+  v_layout->addLayout(publish_layout);
   setLayout(v_layout);
 
   auto * timer = new QTimer(this);
-  connect(timer, &QTimer::timeout, this, &ManualController::update);
-  timer->start(30);
+  connect(timer, &QTimer::timeout, this, &ManualController::updatePeriodStatistics);
+  timer->start(1000);
 }
 
-void ManualController::update()
+ManualController::~ManualController()
+{
+  if (!publish_thread_.joinable()) return;
+
+  {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    is_stopping_ = true;
+  }
+  publish_cv_.notify_one();
+  publish_thread_.join();
+}
+
+void ManualController::runPublishThread()
+{
+  using std::chrono::steady_clock;
+
+  int applied_priority = 0;
+  auto deadline = steady_clock::now();
+  auto prev_publish_time = deadline;
+  bool has_published = false;
+  while (true) {
+    const double target_period = 1.0 / publish_rate_;
+    const auto target_duration = std::chrono::duration_cast<steady_clock::duration>(
+      std::chrono::duration<double>(target_period));
+    deadline += target_duration;
+    {
+      std::unique_lock<std::mutex> lock(publish_mutex_);
+      if (publish_cv_.wait_until(lock, deadline, [this]() { return is_stopping_; })) {
+        return;
+      }
+    }
+
+    // the missed deadlines are skipped instead of publishing them in a burst
+    const auto now = steady_clock::now();
+    if (now > deadline + target_duration) {
+      deadline = now;
+    }
+
+    const int priority = realtime_priority_;
+    if (priority != applied_priority) {
+      applyRealtimePriority(priority);
+      applied_priority = priority;
+    }
+
+    publishCommands();
+
+    if (has_published) {
+      const double period = std::chrono::duration<double>(now - prev_publish_time).count();
+      const double jitter = period - target_period;
+      std::lock_guard<std::mutex> lock(publish_mutex_);
+      auto & s = period_statistics_;
+      ++s.count;
+      s.sum += period;
+      s.sum_sq_jitter += jitter * jitter;
+      s.max_abs_jitter = std::max(s.max_abs_jitter, std::abs(jitter));
+      s.late_count += period > 2.0 * target_period ? 1 : 0;
+    }
+    prev_publish_time = now;
+    has_published = true;
+  }
+}
+
+void ManualController::applyRealtimePriority(const int priority)
+{
+  sched_param param{};
+  param.sched_priority = priority;
+  const int result =
+    pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+  if (result != 0) {
+    // e.g. without CAP_SYS_NICE or rtprio in /etc/security/limits.conf
+    RCLCPP_WARN_STREAM(
+      raw_node_->get_logger(),
+      "failed to set the priority of the manual controller to " << priority << ": "
+                                                                 << std::strerror(result));
+  }
+}
+
+void ManualController::onPublishRateChange(const int rate)
+{
+  publish_rate_ = rate;
+}
+
+void ManualController::updatePeriodStatistics()
+{
+  PeriodStatistics s;
+  {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    std::swap(s, period_statistics_);
+  }
+  if (s.count == 0) {
+    period_statistics_label_ptr_->setText("period: -");
+    return;
+  }
+  const double mean_ms = s.sum / s.count * 1e3;
+  const double rms_jitter_ms = std::sqrt(s.sum_sq_jitter / s.count) * 1e3;
+  const double max_jitter_ms = s.max_abs_jitter * 1e3;
+  period_statistics_label_ptr_->setText(
+    QString("period: %1 ms (jitter rms %2 ms, max %3 ms, late %4)")
+      .arg(mean_ms, 0, 'f', 1)
+      .arg(rms_jitter_ms, 0, 'f', 2)
+      .arg(max_jitter_ms, 0, 'f', 2)
+      .arg(s.late_count));
+}
+
+void ManualController::publishCommands()
 {
-  if (!raw_node_) return;
 
   const auto velocity = sub_velocity_->takeData();
   const double current_velocity = velocity ? velocity->longitudinal_velocity : 0.0;
@@ -113,7 +236,7 @@ void ManualController::update()
   {
     control_cmd.stamp = raw_node_->get_clock()->now();
     control_cmd.lateral.steering_tire_angle = steering_angle_;
-    control_cmd.longitudinal.velocity = cruise_velocity_;
+    control_cmd.longitudinal.velocity = cruise_velocity_.load();
     /**
      * @brief Calculate desired acceleration by simple BackSteppingControl
      *  V = 0.5*(v-v_des)^2 >= 0
@@ -122,7 +245,7 @@ void ManualController::update()
      */
     const double k = -0.5;
     const double v = current_velocity;
-    const double v_des = cruise_velocity_;
+    const double v_des = control_cmd.longitudinal.velocity;
     const double a = current_acceleration;
     const double a_des = k * (v - v_des) + a;
     control_cmd.longitudinal.acceleration = std::clamp(a_des, -1.0, 1.0);
@@ -147,9 +270,11 @@ void ManualController::update()
 void ManualController::onManualSteering()
 {
   const double scale_factor = -0.25;
-  steering_angle_ = scale_factor * steering_slider_ptr_->sliderPosition() * M_PI / 180.0;
+  const double steering_angle =
+    scale_factor * steering_slider_ptr_->sliderPosition() * M_PI / 180.0;
+  steering_angle_ = steering_angle;
   const QString steering_string =
-    QString::fromStdString(std::to_string(steering_angle_ * 180.0 / M_PI));
+    QString::fromStdString(std::to_string(steering_angle * 180.0 / M_PI));
   steering_angle_ptr_->setText(steering_string);
 }
 
@@ -186,6 +311,28 @@ void ManualController::onInitialize()
     raw_node_->create_publisher<Control>("/external/selected/control_cmd", rclcpp::QoS(1));
 
   pub_gear_cmd_ = raw_node_->create_publisher<GearCommand>("/external/selected/gear_cmd", 1);
+
+  publish_thread_ = std::thread([this]() { runPublishThread(); });
+}
+
+void ManualController::save(rviz_common::Config config) const
+{
+  Panel::save(config);
+  config.mapSetValue("PublishRate", publish_rate_input_->value());
+  config.mapSetValue("RealtimePriority", realtime_priority_.load());
+}
+
+void ManualController::load(const rviz_common::Config & config)
+{
+  Panel::load(config);
+  int rate = 30;
+  if (config.mapGetInt("PublishRate", &rate)) {
+    publish_rate_input_->setValue(rate);
+  }
+  int priority = 10;
+  if (config.mapGetInt("RealtimePriority", &priority)) {
+    realtime_priority_ = std::clamp(priority, 0, 99);
+  }
 }
 
 void ManualController::onGateMode(const tier4_control_msgs::msg::GateMode::ConstSharedPtr msg)
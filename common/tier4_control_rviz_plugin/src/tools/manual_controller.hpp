@@ -35,7 +35,12 @@
 #include <tier4_control_msgs/msg/gate_mode.hpp>
 #include <tier4_external_api_msgs/srv/engage.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace rviz_plugins
 {
@@ -55,19 +60,44 @@ class ManualController : public rviz_common::Panel
 
 public:
   explicit ManualController(QWidget * parent = nullptr);
+  ~ManualController() override;
   void onInitialize() override;
+  void save(rviz_common::Config config) const override;
+  void load(const rviz_common::Config & config) override;
 
 public Q_SLOTS:  // NOLINT for Qt
   void onClickCruiseVelocity();
   void onClickEnableButton();
   void onManualSteering();
-  void update();
+  void onPublishRateChange(const int rate);
+  void updatePeriodStatistics();
 
 protected:
-  // Timer
-  rclcpp::TimerBase::SharedPtr timer_;
-  void onTimer();
-  void onPublishControlCommand();
+  /// Statistics of the publish periods since the last report
+  struct PeriodStatistics
+  {
+    size_t count{0};
+    double sum{0.0};             // [s]
+    double sum_sq_jitter{0.0};   // [s^2]
+    double max_abs_jitter{0.0};  // [s]
+    size_t late_count{0};        // periods longer than twice the target
+  };
+
+  // The commands are published by publish_thread_ at the deadlines of the steady clock, so that
+  // they do not depend on the rendering of rviz in the main thread
+  void runPublishThread();
+  void publishCommands();
+  void applyRealtimePriority(const int priority);
+
+  std::thread publish_thread_;
+  std::mutex publish_mutex_;
+  std::condition_variable publish_cv_;
+  bool is_stopping_{false};
+  std::atomic<double> publish_rate_{30.0};  // [Hz]
+  // SCHED_FIFO priority of publish_thread_, where 0 is the normal scheduling
+  std::atomic<int> realtime_priority_{10};
+  PeriodStatistics period_statistics_;  // guarded by publish_mutex_
+
   void onGateMode(const GateMode::ConstSharedPtr msg);
   void onEngageStatus(const Engage::ConstSharedPtr msg);
   void onGear(const GearReport::ConstSharedPtr msg);
@@ -83,8 +113,9 @@ protected:
   rclcpp::Client<EngageSrv>::SharedPtr client_engage_;
   rclcpp::Subscription<GearReport>::SharedPtr sub_gear_;
 
-  double cruise_velocity_{0.0};
-  double steering_angle_{0.0};
+  // read by publish_thread_
+  std::atomic<double> cruise_velocity_{0.0};
+  std::atomic<double> steering_angle_{0.0};
 
   QLabel * gate_mode_label_ptr_;
   QLabel * gear_label_ptr_;
@@ -94,6 +125,8 @@ protected:
   QSpinBox * cruise_velocity_input_;
   QDial * steering_slider_ptr_;
   QLabel * steering_angle_ptr_;
+  QSpinBox * publish_rate_input_;
+  QLabel * period_statistics_label_ptr_;
 
   bool current_engage_{false};
 };
@@ -59,9 +59,11 @@
 #include <rviz_common/properties/string_property.hpp>
 #include <rviz_common/validate_floats.hpp>
 #include <tier4_debug_rviz_plugin/jsk_overlay_utils.hpp>
+#include <tier4_debug_rviz_plugin/shared_subscription.hpp>
 
 #include <autoware_internal_debug_msgs/msg/float32_multi_array_stamped.hpp>
 
+#include <memory>
 #include <mutex>
 
 namespace rviz_plugins
@@ -114,7 +116,10 @@ protected:
   rviz_common::properties::FloatProperty * med_color_threshold_property_;
   rviz_common::properties::BoolProperty * clockwise_rotate_property_;
 
-  rclcpp::Subscription<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>::SharedPtr sub_;
+  // the subscription of the topic is shared by the displays of it, e.g. of different data_index
+  using Float32MultiArrayStampedSubscription =
+    SharedSubscription<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>;
+  std::shared_ptr<Float32MultiArrayStampedSubscription::Slot> slot_;
   int left_;
   int top_;
   uint16_t texture_size_;
@@ -134,6 +139,8 @@ protected:
   double max_color_threshold_;
   double med_color_threshold_;
   bool update_required_;
+  // the texture size or the position is changed, and the overlay is laid out again
+  bool layout_update_required_{true};
   bool first_time_;
   float data_;
   int data_index_{0};
@@ -0,0 +1,121 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef TIER4_DEBUG_RVIZ_PLUGIN__SHARED_SUBSCRIPTION_HPP_
+#define TIER4_DEBUG_RVIZ_PLUGIN__SHARED_SUBSCRIPTION_HPP_
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief subscription of a topic shared by the displays of the topic, which is deserialized once
+ * and fanned out to the slots of the displays. The subscription is kept while any slot of it is
+ */
+template <typename MessageT>
+class SharedSubscription
+{
+public:
+  using ConstSharedPtr = typename MessageT::ConstSharedPtr;
+
+  /// Latest message of the topic for a display, which is overwritten by the newer messages
+  class Slot
+  {
+  public:
+    explicit Slot(std::shared_ptr<SharedSubscription> subscription)
+    : subscription_(std::move(subscription))
+    {
+    }
+
+    /**
+     * @brief take the latest message, which is null if no message is received since the last take
+     */
+    ConstSharedPtr take() { return std::atomic_exchange(&msg_, ConstSharedPtr()); }
+
+  private:
+    friend class SharedSubscription;
+    std::shared_ptr<SharedSubscription> subscription_;
+    ConstSharedPtr msg_;
+  };
+
+  /**
+   * @brief get a new slot of the topic, which creates the subscription if there is not one of the
+   * node and the topic
+   */
+  static std::shared_ptr<Slot> subscribe(
+    const rclcpp::Node::SharedPtr & node, const std::string & topic_name, const rclcpp::QoS & qos)
+  {
+    static std::mutex pool_mutex;
+    static std::map<std::pair<const rclcpp::Node *, std::string>, std::weak_ptr<SharedSubscription>>
+      pool;
+
+    std::lock_guard<std::mutex> pool_lock(pool_mutex);
+    for (auto itr = pool.begin(); itr != pool.end();) {
+      itr = itr->second.expired() ? pool.erase(itr) : std::next(itr);
+    }
+    auto & weak_subscription = pool[{node.get(), topic_name}];
+    auto subscription = weak_subscription.lock();
+    if (!subscription) {
+      subscription = std::shared_ptr<SharedSubscription>(new SharedSubscription);
+      const std::weak_ptr<SharedSubscription> weak_this = subscription;
+      subscription->sub_ = node->create_subscription<MessageT>(
+        topic_name, qos, [weak_this](const ConstSharedPtr msg) {
+          if (const auto self = weak_this.lock()) {
+            self->fanOut(msg);
+          }
+        });
+      weak_subscription = subscription;
+    }
+
+    auto slot = std::make_shared<Slot>(subscription);
+    std::lock_guard<std::mutex> slots_lock(subscription->mutex_);
+    subscription->slots_.push_back(slot);
+    return slot;
+  }
+
+private:
+  SharedSubscription() = default;
+
+  void fanOut(const ConstSharedPtr & msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr = slots_.begin();
+    while (itr != slots_.end()) {
+      if (const auto slot = itr->lock()) {
+        std::atomic_store(&slot->msg_, msg);
+        ++itr;
+      } else {
+        itr = slots_.erase(itr);
+      }
+    }
+  }
+
+  typename rclcpp::Subscription<MessageT>::SharedPtr sub_;
+  std::mutex mutex_;
+  std::vector<std::weak_ptr<Slot>> slots_;
+};
+
+}  // namespace rviz_plugins
+
+#endif  // TIER4_DEBUG_RVIZ_PLUGIN__SHARED_SUBSCRIPTION_HPP_
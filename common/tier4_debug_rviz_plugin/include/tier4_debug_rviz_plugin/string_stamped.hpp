@@ -48,6 +48,7 @@
 #ifndef TIER4_DEBUG_RVIZ_PLUGIN__STRING_STAMPED_HPP_
 #define TIER4_DEBUG_RVIZ_PLUGIN__STRING_STAMPED_HPP_
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 
@@ -94,6 +95,7 @@ protected:
   rviz_common::properties::FloatProperty * property_value_scale_;
   rviz_common::properties::IntProperty * property_font_size_;
   rviz_common::properties::IntProperty * property_max_letter_num_;
+  rviz_common::properties::FloatProperty * property_update_rate_;
   // QImage hud_;
 
 private:
@@ -101,7 +103,13 @@ private:
   static constexpr int hand_width_ = 4;
 
   std::mutex mutex_;
+  // the latest message is swapped in by processMessage, and taken by update at most at the update
+  // rate, so that the messages between the updates are not painted
+  autoware_internal_debug_msgs::msg::StringStamped::ConstSharedPtr pending_msg_ptr_;
+  std::chrono::steady_clock::time_point last_paint_time_;
   autoware_internal_debug_msgs::msg::StringStamped::ConstSharedPtr last_msg_ptr_;
+  // the text or the appearance is changed, and the texture needs to be painted again
+  bool update_required_{false};
 };
 }  // namespace rviz_plugins
 
@@ -169,13 +169,26 @@ void Float32MultiArrayStampedPieChartDisplay::onInitialize()
 void Float32MultiArrayStampedPieChartDisplay::update(
   [[maybe_unused]] float wall_dt, [[maybe_unused]] float ros_dt)
 {
-  if (update_required_) {
-    update_required_ = false;
+  if (slot_) {
+    if (const auto msg = slot_->take()) {
+      processMessage(msg);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // the texture is painted and uploaded only when the value or the appearance is changed
+  if (!update_required_) {
+    return;
+  }
+  update_required_ = false;
+  if (layout_update_required_) {
+    layout_update_required_ = false;
     overlay_->updateTextureSize(texture_size_, texture_size_ + caption_offset_);
     overlay_->setPosition(left_, top_);
     overlay_->setDimensions(overlay_->getTextureWidth(), overlay_->getTextureHeight());
-    drawPlot(data_);
   }
+  drawPlot(data_);
 }
 
 void Float32MultiArrayStampedPieChartDisplay::processMessage(
@@ -298,17 +311,13 @@ void Float32MultiArrayStampedPieChartDisplay::subscribe()
 
   if (topic_name.length() > 0 && topic_name != "/") {
     rclcpp::Node::SharedPtr raw_node = context_->getRosNodeAbstraction().lock()->get_raw_node();
-    sub_ =
-      raw_node->create_subscription<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
-        topic_name, 1,
-        std::bind(
-          &Float32MultiArrayStampedPieChartDisplay::processMessage, this, std::placeholders::_1));
+    slot_ = Float32MultiArrayStampedSubscription::subscribe(raw_node, topic_name, rclcpp::QoS(1));
   }
 }
 
 void Float32MultiArrayStampedPieChartDisplay::unsubscribe()
 {
-  sub_.reset();
+  slot_.reset();
 }
 
 void Float32MultiArrayStampedPieChartDisplay::onEnable()
@@ -330,18 +339,21 @@ void Float32MultiArrayStampedPieChartDisplay::updateSize()
 
   texture_size_ = size_property_->getInt();
   update_required_ = true;
+  layout_update_required_ = true;
 }
 
 void Float32MultiArrayStampedPieChartDisplay::updateTop()
 {
   top_ = top_property_->getInt();
   update_required_ = true;
+  layout_update_required_ = true;
 }
 
 void Float32MultiArrayStampedPieChartDisplay::updateLeft()
 {
   left_ = left_property_->getInt();
   update_required_ = true;
+  layout_update_required_ = true;
 }
 
 void Float32MultiArrayStampedPieChartDisplay::updateBGColor()
@@ -395,6 +407,7 @@ void Float32MultiArrayStampedPieChartDisplay::updateTextSize()
   font.setPointSize(text_size_);
   caption_offset_ = QFontMetrics(font).height();
   update_required_ = true;
+  layout_update_required_ = true;
 }
 
 void Float32MultiArrayStampedPieChartDisplay::updateShowCaption()
@@ -88,6 +88,9 @@ StringStampedOverlayDisplay::StringStampedOverlayDisplay()
   property_max_letter_num_ = new rviz_common::properties::IntProperty(
     "Max Letter Num", 100, "Max Letter Num", this, SLOT(updateVisualization()), this);
   property_max_letter_num_->setMin(10);
+  property_update_rate_ = new rviz_common::properties::FloatProperty(
+    "Update Rate", 10.0, "Max rate of the update of the text [Hz]", this);
+  property_update_rate_->setMin(0.1);
 }
 
 StringStampedOverlayDisplay::~StringStampedOverlayDisplay()
@@ -133,10 +136,26 @@ void StringStampedOverlayDisplay::update(float wall_dt, float ros_dt)
   (void)wall_dt;
   (void)ros_dt;
 
+  const auto now = std::chrono::steady_clock::now();
+  const auto update_period = std::chrono::duration<double>(1.0 / property_update_rate_->getFloat());
+  if (now - last_paint_time_ < update_period) {
+    return;
+  }
+
+  const auto msg_ptr = std::atomic_exchange(
+    &pending_msg_ptr_, autoware_internal_debug_msgs::msg::StringStamped::ConstSharedPtr());
+
   std::lock_guard<std::mutex> message_lock(mutex_);
-  if (!last_msg_ptr_) {
+  if (msg_ptr && (!last_msg_ptr_ || last_msg_ptr_->data != msg_ptr->data)) {
+    last_msg_ptr_ = msg_ptr;
+    update_required_ = true;
+  }
+  // the texture is painted and uploaded only when the text or the appearance is changed
+  if (!last_msg_ptr_ || !update_required_) {
     return;
   }
+  update_required_ = false;
+  last_paint_time_ = now;
 
   // Display
   QColor background_color;
@@ -166,7 +185,8 @@ void StringStampedOverlayDisplay::update(float wall_dt, float ros_dt)
     std::max(h - property_value_height_offset_->getInt(), 1), Qt::AlignLeft | Qt::AlignTop,
     last_msg_ptr_->data.c_str());
   painter.end();
-  updateVisualization();
+
+  queueRender();
 }
 
 void StringStampedOverlayDisplay::processMessage(
@@ -176,16 +196,18 @@ void StringStampedOverlayDisplay::processMessage(
     return;
   }
 
-  {
-    std::lock_guard<std::mutex> message_lock(mutex_);
-    last_msg_ptr_ = msg_ptr;
-  }
-
-  queueRender();
+  // only the latest message is kept until the next update, which renders it if the text is changed
+  std::atomic_store(&pending_msg_ptr_, msg_ptr);
 }
 
 void StringStampedOverlayDisplay::updateVisualization()
 {
+  if (!overlay_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> message_lock(mutex_);
+  update_required_ = true;
   const int texture_size = property_font_size_->getInt() * property_max_letter_num_->getInt();
   overlay_->updateTextureSize(texture_size, texture_size);
   overlay_->setPosition(property_left_->getInt(), property_top_->getInt());
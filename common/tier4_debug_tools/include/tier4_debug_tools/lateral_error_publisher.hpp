@@ -22,10 +22,13 @@
 #include <autoware/motion_utils/trajectory/trajectory.hpp>
 #include <rclcpp/rclcpp.hpp>
 
+#include <autoware_internal_debug_msgs/msg/float32_multi_array_stamped.hpp>
 #include <autoware_internal_debug_msgs/msg/float32_stamped.hpp>
 #include <autoware_planning_msgs/msg/trajectory.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 
+#include <optional>
+
 class LateralErrorPublisher : public rclcpp::Node
 {
 public:
@@ -34,14 +37,17 @@ public:
 private:
   /* Parameters */
   double yaw_threshold_to_search_closest_;
+  bool publish_separate_lateral_errors_;
 
   /* States */
-  autoware_planning_msgs::msg::Trajectory::SharedPtr
+  autoware_planning_msgs::msg::Trajectory::ConstSharedPtr
     current_trajectory_ptr_;  //!< @brief reference trajectory
-  geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr
+  geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr
     current_vehicle_pose_ptr_;  //!< @brief current EKF pose
-  geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr
+  geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr
     current_ground_truth_pose_ptr_;  //!< @brief current GNSS pose
+  std::optional<size_t>
+    closest_index_cursor_;  //!< @brief closest index of the last pose on the current trajectory
 
   /* Publishers and Subscribers */
   rclcpp::Subscription<autoware_planning_msgs::msg::Trajectory>::SharedPtr
@@ -56,19 +62,26 @@ private:
     pub_localization_lateral_error_;  //!< @brief publisher for localization lateral error
   rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32Stamped>::SharedPtr
     pub_lateral_error_;  //!< @brief publisher for lateral error (control + localization)
+  rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>::SharedPtr
+    pub_lateral_errors_;  //!< @brief publisher for all the lateral errors in one message
 
   /**
    * @brief set current_trajectory_ with received message
    */
-  void onTrajectory(const autoware_planning_msgs::msg::Trajectory::SharedPtr);
+  void onTrajectory(const autoware_planning_msgs::msg::Trajectory::ConstSharedPtr msg);
   /**
    * @brief set current_vehicle_pose_ with received message
    */
-  void onVehiclePose(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg);
+  void onVehiclePose(const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr msg);
   /**
    * @brief set current_ground_truth_pose_ and calculate lateral error
    */
-  void onGroundTruthPose(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg);
+  void onGroundTruthPose(const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr msg);
+  /**
+   * @brief search the closest trajectory point to the pose around the cursor, and search the whole
+   * trajectory only if there is no cursor or the local result is not valid
+   */
+  std::optional<size_t> searchClosestIndex(const geometry_msgs::msg::Pose & pose);
 };
 
 #endif  // TIER4_DEBUG_TOOLS__LATERAL_ERROR_PUBLISHER_HPP_
@@ -14,6 +14,9 @@
 
 #include "tier4_debug_tools/lateral_error_publisher.hpp"
 
+#include <autoware/universe_utils/geometry/geometry.hpp>
+
+#include <cmath>
 #include <limits>
 
 LateralErrorPublisher::LateralErrorPublisher(const rclcpp::NodeOptions & node_options)
@@ -24,40 +27,51 @@ LateralErrorPublisher::LateralErrorPublisher(const rclcpp::NodeOptions & node_op
   /* Parameters */
   yaw_threshold_to_search_closest_ =
     declare_parameter("yaw_threshold_to_search_closest", M_PI / 4.0);
+  publish_separate_lateral_errors_ = declare_parameter("publish_separate_lateral_errors", true);
 
   /* Publishers and Subscribers */
+  // The inputs from the nodes in the same container are received without a copy
+  rclcpp::SubscriptionOptions input_options;
+  input_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   sub_trajectory_ = create_subscription<autoware_planning_msgs::msg::Trajectory>(
     "~/input/reference_trajectory", rclcpp::QoS{1},
-    std::bind(&LateralErrorPublisher::onTrajectory, this, _1));
+    std::bind(&LateralErrorPublisher::onTrajectory, this, _1), input_options);
   sub_vehicle_pose_ = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
     "~/input/vehicle_pose_with_covariance", rclcpp::QoS{1},
-    std::bind(&LateralErrorPublisher::onVehiclePose, this, _1));
+    std::bind(&LateralErrorPublisher::onVehiclePose, this, _1), input_options);
   sub_ground_truth_pose_ = create_subscription<geometry_msgs::msg::PoseWithCovarianceStamped>(
     "~/input/ground_truth_pose_with_covariance", rclcpp::QoS{1},
-    std::bind(&LateralErrorPublisher::onGroundTruthPose, this, _1));
-  pub_control_lateral_error_ = create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>(
-    "~/control_lateral_error", 1);
-  pub_localization_lateral_error_ =
-    create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>(
-      "~/localization_lateral_error", 1);
-  pub_lateral_error_ =
-    create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>("~/lateral_error", 1);
+    std::bind(&LateralErrorPublisher::onGroundTruthPose, this, _1), input_options);
+  pub_lateral_errors_ =
+    create_publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
+      "~/lateral_errors", 1);
+  if (publish_separate_lateral_errors_) {
+    pub_control_lateral_error_ =
+      create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>(
+        "~/control_lateral_error", 1);
+    pub_localization_lateral_error_ =
+      create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>(
+        "~/localization_lateral_error", 1);
+    pub_lateral_error_ =
+      create_publisher<autoware_internal_debug_msgs::msg::Float32Stamped>("~/lateral_error", 1);
+  }
 }
 
 void LateralErrorPublisher::onTrajectory(
-  const autoware_planning_msgs::msg::Trajectory::SharedPtr msg)
+  const autoware_planning_msgs::msg::Trajectory::ConstSharedPtr msg)
 {
   current_trajectory_ptr_ = msg;
+  closest_index_cursor_.reset();
 }
 
 void LateralErrorPublisher::onVehiclePose(
-  const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg)
+  const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr msg)
 {
   current_vehicle_pose_ptr_ = msg;
 }
 
 void LateralErrorPublisher::onGroundTruthPose(
-  const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg)
+  const geometry_msgs::msg::PoseWithCovarianceStamped::ConstSharedPtr msg)
 {
   current_ground_truth_pose_ptr_ = msg;
 
@@ -75,9 +89,7 @@ void LateralErrorPublisher::onGroundTruthPose(
   }
 
   // Search closest trajectory point with vehicle pose
-  const auto closest_index = autoware::motion_utils::findNearestIndex(
-    current_trajectory_ptr_->points, current_vehicle_pose_ptr_->pose.pose,
-    std::numeric_limits<double>::max(), yaw_threshold_to_search_closest_);
+  const auto closest_index = searchClosestIndex(current_vehicle_pose_ptr_->pose.pose);
   if (!closest_index) {
     RCLCPP_WARN_THROTTLE(
       this->get_logger(), *this->get_clock(), 1000 /* ms */, "Failed to search closest index");
@@ -132,21 +144,73 @@ void LateralErrorPublisher::onGroundTruthPose(
   RCLCPP_DEBUG(this->get_logger(), "localization_error: %f", lateral_error);
 
   // Publish lateral errors
+  const auto stamp = this->now();
+  autoware_internal_debug_msgs::msg::Float32MultiArrayStamped errors_msg;
+  errors_msg.stamp = stamp;
+  errors_msg.data = {
+    static_cast<float>(control_lateral_error), static_cast<float>(localization_lateral_error),
+    static_cast<float>(lateral_error)};
+  pub_lateral_errors_->publish(errors_msg);
+
+  if (!publish_separate_lateral_errors_) {
+    return;
+  }
+
   autoware_internal_debug_msgs::msg::Float32Stamped control_msg;
-  control_msg.stamp = this->now();
+  control_msg.stamp = stamp;
   control_msg.data = static_cast<float>(control_lateral_error);
   pub_control_lateral_error_->publish(control_msg);
 
   autoware_internal_debug_msgs::msg::Float32Stamped localization_msg;
-  localization_msg.stamp = this->now();
+  localization_msg.stamp = stamp;
   localization_msg.data = static_cast<float>(localization_lateral_error);
   pub_localization_lateral_error_->publish(localization_msg);
 
   autoware_internal_debug_msgs::msg::Float32Stamped sum_msg;
-  sum_msg.stamp = this->now();
+  sum_msg.stamp = stamp;
   sum_msg.data = static_cast<float>(lateral_error);
   pub_lateral_error_->publish(sum_msg);
 }
 
+std::optional<size_t> LateralErrorPublisher::searchClosestIndex(
+  const geometry_msgs::msg::Pose & pose)
+{
+  using autoware::universe_utils::calcSquaredDistance2d;
+  using autoware::universe_utils::calcYawDeviation;
+
+  const auto & points = current_trajectory_ptr_->points;
+
+  // Follow the decreasing distance from the cursor, since the pose moves little between messages
+  if (closest_index_cursor_ && *closest_index_cursor_ < points.size()) {
+    size_t index = *closest_index_cursor_;
+    double dist = calcSquaredDistance2d(points.at(index), pose);
+    while (index + 1 < points.size()) {
+      const double next_dist = calcSquaredDistance2d(points.at(index + 1), pose);
+      if (next_dist > dist) {
+        break;
+      }
+      ++index;
+      dist = next_dist;
+    }
+    while (index > 0) {
+      const double prev_dist = calcSquaredDistance2d(points.at(index - 1), pose);
+      if (prev_dist >= dist) {
+        break;
+      }
+      --index;
+      dist = prev_dist;
+    }
+    const double yaw_deviation = std::abs(calcYawDeviation(points.at(index).pose, pose));
+    if (yaw_deviation <= yaw_threshold_to_search_closest_) {
+      closest_index_cursor_ = index;
+      return index;
+    }
+  }
+
+  closest_index_cursor_ = autoware::motion_utils::findNearestIndex(
+    points, pose, std::numeric_limits<double>::max(), yaw_threshold_to_search_closest_);
+  return closest_index_cursor_;
+}
+
 #include <rclcpp_components/register_node_macro.hpp>
 RCLCPP_COMPONENTS_REGISTER_NODE(LateralErrorPublisher)
@@ -22,10 +22,14 @@
 #include <QLabel>
 #include <QMap>
 #include <QPushButton>
+#include <QTimer>
 #include <QVBoxLayout>
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
 #include <map>
 #include <string>
 #include <unordered_map>
@@ -59,14 +63,46 @@ Q_OBJECT  // This macro is needed for Qt to handle slots and signals
   void load(const rviz_common::Config & config) override;
 
 private:
+  using ConfigLogger = logging_demo::srv::ConfigLogger;
+
   QMap<QString, QButtonGroup *> buttonGroups_;
   rclcpp::Node::SharedPtr raw_node_;
 
   std::vector<LoggerNamespaceInfo> display_info_vec_;
 
-  // client_map_[node_name] = service_client
-  std::unordered_map<QString, rclcpp::Client<logging_demo::srv::ConfigLogger>::SharedPtr>
-    client_map_;
+  // client_map_[node_name] = service_client, which is created when the node is requested first
+  std::unordered_map<QString, rclcpp::Client<ConfigLogger>::SharedPtr> client_map_;
+
+  // requests to change the logging level of the loggers of a button
+  struct LoggingLevelJob
+  {
+    QString button_name;
+    QString level;
+    size_t remaining_num;
+    std::vector<QString> failed_loggers;
+  };
+  struct LoggerRequest
+  {
+    size_t job_id;
+    LoggerInfo logger_info;
+  };
+  struct InFlightLoggerRequest
+  {
+    LoggerRequest request;
+    int64_t request_id;
+    std::chrono::steady_clock::time_point send_time;
+  };
+  std::map<size_t, LoggingLevelJob> jobs_;
+  size_t next_job_id_{0};
+  // the latest job of each button, whose result is shown on the buttons
+  std::unordered_map<QString, size_t> latest_job_id_map_;
+  std::deque<LoggerRequest> request_queue_;
+  std::map<uint64_t, InFlightLoggerRequest> in_flight_requests_;
+  uint64_t next_request_key_{0};
+  QTimer * request_timer_;
+
+  static constexpr size_t max_in_flight_request_num_ = 16;
+  static constexpr std::chrono::milliseconds request_timeout_{1000};
 
   // button_map_[button_name][logging_level] = Q_button_pointer
   std::unordered_map<QString, std::unordered_map<QString, QPushButton *>> button_map_;
@@ -78,11 +114,18 @@ private:
   ButtonInfo getButtonInfoFromNamespace(const QString & ns);
   std::vector<LoggerInfo> getNodeLoggerNameFromButtonName(const QString button_name);
 
+  rclcpp::Client<ConfigLogger>::SharedPtr getClient(const QString & node_name);
+  void dispatchRequests();
+  void finishLoggerRequest(const LoggerRequest & request, const bool success);
+  void onJobFinished(const size_t job_id, const LoggingLevelJob & job);
+
 private Q_SLOTS:
   void onButtonClick(QPushButton * button, const QString & name, const QString & level);
   void updateButtonColors(
     const QString & target_module_name, QPushButton * active_button, const QString & level);
   void changeLogLevel(const QString & container, const QString & level);
+  void onLoggerResponse(const uint64_t request_key, const bool success);
+  void onRequestTimer();
 };
 
 }  // namespace rviz_plugin
@@ -108,13 +108,11 @@ void LoggingLevelConfigureRvizPlugin::onInitialize()
   scrollLayout->addWidget(scrollArea);
   setLayout(scrollLayout);
 
-  // Setup service clients
-  const auto & nodes = getNodeList();
-  for (const QString & node : nodes) {
-    const auto client = raw_node_->create_client<logging_demo::srv::ConfigLogger>(
-      node.toStdString() + "/config_logger");
-    client_map_[node] = client;
-  }
+  // the service clients are created when the nodes are requested first, and the requests in flight
+  // are checked for the timeout by this timer
+  request_timer_ = new QTimer(this);
+  request_timer_->setInterval(100);
+  connect(request_timer_, &QTimer::timeout, this, &LoggingLevelConfigureRvizPlugin::onRequestTimer);
 }
 
 // Calculate the maximum width among all target_module_name.
@@ -151,25 +149,161 @@ void LoggingLevelConfigureRvizPlugin::onButtonClick(
   QPushButton * button, const QString & target_module_name, const QString & level)
 {
   if (button) {
-    const auto callback =
-      [&](rclcpp::Client<logging_demo::srv::ConfigLogger>::SharedFuture future) {
-        std::cerr << "change logging level: "
-                  << std::string(future.get()->success ? "success!" : "failed...") << std::endl;
-      };
-
-    const auto node_logger_vec = getNodeLoggerNameFromButtonName(target_module_name);
-    for (const auto & data : node_logger_vec) {
-      const auto req = std::make_shared<logging_demo::srv::ConfigLogger::Request>();
-
-      req->logger_name = data.logger_name.toStdString();
-      req->level = level.toStdString();
-      std::cerr << "logger level of " << req->logger_name << " is set to " << req->level
-                << std::endl;
-      client_map_[data.node_name]->async_send_request(req, callback);
+    // the button colors are updated when the results of all the loggers are received
+    changeLogLevel(target_module_name, level);
+  }
+}
+
+void LoggingLevelConfigureRvizPlugin::changeLogLevel(
+  const QString & container, const QString & level)
+{
+  const auto node_logger_vec = getNodeLoggerNameFromButtonName(container);
+  if (node_logger_vec.empty()) {
+    return;
+  }
+
+  const size_t job_id = next_job_id_++;
+  jobs_.emplace(job_id, LoggingLevelJob{container, level, node_logger_vec.size(), {}});
+  latest_job_id_map_[container] = job_id;
+  for (const auto & data : node_logger_vec) {
+    request_queue_.push_back(LoggerRequest{job_id, data});
+  }
+
+  dispatchRequests();
+  request_timer_->start();
+}
+
+rclcpp::Client<logging_demo::srv::ConfigLogger>::SharedPtr
+LoggingLevelConfigureRvizPlugin::getClient(const QString & node_name)
+{
+  auto & client = client_map_[node_name];
+  if (!client) {
+    client = raw_node_->create_client<ConfigLogger>(node_name.toStdString() + "/config_logger");
+  }
+  return client;
+}
+
+void LoggingLevelConfigureRvizPlugin::dispatchRequests()
+{
+  // the number of the requests in flight is bounded not to flood the nodes and the executor
+  while (in_flight_requests_.size() < max_in_flight_request_num_ && !request_queue_.empty()) {
+    const auto request = request_queue_.front();
+    request_queue_.pop_front();
+
+    const auto client = getClient(request.logger_info.node_name);
+    if (!client->service_is_ready()) {
+      RCLCPP_WARN(
+        raw_node_->get_logger(), "config_logger service of %s is not ready",
+        request.logger_info.node_name.toStdString().c_str());
+      finishLoggerRequest(request, false);
+      continue;
     }
 
-    updateButtonColors(
-      target_module_name, button, level);  // Modify updateButtonColors to accept QPushButton only.
+    const auto req = std::make_shared<ConfigLogger::Request>();
+    req->logger_name = request.logger_info.logger_name.toStdString();
+    req->level = jobs_.at(request.job_id).level.toStdString();
+    std::cerr << "logger level of " << req->logger_name << " is set to " << req->level
+              << std::endl;
+
+    // the response may be received in another thread, and is handled in the UI thread
+    const uint64_t request_key = next_request_key_++;
+    const auto future_and_request_id = client->async_send_request(
+      req, [this, request_key](rclcpp::Client<ConfigLogger>::SharedFuture future) {
+        const bool success = future.get()->success;
+        QMetaObject::invokeMethod(
+          this, [this, request_key, success]() { onLoggerResponse(request_key, success); },
+          Qt::QueuedConnection);
+      });
+    in_flight_requests_.emplace(
+      request_key, InFlightLoggerRequest{
+                     request, future_and_request_id.request_id, std::chrono::steady_clock::now()});
+  }
+}
+
+void LoggingLevelConfigureRvizPlugin::onLoggerResponse(
+  const uint64_t request_key, const bool success)
+{
+  const auto itr = in_flight_requests_.find(request_key);
+  if (itr == in_flight_requests_.end()) {
+    // the request has already timed out
+    return;
+  }
+  const auto request = itr->second.request;
+  in_flight_requests_.erase(itr);
+
+  std::cerr << "change logging level of " << request.logger_info.logger_name.toStdString() << ": "
+            << std::string(success ? "success!" : "failed...") << std::endl;
+  finishLoggerRequest(request, success);
+  dispatchRequests();
+}
+
+void LoggingLevelConfigureRvizPlugin::onRequestTimer()
+{
+  const auto now = std::chrono::steady_clock::now();
+  for (auto itr = in_flight_requests_.begin(); itr != in_flight_requests_.end();) {
+    if (now - itr->second.send_time < request_timeout_) {
+      ++itr;
+      continue;
+    }
+    const auto request = itr->second.request;
+    getClient(request.logger_info.node_name)->remove_pending_request(itr->second.request_id);
+    itr = in_flight_requests_.erase(itr);
+
+    RCLCPP_WARN(
+      raw_node_->get_logger(), "config_logger service of %s timed out",
+      request.logger_info.node_name.toStdString().c_str());
+    finishLoggerRequest(request, false);
+  }
+  dispatchRequests();
+
+  if (in_flight_requests_.empty() && request_queue_.empty()) {
+    request_timer_->stop();
+  }
+}
+
+void LoggingLevelConfigureRvizPlugin::finishLoggerRequest(
+  const LoggerRequest & request, const bool success)
+{
+  auto & job = jobs_.at(request.job_id);
+  if (!success) {
+    job.failed_loggers.push_back(
+      request.logger_info.node_name + ": " + request.logger_info.logger_name);
+  }
+  if (--job.remaining_num == 0) {
+    const auto finished_job = job;
+    jobs_.erase(request.job_id);
+    onJobFinished(request.job_id, finished_job);
+  }
+}
+
+void LoggingLevelConfigureRvizPlugin::onJobFinished(
+  const size_t job_id, const LoggingLevelJob & job)
+{
+  // the result of the job superseded by a later click of the same button is not shown
+  if (latest_job_id_map_.at(job.button_name) != job_id) {
+    return;
+  }
+
+  auto * button = button_map_[job.button_name][job.level];
+  const auto logger_num = getNodeLoggerNameFromButtonName(job.button_name).size();
+  if (job.failed_loggers.empty()) {
+    button->setToolTip("");
+    updateButtonColors(job.button_name, button, job.level);
+    return;
+  }
+
+  RCLCPP_WARN(
+    raw_node_->get_logger(), "Failed to change the logging level of %zu/%zu loggers of %s",
+    job.failed_loggers.size(), logger_num, job.button_name.toStdString().c_str());
+  QStringList failed_loggers;
+  for (const auto & logger : job.failed_loggers) {
+    failed_loggers.append(logger);
+  }
+  button->setToolTip("Failed to change the logging level of:\n" + failed_loggers.join("\n"));
+
+  // the buttons keep showing the previous level when none of the loggers is changed
+  if (job.failed_loggers.size() < logger_num) {
+    updateButtonColors(job.button_name, button, job.level);
   }
 }
 
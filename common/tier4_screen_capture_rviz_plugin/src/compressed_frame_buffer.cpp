@@ -0,0 +1,126 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compressed_frame_buffer.hpp"
+
+#include "qimage_conversion.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+CompressedFrameBuffer::CompressedFrameBuffer(const int quality) : quality_(quality)
+{
+  compress_thread_ = std::thread([this]() { compress(); });
+}
+
+CompressedFrameBuffer::~CompressedFrameBuffer()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  cv_.notify_one();
+  compress_thread_.join();
+}
+
+void CompressedFrameBuffer::push(const QImage & image)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_frames_.push_back(image);
+    while (pending_frames_.size() > max_pending_frame_num_) {
+      pending_frames_.pop_front();
+    }
+  }
+  cv_.notify_one();
+}
+
+void CompressedFrameBuffer::setMaxFrameNum(const size_t max_frame_num)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_frame_num_ = max_frame_num;
+  while (packets_.size() > max_frame_num_) {
+    byte_size_ -= packets_.front()->size();
+    packets_.pop_front();
+  }
+}
+
+void CompressedFrameBuffer::setQuality(const int quality)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  quality_ = quality;
+}
+
+void CompressedFrameBuffer::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_frames_.clear();
+  packets_.clear();
+  byte_size_ = 0;
+}
+
+std::vector<CompressedFrameBuffer::Packet> CompressedFrameBuffer::getPackets() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return {packets_.begin(), packets_.end()};
+}
+
+size_t CompressedFrameBuffer::getByteSize() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return byte_size_;
+}
+
+cv::Mat CompressedFrameBuffer::decode(const Packet & packet)
+{
+  return cv::imdecode(*packet, cv::IMREAD_COLOR);
+}
+
+void CompressedFrameBuffer::compress()
+{
+  while (true) {
+    QImage image;
+    int quality = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return is_stopping_ || !pending_frames_.empty(); });
+      if (is_stopping_) {
+        return;
+      }
+      image = std::move(pending_frames_.front());
+      pending_frames_.pop_front();
+      quality = quality_;
+    }
+
+    // imencode takes BGR images, and the color conversion is done here instead of in the capture
+    cv::Mat bgr_frame;
+    toBGRMat(image, bgr_frame);
+    auto packet = std::make_shared<std::vector<uchar>>();
+    cv::imencode(".jpg", bgr_frame, *packet, {cv::IMWRITE_JPEG_QUALITY, quality});
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    byte_size_ += packet->size();
+    packets_.push_back(std::move(packet));
+    while (packets_.size() > max_frame_num_) {
+      byte_size_ -= packets_.front()->size();
+      packets_.pop_front();
+    }
+  }
+}
+
+}  // namespace rviz_plugins
@@ -0,0 +1,86 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef COMPRESSED_FRAME_BUFFER_HPP_
+#define COMPRESSED_FRAME_BUFFER_HPP_
+
+#include <QImage>
+#include <opencv2/opencv.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief ring buffer of the last frames, which are kept as JPEG images compressed in a background
+ * thread, so that minutes of frames fit in memory
+ */
+class CompressedFrameBuffer
+{
+public:
+  using Packet = std::shared_ptr<const std::vector<uchar>>;
+
+  /**
+   * @param [in] quality JPEG quality of the frames from 0 to 100
+   */
+  explicit CompressedFrameBuffer(const int quality);
+  ~CompressedFrameBuffer();
+
+  /**
+   * @brief queue a captured frame to compress. The image is implicitly shared, so it is not copied
+   */
+  void push(const QImage & image);
+
+  void setMaxFrameNum(const size_t max_frame_num);
+  void setQuality(const int quality);
+  void clear();
+
+  /**
+   * @brief get the compressed frames from the oldest, which share the data with the buffer
+   */
+  std::vector<Packet> getPackets() const;
+
+  size_t getByteSize() const;
+
+  /**
+   * @brief decode a frame of getPackets to a BGR image
+   */
+  static cv::Mat decode(const Packet & packet);
+
+private:
+  void compress();
+
+  // frames waiting for the compression, beyond which the oldest ones are dropped
+  static constexpr size_t max_pending_frame_num_ = 8;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread compress_thread_;
+  std::deque<QImage> pending_frames_;
+  std::deque<Packet> packets_;
+  size_t max_frame_num_{0};
+  size_t byte_size_{0};
+  int quality_;
+  bool is_stopping_{false};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // COMPRESSED_FRAME_BUFFER_HPP_
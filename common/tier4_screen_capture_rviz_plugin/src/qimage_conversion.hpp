@@ -0,0 +1,77 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QIMAGE_CONVERSION_HPP_
+#define QIMAGE_CONVERSION_HPP_
+
+#include <QImage>
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief convert a captured frame to a BGR image. The frames of grabWindow are 32 bit BGRA in
+ * memory, which are converted without the RGB888 conversion of Qt
+ */
+inline void toBGRMat(const QImage & image, cv::Mat & bgr_image)
+{
+  const auto size = cv::Size(image.width(), image.height());
+  const auto step = static_cast<size_t>(image.bytesPerLine());
+  auto * bits = const_cast<uchar *>(image.constBits());
+  switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+      cv::cvtColor(cv::Mat(size, CV_8UC4, bits, step), bgr_image, cv::COLOR_BGRA2BGR);
+      return;
+    case QImage::Format_RGB888:
+      cv::cvtColor(cv::Mat(size, CV_8UC3, bits, step), bgr_image, cv::COLOR_RGB2BGR);
+      return;
+    default: {
+      const auto rgb_image = image.convertToFormat(QImage::Format_RGB888);
+      toBGRMat(rgb_image, bgr_image);
+    }
+  }
+}
+
+/**
+ * @brief downscale a captured frame by the given scale, with a size of even numbers for the video
+ * encoders. The frame is returned as it is if the scale is not less than 1
+ */
+inline QImage downscale(const QImage & image, const double scale)
+{
+  if (scale >= 1.0 || image.isNull()) {
+    return image;
+  }
+  const int width = std::max(2, static_cast<int>(image.width() * scale) / 2 * 2);
+  const int height = std::max(2, static_cast<int>(image.height() * scale) / 2 * 2);
+  const auto source = image.depth() == 32 ? image : image.convertToFormat(QImage::Format_RGB32);
+
+  // cv::resize of the area interpolation is faster and smoother than the scaling of Qt
+  QImage scaled_image(width, height, QImage::Format_RGB32);
+  const cv::Mat src(
+    source.height(), source.width(), CV_8UC4, const_cast<uchar *>(source.constBits()),
+    static_cast<size_t>(source.bytesPerLine()));
+  cv::Mat dst(
+    height, width, CV_8UC4, scaled_image.bits(), static_cast<size_t>(scaled_image.bytesPerLine()));
+  cv::resize(src, dst, dst.size(), 0.0, 0.0, cv::INTER_AREA);
+  return scaled_image;
+}
+
+}  // namespace rviz_plugins
+
+#endif  // QIMAGE_CONVERSION_HPP_
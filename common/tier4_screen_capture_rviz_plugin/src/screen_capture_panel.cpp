@@ -14,6 +14,8 @@
 
 #include "screen_capture_panel.hpp"
 
+#include "qimage_conversion.hpp"
+
 #include <rclcpp/rclcpp.hpp>
 
 #include <ctime>
@@ -21,6 +23,7 @@
 #include <filesystem>
 #include <iostream>
 #include <string>
+#include <system_error>
 
 namespace rviz_plugins
 {
@@ -62,7 +65,7 @@ AutowareScreenCapturePanel::AutowareScreenCapturePanel(QWidget * parent)
     capture_to_mp4_button_ptr_ = new QPushButton("Capture Screen");
     connect(capture_to_mp4_button_ptr_, SIGNAL(clicked()), this, SLOT(on_click_video_capture()));
     rate_ = new QSpinBox();
-    rate_->setRange(1, 10);
+    rate_->setRange(1, 30);
     rate_->setValue(10);
     rate_->setSingleStep(1);
     connect(rate_, SIGNAL(valueChanged(const int)), this, SLOT(on_rate_change(const int)));
@@ -70,6 +73,26 @@ AutowareScreenCapturePanel::AutowareScreenCapturePanel(QWidget * parent)
     video_cap_layout->addWidget(capture_to_mp4_button_ptr_);
     video_cap_layout->addWidget(rate_);
     video_cap_layout->addWidget(new QLabel(" [Hz]"));
+    streaming_ = new QCheckBox("Stream to file");
+    streaming_->setChecked(true);
+    video_cap_layout->addWidget(streaming_);
+  }
+
+  // capture region setting
+  auto * capture_layout = new QHBoxLayout;
+  {
+    capture_layout->addWidget(new QLabel("Capture: "));
+    capture_source_ = new QComboBox();
+    capture_source_->addItems({"Window", "Render Panel"});
+    capture_layout->addWidget(capture_source_);
+
+    capture_layout->addWidget(new QLabel(" Scale: "));
+    capture_scale_ = new QSpinBox();
+    capture_scale_->setRange(10, 100);
+    capture_scale_->setValue(100);
+    capture_scale_->setSingleStep(10);
+    capture_layout->addWidget(capture_scale_);
+    capture_layout->addWidget(new QLabel(" [%]"));
   }
 
   // buffer size setting
@@ -78,7 +101,7 @@ AutowareScreenCapturePanel::AutowareScreenCapturePanel(QWidget * parent)
     buffer_size_layout->addWidget(new QLabel("Buffer Size: "));
 
     buffer_size_ = new QSpinBox();
-    buffer_size_->setRange(1, 300);  // Maximum 300 seconds buffer
+    buffer_size_->setRange(1, 600);  // Maximum 600 seconds buffer
     buffer_size_->setValue(10);      // Default 10 seconds buffer
     buffer_size_->setSingleStep(1);
     buffer_size_layout->addWidget(buffer_size_);
@@ -92,11 +115,13 @@ AutowareScreenCapturePanel::AutowareScreenCapturePanel(QWidget * parent)
   {
     v_layout->addLayout(cap_layout);
     v_layout->addLayout(video_cap_layout);
+    v_layout->addLayout(capture_layout);
     v_layout->addLayout(buffer_size_layout);
     setLayout(v_layout);
   }
 
   // Initialize buffer sizes
+  buffer_ = std::make_unique<CompressedFrameBuffer>(buffer_jpeg_quality_);
   update_buffer_size();
 }
 
@@ -135,6 +160,7 @@ void AutowareScreenCapturePanel::update_buffer_size()
 {
   // Calculate buffer sizes in frames
   buffer_size_frames_ = buffer_size_->value() * rate_->value();
+  buffer_->setMaxFrameNum(buffer_size_frames_);
 }
 
 void AutowareScreenCapturePanel::on_timer()
@@ -143,32 +169,54 @@ void AutowareScreenCapturePanel::on_timer()
 
   if (!main_window_) return;
 
-  // this is deprecated but only way to capture nicely
+  const auto rect = capture_rect();
+  if (rect.isEmpty()) return;
+
+  // this is deprecated but only way to capture nicely. Only the region is read from the window
   QScreen * screen = QGuiApplication::primaryScreen();
-  QPixmap original_pixmap = screen->grabWindow(main_window_->winId());
-  const auto q_image =
-    original_pixmap.toImage().convertToFormat(QImage::Format_RGB888).rgbSwapped();
-  const int h = q_image.height();
-  const int w = q_image.width();
-  cv::Size size = cv::Size(w, h);
-  cv::Mat image(
-    size, CV_8UC3, const_cast<uchar *>(q_image.bits()),
-    static_cast<size_t>(q_image.bytesPerLine()));
-
-  size_ = size;
+  QPixmap original_pixmap =
+    screen->grabWindow(main_window_->winId(), rect.x(), rect.y(), rect.width(), rect.height());
+  // the frame is downscaled once here, so that the smaller frame is stored and encoded. It is
+  // implicitly shared with the workers, which convert it in their threads
+  const auto image = downscale(original_pixmap.toImage(), capture_scale_->value() / 100.0);
+
+  if (is_recording_ && is_streaming_) {
+    if (!stream_writer_->isOpened()) {
+      const auto size = cv::Size(image.width(), image.height());
+      if (!stream_writer_->open(stream_file_path_, rate_->value(), size, encoder_pipeline_)) {
+        RCLCPP_ERROR_STREAM(raw_node_->get_logger(), "FAILED TO OPEN " << stream_file_path_);
+        is_recording_ = false;
+        return;
+      }
+    }
+    stream_writer_->push(image);
+  }
 
   if (is_buffering_) {
-    buffer_.push_back(image.clone());
-    while (buffer_.size() > buffer_size_frames_) {
-      buffer_.pop_front();
-    }
+    buffer_->push(image);
   }
 
-  if (is_recording_) {
-    movie_.push_back(image.clone());
+  if (is_recording_ && !is_streaming_) {
+    if (movie_.empty()) {
+      size_ = cv::Size(image.width(), image.height());
+    }
+    movie_.push_back(image);
   }
+}
 
-  cv::waitKey(0);
+QRect AutowareScreenCapturePanel::capture_rect() const
+{
+  QRect source_rect = main_window_->rect();
+  if (capture_source_->currentIndex() == 1) {
+    const auto * render_panel = getDisplayContext()->getViewManager()->getRenderPanel();
+    if (render_panel) {
+      source_rect = QRect(render_panel->mapTo(main_window_, QPoint(0, 0)), render_panel->size());
+    }
+  }
+  if (capture_region_.isEmpty()) {
+    return source_rect;
+  }
+  return capture_region_.translated(source_rect.topLeft()).intersected(source_rect);
 }
 
 void AutowareScreenCapturePanel::callback(
@@ -261,6 +309,13 @@ bool AutowareScreenCapturePanel::start_recording()
   capture_to_mp4_button_ptr_->setText("capturing rviz screen");
   capture_to_mp4_button_ptr_->setStyleSheet("background-color: #FF0000;");
 
+  // the writer is opened with the size of the first frame
+  is_streaming_ = streaming_->isChecked();
+  if (is_streaming_) {
+    stream_file_path_ = movie_path("recording");
+    stream_writer_ = std::make_unique<VideoStreamWriter>(3 * rate_->value());
+  }
+
   is_recording_ = true;
 
   return true;
@@ -284,7 +339,7 @@ bool AutowareScreenCapturePanel::start_buffering()
 
   RCLCPP_INFO_STREAM(raw_node_->get_logger(), "START BUFFERING.");
 
-  buffer_.clear();
+  buffer_->clear();
   is_buffering_ = true;
 
   return true;
@@ -294,7 +349,7 @@ bool AutowareScreenCapturePanel::stop_buffering()
 {
   if (!is_buffering_) return false;
 
-  buffer_.clear();
+  buffer_->clear();
   is_buffering_ = false;
 
   return true;
@@ -306,7 +361,19 @@ bool AutowareScreenCapturePanel::save_movie(const std::string & file_name)
 
   RCLCPP_INFO_STREAM(raw_node_->get_logger(), "SAVE RECORDED MOVIE.");
 
-  save(movie_, file_name);
+  if (is_streaming_) {
+    stream_writer_->close();
+    if (stream_writer_->getDroppedFrameNum() > 0) {
+      RCLCPP_WARN_STREAM(
+        raw_node_->get_logger(),
+        "DROPPED " << stream_writer_->getDroppedFrameNum() << " FRAMES, SET LOWER RATE.");
+    }
+    stream_writer_.reset();
+    std::error_code ec;
+    std::filesystem::rename(stream_file_path_, movie_path(file_name), ec);
+  } else {
+    save(movie_, file_name);
+  }
 
   capture_to_mp4_button_ptr_->setText("waiting for capture");
   capture_to_mp4_button_ptr_->setStyleSheet("background-color: #00FF00;");
@@ -320,48 +387,127 @@ bool AutowareScreenCapturePanel::save_movie(const std::string & file_name)
 
 bool AutowareScreenCapturePanel::save_buffer(const std::string & file_name)
 {
-  if (buffer_.empty()) return false;
-
   if (!is_buffering_) return false;
 
-  RCLCPP_INFO_STREAM(raw_node_->get_logger(), "SAVE BUFFERED MOVIE.");
+  auto packets = buffer_->getPackets();
+  if (packets.empty()) return false;
+
+  RCLCPP_INFO_STREAM(
+    raw_node_->get_logger(), "SAVE BUFFERED MOVIE OF " << packets.size() << " FRAMES ("
+                                                       << buffer_->getByteSize() / 1024 / 1024
+                                                       << " MB).");
 
-  save(buffer_, file_name + "_buffered");
+  // the frames share the data with the buffer, and are decoded and encoded in the background
+  if (save_buffer_thread_.joinable()) {
+    save_buffer_thread_.join();
+  }
+  save_buffer_thread_ = std::thread(
+    [packets = std::move(packets), path = movie_path(file_name + "_buffered"),
+     fps = rate_->value()]() {
+      cv::VideoWriter writer;
+      for (const auto & packet : packets) {
+        const auto frame = CompressedFrameBuffer::decode(packet);
+        if (frame.empty()) {
+          continue;
+        }
+        if (!writer.isOpened()) {
+          writer.open(path, cv::VideoWriter::fourcc('h', '2', '6', '4'), fps, frame.size());
+        }
+        writer.write(frame);
+      }
+      writer.release();
+    });
 
   return true;
 }
 
 void AutowareScreenCapturePanel::save(
-  const std::deque<cv::Mat> & images, const std::string & file_name)
+  const std::deque<QImage> & images, const std::string & file_name)
 {
   int fourcc = cv::VideoWriter::fourcc('h', '2', '6', '4');  // mp4
 
   cv::VideoWriter writer;
 
-  writer.open(
-    "capture/" + file_name + ros_time_label_->text().toStdString() + ".mp4", fourcc, rate_->value(),
-    size_);
+  writer.open(movie_path(file_name), fourcc, rate_->value(), size_);
 
-  for (const auto & frame : images) {
-    cv::Mat resized_frame;
-    cv::resize(frame, resized_frame, size_);
-    writer.write(resized_frame);
+  cv::Mat frame;
+  cv::Mat resized_frame;
+  for (const auto & image : images) {
+    toBGRMat(image, frame);
+    if (frame.size() == size_) {
+      writer.write(frame);
+    } else {
+      cv::resize(frame, resized_frame, size_);
+      writer.write(resized_frame);
+    }
   }
 
   writer.release();
 }
 
+std::string AutowareScreenCapturePanel::movie_path(const std::string & file_name) const
+{
+  return "capture/" + file_name + ros_time_label_->text().toStdString() + ".mp4";
+}
+
 void AutowareScreenCapturePanel::save(rviz_common::Config config) const
 {
   Panel::save(config);
+  config.mapSetValue("Streaming", streaming_->isChecked());
+  config.mapSetValue("EncoderPipeline", QString::fromStdString(encoder_pipeline_));
+  config.mapSetValue("BufferJpegQuality", buffer_jpeg_quality_);
+  config.mapSetValue("CaptureSource", capture_source_->currentText());
+  config.mapSetValue("CaptureScale", capture_scale_->value());
+  if (!capture_region_.isEmpty()) {
+    config.mapSetValue(
+      "CaptureRegion", QString("%1,%2,%3,%4")
+                         .arg(capture_region_.x())
+                         .arg(capture_region_.y())
+                         .arg(capture_region_.width())
+                         .arg(capture_region_.height()));
+  }
 }
 
 void AutowareScreenCapturePanel::load(const rviz_common::Config & config)
 {
   Panel::load(config);
+  bool streaming = true;
+  if (config.mapGetBool("Streaming", &streaming)) {
+    streaming_->setChecked(streaming);
+  }
+  QString pipeline;
+  if (config.mapGetString("EncoderPipeline", &pipeline)) {
+    encoder_pipeline_ = pipeline.toStdString();
+  }
+  int quality = 75;
+  if (config.mapGetInt("BufferJpegQuality", &quality)) {
+    buffer_->setQuality(quality);
+    buffer_jpeg_quality_ = quality;
+  }
+  QString source;
+  if (config.mapGetString("CaptureSource", &source)) {
+    capture_source_->setCurrentText(source);
+  }
+  int scale = 100;
+  if (config.mapGetInt("CaptureScale", &scale)) {
+    capture_scale_->setValue(scale);
+  }
+  QString region;
+  if (config.mapGetString("CaptureRegion", &region)) {
+    const auto values = region.split(',');
+    if (values.size() == 4) {
+      capture_region_ =
+        QRect(values[0].toInt(), values[1].toInt(), values[2].toInt(), values[3].toInt());
+    }
+  }
 }
 
-AutowareScreenCapturePanel::~AutowareScreenCapturePanel() = default;
+AutowareScreenCapturePanel::~AutowareScreenCapturePanel()
+{
+  if (save_buffer_thread_.joinable()) {
+    save_buffer_thread_.join();
+  }
+}
 
 }  // namespace rviz_plugins
 
@@ -17,6 +17,8 @@
 
 // Qt
 #include <QApplication>
+#include <QCheckBox>
+#include <QComboBox>
 #include <QDesktopWidget>
 #include <QDir>
 #include <QFileDialog>
@@ -25,6 +27,7 @@
 #include <QLineEdit>
 #include <QMainWindow>
 #include <QPushButton>
+#include <QRect>
 #include <QScreen>
 #include <QSpinBox>
 #include <QTimer>
@@ -39,6 +42,9 @@
 #include <rviz_rendering/render_window.hpp>
 
 // ros
+#include "compressed_frame_buffer.hpp"
+#include "video_stream_writer.hpp"
+
 #include <tier4_screen_capture_rviz_plugin/srv/capture.hpp>
 
 #include <std_srvs/srv/trigger.hpp>
@@ -46,6 +52,7 @@
 #include <deque>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -98,23 +105,47 @@ private:
 
   void on_timer();
 
-  void save(const std::deque<cv::Mat> & images, const std::string & file_name);
+  void save(const std::deque<QImage> & images, const std::string & file_name);
+
+  std::string movie_path(const std::string & file_name) const;
 
   void update_buffer_size();
 
+  QRect capture_rect() const;
+
   QLabel * ros_time_label_;
   QPushButton * screen_capture_button_ptr_;
   QPushButton * capture_to_mp4_button_ptr_;
   QLineEdit * file_prefix_;
   QSpinBox * rate_;
   QSpinBox * buffer_size_;
+  QCheckBox * streaming_;
+  QComboBox * capture_source_;
+  QSpinBox * capture_scale_;
   QMainWindow * main_window_{nullptr};
 
   cv::Size size_;
 
-  std::deque<cv::Mat> movie_;
-
-  std::deque<cv::Mat> buffer_;
+  // Region of the frames in the window or the render panel of capture_source_, which is the whole
+  // of it if it is empty. Only the region is grabbed, and it is downscaled by capture_scale_ before
+  // the frame is stored or queued. The region is set by CaptureRegion "x,y,width,height" in the
+  // config
+  QRect capture_region_;
+
+  // Frames of the recording when it is not streamed, which are converted when they are saved
+  std::deque<QImage> movie_;
+
+  // In the streaming mode, the recorded frames are encoded to stream_file_path_ while recording,
+  // and the file is renamed when it is saved. The pipeline is set by EncoderPipeline in the config
+  std::unique_ptr<VideoStreamWriter> stream_writer_;
+  std::string stream_file_path_;
+  std::string encoder_pipeline_;
+  bool is_streaming_{false};
+
+  // Frames of the last buffer_size_ seconds, which are compressed to JPEG images
+  std::unique_ptr<CompressedFrameBuffer> buffer_;
+  int buffer_jpeg_quality_{75};
+  std::thread save_buffer_thread_;
 
   // Size of the frame buffer (number of frames to keep in memory)
   // At 10 Hz capture rate, 100 frames correspond to approximately 10 seconds of video
@@ -0,0 +1,110 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "video_stream_writer.hpp"
+
+#include "qimage_conversion.hpp"
+
+#include <string>
+#include <utility>
+
+namespace rviz_plugins
+{
+
+bool VideoStreamWriter::open(
+  const std::string & path, const double fps, const cv::Size & size, const std::string & pipeline)
+{
+  close();
+
+  if (pipeline.empty()) {
+    const int fourcc = cv::VideoWriter::fourcc('h', '2', '6', '4');  // mp4
+    writer_.open(path, fourcc, fps, size);
+  } else {
+    std::string gst_pipeline = pipeline;
+    const std::string key = "{file}";
+    for (auto pos = gst_pipeline.find(key); pos != std::string::npos;
+         pos = gst_pipeline.find(key)) {
+      gst_pipeline.replace(pos, key.size(), path);
+    }
+    writer_.open(gst_pipeline, cv::CAP_GSTREAMER, 0, fps, size);
+  }
+
+  if (!writer_.isOpened()) {
+    return false;
+  }
+
+  size_ = size;
+  is_closing_ = false;
+  dropped_frame_num_ = 0;
+  encoder_thread_ = std::thread([this]() { encode(); });
+  return true;
+}
+
+bool VideoStreamWriter::push(const QImage & image)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!isOpened() || queue_.size() >= queue_size_) {
+      ++dropped_frame_num_;
+      return false;
+    }
+    queue_.push_back(image);
+  }
+  cv_.notify_one();
+  return true;
+}
+
+void VideoStreamWriter::close()
+{
+  if (!isOpened()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_closing_ = true;
+  }
+  cv_.notify_one();
+  encoder_thread_.join();
+  writer_.release();
+}
+
+void VideoStreamWriter::encode()
+{
+  cv::Mat bgr_frame;
+  cv::Mat resized_frame;
+  while (true) {
+    QImage image;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return is_closing_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      image = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    // the color conversion is done here instead of in the capture
+    toBGRMat(image, bgr_frame);
+    if (bgr_frame.size() == size_) {
+      writer_.write(bgr_frame);
+    } else {
+      cv::resize(bgr_frame, resized_frame, size_);
+      writer_.write(resized_frame);
+    }
+  }
+}
+
+}  // namespace rviz_plugins
@@ -0,0 +1,84 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VIDEO_STREAM_WRITER_HPP_
+#define VIDEO_STREAM_WRITER_HPP_
+
+#include <QImage>
+#include <opencv2/opencv.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief encode the captured frames to a file in its own thread, so that only a few frames are
+ * kept in memory while recording
+ */
+class VideoStreamWriter
+{
+public:
+  /**
+   * @param [in] queue_size number of frames waiting for the encoder, beyond which the new frames
+   * are dropped instead of blocking the capture
+   */
+  explicit VideoStreamWriter(const size_t queue_size) : queue_size_(queue_size) {}
+  ~VideoStreamWriter() { close(); }
+
+  /**
+   * @brief open the file and start the encoder thread
+   * @param [in] pipeline GStreamer pipeline starting with appsrc, where "{file}" is replaced by
+   * the path, e.g. to use a hardware encoder. The h264 encoder of OpenCV is used if it is empty
+   * @return false if the encoder cannot be opened
+   */
+  bool open(
+    const std::string & path, const double fps, const cv::Size & size,
+    const std::string & pipeline = "");
+
+  /**
+   * @brief queue a captured frame to encode. The image is implicitly shared, so it is not copied
+   * @return false if the queue is full and the frame is dropped
+   */
+  bool push(const QImage & image);
+
+  /**
+   * @brief encode the frames in the queue, and close the file
+   */
+  void close();
+
+  bool isOpened() const { return encoder_thread_.joinable(); }
+  size_t getDroppedFrameNum() const { return dropped_frame_num_; }
+
+private:
+  void encode();
+
+  size_t queue_size_;
+  cv::VideoWriter writer_;
+  cv::Size size_;
+  std::thread encoder_thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<QImage> queue_;
+  bool is_closing_{false};
+  size_t dropped_frame_num_{0};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // VIDEO_STREAM_WRITER_HPP_
@@ -24,6 +24,7 @@
 #include <rviz_common/display_context.hpp>
 
 #include <chrono>
+#include <cmath>
 #include <string>
 
 namespace rviz_plugins
@@ -54,6 +55,11 @@ SimulatedClockPanel::SimulatedClockPanel(QWidget * parent) : rviz_common::Panel(
   step_unit_combo_ = new QComboBox();
   step_unit_combo_->addItems({"s", "ms", "µs", "ns"});
 
+  lock_step_check_ = new QCheckBox("Lock-step");
+  lock_step_check_->setToolTip(
+    "Advance the clock by one period of the rate at each message on /clock_trigger, instead of "
+    "in real time.");
+
   auto * layout = new QGridLayout(this);
   auto * step_layout = new QHBoxLayout();
   auto * clock_layout = new QHBoxLayout();
@@ -71,11 +77,29 @@ SimulatedClockPanel::SimulatedClockPanel(QWidget * parent) : rviz_common::Panel(
   step_layout->addWidget(step_unit_combo_);
   layout->addWidget(clock_box, 0, 1, 1, 2);
   layout->addWidget(step_box, 1, 1, 1, 2);
+  layout->addWidget(lock_step_check_, 2, 0);
   layout->setContentsMargins(0, 0, 20, 0);
-  prev_published_time_ = std::chrono::system_clock::now();
 
   connect(publishing_rate_input_, SIGNAL(valueChanged(int)), this, SLOT(onRateChanged(int)));
   connect(step_button_, SIGNAL(clicked()), this, SLOT(onStepClicked()));
+  connect(pause_button_, SIGNAL(toggled(bool)), this, SLOT(onPauseToggled(bool)));
+  connect(clock_speed_input_, SIGNAL(valueChanged(double)), this, SLOT(onSpeedChanged(double)));
+  connect(lock_step_check_, SIGNAL(toggled(bool)), this, SLOT(onLockStepToggled(bool)));
+
+  period_ = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / publishing_rate_input_->value()));
+  speed_ = clock_speed_input_->value();
+}
+
+SimulatedClockPanel::~SimulatedClockPanel()
+{
+  if (clock_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(clock_mutex_);
+      is_stopping_ = true;
+    }
+    clock_cv_.notify_one();
+    clock_thread_.join();
+  }
 }
 
 void SimulatedClockPanel::onInitialize()
@@ -83,14 +107,61 @@ void SimulatedClockPanel::onInitialize()
   raw_node_ = this->getDisplayContext()->getRosNodeAbstraction().lock()->get_raw_node();
 
   clock_pub_ = raw_node_->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::QoS(1));
-  createWallTimer();
+  trigger_sub_ = raw_node_->create_subscription<std_msgs::msg::Empty>(
+    "/clock_trigger", rclcpp::QoS(10),
+    [this](const std_msgs::msg::Empty::ConstSharedPtr msg) { onTrigger(msg); });
+
+  // the clock is published in its own thread so that it does not depend on the load of rviz
+  anchor_time_ = std::chrono::steady_clock::now();
+  clock_thread_ = std::thread([this]() { runClock(); });
 }
 
 void SimulatedClockPanel::onRateChanged(int new_rate)
 {
-  (void)new_rate;
-  pub_timer_->cancel();
-  createWallTimer();
+  {
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+    period_ = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / new_rate));
+    is_rate_changed_ = true;
+  }
+  clock_cv_.notify_one();
+}
+
+void SimulatedClockPanel::onPauseToggled(bool is_paused)
+{
+  std::lock_guard<std::mutex> lock(clock_mutex_);
+  resetAnchor();
+  is_paused_ = is_paused;
+}
+
+void SimulatedClockPanel::onSpeedChanged(double speed)
+{
+  std::lock_guard<std::mutex> lock(clock_mutex_);
+  resetAnchor();
+  speed_ = speed;
+}
+
+void SimulatedClockPanel::onLockStepToggled(bool is_lock_step)
+{
+  {
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+    resetAnchor();
+    is_lock_step_ = is_lock_step;
+    pending_trigger_num_ = 0;
+  }
+  clock_cv_.notify_one();
+}
+
+void SimulatedClockPanel::onTrigger(const std_msgs::msg::Empty::ConstSharedPtr msg)
+{
+  (void)msg;
+  {
+    std::lock_guard<std::mutex> lock(clock_mutex_);
+    if (!is_lock_step_) {
+      return;
+    }
+    ++pending_trigger_num_;
+  }
+  clock_cv_.notify_one();
 }
 
 void SimulatedClockPanel::onStepClicked()
@@ -110,41 +181,86 @@ void SimulatedClockPanel::onStepClicked()
   } else if (unit == "ns") {
     step_duration_ns += duration_cast<nanoseconds>(nanoseconds(step_time));
   }
-  addTimeToClock(step_duration_ns);
+
+  std::lock_guard<std::mutex> lock(clock_mutex_);
+  resetAnchor();
+  is_paused_ = true;
+  sim_time_ns_ += step_duration_ns.count();
 }
 
-void SimulatedClockPanel::createWallTimer()
+void SimulatedClockPanel::runClock()
 {
-  // convert rate from Hz to milliseconds
-  const auto period =
-    std::chrono::milliseconds(static_cast<int64_t>(1e3 / publishing_rate_input_->value()));
-  pub_timer_ = raw_node_->create_wall_timer(period, [&]() { onTimer(); });
+  using std::chrono::steady_clock;
+
+  std::unique_lock<std::mutex> lock(clock_mutex_);
+  auto deadline = steady_clock::now();
+  while (true) {
+    if (is_lock_step_) {
+      clock_cv_.wait(
+        lock, [this]() { return is_stopping_ || !is_lock_step_ || 0 < pending_trigger_num_; });
+      if (is_stopping_) {
+        return;
+      }
+      if (!is_lock_step_) {
+        deadline = steady_clock::now();
+        continue;
+      }
+      // each trigger advances the clock by one period of the rate, regardless of the wall time
+      if (!is_paused_) {
+        sim_time_ns_ += pending_trigger_num_ * std::llround(period_.count() * speed_);
+      }
+      pending_trigger_num_ = 0;
+    } else {
+      const bool is_woken_up = clock_cv_.wait_until(lock, deadline, [this]() {
+        return is_stopping_ || is_lock_step_ || is_rate_changed_;
+      });
+      if (is_stopping_) {
+        return;
+      }
+      if (is_woken_up) {
+        if (is_rate_changed_) {
+          is_rate_changed_ = false;
+          deadline = steady_clock::now() + period_;
+        }
+        continue;
+      }
+
+      // the deadlines are absolute not to accumulate the delays of the wake-ups. The time of the
+      // clock does not depend on the ticks, so the missed ticks are caught up at once by skipping
+      // to the next deadline in the future
+      const auto now = steady_clock::now();
+      deadline += period_;
+      if (deadline <= now) {
+        deadline += ((now - deadline) / period_ + 1) * period_;
+      }
+    }
+
+    rosgraph_msgs::msg::Clock clock_msg;
+    const int64_t sim_time_ns = getSimTime(steady_clock::now());
+    clock_msg.clock.sec = static_cast<int32_t>(sim_time_ns / 1000000000);
+    clock_msg.clock.nanosec = static_cast<uint32_t>(sim_time_ns % 1000000000);
+
+    lock.unlock();
+    clock_pub_->publish(clock_msg);
+    lock.lock();
+  }
 }
 
-void SimulatedClockPanel::onTimer()
+int64_t SimulatedClockPanel::getSimTime(const std::chrono::steady_clock::time_point & now) const
 {
-  if (!pause_button_->isChecked()) {
-    const auto duration_since_prev_clock = std::chrono::system_clock::now() - prev_published_time_;
-    const auto speed_adjusted_duration = duration_since_prev_clock * clock_speed_input_->value();
-    addTimeToClock(std::chrono::duration_cast<std::chrono::nanoseconds>(speed_adjusted_duration));
+  if (is_paused_ || is_lock_step_) {
+    return sim_time_ns_;
   }
-  clock_pub_->publish(clock_msg_);
-  prev_published_time_ = std::chrono::system_clock::now();
+  const auto elapsed_time =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(now - anchor_time_);
+  return sim_time_ns_ + std::llround(elapsed_time.count() * speed_);
 }
 
-void SimulatedClockPanel::addTimeToClock(std::chrono::nanoseconds time_to_add_ns)
+void SimulatedClockPanel::resetAnchor()
 {
-  constexpr auto one_sec = std::chrono::seconds(1);
-  constexpr auto one_sec_ns = std::chrono::nanoseconds(one_sec);
-  while (time_to_add_ns >= one_sec) {
-    time_to_add_ns -= one_sec;
-    clock_msg_.clock.sec += 1;
-  }
-  clock_msg_.clock.nanosec += time_to_add_ns.count();
-  if (clock_msg_.clock.nanosec >= one_sec_ns.count()) {
-    clock_msg_.clock.sec += 1;
-    clock_msg_.clock.nanosec = clock_msg_.clock.nanosec - one_sec_ns.count();
-  }
+  const auto now = std::chrono::steady_clock::now();
+  sim_time_ns_ = getSimTime(now);
+  anchor_time_ = now;
 }
 
 }  // namespace rviz_plugins
@@ -17,6 +17,7 @@
 #ifndef SIMULATED_CLOCK_PANEL_HPP_
 #define SIMULATED_CLOCK_PANEL_HPP_
 
+#include <qt5/QtWidgets/QCheckBox>
 #include <qt5/QtWidgets/QComboBox>
 #include <qt5/QtWidgets/QDoubleSpinBox>
 #include <qt5/QtWidgets/QPushButton>
@@ -26,8 +27,14 @@
 #include <rviz_common/panel.hpp>
 
 #include <rosgraph_msgs/msg/clock.hpp>
+#include <std_msgs/msg/empty.hpp>
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace rviz_plugins
 {
@@ -37,6 +44,7 @@ class SimulatedClockPanel : public rviz_common::Panel
 
 public:
   explicit SimulatedClockPanel(QWidget * parent = nullptr);
+  ~SimulatedClockPanel() override;
   void onInitialize() override;
 
 protected Q_SLOTS:
@@ -44,19 +52,31 @@ protected Q_SLOTS:
   void onRateChanged(int new_rate);
   /// @brief callback for when the step button is clicked
   void onStepClicked();
+  /// @brief callback for when the pause button is toggled
+  void onPauseToggled(bool is_paused);
+  /// @brief callback for when the clock speed is changed
+  void onSpeedChanged(double speed);
+  /// @brief callback for when the lock-step mode is toggled
+  void onLockStepToggled(bool is_lock_step);
 
 protected:
-  /// @brief creates ROS wall timer to periodically call onTimer()
-  void createWallTimer();
-  void onTimer();
-  /// @brief add some time to the clock
-  /// @input ns time to add in nanoseconds
-  void addTimeToClock(std::chrono::nanoseconds ns);
+  /// @brief publish the clock at the absolute deadlines of the publishing rate, or at each trigger
+  /// in the lock-step mode
+  void runClock();
+  /// @brief callback for the trigger to advance the clock in the lock-step mode
+  void onTrigger(const std_msgs::msg::Empty::ConstSharedPtr msg);
+  /// @brief get the simulated time in nanoseconds at the given wall time
+  /// @details clock_mutex_ must be locked
+  int64_t getSimTime(const std::chrono::steady_clock::time_point & now) const;
+  /// @brief restart the progress of the simulated time from the current one, before its speed is
+  /// changed
+  /// @details clock_mutex_ must be locked
+  void resetAnchor();
 
   // ROS
   rclcpp::Node::SharedPtr raw_node_;
   rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr clock_pub_;
-  rclcpp::TimerBase::SharedPtr pub_timer_;
+  rclcpp::Subscription<std_msgs::msg::Empty>::SharedPtr trigger_sub_;
 
   // GUI
   QPushButton * pause_button_;
@@ -65,10 +85,22 @@ protected:
   QDoubleSpinBox * clock_speed_input_;
   QSpinBox * step_time_input_;
   QComboBox * step_unit_combo_;
+  QCheckBox * lock_step_check_;
 
-  // Clocks
-  std::chrono::time_point<std::chrono::system_clock> prev_published_time_;
-  rosgraph_msgs::msg::Clock clock_msg_;
+  // Clocks, which are shared with the clock thread
+  std::thread clock_thread_;
+  std::mutex clock_mutex_;
+  std::condition_variable clock_cv_;
+  bool is_stopping_{false};
+  bool is_paused_{false};
+  bool is_lock_step_{false};
+  bool is_rate_changed_{false};
+  double speed_{1.0};
+  std::chrono::nanoseconds period_{std::chrono::milliseconds(10)};
+  size_t pending_trigger_num_{0};
+  // the simulated time is sim_time_ns_ + speed_ * (now - anchor_time_) while running in real time
+  int64_t sim_time_ns_{0};
+  std::chrono::steady_clock::time_point anchor_time_;
 };
 
 }  // namespace rviz_plugins
@@ -17,7 +17,9 @@
 #include <QVBoxLayout>
 #include <rclcpp/rclcpp.hpp>
 
+#include <chrono>
 #include <ctime>
+#include <memory>
 
 namespace tier4_string_viewer_rviz_plugin
 {
@@ -45,6 +47,16 @@ void StringViewerPanel::onInitialize()
 
   using namespace std::literals::chrono_literals;
   timer_ = raw_node_->create_wall_timer(1000ms, [&]() { on_timer(); });
+  create_render_timer();
+}
+
+void StringViewerPanel::create_render_timer()
+{
+  if (!raw_node_) return;
+
+  const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::duration<double>(1.0 / update_rate_));
+  render_timer_ = raw_node_->create_wall_timer(period, [&]() { on_render_timer(); });
 }
 
 void StringViewerPanel::on_topic_name(const QString & topic)
@@ -52,6 +64,8 @@ void StringViewerPanel::on_topic_name(const QString & topic)
   if (topic.isEmpty()) return;
 
   contents_->clear();
+  displayed_text_.clear();
+  std::atomic_store(&latest_msg_, StringStamped::ConstSharedPtr());
   sub_string_.reset();
   sub_string_ = raw_node_->create_subscription<StringStamped>(
     topic.toStdString(), rclcpp::QoS{1},
@@ -60,6 +74,16 @@ void StringViewerPanel::on_topic_name(const QString & topic)
 
 void StringViewerPanel::on_string(const StringStamped::ConstSharedPtr msg)
 {
+  // only the latest message is kept until the next update of the label
+  std::atomic_store(&latest_msg_, msg);
+}
+
+void StringViewerPanel::on_render_timer()
+{
+  const auto msg = std::atomic_exchange(&latest_msg_, StringStamped::ConstSharedPtr());
+  if (!msg || msg->data == displayed_text_) return;
+
+  displayed_text_ = msg->data;
   contents_->setText(msg->data.c_str());
   contents_->setWordWrap(true);
 }
@@ -102,12 +126,18 @@ void StringViewerPanel::save(rviz_common::Config config) const
 {
   Panel::save(config);
   config.mapSetValue("topic", topic_list_->currentText());
+  config.mapSetValue("update_rate", update_rate_);
 }
 
 void StringViewerPanel::load(const rviz_common::Config & config)
 {
   Panel::load(config);
   config.mapGetString("topic", &default_topic_);
+  float update_rate = 0.0;
+  if (config.mapGetFloat("update_rate", &update_rate) && update_rate > 0.0) {
+    update_rate_ = update_rate;
+    create_render_timer();
+  }
 }
 }  // namespace tier4_string_viewer_rviz_plugin
 
@@ -24,6 +24,9 @@
 
 #include <autoware_internal_debug_msgs/msg/string_stamped.hpp>
 
+#include <memory>
+#include <string>
+
 namespace tier4_string_viewer_rviz_plugin
 {
 
@@ -52,6 +55,10 @@ private:
 
   void on_timer();
 
+  void on_render_timer();
+
+  void create_render_timer();
+
   QLabel * contents_;
 
   QComboBox * topic_list_;
@@ -64,6 +71,13 @@ private:
 
   rclcpp::Subscription<StringStamped>::SharedPtr sub_string_;
 
+  // The latest message is swapped in by on_string, and the label is updated by render_timer_ at
+  // most at update_rate_ only when the text is changed
+  rclcpp::TimerBase::SharedPtr render_timer_;
+  StringStamped::ConstSharedPtr latest_msg_;
+  std::string displayed_text_;
+  double update_rate_{10.0};
+
   size_t topic_num_{0L};
 };
 }  // namespace tier4_string_viewer_rviz_plugin
@@ -21,11 +21,19 @@
 #include <rclcpp/rclcpp.hpp>
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 TargetObjectTypePanel::TargetObjectTypePanel(QWidget * parent) : rviz_common::Panel(parent)
 {
   node_ = std::make_shared<rclcpp::Node>("matrix_display_node");
+  executor_.add_node(node_);
+
+  spin_timer_ = new QTimer(this);
+  spin_timer_->setInterval(10);
+  connect(spin_timer_, &QTimer::timeout, this, &TargetObjectTypePanel::onSpinTimer);
 
   setParameters();
 
@@ -247,23 +255,10 @@ void TargetObjectTypePanel::setParameters()
 
 void TargetObjectTypePanel::updateMatrix()
 {
-  // blue base
-  // const QColor color_in_use("#6eb6cc");
-  // const QColor color_no_use("#1d3e48");
-  // const QColor color_undefined("#9e9e9e");
-
-  // green base
-  const QColor color_in_use("#afff70");
-  const QColor color_no_use("#44642b");
-  const QColor color_undefined("#9e9e9e");
-
-  const auto set_undefined = [&](const auto i, const auto j) {
-    QTableWidgetItem * item = new QTableWidgetItem("N/A");
-    item->setForeground(QBrush(Qt::black));  // set the text color to black
-    item->setBackground(color_undefined);
-    matrix_widget_->setItem(i, j, item);
-  };
+  ++request_generation_;
+  node_requests_.clear();
 
+  // the parameters of the modules in the same node are requested at once
   for (size_t i = 0; i < modules_.size(); i++) {
     const auto & module = modules_[i];
 
@@ -274,17 +269,7 @@ void TargetObjectTypePanel::updateMatrix()
     }
 
     const auto & module_params = param_names_.at(module);
-    auto parameters_client =
-      std::make_shared<rclcpp::SyncParametersClient>(node_, module_params.node);
-    if (!parameters_client->wait_for_service(std::chrono::microseconds(500))) {
-      RCLCPP_WARN_STREAM(
-        node_->get_logger(), "Failed to find parameter service for node: " << module_params.node);
-      for (size_t j = 0; j < targets_.size(); j++) {
-        set_undefined(i, j);
-      }
-      continue;
-    }
-
+    auto & request = node_requests_[module_params.node];
     for (size_t j = 0; j < targets_.size(); j++) {
       const auto & target = targets_[j];
 
@@ -297,21 +282,149 @@ void TargetObjectTypePanel::updateMatrix()
 
       std::string param_name =
         (module_params.ns.empty() ? "" : module_params.ns + ".") + module_params.name.at(target);
-      auto parameter_result = parameters_client->get_parameters({param_name});
-
-      if (!parameter_result.empty()) {
-        bool value = parameter_result[0].as_bool();
-        QTableWidgetItem * item = new QTableWidgetItem(value ? "O" : "X");
-        item->setForeground(QBrush(value ? Qt::black : Qt::black));  // set the text color to black
-        item->setBackground(QBrush(value ? color_in_use : color_no_use));
-        matrix_widget_->setItem(i, j, item);
+      auto & cells = request.cells[param_name];
+      if (cells.empty()) {
+        request.names.push_back(param_name);
+      }
+      cells.emplace_back(i, j);
+    }
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  for (auto & [node_name, request] : node_requests_) {
+    if (parameter_clients_.find(node_name) == parameter_clients_.end()) {
+      parameter_clients_.emplace(
+        node_name, std::make_shared<rclcpp::AsyncParametersClient>(node_, node_name));
+    }
+    request.start_time = now;
+  }
+
+  // the requests are sent and the responses are handled in the timer, not to block the UI
+  onSpinTimer();
+  spin_timer_->start();
+}
+
+void TargetObjectTypePanel::onSpinTimer()
+{
+  // the service discovery and the response each wait for up to this duration
+  constexpr auto timeout = std::chrono::seconds(1);
+
+  executor_.spin_some();
+
+  const auto now = std::chrono::steady_clock::now();
+  for (auto itr = node_requests_.begin(); itr != node_requests_.end();) {
+    const auto & node_name = itr->first;
+    auto & request = itr->second;
+    if (request.is_sent && request.pending_response_num == 0) {
+      itr = node_requests_.erase(itr);
+      continue;
+    }
+
+    if (!request.is_sent && parameter_clients_.at(node_name)->service_is_ready()) {
+      request.is_sent = true;
+      request.start_time = now;
+      sendParameterRequest(node_name, request.names);
+    } else if (timeout < now - request.start_time) {
+      if (request.is_sent) {
+        RCLCPP_WARN_STREAM(
+          node_->get_logger(), "Failed to get parameters from node: " << node_name);
       } else {
         RCLCPP_WARN_STREAM(
-          node_->get_logger(),
-          "Failed to get parameter " << module_params.node << " " << param_name);
+          node_->get_logger(), "Failed to find parameter service for node: " << node_name);
+      }
+      setUndefinedCells(request);
+      itr = node_requests_.erase(itr);
+      continue;
+    }
+    ++itr;
+  }
 
-        set_undefined(i, j);
+  if (node_requests_.empty()) {
+    spin_timer_->stop();
+  }
+}
+
+void TargetObjectTypePanel::sendParameterRequest(
+  const std::string & node, const std::vector<std::string> & names)
+{
+  auto & request = node_requests_.at(node);
+  ++request.pending_response_num;
+
+  const auto generation = request_generation_;
+  parameter_clients_.at(node)->get_parameters(
+    names, [this, node, names, generation](
+             std::shared_future<std::vector<rclcpp::Parameter>> future) {
+      // the response is handled in spin_some of the timer, i.e. in the UI thread
+      if (generation != request_generation_ || node_requests_.count(node) == 0) {
+        return;
+      }
+      auto & request = node_requests_.at(node);
+      --request.pending_response_num;
+
+      const auto parameters = future.get();
+
+      // the node returns no parameters when any of them is not declared, and then each of them is
+      // requested separately to find the ones that exist
+      if (parameters.empty() && 1 < names.size()) {
+        for (const auto & name : names) {
+          sendParameterRequest(node, {name});
+        }
+        return;
       }
+
+      std::unordered_map<std::string, bool> values;
+      for (const auto & parameter : parameters) {
+        if (parameter.get_type() == rclcpp::ParameterType::PARAMETER_BOOL) {
+          values.emplace(parameter.get_name(), parameter.as_bool());
+        }
+      }
+      for (const auto & name : names) {
+        const auto value_itr = values.find(name);
+        if (value_itr == values.end()) {
+          RCLCPP_WARN_STREAM(
+            node_->get_logger(), "Failed to get parameter " << node << " " << name);
+        }
+        for (const auto & [i, j] : request.cells.at(name)) {
+          setCell(
+            i, j,
+            value_itr == values.end() ? std::nullopt : std::make_optional(value_itr->second));
+        }
+      }
+    });
+}
+
+void TargetObjectTypePanel::setCell(
+  const size_t i, const size_t j, const std::optional<bool> & value)
+{
+  // blue base
+  // const QColor color_in_use("#6eb6cc");
+  // const QColor color_no_use("#1d3e48");
+  // const QColor color_undefined("#9e9e9e");
+
+  // green base
+  const QColor color_in_use("#afff70");
+  const QColor color_no_use("#44642b");
+  const QColor color_undefined("#9e9e9e");
+
+  if (!value) {
+    QTableWidgetItem * item = new QTableWidgetItem("N/A");
+    item->setForeground(QBrush(Qt::black));  // set the text color to black
+    item->setBackground(color_undefined);
+    matrix_widget_->setItem(i, j, item);
+    return;
+  }
+
+  QTableWidgetItem * item = new QTableWidgetItem(*value ? "O" : "X");
+  item->setForeground(QBrush(Qt::black));  // set the text color to black
+  item->setBackground(QBrush(*value ? color_in_use : color_no_use));
+  matrix_widget_->setItem(i, j, item);
+}
+
+void TargetObjectTypePanel::setUndefinedCells(const NodeParameterRequest & request)
+{
+  for (const auto & [name, cells] : request.cells) {
+    for (const auto & [i, j] : cells) {
+      setCell(i, j, std::nullopt);
     }
   }
 }
@@ -18,12 +18,16 @@
 #include <QPushButton>
 #include <QTableWidget>
 #include <QTableWidgetItem>
+#include <QTimer>
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 class TargetObjectTypePanel : public rviz_common::Panel
@@ -47,14 +51,34 @@ protected:
   };
   std::unordered_map<std::string, ParamNameEnableObject> param_names_;
 
+  // parameters requested from a node at once, and the cells of the matrix to fill with them
+  struct NodeParameterRequest
+  {
+    std::vector<std::string> names;
+    std::unordered_map<std::string, std::vector<std::pair<size_t, size_t>>> cells;
+    std::chrono::steady_clock::time_point start_time;
+    bool is_sent{false};
+    size_t pending_response_num{0};
+  };
+  std::unordered_map<std::string, NodeParameterRequest> node_requests_;
+  std::unordered_map<std::string, rclcpp::AsyncParametersClient::SharedPtr> parameter_clients_;
+  rclcpp::executors::SingleThreadedExecutor executor_;
+  // to ignore the responses to the requests before reloading
+  size_t request_generation_{0};
+
 private slots:
   void onReloadButtonClicked();
+  void onSpinTimer();
 
 private:
   QPushButton * reload_button_;
+  QTimer * spin_timer_;
 
   void updateMatrix();
   void setParameters();
+  void sendParameterRequest(const std::string & node, const std::vector<std::string> & names);
+  void setCell(const size_t i, const size_t j, const std::optional<bool> & value);
+  void setUndefinedCells(const NodeParameterRequest & request);
 };
 
 #endif  // TARGET_OBJECT_TYPE_PANEL_HPP_
@@ -0,0 +1,208 @@
+// Copyright 2021 Tier IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VEHICLE_CMD_ANALYZER__COMMAND_STATISTICS_HPP_
+#define VEHICLE_CMD_ANALYZER__COMMAND_STATISTICS_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+/// nearest-rank percentile, which partially sorts the given values
+inline double calcPercentile(std::vector<double> & values, const double ratio)
+{
+  const auto rank = static_cast<size_t>(std::ceil(ratio * values.size()));
+  const auto nth = values.begin() + std::max<size_t>(rank, 1) - 1;
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+/// Statistics of the commands received in a sliding time window
+class CommandStatistics
+{
+public:
+  /// Types of statistics values
+  enum class TYPE {
+    SAMPLE_NUM = 0,
+    WINDOW_DURATION = 1,
+    RMS_JERK = 2,
+    MAX_ABS_JERK = 3,
+    ABS_JERK_P50 = 4,
+    ABS_JERK_P95 = 5,
+    ABS_JERK_P99 = 6,
+    MAX_ABS_LATERAL_ACC = 7,
+    ABS_LATERAL_ACC_P50 = 8,
+    ABS_LATERAL_ACC_P95 = 9,
+    ABS_LATERAL_ACC_P99 = 10,
+    SIZE  // this is the number of enum elements
+  };
+
+  using Values = std::array<double, static_cast<int>(TYPE::SIZE)>;
+
+  /**
+   * @param [in] window_duration duration of the window [s]
+   */
+  explicit CommandStatistics(const double window_duration) : window_duration_(window_duration) {}
+
+  /**
+   * @brief add a sample, and drop the samples older than the window
+   * @param [in] stamp stamp of the command [s]
+   * @param [in] jerk derivative of the commanded acceleration
+   * @param [in] lateral_acc lateral acceleration of the command
+   */
+  void addSample(const double stamp, const double jerk, const double lateral_acc)
+  {
+    samples_.push_back({stamp, jerk, lateral_acc});
+    while (!samples_.empty() && samples_.front().stamp < stamp - window_duration_) {
+      samples_.pop_front();
+    }
+  }
+
+  void clear() { samples_.clear(); }
+  bool empty() const { return samples_.empty(); }
+
+  /**
+   * @brief compute the statistics of the samples in the window
+   * @return all the statistics values, which are 0 if there is no sample
+   */
+  Values calcValues() const
+  {
+    Values values{};
+    if (samples_.empty()) {
+      return values;
+    }
+
+    std::vector<double> abs_jerk;
+    std::vector<double> abs_lateral_acc;
+    abs_jerk.reserve(samples_.size());
+    abs_lateral_acc.reserve(samples_.size());
+    double sum_sq_jerk = 0.0;
+    for (const auto & s : samples_) {
+      abs_jerk.push_back(std::abs(s.jerk));
+      abs_lateral_acc.push_back(std::abs(s.lateral_acc));
+      sum_sq_jerk += s.jerk * s.jerk;
+    }
+
+    set(values, TYPE::SAMPLE_NUM, samples_.size());
+    set(values, TYPE::WINDOW_DURATION, samples_.back().stamp - samples_.front().stamp);
+    set(values, TYPE::RMS_JERK, std::sqrt(sum_sq_jerk / samples_.size()));
+    set(values, TYPE::MAX_ABS_JERK, *std::max_element(abs_jerk.begin(), abs_jerk.end()));
+    set(values, TYPE::ABS_JERK_P50, calcPercentile(abs_jerk, 0.50));
+    set(values, TYPE::ABS_JERK_P95, calcPercentile(abs_jerk, 0.95));
+    set(values, TYPE::ABS_JERK_P99, calcPercentile(abs_jerk, 0.99));
+    set(
+      values, TYPE::MAX_ABS_LATERAL_ACC,
+      *std::max_element(abs_lateral_acc.begin(), abs_lateral_acc.end()));
+    set(values, TYPE::ABS_LATERAL_ACC_P50, calcPercentile(abs_lateral_acc, 0.50));
+    set(values, TYPE::ABS_LATERAL_ACC_P95, calcPercentile(abs_lateral_acc, 0.95));
+    set(values, TYPE::ABS_LATERAL_ACC_P99, calcPercentile(abs_lateral_acc, 0.99));
+    return values;
+  }
+
+private:
+  struct Sample
+  {
+    double stamp;
+    double jerk;
+    double lateral_acc;
+  };
+
+  static void set(Values & values, const TYPE type, const double value)
+  {
+    values.at(static_cast<int>(type)) = value;
+  }
+
+  double window_duration_;
+  std::deque<Sample> samples_;
+};
+
+/// Statistics of the latencies of the commands in a sliding time window
+class LatencyStatistics
+{
+public:
+  /// Types of statistics values
+  enum class TYPE {
+    SAMPLE_NUM = 0,
+    MEAN = 1,
+    MAX = 2,
+    P50 = 3,
+    P95 = 4,
+    P99 = 5,
+    SIZE  // this is the number of enum elements
+  };
+
+  using Values = std::array<double, static_cast<int>(TYPE::SIZE)>;
+
+  /**
+   * @param [in] window_duration duration of the window [s]
+   */
+  explicit LatencyStatistics(const double window_duration) : window_duration_(window_duration) {}
+
+  /**
+   * @brief add a sample, and drop the samples older than the window
+   * @param [in] time time when the latency is measured [s]
+   * @param [in] latency latency of the command [s]
+   */
+  void addSample(const double time, const double latency)
+  {
+    samples_.emplace_back(time, latency);
+    while (!samples_.empty() && samples_.front().first < time - window_duration_) {
+      samples_.pop_front();
+    }
+  }
+
+  bool empty() const { return samples_.empty(); }
+
+  /**
+   * @brief compute the statistics of the samples in the window
+   * @return all the statistics values, which are 0 if there is no sample
+   */
+  Values calcValues() const
+  {
+    Values values{};
+    if (samples_.empty()) {
+      return values;
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(samples_.size());
+    for (const auto & s : samples_) {
+      latencies.push_back(s.second);
+    }
+    const double sum = std::accumulate(latencies.begin(), latencies.end(), 0.0);
+
+    set(values, TYPE::SAMPLE_NUM, samples_.size());
+    set(values, TYPE::MEAN, sum / samples_.size());
+    set(values, TYPE::MAX, *std::max_element(latencies.begin(), latencies.end()));
+    set(values, TYPE::P50, calcPercentile(latencies, 0.50));
+    set(values, TYPE::P95, calcPercentile(latencies, 0.95));
+    set(values, TYPE::P99, calcPercentile(latencies, 0.99));
+    return values;
+  }
+
+private:
+  static void set(Values & values, const TYPE type, const double value)
+  {
+    values.at(static_cast<int>(type)) = value;
+  }
+
+  double window_duration_;
+  std::deque<std::pair<double, double>> samples_;  // time and latency
+};
+
+#endif  // VEHICLE_CMD_ANALYZER__COMMAND_STATISTICS_HPP_
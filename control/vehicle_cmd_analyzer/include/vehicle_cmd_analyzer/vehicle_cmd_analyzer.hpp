@@ -16,6 +16,7 @@
 #define VEHICLE_CMD_ANALYZER__VEHICLE_CMD_ANALYZER_HPP_
 
 #include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
+#include "vehicle_cmd_analyzer/command_statistics.hpp"
 #include "vehicle_cmd_analyzer/debug_values.hpp"
 
 #include <rclcpp/rclcpp.hpp>
@@ -24,45 +25,100 @@
 #include "autoware_internal_debug_msgs/msg/float32_multi_array_stamped.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 class VehicleCmdAnalyzer : public rclcpp::Node
 {
 private:
-  rclcpp::Subscription<autoware_control_msgs::msg::Control>::SharedPtr sub_vehicle_cmd_;
-  rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>::SharedPtr
-    pub_debug_;
+  using Float32MultiArrayStamped = autoware_internal_debug_msgs::msg::Float32MultiArrayStamped;
+
+  /// Velocity and acceleration of a received command
+  struct CommandSample
+  {
+    double stamp;
+    double vel;
+    double acc;
+  };
+
+  /// Command topic to analyze, with its own outputs
+  struct InputTopic
+  {
+    std::string name;
+    rclcpp::Subscription<autoware_control_msgs::msg::Control>::SharedPtr sub_vehicle_cmd;
+    rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_debug;
+    rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_statistics;
+    rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_latency;
+    rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_latency_statistics;
+
+    autoware_control_msgs::msg::Control::ConstSharedPtr vehicle_cmd_ptr{nullptr};
+
+    // the last commands, newest at the back, for the derivatives in the event-driven mode
+    std::array<CommandSample, 3> command_samples{};
+    size_t command_sample_num{0};
+    std::unique_ptr<CommandStatistics> statistics;
+    // latencies from the first input topic, which is null for the first input topic
+    std::unique_ptr<LatencyStatistics> latency_statistics;
+
+    double prev_target_vel{0.0};
+    std::array<double, 3> prev_target_d_vel = {};
+    double prev_target_acc{0.0};
+
+    // debug values
+    DebugValues debug_values;
+  };
+
+  /// Receive time of a command of the first input topic
+  struct ReferenceStamp
+  {
+    int64_t stamp;  // [ns]
+    double receive_time;
+  };
+
+  // the commands are analyzed for each input topic in the same callbacks of the timers
+  std::vector<InputTopic> inputs_;
   rclcpp::TimerBase::SharedPtr timer_control_;
-
-  std::shared_ptr<autoware_control_msgs::msg::Control> vehicle_cmd_ptr_{nullptr};
+  rclcpp::TimerBase::SharedPtr timer_statistics_;
 
   // timer callback
   double control_rate_;
   double wheelbase_;
 
-  // for calculating dt
-  std::shared_ptr<rclcpp::Time> prev_control_time_{nullptr};
+  // event-driven mode, which computes the values for every command from the stamps of the
+  // commands, and publishes the statistics of them at statistics_rate_
+  bool use_event_driven_mode_;
+  double statistics_rate_;
 
-  double prev_target_vel_;
-  std::array<double, 3> prev_target_d_vel_ = {};
-  double prev_target_acc_;
+  // the latency of a command of the other input topics is the difference of the receive times from
+  // the command of the first input topic with the same stamp, with the steady clock
+  rclcpp::Clock steady_clock_{RCL_STEADY_TIME};
+  std::deque<ReferenceStamp> reference_stamps_;
+  static constexpr size_t max_reference_stamp_num_ = 256;
 
-  // debug values
-  DebugValues debug_values_;
+  // for calculating dt
+  std::shared_ptr<rclcpp::Time> prev_control_time_{nullptr};
 
-  void callbackVehicleCommand(const autoware_control_msgs::msg::Control::SharedPtr msg);
+  void callbackVehicleCommand(
+    const size_t input_idx, const autoware_control_msgs::msg::Control::ConstSharedPtr msg);
 
   void callbackTimerControl();
+  void callbackTimerStatistics();
+
+  void processCommandEvent(InputTopic & input);
+  void measureLatency(const size_t input_idx);
 
-  void publishDebugData();
+  void publishDebugData(InputTopic & input, const double dt);
 
   double getDt();
-  std::pair<double, double> differentiateVelocity(const double dt);
-  double differentiateAcceleration(const double dt);
-  double calcLateralAcceleration() const;
+  std::pair<double, double> differentiateVelocity(InputTopic & input, const double dt);
+  double differentiateAcceleration(InputTopic & input, const double dt);
+  double calcLateralAcceleration(const InputTopic & input) const;
 
 public:
   explicit VehicleCmdAnalyzer(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
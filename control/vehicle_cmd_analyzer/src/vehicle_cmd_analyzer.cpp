@@ -18,23 +18,79 @@
 
 #include <algorithm>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 VehicleCmdAnalyzer::VehicleCmdAnalyzer(const rclcpp::NodeOptions & options)
 : Node("vehicle_cmd_analyzer", options)
 {
   control_rate_ = declare_parameter("control_rate", 30.0);
+  use_event_driven_mode_ = declare_parameter("use_event_driven_mode", false);
+  statistics_rate_ = declare_parameter("statistics_rate", 1.0);
+  const double statistics_window_duration = declare_parameter("statistics_window_duration", 10.0);
+  const auto input_topics = declare_parameter<std::vector<std::string>>(
+    "input_topics", std::vector<std::string>{"/control/command/control_cmd"});
+  auto input_names = declare_parameter<std::vector<std::string>>(
+    "input_names", std::vector<std::string>{"control_cmd"});
+  if (input_topics.empty()) {
+    throw std::invalid_argument("input_topics must not be empty");
+  }
+  if (input_names.size() != input_topics.size()) {
+    RCLCPP_WARN(
+      get_logger(), "The sizes of input_names and input_topics differ, so the names are indices");
+    input_names.clear();
+    for (size_t i = 0; i < input_topics.size(); ++i) {
+      input_names.push_back("input_" + std::to_string(i));
+    }
+  }
 
   const auto vehicle_info = autoware::vehicle_info_utils::VehicleInfoUtils(*this).getVehicleInfo();
   wheelbase_ = vehicle_info.wheel_base_m;
 
-  sub_vehicle_cmd_ = this->create_subscription<autoware_control_msgs::msg::Control>(
-    "/control/command/control_cmd", rclcpp::QoS(10),
-    std::bind(&VehicleCmdAnalyzer::callbackVehicleCommand, this, std::placeholders::_1));
-  pub_debug_ = create_publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>(
-    "~/debug_values", rclcpp::QoS{1});
+  // the outputs of a single input topic are not in its namespace, as they were before
+  const bool is_multi_input = input_topics.size() > 1;
+  // the commands of the nodes in the same container are received without a copy
+  rclcpp::SubscriptionOptions input_options;
+  input_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  inputs_.resize(input_topics.size());
+  for (size_t i = 0; i < inputs_.size(); ++i) {
+    auto & input = inputs_.at(i);
+    input.name = input_names.at(i);
+    const std::string output_prefix = is_multi_input ? "~/" + input.name + "/" : "~/";
+
+    input.sub_vehicle_cmd = this->create_subscription<autoware_control_msgs::msg::Control>(
+      input_topics.at(i), rclcpp::QoS(10),
+      [this, i](const autoware_control_msgs::msg::Control::ConstSharedPtr msg) {
+        callbackVehicleCommand(i, msg);
+      },
+      input_options);
+    input.pub_debug =
+      create_publisher<Float32MultiArrayStamped>(output_prefix + "debug_values", rclcpp::QoS{1});
+    if (use_event_driven_mode_) {
+      input.statistics = std::make_unique<CommandStatistics>(statistics_window_duration);
+      input.pub_statistics = create_publisher<Float32MultiArrayStamped>(
+        output_prefix + "debug_statistics", rclcpp::QoS{1});
+    }
+    if (i > 0) {
+      input.latency_statistics = std::make_unique<LatencyStatistics>(statistics_window_duration);
+      input.pub_latency =
+        create_publisher<Float32MultiArrayStamped>(output_prefix + "debug_latency", rclcpp::QoS{1});
+      input.pub_latency_statistics = create_publisher<Float32MultiArrayStamped>(
+        output_prefix + "debug_latency_statistics", rclcpp::QoS{1});
+    }
+  }
+
+  if (use_event_driven_mode_ || is_multi_input) {
+    timer_statistics_ = rclcpp::create_timer(
+      this, get_clock(), rclcpp::Rate(statistics_rate_).period(),
+      std::bind(&VehicleCmdAnalyzer::callbackTimerStatistics, this));
+  }
+  if (use_event_driven_mode_) {
+    return;
+  }
 
   // Timer
   {
@@ -49,46 +105,164 @@ VehicleCmdAnalyzer::VehicleCmdAnalyzer(const rclcpp::NodeOptions & options)
 }
 
 void VehicleCmdAnalyzer::callbackVehicleCommand(
-  const autoware_control_msgs::msg::Control::SharedPtr msg)
+  const size_t input_idx, const autoware_control_msgs::msg::Control::ConstSharedPtr msg)
 {
-  vehicle_cmd_ptr_ = std::make_shared<autoware_control_msgs::msg::Control>(*msg);
+  auto & input = inputs_.at(input_idx);
+  input.vehicle_cmd_ptr = msg;
+
+  if (inputs_.size() > 1) {
+    measureLatency(input_idx);
+  }
+  if (use_event_driven_mode_) {
+    processCommandEvent(input);
+  }
 }
 
 void VehicleCmdAnalyzer::callbackTimerControl()
 {
-  // wait for initial pointers
-  if (!vehicle_cmd_ptr_) {
-    return;
-  }
+  // dt is common to all the input topics, which are sampled at the same time
+  const double dt = getDt();
+  for (auto & input : inputs_) {
+    // wait for initial pointers
+    if (!input.vehicle_cmd_ptr) {
+      continue;
+    }
 
-  // publish debug data
-  publishDebugData();
+    // publish debug data
+    publishDebugData(input, dt);
+  }
 }
 
-void VehicleCmdAnalyzer::publishDebugData()
+void VehicleCmdAnalyzer::publishDebugData(InputTopic & input, const double dt)
 {
-  const double dt = getDt();
-  const double a_lat = calcLateralAcceleration();
-  const auto [d_vel, dd_vel] = differentiateVelocity(dt);
+  const auto & cmd = *input.vehicle_cmd_ptr;
+  const double a_lat = calcLateralAcceleration(input);
+  const auto [d_vel, dd_vel] = differentiateVelocity(input, dt);
 
   // set debug values
-  debug_values_.setValues(DebugValues::TYPE::DT, dt);
-  debug_values_.setValues(
-    DebugValues::TYPE::CURRENT_TARGET_VEL, vehicle_cmd_ptr_->longitudinal.velocity);
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_D_VEL, d_vel);
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_DD_VEL, dd_vel);
-  debug_values_.setValues(
-    DebugValues::TYPE::CURRENT_TARGET_ACC, vehicle_cmd_ptr_->longitudinal.acceleration);
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_D_ACC, differentiateAcceleration(dt));
-  debug_values_.setValues(DebugValues::TYPE::CURRENT_TARGET_LATERAL_ACC, a_lat);
+  auto & debug_values = input.debug_values;
+  debug_values.setValues(DebugValues::TYPE::DT, dt);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_VEL, cmd.longitudinal.velocity);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_D_VEL, d_vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_DD_VEL, dd_vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_ACC, cmd.longitudinal.acceleration);
+  debug_values.setValues(
+    DebugValues::TYPE::CURRENT_TARGET_D_ACC, differentiateAcceleration(input, dt));
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_LATERAL_ACC, a_lat);
 
   // publish debug values
-  autoware_internal_debug_msgs::msg::Float32MultiArrayStamped debug_msg{};
+  Float32MultiArrayStamped debug_msg{};
   debug_msg.stamp = this->now();
-  for (const auto & v : debug_values_.getValues()) {
+  for (const auto & v : debug_values.getValues()) {
+    debug_msg.data.push_back(v);
+  }
+  input.pub_debug->publish(debug_msg);
+}
+
+void VehicleCmdAnalyzer::processCommandEvent(InputTopic & input)
+{
+  const CommandSample sample{
+    rclcpp::Time(input.vehicle_cmd_ptr->stamp).seconds(),
+    input.vehicle_cmd_ptr->longitudinal.velocity,
+    input.vehicle_cmd_ptr->longitudinal.acceleration};
+
+  // restart the derivatives when the stamps do not increase, e.g. a rosbag is replayed again
+  auto & samples = input.command_samples;
+  auto & sample_num = input.command_sample_num;
+  if (sample_num > 0 && sample.stamp <= samples.back().stamp) {
+    sample_num = 0;
+    input.statistics->clear();
+  }
+  std::rotate(samples.begin(), samples.begin() + 1, samples.end());
+  samples.back() = sample;
+  sample_num = std::min(sample_num + 1, samples.size());
+
+  const auto & s2 = samples.at(2);
+  const auto & s1 = samples.at(1);
+  const auto & s0 = samples.at(0);
+  const double dt = sample_num > 1 ? s2.stamp - s1.stamp : 0.0;
+  const double d_vel = sample_num > 1 ? (s2.vel - s1.vel) / dt : 0.0;
+  const double d_acc = sample_num > 1 ? (s2.acc - s1.acc) / dt : 0.0;
+  const double dd_vel =
+    sample_num > 2
+      ? (d_vel - (s1.vel - s0.vel) / (s1.stamp - s0.stamp)) / (0.5 * (s2.stamp - s0.stamp))
+      : 0.0;
+  const double a_lat = calcLateralAcceleration(input);
+
+  auto & debug_values = input.debug_values;
+  debug_values.setValues(DebugValues::TYPE::DT, dt);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_VEL, sample.vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_D_VEL, d_vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_DD_VEL, dd_vel);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_ACC, sample.acc);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_D_ACC, d_acc);
+  debug_values.setValues(DebugValues::TYPE::CURRENT_TARGET_LATERAL_ACC, a_lat);
+
+  if (sample_num > 1) {
+    input.statistics->addSample(sample.stamp, d_acc, a_lat);
+  }
+
+  // the values are stamped with the command, so that they are exact even if they are delayed
+  Float32MultiArrayStamped debug_msg{};
+  debug_msg.stamp = input.vehicle_cmd_ptr->stamp;
+  for (const auto & v : debug_values.getValues()) {
     debug_msg.data.push_back(v);
   }
-  pub_debug_->publish(debug_msg);
+  input.pub_debug->publish(debug_msg);
+}
+
+void VehicleCmdAnalyzer::measureLatency(const size_t input_idx)
+{
+  auto & input = inputs_.at(input_idx);
+  const int64_t stamp = rclcpp::Time(input.vehicle_cmd_ptr->stamp).nanoseconds();
+  const double receive_time = steady_clock_.now().seconds();
+
+  if (input_idx == 0) {
+    reference_stamps_.push_back({stamp, receive_time});
+    if (reference_stamps_.size() > max_reference_stamp_num_) {
+      reference_stamps_.pop_front();
+    }
+    return;
+  }
+
+  // the latest reference is the most likely to have the same stamp
+  const auto reference = std::find_if(
+    reference_stamps_.rbegin(), reference_stamps_.rend(),
+    [stamp](const ReferenceStamp & s) { return s.stamp == stamp; });
+  if (reference == reference_stamps_.rend()) {
+    return;
+  }
+
+  const double latency = receive_time - reference->receive_time;
+  input.latency_statistics->addSample(receive_time, latency);
+
+  Float32MultiArrayStamped latency_msg{};
+  latency_msg.stamp = input.vehicle_cmd_ptr->stamp;
+  latency_msg.data.push_back(latency);
+  input.pub_latency->publish(latency_msg);
+}
+
+void VehicleCmdAnalyzer::callbackTimerStatistics()
+{
+  for (const auto & input : inputs_) {
+    if (input.statistics && !input.statistics->empty()) {
+      Float32MultiArrayStamped statistics_msg{};
+      statistics_msg.stamp = input.vehicle_cmd_ptr->stamp;
+      for (const auto & v : input.statistics->calcValues()) {
+        statistics_msg.data.push_back(v);
+      }
+      input.pub_statistics->publish(statistics_msg);
+    }
+
+    if (input.latency_statistics && !input.latency_statistics->empty()) {
+      Float32MultiArrayStamped latency_statistics_msg{};
+      latency_statistics_msg.stamp = this->now();
+      for (const auto & v : input.latency_statistics->calcValues()) {
+        latency_statistics_msg.data.push_back(v);
+      }
+      input.pub_latency_statistics->publish(latency_statistics_msg);
+    }
+  }
 }
 
 double VehicleCmdAnalyzer::getDt()
@@ -106,38 +280,41 @@ double VehicleCmdAnalyzer::getDt()
   return std::max(std::min(dt, max_dt), min_dt);
 }
 
-std::pair<double, double> VehicleCmdAnalyzer::differentiateVelocity(const double dt)
+std::pair<double, double> VehicleCmdAnalyzer::differentiateVelocity(
+  InputTopic & input, const double dt)
 {
-  if (!prev_target_vel_) {
-    prev_target_vel_ = vehicle_cmd_ptr_->longitudinal.velocity;
-    prev_target_d_vel_.at(2) = 0.0;
+  const double vel = input.vehicle_cmd_ptr->longitudinal.velocity;
+  if (!input.prev_target_vel) {
+    input.prev_target_vel = vel;
+    input.prev_target_d_vel.at(2) = 0.0;
     return {0.0, 0.0};
   }
-  const double d_vel = (vehicle_cmd_ptr_->longitudinal.velocity - prev_target_vel_) / dt;
-  const double dd_vel = (d_vel - prev_target_d_vel_.at(0)) / 2 / dt;
-  prev_target_vel_ = vehicle_cmd_ptr_->longitudinal.velocity;
+  const double d_vel = (vel - input.prev_target_vel) / dt;
+  const double dd_vel = (d_vel - input.prev_target_d_vel.at(0)) / 2 / dt;
+  input.prev_target_vel = vel;
   for (int i = 0; i < 2; i++) {
-    prev_target_d_vel_.at(i) = prev_target_d_vel_.at(i + 1);
+    input.prev_target_d_vel.at(i) = input.prev_target_d_vel.at(i + 1);
   }
-  prev_target_d_vel_.at(2) = d_vel;
+  input.prev_target_d_vel.at(2) = d_vel;
   return {d_vel, dd_vel};
 }
 
-double VehicleCmdAnalyzer::differentiateAcceleration(const double dt)
+double VehicleCmdAnalyzer::differentiateAcceleration(InputTopic & input, const double dt)
 {
-  if (!prev_target_acc_) {
-    prev_target_acc_ = vehicle_cmd_ptr_->longitudinal.acceleration;
+  const double acc = input.vehicle_cmd_ptr->longitudinal.acceleration;
+  if (!input.prev_target_acc) {
+    input.prev_target_acc = acc;
     return 0.0;
   }
-  const double d_acc = (vehicle_cmd_ptr_->longitudinal.acceleration - prev_target_acc_) / dt;
-  prev_target_acc_ = vehicle_cmd_ptr_->longitudinal.acceleration;
+  const double d_acc = (acc - input.prev_target_acc) / dt;
+  input.prev_target_acc = acc;
   return d_acc;
 }
 
-double VehicleCmdAnalyzer::calcLateralAcceleration() const
+double VehicleCmdAnalyzer::calcLateralAcceleration(const InputTopic & input) const
 {
-  const double delta = vehicle_cmd_ptr_->lateral.steering_tire_angle;
-  const double vel = vehicle_cmd_ptr_->longitudinal.velocity;
+  const double delta = input.vehicle_cmd_ptr->lateral.steering_tire_angle;
+  const double vel = input.vehicle_cmd_ptr->longitudinal.velocity;
   const double a_lat = vel * vel * std::sin(delta) / wheelbase_;
   return a_lat;
 }
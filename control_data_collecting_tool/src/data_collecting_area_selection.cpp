@@ -84,19 +84,45 @@ void DataCollectingAreaSelectionTool::activate()
 void DataCollectingAreaSelectionTool::deactivate()
 {
   context_->getSelectionManager()->removeHighlight();
+  is_highlighted_ = false;
 }
 
 void DataCollectingAreaSelectionTool::update(float wall_dt, float ros_dt)
 {
   (void)wall_dt;
   (void)ros_dt;
-  auto sel_manager = context_->getSelectionManager();
 
   if (!selecting_) {
-    sel_manager->removeHighlight();
+    removeHighlight();
   }
 }
 
+void DataCollectingAreaSelectionTool::highlight(
+  rviz_rendering::RenderWindow * window, int x1, int y1, int x2, int y2, bool force)
+{
+  const std::array<int, 4> rectangle{x1, y1, x2, y2};
+  const auto now = std::chrono::steady_clock::now();
+  if (
+    !force && is_highlighted_ &&
+    (rectangle == highlighted_rectangle_ || now - last_highlight_time_ < highlight_period_)) {
+    return;
+  }
+
+  context_->getSelectionManager()->highlight(window, x1, y1, x2, y2);
+  is_highlighted_ = true;
+  highlighted_rectangle_ = rectangle;
+  last_highlight_time_ = now;
+}
+
+void DataCollectingAreaSelectionTool::removeHighlight()
+{
+  if (!is_highlighted_) {
+    return;
+  }
+  context_->getSelectionManager()->removeHighlight();
+  is_highlighted_ = false;
+}
+
 int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMouseEvent & event)
 {
   auto generatePoint = [](double x, double y, double z) {
@@ -107,9 +133,11 @@ int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMous
     return point;
   };
 
-  auto sel_manager = context_->getSelectionManager();
-  auto point_projection_on_xy_plane = projection_finder_->getViewportPointProjectionOnXYPlane(
-    event.panel->getRenderWindow(), event.x, event.y);
+  // the projection is needed only when the selection starts or ends, not at every mouse move
+  const auto project_point_on_xy_plane = [&]() {
+    return projection_finder_->getViewportPointProjectionOnXYPlane(
+      event.panel->getRenderWindow(), event.x, event.y);
+  };
 
   int flags = 0;
 
@@ -120,6 +148,7 @@ int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMous
     moving_ = false;
 
     if (event.leftDown()) {
+      const auto point_projection_on_xy_plane = project_point_on_xy_plane();
       selecting_ = true;
       sel_start_x_ = event.x;
       sel_start_y_ = event.y;
@@ -130,12 +159,14 @@ int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMous
   }
 
   if (selecting_) {
-    sel_manager->highlight(
-      event.panel->getRenderWindow(), sel_start_x_, sel_start_y_, event.x, event.y);
+    highlight(
+      event.panel->getRenderWindow(), sel_start_x_, sel_start_y_, event.x, event.y,
+      event.leftDown() || event.leftUp());
 
     if (event.leftUp()) {
       sel_end_x_ = event.x;
       sel_end_y_ = event.y;
+      const auto point_projection_on_xy_plane = project_point_on_xy_plane();
       auto tmp_point_projection_on_xy_plane1 =
         projection_finder_->getViewportPointProjectionOnXYPlane(
           event.panel->getRenderWindow(), sel_start_x_, sel_end_y_);
@@ -164,7 +195,7 @@ int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMous
 
     flags |= Render;
   } else if (moving_) {
-    sel_manager->removeHighlight();
+    removeHighlight();
 
     flags = move_tool_->processMouseEvent(event);
 
@@ -172,7 +203,7 @@ int DataCollectingAreaSelectionTool::processMouseEvent(rviz_common::ViewportMous
       moving_ = false;
     }
   } else {
-    sel_manager->highlight(event.panel->getRenderWindow(), event.x, event.y, event.x, event.y);
+    highlight(event.panel->getRenderWindow(), event.x, event.y, event.x, event.y);
   }
   return flags;
 }
@@ -25,10 +25,13 @@
 #include <geometry_msgs/msg/point.hpp>
 #include <geometry_msgs/msg/polygon_stamped.hpp>
 
+#include <array>
+#include <chrono>
 #include <memory>
 
 namespace rviz_rendering
 {
+class RenderWindow;
 class Shape;
 }
 
@@ -66,6 +69,12 @@ private:
   void onOperationModeState(
     const autoware_adapi_v1_msgs::msg::OperationModeState::ConstSharedPtr msg);
 
+  // the highlight renders the selection, so it is updated only when the rectangle is changed and
+  // at most at highlight_period_
+  void highlight(
+    rviz_rendering::RenderWindow * window, int x1, int y1, int x2, int y2, bool force = false);
+  void removeHighlight();
+
   Ogre::Vector3 start_pos;
 
   rviz_default_plugins::tools::MoveTool * move_tool_;
@@ -79,6 +88,11 @@ private:
   rviz_common::interaction::M_Picked highlight_;
 
   bool moving_;
+
+  static constexpr std::chrono::milliseconds highlight_period_{33};
+  bool is_highlighted_{false};
+  std::array<int, 4> highlighted_rectangle_{};
+  std::chrono::steady_clock::time_point last_highlight_time_{};
 };
 
 }  // namespace rviz_plugins
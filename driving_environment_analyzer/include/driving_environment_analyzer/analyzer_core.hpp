@@ -15,13 +15,19 @@
 #ifndef DRIVING_ENVIRONMENT_ANALYZER__ANALYZER_CORE_HPP_
 #define DRIVING_ENVIRONMENT_ANALYZER__ANALYZER_CORE_HPP_
 
+#include "driving_environment_analyzer/map_cache.hpp"
 #include "driving_environment_analyzer/type_alias.hpp"
+#include "driving_environment_analyzer/utils.hpp"
 #include "rosbag2_cpp/reader.hpp"
 
+#include <autoware/bag_index/indexed_bag_reader.hpp>
 #include <autoware/route_handler/route_handler.hpp>
 #include <rclcpp/rclcpp.hpp>
 
+#include <functional>
 #include <memory>
+#include <ostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -42,34 +48,58 @@ struct ODDRawData
 class AnalyzerCore
 {
 public:
+  // called with the progress in [0, 1] of a long task, which is cancelled if it returns false
+  using ProgressCallback = std::function<bool(const double)>;
+
   explicit AnalyzerCore(rclcpp::Node & node);
+  // for the analyzers without a node, e.g. of the batch tool, which do not publish the profiles
+  explicit AnalyzerCore(const rclcpp::Logger & logger);
   ~AnalyzerCore();
 
+  void setProgressCallback(const ProgressCallback & callback) { progress_callback_ = callback; }
+
+  // the cache of the maps in the bags, which is shared with the other analyzers if set
+  void setMapCache(const std::shared_ptr<MapCache> & map_cache) { map_cache_ = map_cache; }
+
   bool isDataReadyForStaticODDAnalysis() const;
   bool isDataReadyForDynamicODDAnalysis() const { return odd_raw_data_.has_value(); }
 
   void analyzeStaticODDFactor() const;
-  void analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const;
+  void analyzeDynamicODDFactor(std::ostream & ofs_csv_file) const;
 
-  void addHeader(std::ofstream & ofs_csv_file) const;
+  // write a row of the static ODD factors of the route
+  void writeStaticODDFactor(std::ostream & ofs_csv_file) const;
 
-  void setBagFile(const std::string & file_name);
+  // write the rows of the dynamic ODD factors sampled at each period [s] of the whole bag
+  void analyzeDynamicODDFactorOverBag(
+    std::ostream & ofs_csv_file, const rcutils_time_point_value_t & period,
+    const size_t thread_num);
+
+  void addHeader(std::ostream & ofs_csv_file) const;
+  void addStaticHeader(std::ostream & ofs_csv_file) const;
+
+  // return false if the indexing of the bag is cancelled
+  bool setBagFile(const std::string & file_name);
 
   void setTimeStamp(const rcutils_time_point_value_t & timestamp)
   {
     odd_raw_data_ = getRawData(timestamp);
   }
 
-  void setMap(const LaneletMapBin & msg) { route_handler_.setMap(msg); }
+  // the route lanelets of the new map are looked up by the route handler, not by the index
+  void setMap(const LaneletMapBin & msg)
+  {
+    route_handler_.setMap(msg);
+    route_lanelet_index_ = utils::RouteLaneletIndex();
+  }
 
   void clearData() { odd_raw_data_ = std::nullopt; }
 
   std::pair<rcutils_time_point_value_t, rcutils_time_point_value_t> getBagStartEndTime()
   {
-    const auto metadata = reader_.get_metadata();
     const auto start_time =
-      duration_cast<seconds>(metadata.starting_time.time_since_epoch()).count();
-    const auto duration_time = duration_cast<seconds>(metadata.duration).count();
+      duration_cast<seconds>(bag_metadata_.starting_time.time_since_epoch()).count();
+    const auto duration_time = duration_cast<seconds>(bag_metadata_.duration).count();
     return {start_time, start_time + duration_time};
   }
 
@@ -83,18 +113,33 @@ private:
 
   double getEgoSpeed() const { return odd_raw_data_.value().odometry.twist.twist.linear.x; }
 
-  template <class T>
-  std::optional<T> getLastTopic(const std::string & topic_name);
   template <class T>
   std::optional<T> seekTopic(
     const std::string & topic_name, const rcutils_time_point_value_t & timestamp);
   std::optional<ODDRawData> getRawData(const rcutils_time_point_value_t & timestamp);
+  // lanelet_idx is the closest route lanelet of the previous sample, see RouteLaneletIndex
+  bool analyzeDynamicODDFactor(
+    const ODDRawData & odd_raw_data, std::ostream & ofs_csv_file, std::ostringstream & ss,
+    size_t & lanelet_idx) const;
+  bool reportProgress(const double progress) const
+  {
+    return !progress_callback_ || progress_callback_(progress);
+  }
 
   std::optional<ODDRawData> odd_raw_data_{std::nullopt};
 
   autoware::route_handler::RouteHandler route_handler_;
+  std::shared_ptr<MapCache> map_cache_;
+
+  // built in setBagFile with the route, empty if the route is not in the bag
+  utils::RouteLaneletIndex route_lanelet_index_;
+
+  // reads the messages through the index of the bag built in setBagFile, so that a seek is a
+  // binary search of the stamps and a single read
+  std::unique_ptr<autoware::bag_index::IndexedBagReader> bag_reader_;
+  rosbag2_storage::BagMetadata bag_metadata_;
 
-  rosbag2_cpp::Reader reader_;
+  ProgressCallback progress_callback_;
 
   rclcpp::Logger logger_;
 };
@@ -39,6 +39,11 @@ private:
   rclcpp::Subscription<LaneletMapBin>::SharedPtr sub_map_;
   rclcpp::TimerBase::SharedPtr timer_;
   rosbag2_cpp::Reader reader_;
+
+  bool analyze_dynamic_odd_factor_;
+  int dynamic_odd_sampling_period_;
+  int dynamic_odd_thread_num_;
+  std::string dynamic_odd_csv_path_;
 };
 }  // namespace driving_environment_analyzer
 
@@ -22,6 +22,7 @@
 #include <QFileDialog>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QProgressBar>
 #include <QPushButton>
 #include <QSlider>
 #include <QSpinBox>
@@ -32,8 +33,12 @@
 #include <rviz_common/view_manager.hpp>
 #include <rviz_rendering/render_window.hpp>
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace driving_environment_analyzer
@@ -56,12 +61,37 @@ public Q_SLOTS:
   void onSelectDirectory();
   void onClickAnalyzeStaticODDFactor();
   void onClickAnalyzeDynamicODDFactor();
+  void onClickAnalyzeWholeBag();
+  void onClickCancel();
+  void onJobProgress(int percent);
+  void onJobFinished(bool is_succeeded);
+
+Q_SIGNALS:
+  // emitted by the job thread, and received by the panel in the Qt thread
+  void jobProgress(int percent);
+  void jobFinished(bool is_succeeded);
 
 private:
   void onMap(const LaneletMapBin::ConstSharedPtr map_msg);
+  void loadBag(const std::string & bag_path, const std::string & csv_path);
+
+  /**
+   * @brief run a job of the analyzer in the job thread, so that the panel is not blocked. The
+   * job returns false if it fails or is cancelled, and on_finished is called in the Qt thread.
+   */
+  void startJob(
+    const QString & name, const std::function<bool()> & job,
+    const std::function<void(bool)> & on_finished = nullptr);
+  void setButtonsEnabled(const bool enabled);
 
   std::shared_ptr<analyzer_core::AnalyzerCore> analyzer_;
 
+  // the analyzer is used by one job at a time, and by the map callback of the ros thread
+  std::mutex analyzer_mutex_;
+  std::thread job_thread_;
+  std::function<void(bool)> on_job_finished_;
+  std::atomic_bool is_cancel_requested_{false};
+
   std::ofstream ofs_csv_file_;
 
   QSpinBox * bag_time_selector_;
@@ -73,6 +103,10 @@ private:
   QPushButton * analyze_static_odd_button_;
   QPushButton * analyze_dynamic_odd_button_;
   QPushButton * set_timestamp_btn_;
+  QPushButton * analyze_whole_bag_button_;
+  QPushButton * cancel_button_;
+  QProgressBar * progress_bar_;
+  QLabel * job_label_;
 
   rclcpp::Node::SharedPtr raw_node_;
   rclcpp::Subscription<LaneletMapBin>::SharedPtr sub_map_;
@@ -0,0 +1,98 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DRIVING_ENVIRONMENT_ANALYZER__MAP_CACHE_HPP_
+#define DRIVING_ENVIRONMENT_ANALYZER__MAP_CACHE_HPP_
+
+#include "driving_environment_analyzer/type_alias.hpp"
+
+#include <autoware/route_handler/route_handler.hpp>
+
+#include <rcutils/types/uint8_array.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace driving_environment_analyzer
+{
+
+/**
+ * @brief route handlers of the maps shared by the analyzers of the bags. A map is identified by
+ * the hash and the size of its serialized message and is built once for the bags with the same
+ * map, and the copies of the route handler share the lanelet map and the routing graph, which are
+ * only read after they are built.
+ */
+class MapCache
+{
+public:
+  using RouteHandler = autoware::route_handler::RouteHandler;
+
+  struct MapKey
+  {
+    uint64_t hash;
+    size_t size;
+    bool operator==(const MapKey & other) const
+    {
+      return hash == other.hash && size == other.size;
+    }
+  };
+
+  /**
+   * @param [in] use_key_file whether the key of the map of a bag is saved in a file next to the
+   * bag, so that the map is not read from the bag again if it is already built
+   */
+  explicit MapCache(const bool use_key_file = true) : use_key_file_(use_key_file) {}
+
+  static MapKey getKey(const rcutils_uint8_array_t & serialized_map);
+
+  /**
+   * @brief the key saved for the map message of the bag recorded at the stamp in the file
+   * @return nullopt if the key file is disabled, missing or for another message
+   */
+  std::optional<MapKey> loadKey(const std::string & path, const int64_t stamp) const;
+  void saveKey(const std::string & path, const int64_t stamp, const MapKey & key) const;
+
+  bool contains(const MapKey & key) const;
+
+  /**
+   * @brief the route handler without a route of the map, which is built by the first of the
+   * callers from the map given by load_map
+   */
+  std::shared_ptr<const RouteHandler> getRouteHandler(
+    const MapKey & key, const std::function<LaneletMapBin()> & load_map);
+
+  // the number of the different maps built so far
+  size_t size() const;
+
+private:
+  struct MapKeyHash
+  {
+    size_t operator()(const MapKey & key) const { return static_cast<size_t>(key.hash); }
+  };
+
+  bool use_key_file_;
+  mutable std::mutex mutex_;
+  std::unordered_map<MapKey, std::shared_future<std::shared_ptr<const RouteHandler>>, MapKeyHash>
+    route_handlers_;
+};
+}  // namespace driving_environment_analyzer
+
+#endif  // DRIVING_ENVIRONMENT_ANALYZER__MAP_CACHE_HPP_
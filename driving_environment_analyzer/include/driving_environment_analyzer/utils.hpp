@@ -17,6 +17,12 @@
 
 #include "driving_environment_analyzer/type_alias.hpp"
 
+#include <autoware/universe_utils/geometry/boost_geometry.hpp>
+
+#include <boost/geometry/index/rtree.hpp>
+
+#include <limits>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,6 +31,80 @@ namespace driving_environment_analyzer::utils
 {
 using autoware::route_handler::RouteHandler;
 
+// attributes of a lanelet on the route, which are computed once for all the static ODD factors
+struct LaneletFeature
+{
+  lanelet::Id id;
+  double length;  // 3d length
+  double width;
+  std::optional<double> max_curvature;  // nullopt if the centerline has no point
+  std::optional<std::pair<double, double>> elevation;  // min and max
+  double speed_limit;
+  bool exist_same_direction_lane;
+  bool exist_opposite_direction_lane;
+  bool exist_traffic_light;
+  bool is_intersection;
+  bool exist_crosswalk;
+};
+
+/**
+ * @brief table of the lanelet features of a route. Each lanelet is scanned once, and the ODD
+ * factors are aggregated from the table without querying the route handler again.
+ */
+class RouteFeatures
+{
+public:
+  RouteFeatures(const lanelet::ConstLanelets & lanes, const RouteHandler & route_handler);
+
+  const std::vector<LaneletFeature> & getLaneletFeatures() const { return features_; }
+
+  double getRouteLength() const;
+  double getRouteLengthWithSameDirectionLane() const;
+  double getRouteLengthWithOppositeDirectionLane() const;
+  double getRouteLengthWithNoAdjacentLane() const;
+  double getMaxCurvature() const;
+  std::pair<double, double> getLaneWidth() const;
+  std::pair<double, double> getElevation() const;
+  std::pair<double, double> getSpeedLimit() const;
+  bool existTrafficLight() const;
+  bool existIntersection() const;
+  bool existCrosswalk() const;
+
+private:
+  std::vector<LaneletFeature> features_;
+};
+
+/**
+ * @brief lanelets of a route whose envelopes are indexed with an R-tree, built once for a route,
+ * so that the closest lanelet of a pose is searched among the lanelets around it instead of all
+ * the lanelets of the route.
+ */
+class RouteLaneletIndex
+{
+public:
+  RouteLaneletIndex() = default;
+
+  explicit RouteLaneletIndex(const lanelet::ConstLanelets & route_lanelets);
+
+  bool empty() const { return lanelets_.empty(); }
+
+  /**
+   * @brief the same lanelet as RouteHandler::getClosestLaneletWithinRoute. lanelet_idx is the
+   * closest lanelet of a nearby pose, e.g. the previous sample, as a starting point of the search,
+   * and is updated to the closest one of this pose.
+   */
+  bool getClosestLanelet(
+    const Pose & pose, lanelet::ConstLanelet * closest_lanelet, size_t & lanelet_idx) const;
+
+private:
+  using Box2d = autoware::universe_utils::Box2d;
+
+  lanelet::ConstLanelets lanelets_;
+  std::vector<lanelet::BasicPolygon2d> polygons_;
+  boost::geometry::index::rtree<std::pair<Box2d, size_t>, boost::geometry::index::rstar<16>>
+    rtree_;
+};
+
 template <class T>
 std::vector<double> calcElevationAngle(const T & points);
 
@@ -16,16 +16,44 @@
 
 #include "driving_environment_analyzer/utils.hpp"
 
+#include <autoware/profiling_utils/profiling_utils.hpp>
+#include <autoware_lanelet2_extension/utility/route_checker.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace driving_environment_analyzer::analyzer_core
 {
+namespace
+{
+const std::string route_topic = "/planning/mission_planning/route";
+const std::string map_topic = "/map/vector_map";
+const std::string odometry_topic = "/localization/kinematic_state";
+const std::string objects_topic = "/perception/object_recognition/objects";
+const std::string rtc_status_topic = "/api/external/get/rtc_status";
+const std::string tf_topic = "/tf";
+const std::string tf_static_topic = "/tf_static";
+}  // namespace
+
+AnalyzerCore::AnalyzerCore(rclcpp::Node & node)
+: map_cache_{std::make_shared<MapCache>()}, logger_{node.get_logger()}
+{
+  AUTOWARE_PROFILE_INIT(node);
+}
 
-AnalyzerCore::AnalyzerCore(rclcpp::Node & node) : logger_{node.get_logger()}
+AnalyzerCore::AnalyzerCore(const rclcpp::Logger & logger)
+: map_cache_{std::make_shared<MapCache>()}, logger_{logger}
 {
 }
 
@@ -44,95 +72,110 @@ bool AnalyzerCore::isDataReadyForStaticODDAnalysis() const
   return true;
 }
 
-void AnalyzerCore::setBagFile(const std::string & file_name)
+bool AnalyzerCore::setBagFile(const std::string & file_name)
 {
-  reader_.open(file_name);
-
-  const auto opt_route = getLastTopic<LaneletRoute>("/planning/mission_planning/route");
-  if (opt_route.has_value()) {
-    route_handler_.setRoute(opt_route.value());
+  AUTOWARE_PROFILE_FUNCTION();
+  {
+    rosbag2_cpp::Reader reader;
+    reader.open(file_name);
+    bag_metadata_ = reader.get_metadata();
   }
 
-  const auto opt_map = getLastTopic<LaneletMapBin>("/map/vector_map");
-  if (opt_map.has_value()) {
-    route_handler_.setMap(opt_map.value());
+  // The index is cached next to the bag, and the split files are indexed in parallel
+  const auto index = autoware::bag_index::BagIndex::loadOrBuild(
+    file_name,
+    {route_topic, map_topic, odometry_topic, objects_topic, rtc_status_topic, tf_topic,
+     tf_static_topic},
+    std::max(std::thread::hardware_concurrency(), 1u),
+    [this](const double progress) { return reportProgress(progress); });
+  if (!index.has_value()) {
+    bag_reader_.reset();
+    return false;
   }
-}
-
-template <class T>
-std::optional<T> AnalyzerCore::getLastTopic(const std::string & topic_name)
-{
-  rosbag2_storage::StorageFilter filter;
-  filter.topics.emplace_back(topic_name);
-  reader_.set_filter(filter);
-
-  if (!reader_.has_next()) {
-    return std::nullopt;
+  bag_reader_ = std::make_unique<autoware::bag_index::IndexedBagReader>(
+    std::make_shared<const autoware::bag_index::BagIndex>(index.value()));
+
+  // The map is taken from the cache if it is in another bag loaded before, and is not even read
+  // if its key is saved next to the bag. The route is set after the map, since the cached route
+  // handler replaces the whole handler.
+  const auto map_entry = bag_reader_->getIndex().last(map_topic);
+  if (map_entry.has_value()) {
+    const auto key_path = autoware::bag_index::BagIndex::getCachePath(file_name) + ".map_key";
+    auto key = map_cache_->loadKey(key_path, map_entry->stamp);
+    autoware::bag_index::SerializedBagMessagePtr serialized_map;
+    if (!key.has_value() || !map_cache_->contains(key.value())) {
+      serialized_map = bag_reader_->readLast(map_topic);
+      key = MapCache::getKey(*serialized_map->serialized_data);
+      map_cache_->saveKey(key_path, map_entry->stamp, key.value());
+    }
+    route_handler_ = *map_cache_->getRouteHandler(key.value(), [&]() {
+      if (!serialized_map) {
+        serialized_map = bag_reader_->readLast(map_topic);
+      }
+      return autoware::bag_index::deserialize<LaneletMapBin>(*serialized_map);
+    });
   }
 
-  rclcpp::Serialization<T> serializer;
+  const auto opt_route = bag_reader_->readLastMessage<LaneletRoute>(route_topic);
+  route_lanelet_index_ = utils::RouteLaneletIndex();
+  if (opt_route.has_value()) {
+    route_handler_.setRoute(opt_route.value());
 
-  const auto deserialized_message = std::make_shared<T>();
-  while (reader_.has_next()) {
-    rclcpp::SerializedMessage serialized_msg(*reader_.read_next()->serialized_data);
-    serializer.deserialize_message(&serialized_msg, deserialized_message.get());
+    // the lanelets in the same order as those of the route handler
+    const auto map_ptr = route_handler_.getLaneletMapPtr();
+    if (map_ptr && lanelet::utils::route::isRouteValid(opt_route.value(), map_ptr)) {
+      lanelet::ConstLanelets route_lanelets;
+      for (const auto & segment : opt_route->segments) {
+        for (const auto & primitive : segment.primitives) {
+          route_lanelets.push_back(map_ptr->laneletLayer.get(primitive.id));
+        }
+      }
+      route_lanelet_index_ = utils::RouteLaneletIndex(route_lanelets);
+    }
   }
 
-  return *deserialized_message;
+  return true;
 }
 
 template <class T>
 std::optional<T> AnalyzerCore::seekTopic(
   const std::string & topic_name, const rcutils_time_point_value_t & timestamp)
 {
-  rosbag2_storage::StorageFilter filter;
-  filter.topics.emplace_back(topic_name);
-  reader_.set_filter(filter);
-
-  rclcpp::Serialization<T> serializer;
-  reader_.seek(timestamp);
-
-  if (!reader_.has_next()) {
+  if (!bag_reader_) {
     return std::nullopt;
   }
-
-  rclcpp::SerializedMessage serialized_msg(*reader_.read_next()->serialized_data);
-  const auto deserialized_message = std::make_shared<T>();
-  serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-
-  return *deserialized_message;
+  return bag_reader_->readMessageAt<T>(topic_name, timestamp);
 }
 
 std::optional<ODDRawData> AnalyzerCore::getRawData(const rcutils_time_point_value_t & timestamp)
 {
+  AUTOWARE_PROFILE_FUNCTION();
   ODDRawData odd_raw_data;
 
   odd_raw_data.timestamp = timestamp;
 
-  const auto opt_odometry = seekTopic<Odometry>("/localization/kinematic_state", timestamp * 1e9);
+  const auto opt_odometry = seekTopic<Odometry>(odometry_topic, timestamp * 1e9);
   if (!opt_odometry.has_value()) {
     return std::nullopt;
   } else {
     odd_raw_data.odometry = opt_odometry.value();
   }
 
-  const auto opt_objects =
-    seekTopic<PredictedObjects>("/perception/object_recognition/objects", timestamp * 1e9);
+  const auto opt_objects = seekTopic<PredictedObjects>(objects_topic, timestamp * 1e9);
   if (!opt_objects.has_value()) {
     return std::nullopt;
   } else {
     odd_raw_data.objects = opt_objects.value();
   }
 
-  const auto opt_rtc_status =
-    seekTopic<CooperateStatusArray>("/api/external/get/rtc_status", timestamp * 1e9);
+  const auto opt_rtc_status = seekTopic<CooperateStatusArray>(rtc_status_topic, timestamp * 1e9);
   if (!opt_rtc_status.has_value()) {
     return std::nullopt;
   } else {
     odd_raw_data.rtc_status = opt_rtc_status.value();
   }
 
-  const auto opt_tf = seekTopic<TFMessage>("/tf", timestamp * 1e9);
+  const auto opt_tf = seekTopic<TFMessage>(tf_topic, timestamp * 1e9);
   if (!opt_tf.has_value()) {
     return std::nullopt;
   } else {
@@ -140,7 +183,7 @@ std::optional<ODDRawData> AnalyzerCore::getRawData(const rcutils_time_point_valu
   }
 
   const auto [start_time, end_time] = getBagStartEndTime();
-  const auto opt_tf_static = seekTopic<TFMessage>("/tf_static", start_time * 1e9);
+  const auto opt_tf_static = seekTopic<TFMessage>(tf_static_topic, start_time * 1e9);
   if (!opt_tf_static.has_value()) {
     return std::nullopt;
   } else {
@@ -150,7 +193,7 @@ std::optional<ODDRawData> AnalyzerCore::getRawData(const rcutils_time_point_valu
   return odd_raw_data;
 }
 
-void AnalyzerCore::addHeader(std::ofstream & ofs_csv_file) const
+void AnalyzerCore::addHeader(std::ostream & ofs_csv_file) const
 {
   ofs_csv_file << "TIME" << ',';
   ofs_csv_file << "EGO [SPEED]" << ',';
@@ -183,9 +226,138 @@ void AnalyzerCore::addHeader(std::ofstream & ofs_csv_file) const
   ofs_csv_file << std::endl;
 }
 
-void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
+void AnalyzerCore::addStaticHeader(std::ostream & ofs_csv_file) const
+{
+  ofs_csv_file << "ROUTE [LENGTH]" << ',';
+  ofs_csv_file << "ROUTE [SAME DIRECTION LANE LENGTH]" << ',';
+  ofs_csv_file << "ROUTE [OPPOSITE DIRECTION LANE LENGTH]" << ',';
+  ofs_csv_file << "ROUTE [NO ADJACENT LANE LENGTH]" << ',';
+  ofs_csv_file << "ROUTE [TRAFFIC LIGHT]" << ',';
+  ofs_csv_file << "ROUTE [INTERSECTION]" << ',';
+  ofs_csv_file << "ROUTE [CROSSWALK]" << ',';
+  ofs_csv_file << "LANE WIDTH [MIN]" << ',';
+  ofs_csv_file << "LANE WIDTH [MAX]" << ',';
+  ofs_csv_file << "LANE CURVATURE [MAX]" << ',';
+  ofs_csv_file << "ELEVATION ANGLE [MIN]" << ',';
+  ofs_csv_file << "ELEVATION ANGLE [MAX]" << ',';
+  ofs_csv_file << "SPEED LIMIT [MIN]" << ',';
+  ofs_csv_file << "SPEED LIMIT [MAX]" << ',';
+  ofs_csv_file << std::endl;
+}
+
+void AnalyzerCore::analyzeDynamicODDFactor(std::ostream & ofs_csv_file) const
 {
   std::ostringstream ss;
+  size_t lanelet_idx = std::numeric_limits<size_t>::max();
+  if (analyzeDynamicODDFactor(odd_raw_data_.value(), ofs_csv_file, ss, lanelet_idx)) {
+    RCLCPP_INFO_STREAM(logger_, ss.str());
+  }
+}
+
+void AnalyzerCore::analyzeDynamicODDFactorOverBag(
+  std::ostream & ofs_csv_file, const rcutils_time_point_value_t & period,
+  const size_t thread_num)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  const auto [start_time, end_time] = getBagStartEndTime();
+  const auto step = std::max<rcutils_time_point_value_t>(period, 1);
+  const size_t sample_num = static_cast<size_t>((end_time - start_time) / step) + 1;
+
+  // The reader is used only by the reader thread, and the rows are computed by the workers from
+  // the extracted data. The main thread writes the rows in the order of the samples.
+  constexpr size_t max_queue_size = 64;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::pair<size_t, std::optional<ODDRawData>>> queue;
+  std::map<size_t, std::optional<std::string>> rows;
+  bool is_reading_done = false;
+  bool is_cancelled = false;
+
+  std::thread reader_thread([&]() {
+    for (size_t i = 0; i < sample_num; ++i) {
+      auto data = getRawData(start_time + static_cast<rcutils_time_point_value_t>(i) * step);
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]() { return queue.size() < max_queue_size || is_cancelled; });
+      if (is_cancelled) {
+        break;
+      }
+      queue.emplace_back(i, std::move(data));
+      cv.notify_all();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    is_reading_done = true;
+    cv.notify_all();
+  });
+
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::max<size_t>(thread_num, 1); ++i) {
+    workers.emplace_back([&]() {
+      // the samples of a worker are close to each other, so the closest lanelet of the previous
+      // one starts the search
+      size_t lanelet_idx = std::numeric_limits<size_t>::max();
+      while (true) {
+        std::pair<size_t, std::optional<ODDRawData>> sample;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&]() { return !queue.empty() || is_reading_done || is_cancelled; });
+          if (queue.empty() || is_cancelled) {
+            return;
+          }
+          sample = std::move(queue.front());
+          queue.pop_front();
+          cv.notify_all();
+        }
+        // the samples without data or without the closest lanelet have no row
+        std::optional<std::string> row;
+        if (sample.second.has_value()) {
+          std::ostringstream csv_row;
+          std::ostringstream ss;
+          if (analyzeDynamicODDFactor(sample.second.value(), csv_row, ss, lanelet_idx)) {
+            row = csv_row.str();
+          }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        rows[sample.first] = std::move(row);
+        cv.notify_all();
+      }
+    });
+  }
+
+  size_t row_num = 0;
+  for (size_t i = 0; i < sample_num; ++i) {
+    if (!reportProgress(static_cast<double>(i) / sample_num)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      is_cancelled = true;
+      cv.notify_all();
+      break;
+    }
+    std::optional<std::string> row;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]() { return rows.count(i) != 0; });
+      row = std::move(rows.at(i));
+      rows.erase(i);
+    }
+    if (row.has_value()) {
+      ofs_csv_file << row.value();
+      ++row_num;
+    }
+  }
+
+  reader_thread.join();
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  RCLCPP_INFO(
+    logger_, "Wrote %zu rows of dynamic ODD factors for %zu samples.", row_num, sample_num);
+}
+
+bool AnalyzerCore::analyzeDynamicODDFactor(
+  const ODDRawData & odd_raw_data, std::ostream & ofs_csv_file, std::ostringstream & ss,
+  size_t & lanelet_idx) const
+{
+  AUTOWARE_PROFILE_FUNCTION();
   ss << std::boolalpha << "\n";
   ss << "***********************************************************\n";
   ss << "                   ODD analysis result\n";
@@ -198,23 +370,30 @@ void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
   };
 
   char buffer[128];
-  auto seconds = static_cast<time_t>(odd_raw_data_.value().timestamp);
-  strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+  auto seconds = static_cast<time_t>(odd_raw_data.timestamp);
+  struct tm local_time;
+  localtime_r(&seconds, &local_time);
+  strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local_time);
   ss << "Time: " << write(buffer) << "\n";
   ss << "\n";
   ss << "\n";
 
+  const auto & ego_pose = odd_raw_data.odometry.pose.pose;
   lanelet::ConstLanelet closest_lanelet;
-  if (!route_handler_.getClosestLaneletWithinRoute(getEgoPose(), &closest_lanelet)) {
-    return;
+  const bool is_found =
+    route_lanelet_index_.empty()
+      ? route_handler_.getClosestLaneletWithinRoute(ego_pose, &closest_lanelet)
+      : route_lanelet_index_.getClosestLanelet(ego_pose, &closest_lanelet, lanelet_idx);
+  if (!is_found) {
+    return false;
   }
 
-  const auto number = [this](const auto & target_class) {
-    return utils::getObjectNumber(odd_raw_data_.value().objects, target_class);
+  const auto number = [&odd_raw_data](const auto & target_class) {
+    return utils::getObjectNumber(odd_raw_data.objects, target_class);
   };
 
-  const auto status = [this](const auto & module_type) {
-    return utils::getModuleStatus(odd_raw_data_.value().rtc_status, module_type);
+  const auto status = [&odd_raw_data](const auto & module_type) {
+    return utils::getModuleStatus(odd_raw_data.rtc_status, module_type);
   };
 
   const auto exist_crosswalk = [this, &closest_lanelet]() {
@@ -224,9 +403,10 @@ void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
   const auto to_string = [](const bool exist) { return exist ? "EXIST" : "NONE"; };
 
   ss << "- EGO INFO\n";
-  ss << "  [SPEED]                       : " << write(getEgoSpeed()) << " [m/s]\n";
+  ss << "  [SPEED]                       : "
+     << write(odd_raw_data.odometry.twist.twist.linear.x) << " [m/s]\n";
   ss << "  [ELEVATION ANGLE]             : "
-     << write(utils::calcElevationAngle(closest_lanelet, getEgoPose())) << " [rad]\n";
+     << write(utils::calcElevationAngle(closest_lanelet, ego_pose)) << " [rad]\n";
   ss << "\n";
 
   ss << "- EGO BEHAVIOR\n";
@@ -238,7 +418,7 @@ void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
   ss << "  [GOAL_PLANNER]                : " << write(status(Module::GOAL_PLANNER)) << "\n";
   ss << "  [CROSSWALK]                   : " << write(exist_crosswalk()) << "\n";
   ss << "  [INTERSECTION]                : "
-     << write(utils::getEgoBehavior(closest_lanelet, route_handler_, getEgoPose())) << "\n";
+     << write(utils::getEgoBehavior(closest_lanelet, route_handler_, ego_pose)) << "\n";
   ss << "\n";
 
   ss << "- LANE INFO\n";
@@ -280,7 +460,7 @@ void AnalyzerCore::analyzeDynamicODDFactor(std::ofstream & ofs_csv_file) const
 
   ofs_csv_file << std::endl;
 
-  RCLCPP_INFO_STREAM(logger_, ss.str());
+  return true;
 }
 
 void AnalyzerCore::analyzeStaticODDFactor() const
@@ -294,45 +474,41 @@ void AnalyzerCore::analyzeStaticODDFactor() const
   ss << "\n";
   ss << "\n";
 
-  const auto preferred_lanes = route_handler_.getPreferredLanelets();
+  // The lanelets are scanned once, and every factor is read from the table
+  const utils::RouteFeatures features(route_handler_.getPreferredLanelets(), route_handler_);
   ss << "- ROUTE INFO\n";
-  ss << "  total length                      : " << utils::getRouteLength(preferred_lanes)
-     << " [m]\n";
+  ss << "  total length                      : " << features.getRouteLength() << " [m]\n";
   ss << "  exist same direction lane section : "
-     << utils::getRouteLengthWithSameDirectionLane(preferred_lanes, route_handler_) << " [m]\n";
+     << features.getRouteLengthWithSameDirectionLane() << " [m]\n";
   ss << "  exist same opposite lane section  : "
-     << utils::getRouteLengthWithOppositeDirectionLane(preferred_lanes, route_handler_) << " [m]\n";
-  ss << "  no adjacent lane section          : "
-     << utils::getRouteLengthWithNoAdjacentLane(preferred_lanes, route_handler_) << " [m]\n";
+     << features.getRouteLengthWithOppositeDirectionLane() << " [m]\n";
+  ss << "  no adjacent lane section          : " << features.getRouteLengthWithNoAdjacentLane()
+     << " [m]\n";
 
-  ss << "  exist traffic light               : " << utils::existTrafficLight(preferred_lanes)
-     << "\n";
-  ss << "  exist intersection                : " << utils::existIntersection(preferred_lanes)
-     << "\n";
-  ss << "  exist crosswalk                   : "
-     << utils::existCrosswalk(preferred_lanes, route_handler_) << "\n";
+  ss << "  exist traffic light               : " << features.existTrafficLight() << "\n";
+  ss << "  exist intersection                : " << features.existIntersection() << "\n";
+  ss << "  exist crosswalk                   : " << features.existCrosswalk() << "\n";
   ss << "\n";
 
-  const auto [min_width, max_width] = utils::getLaneWidth(preferred_lanes);
+  const auto [min_width, max_width] = features.getLaneWidth();
   ss << "- LANE WIDTH\n";
   ss << "  max                               : " << max_width << " [m]\n";
   ss << "  min                               : " << min_width << " [m]\n";
   ss << "\n";
 
-  const auto max_curvature = utils::getMaxCurvature(preferred_lanes);
+  const auto max_curvature = features.getMaxCurvature();
   ss << "- LANE CURVATURE\n";
   ss << "  max                               : " << max_curvature << " [1/m]\n";
   ss << "  max                               : " << 1.0 / max_curvature << " [m]\n";
   ss << "\n";
 
-  const auto [min_elevation, max_elevation] = utils::getElevation(preferred_lanes);
+  const auto [min_elevation, max_elevation] = features.getElevation();
   ss << "- ELEVATION ANGLE\n";
   ss << "  max                               : " << max_elevation << " [rad]\n";
   ss << "  min                               : " << min_elevation << " [rad]\n";
   ss << "\n";
 
-  const auto [min_speed_limit, max_speed_limit] =
-    utils::getSpeedLimit(preferred_lanes, route_handler_);
+  const auto [min_speed_limit, max_speed_limit] = features.getSpeedLimit();
   ss << "- SPEED LIMIT\n";
   ss << "  max                               : " << max_speed_limit << " [m/s]\n";
   ss << "  min                               : " << min_speed_limit << " [m/s]\n";
@@ -343,5 +519,26 @@ void AnalyzerCore::analyzeStaticODDFactor() const
   RCLCPP_INFO_STREAM(logger_, ss.str());
 }
 
+void AnalyzerCore::writeStaticODDFactor(std::ostream & ofs_csv_file) const
+{
+  const utils::RouteFeatures features(route_handler_.getPreferredLanelets(), route_handler_);
+  const auto to_string = [](const bool exist) { return exist ? "EXIST" : "NONE"; };
+  const auto [min_width, max_width] = features.getLaneWidth();
+  const auto [min_elevation, max_elevation] = features.getElevation();
+  const auto [min_speed_limit, max_speed_limit] = features.getSpeedLimit();
+  ofs_csv_file << features.getRouteLength() << ',';
+  ofs_csv_file << features.getRouteLengthWithSameDirectionLane() << ',';
+  ofs_csv_file << features.getRouteLengthWithOppositeDirectionLane() << ',';
+  ofs_csv_file << features.getRouteLengthWithNoAdjacentLane() << ',';
+  ofs_csv_file << to_string(features.existTrafficLight()) << ',';
+  ofs_csv_file << to_string(features.existIntersection()) << ',';
+  ofs_csv_file << to_string(features.existCrosswalk()) << ',';
+  ofs_csv_file << min_width << ',' << max_width << ',';
+  ofs_csv_file << features.getMaxCurvature() << ',';
+  ofs_csv_file << min_elevation << ',' << max_elevation << ',';
+  ofs_csv_file << min_speed_limit << ',' << max_speed_limit << ',';
+  ofs_csv_file << std::endl;
+}
+
 AnalyzerCore::~AnalyzerCore() = default;
 }  // namespace driving_environment_analyzer::analyzer_core
@@ -0,0 +1,192 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Analyze the static and dynamic ODD factors of rosbag2 files without RViz. The bags are analyzed
+// by parallel threads, which share the maps through a MapCache so that a map recorded in several
+// bags is built once. The rows of all the bags are written in a static and a dynamic CSV, with the
+// bag in the first column.
+
+#include "driving_environment_analyzer/analyzer_core.hpp"
+#include "driving_environment_analyzer/map_cache.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using driving_environment_analyzer::MapCache;
+using driving_environment_analyzer::analyzer_core::AnalyzerCore;
+
+struct BagResult
+{
+  std::string static_row;
+  std::string dynamic_rows;
+};
+
+struct BagSlot
+{
+  bool is_done = false;
+  std::optional<BagResult> result;  // nullopt if the bag is failed or the result is written
+};
+
+// the rows with the bag in the first column
+std::string addBagColumn(const std::string & rows, const std::string & bag_path)
+{
+  std::ostringstream ss;
+  std::istringstream is(rows);
+  for (std::string line; std::getline(is, line);) {
+    ss << bag_path << ',' << line << '\n';
+  }
+  return ss.str();
+}
+
+// nullopt if the bag cannot be read or does not have the map and the route
+std::optional<BagResult> processBag(
+  const std::string & bag_path, const std::shared_ptr<MapCache> & map_cache,
+  const rcutils_time_point_value_t period, const size_t thread_num)
+{
+  AnalyzerCore analyzer(rclcpp::get_logger("driving_environment_analyzer_batch_tool"));
+  analyzer.setMapCache(map_cache);
+  if (!analyzer.setBagFile(bag_path) || !analyzer.isDataReadyForStaticODDAnalysis()) {
+    return std::nullopt;
+  }
+
+  std::ostringstream static_row;
+  analyzer.writeStaticODDFactor(static_row);
+  std::ostringstream dynamic_rows;
+  analyzer.analyzeDynamicODDFactorOverBag(dynamic_rows, period, thread_num);
+  return BagResult{
+    addBagColumn(static_row.str(), bag_path), addBagColumn(dynamic_rows.str(), bag_path)};
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t num_workers = 1;
+  size_t thread_num = 1;
+  rcutils_time_point_value_t period = 1;
+  bool use_map_key_file = true;
+  std::vector<std::string> positional_args;
+  std::vector<std::string> listed_bag_paths;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      num_workers = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg == "-t" && i + 1 < argc) {
+      thread_num = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg == "-s" && i + 1 < argc) {
+      period = std::max(std::stol(argv[++i]), 1l);
+    } else if (arg == "--no-map-key-file") {
+      use_map_key_file = false;
+    } else if (arg == "-l" && i + 1 < argc) {
+      // a file listing the bags, one per line
+      std::ifstream list_file(argv[++i]);
+      if (!list_file) {
+        std::cerr << "Failed to open " << argv[i] << std::endl;
+        return 1;
+      }
+      for (std::string line; std::getline(list_file, line);) {
+        if (!line.empty()) {
+          listed_bag_paths.push_back(line);
+        }
+      }
+    } else {
+      positional_args.push_back(arg);
+    }
+  }
+  if (positional_args.empty() || positional_args.size() + listed_bag_paths.size() < 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [-j num_workers] [-t thread_num] [-s period] [-l bag_list] [--no-map-key-file]"
+                 " <output_prefix> [rosbag_path]..."
+              << std::endl;
+    return 1;
+  }
+  const std::string output_prefix = positional_args.front();
+  std::vector<std::string> bag_paths(positional_args.begin() + 1, positional_args.end());
+  bag_paths.insert(bag_paths.end(), listed_bag_paths.begin(), listed_bag_paths.end());
+
+  const std::string static_output_path = output_prefix + "_static.csv";
+  const std::string dynamic_output_path = output_prefix + "_dynamic.csv";
+  std::ofstream static_output(static_output_path);
+  std::ofstream dynamic_output(dynamic_output_path);
+  if (!static_output || !dynamic_output) {
+    std::cerr << "Failed to open " << static_output_path << " or " << dynamic_output_path
+              << std::endl;
+    return 1;
+  }
+  {
+    const AnalyzerCore header_writer(rclcpp::get_logger("driving_environment_analyzer_batch_tool"));
+    static_output << "BAG" << ',';
+    header_writer.addStaticHeader(static_output);
+    dynamic_output << "BAG" << ',';
+    header_writer.addHeader(dynamic_output);
+  }
+
+  // The workers take the bags in order, and the results are written in the order of the bags as
+  // soon as the preceding bags are done, so that the rows of all the bags are not kept
+  const auto map_cache = std::make_shared<MapCache>(use_map_key_file);
+  std::atomic<size_t> next_bag{0};
+  std::mutex mutex;
+  std::vector<BagSlot> slots(bag_paths.size());
+  size_t next_write = 0;
+  size_t num_succeeded = 0;
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::min(num_workers, bag_paths.size()); ++i) {
+    workers.emplace_back([&]() {
+      for (size_t j = next_bag++; j < bag_paths.size(); j = next_bag++) {
+        std::optional<BagResult> result;
+        try {
+          result = processBag(bag_paths[j], map_cache, period, thread_num);
+        } catch (const std::exception & e) {
+          std::cerr << bag_paths[j] << ": " << e.what() << std::endl;
+        }
+        if (!result.has_value()) {
+          std::cerr << "Failed to analyze " << bag_paths[j] << std::endl;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        slots[j].is_done = true;
+        slots[j].result = std::move(result);
+        for (; next_write < slots.size() && slots[next_write].is_done; ++next_write) {
+          auto & slot = slots[next_write];
+          if (slot.result.has_value()) {
+            static_output << slot.result->static_row;
+            dynamic_output << slot.result->dynamic_rows;
+            slot.result.reset();
+            ++num_succeeded;
+          }
+        }
+      }
+    });
+  }
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  std::cout << "Analyzed " << num_succeeded << "/" << bag_paths.size() << " bags with "
+            << map_cache->size() << " maps, wrote " << static_output_path << " and "
+            << dynamic_output_path << std::endl;
+  return num_succeeded == bag_paths.size() ? 0 : 1;
+}
@@ -16,6 +16,8 @@
 
 #include "driving_environment_analyzer/analyzer_core.hpp"
 
+#include <algorithm>
+#include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
@@ -39,7 +41,17 @@ DrivingEnvironmentAnalyzerNode::DrivingEnvironmentAnalyzerNode(
 
   analyzer_ = std::make_shared<analyzer_core::AnalyzerCore>(*this);
 
-  analyzer_->setBagFile(declare_parameter<std::string>("bag_path"));
+  const auto bag_path = declare_parameter<std::string>("bag_path");
+  analyzer_->setBagFile(bag_path);
+
+  // the dynamic ODD factors of the whole bag are also written in a CSV, if enabled
+  analyze_dynamic_odd_factor_ = declare_parameter<bool>("analyze_dynamic_odd_factor", false);
+  dynamic_odd_sampling_period_ = declare_parameter<int>("dynamic_odd_sampling_period", 1);
+  dynamic_odd_thread_num_ = declare_parameter<int>("dynamic_odd_thread_num", 4);
+  dynamic_odd_csv_path_ = declare_parameter<std::string>("dynamic_odd_csv_path", "");
+  if (dynamic_odd_csv_path_.empty()) {
+    dynamic_odd_csv_path_ = bag_path + "_odd.csv";
+  }
 }
 
 void DrivingEnvironmentAnalyzerNode::onMap(const LaneletMapBin::ConstSharedPtr msg)
@@ -54,6 +66,13 @@ void DrivingEnvironmentAnalyzerNode::analyze()
   }
 
   analyzer_->analyzeStaticODDFactor();
+
+  if (analyze_dynamic_odd_factor_) {
+    std::ofstream ofs_csv_file(dynamic_odd_csv_path_);
+    analyzer_->addHeader(ofs_csv_file);
+    analyzer_->analyzeDynamicODDFactorOverBag(
+      ofs_csv_file, dynamic_odd_sampling_period_, std::max(dynamic_odd_thread_num_, 1));
+  }
   rclcpp::shutdown();
 }
 }  // namespace driving_environment_analyzer
@@ -16,6 +16,7 @@
 
 #include "driving_environment_analyzer/analyzer_core.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -94,6 +95,33 @@ DrivingEnvironmentAnalyzerPanel::DrivingEnvironmentAnalyzerPanel(QWidget * paren
     v_layout->addWidget(bag_time_slider_);
   }
 
+  {
+    auto * layout = new QHBoxLayout(this);
+
+    // add button to analyze the dynamic ODD factors of the whole bag.
+    analyze_whole_bag_button_ = new QPushButton("Analyze whole bag");
+    connect(analyze_whole_bag_button_, SIGNAL(clicked()), SLOT(onClickAnalyzeWholeBag()));
+    layout->addWidget(analyze_whole_bag_button_);
+
+    // add progress bar and button to cancel the running job.
+    job_label_ = new QLabel();
+    layout->addWidget(job_label_);
+    progress_bar_ = new QProgressBar();
+    progress_bar_->setRange(0, 100);
+    progress_bar_->setValue(0);
+    layout->addWidget(progress_bar_);
+    cancel_button_ = new QPushButton("Cancel");
+    cancel_button_->setEnabled(false);
+    connect(cancel_button_, SIGNAL(clicked()), SLOT(onClickCancel()));
+    layout->addWidget(cancel_button_);
+
+    v_layout->addLayout(layout);
+  }
+
+  // the signals of the job thread are delivered in the Qt thread
+  connect(this, SIGNAL(jobProgress(int)), SLOT(onJobProgress(int)), Qt::QueuedConnection);
+  connect(this, SIGNAL(jobFinished(bool)), SLOT(onJobFinished(bool)), Qt::QueuedConnection);
+
   {
     bag_name_label_ = new QLabel();
     bag_name_label_->setAlignment(Qt::AlignLeft);
@@ -124,13 +152,112 @@ void DrivingEnvironmentAnalyzerPanel::onInitialize()
   pub_tf_static_ = raw_node_->create_publisher<TFMessage>("/tf_static", rclcpp::QoS(1));
 
   analyzer_ = std::make_shared<analyzer_core::AnalyzerCore>(*raw_node_);
+  analyzer_->setProgressCallback([this](const double progress) {
+    Q_EMIT jobProgress(static_cast<int>(std::clamp(progress, 0.0, 1.0) * 100.0));
+    return !is_cancel_requested_;
+  });
 }
 
 void DrivingEnvironmentAnalyzerPanel::onMap(const LaneletMapBin::ConstSharedPtr msg)
 {
+  std::lock_guard<std::mutex> lock(analyzer_mutex_);
   analyzer_->setMap(*msg);
 }
 
+void DrivingEnvironmentAnalyzerPanel::startJob(
+  const QString & name, const std::function<bool()> & job,
+  const std::function<void(bool)> & on_finished)
+{
+  if (job_thread_.joinable()) {
+    return;
+  }
+
+  setButtonsEnabled(false);
+  cancel_button_->setEnabled(true);
+  job_label_->setText(name);
+  progress_bar_->setValue(0);
+  is_cancel_requested_ = false;
+  on_job_finished_ = on_finished;
+
+  job_thread_ = std::thread([this, job]() {
+    bool is_succeeded = false;
+    {
+      std::lock_guard<std::mutex> lock(analyzer_mutex_);
+      is_succeeded = job();
+    }
+    Q_EMIT jobFinished(is_succeeded && !is_cancel_requested_);
+  });
+}
+
+void DrivingEnvironmentAnalyzerPanel::onJobProgress(int percent)
+{
+  progress_bar_->setValue(percent);
+}
+
+void DrivingEnvironmentAnalyzerPanel::onJobFinished(bool is_succeeded)
+{
+  if (job_thread_.joinable()) {
+    job_thread_.join();
+  }
+
+  const auto status = is_succeeded ? " done" : (is_cancel_requested_ ? " cancelled" : " failed");
+  job_label_->setText(job_label_->text() + status);
+  if (is_succeeded) {
+    progress_bar_->setValue(100);
+  }
+  cancel_button_->setEnabled(false);
+  setButtonsEnabled(true);
+
+  if (on_job_finished_) {
+    on_job_finished_(is_succeeded);
+    on_job_finished_ = nullptr;
+  }
+}
+
+void DrivingEnvironmentAnalyzerPanel::onClickCancel()
+{
+  is_cancel_requested_ = true;
+}
+
+void DrivingEnvironmentAnalyzerPanel::setButtonsEnabled(const bool enabled)
+{
+  file_button_ptr_->setEnabled(enabled);
+  dir_button_ptr_->setEnabled(enabled);
+  set_timestamp_btn_->setEnabled(enabled);
+  analyze_static_odd_button_->setEnabled(enabled);
+  analyze_dynamic_odd_button_->setEnabled(enabled);
+  analyze_whole_bag_button_->setEnabled(enabled);
+}
+
+void DrivingEnvironmentAnalyzerPanel::loadBag(
+  const std::string & bag_path, const std::string & csv_path)
+{
+  const auto name = QString::fromStdString(bag_path);
+  startJob(
+    "Loading",
+    [this, bag_path]() {
+      try {
+        return analyzer_->setBagFile(bag_path);
+      } catch (const std::exception & e) {
+        RCLCPP_ERROR(raw_node_->get_logger(), "Failed to load %s: %s", bag_path.c_str(), e.what());
+        return false;
+      }
+    },
+    [this, name, csv_path](const bool is_succeeded) {
+      if (!is_succeeded) {
+        return;
+      }
+      std::lock_guard<std::mutex> lock(analyzer_mutex_);
+      ofs_csv_file_ = std::ofstream(csv_path);
+      analyzer_->addHeader(ofs_csv_file_);
+
+      const auto [start_time, end_time] = analyzer_->getBagStartEndTime();
+      bag_time_selector_->setRange(start_time, end_time);
+      bag_time_slider_->setRange(start_time, end_time);
+      bag_name_label_->setText(name);
+    });
+}
+
 void DrivingEnvironmentAnalyzerPanel::onBoxUpdate()
 {
   set_format_time(bag_time_line_, bag_time_selector_->value());
@@ -150,16 +277,9 @@ void DrivingEnvironmentAnalyzerPanel::onSelectDirectory()
     return;
   }
 
-  analyzer_->setBagFile(file_name.toStdString());
-
-  ofs_csv_file_ = std::ofstream(
+  loadBag(
+    file_name.toStdString(),
     file_name.toStdString() + "/" + file_name.split("/").back().toStdString() + "_odd.csv");
-  analyzer_->addHeader(ofs_csv_file_);
-
-  const auto [start_time, end_time] = analyzer_->getBagStartEndTime();
-  bag_time_selector_->setRange(start_time, end_time);
-  bag_time_slider_->setRange(start_time, end_time);
-  bag_name_label_->setText(file_name);
 }
 
 void DrivingEnvironmentAnalyzerPanel::onSelectBagFile()
@@ -171,51 +291,72 @@ void DrivingEnvironmentAnalyzerPanel::onSelectBagFile()
     return;
   }
 
-  analyzer_->setBagFile(file_name.toStdString());
-
-  ofs_csv_file_ = std::ofstream(file_name.toStdString() + "_odd.csv");
-  analyzer_->addHeader(ofs_csv_file_);
-
-  const auto [start_time, end_time] = analyzer_->getBagStartEndTime();
-  bag_time_selector_->setRange(start_time, end_time);
-  bag_time_slider_->setRange(start_time, end_time);
-  bag_name_label_->setText(file_name);
+  loadBag(file_name.toStdString(), file_name.toStdString() + "_odd.csv");
 }
 
 void DrivingEnvironmentAnalyzerPanel::onClickSetTimeStamp()
 {
-  analyzer_->clearData();
-  analyzer_->setTimeStamp(bag_time_selector_->value());
-
-  if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
-    return;
-  }
-
-  pub_odometry_->publish(analyzer_->getOdometry());
-  pub_objects_->publish(analyzer_->getObjects());
-  pub_tf_->publish(analyzer_->getTF());
-  pub_tf_static_->publish(analyzer_->getTFStatic());
+  const auto timestamp = bag_time_selector_->value();
+  startJob("Seeking", [this, timestamp]() {
+    analyzer_->clearData();
+    analyzer_->setTimeStamp(timestamp);
+
+    if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
+      return false;
+    }
+
+    pub_odometry_->publish(analyzer_->getOdometry());
+    pub_objects_->publish(analyzer_->getObjects());
+    pub_tf_->publish(analyzer_->getTF());
+    pub_tf_static_->publish(analyzer_->getTFStatic());
+    return true;
+  });
 }
 
 void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeDynamicODDFactor()
 {
-  if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
-    return;
-  }
-
-  analyzer_->analyzeDynamicODDFactor(ofs_csv_file_);
+  startJob("Analyzing dynamic ODD", [this]() {
+    if (!analyzer_->isDataReadyForDynamicODDAnalysis()) {
+      return false;
+    }
+
+    analyzer_->analyzeDynamicODDFactor(ofs_csv_file_);
+    return true;
+  });
 }
 
 void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeStaticODDFactor()
 {
-  if (!analyzer_->isDataReadyForStaticODDAnalysis()) {
-    return;
-  }
+  startJob("Analyzing static ODD", [this]() {
+    if (!analyzer_->isDataReadyForStaticODDAnalysis()) {
+      return false;
+    }
+
+    analyzer_->analyzeStaticODDFactor();
+    return true;
+  });
+}
 
-  analyzer_->analyzeStaticODDFactor();
+void DrivingEnvironmentAnalyzerPanel::onClickAnalyzeWholeBag()
+{
+  startJob("Analyzing whole bag", [this]() {
+    if (!analyzer_->isDataReadyForStaticODDAnalysis() || !ofs_csv_file_.is_open()) {
+      return false;
+    }
+
+    analyzer_->analyzeDynamicODDFactorOverBag(
+      ofs_csv_file_, 1, std::max(std::thread::hardware_concurrency(), 1u));
+    return true;
+  });
 }
 
-DrivingEnvironmentAnalyzerPanel::~DrivingEnvironmentAnalyzerPanel() = default;
+DrivingEnvironmentAnalyzerPanel::~DrivingEnvironmentAnalyzerPanel()
+{
+  is_cancel_requested_ = true;
+  if (job_thread_.joinable()) {
+    job_thread_.join();
+  }
+}
 }  // namespace driving_environment_analyzer
 
 #include <pluginlib/class_list_macros.hpp>
@@ -0,0 +1,110 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "driving_environment_analyzer/map_cache.hpp"
+
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace driving_environment_analyzer
+{
+
+MapCache::MapKey MapCache::getKey(const rcutils_uint8_array_t & serialized_map)
+{
+  // FNV-1a, which is the same on every platform so that the key files are portable
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < serialized_map.buffer_length; ++i) {
+    hash = (hash ^ serialized_map.buffer[i]) * 1099511628211ull;
+  }
+  return {hash, serialized_map.buffer_length};
+}
+
+std::optional<MapCache::MapKey> MapCache::loadKey(
+  const std::string & path, const int64_t stamp) const
+{
+  if (!use_key_file_) {
+    return std::nullopt;
+  }
+  std::ifstream ifs(path);
+  int64_t saved_stamp = 0;
+  MapKey key{};
+  if (!(ifs >> saved_stamp >> key.hash >> key.size) || saved_stamp != stamp) {
+    return std::nullopt;
+  }
+  return key;
+}
+
+void MapCache::saveKey(const std::string & path, const int64_t stamp, const MapKey & key) const
+{
+  if (!use_key_file_) {
+    return;
+  }
+  // the bag may be read only, and then the map is read every time
+  std::ofstream ofs(path);
+  ofs << stamp << ' ' << key.hash << ' ' << key.size << '\n';
+}
+
+bool MapCache::contains(const MapKey & key) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return route_handlers_.count(key) != 0;
+}
+
+std::shared_ptr<const MapCache::RouteHandler> MapCache::getRouteHandler(
+  const MapKey & key, const std::function<LaneletMapBin()> & load_map)
+{
+  std::promise<std::shared_ptr<const RouteHandler>> promise;
+  std::shared_future<std::shared_ptr<const RouteHandler>> route_handler;
+  bool is_cached = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto iter = route_handlers_.find(key);
+    is_cached = iter != route_handlers_.end();
+    if (is_cached) {
+      route_handler = iter->second;
+    } else {
+      route_handler = promise.get_future().share();
+      route_handlers_.emplace(key, route_handler);
+    }
+  }
+
+  // The map is built or being built by another caller
+  if (is_cached) {
+    return route_handler.get();
+  }
+
+  // The map is built out of the lock, so that the other maps are built in parallel
+  try {
+    promise.set_value(std::make_shared<const RouteHandler>(load_map()));
+  } catch (...) {
+    // The map is built again by the next caller
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      route_handlers_.erase(key);
+    }
+    promise.set_exception(std::current_exception());
+  }
+  return route_handler.get();
+}
+
+size_t MapCache::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return route_handlers_.size();
+}
+}  // namespace driving_environment_analyzer
@@ -19,6 +19,7 @@
 
 #include <autoware_lanelet2_extension/regulatory_elements/Forward.hpp>
 #include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <autoware_lanelet2_extension/utility/query.hpp>
 #include <autoware_lanelet2_extension/utility/utilities.hpp>
 #include <magic_enum.hpp>
 
@@ -455,4 +456,230 @@ std::string getEgoBehavior(
 
   return "NONE";
 }
+RouteFeatures::RouteFeatures(
+  const lanelet::ConstLanelets & lanes, const RouteHandler & route_handler)
+{
+  const auto traffic_rule = route_handler.getTrafficRulesPtr();
+
+  features_.reserve(lanes.size());
+  std::vector<geometry_msgs::msg::Point> points;
+  for (const auto & lane : lanes) {
+    LaneletFeature feature;
+    feature.id = lane.id();
+
+    // the centerline is converted once for the width, the curvature and the elevation
+    points.clear();
+    for (const auto & p : lane.centerline()) {
+      points.push_back(lanelet::utils::conversion::toGeomMsgPt(p));
+    }
+    feature.length = lanelet::utils::getLaneletLength3d(lane);
+    feature.width = boost::geometry::area(lane.polygon2d().basicPolygon()) /
+                    autoware::motion_utils::calcArcLength(points);
+
+    const auto curvatures = autoware::motion_utils::calcCurvature(points);
+    if (!curvatures.empty()) {
+      feature.max_curvature = *std::max_element(curvatures.begin(), curvatures.end());
+    }
+
+    const auto elevations = calcElevationAngle(points);
+    if (!elevations.empty()) {
+      const auto [min_itr, max_itr] = std::minmax_element(elevations.begin(), elevations.end());
+      feature.elevation = std::make_pair(*min_itr, *max_itr);
+    }
+
+    feature.speed_limit = traffic_rule->speedLimit(lane).speedLimit.value();
+    feature.exist_same_direction_lane = existSameDirectionLane(lane, route_handler);
+    feature.exist_opposite_direction_lane = existOppositeDirectionLane(lane, route_handler);
+    feature.exist_traffic_light = !lane.regulatoryElementsAs<lanelet::TrafficLight>().empty();
+    feature.is_intersection = existIntersection({lane});
+    feature.exist_crosswalk = existCrosswalk(lane, route_handler);
+
+    features_.push_back(feature);
+  }
+}
+
+double RouteFeatures::getRouteLength() const
+{
+  double value = 0.0;
+  for (const auto & feature : features_) {
+    value += feature.length;
+  }
+  return value;
+}
+
+double RouteFeatures::getRouteLengthWithSameDirectionLane() const
+{
+  double value = 0.0;
+  for (const auto & feature : features_) {
+    if (feature.exist_same_direction_lane) {
+      value += feature.length;
+    }
+  }
+  return value;
+}
+
+double RouteFeatures::getRouteLengthWithOppositeDirectionLane() const
+{
+  double value = 0.0;
+  for (const auto & feature : features_) {
+    if (feature.exist_opposite_direction_lane) {
+      value += feature.length;
+    }
+  }
+  return value;
+}
+
+double RouteFeatures::getRouteLengthWithNoAdjacentLane() const
+{
+  double value = 0.0;
+  for (const auto & feature : features_) {
+    if (!feature.exist_same_direction_lane && !feature.exist_opposite_direction_lane) {
+      value += feature.length;
+    }
+  }
+  return value;
+}
+
+double RouteFeatures::getMaxCurvature() const
+{
+  double max_value = 0.0;
+  for (const auto & feature : features_) {
+    if (feature.max_curvature.has_value()) {
+      max_value = std::max(max_value, feature.max_curvature.value());
+    }
+  }
+  return max_value;
+}
+
+std::pair<double, double> RouteFeatures::getLaneWidth() const
+{
+  double min_value = std::numeric_limits<double>::max();
+  double max_value = 0.0;
+  for (const auto & feature : features_) {
+    min_value = std::min(min_value, feature.width);
+    max_value = std::max(max_value, feature.width);
+  }
+  return std::make_pair(min_value, max_value);
+}
+
+std::pair<double, double> RouteFeatures::getElevation() const
+{
+  double min_value = std::numeric_limits<double>::max();
+  double max_value = 0.0;
+  for (const auto & feature : features_) {
+    if (feature.elevation.has_value()) {
+      min_value = std::min(min_value, feature.elevation.value().first);
+      max_value = std::max(max_value, feature.elevation.value().second);
+    }
+  }
+  return std::make_pair(min_value, max_value);
+}
+
+std::pair<double, double> RouteFeatures::getSpeedLimit() const
+{
+  double min_value = std::numeric_limits<double>::max();
+  double max_value = 0.0;
+  for (const auto & feature : features_) {
+    min_value = std::min(min_value, feature.speed_limit);
+    max_value = std::max(max_value, feature.speed_limit);
+  }
+  return std::make_pair(min_value, max_value);
+}
+
+bool RouteFeatures::existTrafficLight() const
+{
+  return std::any_of(features_.begin(), features_.end(), [](const auto & feature) {
+    return feature.exist_traffic_light;
+  });
+}
+
+bool RouteFeatures::existIntersection() const
+{
+  return std::any_of(features_.begin(), features_.end(), [](const auto & feature) {
+    return feature.is_intersection;
+  });
+}
+
+bool RouteFeatures::existCrosswalk() const
+{
+  return std::any_of(features_.begin(), features_.end(), [](const auto & feature) {
+    return feature.exist_crosswalk;
+  });
+}
+
+RouteLaneletIndex::RouteLaneletIndex(const lanelet::ConstLanelets & route_lanelets)
+: lanelets_(route_lanelets)
+{
+  using autoware::universe_utils::Point2d;
+
+  std::vector<std::pair<Box2d, size_t>> indexed_envelopes;
+  for (size_t i = 0; i < lanelets_.size(); ++i) {
+    polygons_.push_back(lanelets_.at(i).polygon2d().basicPolygon());
+
+    Box2d envelope;
+    boost::geometry::assign_inverse(envelope);
+    for (const auto & point : polygons_.back()) {
+      boost::geometry::expand(envelope, Point2d(point.x(), point.y()));
+    }
+    indexed_envelopes.emplace_back(envelope, i);
+  }
+  rtree_ = decltype(rtree_)(indexed_envelopes.begin(), indexed_envelopes.end());
+}
+
+bool RouteLaneletIndex::getClosestLanelet(
+  const Pose & pose, lanelet::ConstLanelet * closest_lanelet, size_t & lanelet_idx) const
+{
+  if (lanelets_.empty()) {
+    return false;
+  }
+
+  // The lanelets within this margin of the closest one are passed to getClosestLanelet, which
+  // picks one of them as it does among all the lanelets of the route
+  constexpr double margin = 1e-6;
+  const autoware::universe_utils::Point2d point(pose.position.x, pose.position.y);
+  const lanelet::BasicPoint2d lanelet_point(pose.position.x, pose.position.y);
+
+  // The distance from the closest lanelet of the nearby pose makes the search stop early
+  double min_dist = std::numeric_limits<double>::max();
+  if (lanelet_idx < lanelets_.size()) {
+    min_dist = boost::geometry::distance(lanelet_point, polygons_.at(lanelet_idx));
+  }
+
+  // The envelopes are visited in the order of the distance from the pose, which is not larger than
+  // the one from their lanelets. Once it exceeds the minimum distance, the rest cannot be closer.
+  std::vector<std::pair<double, size_t>> candidates;
+  for (auto itr = rtree_.qbegin(boost::geometry::index::nearest(point, rtree_.size()));
+       itr != rtree_.qend(); ++itr) {
+    if (min_dist + margin < boost::geometry::distance(point, itr->first)) {
+      break;
+    }
+    const double dist = boost::geometry::distance(lanelet_point, polygons_.at(itr->second));
+    candidates.emplace_back(dist, itr->second);
+    min_dist = std::min(min_dist, dist);
+  }
+
+  // The candidates are in the order of the route, as the lanelets given to getClosestLanelet by
+  // the route handler
+  std::sort(candidates.begin(), candidates.end(), [](const auto & a, const auto & b) {
+    return a.second < b.second;
+  });
+  lanelet::ConstLanelets candidate_lanelets;
+  for (const auto & [dist, idx] : candidates) {
+    if (dist <= min_dist + margin) {
+      candidate_lanelets.push_back(lanelets_.at(idx));
+    }
+  }
+
+  if (!lanelet::utils::query::getClosestLanelet(candidate_lanelets, pose, closest_lanelet)) {
+    return false;
+  }
+
+  const auto itr = std::find_if(candidates.begin(), candidates.end(), [&](const auto & candidate) {
+    return lanelets_.at(candidate.second).id() == closest_lanelet->id();
+  });
+  if (itr != candidates.end()) {
+    lanelet_idx = itr->second;
+  }
+  return true;
+}
 }  // namespace driving_environment_analyzer::utils
@@ -0,0 +1,132 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef METRIC_PLOT_WIDGET_HPP_
+#define METRIC_PLOT_WIDGET_HPP_
+
+#ifndef Q_MOC_RUN
+#include <QColor>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLWidget>
+#include <QString>
+#endif
+
+#include "metrics_time_series.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief lightweight plot of the series of a metric, which keeps the samples of each series in a
+ * ring of vertices on the GPU. Only the samples appended since the last update are uploaded, and
+ * the time window is scrolled by a uniform, so that the cost of a frame does not grow with the
+ * number of samples like that of a QChartView
+ */
+class MetricPlotWidget : public QOpenGLWidget, protected QOpenGLFunctions
+{
+public:
+  using Series = std::pair<QString, const MetricTimeSeries *>;
+
+  explicit MetricPlotWidget(QWidget * parent = nullptr);
+  ~MetricPlotWidget() override;
+
+  /**
+   * @brief plot the series, which are uploaded again at the next update. The series are read
+   * until this is called again, so they have to live until then
+   */
+  void setSeries(const QString & title, const std::vector<Series> & series);
+
+  void setRange(const double t_min, const double t_max, const double y_min, const double y_max);
+
+  /**
+   * @brief copy the samples appended to the series since the last update, and schedule a repaint
+   * that uploads them
+   */
+  void updateSeries();
+
+protected:
+  void initializeGL() override;
+  void paintGL() override;
+
+private:
+  // samples copied to a contiguous range of the ring, in vertices
+  struct Write
+  {
+    size_t slot;
+    std::vector<float> vertices;
+  };
+
+  struct Track
+  {
+    QString name;
+    QColor color;
+    const MetricTimeSeries * series{nullptr};
+
+    // state of the samples copied from the series, by their indices in the series
+    size_t generation{0};
+    size_t next_index{0};
+    size_t begin_index{0};
+    size_t end_index{0};
+    bool is_reset{true};
+
+    // the times are relative to base_time, so that they keep their precision as floats
+    double base_time{0.0};
+
+    // the ring has capacity vertices, and a copy of the first one after them, so that a line strip
+    // that wraps around is drawn in two parts without a gap
+    size_t capacity{0};
+    bool is_reallocated{true};
+    std::vector<Write> writes;
+
+    std::unique_ptr<QOpenGLBuffer> buffer;
+  };
+
+  void copySamples(Track & track) const;
+  void uploadSamples(Track & track);
+  void drawTrack(const Track & track, const QRect & area);
+
+  // the minimum size of a ring, in vertices
+  static constexpr size_t min_capacity = 1024;
+
+  // the times are rebased once they are this far from the base, in seconds
+  static constexpr double max_relative_time = 1e4;
+
+  std::unique_ptr<QOpenGLShaderProgram> program_;
+
+  // buffers of the previous series, which are destroyed while the context is current
+  std::vector<std::unique_ptr<QOpenGLBuffer>> released_buffers_;
+
+  // the tracks and the range are set from the timer of the panel, and read when the widget is
+  // painted
+  std::mutex mutex_;
+  QString title_;
+  std::vector<Track> tracks_;
+  double t_min_{0.0};
+  double t_max_{1.0};
+  double y_min_{0.0};
+  double y_max_{1.0};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // METRIC_PLOT_WIDGET_HPP_
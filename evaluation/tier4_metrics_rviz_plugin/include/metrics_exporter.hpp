@@ -0,0 +1,83 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef METRICS_EXPORTER_HPP_
+#define METRICS_EXPORTER_HPP_
+
+#include "metrics_message_queue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief write all the values of the received metrics to a CSV file in its own thread, with a row
+ * of "stamp,topic,metric,key,value" for each value, so that the full history can be analyzed
+ * offline while the charts keep only their time window
+ */
+class MetricsExporter
+{
+public:
+  MetricsExporter() = default;
+  MetricsExporter(const MetricsExporter &) = delete;
+  MetricsExporter & operator=(const MetricsExporter &) = delete;
+  ~MetricsExporter() { stop(); }
+
+  /**
+   * @brief open the file and start the writer thread
+   * @return false if the file cannot be opened
+   */
+  bool start(const std::string & path);
+
+  /**
+   * @brief write the queued messages, and close the file
+   */
+  void stop();
+
+  /**
+   * @brief queue a message to write, which is ignored if the exporter is not started. It does not
+   * block, so it can be called from the subscription callbacks
+   */
+  void push(const MetricsMessageQueue::Message & msg, const std::string & topic_name);
+
+  bool isActive() const { return is_active_; }
+  size_t getWrittenRowNum() const { return written_row_num_; }
+
+private:
+  void write();
+  void writeMessages();
+
+  // period at which the writer thread drains the queue
+  static constexpr int64_t write_period_ms_ = 100;
+
+  MetricsMessageQueue queue_;
+  std::ofstream file_;
+  std::thread writer_thread_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool is_stopping_{false};
+  std::atomic<bool> is_active_{false};
+  std::atomic<size_t> written_row_num_{0};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // METRICS_EXPORTER_HPP_
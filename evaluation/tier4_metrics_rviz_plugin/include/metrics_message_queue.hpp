@@ -0,0 +1,83 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef METRICS_MESSAGE_QUEUE_HPP_
+#define METRICS_MESSAGE_QUEUE_HPP_
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief lock-free queue of the received messages, which any thread can push to, and the UI
+ * thread drains at once
+ */
+class MetricsMessageQueue
+{
+public:
+  using Message = diagnostic_msgs::msg::DiagnosticArray::ConstSharedPtr;
+
+  MetricsMessageQueue() = default;
+  MetricsMessageQueue(const MetricsMessageQueue &) = delete;
+  MetricsMessageQueue & operator=(const MetricsMessageQueue &) = delete;
+  ~MetricsMessageQueue() { drain(); }
+
+  void push(const Message & msg, const std::string & topic_name)
+  {
+    auto * node = new Node{msg, topic_name, head_.load(std::memory_order_relaxed)};
+    while (!head_.compare_exchange_weak(
+      node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @brief take all the queued messages with their topics, in the order they were pushed
+   */
+  std::vector<std::pair<Message, std::string>> drain()
+  {
+    Node * node = head_.exchange(nullptr, std::memory_order_acquire);
+    std::vector<std::pair<Message, std::string>> messages;
+    while (node) {
+      messages.emplace_back(std::move(node->msg), std::move(node->topic_name));
+      Node * next = node->next;
+      delete node;
+      node = next;
+    }
+    // the nodes are linked from the newest
+    std::reverse(messages.begin(), messages.end());
+    return messages;
+  }
+
+private:
+  struct Node
+  {
+    Message msg;
+    std::string topic_name;
+    Node * next;
+  };
+
+  std::atomic<Node *> head_{nullptr};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // METRICS_MESSAGE_QUEUE_HPP_
@@ -0,0 +1,130 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef METRICS_TIME_SERIES_HPP_
+#define METRICS_TIME_SERIES_HPP_
+
+#ifndef Q_MOC_RUN
+#include <QPointF>
+#include <QVector>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+
+namespace rviz_plugins
+{
+
+/**
+ * @brief samples of a metric in the last time_window seconds
+ */
+class MetricTimeSeries
+{
+public:
+  explicit MetricTimeSeries(const double time_window) : time_window_(time_window) {}
+
+  void append(const double time, const double data)
+  {
+    // restart when the time goes back, e.g. a rosbag is replayed again
+    if (!points_.empty() && time < points_.back().x()) {
+      points_.clear();
+      appended_num_ = 0;
+      generation_++;
+    }
+    points_.emplace_back(time, data);
+    appended_num_++;
+    while (points_.front().x() < time - time_window_) {
+      points_.pop_front();
+    }
+  }
+
+  bool empty() const { return points_.empty(); }
+  double latestTime() const { return points_.back().x(); }
+  double timeWindow() const { return time_window_; }
+
+  /**
+   * @brief the samples are numbered in the order they are appended, so that a view knows which of
+   * them are new since it last drew the series. The numbers start again at a new generation, when
+   * the samples are cleared because the time went back
+   */
+  size_t generation() const { return generation_; }
+  size_t endIndex() const { return appended_num_; }
+  size_t beginIndex() const { return appended_num_ - points_.size(); }
+  const QPointF & at(const size_t index) const { return points_.at(index - beginIndex()); }
+
+  /**
+   * @brief downsample the samples with M4, which keeps the first, min, max and last samples of
+   * the samples in each of bucket_num buckets of the time window. The line drawn with bucket_num
+   * pixels is the same as that of all the samples
+   */
+  QVector<QPointF> downsample(const int bucket_num) const
+  {
+    if (bucket_num <= 0 || points_.size() <= 4 * static_cast<size_t>(bucket_num)) {
+      return QVector<QPointF>(points_.begin(), points_.end());
+    }
+
+    const double t_min = points_.back().x() - time_window_;
+    const double bucket_width = time_window_ / bucket_num;
+    QVector<QPointF> result;
+    result.reserve(4 * bucket_num);
+
+    auto begin = points_.begin();
+    while (begin != points_.end()) {
+      const auto bucket = std::floor((begin->x() - t_min) / bucket_width);
+      auto end = begin;
+      auto min_itr = begin;
+      auto max_itr = begin;
+      for (; end != points_.end() && std::floor((end->x() - t_min) / bucket_width) == bucket;
+           ++end) {
+        if (end->y() < min_itr->y()) {
+          min_itr = end;
+        }
+        if (end->y() > max_itr->y()) {
+          max_itr = end;
+        }
+      }
+      const auto last_itr = std::prev(end);
+
+      // keep the samples in time order, without duplicates
+      result.push_back(*begin);
+      const auto first_extremum = std::min(min_itr, max_itr);
+      const auto second_extremum = std::max(min_itr, max_itr);
+      if (first_extremum != begin) {
+        result.push_back(*first_extremum);
+      }
+      if (second_extremum != first_extremum && second_extremum != begin) {
+        result.push_back(*second_extremum);
+      }
+      if (last_itr != second_extremum && last_itr != begin) {
+        result.push_back(*last_itr);
+      }
+      begin = end;
+    }
+    return result;
+  }
+
+private:
+  double time_window_;
+  std::deque<QPointF> points_;
+  size_t appended_num_{0};
+  size_t generation_{0};
+};
+
+}  // namespace rviz_plugins
+
+#endif  // METRICS_TIME_SERIES_HPP_
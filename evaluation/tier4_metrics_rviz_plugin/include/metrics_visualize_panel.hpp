@@ -18,6 +18,7 @@
 
 #ifndef Q_MOC_RUN
 #include <QChartView>
+#include <QCheckBox>
 #include <QColor>
 #include <QComboBox>
 #include <QGridLayout>
@@ -30,6 +31,11 @@
 #include <QVBoxLayout>
 #endif
 
+#include "metric_plot_widget.hpp"
+#include "metrics_exporter.hpp"
+#include "metrics_message_queue.hpp"
+#include "metrics_time_series.hpp"
+
 #include <rclcpp/rclcpp.hpp>
 #include <rviz_common/panel.hpp>
 
@@ -83,6 +89,7 @@ public:
       auto plot = new QLineSeries;
       plot->setName(QString::fromStdString(key));
       plots.emplace(key, plot);
+      series.emplace(key, MetricTimeSeries(time_window));
       chart->chart()->addSeries(plot);
       chart->chart()->createDefaultAxes();
 
@@ -104,6 +111,14 @@ public:
       table->setRowCount(1);
       table->setSizeAdjustPolicy(QAbstractScrollArea::AdjustToContents);
     }
+
+    {
+      table->setCellWidget(0, 0, labels.at("metric_name"));
+    }
+
+    for (size_t i = 0; i < status.values.size(); ++i) {
+      table->setCellWidget(0, i + 1, labels.at(status.values.at(i).key));
+    }
   }
 
   void updateData(const double time, const DiagnosticStatus & status)
@@ -112,30 +127,17 @@ public:
       try {
         const double data = std::stod(value);
         labels.at(key)->setText(QString::fromStdString(toString(data)));
-        plots.at(key)->append(time, data);
+        series.at(key).append(time, data);
         updateMinMax(data);
+        is_graph_updated = true;
+        is_table_updated = true;
       } catch (const std::exception & e) {
         RCLCPP_DEBUG(
           rclcpp::get_logger(__func__), "%s invalid argument. KEY:%s VALUE:%s", e.what(),
           key.c_str(), value.c_str());
       }
     }
-
-    {
-      const auto area = chart->chart()->plotArea();
-      const auto rect = chart->chart()->legend()->rect();
-      chart->chart()->legend()->setGeometry(
-        QRectF(area.x(), area.y(), area.width(), rect.height()));
-      chart->chart()->axes(Qt::Horizontal).front()->setRange(time - 100.0, time);
-    }
-
-    {
-      table->setCellWidget(0, 0, labels.at("metric_name"));
-    }
-
-    for (size_t i = 0; i < status.values.size(); ++i) {
-      table->setCellWidget(0, i + 1, labels.at(status.values.at(i).key));
-    }
+    latest_time = time;
   }
 
   void updateMinMax(double data)
@@ -151,9 +153,76 @@ public:
     }
   }
 
-  void updateTable() { table->update(); }
+  void updateTable()
+  {
+    if (!is_table_updated || !table->isVisible()) {
+      return;
+    }
+    table->update();
+    is_table_updated = false;
+  }
 
-  void updateGraph() { chart->update(); }
+  /**
+   * @brief redraw the chart if it has new data and is visible. The series are downsampled to the
+   * width of the plot area
+   * @param [in] view view showing the chart, which is the view of this metric if it is null
+   */
+  void updateGraph(QChartView * view = nullptr)
+  {
+    view = view ? view : chart;
+    if (!is_graph_updated || !view->isVisible()) {
+      return;
+    }
+
+    const auto area = chart->chart()->plotArea();
+    const auto rect = chart->chart()->legend()->rect();
+    chart->chart()->legend()->setGeometry(QRectF(area.x(), area.y(), area.width(), rect.height()));
+    chart->chart()->axes(Qt::Horizontal).front()->setRange(latest_time - time_window, latest_time);
+
+    const int bucket_num = std::max(static_cast<int>(area.width()), 1);
+    for (const auto & [key, plot] : plots) {
+      plot->replace(series.at(key).downsample(bucket_num));
+    }
+    view->update();
+    is_graph_updated = false;
+  }
+
+  /**
+   * @brief upload the new samples to the plot if it has new data and is visible
+   */
+  void updatePlot(MetricPlotWidget * plot)
+  {
+    if (!is_graph_updated || !plot->isVisible()) {
+      return;
+    }
+
+    plot->setRange(latest_time - time_window, latest_time, y_range_min, y_range_max);
+    plot->updateSeries();
+    is_graph_updated = false;
+  }
+
+  /**
+   * @brief show the series of this metric on the plot, which reads them until another metric is
+   * shown
+   */
+  void showOnPlot(MetricPlotWidget * plot) const
+  {
+    std::vector<MetricPlotWidget::Series> plot_series;
+    for (const auto & [key, samples] : series) {
+      plot_series.emplace_back(QString::fromStdString(key), &samples);
+    }
+    plot->setSeries(chart->chart()->title(), plot_series);
+  }
+
+  /**
+   * @brief render the series of the chart with OpenGL instead of the raster engine of QtCharts
+   */
+  void setUseOpenGL(const bool use_opengl)
+  {
+    for (const auto & [key, plot] : plots) {
+      plot->setUseOpenGL(use_opengl);
+    }
+  }
 
   QChartView * getChartView() const { return chart; }
 
@@ -188,6 +257,13 @@ private:
   std::unordered_map<std::string, QLabel *> labels;
   std::unordered_map<std::string, QLineSeries *> plots;
 
+  // samples of the plots in the time window of the chart
+  static constexpr double time_window = 100.0;
+  std::unordered_map<std::string, MetricTimeSeries> series;
+  double latest_time{0.0};
+  bool is_graph_updated{false};
+  bool is_table_updated{false};
+
   double y_range_min{std::numeric_limits<double>::max()};
   double y_range_max{std::numeric_limits<double>::lowest()};
 };
@@ -199,6 +275,8 @@ class MetricsVisualizePanel : public rviz_common::Panel
 public:
   explicit MetricsVisualizePanel(QWidget * parent = nullptr);
   void onInitialize() override;
+  void save(rviz_common::Config config) const override;
+  void load(const rviz_common::Config & config) override;
 
 private Q_SLOTS:
   // Slot functions triggered by UI events
@@ -206,6 +284,8 @@ private Q_SLOTS:
   void onSpecificMetricChanged();
   void onClearButtonClicked();
   void onTabChanged();
+  void onExportButtonToggled(const bool checked);
+  void onOpenGLToggled(const bool checked);
 
 private:
   // ROS 2 node and subscriptions for handling metrics data
@@ -217,9 +297,16 @@ private:
   std::vector<std::string> topics_ = {
     "/planning/planning_evaluator/metrics", "/perception/perception_online_evaluator/metrics"};
 
-  // Timer and metrics message callback
+  // Timer and metrics message callback. The messages are queued by the callback, and processed in
+  // a batch by the timer in the UI thread
   void onTimer();
   void onMetrics(const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name);
+  void processMetrics(const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name);
+  MetricsMessageQueue message_queue_;
+
+  // All the received values are also written to a CSV file by the exporter while it is active
+  MetricsExporter exporter_;
+  QPushButton * export_button_;
 
   // Functions to update UI based on selected metrics
   void updateViews();
@@ -235,6 +322,12 @@ private:
   QChartView * specific_metric_chart_view_;
   QTableWidget * specific_metric_table_;
 
+  // With OpenGL, the series of the charts are rendered by OpenGL, and the selected metric, which
+  // is shown large with all the samples of its time window, is drawn by the lightweight plot
+  QCheckBox * opengl_checkbox_;
+  MetricPlotWidget * specific_metric_plot_;
+  bool use_opengl_{false};
+
   // Selected metrics data
   std::optional<std::pair<std::string, Metric>> selected_metrics_;
 
@@ -0,0 +1,309 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "metric_plot_widget.hpp"
+
+#include <QPainter>
+#include <QVector2D>
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rviz_plugins
+{
+
+namespace
+{
+constexpr auto vertex_shader = R"(
+attribute highp vec2 vertex;
+uniform highp vec2 offset;
+uniform highp vec2 scale;
+void main()
+{
+  gl_Position = vec4((vertex - offset) * scale - 1.0, 0.0, 1.0);
+}
+)";
+
+constexpr auto fragment_shader = R"(
+uniform lowp vec4 color;
+void main()
+{
+  gl_FragColor = color;
+}
+)";
+
+// the colors of the series of the light theme of QtCharts, so that both views look alike
+const std::array<QColor, 5> colors{
+  QColor("#209fdf"), QColor("#99ca53"), QColor("#f6a625"), QColor("#6d5fd5"), QColor("#bf593e")};
+
+// margins of the plot area for the title, the legend and the labels, in pixels
+constexpr int margin_left = 64;
+constexpr int margin_top = 40;
+constexpr int margin_right = 12;
+constexpr int margin_bottom = 20;
+}  // namespace
+
+MetricPlotWidget::MetricPlotWidget(QWidget * parent) : QOpenGLWidget(parent)
+{
+  setMinimumHeight(200);
+}
+
+MetricPlotWidget::~MetricPlotWidget()
+{
+  makeCurrent();
+  for (auto & track : tracks_) {
+    track.buffer.reset();
+  }
+  released_buffers_.clear();
+  program_.reset();
+  doneCurrent();
+}
+
+void MetricPlotWidget::setSeries(const QString & title, const std::vector<Series> & series)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  title_ = title;
+  for (auto & track : tracks_) {
+    if (track.buffer) {
+      released_buffers_.push_back(std::move(track.buffer));
+    }
+  }
+  tracks_.clear();
+
+  for (size_t i = 0; i < series.size(); ++i) {
+    Track track;
+    track.name = series.at(i).first;
+    track.series = series.at(i).second;
+    track.color = colors.at(i % colors.size());
+    tracks_.push_back(std::move(track));
+  }
+  update();
+}
+
+void MetricPlotWidget::setRange(
+  const double t_min, const double t_max, const double y_min, const double y_max)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  t_min_ = t_min;
+  t_max_ = t_max;
+  y_min_ = y_min;
+  y_max_ = y_max;
+}
+
+void MetricPlotWidget::updateSeries()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto & track : tracks_) {
+      copySamples(track);
+    }
+  }
+  update();
+}
+
+void MetricPlotWidget::copySamples(Track & track) const
+{
+  const auto & series = *track.series;
+  const size_t size = series.endIndex() - series.beginIndex();
+
+  // all the samples are copied again when the series restarts, when they do not fit in the ring,
+  // or when the times are too far from the base to be floats
+  if (
+    track.is_reset || track.generation != series.generation() || size > track.capacity ||
+    (!series.empty() && series.latestTime() - track.base_time > max_relative_time)) {
+    while (track.capacity < size || track.capacity == 0) {
+      track.capacity = std::max(min_capacity, 2 * track.capacity);
+      track.is_reallocated = true;
+    }
+    track.generation = series.generation();
+    track.next_index = series.beginIndex();
+    track.base_time = series.empty() ? 0.0 : series.at(series.beginIndex()).x();
+    track.writes.clear();
+    track.is_reset = false;
+  }
+
+  // the new samples are split where they wrap around the ring
+  const size_t end = series.endIndex();
+  for (size_t i = std::max(track.next_index, series.beginIndex()); i < end;) {
+    const size_t slot = i % track.capacity;
+    const size_t run_end = std::min(end, i + track.capacity - slot);
+
+    Write write{slot, {}};
+    write.vertices.reserve(2 * (run_end - i));
+    for (; i < run_end; ++i) {
+      const auto & point = series.at(i);
+      write.vertices.push_back(static_cast<float>(point.x() - track.base_time));
+      write.vertices.push_back(static_cast<float>(point.y()));
+    }
+
+    if (slot == 0) {
+      track.writes.push_back(
+        Write{track.capacity, {write.vertices.at(0), write.vertices.at(1)}});
+    }
+    track.writes.push_back(std::move(write));
+  }
+
+  track.next_index = end;
+  track.begin_index = series.beginIndex();
+  track.end_index = end;
+}
+
+void MetricPlotWidget::initializeGL()
+{
+  initializeOpenGLFunctions();
+
+  program_ = std::make_unique<QOpenGLShaderProgram>();
+  program_->addShaderFromSourceCode(QOpenGLShader::Vertex, vertex_shader);
+  program_->addShaderFromSourceCode(QOpenGLShader::Fragment, fragment_shader);
+  program_->bindAttributeLocation("vertex", 0);
+  if (!program_->link()) {
+    RCLCPP_ERROR_STREAM(
+      rclcpp::get_logger("metrics_visualize_panel"),
+      "failed to link the shaders of the plot: " << program_->log().toStdString());
+    program_.reset();
+  }
+}
+
+void MetricPlotWidget::uploadSamples(Track & track)
+{
+  if (track.capacity == 0) {
+    return;
+  }
+
+  if (!track.buffer) {
+    track.buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
+    track.buffer->create();
+    track.buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    track.is_reallocated = true;
+  }
+
+  track.buffer->bind();
+  if (track.is_reallocated) {
+    track.buffer->allocate(static_cast<int>(2 * (track.capacity + 1) * sizeof(float)));
+    track.is_reallocated = false;
+  }
+
+  // only the samples copied since the last frame are written to the ring
+  for (const auto & write : track.writes) {
+    track.buffer->write(
+      static_cast<int>(2 * write.slot * sizeof(float)), write.vertices.data(),
+      static_cast<int>(write.vertices.size() * sizeof(float)));
+  }
+  track.writes.clear();
+  track.buffer->release();
+}
+
+void MetricPlotWidget::drawTrack(const Track & track, const QRect & area)
+{
+  const size_t count = track.end_index - track.begin_index;
+  if (!track.buffer || count < 2 || area.width() <= 0 || area.height() <= 0) {
+    return;
+  }
+
+  const double t_range = std::max(t_max_ - t_min_, 1e-9);
+  const double y_range = std::max(y_max_ - y_min_, 1e-9);
+
+  track.buffer->bind();
+  program_->enableAttributeArray(0);
+  program_->setAttributeBuffer(0, GL_FLOAT, 0, 2);
+  program_->setUniformValue(
+    "offset", QVector2D(static_cast<float>(t_min_ - track.base_time), static_cast<float>(y_min_)));
+  program_->setUniformValue(
+    "scale", QVector2D(static_cast<float>(2.0 / t_range), static_cast<float>(2.0 / y_range)));
+  program_->setUniformValue("color", track.color);
+
+  // the part at the end of the ring ends with the copy of the first vertex
+  const size_t slot = track.begin_index % track.capacity;
+  if (slot + count <= track.capacity) {
+    glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(slot), static_cast<GLsizei>(count));
+  } else {
+    const size_t first_count = track.capacity - slot;
+    glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(slot), static_cast<GLsizei>(first_count + 1));
+    glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(count - first_count));
+  }
+
+  program_->disableAttributeArray(0);
+  track.buffer->release();
+}
+
+void MetricPlotWidget::paintGL()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  released_buffers_.clear();
+  for (auto & track : tracks_) {
+    uploadSamples(track);
+  }
+
+  const QRect area(
+    margin_left, margin_top, width() - margin_left - margin_right,
+    height() - margin_top - margin_bottom);
+  const qreal ratio = devicePixelRatioF();
+
+  QPainter painter(this);
+  painter.beginNativePainting();
+  glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  if (program_) {
+    // the lines are clipped to the plot area by the viewport
+    glViewport(
+      static_cast<GLint>(area.x() * ratio),
+      static_cast<GLint>((height() - area.y() - area.height()) * ratio),
+      static_cast<GLsizei>(area.width() * ratio), static_cast<GLsizei>(area.height() * ratio));
+    program_->bind();
+    for (const auto & track : tracks_) {
+      drawTrack(track, area);
+    }
+    program_->release();
+    glViewport(0, 0, static_cast<GLsizei>(width() * ratio), static_cast<GLsizei>(height() * ratio));
+  }
+  painter.endNativePainting();
+
+  painter.setPen(Qt::gray);
+  painter.drawRect(area);
+
+  const int text_height = painter.fontMetrics().height();
+  painter.setPen(Qt::black);
+  painter.drawText(QRect(0, 0, width(), margin_top / 2), Qt::AlignCenter, title_);
+  painter.drawText(
+    QRect(0, area.top(), margin_left - 4, text_height), Qt::AlignRight | Qt::AlignTop,
+    QString::number(y_max_, 'e', 2));
+  painter.drawText(
+    QRect(0, area.bottom() - text_height, margin_left - 4, text_height),
+    Qt::AlignRight | Qt::AlignBottom, QString::number(y_min_, 'e', 2));
+  painter.drawText(
+    QRect(area.left(), area.bottom(), area.width(), margin_bottom), Qt::AlignLeft | Qt::AlignTop,
+    QString::number(t_min_ - t_max_, 'f', 0) + " s");
+  painter.drawText(
+    QRect(area.left(), area.bottom(), area.width(), margin_bottom), Qt::AlignRight | Qt::AlignTop,
+    "0 s");
+
+  // the legend is a row of the names in the colors of their lines
+  int x = area.left();
+  for (const auto & track : tracks_) {
+    painter.setPen(track.color);
+    painter.drawText(
+      QRect(x, margin_top / 2, area.width(), margin_top / 2), Qt::AlignLeft, track.name);
+    x += painter.fontMetrics().horizontalAdvance(track.name) + 16;
+  }
+}
+
+}  // namespace rviz_plugins
@@ -0,0 +1,131 @@
+//  Copyright 2024 TIER IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "metrics_exporter.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace rviz_plugins
+{
+
+namespace
+{
+// quote the field if it has a comma, a quote or a newline
+std::string toCsvField(const std::string & field)
+{
+  if (field.find_first_of(",\"\n") == std::string::npos) {
+    return field;
+  }
+  std::string quoted = "\"";
+  for (const char c : field) {
+    quoted += c == '"' ? "\"\"" : std::string(1, c);
+  }
+  return quoted + "\"";
+}
+
+std::string toStampString(const builtin_interfaces::msg::Time & stamp)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%d.%09u", stamp.sec, stamp.nanosec);
+  return buffer;
+}
+}  // namespace
+
+bool MetricsExporter::start(const std::string & path)
+{
+  stop();
+
+  file_.open(path);
+  if (!file_) {
+    return false;
+  }
+  file_ << "stamp,topic,metric,key,value\n";
+
+  // drop the messages pushed while the last export was stopping
+  queue_.drain();
+  is_stopping_ = false;
+  written_row_num_ = 0;
+  writer_thread_ = std::thread([this]() { write(); });
+  is_active_ = true;
+  return true;
+}
+
+void MetricsExporter::stop()
+{
+  if (!writer_thread_.joinable()) {
+    return;
+  }
+
+  is_active_ = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopping_ = true;
+  }
+  cv_.notify_one();
+  writer_thread_.join();
+  file_.close();
+}
+
+void MetricsExporter::push(const MetricsMessageQueue::Message & msg, const std::string & topic_name)
+{
+  if (is_active_) {
+    queue_.push(msg, topic_name);
+  }
+}
+
+void MetricsExporter::write()
+{
+  while (true) {
+    bool is_stopping;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      is_stopping = cv_.wait_for(
+        lock, std::chrono::milliseconds(write_period_ms_), [this]() { return is_stopping_; });
+    }
+    // the messages pushed before stop are written too
+    writeMessages();
+    if (is_stopping) {
+      return;
+    }
+  }
+}
+
+void MetricsExporter::writeMessages()
+{
+  const auto messages = queue_.drain();
+  if (messages.empty()) {
+    return;
+  }
+
+  size_t row_num = 0;
+  for (const auto & [msg, topic_name] : messages) {
+    const std::string stamp = toStampString(msg->header.stamp);
+    const std::string topic = toCsvField(topic_name);
+    for (const auto & status : msg->status) {
+      const std::string metric = toCsvField(status.name);
+      for (const auto & [key, value] : status.values) {
+        file_ << stamp << ',' << topic << ',' << metric << ',' << toCsvField(key) << ','
+              << toCsvField(value) << '\n';
+        ++row_num;
+      }
+    }
+  }
+  file_.flush();
+  written_row_num_ += row_num;
+}
+
+}  // namespace rviz_plugins
@@ -15,6 +15,7 @@
 
 #include "metrics_visualize_panel.hpp"
 
+#include <QDateTime>
 #include <ament_index_cpp/get_package_share_directory.hpp>
 #include <rviz_common/display_context.hpp>
 
@@ -72,11 +73,28 @@ MetricsVisualizePanel::MetricsVisualizePanel(QWidget * parent)
   specific_metric_chart_view_ = new QChartView();
   specific_metrics_layout->addWidget(specific_metric_chart_view_);
 
+  // Add the plot drawn with OpenGL, which replaces the chart view while OpenGL is enabled
+  specific_metric_plot_ = new MetricPlotWidget();
+  specific_metric_plot_->setVisible(false);
+  specific_metrics_layout->addWidget(specific_metric_plot_);
+
   tab_widget_->addTab(
     specific_metrics_widget, "Specific Metrics");  // Add "Specific Metrics" tab to the tab widget
 
+  // Add export button to write all the values to a file
+  export_button_ = new QPushButton("Export to CSV");
+  export_button_->setCheckable(true);
+  connect(
+    export_button_, &QPushButton::toggled, this, &MetricsVisualizePanel::onExportButtonToggled);
+
+  // Add checkbox to render the charts with OpenGL
+  opengl_checkbox_ = new QCheckBox("Render charts with OpenGL");
+  connect(opengl_checkbox_, &QCheckBox::toggled, this, &MetricsVisualizePanel::onOpenGLToggled);
+
   // Set the main layout of the panel
   QVBoxLayout * main_layout = new QVBoxLayout();
+  main_layout->addWidget(export_button_);
+  main_layout->addWidget(opengl_checkbox_);
   main_layout->addWidget(tab_widget_);
   setLayout(main_layout);
 }
@@ -105,6 +123,21 @@ void MetricsVisualizePanel::onInitialize()
   config_ = YAML::LoadFile(yaml_filepath);
 }
 
+void MetricsVisualizePanel::save(rviz_common::Config config) const
+{
+  rviz_common::Panel::save(config);
+  config.mapSetValue("UseOpenGL", opengl_checkbox_->isChecked());
+}
+
+void MetricsVisualizePanel::load(const rviz_common::Config & config)
+{
+  rviz_common::Panel::load(config);
+  bool use_opengl = false;
+  if (config.mapGetBool("UseOpenGL", &use_opengl)) {
+    opengl_checkbox_->setChecked(use_opengl);
+  }
+}
+
 void MetricsVisualizePanel::updateWidgetVisibility(
   const std::string & target_topic, const bool show)
 {
@@ -149,6 +182,7 @@ void MetricsVisualizePanel::updateSelectedMetric(const std::string & metric_name
       if (metric_name == status.name) {
         selected_metrics_ = {metric_name, Metric(status)};
         selected_metrics_->second.updateData(time, status);
+        selected_metrics_->second.showOnPlot(specific_metric_plot_);
         return;
       }
     }
@@ -189,17 +223,68 @@ void MetricsVisualizePanel::onClearButtonClicked()
   updateViews();
 }
 
+void MetricsVisualizePanel::onExportButtonToggled(const bool checked)
+{
+  if (!checked) {
+    exporter_.stop();
+    RCLCPP_INFO_STREAM(
+      rclcpp::get_logger("metrics_visualize_panel"),
+      "exported " << exporter_.getWrittenRowNum() << " values");
+    export_button_->setText("Export to CSV");
+    return;
+  }
+
+  const auto date = QDateTime::currentDateTime().toString("yyyy-MM-dd-hh-mm-ss").toStdString();
+  const auto file_name = "metrics_" + date + ".csv";
+  if (!exporter_.start(file_name)) {
+    RCLCPP_ERROR_STREAM(
+      rclcpp::get_logger("metrics_visualize_panel"), "failed to open " << file_name);
+    QSignalBlocker blocker(export_button_);
+    export_button_->setChecked(false);
+    return;
+  }
+  export_button_->setText(QString::fromStdString("Exporting to " + file_name));
+}
+
+void MetricsVisualizePanel::onOpenGLToggled(const bool checked)
+{
+  std::lock_guard<std::mutex> message_lock(mutex_);
+  use_opengl_ = checked;
+  for (auto & [name, metric] : metrics_) {
+    metric.setUseOpenGL(checked);
+  }
+  specific_metric_chart_view_->setVisible(!checked);
+  specific_metric_plot_->setVisible(checked);
+}
+
 void MetricsVisualizePanel::onTimer()
 {
   std::lock_guard<std::mutex> message_lock(mutex_);
 
-  for (auto & [name, metric] : metrics_) {
-    metric.updateGraph();
-    metric.updateTable();
+  for (const auto & [msg, topic_name] : message_queue_.drain()) {
+    processMetrics(msg, topic_name);
+  }
+
+  // render only the metrics of the current tab, and of the current topic in "All Metrics"
+  if (tab_widget_->currentIndex() == 0) {
+    const auto itr = topic_widgets_map_.find(topic_selector_->currentText().toStdString());
+    if (itr == topic_widgets_map_.end()) {
+      return;
+    }
+    for (const auto & [name, widgets] : itr->second) {
+      auto & metric = metrics_.at(name);
+      metric.updateGraph();
+      metric.updateTable();
+    }
+    return;
   }
 
   if (selected_metrics_) {
-    selected_metrics_->second.updateGraph();
+    if (use_opengl_) {
+      selected_metrics_->second.updatePlot(specific_metric_plot_);
+    } else {
+      selected_metrics_->second.updateGraph(specific_metric_chart_view_);
+    }
     selected_metrics_->second.updateTable();
   }
 }
@@ -207,15 +292,21 @@ void MetricsVisualizePanel::onTimer()
 void MetricsVisualizePanel::onMetrics(
   const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name)
 {
-  std::lock_guard<std::mutex> message_lock(mutex_);
+  message_queue_.push(msg, topic_name);
+  exporter_.push(msg, topic_name);
+}
 
+void MetricsVisualizePanel::processMetrics(
+  const DiagnosticArray::ConstSharedPtr & msg, const std::string & topic_name)
+{
   const auto time = msg->header.stamp.sec + msg->header.stamp.nanosec * 1e-9;
   constexpr size_t GRAPH_COL_SIZE = 5;
 
   for (const auto & status : msg->status) {
     const size_t num_current_metrics = topic_widgets_map_[topic_name].size();
     if (metrics_.count(status.name) == 0) {
-      const auto metric = Metric(status);
+      auto metric = Metric(status);
+      metric.setUseOpenGL(use_opengl_);
       metrics_.emplace(status.name, metric);
 
       // Calculate grid position
@@ -0,0 +1,378 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/gyro_bias_module.hpp"
+#include "deviation_estimator/stddev_accumulator.hpp"
+#include "deviation_estimator/trajectory_store.hpp"
+#include "deviation_estimator/utils.hpp"
+#include "deviation_estimator/velocity_coef_module.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+#include <rosbag2_cpp/writer.hpp>
+
+#include "autoware_vehicle_msgs/msg/velocity_report.hpp"
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "tf2_msgs/msg/tf_message.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// Costs of the estimation on synthetic drives of increasing length. The estimation of a time
+// window by timer_callback is measured after a drive of the given number of windows, so that a
+// growth of its cost with the elapsed time shows up, and the kernels and the unit tool are
+// measured in messages per second.
+
+namespace
+{
+// The gyro is sampled at 100 Hz, the velocity at 50 Hz and the pose at 10 Hz
+constexpr double gyro_rate = 100.0;
+constexpr size_t velocity_decimation = 2;
+constexpr size_t pose_decimation = 10;
+
+// the defaults of config/deviation_estimator.param.yaml
+constexpr double time_window = 4.0;
+constexpr double raw_data_buffer_duration = 60.0;
+constexpr double vx_threshold = 1.5;
+constexpr double wz_threshold = 0.01;
+constexpr double accel_threshold = 0.3;
+
+builtin_interfaces::msg::Time to_stamp(const double t)
+{
+  return rclcpp::Time(static_cast<int64_t>(t * 1e9));
+}
+
+size_t message_num(const TrajectoryData & data)
+{
+  return data.pose_list.size() + data.vx_list.size() + data.gyro_list.size();
+}
+
+// A drive at about 5 m/s with a slowly swaying yaw, which is straight and at a constant velocity
+// for the thresholds. The gyro has a bias and a noise, and each next() continues the drive
+class SyntheticDrive
+{
+public:
+  TrajectoryData next(const double duration)
+  {
+    TrajectoryData data;
+    const double dt = 1.0 / gyro_rate;
+    const auto step_num = static_cast<size_t>(std::lround(duration * gyro_rate));
+
+    for (size_t i = 0; i < step_num; ++i, ++step_) {
+      const double t = t_start_ + static_cast<double>(step_) * dt;
+      const double vx = 5.0 + 0.5 * std::sin(0.02 * t);
+      const double wz = 0.005 * std::cos(0.05 * t);
+
+      geometry_msgs::msg::Vector3Stamped gyro;
+      gyro.header.stamp = to_stamp(t);
+      gyro.header.frame_id = "imu_link";
+      gyro.vector.x = 0.001 + noise_(engine_);
+      gyro.vector.y = -0.002 + noise_(engine_);
+      gyro.vector.z = wz + 0.003 + noise_(engine_);
+      data.gyro_list.push_back(gyro);
+
+      if (step_ % velocity_decimation == 0) {
+        autoware_internal_debug_msgs::msg::Float64Stamped vx_msg;
+        vx_msg.stamp = to_stamp(t);
+        vx_msg.data = 1.01 * vx;
+        data.vx_list.push_back(vx_msg);
+      }
+
+      if (step_ % pose_decimation == 0) {
+        geometry_msgs::msg::PoseStamped pose;
+        pose.header.stamp = to_stamp(t);
+        pose.header.frame_id = "map";
+        pose.pose.position.x = x_;
+        pose.pose.position.y = y_;
+        tf2::Quaternion q;
+        q.setRPY(0.0, 0.0, yaw_);
+        pose.pose.orientation = tf2::toMsg(q);
+        data.pose_list.push_back(pose);
+      }
+
+      x_ += vx * std::cos(yaw_) * dt;
+      y_ += vx * std::sin(yaw_) * dt;
+      yaw_ += wz * dt;
+    }
+
+    return data;
+  }
+
+private:
+  const double t_start_{1.0};
+  size_t step_{0};
+  double x_{0.0};
+  double y_{0.0};
+  double yaw_{0.0};
+  std::mt19937 engine_{0};
+  std::normal_distribution<double> noise_{0.0, 0.01};
+};
+
+// timer_callback of DeviationEstimator with the default parameters, without the publishers and
+// TF. The raw data are added and evicted as by the callbacks
+class EstimationStep
+{
+public:
+  void add(const TrajectoryData & data)
+  {
+    for (const auto & vx : data.vx_list) store_.add_velocity(vx);
+    for (const auto & gyro : data.gyro_list) store_.add_gyro(gyro);
+    for (const auto & pose : data.pose_list) store_.add_pose(pose);
+
+    if (
+      !store_.vx_t.empty() &&
+      store_.vx_t.front() < store_.vx_t.back() - 2.0 * raw_data_buffer_duration) {
+      store_.evict_velocity(store_.vx_t.back() - raw_data_buffer_duration);
+    }
+    if (
+      !store_.gyro_t.empty() &&
+      store_.gyro_t.front() < store_.gyro_t.back() - 2.0 * raw_data_buffer_duration) {
+      store_.evict_gyro(store_.gyro_t.back() - raw_data_buffer_duration);
+    }
+  }
+
+  void run()
+  {
+    if (store_.gyro_t.empty() || store_.vx_t.empty() || store_.pose_t.empty()) return;
+    const double t0 = store_.pose_t.front();
+    const double t1 = store_.pose_t.back();
+    if (t1 <= t0) return;
+
+    const TrajectoryView view = store_.view(t0, t1);
+    if (view.vx.size() < 2 || view.gyro.size() < 2) {
+      store_.clear_pose();
+      return;
+    }
+    const bool is_straight = get_mean_abs_wz(view) < wz_threshold;
+    const bool is_moving = get_mean_abs_vx(view) > vx_threshold;
+    const bool is_constant_velocity = std::abs(get_mean_accel(view)) < accel_threshold;
+
+    if (whether_to_use_data(is_straight, is_moving, is_constant_velocity, true, true, true)) {
+      vel_coef_module_.update_coef(view);
+      stddev_accumulator_for_velocity_.add(view);
+    }
+    if (whether_to_use_data(is_straight, is_moving, is_constant_velocity, true, false, false)) {
+      gyro_bias_module_.update_bias(view);
+      stddev_accumulator_for_gyro_.add(view);
+    }
+
+    store_.clear_pose();
+    store_.evict_velocity(t1);
+    store_.evict_gyro(t1);
+
+    benchmark::DoNotOptimize(
+      stddev_accumulator_for_velocity_.estimate(vel_coef_module_.get_coef()));
+    benchmark::DoNotOptimize(
+      stddev_accumulator_for_gyro_.estimate(gyro_bias_module_.get_bias_base_link()).z);
+  }
+
+private:
+  TrajectoryStore store_;
+  GyroBiasModule gyro_bias_module_;
+  VelocityCoefModule vel_coef_module_;
+  VelocityStddevAccumulator stddev_accumulator_for_velocity_;
+  AngularVelocityStddevAccumulator stddev_accumulator_for_gyro_;
+};
+
+// the number of gyro samples of the kernels
+void setSampleSizes(benchmark::internal::Benchmark * b)
+{
+  b->RangeMultiplier(10)->Range(1000, 1000000);
+}
+
+// A bag of the topics of the unit tool, with the IMU in imu_link at the pose of base_link
+void write_bag(const std::string & uri, const double duration)
+{
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = uri;
+  storage_options.storage_id = "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::Writer writer;
+  writer.open(storage_options, converter_options);
+
+  tf2_msgs::msg::TFMessage tf_msg;
+  geometry_msgs::msg::TransformStamped transform;
+  transform.header.frame_id = "base_link";
+  transform.child_frame_id = "imu_link";
+  transform.transform.rotation.w = 1.0;
+  tf_msg.transforms.push_back(transform);
+  writer.write(tf_msg, "/tf_static", rclcpp::Time(0));
+
+  SyntheticDrive drive;
+  for (double t = 0.0; t < duration; t += time_window) {
+    const auto data = drive.next(time_window);
+
+    for (const auto & vx : data.vx_list) {
+      autoware_vehicle_msgs::msg::VelocityReport msg;
+      msg.header.stamp = vx.stamp;
+      msg.header.frame_id = "base_link";
+      msg.longitudinal_velocity = static_cast<float>(vx.data);
+      writer.write(msg, "/vehicle/status/velocity_status", rclcpp::Time(vx.stamp));
+    }
+    for (const auto & gyro : data.gyro_list) {
+      sensor_msgs::msg::Imu msg;
+      msg.header = gyro.header;
+      msg.angular_velocity = gyro.vector;
+      writer.write(msg, "/sensing/imu/tamagawa/imu_raw", rclcpp::Time(gyro.header.stamp));
+    }
+    for (const auto & pose : data.pose_list) {
+      geometry_msgs::msg::PoseWithCovarianceStamped msg;
+      msg.header = pose.header;
+      msg.pose.pose = pose.pose;
+      writer.write(
+        msg, "/localization/pose_estimator/pose_with_covariance",
+        rclcpp::Time(pose.header.stamp));
+    }
+  }
+}
+}  // namespace
+
+static void BM_TimerCallback(benchmark::State & state)
+{
+  SyntheticDrive drive;
+  EstimationStep step;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    step.add(drive.next(time_window));
+    step.run();
+  }
+
+  size_t processed_num = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    const auto data = drive.next(time_window);
+    processed_num += message_num(data);
+    step.add(data);
+    state.ResumeTiming();
+    step.run();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(processed_num));
+}
+// the elapsed windows of 4 s before the measurement, up to 4.5 hours of driving. The iterations
+// are fixed so that the drive before the measurement is run once
+BENCHMARK(BM_TimerCallback)->RangeMultiplier(16)->Range(1, 4096)->Iterations(100);
+
+static void BM_IntegratePosition(benchmark::State & state)
+{
+  SyntheticDrive drive;
+  const auto data = drive.next(static_cast<double>(state.range(0)) / gyro_rate);
+  const TrajectoryStore store = make_trajectory_store(data);
+  const TrajectoryView view = store.view();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(integrate_position(view, 1.0, 0.0));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(message_num(data)));
+}
+BENCHMARK(BM_IntegratePosition)->Apply(setSampleSizes);
+
+static void BM_IntegratePositionLists(benchmark::State & state)
+{
+  SyntheticDrive drive;
+  const auto data = drive.next(static_cast<double>(state.range(0)) / gyro_rate);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(integrate_position(data.vx_list, data.gyro_list, 1.0, 0.0));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(message_num(data)));
+}
+BENCHMARK(BM_IntegratePositionLists)->Apply(setSampleSizes);
+
+// a query on the whole list, which is converted for each query
+static void BM_InterpolateVector3Stamped(benchmark::State & state)
+{
+  SyntheticDrive drive;
+  const auto data = drive.next(static_cast<double>(state.range(0)) / gyro_rate);
+  const double t_mid = rclcpp::Time(data.gyro_list.at(data.gyro_list.size() / 2).header.stamp)
+                         .seconds() +
+                       0.5 / gyro_rate;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(interpolate_vector3_stamped(data.gyro_list, t_mid, 0.1));
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(data.gyro_list.size()));
+}
+BENCHMARK(BM_InterpolateVector3Stamped)->Apply(setSampleSizes);
+
+// the queries at the velocity timestamps over the whole drive, as in the dead reckoning
+static void BM_Vector3StampedInterpolator(benchmark::State & state)
+{
+  SyntheticDrive drive;
+  const auto data = drive.next(static_cast<double>(state.range(0)) / gyro_rate);
+  const TrajectoryStore store = make_trajectory_store(data);
+  for (auto _ : state) {
+    Vector3StampedInterpolator interpolator(store.view());
+    for (const double t : store.vx_t) {
+      benchmark::DoNotOptimize(interpolator.interpolate(t));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(store.vx_t.size()));
+}
+BENCHMARK(BM_Vector3StampedInterpolator)->Apply(setSampleSizes);
+
+// the middle half of the gyro
+static void BM_ExtractSubTrajectory(benchmark::State & state)
+{
+  SyntheticDrive drive;
+  const auto data = drive.next(static_cast<double>(state.range(0)) / gyro_rate);
+  const auto & gyro_list = data.gyro_list;
+  const rclcpp::Time t0(gyro_list.at(gyro_list.size() / 4).header.stamp);
+  const rclcpp::Time t1(gyro_list.at(gyro_list.size() * 3 / 4).header.stamp);
+  for (auto _ : state) {
+    const auto sub_list = extract_sub_trajectory(gyro_list, t0, t1);
+    benchmark::DoNotOptimize(sub_list.data());
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(gyro_list.size() / 2));
+}
+BENCHMARK(BM_ExtractSubTrajectory)->Apply(setSampleSizes);
+
+// The whole unit tool as a process on a bag of the given seconds with the given threads. The bag
+// is written once for each duration, and the results of the tool are written next to it
+static void BM_UnitTool(benchmark::State & state)
+{
+  const double duration = static_cast<double>(state.range(0));
+  const auto dir = std::filesystem::temp_directory_path() / "deviation_estimator_benchmark" /
+                   std::to_string(state.range(0));
+  const auto bag_path = dir / "bag";
+  if (!std::filesystem::exists(bag_path)) {
+    std::filesystem::create_directories(dir);
+    write_bag(bag_path.string(), duration);
+  }
+
+  const std::string command = "cd " + dir.string() + " && " + UNIT_TOOL_PATH + " " +
+                              bag_path.string() + " " + std::to_string(state.range(1)) +
+                              " > /dev/null";
+  for (auto _ : state) {
+    if (std::system(command.c_str()) != 0) {
+      state.SkipWithError("deviation_estimator_unit_tool failed");
+      break;
+    }
+  }
+
+  const auto step_num = static_cast<int64_t>(std::lround(duration * gyro_rate));
+  const auto bag_message_num =
+    step_num + step_num / static_cast<int64_t>(velocity_decimation) +
+    step_num / static_cast<int64_t>(pose_decimation);
+  state.SetItemsProcessed(state.iterations() * bag_message_num);
+}
+BENCHMARK(BM_UnitTool)
+  ->ArgsProduct({{60, 600, 3600}, {1, 4}})
+  ->Unit(benchmark::kSecond)
+  ->Iterations(3);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,60 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_ESTIMATOR__ASYNC_FILE_WRITER_HPP_
+#define DEVIATION_ESTIMATOR__ASYNC_FILE_WRITER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief replace the contents of files on a thread of its own, so that the caller never waits for
+ * the disk. Only the latest content of each file is written, at most once per flush period, to a
+ * temporary file which is then renamed to the file, so that a reader never sees a partial file.
+ */
+class AsyncFileWriter
+{
+public:
+  explicit AsyncFileWriter(const double flush_period_sec);
+  // the pending contents are written before the thread ends
+  ~AsyncFileWriter();
+  AsyncFileWriter(const AsyncFileWriter &) = delete;
+  AsyncFileWriter & operator=(const AsyncFileWriter &) = delete;
+
+  void write(const std::string & path, std::string content);
+
+  /**
+   * @brief block until the contents given so far are written
+   */
+  void flush();
+
+private:
+  void run();
+
+  const std::chrono::duration<double> flush_period_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable cv_written_;
+  std::map<std::string, std::string> pending_contents_;
+  bool is_writing_{false};
+  bool is_flush_requested_{false};
+  bool is_stopped_{false};
+  std::thread thread_;
+};
+
+#endif  // DEVIATION_ESTIMATOR__ASYNC_FILE_WRITER_HPP_
@@ -16,8 +16,11 @@
 #define DEVIATION_ESTIMATOR__DEVIATION_ESTIMATOR_HPP_
 
 #include "autoware/universe_utils/ros/transform_listener.hpp"
+#include "deviation_estimator/gyro_batch_estimator.hpp"
 #include "deviation_estimator/gyro_bias_module.hpp"
 #include "deviation_estimator/logger.hpp"
+#include "deviation_estimator/stddev_accumulator.hpp"
+#include "deviation_estimator/trajectory_store.hpp"
 #include "deviation_estimator/utils.hpp"
 #include "deviation_estimator/validation_module.hpp"
 #include "deviation_estimator/velocity_coef_module.hpp"
@@ -57,25 +60,33 @@ public:
   DeviationEstimator(const std::string & node_name, const rclcpp::NodeOptions & options);
 
 private:
+  /**
+   * @brief gyro of an IMU and the estimation of its bias and standard deviation. The IMUs share
+   * the poses, the velocity and the selection of the time windows.
+   */
+  struct ImuChannel
+  {
+    std::string frame;
+    TrajectoryStore store;  // only the gyro
+    GyroBatchEstimator gyro_estimator;
+    std::unique_ptr<ValidationModule> validation_module;
+    std::unique_ptr<Logger> results_logger;
+    rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr sub_imu;
+    rclcpp::Publisher<geometry_msgs::msg::Vector3>::SharedPtr pub_bias_angvel;
+    rclcpp::Publisher<geometry_msgs::msg::Vector3>::SharedPtr pub_stddev_angvel;
+  };
+
   rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>::SharedPtr sub_pose_with_cov_;
   rclcpp::Subscription<autoware_vehicle_msgs::msg::VelocityReport>::SharedPtr sub_wheel_odometry_;
-  rclcpp::Subscription<sensor_msgs::msg::Imu>::SharedPtr sub_imu_;
   rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr pub_coef_vx_;
-  rclcpp::Publisher<geometry_msgs::msg::Vector3>::SharedPtr pub_bias_angvel_;
   rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr pub_stddev_vx_;
-  rclcpp::Publisher<geometry_msgs::msg::Vector3>::SharedPtr pub_stddev_angvel_;
   rclcpp::TimerBase::SharedPtr timer_;
 
   tf2_ros::Buffer tf_buffer_;
   tf2_ros::TransformListener tf_listener_;
 
-  std::string imu_link_frame_;
-
-  std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> vx_all_;
-  std::vector<geometry_msgs::msg::Vector3Stamped> gyro_all_;
-  std::vector<geometry_msgs::msg::PoseStamped> pose_buf_;
-  std::vector<TrajectoryData> traj_data_list_for_gyro_;
-  std::vector<TrajectoryData> traj_data_list_for_velocity_;
+  TrajectoryStore store_;  // the poses and the velocity
+  VelocityStddevAccumulator stddev_accumulator_for_velocity_;
 
   double dt_design_;
   double dx_design_;
@@ -84,24 +95,25 @@ private:
   double accel_threshold_;
   double estimation_freq_;
   double time_window_;
+  double raw_data_buffer_duration_;
 
   bool gyro_only_use_straight_;
   bool gyro_only_use_moving_;
   bool gyro_only_use_constant_velocity_;
   bool gyro_add_bias_uncertainty_;
+  size_t gyro_bootstrap_num_;
+  double gyro_confidence_level_;
   bool velocity_only_use_straight_;
   bool velocity_only_use_moving_;
   bool velocity_only_use_constant_velocity_;
   bool velocity_add_bias_uncertainty_;
 
-  std::string imu_frame_;
   const std::string output_frame_;
   const std::string results_dir_;
-  const Logger results_logger_;
 
-  std::unique_ptr<GyroBiasModule> gyro_bias_module_;
+  // The first IMU is also used for the velocity and the selection of the time windows
+  std::vector<std::unique_ptr<ImuChannel>> imus_;
   std::unique_ptr<VelocityCoefModule> vel_coef_module_;
-  std::unique_ptr<ValidationModule> validation_module_;
 
   std::shared_ptr<autoware::universe_utils::TransformListener> transform_listener_;
 
@@ -110,10 +122,14 @@ private:
   void callback_wheel_odometry(
     const autoware_vehicle_msgs::msg::VelocityReport::ConstSharedPtr wheel_odometry_msg_ptr);
 
-  void callback_imu(const sensor_msgs::msg::Imu::ConstSharedPtr imu_msg_ptr);
+  void callback_imu(const sensor_msgs::msg::Imu::ConstSharedPtr imu_msg_ptr, ImuChannel & imu);
 
   void timer_callback();
 
+  void update_gyro(const std::vector<TrajectoryView> & traj_views);
+
+  void publish_gyro(ImuChannel & imu, const double coef_vx, const double stddev_vx);
+
   double add_bias_uncertainty_on_velocity(
     const double stddev_vx, const double stddev_coef_vx) const;
 
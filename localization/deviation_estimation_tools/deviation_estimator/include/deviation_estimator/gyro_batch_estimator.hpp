@@ -0,0 +1,70 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_ESTIMATOR__GYRO_BATCH_ESTIMATOR_HPP_
+#define DEVIATION_ESTIMATOR__GYRO_BATCH_ESTIMATOR_HPP_
+
+#include "deviation_estimator/utils.hpp"
+
+#include "geometry_msgs/msg/vector3.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief gyro bias and angular velocity standard deviation of the trajectories, from their
+ * sufficient statistics kept per trajectory in arrays. A trajectory is integrated once when it is
+ * added, and the estimation is one weighted least-squares fit of its error against its duration,
+ * so that the trajectories can also be resampled for confidence intervals.
+ */
+class GyroBatchEstimator
+{
+public:
+  struct Estimate
+  {
+    geometry_msgs::msg::Vector3 bias;
+    geometry_msgs::msg::Vector3 bias_std;
+    geometry_msgs::msg::Vector3 stddev;  // of the angular velocity, around the bias
+  };
+
+  struct Interval
+  {
+    Estimate lower;
+    Estimate upper;
+  };
+
+  GyroBatchEstimator() = default;
+  void add(const TrajectoryView & view);
+  void add(const TrajectoryData & traj_data);
+  size_t size() const { return dt_.size(); }
+
+  // the same as GyroBiasModule and AngularVelocityStddevAccumulator on the same trajectories
+  Estimate estimate() const;
+
+  // percentile bootstrap over the trajectories, with the replicates computed in parallel
+  Interval bootstrap(
+    const size_t replicate_num, const double confidence, const uint64_t seed = 0) const;
+
+private:
+  // the trajectories are weighted by the number of times they are drawn, or 1 without counts
+  Estimate estimate(const std::vector<uint32_t> * counts) const;
+
+  std::vector<double> dt_;                    // duration of the poses
+  std::vector<double> sqrt_n_;                // square root of the number of gyro samples
+  std::array<std::vector<double>, 3> error_;  // error of the integrated rpy, in the pose duration
+};
+
+#endif  // DEVIATION_ESTIMATOR__GYRO_BATCH_ESTIMATOR_HPP_
@@ -15,25 +15,28 @@
 #ifndef DEVIATION_ESTIMATOR__GYRO_BIAS_MODULE_HPP_
 #define DEVIATION_ESTIMATOR__GYRO_BIAS_MODULE_HPP_
 
+#include "deviation_estimator/stddev_accumulator.hpp"
 #include "deviation_estimator/utils.hpp"
 
 #include "geometry_msgs/msg/pose_stamped.hpp"
 #include "geometry_msgs/msg/vector3_stamped.hpp"
 
 #include <utility>
-#include <vector>
 
 class GyroBiasModule
 {
 public:
   GyroBiasModule() = default;
+  void update_bias(const TrajectoryView & view);
   void update_bias(const TrajectoryData & traj_data);
   geometry_msgs::msg::Vector3 get_bias_base_link() const;
   geometry_msgs::msg::Vector3 get_bias_std() const;
   bool empty() const;
 
 private:
-  std::vector<geometry_msgs::msg::Vector3> gyro_bias_list_;
+  RunningStatistics gyro_bias_x_;
+  RunningStatistics gyro_bias_y_;
+  RunningStatistics gyro_bias_z_;
   std::pair<geometry_msgs::msg::Vector3, geometry_msgs::msg::Vector3> gyro_bias_pair_;
 };
 
@@ -15,6 +15,8 @@
 #ifndef DEVIATION_ESTIMATOR__LOGGER_HPP_
 #define DEVIATION_ESTIMATOR__LOGGER_HPP_
 
+#include "deviation_estimator/async_file_writer.hpp"
+#include "deviation_estimator/gyro_batch_estimator.hpp"
 #include "deviation_estimator/utils.hpp"
 #include "deviation_estimator/validation_module.hpp"
 
@@ -22,22 +24,27 @@
 
 #include <fmt/core.h>
 
-#include <fstream>
+#include <memory>
 #include <string>
 
 class Logger
 {
 public:
-  explicit Logger(const std::string & output_dir);
+  // the results are written by a thread of its own at most once per flush_period_sec
+  explicit Logger(const std::string & output_dir, const double flush_period_sec = 1.0);
   void log_estimated_result_section(
     const double stddev_vx, const double coef_vx,
     const geometry_msgs::msg::Vector3 & angular_velocity_stddev,
     const geometry_msgs::msg::Vector3 & angular_velocity_offset) const;
   void log_validation_result_section(const ValidationModule & validation_module) const;
+  void log_confidence_interval_section(
+    const GyroBatchEstimator::Interval & interval, const double confidence) const;
 
 private:
   const std::string output_log_path_;
   const std::string output_imu_param_path_;
   const std::string output_velocity_param_path_;
+  const std::string output_confidence_interval_path_;
+  std::unique_ptr<AsyncFileWriter> writer_;
 };
 #endif  // DEVIATION_ESTIMATOR__LOGGER_HPP_
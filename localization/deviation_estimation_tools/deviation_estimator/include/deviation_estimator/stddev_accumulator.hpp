@@ -0,0 +1,104 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_ESTIMATOR__STDDEV_ACCUMULATOR_HPP_
+#define DEVIATION_ESTIMATOR__STDDEV_ACCUMULATOR_HPP_
+
+#include "deviation_estimator/utils.hpp"
+
+#include "geometry_msgs/msg/vector3.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief Welford's online algorithm for the mean and standard deviation of a stream of values
+ */
+class RunningStatistics
+{
+public:
+  RunningStatistics() = default;
+  void add(const double x);
+  size_t size() const { return n_; }
+  double mean() const { return mean_; }
+  double stddev() const;
+  double stddev_around(const double mean) const;
+
+private:
+  size_t n_{0};
+  double mean_{0.0};
+  double m2_{0.0};
+};
+
+/**
+ * @brief accumulate pairs (x, y) so that the standard deviation of x - c * y is calculated for
+ * any c in O(1)
+ */
+class LinearCombinationStddevAccumulator
+{
+public:
+  LinearCombinationStddevAccumulator() = default;
+  void add(const double x, const double y);
+  size_t size() const { return n_; }
+  double stddev(const double c) const;
+
+private:
+  size_t n_{0};
+  double mean_x_{0.0};
+  double mean_y_{0.0};
+  double m2_x_{0.0};
+  double m2_y_{0.0};
+  double c_xy_{0.0};
+};
+
+/**
+ * @brief incremental version of estimate_stddev_velocity. The error of each trajectory is linear
+ * in the velocity coefficient, so the trajectories do not have to be stored.
+ */
+class VelocityStddevAccumulator
+{
+public:
+  VelocityStddevAccumulator() = default;
+  void add(const TrajectoryView & view);
+  void add(const TrajectoryData & traj_data);
+  double estimate(const double coef_vx) const;
+  size_t size() const { return n_; }
+
+private:
+  size_t n_{0};
+  double t_window_sum_{0.0};
+  LinearCombinationStddevAccumulator delta_x_;
+};
+
+/**
+ * @brief incremental version of estimate_stddev_angular_velocity. The error of each trajectory is
+ * linear in the gyro bias unless the error wraps around at +-pi.
+ */
+class AngularVelocityStddevAccumulator
+{
+public:
+  AngularVelocityStddevAccumulator() = default;
+  void add(const TrajectoryView & view);
+  void add(const TrajectoryData & traj_data);
+  geometry_msgs::msg::Vector3 estimate(const geometry_msgs::msg::Vector3 & gyro_bias) const;
+  size_t size() const { return n_; }
+
+private:
+  size_t n_{0};
+  double t_window_sum_{0.0};
+  LinearCombinationStddevAccumulator delta_wx_;
+  LinearCombinationStddevAccumulator delta_wy_;
+  LinearCombinationStddevAccumulator delta_wz_;
+};
+
+#endif  // DEVIATION_ESTIMATOR__STDDEV_ACCUMULATOR_HPP_
@@ -0,0 +1,93 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_ESTIMATOR__TRAJECTORY_STORE_HPP_
+#define DEVIATION_ESTIMATOR__TRAJECTORY_STORE_HPP_
+
+#include "autoware_internal_debug_msgs/msg/float64_stamped.hpp"
+#include "geometry_msgs/msg/pose_stamped.hpp"
+#include "geometry_msgs/msg/vector3_stamped.hpp"
+
+#include <cstddef>
+#include <vector>
+
+struct TrajectoryData;
+struct TrajectoryView;
+
+/**
+ * @brief range [begin, end) of the indices of one kind of data in TrajectoryStore
+ */
+struct IndexSpan
+{
+  size_t begin{0};
+  size_t end{0};
+  size_t size() const { return end - begin; }
+  bool empty() const { return begin == end; }
+  size_t front() const { return begin; }
+  size_t back() const { return end - 1; }
+};
+
+/**
+ * @brief structure-of-arrays of the velocity, gyro and pose. The timestamps are converted to
+ * seconds and the orientations to RPY only once, when the data are added.
+ */
+struct TrajectoryStore
+{
+  std::vector<double> vx_t;
+  std::vector<double> vx;
+
+  std::vector<double> gyro_t;
+  std::vector<double> wx;
+  std::vector<double> wy;
+  std::vector<double> wz;
+
+  std::vector<double> pose_t;
+  std::vector<double> pose_x;
+  std::vector<double> pose_y;
+  std::vector<double> pose_roll;
+  std::vector<double> pose_pitch;
+  std::vector<double> pose_yaw;
+
+  void add_velocity(const autoware_internal_debug_msgs::msg::Float64Stamped & vx_msg);
+  void add_gyro(const geometry_msgs::msg::Vector3Stamped & gyro);
+  void add_pose(const geometry_msgs::msg::PoseStamped & pose);
+
+  void evict_velocity(const double t_sec);
+  void evict_gyro(const double t_sec);
+  void clear_pose();
+
+  TrajectoryView view() const;
+  TrajectoryView view(const double t0_sec, const double t1_sec) const;
+  // the same with the gyro of another store, so that several IMUs share the pose and velocity
+  TrajectoryView view(
+    const double t0_sec, const double t1_sec, const TrajectoryStore & gyro_store) const;
+  TrajectoryView slice(const double t0_sec, const double t1_sec) const;
+};
+
+/**
+ * @brief trajectory as the spans of a TrajectoryStore, which must outlive the view. The gyro span
+ * is of gyro_store, which is the same as store unless the gyro is of another IMU.
+ */
+struct TrajectoryView
+{
+  const TrajectoryStore * store{nullptr};
+  const TrajectoryStore * gyro_store{nullptr};
+  IndexSpan pose;
+  IndexSpan vx;
+  IndexSpan gyro;
+};
+
+TrajectoryStore make_trajectory_store(const TrajectoryData & traj_data);
+
+#endif  // DEVIATION_ESTIMATOR__TRAJECTORY_STORE_HPP_
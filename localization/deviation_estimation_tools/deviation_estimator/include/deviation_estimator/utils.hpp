@@ -16,6 +16,7 @@
 #define DEVIATION_ESTIMATOR__UTILS_HPP_
 
 #include "deviation_estimator/autoware_universe_utils.hpp"
+#include "deviation_estimator/trajectory_store.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 #include "autoware_internal_debug_msgs/msg/float64_stamped.hpp"
@@ -25,6 +26,7 @@
 
 #include <tf2/transform_datatypes.h>
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -142,15 +144,41 @@ geometry_msgs::msg::Vector3 interpolate_vector3_stamped(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list, const double time,
   const double tolerance_sec);
 
-template <typename T>
-std::vector<T> extract_sub_trajectory(
-  const std::vector<T> & msg_list, const rclcpp::Time & t0, const rclcpp::Time & t1)
+/**
+ * @brief interpolation on "vec_list" for increasing query times. The timestamps are converted once,
+ * and the cursor moves forward with the queries, so that the queries over a whole trajectory are
+ * linear in total. A query going back in time falls back to a binary search.
+ */
+class Vector3StampedInterpolator
+{
+public:
+  explicit Vector3StampedInterpolator(
+    const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list,
+    const double tolerance_sec = 0.1);
+  // interpolation on the gyro of the view, without copying it
+  explicit Vector3StampedInterpolator(
+    const TrajectoryView & view, const double tolerance_sec = 0.1);
+  Vector3StampedInterpolator(const Vector3StampedInterpolator &) = delete;
+  Vector3StampedInterpolator & operator=(const Vector3StampedInterpolator &) = delete;
+  geometry_msgs::msg::Vector3 interpolate(const double time);
+
+private:
+  TrajectoryStore owned_store_;
+  const TrajectoryStore * store_;
+  IndexSpan span_;
+  const double tolerance_sec_;
+  size_t next_idx_{0};
+};
+
+template <typename Container>
+std::vector<typename Container::value_type> extract_sub_trajectory(
+  const Container & msg_list, const rclcpp::Time & t0, const rclcpp::Time & t1)
 {
   const auto start_iter =
     std::lower_bound(msg_list.begin(), msg_list.end(), t0, CompareMsgTimestamp());
   const auto end_iter =
     std::lower_bound(msg_list.begin(), msg_list.end(), t1, CompareMsgTimestamp());
-  std::vector<T> msg_list_sub(start_iter, end_iter);
+  std::vector<typename Container::value_type> msg_list_sub(start_iter, end_iter);
   return msg_list_sub;
 }
 
@@ -164,23 +192,32 @@ double norm_xy(const T p1, const U p2)
 
 double clip_radian(const double rad);
 
+geometry_msgs::msg::Point integrate_position(
+  const TrajectoryView & view, const double coef_vx, const double yaw_init);
 geometry_msgs::msg::Point integrate_position(
   const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list,
   const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list, const double coef_vx,
   const double yaw_init);
 
+geometry_msgs::msg::Vector3 calculate_error_rpy(
+  const TrajectoryView & view, const geometry_msgs::msg::Vector3 & gyro_bias);
 geometry_msgs::msg::Vector3 calculate_error_rpy(
   const std::vector<geometry_msgs::msg::PoseStamped> & pose_list,
   const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
   const geometry_msgs::msg::Vector3 & gyro_bias);
 
+geometry_msgs::msg::Vector3 integrate_orientation(
+  const TrajectoryView & view, const geometry_msgs::msg::Vector3 & gyro_bias);
 geometry_msgs::msg::Vector3 integrate_orientation(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
   const geometry_msgs::msg::Vector3 & gyro_bias);
 
+double get_mean_abs_vx(const TrajectoryView & view);
 double get_mean_abs_vx(
   const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list);
+double get_mean_abs_wz(const TrajectoryView & view);
 double get_mean_abs_wz(const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list);
+double get_mean_accel(const TrajectoryView & view);
 double get_mean_accel(
   const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list);
 
@@ -21,12 +21,38 @@
 
 #include <fmt/core.h>
 
+#include <deque>
 #include <limits>
 #include <map>
 #include <string>
 #include <utility>
 #include <vector>
 
+/**
+ * @brief min, max and percentiles of the last "capacity" values. The min and max are kept by
+ * monotonic deques and the percentiles by a sorted copy of the window, so that no query scans the
+ * history. NaN values are in the window but are ignored by the statistics.
+ */
+class SlidingWindowStatistics
+{
+public:
+  explicit SlidingWindowStatistics(const size_t capacity);
+  void add(const double value);
+  size_t size() const;
+  double back() const;
+  double min() const;
+  double max() const;
+  double percentile(const double ratio) const;
+
+private:
+  const size_t capacity_;
+  size_t count_{0};
+  std::deque<double> values_;
+  std::deque<std::pair<size_t, double>> min_queue_;
+  std::deque<std::pair<size_t, double>> max_queue_;
+  std::vector<double> sorted_values_;
+};
+
 class ValidationModule
 {
 public:
@@ -38,10 +64,14 @@ public:
     const geometry_msgs::msg::Vector3 & bias_gyro, const geometry_msgs::msg::Vector3 & stddev_gyro);
 
   std::pair<double, double> get_min_max(const std::string key) const;
+  double get_percentile(const std::string key, const double ratio) const;
   bool is_valid(const std::string key) const;
 
 private:
-  std::map<std::string, std::vector<double>> data_list_dict_;
+  void add_data(const std::string & key, const double value);
+  const SlidingWindowStatistics & get_data(const std::string & key) const;
+
+  std::map<std::string, SlidingWindowStatistics> data_list_dict_;
 
   std::map<std::string, double> threshold_dict_;
   const size_t num_history_;
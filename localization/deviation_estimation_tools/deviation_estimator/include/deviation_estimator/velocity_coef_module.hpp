@@ -15,6 +15,7 @@
 #ifndef DEVIATION_ESTIMATOR__VELOCITY_COEF_MODULE_HPP_
 #define DEVIATION_ESTIMATOR__VELOCITY_COEF_MODULE_HPP_
 
+#include "deviation_estimator/stddev_accumulator.hpp"
 #include "deviation_estimator/utils.hpp"
 
 #include "autoware_internal_debug_msgs/msg/float64_stamped.hpp"
@@ -22,19 +23,19 @@
 #include "geometry_msgs/msg/vector3_stamped.hpp"
 
 #include <utility>
-#include <vector>
 
 class VelocityCoefModule
 {
 public:
   VelocityCoefModule() = default;
+  void update_coef(const TrajectoryView & view);
   void update_coef(const TrajectoryData & traj_data);
   double get_coef() const;
   double get_coef_std() const;
   bool empty() const;
 
 private:
-  std::vector<double> coef_vx_list_;
+  RunningStatistics coef_vx_statistics_;
   std::pair<double, double> coef_vx_;
 };
 
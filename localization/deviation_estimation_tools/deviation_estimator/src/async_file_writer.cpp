@@ -0,0 +1,105 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/async_file_writer.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace
+{
+/**
+ * @brief write to "path.tmp" and rename it to "path", which replaces the file atomically
+ */
+void write_atomically(const std::string & path, const std::string & content)
+{
+  const std::string tmp_path = path + ".tmp";
+  std::ofstream file(tmp_path, std::ios::trunc);
+  file << content;
+  file.close();
+  if (!file) {
+    std::cerr << "Failed to write " << tmp_path << std::endl;
+    std::remove(tmp_path.c_str());
+    return;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::cerr << "Failed to rename " << tmp_path << " to " << path << std::endl;
+    std::remove(tmp_path.c_str());
+  }
+}
+}  // namespace
+
+AsyncFileWriter::AsyncFileWriter(const double flush_period_sec)
+: flush_period_(std::max(flush_period_sec, 0.0)), thread_(&AsyncFileWriter::run, this)
+{
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_stopped_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+void AsyncFileWriter::write(const std::string & path, std::string content)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_contents_[path] = std::move(content);
+  }
+  cv_.notify_all();
+}
+
+void AsyncFileWriter::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  is_flush_requested_ = true;
+  cv_.notify_all();
+  cv_written_.wait(lock, [this]() { return pending_contents_.empty() && !is_writing_; });
+}
+
+void AsyncFileWriter::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this]() {
+      return is_stopped_ || is_flush_requested_ || !pending_contents_.empty();
+    });
+    // The contents given in a flush period replace each other, and only the last ones are written
+    cv_.wait_for(lock, flush_period_, [this]() { return is_stopped_ || is_flush_requested_; });
+
+    std::map<std::string, std::string> contents;
+    contents.swap(pending_contents_);
+    is_flush_requested_ = false;
+    is_writing_ = true;
+    lock.unlock();
+    for (const auto & [path, content] : contents) {
+      write_atomically(path, content);
+    }
+    lock.lock();
+    is_writing_ = false;
+    cv_written_.notify_all();
+
+    if (is_stopped_ && pending_contents_.empty()) {
+      return;
+    }
+  }
+}
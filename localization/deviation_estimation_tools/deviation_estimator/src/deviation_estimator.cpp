@@ -19,7 +19,11 @@
 #include "deviation_estimator/utils.hpp"
 #include "rclcpp/logging.hpp"
 
+#include <autoware/profiling_utils/profiling_utils.hpp>
+#include <autoware/task_scheduler/task_scheduler.hpp>
+
 #include <algorithm>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <string>
@@ -124,8 +128,7 @@ DeviationEstimator::DeviationEstimator(
   tf_buffer_(this->get_clock()),
   tf_listener_(tf_buffer_),
   output_frame_(declare_parameter<std::string>("output_frame")),
-  results_dir_(declare_parameter<std::string>("results_dir")),
-  results_logger_(results_dir_)
+  results_dir_(declare_parameter<std::string>("results_dir"))
 {
   dt_design_ = declare_parameter<double>("dt_design");
   dx_design_ = declare_parameter<double>("dx_design");
@@ -133,6 +136,7 @@ DeviationEstimator::DeviationEstimator(
   wz_threshold_ = declare_parameter<double>("wz_threshold");
   accel_threshold_ = declare_parameter<double>("accel_threshold");
   time_window_ = declare_parameter<double>("time_window");
+  raw_data_buffer_duration_ = declare_parameter<double>("raw_data_buffer_duration");
 
   // flags for deciding which trajectory to use
   gyro_only_use_straight_ = declare_parameter<bool>("gyro_estimation.only_use_straight");
@@ -140,6 +144,8 @@ DeviationEstimator::DeviationEstimator(
   gyro_only_use_constant_velocity_ =
     declare_parameter<bool>("gyro_estimation.only_use_constant_velocity");
   gyro_add_bias_uncertainty_ = declare_parameter<bool>("gyro_estimation.add_bias_uncertainty");
+  gyro_bootstrap_num_ = std::max(declare_parameter<int>("gyro_estimation.bootstrap_num", 0), 0);
+  gyro_confidence_level_ = declare_parameter<double>("gyro_estimation.confidence_level", 0.95);
   velocity_only_use_straight_ = declare_parameter<bool>("velocity_estimation.only_use_straight");
   velocity_only_use_moving_ = declare_parameter<bool>("velocity_estimation.only_use_moving");
   velocity_only_use_constant_velocity_ =
@@ -159,27 +165,45 @@ DeviationEstimator::DeviationEstimator(
     "in_pose_with_covariance", 1,
     std::bind(&DeviationEstimator::callback_pose_with_covariance, this, _1));
   pub_coef_vx_ = create_publisher<std_msgs::msg::Float64>("estimated_coef_vx", 1);
-  pub_bias_angvel_ =
-    create_publisher<geometry_msgs::msg::Vector3>("estimated_bias_angular_velocity", 1);
   pub_stddev_vx_ = create_publisher<std_msgs::msg::Float64>("estimated_stddev_vx", 1);
-  pub_stddev_angvel_ =
-    create_publisher<geometry_msgs::msg::Vector3>("estimated_stddev_angular_velocity", 1);
 
-  sub_imu_ = create_subscription<sensor_msgs::msg::Imu>(
-    "in_imu", 1, std::bind(&DeviationEstimator::callback_imu, this, _1));
   sub_wheel_odometry_ = create_subscription<autoware_vehicle_msgs::msg::VelocityReport>(
     "in_wheel_odometry", 1, std::bind(&DeviationEstimator::callback_wheel_odometry, this, _1));
-  results_logger_.log_estimated_result_section(
-    0.2, 0.0, geometry_msgs::msg::Vector3{}, geometry_msgs::msg::Vector3{});
 
-  gyro_bias_module_ = std::make_unique<GyroBiasModule>();
+  // With several IMUs, the topics of the i-th IMU end with "_i" and its results are in "imu_i"
+  const size_t imu_num = std::max(declare_parameter<int>("imu_num", 1), 1);
+  const double results_flush_period = declare_parameter<double>("results_flush_period");
+  const double thres_coef_vx = declare_parameter<double>("thres_coef_vx");
+  const double thres_stddev_vx = declare_parameter<double>("thres_stddev_vx");
+  const double thres_bias_gyro = declare_parameter<double>("thres_bias_gyro");
+  const double thres_stddev_gyro = declare_parameter<double>("thres_stddev_gyro");
+  for (size_t i = 0; i < imu_num; ++i) {
+    const std::string suffix = imu_num == 1 ? "" : "_" + std::to_string(i);
+    const std::string results_dir =
+      imu_num == 1 ? results_dir_ : results_dir_ + "/imu_" + std::to_string(i);
+    std::filesystem::create_directories(results_dir);
+
+    auto & imu = *imus_.emplace_back(std::make_unique<ImuChannel>());
+    imu.validation_module = std::make_unique<ValidationModule>(
+      thres_coef_vx, thres_stddev_vx, thres_bias_gyro, thres_stddev_gyro, 5);
+    imu.results_logger = std::make_unique<Logger>(results_dir, results_flush_period);
+    imu.results_logger->log_estimated_result_section(
+      0.2, 0.0, geometry_msgs::msg::Vector3{}, geometry_msgs::msg::Vector3{});
+    imu.sub_imu = create_subscription<sensor_msgs::msg::Imu>(
+      "in_imu" + suffix, 1, [this, &imu](const sensor_msgs::msg::Imu::ConstSharedPtr msg) {
+        callback_imu(msg, imu);
+      });
+    imu.pub_bias_angvel =
+      create_publisher<geometry_msgs::msg::Vector3>("estimated_bias_angular_velocity" + suffix, 1);
+    imu.pub_stddev_angvel = create_publisher<geometry_msgs::msg::Vector3>(
+      "estimated_stddev_angular_velocity" + suffix, 1);
+  }
+
   vel_coef_module_ = std::make_unique<VelocityCoefModule>();
-  validation_module_ = std::make_unique<ValidationModule>(
-    declare_parameter<double>("thres_coef_vx"), declare_parameter<double>("thres_stddev_vx"),
-    declare_parameter<double>("thres_bias_gyro"), declare_parameter<double>("thres_stddev_gyro"),
-    5);
   transform_listener_ = std::make_shared<autoware::universe_utils::TransformListener>(this);
 
+  AUTOWARE_PROFILE_INIT(*this);
+
   RCLCPP_INFO(this->get_logger(), "[Deviation Estimator] launch success");
 }
 
@@ -193,7 +217,7 @@ void DeviationEstimator::callback_pose_with_covariance(
   geometry_msgs::msg::PoseStamped pose;
   pose.header = msg->header;
   pose.pose = msg->pose.pose;
-  pose_buf_.push_back(pose);
+  store_.add_pose(pose);
 }
 
 /**
@@ -206,21 +230,27 @@ void DeviationEstimator::callback_wheel_odometry(
   vx.stamp = wheel_odometry_msg_ptr->header.stamp;
   vx.data = wheel_odometry_msg_ptr->longitudinal_velocity;
 
-  vx_all_.push_back(vx);
+  store_.add_velocity(vx);
+  // Evict in chunks, since removing the front of the arrays moves all the rest of them
+  const double latest_vx_time = store_.vx_t.back();
+  if (store_.vx_t.front() < latest_vx_time - 2.0 * raw_data_buffer_duration_) {
+    store_.evict_velocity(latest_vx_time - raw_data_buffer_duration_);
+  }
 }
 
 /**
  * @brief receive IMU data, transform it into a required frame, and store it in a buffer
  */
-void DeviationEstimator::callback_imu(const sensor_msgs::msg::Imu::ConstSharedPtr imu_msg_ptr)
+void DeviationEstimator::callback_imu(
+  const sensor_msgs::msg::Imu::ConstSharedPtr imu_msg_ptr, ImuChannel & imu)
 {
-  imu_frame_ = imu_msg_ptr->header.frame_id;
+  imu.frame = imu_msg_ptr->header.frame_id;
   geometry_msgs::msg::TransformStamped::ConstSharedPtr tf_imu2base_ptr =
-    transform_listener_->getLatestTransform(imu_frame_, output_frame_);
+    transform_listener_->getLatestTransform(imu.frame, output_frame_);
   if (!tf_imu2base_ptr) {
     RCLCPP_ERROR(
       this->get_logger(), "Please publish TF %s to %s", output_frame_.c_str(),
-      (imu_frame_).c_str());
+      (imu.frame).c_str());
     return;
   }
 
@@ -228,7 +258,11 @@ void DeviationEstimator::callback_imu(const sensor_msgs::msg::Imu::ConstSharedPt
   gyro.header.stamp = imu_msg_ptr->header.stamp;
   gyro.vector = transform_vector3(imu_msg_ptr->angular_velocity, *tf_imu2base_ptr);
 
-  gyro_all_.push_back(gyro);
+  imu.store.add_gyro(gyro);
+  const double latest_gyro_time = imu.store.gyro_t.back();
+  if (imu.store.gyro_t.front() < latest_gyro_time - 2.0 * raw_data_buffer_duration_) {
+    imu.store.evict_gyro(latest_gyro_time - raw_data_buffer_duration_);
+  }
 }
 
 /**
@@ -236,26 +270,39 @@ void DeviationEstimator::callback_imu(const sensor_msgs::msg::Imu::ConstSharedPt
  */
 void DeviationEstimator::timer_callback()
 {
-  if (gyro_all_.empty()) {
+  AUTOWARE_PROFILE_FUNCTION();
+  const TrajectoryStore & primary_gyro_store = imus_.front()->store;
+  AUTOWARE_PROFILE_COUNTER(
+    "gyro_buffer_size", static_cast<double>(primary_gyro_store.gyro_t.size()));
+  AUTOWARE_PROFILE_COUNTER("vx_buffer_size", static_cast<double>(store_.vx_t.size()));
+  if (primary_gyro_store.gyro_t.empty()) {
     RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "No IMU data");
     return;
   }
-  if (vx_all_.empty()) {
+  if (store_.vx_t.empty()) {
     RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "No wheel odometry");
     return;
   }
-  if (pose_buf_.size() == 0) return;
-  rclcpp::Time t0_rclcpp_time = rclcpp::Time(pose_buf_.front().header.stamp);
-  rclcpp::Time t1_rclcpp_time = rclcpp::Time(pose_buf_.back().header.stamp);
-  if (t1_rclcpp_time <= t0_rclcpp_time) return;
-
-  TrajectoryData traj_data;
-  traj_data.pose_list = pose_buf_;
-  traj_data.vx_list = extract_sub_trajectory(vx_all_, t0_rclcpp_time, t1_rclcpp_time);
-  traj_data.gyro_list = extract_sub_trajectory(gyro_all_, t0_rclcpp_time, t1_rclcpp_time);
-  bool is_straight = get_mean_abs_wz(traj_data.gyro_list) < wz_threshold_;
-  bool is_moving = get_mean_abs_vx(traj_data.vx_list) > vx_threshold_;
-  bool is_constant_velocity = std::abs(get_mean_accel(traj_data.vx_list)) < accel_threshold_;
+  if (store_.pose_t.empty()) return;
+  const double t0 = store_.pose_t.front();
+  const double t1 = store_.pose_t.back();
+  if (t1 <= t0) return;
+
+  // The time window is the same for all the IMUs, and is selected with the first one
+  std::vector<TrajectoryView> traj_views;
+  for (const auto & imu : imus_) {
+    traj_views.push_back(store_.view(t0, t1, imu->store));
+  }
+  const TrajectoryView & traj_view = traj_views.front();
+  if (traj_view.vx.size() < 2 || traj_view.gyro.size() < 2) {
+    // The raw data of the poses may have been evicted from the buffers.
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "No raw data in the time window");
+    store_.clear_pose();
+    return;
+  }
+  bool is_straight = get_mean_abs_wz(traj_view) < wz_threshold_;
+  bool is_moving = get_mean_abs_vx(traj_view) > vx_threshold_;
+  bool is_constant_velocity = std::abs(get_mean_accel(traj_view)) < accel_threshold_;
 
   const bool use_gyro = whether_to_use_data(
     is_straight, is_moving, is_constant_velocity, gyro_only_use_straight_, gyro_only_use_moving_,
@@ -264,48 +311,81 @@ void DeviationEstimator::timer_callback()
     is_straight, is_moving, is_constant_velocity, velocity_only_use_straight_,
     velocity_only_use_moving_, velocity_only_use_constant_velocity_);
   if (use_velocity) {
-    vel_coef_module_->update_coef(traj_data);
-    traj_data_list_for_velocity_.push_back(traj_data);
+    AUTOWARE_PROFILE_SCOPE("update_velocity");
+    vel_coef_module_->update_coef(traj_view);
+    stddev_accumulator_for_velocity_.add(traj_view);
   }
   if (use_gyro) {
-    gyro_bias_module_->update_bias(traj_data);
-    traj_data_list_for_gyro_.push_back(traj_data);
+    AUTOWARE_PROFILE_SCOPE("update_gyro");
+    update_gyro(traj_views);
   }
 
-  pose_buf_.clear();
+  // The next trajectory starts after the last pose, so the older raw data are no longer used.
+  store_.clear_pose();
+  store_.evict_velocity(t1);
+  for (auto & imu : imus_) {
+    imu->store.evict_gyro(t1);
+  }
 
-  double stddev_vx =
-    estimate_stddev_velocity(traj_data_list_for_velocity_, vel_coef_module_->get_coef());
+  AUTOWARE_PROFILE_SCOPE("estimate_stddev");
+  const double coef_vx = vel_coef_module_->get_coef();
+  double stddev_vx = stddev_accumulator_for_velocity_.estimate(coef_vx);
   if (velocity_add_bias_uncertainty_) {
     stddev_vx = add_bias_uncertainty_on_velocity(stddev_vx, vel_coef_module_->get_coef_std());
   }
 
-  auto stddev_angvel_base = estimate_stddev_angular_velocity(
-    traj_data_list_for_gyro_, gyro_bias_module_->get_bias_base_link());
-  if (gyro_add_bias_uncertainty_) {
-    stddev_angvel_base = add_bias_uncertainty_on_angular_velocity(
-      stddev_angvel_base, gyro_bias_module_->get_bias_std());
-  }
-
   // publish messages
   std_msgs::msg::Float64 coef_vx_msg;
-  coef_vx_msg.data = vel_coef_module_->get_coef();
+  coef_vx_msg.data = coef_vx;
   pub_coef_vx_->publish(coef_vx_msg);
 
+  std_msgs::msg::Float64 stddev_vx_msg;
+  stddev_vx_msg.data = stddev_vx;
+  pub_stddev_vx_->publish(stddev_vx_msg);
+
+  for (auto & imu : imus_) {
+    publish_gyro(*imu, coef_vx, stddev_vx);
+  }
+}
+
+/**
+ * @brief update the gyro bias and standard deviation of each IMU. The IMUs are updated in parallel
+ * by the scheduler of the process, as they only read the shared poses and velocity.
+ */
+void DeviationEstimator::update_gyro(const std::vector<TrajectoryView> & traj_views)
+{
+  autoware::task_scheduler::TaskScheduler::global().parallel_for(
+    imus_.size(), [this, &traj_views](const size_t i) {
+      if (traj_views[i].gyro.size() < 2) return;
+      imus_[i]->gyro_estimator.add(traj_views[i]);
+    });
+}
+
+/**
+ * @brief publish and log the estimated gyro bias and standard deviation of an IMU
+ */
+void DeviationEstimator::publish_gyro(
+  ImuChannel & imu, const double coef_vx, const double stddev_vx)
+{
+  if (imu.frame.empty()) return;
+
+  const auto estimate = imu.gyro_estimator.estimate();
+  auto stddev_angvel_base = estimate.stddev;
+  if (gyro_add_bias_uncertainty_) {
+    stddev_angvel_base =
+      add_bias_uncertainty_on_angular_velocity(stddev_angvel_base, estimate.bias_std);
+  }
+
   geometry_msgs::msg::TransformStamped::ConstSharedPtr tf_base2imu_ptr =
-    transform_listener_->getLatestTransform(output_frame_, imu_frame_);
+    transform_listener_->getLatestTransform(output_frame_, imu.frame);
   if (!tf_base2imu_ptr) {
     RCLCPP_ERROR(
-      this->get_logger(), "Please publish TF %s to %s", imu_frame_.c_str(), output_frame_.c_str());
+      this->get_logger(), "Please publish TF %s to %s", imu.frame.c_str(), output_frame_.c_str());
     return;
   }
   const geometry_msgs::msg::Vector3 bias_angvel_imu =
-    transform_vector3(gyro_bias_module_->get_bias_base_link(), *tf_base2imu_ptr);
-  pub_bias_angvel_->publish(bias_angvel_imu);
-
-  std_msgs::msg::Float64 stddev_vx_msg;
-  stddev_vx_msg.data = stddev_vx;
-  pub_stddev_vx_->publish(stddev_vx_msg);
+    transform_vector3(estimate.bias, *tf_base2imu_ptr);
+  imu.pub_bias_angvel->publish(bias_angvel_imu);
 
   // For IMU link standard deviation, we use the yaw standard deviation in base_link.
   // This is because the standard deviation estimation of x and y in base_link may not be accurate
@@ -315,14 +395,21 @@ void DeviationEstimator::timer_callback()
   double stddev_angvel_imu = stddev_angvel_base.z;
   geometry_msgs::msg::Vector3 stddev_angvel_imu_msg =
     createVector3(stddev_angvel_imu, stddev_angvel_imu, stddev_angvel_imu);
-  pub_stddev_angvel_->publish(stddev_angvel_imu_msg);
+  imu.pub_stddev_angvel->publish(stddev_angvel_imu_msg);
 
-  validation_module_->set_velocity_data(vel_coef_module_->get_coef(), stddev_vx);
-  validation_module_->set_gyro_data(bias_angvel_imu, stddev_angvel_imu_msg);
+  imu.validation_module->set_velocity_data(coef_vx, stddev_vx);
+  imu.validation_module->set_gyro_data(bias_angvel_imu, stddev_angvel_imu_msg);
 
-  results_logger_.log_estimated_result_section(
-    stddev_vx, vel_coef_module_->get_coef(), stddev_angvel_imu_msg, bias_angvel_imu);
-  results_logger_.log_validation_result_section(*validation_module_);
+  imu.results_logger->log_estimated_result_section(
+    stddev_vx, coef_vx, stddev_angvel_imu_msg, bias_angvel_imu);
+  imu.results_logger->log_validation_result_section(*imu.validation_module);
+
+  if (gyro_bootstrap_num_ > 0) {
+    AUTOWARE_PROFILE_SCOPE("bootstrap_gyro");
+    imu.results_logger->log_confidence_interval_section(
+      imu.gyro_estimator.bootstrap(gyro_bootstrap_num_, gyro_confidence_level_),
+      gyro_confidence_level_);
+  }
 }
 
 /**
@@ -12,47 +12,211 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "autoware/bag_index/cdr_view.hpp"
+#include "autoware/task_scheduler/bounded_queue.hpp"
+#include "autoware/task_scheduler/budget.hpp"
+#include "autoware/task_scheduler/task_scheduler.hpp"
 #include "deviation_estimator/deviation_estimator.hpp"
 
 #include <ament_index_cpp/get_package_share_directory.hpp>
 #include <rclcpp/serialization.hpp>
 #include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
 
 #include <algorithm>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
+#include <variant>
 #include <vector>
 
+namespace
+{
+namespace cdr = autoware::bag_index::cdr;
+using autoware::task_scheduler::BoundedQueue;
+
+const char * const TOPIC_VELOCITY_STATUS = "/vehicle/status/velocity_status";
+const char * const TOPIC_TF_STATIC = "/tf_static";
+const char * const TOPIC_IMU = "/sensing/imu/tamagawa/imu_raw";
+const char * const TOPIC_POSE = "/localization/pose_estimator/pose_with_covariance";
+
+// Number of the messages deserialized at once by a worker thread
+constexpr size_t BATCH_SIZE = 1000;
+
+// IMU is kept in its own frame, whose ID is in the header, until it is transformed to base_link
+using DecodedMessage = std::variant<
+  autoware_internal_debug_msgs::msg::Float64Stamped, tf2_msgs::msg::TFMessage,
+  geometry_msgs::msg::Vector3Stamped, geometry_msgs::msg::PoseStamped>;
+using DecodedBatch = std::vector<DecodedMessage>;
+using DecodeTask = std::pair<
+  std::vector<rosbag2_storage::SerializedBagMessageSharedPtr>, std::promise<DecodedBatch>>;
+
+/**
+ * @brief deserialize the messages of the topics used for the estimation
+ */
+DecodedBatch decode_batch(
+  const std::vector<rosbag2_storage::SerializedBagMessageSharedPtr> & serialized_messages)
+{
+  rclcpp::Serialization<autoware_vehicle_msgs::msg::VelocityReport> serialization_velocity_status;
+  rclcpp::Serialization<tf2_msgs::msg::TFMessage> serialization_tf;
+  rclcpp::Serialization<sensor_msgs::msg::Imu> serialization_imu;
+  rclcpp::Serialization<geometry_msgs::msg::PoseWithCovarianceStamped> serialization_pose;
+
+  DecodedBatch decoded_batch;
+  decoded_batch.reserve(serialized_messages.size());
+  for (const auto & serialized_message : serialized_messages) {
+    const std::string & topic_name = serialized_message->topic_name;
+    const rcutils_uint8_array_t & buffer = *serialized_message->serialized_data;
+
+    // The fields of the velocity, the IMU and the pose are read in place from the CDR buffers, and
+    // the messages are deserialized only if the buffers cannot be read
+    if (topic_name == TOPIC_VELOCITY_STATUS) {
+      auto view = cdr::CdrView::create(buffer);
+      const auto header = view ? cdr::HeaderView::read(*view) : std::nullopt;
+      float longitudinal_velocity;
+      if (header && view->read(longitudinal_velocity)) {
+        autoware_internal_debug_msgs::msg::Float64Stamped vx;
+        vx.stamp = header->stamp;
+        vx.data = longitudinal_velocity;
+        decoded_batch.emplace_back(vx);
+        continue;
+      }
+      autoware_vehicle_msgs::msg::VelocityReport velocity_status_msg;
+      const rclcpp::SerializedMessage msg(buffer);
+      serialization_velocity_status.deserialize_message(&msg, &velocity_status_msg);
+      autoware_internal_debug_msgs::msg::Float64Stamped vx;
+      vx.stamp = velocity_status_msg.header.stamp;
+      vx.data = velocity_status_msg.longitudinal_velocity;
+      decoded_batch.emplace_back(vx);
+
+    } else if (topic_name == TOPIC_TF_STATIC) {
+      tf2_msgs::msg::TFMessage tf_msg;
+      const rclcpp::SerializedMessage msg(buffer);
+      serialization_tf.deserialize_message(&msg, &tf_msg);
+      decoded_batch.emplace_back(std::move(tf_msg));
+
+    } else if (topic_name == TOPIC_IMU) {
+      if (const auto imu_view = cdr::ImuView::parse(buffer)) {
+        geometry_msgs::msg::Vector3Stamped gyro;
+        gyro.header.stamp = imu_view->header.stamp;
+        gyro.header.frame_id = imu_view->header.frame_id;
+        gyro.vector = imu_view->angular_velocity();
+        decoded_batch.emplace_back(std::move(gyro));
+        continue;
+      }
+      sensor_msgs::msg::Imu imu_msg;
+      const rclcpp::SerializedMessage msg(buffer);
+      serialization_imu.deserialize_message(&msg, &imu_msg);
+      geometry_msgs::msg::Vector3Stamped gyro;
+      gyro.header = imu_msg.header;
+      gyro.vector = imu_msg.angular_velocity;
+      decoded_batch.emplace_back(std::move(gyro));
+
+    } else if (topic_name == TOPIC_POSE) {
+      if (const auto pose_view = cdr::PoseWithCovarianceStampedView::parse(buffer)) {
+        geometry_msgs::msg::PoseStamped pose_stamped;
+        pose_stamped.header.stamp = pose_view->header.stamp;
+        pose_stamped.header.frame_id = pose_view->header.frame_id;
+        pose_stamped.pose.position = pose_view->position();
+        pose_stamped.pose.orientation = pose_view->orientation();
+        decoded_batch.emplace_back(std::move(pose_stamped));
+        continue;
+      }
+      geometry_msgs::msg::PoseWithCovarianceStamped pose_msg;
+      const rclcpp::SerializedMessage msg(buffer);
+      serialization_pose.deserialize_message(&msg, &pose_msg);
+      geometry_msgs::msg::PoseStamped pose_stamped;
+      pose_stamped.header = pose_msg.header;
+      pose_stamped.pose = pose_msg.pose.pose;
+      decoded_batch.emplace_back(std::move(pose_stamped));
+    }
+  }
+  return decoded_batch;
+}
+
+/**
+ * @brief load the parameters of a yaml file, e.g. config/deviation_estimator.param.yaml
+ */
+std::map<std::string, rclcpp::Parameter> load_param_map(const std::string & yaml_path)
+{
+  rcl_params_t * params_st = rcl_yaml_node_struct_init(rcl_get_default_allocator());
+  if (!rcl_parse_yaml_file(yaml_path.c_str(), params_st)) {
+    std::cerr << "Failed to parse yaml file: " << yaml_path << std::endl;
+    std::exit(1);
+  }
+  const std::vector<rclcpp::Parameter> parameters =
+    rclcpp::parameter_map_from(params_st, "").at("");
+  rcl_yaml_node_struct_fini(params_st);
+
+  std::map<std::string, rclcpp::Parameter> param_map;
+  for (const rclcpp::Parameter & param : parameters) {
+    param_map[param.get_name()] = param;
+  }
+  return param_map;
+}
+
+// Parameters evaluated in the sweep mode
+struct SweepConfig
+{
+  double time_window;
+  double wz_threshold;
+  double vx_threshold;
+  double accel_threshold;
+};
+
+struct SweepResult
+{
+  double coef_vx{1.0};
+  double stddev_vx{0.0};
+  geometry_msgs::msg::Vector3 bias_angvel_base;
+  geometry_msgs::msg::Vector3 stddev_angvel_base;
+  size_t count_velocity{0};
+  size_t count_gyro{0};
+};
+
+/**
+ * @brief values of a swept parameter, which is either a double or a list of doubles. The value
+ * of the default parameter file is used if the parameter is not in the sweep file.
+ */
+std::vector<double> get_sweep_values(
+  const std::map<std::string, rclcpp::Parameter> & sweep_param_map, const std::string & name,
+  const double default_value)
+{
+  const auto iter = sweep_param_map.find(name);
+  if (iter == sweep_param_map.end()) {
+    return {default_value};
+  }
+  if (iter->second.get_type() == rclcpp::ParameterType::PARAMETER_DOUBLE_ARRAY) {
+    return iter->second.as_double_array();
+  }
+  return {iter->second.as_double()};
+}
+}  // namespace
+
 int main(int argc, char ** argv)
 {
-  if (argc != 2) {
-    std::cout << "Usage: " << argv[0] << " <rosbag_path>" << std::endl;
+  if (argc < 2 || 4 < argc) {
+    std::cout << "Usage: " << argv[0] << " <rosbag_path> [thread_num] [sweep_param_yaml]"
+              << std::endl;
     return 1;
   }
   const std::string rosbag_path = argv[1];
+  const size_t thread_num =
+    autoware::task_scheduler::resolve_thread_num(argc >= 3 ? std::stoll(argv[2]) : 0);
 
   std::cout << "deviation_estimator_unit_tool" << std::endl;
 
   // Load parameters
-  std::map<std::string, rclcpp::Parameter> param_map;
-  {
-    const std::string yaml_path =
-      ament_index_cpp::get_package_share_directory("deviation_estimator") +
-      "/config/deviation_estimator.param.yaml";
-    rcl_params_t * params_st = rcl_yaml_node_struct_init(rcl_get_default_allocator());
-    if (!rcl_parse_yaml_file(yaml_path.c_str(), params_st)) {
-      std::cerr << "Failed to parse yaml file: " << yaml_path << std::endl;
-      std::exit(1);
-    }
-    const std::vector<rclcpp::Parameter> parameters =
-      rclcpp::parameter_map_from(params_st, "").at("");
-    rcl_yaml_node_struct_fini(params_st);
-    for (const rclcpp::Parameter & param : parameters) {
-      param_map[param.get_name()] = param;
-    }
-  }
+  const std::map<std::string, rclcpp::Parameter> param_map = load_param_map(
+    ament_index_cpp::get_package_share_directory("deviation_estimator") +
+    "/config/deviation_estimator.param.yaml");
 
   // Prepare rosbag reader
   rosbag2_storage::StorageOptions storage_options;
@@ -64,104 +228,22 @@ int main(int argc, char ** argv)
   rosbag2_cpp::readers::SequentialReader reader;
   reader.open(storage_options, converter_options);
 
-  // Prepare serialization
-  rclcpp::Serialization<autoware_vehicle_msgs::msg::VelocityReport> serialization_velocity_status;
-  rclcpp::Serialization<tf2_msgs::msg::TFMessage> serialization_tf;
-  rclcpp::Serialization<sensor_msgs::msg::Imu> serialization_imu;
-  rclcpp::Serialization<geometry_msgs::msg::PoseWithCovarianceStamped> serialization_pose;
+  // Read only the topics used for the estimation
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {TOPIC_VELOCITY_STATUS, TOPIC_TF_STATIC, TOPIC_IMU, TOPIC_POSE};
+  reader.set_filter(storage_filter);
 
   // Prepare tf_buffer
   rclcpp::Clock::SharedPtr clock = std::make_shared<rclcpp::Clock>(RCL_ROS_TIME);
   tf2_ros::Buffer tf_buffer(clock);
 
   // Prepare variables
-  std::vector<TrajectoryData> trajectory_data_list;
-  rclcpp::Time first_stamp(std::numeric_limits<int64_t>::max(), RCL_ROS_TIME);
   const double time_window = param_map.at("time_window").as_double();
   std::string imu_frame_id;
 
-  // ----------- //
-  // Read rosbag //
-  // ----------- //
-  while (reader.has_next()) {
-    const rosbag2_storage::SerializedBagMessageSharedPtr serialized_message = reader.read_next();
-    const std::string topic_name = serialized_message->topic_name;
-    const rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
-
-    if (topic_name == "/vehicle/status/velocity_status") {
-      autoware_vehicle_msgs::msg::VelocityReport::SharedPtr velocity_status_msg =
-        std::make_shared<autoware_vehicle_msgs::msg::VelocityReport>();
-      serialization_velocity_status.deserialize_message(&msg, velocity_status_msg.get());
-      const rclcpp::Time curr_stamp = velocity_status_msg->header.stamp;
-      first_stamp = std::min(first_stamp, curr_stamp);
-      const double diff_sec = (curr_stamp - first_stamp).seconds();
-      const int64_t index = static_cast<int64_t>(diff_sec / time_window);
-      if (index >= static_cast<int64_t>(trajectory_data_list.size())) {
-        trajectory_data_list.resize(index + 1);
-      }
-      autoware_internal_debug_msgs::msg::Float64Stamped vx;
-      vx.stamp = velocity_status_msg->header.stamp;
-      vx.data = velocity_status_msg->longitudinal_velocity;
-      trajectory_data_list[index].vx_list.push_back(vx);
-
-    } else if (topic_name == "/tf_static") {
-      tf2_msgs::msg::TFMessage::SharedPtr tf_msg = std::make_shared<tf2_msgs::msg::TFMessage>();
-      serialization_tf.deserialize_message(&msg, tf_msg.get());
-      for (const auto & transform : tf_msg->transforms) {
-        try {
-          tf_buffer.setTransform(transform, "default_authority", false);
-        } catch (const tf2::TransformException & ex) {
-          std::cerr << "Transform exception: " << ex.what() << std::endl;
-          std::exit(1);
-        }
-      }
-
-    } else if (topic_name == "/sensing/imu/tamagawa/imu_raw") {
-      sensor_msgs::msg::Imu::SharedPtr imu_msg = std::make_shared<sensor_msgs::msg::Imu>();
-      serialization_imu.deserialize_message(&msg, imu_msg.get());
-      imu_frame_id = imu_msg->header.frame_id;
-      geometry_msgs::msg::Vector3Stamped vec_stamped_transformed;
-      try {
-        const geometry_msgs::msg::TransformStamped transform =
-          tf_buffer.lookupTransform("base_link", imu_msg->header.frame_id, tf2::TimePointZero);
-        vec_stamped_transformed.header = imu_msg->header;
-        tf2::doTransform(imu_msg->angular_velocity, vec_stamped_transformed.vector, transform);
-      } catch (const tf2::TransformException & ex) {
-        std::cerr << "Transform exception: " << ex.what() << std::endl;
-        continue;
-      }
-      const rclcpp::Time curr_stamp = imu_msg->header.stamp;
-      first_stamp = std::min(first_stamp, curr_stamp);
-      const double diff_sec = (curr_stamp - first_stamp).seconds();
-      const int64_t index = static_cast<int64_t>(diff_sec / time_window);
-      if (index >= static_cast<int64_t>(trajectory_data_list.size())) {
-        trajectory_data_list.resize(index + 1);
-      }
-      trajectory_data_list[index].gyro_list.push_back(vec_stamped_transformed);
-
-    } else if (topic_name == "/localization/pose_estimator/pose_with_covariance") {
-      geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr pose_msg =
-        std::make_shared<geometry_msgs::msg::PoseWithCovarianceStamped>();
-      serialization_pose.deserialize_message(&msg, pose_msg.get());
-      const rclcpp::Time curr_stamp = pose_msg->header.stamp;
-      first_stamp = std::min(first_stamp, curr_stamp);
-      const double diff_sec = (curr_stamp - first_stamp).seconds();
-      const int64_t index = static_cast<int64_t>(diff_sec / time_window);
-      if (index >= static_cast<int64_t>(trajectory_data_list.size())) {
-        trajectory_data_list.resize(index + 1);
-      }
-      geometry_msgs::msg::PoseStamped pose_stamped;
-      pose_stamped.header = pose_msg->header;
-      pose_stamped.pose = pose_msg->pose.pose;
-      trajectory_data_list[index].pose_list.push_back(pose_stamped);
-
-    } else {
-    }
-  }
-
-  // ------------------ //
-  // Estimate deviation //
-  // ------------------ //
+  // ---------------------------- //
+  // Prepare deviation estimation //
+  // ---------------------------- //
   const double wz_threshold = param_map.at("wz_threshold").as_double();
   const double vx_threshold = param_map.at("vx_threshold").as_double();
   const double accel_threshold = param_map.at("accel_threshold").as_double();
@@ -181,8 +263,8 @@ int main(int argc, char ** argv)
     param_map.at("velocity_estimation.add_bias_uncertainty").as_bool();
   std::unique_ptr<GyroBiasModule> gyro_bias_module = std::make_unique<GyroBiasModule>();
   std::unique_ptr<VelocityCoefModule> vel_coef_module = std::make_unique<VelocityCoefModule>();
-  std::vector<TrajectoryData> traj_data_list_for_velocity;
-  std::vector<TrajectoryData> traj_data_list_for_gyro;
+  VelocityStddevAccumulator stddev_accumulator_for_velocity;
+  AngularVelocityStddevAccumulator stddev_accumulator_for_gyro;
 
   if (gyro_add_bias_uncertainty) {
     std::cerr << "gyro_add_bias_uncertainty is not supported yet." << std::endl;
@@ -197,9 +279,85 @@ int main(int argc, char ** argv)
     param_map.at("thres_coef_vx").as_double(), param_map.at("thres_stddev_vx").as_double(),
     param_map.at("thres_bias_gyro").as_double(), param_map.at("thres_stddev_gyro").as_double(), 5);
 
+  // In the sweep mode, the whole rosbag is loaded into a store once, and each parameter set is
+  // evaluated on it after reading
+  std::vector<SweepConfig> sweep_configs;
+  if (argc == 4) {
+    const auto sweep_param_map = load_param_map(argv[3]);
+    for (const double t : get_sweep_values(sweep_param_map, "time_window", time_window)) {
+      if (t <= 0.0) {
+        std::cerr << "time_window must be positive: " << t << std::endl;
+        std::exit(1);
+      }
+      for (const double wz : get_sweep_values(sweep_param_map, "wz_threshold", wz_threshold)) {
+        for (const double vx : get_sweep_values(sweep_param_map, "vx_threshold", vx_threshold)) {
+          for (const double accel :
+               get_sweep_values(sweep_param_map, "accel_threshold", accel_threshold)) {
+            sweep_configs.push_back(SweepConfig{t, wz, vx, accel});
+          }
+        }
+      }
+    }
+    std::cout << "sweep over " << sweep_configs.size() << " parameter sets" << std::endl;
+  }
+  const bool sweep_mode = !sweep_configs.empty();
+  TrajectoryStore whole_store;
+
+  // Estimate the deviation over the whole rosbag with a parameter set, in the same way as
+  // process_trajectory
+  auto evaluate_config = [&](const SweepConfig & config) {
+    SweepResult result;
+    GyroBiasModule sweep_gyro_bias_module;
+    VelocityCoefModule sweep_vel_coef_module;
+    VelocityStddevAccumulator sweep_stddev_accumulator_for_velocity;
+    AngularVelocityStddevAccumulator sweep_stddev_accumulator_for_gyro;
+
+    const double t_begin = std::min(
+      {whole_store.vx_t.front(), whole_store.gyro_t.front(), whole_store.pose_t.front()});
+    const double t_end =
+      std::max({whole_store.vx_t.back(), whole_store.gyro_t.back(), whole_store.pose_t.back()});
+    for (int64_t index = 0; t_begin + index * config.time_window <= t_end; ++index) {
+      const double t0 = t_begin + index * config.time_window;
+      const TrajectoryView traj_view = whole_store.slice(t0, t0 + config.time_window);
+      if (traj_view.pose.size() < 2 || traj_view.gyro.size() < 2 || traj_view.vx.size() < 2) {
+        continue;
+      }
+
+      const bool is_straight = get_mean_abs_wz(traj_view) < config.wz_threshold;
+      const bool is_moving = get_mean_abs_vx(traj_view) > config.vx_threshold;
+      const bool is_constant_velocity =
+        std::abs(get_mean_accel(traj_view)) < config.accel_threshold;
+
+      const bool use_gyro = whether_to_use_data(
+        is_straight, is_moving, is_constant_velocity, gyro_only_use_straight, gyro_only_use_moving,
+        gyro_only_use_constant_velocity);
+      const bool use_velocity = whether_to_use_data(
+        is_straight, is_moving, is_constant_velocity, velocity_only_use_straight,
+        velocity_only_use_moving, velocity_only_use_constant_velocity);
+      if (use_velocity) {
+        sweep_vel_coef_module.update_coef(traj_view);
+        sweep_stddev_accumulator_for_velocity.add(traj_view);
+      }
+      if (use_gyro) {
+        sweep_gyro_bias_module.update_bias(traj_view);
+        sweep_stddev_accumulator_for_gyro.add(traj_view);
+      }
+    }
+
+    result.coef_vx = sweep_vel_coef_module.get_coef();
+    result.stddev_vx = sweep_stddev_accumulator_for_velocity.estimate(result.coef_vx);
+    result.bias_angvel_base = sweep_gyro_bias_module.get_bias_base_link();
+    result.stddev_angvel_base =
+      sweep_stddev_accumulator_for_gyro.estimate(result.bias_angvel_base);
+    result.count_velocity = sweep_stddev_accumulator_for_velocity.size();
+    result.count_gyro = sweep_stddev_accumulator_for_gyro.size();
+    return result;
+  };
+
   Logger results_logger(".");
 
-  for (const TrajectoryData & traj_data : trajectory_data_list) {
+  // Estimate the deviation with each trajectory data as soon as its time window closes
+  auto process_trajectory = [&](const TrajectoryData & traj_data) {
     std::cout << "traj_data.pose_list.size(): " << traj_data.pose_list.size() << std::endl;
     std::cout << "traj_data.gyro_list.size(): " << traj_data.gyro_list.size() << std::endl;
     std::cout << "traj_data.vx_list.size(): " << traj_data.vx_list.size() << std::endl;
@@ -208,7 +366,7 @@ int main(int argc, char ** argv)
     if (
       traj_data.pose_list.size() < 2 || traj_data.gyro_list.size() < 2 ||
       traj_data.vx_list.size() < 2) {
-      continue;
+      return;
     }
 
     const bool is_straight = get_mean_abs_wz(traj_data.gyro_list) < wz_threshold;
@@ -223,18 +381,17 @@ int main(int argc, char ** argv)
       velocity_only_use_moving, velocity_only_use_constant_velocity);
     if (use_velocity) {
       vel_coef_module->update_coef(traj_data);
-      traj_data_list_for_velocity.push_back(traj_data);
+      stddev_accumulator_for_velocity.add(traj_data);
     }
     if (use_gyro) {
       gyro_bias_module->update_bias(traj_data);
-      traj_data_list_for_gyro.push_back(traj_data);
+      stddev_accumulator_for_gyro.add(traj_data);
     }
 
-    double stddev_vx =
-      estimate_stddev_velocity(traj_data_list_for_velocity, vel_coef_module->get_coef());
+    double stddev_vx = stddev_accumulator_for_velocity.estimate(vel_coef_module->get_coef());
 
-    auto stddev_angvel_base = estimate_stddev_angular_velocity(
-      traj_data_list_for_gyro, gyro_bias_module->get_bias_base_link());
+    auto stddev_angvel_base =
+      stddev_accumulator_for_gyro.estimate(gyro_bias_module->get_bias_base_link());
 
     // print
     const geometry_msgs::msg::Vector3 curr_gyro_bias = gyro_bias_module->get_bias_base_link();
@@ -277,9 +434,166 @@ int main(int argc, char ** argv)
     results_logger.log_validation_result_section(*validation_module);
 
     std::cout << "saved to ./" << std::endl;
+  };
+
+  // ----------------------------------------------------------------------------------------- //
+  // Read rosbag                                                                               //
+  // The reader thread reads batches of serialized messages, the worker threads deserialize    //
+  // them, and this thread puts the messages into the time windows in the order of the rosbag. //
+  // ----------------------------------------------------------------------------------------- //
+  BoundedQueue<DecodeTask> task_queue(2 * thread_num);
+  BoundedQueue<std::future<DecodedBatch>> result_queue(2 * thread_num);
+
+  std::thread reader_thread([&]() {
+    while (reader.has_next()) {
+      DecodeTask task;
+      while (reader.has_next() && task.first.size() < BATCH_SIZE) {
+        task.first.push_back(reader.read_next());
+      }
+      result_queue.push(task.second.get_future());
+      task_queue.push(std::move(task));
+    }
+    task_queue.close();
+    result_queue.close();
+  });
+
+  std::vector<std::thread> worker_threads;
+  for (size_t i = 0; i < thread_num; ++i) {
+    worker_threads.emplace_back([&]() {
+      while (auto task = task_queue.pop()) {
+        try {
+          task->second.set_value(decode_batch(task->first));
+        } catch (...) {
+          task->second.set_exception(std::current_exception());
+        }
+      }
+    });
   }
 
-  std::cout << "count for velocity : " << traj_data_list_for_velocity.size() << std::endl;
-  std::cout << "count for gyro : " << traj_data_list_for_gyro.size() << std::endl;
+  // A time window closes when all of the velocity, IMU and pose have reached the next windows
+  std::map<int64_t, TrajectoryData> open_windows;
+  std::optional<rclcpp::Time> first_stamp;
+  int64_t latest_vx_index = -1;
+  int64_t latest_gyro_index = -1;
+  int64_t latest_pose_index = -1;
+  auto get_window_index = [&](const rclcpp::Time & stamp) {
+    if (!first_stamp) {
+      first_stamp = stamp;
+    }
+    const double diff_sec = (stamp - *first_stamp).seconds();
+    return std::max<int64_t>(static_cast<int64_t>(diff_sec / time_window), 0);
+  };
+  auto close_windows = [&](const int64_t next_index) {
+    while (!open_windows.empty() && open_windows.begin()->first < next_index) {
+      process_trajectory(open_windows.begin()->second);
+      open_windows.erase(open_windows.begin());
+    }
+  };
+
+  while (auto result = result_queue.pop()) {
+    for (auto & decoded_message : result->get()) {
+      if (
+        auto * vx =
+          std::get_if<autoware_internal_debug_msgs::msg::Float64Stamped>(&decoded_message)) {
+        if (sweep_mode) {
+          whole_store.add_velocity(*vx);
+          continue;
+        }
+        const int64_t index = get_window_index(vx->stamp);
+        latest_vx_index = std::max(latest_vx_index, index);
+        open_windows[index].vx_list.push_back(*vx);
+
+      } else if (auto * tf_msg = std::get_if<tf2_msgs::msg::TFMessage>(&decoded_message)) {
+        for (const auto & transform : tf_msg->transforms) {
+          try {
+            tf_buffer.setTransform(transform, "default_authority", false);
+          } catch (const tf2::TransformException & ex) {
+            std::cerr << "Transform exception: " << ex.what() << std::endl;
+            std::exit(1);
+          }
+        }
+
+      } else if (auto * gyro = std::get_if<geometry_msgs::msg::Vector3Stamped>(&decoded_message)) {
+        imu_frame_id = gyro->header.frame_id;
+        geometry_msgs::msg::Vector3Stamped vec_stamped_transformed;
+        try {
+          const geometry_msgs::msg::TransformStamped transform =
+            tf_buffer.lookupTransform("base_link", gyro->header.frame_id, tf2::TimePointZero);
+          vec_stamped_transformed.header = gyro->header;
+          tf2::doTransform(gyro->vector, vec_stamped_transformed.vector, transform);
+        } catch (const tf2::TransformException & ex) {
+          std::cerr << "Transform exception: " << ex.what() << std::endl;
+          continue;
+        }
+        if (sweep_mode) {
+          whole_store.add_gyro(vec_stamped_transformed);
+          continue;
+        }
+        const int64_t index = get_window_index(gyro->header.stamp);
+        latest_gyro_index = std::max(latest_gyro_index, index);
+        open_windows[index].gyro_list.push_back(vec_stamped_transformed);
+
+      } else if (auto * pose = std::get_if<geometry_msgs::msg::PoseStamped>(&decoded_message)) {
+        if (sweep_mode) {
+          whole_store.add_pose(*pose);
+          continue;
+        }
+        const int64_t index = get_window_index(pose->header.stamp);
+        latest_pose_index = std::max(latest_pose_index, index);
+        open_windows[index].pose_list.push_back(*pose);
+      }
+    }
+    close_windows(std::min({latest_vx_index, latest_gyro_index, latest_pose_index}));
+  }
+
+  reader_thread.join();
+  for (auto & worker_thread : worker_threads) {
+    worker_thread.join();
+  }
+
+  if (sweep_mode) {
+    if (whole_store.vx_t.empty() || whole_store.gyro_t.empty() || whole_store.pose_t.empty()) {
+      std::cerr << "No velocity, IMU or pose in the rosbag." << std::endl;
+      std::exit(1);
+    }
+
+    // The parameter sets share the store, and each of them is evaluated by one thread
+    std::vector<SweepResult> sweep_results(sweep_configs.size());
+    autoware::task_scheduler::TaskScheduler::global().parallel_for(
+      sweep_configs.size(),
+      [&](const size_t i) { sweep_results[i] = evaluate_config(sweep_configs[i]); }, thread_num);
+
+    // The gyro bias is output in the IMU frame, and the stddev of yaw in base_link is used for
+    // the IMU, as the results of the normal mode
+    const geometry_msgs::msg::TransformStamped transform =
+      tf_buffer.lookupTransform(imu_frame_id, "base_link", tf2::TimePointZero);
+    const std::string header =
+      "time_window,wz_threshold,vx_threshold,accel_threshold,coef_vx,stddev_vx,"
+      "bias_angvel_x,bias_angvel_y,bias_angvel_z,stddev_angvel,count_velocity,count_gyro";
+    std::ofstream sweep_file("./sweep_result.csv");
+    sweep_file << header << "\n";
+    std::cout << header << std::endl;
+    for (size_t i = 0; i < sweep_configs.size(); ++i) {
+      const SweepConfig & config = sweep_configs[i];
+      const SweepResult & result = sweep_results[i];
+      geometry_msgs::msg::Vector3 bias_angvel_imu;
+      tf2::doTransform(result.bias_angvel_base, bias_angvel_imu, transform);
+      const std::string row = fmt::format(
+        "{:.3f},{:.5f},{:.3f},{:.3f},{:.5f},{:.5f},{:.5f},{:.5f},{:.5f},{:.5f},{},{}",
+        config.time_window, config.wz_threshold, config.vx_threshold, config.accel_threshold,
+        result.coef_vx, result.stddev_vx, bias_angvel_imu.x, bias_angvel_imu.y, bias_angvel_imu.z,
+        result.stddev_angvel_base.z, result.count_velocity, result.count_gyro);
+      sweep_file << row << "\n";
+      std::cout << row << std::endl;
+    }
+    std::cout << "saved to ./sweep_result.csv" << std::endl;
+    return 0;
+  }
+
+  // The remaining windows are closed at the end of the rosbag
+  close_windows(std::numeric_limits<int64_t>::max());
+
+  std::cout << "count for velocity : " << stddev_accumulator_for_velocity.size() << std::endl;
+  std::cout << "count for gyro : " << stddev_accumulator_for_gyro.size() << std::endl;
   std::cout << "Finished." << std::endl;
 }
@@ -0,0 +1,160 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/gyro_batch_estimator.hpp"
+
+#include "deviation_estimator/utils.hpp"
+
+#include <autoware/task_scheduler/task_scheduler.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
+
+/**
+ * @brief add a trajectory. Its error is scaled to the duration of the poses as in GyroBiasModule,
+ * and a trajectory without a duration is skipped, since it has no angular velocity.
+ */
+void GyroBatchEstimator::add(const TrajectoryView & view)
+{
+  const auto & s = *view.store;
+  const double dt_pose = s.pose_t[view.pose.back()] - s.pose_t[view.pose.front()];
+  const auto & gyro_t = view.gyro_store->gyro_t;
+  const double dt_gyro = gyro_t[view.gyro.back()] - gyro_t[view.gyro.front()];
+  if (dt_pose <= 0.0 || dt_gyro <= 0.0) return;
+
+  const auto error_rpy = calculate_error_rpy(view, geometry_msgs::msg::Vector3{});
+  const double ratio = dt_pose / dt_gyro;
+
+  dt_.push_back(dt_pose);
+  sqrt_n_.push_back(std::sqrt(view.gyro.size()));
+  error_[0].push_back(error_rpy.x * ratio);
+  error_[1].push_back(error_rpy.y * ratio);
+  error_[2].push_back(error_rpy.z * ratio);
+}
+
+void GyroBatchEstimator::add(const TrajectoryData & traj_data)
+{
+  add(make_trajectory_store(traj_data).view());
+}
+
+GyroBatchEstimator::Estimate GyroBatchEstimator::estimate() const
+{
+  return estimate(nullptr);
+}
+
+/**
+ * @brief fit error = bias * dt by least squares. The standard deviation of the bias is that of
+ * error / dt around it, and the deviation of the angular velocity is the standard deviation of the
+ * residuals weighted by the square root of the number of gyro samples, divided by the mean
+ * duration, all from sums over the trajectories.
+ */
+GyroBatchEstimator::Estimate GyroBatchEstimator::estimate(
+  const std::vector<uint32_t> * counts) const
+{
+  Estimate result;
+  if (dt_.empty()) return result;
+
+  const auto weight = [counts](const size_t i) {
+    return counts ? static_cast<double>((*counts)[i]) : 1.0;
+  };
+
+  double n = 0.0, sum_dt = 0.0, sum_dd = 0.0, sum_y = 0.0, sum_yy = 0.0;
+  for (size_t i = 0; i < dt_.size(); ++i) {
+    const double w = weight(i);
+    const double y = sqrt_n_[i] * dt_[i];
+    n += w;
+    sum_dt += w * dt_[i];
+    sum_dd += w * dt_[i] * dt_[i];
+    sum_y += w * y;
+    sum_yy += w * y * y;
+  }
+
+  const auto fit_axis = [&](const std::vector<double> & error) {
+    double sum_de = 0.0, sum_r = 0.0, sum_rr = 0.0, sum_x = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+    for (size_t i = 0; i < dt_.size(); ++i) {
+      const double w = weight(i);
+      const double r = error[i] / dt_[i];
+      const double x = sqrt_n_[i] * error[i];
+      const double y = sqrt_n_[i] * dt_[i];
+      sum_de += w * dt_[i] * error[i];
+      sum_r += w * r;
+      sum_rr += w * r * r;
+      sum_x += w * x;
+      sum_xx += w * x * x;
+      sum_xy += w * x * y;
+    }
+
+    const double bias = sum_de / sum_dd;
+    const double bias_m2 = sum_rr - 2.0 * bias * sum_r + n * bias * bias;
+    const double bias_std = std::sqrt(std::max(bias_m2, 0.0) / n);
+    const double sum_residual = sum_x - bias * sum_y;
+    const double m2 = sum_xx - 2.0 * bias * sum_xy + bias * bias * sum_yy -
+                      sum_residual * sum_residual / n;
+    const double stddev = std::sqrt(std::max(m2, 0.0) / n) / (sum_dt / n);
+    return std::make_tuple(bias, bias_std, stddev);
+  };
+
+  std::tie(result.bias.x, result.bias_std.x, result.stddev.x) = fit_axis(error_[0]);
+  std::tie(result.bias.y, result.bias_std.y, result.stddev.y) = fit_axis(error_[1]);
+  std::tie(result.bias.z, result.bias_std.z, result.stddev.z) = fit_axis(error_[2]);
+  return result;
+}
+
+/**
+ * @brief each replicate draws as many trajectories as there are with replacement, and weights
+ * their sums by the number of draws, so that no trajectory is integrated again. The bounds are the
+ * (1 - confidence) / 2 and (1 + confidence) / 2 percentiles of the replicates, and the replicates
+ * are the same for the same seed.
+ */
+GyroBatchEstimator::Interval GyroBatchEstimator::bootstrap(
+  const size_t replicate_num, const double confidence, const uint64_t seed) const
+{
+  const Estimate full = estimate();
+  if (replicate_num == 0 || dt_.size() < 2) return Interval{full, full};
+
+  std::vector<Estimate> replicates(replicate_num);
+  autoware::task_scheduler::TaskScheduler::global().parallel_for(
+    replicate_num, [this, seed, &replicates](const size_t r) {
+      std::seed_seq seed_seq{seed, static_cast<uint64_t>(r)};
+      std::mt19937_64 engine(seed_seq);
+      std::uniform_int_distribution<size_t> dist(0, dt_.size() - 1);
+      std::vector<uint32_t> counts(dt_.size(), 0);
+      for (size_t k = 0; k < dt_.size(); ++k) {
+        ++counts[dist(engine)];
+      }
+      replicates[r] = estimate(&counts);
+    });
+
+  const double alpha = std::clamp((1.0 - confidence) / 2.0, 0.0, 0.5);
+  const auto lower = static_cast<size_t>(std::floor(alpha * (replicate_num - 1)));
+  const auto upper = static_cast<size_t>(std::ceil((1.0 - alpha) * (replicate_num - 1)));
+
+  using Vector3 = geometry_msgs::msg::Vector3;
+  Interval interval;
+  std::vector<double> values(replicate_num);
+  for (const auto field : {&Estimate::bias, &Estimate::bias_std, &Estimate::stddev}) {
+    for (const auto axis : {&Vector3::x, &Vector3::y, &Vector3::z}) {
+      for (size_t r = 0; r < replicate_num; ++r) {
+        values[r] = (replicates[r].*field).*axis;
+      }
+      std::sort(values.begin(), values.end());
+      (interval.lower.*field).*axis = values[lower];
+      (interval.upper.*field).*axis = values[upper];
+    }
+  }
+  return interval;
+}
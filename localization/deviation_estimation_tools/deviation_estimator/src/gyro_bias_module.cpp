@@ -17,25 +17,19 @@
 #include "autoware/universe_utils/geometry/geometry.hpp"
 #include "deviation_estimator/utils.hpp"
 
-#include <vector>
 
 /**
  * @brief update gyroscope bias based on a given trajectory data
  */
-void GyroBiasModule::update_bias(const TrajectoryData & traj_data)
+void GyroBiasModule::update_bias(const TrajectoryView & view)
 {
-  const rclcpp::Time t0_rclcpp_time = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-  const rclcpp::Time t1_rclcpp_time = rclcpp::Time(traj_data.pose_list.back().header.stamp);
-  const double dt = t1_rclcpp_time.seconds() - t0_rclcpp_time.seconds();
+  const auto & s = *view.store;
+  const double dt = s.pose_t[view.pose.back()] - s.pose_t[view.pose.front()];
 
-  auto error_rpy =
-    calculate_error_rpy(traj_data.pose_list, traj_data.gyro_list, geometry_msgs::msg::Vector3{});
-  const double dt_pose = (rclcpp::Time(traj_data.pose_list.back().header.stamp) -
-                          rclcpp::Time(traj_data.pose_list.front().header.stamp))
-                           .seconds();
-  const double dt_gyro = (rclcpp::Time(traj_data.gyro_list.back().header.stamp) -
-                          rclcpp::Time(traj_data.gyro_list.front().header.stamp))
-                           .seconds();
+  auto error_rpy = calculate_error_rpy(view, geometry_msgs::msg::Vector3{});
+  const double dt_pose = dt;
+  const auto & gyro_t = view.gyro_store->gyro_t;
+  const double dt_gyro = gyro_t[view.gyro.back()] - gyro_t[view.gyro.front()];
   error_rpy.x *= dt_pose / dt_gyro;
   error_rpy.y *= dt_pose / dt_gyro;
   error_rpy.z *= dt_pose / dt_gyro;
@@ -47,11 +41,14 @@ void GyroBiasModule::update_bias(const TrajectoryData & traj_data)
   gyro_bias_pair_.second.y += dt * dt;
   gyro_bias_pair_.second.z += dt * dt;
 
-  geometry_msgs::msg::Vector3 gyro_bias;
-  gyro_bias.x = error_rpy.x / dt;
-  gyro_bias.y = error_rpy.y / dt;
-  gyro_bias.z = error_rpy.z / dt;
-  gyro_bias_list_.push_back(gyro_bias);
+  gyro_bias_x_.add(error_rpy.x / dt);
+  gyro_bias_y_.add(error_rpy.y / dt);
+  gyro_bias_z_.add(error_rpy.z / dt);
+}
+
+void GyroBiasModule::update_bias(const TrajectoryData & traj_data)
+{
+  update_bias(make_trajectory_store(traj_data).view());
 }
 
 /**
@@ -71,23 +68,14 @@ geometry_msgs::msg::Vector3 GyroBiasModule::get_bias_base_link() const
  */
 geometry_msgs::msg::Vector3 GyroBiasModule::get_bias_std() const
 {
-  std::vector<double> stddev_bias_list_x, stddev_bias_list_y, stddev_bias_list_z;
-  for (const auto & e : gyro_bias_list_) {
-    stddev_bias_list_x.push_back(e.x);
-    stddev_bias_list_y.push_back(e.y);
-    stddev_bias_list_z.push_back(e.z);
-  }
   geometry_msgs::msg::Vector3 stddev_bias;
-  stddev_bias.x = calculate_std_mean_const(
-    stddev_bias_list_x, gyro_bias_pair_.first.x / gyro_bias_pair_.second.x);
-  stddev_bias.y = calculate_std_mean_const(
-    stddev_bias_list_y, gyro_bias_pair_.first.y / gyro_bias_pair_.second.y);
-  stddev_bias.z = calculate_std_mean_const(
-    stddev_bias_list_z, gyro_bias_pair_.first.z / gyro_bias_pair_.second.z);
+  stddev_bias.x = gyro_bias_x_.stddev_around(gyro_bias_pair_.first.x / gyro_bias_pair_.second.x);
+  stddev_bias.y = gyro_bias_y_.stddev_around(gyro_bias_pair_.first.y / gyro_bias_pair_.second.y);
+  stddev_bias.z = gyro_bias_z_.stddev_around(gyro_bias_pair_.first.z / gyro_bias_pair_.second.z);
   return stddev_bias;
 }
 
 bool GyroBiasModule::empty() const
 {
-  return gyro_bias_list_.empty();
+  return gyro_bias_x_.size() == 0;
 }
@@ -15,25 +15,25 @@
 #include "deviation_estimator/logger.hpp"
 
 #include <cmath>
+#include <sstream>
 #include <string>
+#include <tuple>
 #include <vector>
 
 /**
  * @brief constructor for Logger class
  */
-Logger::Logger(const std::string & output_dir)
+Logger::Logger(const std::string & output_dir, const double flush_period_sec)
 : output_log_path_(output_dir + "/output.txt"),
   output_imu_param_path_(output_dir + "/imu_corrector.param.yaml"),
-  output_velocity_param_path_(output_dir + "/vehicle_velocity_converter.param.yaml")
+  output_velocity_param_path_(output_dir + "/vehicle_velocity_converter.param.yaml"),
+  output_confidence_interval_path_(output_dir + "/confidence_interval.txt"),
+  writer_(std::make_unique<AsyncFileWriter>(flush_period_sec))
 {
-  std::ofstream file_log(output_log_path_);
-  file_log.close();
-
-  std::ofstream file_imu_param(output_imu_param_path_);
-  file_imu_param.close();
-
-  std::ofstream file_velocity_param(output_velocity_param_path_);
-  file_velocity_param.close();
+  writer_->write(output_log_path_, "");
+  writer_->write(output_imu_param_path_, "");
+  writer_->write(output_velocity_param_path_, "");
+  writer_->write(output_confidence_interval_path_, "");
 }
 
 /**
@@ -44,7 +44,7 @@ void Logger::log_estimated_result_section(
   const geometry_msgs::msg::Vector3 & angular_velocity_stddev,
   const geometry_msgs::msg::Vector3 & angular_velocity_offset) const
 {
-  std::ofstream file_velocity_param(output_velocity_param_path_);
+  std::ostringstream file_velocity_param;
   file_velocity_param << "# Estimated by deviation_estimator\n";
   file_velocity_param << "/**:\n";
   file_velocity_param << "  ros__parameters:\n";
@@ -52,9 +52,9 @@ void Logger::log_estimated_result_section(
   file_velocity_param << fmt::format("    velocity_stddev_xx: {:.5f}\n", stddev_vx);
   file_velocity_param << "    angular_velocity_stddev_zz: 0.1 # Default value\n";
   file_velocity_param << "    frame_id: base_link # Default value\n";
-  file_velocity_param.close();
+  writer_->write(output_velocity_param_path_, file_velocity_param.str());
 
-  std::ofstream file_imu_param(output_imu_param_path_);
+  std::ostringstream file_imu_param;
   file_imu_param << "# Estimated by deviation_estimator\n";
   file_imu_param << "/**:\n";
   file_imu_param << "  ros__parameters:\n";
@@ -70,6 +70,7 @@ void Logger::log_estimated_result_section(
     "    angular_velocity_stddev_yy: {:.5f}\n", angular_velocity_stddev.y);
   file_imu_param << fmt::format(
     "    angular_velocity_stddev_zz: {:.5f}\n", angular_velocity_stddev.z);
+  writer_->write(output_imu_param_path_, file_imu_param.str());
 }
 
 /**
@@ -77,7 +78,7 @@ void Logger::log_estimated_result_section(
  */
 void Logger::log_validation_result_section(const ValidationModule & validation_module) const
 {
-  std::ofstream file(output_log_path_);
+  std::ostringstream file;
   file << "# Validation results\n";
   file << "# value: [min, max]\n";
 
@@ -105,5 +106,33 @@ void Logger::log_validation_result_section(const ValidationModule & validation_m
       file << fmt::format("[NG] {}: Not enough data provided yet\n", key);
     }
   }
-  file.close();
+  writer_->write(output_log_path_, file.str());
+}
+
+/**
+ * @brief log the bootstrap confidence intervals of the gyro bias and standard deviation in
+ * base_link, before the bias uncertainty is added to the standard deviation
+ */
+void Logger::log_confidence_interval_section(
+  const GyroBatchEstimator::Interval & interval, const double confidence) const
+{
+  std::ostringstream file;
+  file << "# Bootstrap confidence intervals in base_link\n";
+  file << fmt::format("# value: [lower, upper] at confidence {}\n", confidence);
+
+  const auto & lower = interval.lower;
+  const auto & upper = interval.upper;
+  const std::vector<std::tuple<std::string, double, double>> rows{
+    {"angular_velocity_offset_x", lower.bias.x, upper.bias.x},
+    {"angular_velocity_offset_y", lower.bias.y, upper.bias.y},
+    {"angular_velocity_offset_z", lower.bias.z, upper.bias.z},
+    {"angular_velocity_stddev_xx", lower.stddev.x, upper.stddev.x},
+    {"angular_velocity_stddev_yy", lower.stddev.y, upper.stddev.y},
+    {"angular_velocity_stddev_zz", lower.stddev.z, upper.stddev.z}};
+
+  for (const auto & [key, lower_value, upper_value] : rows) {
+    file << fmt::format(
+      "{}: [{}, {}]\n", key, double_round(lower_value, 5), double_round(upper_value, 5));
+  }
+  writer_->write(output_confidence_interval_path_, file.str());
 }
@@ -0,0 +1,149 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/stddev_accumulator.hpp"
+
+#include "deviation_estimator/utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void RunningStatistics::add(const double x)
+{
+  ++n_;
+  const double d = x - mean_;
+  mean_ += d / n_;
+  m2_ += d * (x - mean_);
+}
+
+double RunningStatistics::stddev() const
+{
+  if (n_ == 0) return 0.0;
+  return std::sqrt(std::max(m2_, 0.0) / n_);
+}
+
+/**
+ * @brief the same as calculate_std_mean_const, i.e. the deviation around the given mean
+ */
+double RunningStatistics::stddev_around(const double mean) const
+{
+  if (n_ == 0) return 0.0;
+  return std::sqrt(std::max(m2_ + n_ * std::pow(mean_ - mean, 2), 0.0) / n_);
+}
+
+void LinearCombinationStddevAccumulator::add(const double x, const double y)
+{
+  ++n_;
+  const double dx = x - mean_x_;
+  const double dy = y - mean_y_;
+  mean_x_ += dx / n_;
+  mean_y_ += dy / n_;
+  m2_x_ += dx * (x - mean_x_);
+  m2_y_ += dy * (y - mean_y_);
+  c_xy_ += dx * (y - mean_y_);
+}
+
+double LinearCombinationStddevAccumulator::stddev(const double c) const
+{
+  if (n_ == 0) return 0.0;
+  const double m2 = m2_x_ - 2.0 * c * c_xy_ + c * c * m2_y_;
+  return std::sqrt(std::max(m2, 0.0) / n_);
+}
+
+/**
+ * @brief add a trajectory. The delta of estimate_stddev_velocity is
+ * sqrt(n / t_window) * (x - coef_vx * y) / sqrt(n), where x and y are accumulated here.
+ */
+void VelocityStddevAccumulator::add(const TrajectoryView & view)
+{
+  const auto & s = *view.store;
+  const size_t p0 = view.pose.front();
+  const size_t p1 = view.pose.back();
+  ++n_;
+  t_window_sum_ += s.pose_t[p1] - s.pose_t[p0];
+  if (s.pose_t[p0] > s.pose_t[p1]) return;
+
+  const double sqrt_n_twist = std::sqrt(view.vx.size());
+
+  const double distance = std::hypot(s.pose_x[p1] - s.pose_x[p0], s.pose_y[p1] - s.pose_y[p0]);
+  const auto d_pos = integrate_position(view, 1.0, s.pose_yaw[p0]);
+
+  const double dt_pose = s.pose_t[p1] - s.pose_t[p0];
+  const double dt_velocity = s.vx_t[view.vx.back()] - s.vx_t[view.vx.front()];
+  const double distance_from_twist_per_coef =
+    std::sqrt(d_pos.x * d_pos.x + d_pos.y * d_pos.y) * dt_pose / dt_velocity;
+
+  delta_x_.add(sqrt_n_twist * distance, sqrt_n_twist * distance_from_twist_per_coef);
+}
+
+void VelocityStddevAccumulator::add(const TrajectoryData & traj_data)
+{
+  add(make_trajectory_store(traj_data).view());
+}
+
+/**
+ * @brief the same as estimate_stddev_velocity over all the added trajectories, for a positive
+ * coef_vx
+ */
+double VelocityStddevAccumulator::estimate(const double coef_vx) const
+{
+  if (n_ == 0) return 0.0;
+  const double t_window = t_window_sum_ / n_;
+  return delta_x_.stddev(coef_vx) / t_window;
+}
+
+/**
+ * @brief add a trajectory. The error of calculate_error_rpy decreases by gyro_bias * dt_gyro, so
+ * the delta of estimate_stddev_angular_velocity is
+ * sqrt(n / t_window) * (x - gyro_bias * y) / sqrt(n), where x and y are accumulated here.
+ */
+void AngularVelocityStddevAccumulator::add(const TrajectoryView & view)
+{
+  const auto & s = *view.store;
+  const size_t p0 = view.pose.front();
+  const size_t p1 = view.pose.back();
+  ++n_;
+  t_window_sum_ += s.pose_t[p1] - s.pose_t[p0];
+  if (s.pose_t[p0] > s.pose_t[p1]) return;
+
+  const double sqrt_n_twist = std::sqrt(view.gyro.size());
+
+  const auto error_rpy = calculate_error_rpy(view, geometry_msgs::msg::Vector3{});
+  const double dt_pose = s.pose_t[p1] - s.pose_t[p0];
+  const auto & gyro_t = view.gyro_store->gyro_t;
+  const double dt_gyro = gyro_t[view.gyro.back()] - gyro_t[view.gyro.front()];
+  const double ratio = dt_pose / dt_gyro;
+
+  delta_wx_.add(sqrt_n_twist * error_rpy.x * ratio, sqrt_n_twist * dt_pose);
+  delta_wy_.add(sqrt_n_twist * error_rpy.y * ratio, sqrt_n_twist * dt_pose);
+  delta_wz_.add(sqrt_n_twist * error_rpy.z * ratio, sqrt_n_twist * dt_pose);
+}
+
+void AngularVelocityStddevAccumulator::add(const TrajectoryData & traj_data)
+{
+  add(make_trajectory_store(traj_data).view());
+}
+
+/**
+ * @brief the same as estimate_stddev_angular_velocity over all the added trajectories
+ */
+geometry_msgs::msg::Vector3 AngularVelocityStddevAccumulator::estimate(
+  const geometry_msgs::msg::Vector3 & gyro_bias) const
+{
+  if (n_ == 0) return geometry_msgs::msg::Vector3{};
+  const double t_window = t_window_sum_ / n_;
+  return createVector3(
+    delta_wx_.stddev(gyro_bias.x) / t_window, delta_wy_.stddev(gyro_bias.y) / t_window,
+    delta_wz_.stddev(gyro_bias.z) / t_window);
+}
@@ -0,0 +1,150 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/trajectory_store.hpp"
+
+#include "autoware/universe_utils/geometry/geometry.hpp"
+#include "deviation_estimator/utils.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+/**
+ * @brief remove the elements before "n" from the front of the arrays
+ */
+template <typename... Arrays>
+void erase_front(const size_t n, Arrays &... arrays)
+{
+  (arrays.erase(arrays.begin(), arrays.begin() + n), ...);
+}
+
+size_t lower_bound_index(const std::vector<double> & t, const double t_sec)
+{
+  return std::lower_bound(t.begin(), t.end(), t_sec) - t.begin();
+}
+}  // namespace
+
+void TrajectoryStore::add_velocity(const autoware_internal_debug_msgs::msg::Float64Stamped & vx_msg)
+{
+  vx_t.push_back(rclcpp::Time(vx_msg.stamp).seconds());
+  vx.push_back(vx_msg.data);
+}
+
+void TrajectoryStore::add_gyro(const geometry_msgs::msg::Vector3Stamped & gyro)
+{
+  gyro_t.push_back(rclcpp::Time(gyro.header.stamp).seconds());
+  wx.push_back(gyro.vector.x);
+  wy.push_back(gyro.vector.y);
+  wz.push_back(gyro.vector.z);
+}
+
+void TrajectoryStore::add_pose(const geometry_msgs::msg::PoseStamped & pose)
+{
+  const auto rpy = autoware::universe_utils::getRPY(pose.pose.orientation);
+  pose_t.push_back(rclcpp::Time(pose.header.stamp).seconds());
+  pose_x.push_back(pose.pose.position.x);
+  pose_y.push_back(pose.pose.position.y);
+  pose_roll.push_back(rpy.x);
+  pose_pitch.push_back(rpy.y);
+  pose_yaw.push_back(rpy.z);
+}
+
+/**
+ * @brief remove the velocity older than "t_sec"
+ */
+void TrajectoryStore::evict_velocity(const double t_sec)
+{
+  erase_front(lower_bound_index(vx_t, t_sec), vx_t, vx);
+}
+
+/**
+ * @brief remove the gyro older than "t_sec"
+ */
+void TrajectoryStore::evict_gyro(const double t_sec)
+{
+  erase_front(lower_bound_index(gyro_t, t_sec), gyro_t, wx, wy, wz);
+}
+
+void TrajectoryStore::clear_pose()
+{
+  erase_front(pose_t.size(), pose_t, pose_x, pose_y, pose_roll, pose_pitch, pose_yaw);
+}
+
+/**
+ * @brief view of all the data
+ */
+TrajectoryView TrajectoryStore::view() const
+{
+  TrajectoryView view;
+  view.store = this;
+  view.gyro_store = this;
+  view.pose = IndexSpan{0, pose_t.size()};
+  view.vx = IndexSpan{0, vx_t.size()};
+  view.gyro = IndexSpan{0, gyro_t.size()};
+  return view;
+}
+
+/**
+ * @brief view of all the poses, and the velocity and gyro in [t0_sec, t1_sec), i.e. the same range
+ * as extract_sub_trajectory
+ */
+TrajectoryView TrajectoryStore::view(const double t0_sec, const double t1_sec) const
+{
+  return view(t0_sec, t1_sec, *this);
+}
+
+/**
+ * @brief view of the poses and the velocity of this store, and the gyro of "gyro_store", in
+ * [t0_sec, t1_sec)
+ */
+TrajectoryView TrajectoryStore::view(
+  const double t0_sec, const double t1_sec, const TrajectoryStore & gyro_store) const
+{
+  const auto & gyro_t = gyro_store.gyro_t;
+  TrajectoryView view;
+  view.store = this;
+  view.gyro_store = &gyro_store;
+  view.pose = IndexSpan{0, pose_t.size()};
+  view.vx = IndexSpan{lower_bound_index(vx_t, t0_sec), lower_bound_index(vx_t, t1_sec)};
+  view.gyro = IndexSpan{lower_bound_index(gyro_t, t0_sec), lower_bound_index(gyro_t, t1_sec)};
+  return view;
+}
+
+/**
+ * @brief view of all the data in [t0_sec, t1_sec), e.g. a time window of a whole rosbag
+ */
+TrajectoryView TrajectoryStore::slice(const double t0_sec, const double t1_sec) const
+{
+  TrajectoryView view = this->view(t0_sec, t1_sec);
+  view.pose = IndexSpan{lower_bound_index(pose_t, t0_sec), lower_bound_index(pose_t, t1_sec)};
+  return view;
+}
+
+TrajectoryStore make_trajectory_store(const TrajectoryData & traj_data)
+{
+  TrajectoryStore store;
+  for (const auto & vx : traj_data.vx_list) {
+    store.add_velocity(vx);
+  }
+  for (const auto & gyro : traj_data.gyro_list) {
+    store.add_gyro(gyro);
+  }
+  for (const auto & pose : traj_data.pose_list) {
+    store.add_pose(pose);
+  }
+  return store;
+}
@@ -54,29 +54,61 @@ geometry_msgs::msg::Vector3 interpolate_vector3_stamped(
   const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list, const double time,
   const double tolerance_sec = 0.1)
 {
-  std::vector<double> time_list{};
+  return Vector3StampedInterpolator(vec_list, tolerance_sec).interpolate(time);
+}
+
+Vector3StampedInterpolator::Vector3StampedInterpolator(
+  const std::vector<geometry_msgs::msg::Vector3Stamped> & vec_list, const double tolerance_sec)
+: store_(&owned_store_), tolerance_sec_(tolerance_sec)
+{
   for (const auto & vec : vec_list) {
-    time_list.push_back(rclcpp::Time(vec.header.stamp).seconds());
+    owned_store_.add_gyro(vec);
   }
+  span_ = owned_store_.view().gyro;
+  next_idx_ = span_.begin;
+}
+
+Vector3StampedInterpolator::Vector3StampedInterpolator(
+  const TrajectoryView & view, const double tolerance_sec)
+: store_(view.gyro_store),
+  span_(view.gyro),
+  tolerance_sec_(tolerance_sec),
+  next_idx_(view.gyro.begin)
+{
+}
 
-  const int next_idx =
-    std::upper_bound(time_list.begin(), time_list.end(), time) - time_list.begin();
+/**
+ * @brief the same as interpolate_vector3_stamped, with the index of the next timestamp cached
+ */
+geometry_msgs::msg::Vector3 Vector3StampedInterpolator::interpolate(const double time)
+{
+  const auto & t = store_->gyro_t;
+  if (span_.begin < next_idx_ && time < t[next_idx_ - 1]) {
+    next_idx_ =
+      std::upper_bound(t.begin() + span_.begin, t.begin() + span_.end, time) - t.begin();
+  }
+  while (next_idx_ < span_.end && t[next_idx_] <= time) {
+    ++next_idx_;
+  }
 
-  if (next_idx == 0) {
-    if (time_list.front() - time > tolerance_sec) {
+  const auto get_vector = [this](const size_t idx) {
+    return createVector3(store_->wx[idx], store_->wy[idx], store_->wz[idx]);
+  };
+  if (next_idx_ == span_.begin) {
+    if (t[span_.front()] - time > tolerance_sec_) {
       throw std::domain_error("interpolate_vector3_stamped failed! Query time is too small.");
     }
-    return vec_list.front().vector;
-  } else if (next_idx == time_list.end() - time_list.begin()) {
-    if (time - time_list.back() > tolerance_sec) {
+    return get_vector(span_.front());
+  } else if (next_idx_ == span_.end) {
+    if (time - t[span_.back()] > tolerance_sec_) {
       throw std::domain_error("interpolate_vector3_stamped failed! Query time is too large.");
     }
-    return vec_list.back().vector;
+    return get_vector(span_.back());
   } else {
-    const int prev_idx = next_idx - 1;
-    const double ratio = (time - time_list[prev_idx]) / (time_list[next_idx] - time_list[prev_idx]);
+    const size_t prev_idx = next_idx_ - 1;
+    const double ratio = (time - t[prev_idx]) / (t[next_idx_] - t[prev_idx]);
     geometry_msgs::msg::Point interpolated_vec =
-      calcInterpolatedPoint(vec_list[prev_idx].vector, vec_list[next_idx].vector, ratio);
+      calcInterpolatedPoint(get_vector(prev_idx), get_vector(next_idx_), ratio);
 
     return createVector3(interpolated_vec.x, interpolated_vec.y, interpolated_vec.z);
   }
@@ -87,105 +119,162 @@ geometry_msgs::msg::Vector3 interpolate_vector3_stamped(
  * point
  */
 geometry_msgs::msg::Point integrate_position(
-  const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list,
-  const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list, const double coef_vx,
-  const double yaw_init)
+  const TrajectoryView & view, const double coef_vx, const double yaw_init)
 {
-  double t_prev = rclcpp::Time(vx_list.front().stamp).seconds();
+  const auto & s = *view.store;
+
+  // NOTE: The velocity is sorted by time, so the gyro is interpolated with a moving cursor.
+  Vector3StampedInterpolator gyro_interpolator(view);
+  double t_prev = s.vx_t[view.vx.front()];
   double yaw = yaw_init;
   geometry_msgs::msg::Point d_pos = autoware::universe_utils::createPoint(0.0, 0.0, 0.0);
-  for (std::size_t i = 0; i < vx_list.size() - 1; ++i) {
-    const double t_cur = rclcpp::Time(vx_list[i + 1].stamp).seconds();
-    const geometry_msgs::msg::Vector3 gyro_interpolated =
-      interpolate_vector3_stamped(gyro_list, rclcpp::Time(vx_list[i + 1].stamp).seconds());
+  for (std::size_t i = view.vx.begin; i < view.vx.back(); ++i) {
+    const double t_cur = s.vx_t[i + 1];
+    const geometry_msgs::msg::Vector3 gyro_interpolated = gyro_interpolator.interpolate(t_cur);
     yaw += gyro_interpolated.z * (t_cur - t_prev);
 
-    d_pos.x += (t_cur - t_prev) * vx_list[i].data * std::cos(yaw) * coef_vx;
-    d_pos.y += (t_cur - t_prev) * vx_list[i].data * std::sin(yaw) * coef_vx;
+    d_pos.x += (t_cur - t_prev) * s.vx[i] * std::cos(yaw) * coef_vx;
+    d_pos.y += (t_cur - t_prev) * s.vx[i] * std::sin(yaw) * coef_vx;
 
     t_prev = t_cur;
   }
   return d_pos;
 }
 
+geometry_msgs::msg::Point integrate_position(
+  const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list,
+  const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list, const double coef_vx,
+  const double yaw_init)
+{
+  TrajectoryData traj_data;
+  traj_data.vx_list = vx_list;
+  traj_data.gyro_list = gyro_list;
+  const auto store = make_trajectory_store(traj_data);
+  return integrate_position(store.view(), coef_vx, yaw_init);
+}
+
 /**
- * @brief calculate RPY error on dead-reckoning (calculated from "gyro_list") compared to the
- * ground-truth pose from "pose_list".
+ * @brief calculate RPY error on dead-reckoning (calculated from the gyro) compared to the
+ * ground-truth pose.
  */
 geometry_msgs::msg::Vector3 calculate_error_rpy(
-  const std::vector<geometry_msgs::msg::PoseStamped> & pose_list,
-  const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
-  const geometry_msgs::msg::Vector3 & gyro_bias)
+  const TrajectoryView & view, const geometry_msgs::msg::Vector3 & gyro_bias)
 {
-  const geometry_msgs::msg::Vector3 rpy_0 =
-    autoware::universe_utils::getRPY(pose_list.front().pose.orientation);
-  const geometry_msgs::msg::Vector3 rpy_1 =
-    autoware::universe_utils::getRPY(pose_list.back().pose.orientation);
-  const geometry_msgs::msg::Vector3 d_rpy = integrate_orientation(gyro_list, gyro_bias);
+  const auto & s = *view.store;
+  const size_t p0 = view.pose.front();
+  const size_t p1 = view.pose.back();
+  const geometry_msgs::msg::Vector3 d_rpy = integrate_orientation(view, gyro_bias);
 
   geometry_msgs::msg::Vector3 error_rpy = createVector3(
-    clip_radian(-rpy_1.x + rpy_0.x + d_rpy.x), clip_radian(-rpy_1.y + rpy_0.y + d_rpy.y),
-    clip_radian(-rpy_1.z + rpy_0.z + d_rpy.z));
+    clip_radian(-s.pose_roll[p1] + s.pose_roll[p0] + d_rpy.x),
+    clip_radian(-s.pose_pitch[p1] + s.pose_pitch[p0] + d_rpy.y),
+    clip_radian(-s.pose_yaw[p1] + s.pose_yaw[p0] + d_rpy.z));
   return error_rpy;
 }
 
+geometry_msgs::msg::Vector3 calculate_error_rpy(
+  const std::vector<geometry_msgs::msg::PoseStamped> & pose_list,
+  const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
+  const geometry_msgs::msg::Vector3 & gyro_bias)
+{
+  TrajectoryData traj_data;
+  traj_data.pose_list = pose_list;
+  traj_data.gyro_list = gyro_list;
+  const auto store = make_trajectory_store(traj_data);
+  return calculate_error_rpy(store.view(), gyro_bias);
+}
+
 /**
- * @brief perform dead reckoning based on "gyro_list" and return a relative pose (in RPY)
+ * @brief perform dead reckoning based on the gyro and return a relative pose (in RPY)
  */
 geometry_msgs::msg::Vector3 integrate_orientation(
-  const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
-  const geometry_msgs::msg::Vector3 & gyro_bias)
+  const TrajectoryView & view, const geometry_msgs::msg::Vector3 & gyro_bias)
 {
+  const auto & s = *view.gyro_store;
   geometry_msgs::msg::Vector3 d_rpy = createVector3(0.0, 0.0, 0.0);
-  double t_prev = rclcpp::Time(gyro_list.front().header.stamp).seconds();
-  for (std::size_t i = 0; i < gyro_list.size() - 1; ++i) {
-    double t_cur = rclcpp::Time(gyro_list[i + 1].header.stamp).seconds();
+  double t_prev = s.gyro_t[view.gyro.front()];
+  for (std::size_t i = view.gyro.begin; i < view.gyro.back(); ++i) {
+    const double t_cur = s.gyro_t[i + 1];
 
-    d_rpy.x += (t_cur - t_prev) * (gyro_list[i].vector.x - gyro_bias.x);
-    d_rpy.y += (t_cur - t_prev) * (gyro_list[i].vector.y - gyro_bias.y);
-    d_rpy.z += (t_cur - t_prev) * (gyro_list[i].vector.z - gyro_bias.z);
+    d_rpy.x += (t_cur - t_prev) * (s.wx[i] - gyro_bias.x);
+    d_rpy.y += (t_cur - t_prev) * (s.wy[i] - gyro_bias.y);
+    d_rpy.z += (t_cur - t_prev) * (s.wz[i] - gyro_bias.z);
 
     t_prev = t_cur;
   }
   return d_rpy;
 }
 
+geometry_msgs::msg::Vector3 integrate_orientation(
+  const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list,
+  const geometry_msgs::msg::Vector3 & gyro_bias)
+{
+  TrajectoryData traj_data;
+  traj_data.gyro_list = gyro_list;
+  const auto store = make_trajectory_store(traj_data);
+  return integrate_orientation(store.view(), gyro_bias);
+}
+
 /**
  * @brief calculate mean of |vx|
  */
-double get_mean_abs_vx(
-  const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list)
+double get_mean_abs_vx(const TrajectoryView & view)
 {
   double mean_abs_vx = 0;
-  for (const auto & msg : vx_list) {
-    mean_abs_vx += abs(msg.data);
+  for (size_t i = view.vx.begin; i < view.vx.end; ++i) {
+    mean_abs_vx += std::abs(view.store->vx[i]);
   }
-  mean_abs_vx /= vx_list.size();
+  mean_abs_vx /= view.vx.size();
   return mean_abs_vx;
 }
 
+double get_mean_abs_vx(
+  const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list)
+{
+  TrajectoryData traj_data;
+  traj_data.vx_list = vx_list;
+  const auto store = make_trajectory_store(traj_data);
+  return get_mean_abs_vx(store.view());
+}
+
 /**
  * @brief calculate mean of |wz|
  */
-double get_mean_abs_wz(const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list)
+double get_mean_abs_wz(const TrajectoryView & view)
 {
   double mean_abs_wz = 0;
-  for (auto & msg : gyro_list) {
-    mean_abs_wz += abs(msg.vector.z);
+  for (size_t i = view.gyro.begin; i < view.gyro.end; ++i) {
+    mean_abs_wz += std::abs(view.gyro_store->wz[i]);
   }
-  mean_abs_wz /= gyro_list.size();
+  mean_abs_wz /= view.gyro.size();
   return mean_abs_wz;
 }
 
+double get_mean_abs_wz(const std::vector<geometry_msgs::msg::Vector3Stamped> & gyro_list)
+{
+  TrajectoryData traj_data;
+  traj_data.gyro_list = gyro_list;
+  const auto store = make_trajectory_store(traj_data);
+  return get_mean_abs_wz(store.view());
+}
+
 /**
  * @brief calculate mean of acceleration
  */
+double get_mean_accel(const TrajectoryView & view)
+{
+  const auto & s = *view.store;
+  const double dt = s.vx_t[view.vx.back()] - s.vx_t[view.vx.front()];
+  return (s.vx[view.vx.back()] - s.vx[view.vx.front()]) / dt;
+}
+
 double get_mean_accel(
   const std::vector<autoware_internal_debug_msgs::msg::Float64Stamped> & vx_list)
 {
-  const double dt =
-    (rclcpp::Time(vx_list.back().stamp) - rclcpp::Time(vx_list.front().stamp)).seconds();
-  return (vx_list.back().data - vx_list.front().data) / dt;
+  TrajectoryData traj_data;
+  traj_data.vx_list = vx_list;
+  const auto store = make_trajectory_store(traj_data);
+  return get_mean_accel(store.view());
 }
 
 /**
@@ -15,6 +15,7 @@
 #include "deviation_estimator/validation_module.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <string>
 #include <utility>
@@ -39,18 +40,81 @@ ValidationModule::ValidationModule(
   threshold_dict_["angular_velocity_stddev_zz"] = threshold_stddev_gyro;
 }
 
+SlidingWindowStatistics::SlidingWindowStatistics(const size_t capacity)
+: capacity_(std::max<size_t>(capacity, 1))
+{
+}
+
+/**
+ * @brief add a value, and remove the oldest one if the window is full
+ */
+void SlidingWindowStatistics::add(const double value)
+{
+  values_.push_back(value);
+  if (values_.size() > capacity_) {
+    const double oldest = values_.front();
+    values_.pop_front();
+    if (!std::isnan(oldest)) {
+      sorted_values_.erase(std::lower_bound(sorted_values_.begin(), sorted_values_.end(), oldest));
+    }
+  }
+
+  const size_t index = count_++;
+  if (!std::isnan(value)) {
+    sorted_values_.insert(
+      std::upper_bound(sorted_values_.begin(), sorted_values_.end(), value), value);
+    while (!min_queue_.empty() && min_queue_.back().second >= value) {
+      min_queue_.pop_back();
+    }
+    min_queue_.emplace_back(index, value);
+    while (!max_queue_.empty() && max_queue_.back().second <= value) {
+      max_queue_.pop_back();
+    }
+    max_queue_.emplace_back(index, value);
+  }
+
+  // The values whose indices are out of the window are no longer the min or max
+  while (!min_queue_.empty() && min_queue_.front().first + capacity_ < count_) {
+    min_queue_.pop_front();
+  }
+  while (!max_queue_.empty() && max_queue_.front().first + capacity_ < count_) {
+    max_queue_.pop_front();
+  }
+}
+
+size_t SlidingWindowStatistics::size() const
+{
+  return values_.size();
+}
+
+double SlidingWindowStatistics::back() const
+{
+  return values_.back();
+}
+
+double SlidingWindowStatistics::min() const
+{
+  return min_queue_.empty() ? std::numeric_limits<double>::max() : min_queue_.front().second;
+}
+
+double SlidingWindowStatistics::max() const
+{
+  return max_queue_.empty() ? -std::numeric_limits<double>::max() : max_queue_.front().second;
+}
+
 /**
- * @brief get a min and max of a given vector
+ * @brief percentile of the window with linear interpolation, e.g. the median for ratio = 0.5
  */
-std::pair<double, double> get_min_max_from_vector(const std::vector<double> & vec, const int num)
+double SlidingWindowStatistics::percentile(const double ratio) const
 {
-  double min_val = std::numeric_limits<double>::max();
-  double max_val = -std::numeric_limits<double>::max();
-  for (int i = 0; i < num; ++i) {
-    min_val = std::min(min_val, vec[vec.size() - i - 1]);
-    max_val = std::max(max_val, vec[vec.size() - i - 1]);
+  if (sorted_values_.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
   }
-  return std::pair<double, double>(min_val, max_val);
+  const double position = std::clamp(ratio, 0.0, 1.0) * (sorted_values_.size() - 1);
+  const size_t lower = static_cast<size_t>(std::floor(position));
+  const size_t upper = std::min(lower + 1, sorted_values_.size() - 1);
+  const double weight = position - lower;
+  return (1.0 - weight) * sorted_values_[lower] + weight * sorted_values_[upper];
 }
 
 /**
@@ -59,13 +123,13 @@ std::pair<double, double> get_min_max_from_vector(const std::vector<double> & ve
 void ValidationModule::set_velocity_data(const double coef_vx, const double stddev_vx)
 {
   if (data_list_dict_.count("coef_vx")) {
-    if (coef_vx == data_list_dict_["coef_vx"].back()) {
+    if (coef_vx == data_list_dict_.at("coef_vx").back()) {
       return;
     }
   }
 
-  data_list_dict_["coef_vx"].push_back(coef_vx);
-  data_list_dict_["stddev_vx"].push_back(stddev_vx);
+  add_data("coef_vx", coef_vx);
+  add_data("stddev_vx", stddev_vx);
 }
 
 /**
@@ -75,34 +139,57 @@ void ValidationModule::set_gyro_data(
   const geometry_msgs::msg::Vector3 & bias_gyro, const geometry_msgs::msg::Vector3 & stddev_gyro)
 {
   if (data_list_dict_.count("angular_velocity_offset_x")) {
-    if (bias_gyro.x == data_list_dict_["angular_velocity_offset_x"].back()) {
+    if (bias_gyro.x == data_list_dict_.at("angular_velocity_offset_x").back()) {
       return;
     }
   }
 
-  data_list_dict_["angular_velocity_offset_x"].push_back(bias_gyro.x);
-  data_list_dict_["angular_velocity_offset_y"].push_back(bias_gyro.y);
-  data_list_dict_["angular_velocity_offset_z"].push_back(bias_gyro.z);
-  data_list_dict_["angular_velocity_stddev_xx"].push_back(stddev_gyro.x);
-  data_list_dict_["angular_velocity_stddev_yy"].push_back(stddev_gyro.y);
-  data_list_dict_["angular_velocity_stddev_zz"].push_back(stddev_gyro.z);
+  add_data("angular_velocity_offset_x", bias_gyro.x);
+  add_data("angular_velocity_offset_y", bias_gyro.y);
+  add_data("angular_velocity_offset_z", bias_gyro.z);
+  add_data("angular_velocity_stddev_xx", stddev_gyro.x);
+  add_data("angular_velocity_stddev_yy", stddev_gyro.y);
+  add_data("angular_velocity_stddev_zz", stddev_gyro.z);
+}
+
+void ValidationModule::add_data(const std::string & key, const double value)
+{
+  data_list_dict_.try_emplace(key, num_history_).first->second.add(value);
 }
 
 /**
- * @brief get a min and max of a certain vector (designated by a key)
+ * @brief get the last "num_history" data of a certain key
  */
-std::pair<double, double> ValidationModule::get_min_max(const std::string key) const
+const SlidingWindowStatistics & ValidationModule::get_data(const std::string & key) const
 {
   if (data_list_dict_.count(key)) {
     if (data_list_dict_.at(key).size() < num_history_) {
       throw std::domain_error("The data is not enough. Provide more data for valid results.");
     }
-    return get_min_max_from_vector(data_list_dict_.at(key), num_history_);
+    return data_list_dict_.at(key);
   } else {
     throw std::runtime_error("Invalid key in ValidationModule::get_min_max");
   }
 }
 
+/**
+ * @brief get a min and max of a certain vector (designated by a key)
+ */
+std::pair<double, double> ValidationModule::get_min_max(const std::string key) const
+{
+  const auto & data = get_data(key);
+  return std::pair<double, double>(data.min(), data.max());
+}
+
+/**
+ * @brief get a percentile of a certain vector (designated by a key), e.g. the median for
+ * ratio = 0.5
+ */
+double ValidationModule::get_percentile(const std::string key, const double ratio) const
+{
+  return get_data(key).percentile(ratio);
+}
+
 /**
  * @brief check if the given item (="key") is valid
  */
@@ -20,34 +20,32 @@
 /**
  * @brief update speed scale factor (or velocity coefficient) based on a given trajectory data
  */
-void VelocityCoefModule::update_coef(const TrajectoryData & traj_data)
+void VelocityCoefModule::update_coef(const TrajectoryView & view)
 {
-  const rclcpp::Time t0_rclcpp_time = rclcpp::Time(traj_data.pose_list.front().header.stamp);
-  const rclcpp::Time t1_rclcpp_time = rclcpp::Time(traj_data.pose_list.back().header.stamp);
+  const auto & s = *view.store;
+  const size_t p0 = view.pose.front();
+  const size_t p1 = view.pose.back();
 
-  auto d_pos = integrate_position(
-    traj_data.vx_list, traj_data.gyro_list, 1.0,
-    tf2::getYaw(traj_data.pose_list.front().pose.orientation));
-  const double dt_pose = (rclcpp::Time(traj_data.pose_list.back().header.stamp) -
-                          rclcpp::Time(traj_data.pose_list.front().header.stamp))
-                           .seconds();
-  const double dt_velocity =
-    (rclcpp::Time(traj_data.vx_list.back().stamp) - rclcpp::Time(traj_data.vx_list.front().stamp))
-      .seconds();
+  auto d_pos = integrate_position(view, 1.0, s.pose_yaw[p0]);
+  const double dt_pose = s.pose_t[p1] - s.pose_t[p0];
+  const double dt_velocity = s.vx_t[view.vx.back()] - s.vx_t[view.vx.front()];
   d_pos.x *= dt_pose / dt_velocity;
   d_pos.y *= dt_pose / dt_velocity;
 
-  const double dx =
-    traj_data.pose_list.back().pose.position.x - traj_data.pose_list.front().pose.position.x;
-  const double dy =
-    traj_data.pose_list.back().pose.position.y - traj_data.pose_list.front().pose.position.y;
+  const double dx = s.pose_x[p1] - s.pose_x[p0];
+  const double dy = s.pose_y[p1] - s.pose_y[p0];
   if (d_pos.x * d_pos.x + d_pos.y * d_pos.y == 0) return;
 
   const double d_coef_vx = (d_pos.x * dx + d_pos.y * dy) / (d_pos.x * d_pos.x + d_pos.y * d_pos.y);
 
   coef_vx_.first += d_coef_vx;
   coef_vx_.second += 1;
-  coef_vx_list_.push_back(d_coef_vx);
+  coef_vx_statistics_.add(d_coef_vx);
+}
+
+void VelocityCoefModule::update_coef(const TrajectoryData & traj_data)
+{
+  update_coef(make_trajectory_store(traj_data).view());
 }
 
 /**
@@ -64,7 +62,7 @@ double VelocityCoefModule::get_coef() const
  */
 double VelocityCoefModule::get_coef_std() const
 {
-  return calculate_std(coef_vx_list_);
+  return coef_vx_statistics_.stddev();
 }
 
 bool VelocityCoefModule::empty() const
@@ -0,0 +1,77 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/async_file_writer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+std::string read_file(const std::string & path)
+{
+  std::ifstream file(path);
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+std::string temp_path(const std::string & name)
+{
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+}  // namespace
+
+TEST(AsyncFileWriter, WriteLatestContentOnFlush)
+{
+  const std::string path = temp_path("test_async_file_writer_flush.txt");
+  std::filesystem::remove(path);
+  AsyncFileWriter writer(60.0);
+  writer.write(path, "first");
+  writer.write(path, "second");
+  writer.flush();
+  EXPECT_EQ(read_file(path), "second");
+  EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  writer.write(path, "third");
+  writer.flush();
+  EXPECT_EQ(read_file(path), "third");
+  std::filesystem::remove(path);
+}
+
+TEST(AsyncFileWriter, WritePendingContentOnDestruction)
+{
+  const std::string path_a = temp_path("test_async_file_writer_a.txt");
+  const std::string path_b = temp_path("test_async_file_writer_b.txt");
+  {
+    AsyncFileWriter writer(60.0);
+    writer.write(path_a, "a");
+    writer.write(path_b, "b");
+  }
+  EXPECT_EQ(read_file(path_a), "a");
+  EXPECT_EQ(read_file(path_b), "b");
+  std::filesystem::remove(path_a);
+  std::filesystem::remove(path_b);
+}
+
+TEST(AsyncFileWriter, FlushWithoutContent)
+{
+  AsyncFileWriter writer(0.0);
+  writer.flush();
+  SUCCEED();
+}
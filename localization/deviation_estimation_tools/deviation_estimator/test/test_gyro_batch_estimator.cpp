@@ -0,0 +1,150 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/universe_utils/geometry/geometry.hpp"
+#include "deviation_estimator/deviation_estimator.hpp"
+#include "deviation_estimator/gyro_batch_estimator.hpp"
+#include "deviation_estimator/gyro_bias_module.hpp"
+#include "deviation_estimator/stddev_accumulator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Trajectory moving straight along the x-axis with noisy wheel speed and gyro
+TrajectoryData create_trajectory_data(
+  std::mt19937 & engine, const double t_offset, const double t_window, const double vx)
+{
+  const double stddev_gyro = 0.02;
+  const double stddev_vx = 0.1;
+  const int gyro_rate = 30;
+  const int vx_rate = 30;
+  const int ndt_rate = 10;
+  std::normal_distribution<> dist_gyro(0.0, stddev_gyro);
+  std::normal_distribution<> dist_vx(0.0, stddev_vx);
+  const rclcpp::Time t_start = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(t_offset);
+
+  TrajectoryData traj_data;
+  for (int i = 0; i <= gyro_rate * t_window; ++i) {
+    geometry_msgs::msg::Vector3Stamped gyro;
+    gyro.header.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / gyro_rate);
+    gyro.vector = createVector3(dist_gyro(engine), dist_gyro(engine), dist_gyro(engine));
+    traj_data.gyro_list.push_back(gyro);
+  }
+  for (int i = 0; i <= vx_rate * t_window; ++i) {
+    autoware_internal_debug_msgs::msg::Float64Stamped vx_msg;
+    vx_msg.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / vx_rate);
+    vx_msg.data = vx + dist_vx(engine);
+    traj_data.vx_list.push_back(vx_msg);
+  }
+  for (int i = 0; i <= ndt_rate * t_window; ++i) {
+    geometry_msgs::msg::PoseStamped pose;
+    pose.header.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / ndt_rate);
+    pose.pose.position.x = vx * i / ndt_rate;
+    pose.pose.orientation = autoware::universe_utils::createQuaternionFromRPY(0.0, 0.0, 0.0);
+    traj_data.pose_list.push_back(pose);
+  }
+  return traj_data;
+}
+
+void expect_vector_near(
+  const geometry_msgs::msg::Vector3 & actual, const geometry_msgs::msg::Vector3 & expected,
+  const double error_rate)
+{
+  EXPECT_NEAR(actual.x, expected.x, std::abs(expected.x) * error_rate);
+  EXPECT_NEAR(actual.y, expected.y, std::abs(expected.y) * error_rate);
+  EXPECT_NEAR(actual.z, expected.z, std::abs(expected.z) * error_rate);
+}
+
+void expect_in_between(
+  const geometry_msgs::msg::Vector3 & value, const geometry_msgs::msg::Vector3 & lower,
+  const geometry_msgs::msg::Vector3 & upper)
+{
+  EXPECT_LE(lower.x, value.x);
+  EXPECT_LE(value.x, upper.x);
+  EXPECT_LE(lower.y, value.y);
+  EXPECT_LE(value.y, upper.y);
+  EXPECT_LE(lower.z, value.z);
+  EXPECT_LE(value.z, upper.z);
+}
+}  // namespace
+
+TEST(DeviationEstimatorGyroBatchEstimator, SameAsModules)
+{
+  // Only the rounding errors of the different order of the summation are allowed.
+  const double ERROR_RATE = 1e-6;
+
+  std::mt19937 engine;
+  engine.seed();
+  std::uniform_real_distribution<> dist_window(3.0, 5.0);
+
+  GyroBatchEstimator estimator;
+  GyroBiasModule gyro_bias_module;
+  AngularVelocityStddevAccumulator gyro_accumulator;
+  double t_offset = 0.0;
+  for (int i = 0; i < 50; ++i) {
+    const double t_window = dist_window(engine);
+    const auto traj_data = create_trajectory_data(engine, t_offset, t_window, 5.0);
+    t_offset += t_window;
+
+    estimator.add(traj_data);
+    gyro_bias_module.update_bias(traj_data);
+    gyro_accumulator.add(traj_data);
+
+    const auto bias = gyro_bias_module.get_bias_base_link();
+    const auto estimate = estimator.estimate();
+    expect_vector_near(estimate.bias, bias, ERROR_RATE);
+    expect_vector_near(estimate.bias_std, gyro_bias_module.get_bias_std(), ERROR_RATE);
+    expect_vector_near(estimate.stddev, gyro_accumulator.estimate(bias), ERROR_RATE);
+  }
+
+  EXPECT_EQ(estimator.size(), gyro_accumulator.size());
+}
+
+TEST(DeviationEstimatorGyroBatchEstimator, Bootstrap)
+{
+  std::mt19937 engine;
+  engine.seed();
+
+  GyroBatchEstimator estimator;
+  double t_offset = 0.0;
+  for (int i = 0; i < 30; ++i) {
+    estimator.add(create_trajectory_data(engine, t_offset, 4.0, 5.0));
+    t_offset += 4.0;
+  }
+
+  const auto estimate = estimator.estimate();
+  const auto interval = estimator.bootstrap(200, 0.95, 42);
+  expect_in_between(estimate.bias, interval.lower.bias, interval.upper.bias);
+  expect_in_between(estimate.stddev, interval.lower.stddev, interval.upper.stddev);
+
+  // The replicates only depend on the seed, not on the threads computing them.
+  const auto same_interval = estimator.bootstrap(200, 0.95, 42);
+  EXPECT_DOUBLE_EQ(same_interval.lower.bias.x, interval.lower.bias.x);
+  EXPECT_DOUBLE_EQ(same_interval.upper.bias.y, interval.upper.bias.y);
+  EXPECT_DOUBLE_EQ(same_interval.lower.stddev.z, interval.lower.stddev.z);
+  EXPECT_DOUBLE_EQ(same_interval.upper.stddev.x, interval.upper.stddev.x);
+}
+
+TEST(DeviationEstimatorGyroBatchEstimator, Empty)
+{
+  const auto estimate = GyroBatchEstimator{}.estimate();
+  EXPECT_DOUBLE_EQ(estimate.bias.x, 0.0);
+  EXPECT_DOUBLE_EQ(estimate.bias_std.y, 0.0);
+  EXPECT_DOUBLE_EQ(estimate.stddev.z, 0.0);
+}
@@ -0,0 +1,125 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/universe_utils/geometry/geometry.hpp"
+#include "deviation_estimator/deviation_estimator.hpp"
+#include "deviation_estimator/stddev_accumulator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace
+{
+// Trajectory moving straight along the x-axis with noisy wheel speed and gyro
+TrajectoryData create_trajectory_data(
+  std::mt19937 & engine, const double t_offset, const double t_window, const double vx)
+{
+  const double stddev_gyro = 0.02;
+  const double stddev_vx = 0.1;
+  const int gyro_rate = 30;
+  const int vx_rate = 30;
+  const int ndt_rate = 10;
+  std::normal_distribution<> dist_gyro(0.0, stddev_gyro);
+  std::normal_distribution<> dist_vx(0.0, stddev_vx);
+  const rclcpp::Time t_start = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(t_offset);
+
+  TrajectoryData traj_data;
+  for (int i = 0; i <= gyro_rate * t_window; ++i) {
+    geometry_msgs::msg::Vector3Stamped gyro;
+    gyro.header.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / gyro_rate);
+    gyro.vector = createVector3(dist_gyro(engine), dist_gyro(engine), dist_gyro(engine));
+    traj_data.gyro_list.push_back(gyro);
+  }
+  for (int i = 0; i <= vx_rate * t_window; ++i) {
+    autoware_internal_debug_msgs::msg::Float64Stamped vx_msg;
+    vx_msg.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / vx_rate);
+    vx_msg.data = vx + dist_vx(engine);
+    traj_data.vx_list.push_back(vx_msg);
+  }
+  for (int i = 0; i <= ndt_rate * t_window; ++i) {
+    geometry_msgs::msg::PoseStamped pose;
+    pose.header.stamp = t_start + rclcpp::Duration::from_seconds(1.0 * i / ndt_rate);
+    pose.pose.position.x = vx * i / ndt_rate;
+    pose.pose.orientation = autoware::universe_utils::createQuaternionFromRPY(0.0, 0.0, 0.0);
+    traj_data.pose_list.push_back(pose);
+  }
+  return traj_data;
+}
+}  // namespace
+
+TEST(DeviationEstimatorStddevAccumulator, RunningStatistics)
+{
+  const std::vector<double> values{0.3, -1.2, 2.5, 0.7, 0.0, 1.1};
+
+  RunningStatistics statistics;
+  for (const double v : values) {
+    statistics.add(v);
+  }
+
+  EXPECT_EQ(statistics.size(), values.size());
+  EXPECT_NEAR(statistics.mean(), calculate_mean(values), 1e-12);
+  EXPECT_NEAR(statistics.stddev(), calculate_std(values), 1e-12);
+  EXPECT_NEAR(statistics.stddev_around(0.5), calculate_std_mean_const(values, 0.5), 1e-12);
+  EXPECT_DOUBLE_EQ(RunningStatistics{}.stddev(), 0.0);
+}
+
+TEST(DeviationEstimatorStddevAccumulator, SameAsBatchEstimation)
+{
+  // Only the rounding errors of the different order of the summation are allowed.
+  const double ERROR_RATE = 1e-6;
+
+  std::mt19937 engine;
+  engine.seed();
+  std::uniform_real_distribution<> dist_window(3.0, 5.0);
+
+  std::vector<TrajectoryData> traj_data_list;
+  VelocityStddevAccumulator velocity_accumulator;
+  AngularVelocityStddevAccumulator gyro_accumulator;
+  double t_offset = 0.0;
+  for (int i = 0; i < 50; ++i) {
+    const double t_window = dist_window(engine);
+    const auto traj_data = create_trajectory_data(engine, t_offset, t_window, 5.0);
+    t_offset += t_window;
+
+    traj_data_list.push_back(traj_data);
+    velocity_accumulator.add(traj_data);
+    gyro_accumulator.add(traj_data);
+
+    // The estimations must be the same as the batch ones for any coefficient and bias.
+    for (const double coef_vx : {0.95, 1.0, 1.02}) {
+      const double expected = estimate_stddev_velocity(traj_data_list, coef_vx);
+      EXPECT_NEAR(velocity_accumulator.estimate(coef_vx), expected, expected * ERROR_RATE);
+    }
+    const auto gyro_bias = createVector3(0.001, -0.002, 0.003);
+    const auto expected = estimate_stddev_angular_velocity(traj_data_list, gyro_bias);
+    const auto estimated = gyro_accumulator.estimate(gyro_bias);
+    EXPECT_NEAR(estimated.x, expected.x, expected.x * ERROR_RATE);
+    EXPECT_NEAR(estimated.y, expected.y, expected.y * ERROR_RATE);
+    EXPECT_NEAR(estimated.z, expected.z, expected.z * ERROR_RATE);
+  }
+
+  EXPECT_EQ(velocity_accumulator.size(), traj_data_list.size());
+  EXPECT_EQ(gyro_accumulator.size(), traj_data_list.size());
+}
+
+TEST(DeviationEstimatorStddevAccumulator, Empty)
+{
+  EXPECT_DOUBLE_EQ(VelocityStddevAccumulator{}.estimate(1.0), 0.0);
+  const auto stddev = AngularVelocityStddevAccumulator{}.estimate(geometry_msgs::msg::Vector3{});
+  EXPECT_DOUBLE_EQ(stddev.x, 0.0);
+  EXPECT_DOUBLE_EQ(stddev.y, 0.0);
+  EXPECT_DOUBLE_EQ(stddev.z, 0.0);
+}
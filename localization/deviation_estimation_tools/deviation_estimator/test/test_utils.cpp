@@ -16,6 +16,9 @@
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+#include <vector>
+
 TEST(DeviationEstimatorUtils, WhetherToUseData1)
 {
   const bool is_straight = false;
@@ -106,3 +109,100 @@ TEST(DeviationEstimatorUtils, WhetherToUseData7)
     is_straight, is_moving, is_constant_velocity, only_use_straight, only_use_moving,
     only_use_constant_velocity));
 }
+
+TEST(DeviationEstimatorUtils, Vector3StampedInterpolator)
+{
+  std::vector<geometry_msgs::msg::Vector3Stamped> vec_list;
+  for (int i = 0; i < 10; ++i) {
+    geometry_msgs::msg::Vector3Stamped vec;
+    vec.header.stamp = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(0.1 * i);
+    vec.vector = createVector3(i, -2.0 * i, i * i);
+    vec_list.push_back(vec);
+  }
+
+  // The queries going forward and back in time are the same as interpolate_vector3_stamped.
+  Vector3StampedInterpolator interpolator(vec_list);
+  for (const double time : {-0.05, 0.0, 0.03, 0.1, 0.47, 0.5, 0.21, 0.88, 0.9, 0.95}) {
+    const auto expected = interpolate_vector3_stamped(vec_list, time, 0.1);
+    const auto interpolated = interpolator.interpolate(time);
+    EXPECT_DOUBLE_EQ(interpolated.x, expected.x);
+    EXPECT_DOUBLE_EQ(interpolated.y, expected.y);
+    EXPECT_DOUBLE_EQ(interpolated.z, expected.z);
+  }
+
+  EXPECT_NEAR(interpolator.interpolate(0.25).x, 2.5, 1e-9);
+  EXPECT_THROW(interpolator.interpolate(1.1), std::domain_error);
+  EXPECT_THROW(interpolator.interpolate(-0.2), std::domain_error);
+}
+
+TEST(DeviationEstimatorUtils, TrajectoryStoreView)
+{
+  TrajectoryData traj_data;
+  for (int i = 0; i < 10; ++i) {
+    autoware_internal_debug_msgs::msg::Float64Stamped vx;
+    vx.stamp = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(0.1 * i);
+    vx.data = i;
+    traj_data.vx_list.push_back(vx);
+
+    geometry_msgs::msg::Vector3Stamped gyro;
+    gyro.header.stamp = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(0.05 + 0.1 * i);
+    gyro.vector = createVector3(0.0, 0.0, -i);
+    traj_data.gyro_list.push_back(gyro);
+  }
+  const TrajectoryStore store = make_trajectory_store(traj_data);
+
+  // The spans cover the same data as extract_sub_trajectory.
+  const rclcpp::Time t0(0, 200000000);
+  const rclcpp::Time t1(0, 650000000);
+  const TrajectoryView view = store.view(t0.seconds(), t1.seconds());
+  const auto vx_list = extract_sub_trajectory(traj_data.vx_list, t0, t1);
+  const auto gyro_list = extract_sub_trajectory(traj_data.gyro_list, t0, t1);
+  ASSERT_EQ(view.vx.size(), vx_list.size());
+  ASSERT_EQ(view.gyro.size(), gyro_list.size());
+  EXPECT_DOUBLE_EQ(store.vx[view.vx.front()], vx_list.front().data);
+  EXPECT_DOUBLE_EQ(store.wz[view.gyro.back()], gyro_list.back().vector.z);
+
+  EXPECT_DOUBLE_EQ(get_mean_abs_vx(view), get_mean_abs_vx(vx_list));
+  EXPECT_DOUBLE_EQ(get_mean_abs_wz(view), get_mean_abs_wz(gyro_list));
+  EXPECT_DOUBLE_EQ(get_mean_accel(view), get_mean_accel(vx_list));
+}
+
+TEST(DeviationEstimatorUtils, TrajectoryStoreViewWithGyroOfAnotherStore)
+{
+  TrajectoryData traj_data;
+  TrajectoryData other_imu_data;
+  for (int i = 0; i < 10; ++i) {
+    autoware_internal_debug_msgs::msg::Float64Stamped vx;
+    vx.stamp = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(0.1 * i);
+    vx.data = i;
+    traj_data.vx_list.push_back(vx);
+
+    geometry_msgs::msg::Vector3Stamped gyro;
+    gyro.header.stamp = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(0.05 + 0.1 * i);
+    gyro.vector = createVector3(0.0, 0.0, -i);
+    traj_data.gyro_list.push_back(gyro);
+
+    // The other IMU runs at twice the rate
+    for (int j = 0; j < 2; ++j) {
+      gyro.header.stamp = rclcpp::Time(0, 0) + rclcpp::Duration::from_seconds(0.05 * (2 * i + j));
+      gyro.vector = createVector3(0.0, 0.0, 2.0 * i + j);
+      other_imu_data.gyro_list.push_back(gyro);
+    }
+  }
+  const TrajectoryStore store = make_trajectory_store(traj_data);
+  const TrajectoryStore other_imu_store = make_trajectory_store(other_imu_data);
+
+  const rclcpp::Time t0(0, 200000000);
+  const rclcpp::Time t1(0, 650000000);
+  const TrajectoryView view = store.view(t0.seconds(), t1.seconds(), other_imu_store);
+  const auto vx_list = extract_sub_trajectory(traj_data.vx_list, t0, t1);
+  const auto gyro_list = extract_sub_trajectory(other_imu_data.gyro_list, t0, t1);
+  EXPECT_EQ(view.store, &store);
+  EXPECT_EQ(view.gyro_store, &other_imu_store);
+  ASSERT_EQ(view.vx.size(), vx_list.size());
+  ASSERT_EQ(view.gyro.size(), gyro_list.size());
+  EXPECT_DOUBLE_EQ(other_imu_store.wz[view.gyro.back()], gyro_list.back().vector.z);
+
+  EXPECT_DOUBLE_EQ(get_mean_abs_vx(view), get_mean_abs_vx(vx_list));
+  EXPECT_DOUBLE_EQ(get_mean_abs_wz(view), get_mean_abs_wz(gyro_list));
+}
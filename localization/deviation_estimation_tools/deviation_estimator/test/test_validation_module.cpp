@@ -0,0 +1,80 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_estimator/validation_module.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST(DeviationEstimatorValidationModule, SlidingWindowStatistics)
+{
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<> dist(-1.0, 1.0);
+  const size_t capacity = 5;
+  SlidingWindowStatistics statistics(capacity);
+  std::vector<double> values;
+
+  // The statistics are the same as those computed from the last "capacity" values
+  for (int i = 0; i < 100; ++i) {
+    const double value = dist(engine);
+    values.push_back(value);
+    statistics.add(value);
+
+    std::vector<double> window(values.end() - std::min(values.size(), capacity), values.end());
+    std::sort(window.begin(), window.end());
+    ASSERT_EQ(statistics.size(), window.size());
+    EXPECT_DOUBLE_EQ(statistics.min(), window.front());
+    EXPECT_DOUBLE_EQ(statistics.max(), window.back());
+    if (window.size() == capacity) {
+      EXPECT_DOUBLE_EQ(statistics.percentile(0.5), window[capacity / 2]);
+    }
+  }
+}
+
+TEST(DeviationEstimatorValidationModule, IgnoreNaN)
+{
+  SlidingWindowStatistics statistics(3);
+  statistics.add(1.0);
+  statistics.add(std::nan(""));
+  statistics.add(3.0);
+  EXPECT_EQ(statistics.size(), 3u);
+  EXPECT_DOUBLE_EQ(statistics.min(), 1.0);
+  EXPECT_DOUBLE_EQ(statistics.max(), 3.0);
+  EXPECT_DOUBLE_EQ(statistics.percentile(0.5), 2.0);
+
+  statistics.add(2.0);
+  EXPECT_DOUBLE_EQ(statistics.min(), 2.0);
+  EXPECT_DOUBLE_EQ(statistics.max(), 3.0);
+}
+
+TEST(DeviationEstimatorValidationModule, GetMinMax)
+{
+  ValidationModule validation_module(0.01, 0.05, 0.001, 0.01, 5);
+  validation_module.set_velocity_data(1.0, 0.1);
+  EXPECT_THROW(validation_module.get_min_max("coef_vx"), std::domain_error);
+  EXPECT_THROW(validation_module.get_min_max("invalid_key"), std::runtime_error);
+
+  for (int i = 1; i < 10; ++i) {
+    validation_module.set_velocity_data(1.0 + 0.001 * i, 0.1);
+  }
+  const auto min_max = validation_module.get_min_max("coef_vx");
+  EXPECT_DOUBLE_EQ(min_max.first, 1.005);
+  EXPECT_DOUBLE_EQ(min_max.second, 1.009);
+  EXPECT_DOUBLE_EQ(validation_module.get_percentile("coef_vx", 0.5), 1.007);
+  EXPECT_TRUE(validation_module.is_valid("coef_vx"));
+}
@@ -17,6 +17,7 @@
 
 #include "autoware/universe_utils/ros/transform_listener.hpp"
 #include "deviation_evaluator/autoware_universe_utils.hpp"
+#include "deviation_evaluator/deviation_monitor.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "tf2/LinearMath/Quaternion.h"
 
@@ -31,7 +32,6 @@
 
 #include <tf2/utils.h>
 
-#include <deque>
 #include <fstream>
 #include <iostream>
 #include <memory>
@@ -45,12 +45,6 @@ private:
   using TwistWithCovarianceStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
   using PoseStamped = geometry_msgs::msg::PoseStamped;
   using Odometry = nav_msgs::msg::Odometry;
-  struct Errors
-  {
-    double lateral;
-    double long_radius;
-    Errors() : lateral(0), long_radius(0) {}
-  };
 
 public:
   DeviationEvaluator(const std::string & node_name, const rclcpp::NodeOptions & options);
@@ -68,23 +62,14 @@ private:
 
   bool show_debug_info_;
   std::string save_dir_;
-  double start_time_;
 
-  double wait_duration_;
-  Errors errors_threshold_;
-  Errors current_errors_;
-
-  std::deque<PoseStamped::SharedPtr> dr_pose_queue_;
-
-  PoseStamped::SharedPtr last_gt_pose_ptr_;
+  std::unique_ptr<DeviationMonitor> monitor_;
 
   PoseStamped::SharedPtr current_ekf_gt_pose_ptr_;
   PoseStamped::SharedPtr current_ndt_pose_ptr_;
 
   std::shared_ptr<autoware::universe_utils::TransformListener> transform_listener_;
 
-  bool has_published_initial_pose_;
-
   // void callbackWheelOdometry(const TwistWithCovarianceStamped::SharedPtr msg);
 
   void callbackNDTPoseWithCovariance(const PoseWithCovarianceStamped::SharedPtr msg);
@@ -93,8 +78,6 @@ private:
   void callbackEKFDROdom(const Odometry::SharedPtr msg);
 
   void callbackEKFGTOdom(const Odometry::SharedPtr msg);
-
-  geometry_msgs::msg::Pose interpolatePose(const double timestamp_seconds);
 };
 
 #endif  // DEVIATION_EVALUATOR__DEVIATION_EVALUATOR_HPP_
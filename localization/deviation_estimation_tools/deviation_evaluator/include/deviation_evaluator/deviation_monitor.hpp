@@ -0,0 +1,92 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_EVALUATOR__DEVIATION_MONITOR_HPP_
+#define DEVIATION_EVALUATOR__DEVIATION_MONITOR_HPP_
+
+#include "deviation_evaluator/pose_ring_buffer.hpp"
+
+#include "geometry_msgs/msg/pose.hpp"
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+
+#include <cstddef>
+
+/**
+ * @brief the EKF initialization pose made from an NDT pose, with small covariances
+ */
+geometry_msgs::msg::PoseWithCovarianceStamped createInitialPose(
+  const geometry_msgs::msg::PoseWithCovarianceStamped & ndt_pose);
+
+/**
+ * @brief decisions of the deviation evaluator on the NDT poses and the outputs of the dead
+ * reckoning (DR) and ground truth (GT) EKFs. It is shared by the node and the batch tool so that
+ * both evaluate the same way.
+ */
+class DeviationMonitor
+{
+public:
+  enum class NDTPoseUse { INITIAL_POSE, DR_AND_GT, GT };
+
+  struct Errors
+  {
+    double lateral;
+    double long_radius;
+    Errors() : lateral(0), long_radius(0) {}
+  };
+
+  DeviationMonitor(const double wait_duration, const Errors & errors_threshold);
+
+  /**
+   * @brief the EKFs the NDT pose of "time" is sent to. The first pose initializes them, and the
+   * following ones are also sent to the DR EKF only for wait_duration.
+   */
+  NDTPoseUse useNDTPose(const double time);
+
+  /**
+   * @brief return true if the errors are large enough, when the EKFs are initialized again with
+   * the next NDT pose
+   */
+  bool resetIfErrorsAreLarge(const double time);
+
+  /**
+   * @brief return false if the timestamp jumps back, when the DR poses so far are cleared
+   */
+  bool addDRPose(const double time, const geometry_msgs::msg::Pose & pose);
+
+  /**
+   * @brief update the errors at the GT pose once the DR poses around it are available
+   */
+  void addGTPose(const double time, const geometry_msgs::msg::Pose & pose);
+
+  const Errors & currentErrors() const { return current_errors_; }
+
+private:
+  double wait_duration_;
+  Errors errors_threshold_;
+  Errors current_errors_;
+  double start_time_;
+  bool has_published_initial_pose_;
+
+  // 20 seconds of the EKF output at 50 Hz
+  static constexpr size_t dr_pose_buffer_capacity_ = 1000;
+  PoseRingBuffer dr_pose_buffer_;
+
+  bool has_last_gt_pose_;
+  double last_gt_time_;
+  geometry_msgs::msg::Pose last_gt_pose_;
+
+  geometry_msgs::msg::Pose interpolatePose(const double time) const;
+};
+
+#endif  // DEVIATION_EVALUATOR__DEVIATION_MONITOR_HPP_
@@ -0,0 +1,98 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVIATION_EVALUATOR__POSE_RING_BUFFER_HPP_
+#define DEVIATION_EVALUATOR__POSE_RING_BUFFER_HPP_
+
+#include "geometry_msgs/msg/pose.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief preallocated ring buffer of time-ordered poses. When it is full, the oldest pose is
+ * overwritten. The indices are counted from the oldest pose.
+ */
+class PoseRingBuffer
+{
+public:
+  explicit PoseRingBuffer(const size_t capacity)
+  : times_(std::max<size_t>(capacity, 1)), poses_(std::max<size_t>(capacity, 1))
+  {
+  }
+
+  void push_back(const double time, const geometry_msgs::msg::Pose & pose)
+  {
+    const size_t idx = (head_ + size_) % capacity();
+    times_[idx] = time;
+    poses_[idx] = pose;
+    if (size_ < capacity()) {
+      ++size_;
+    } else {
+      head_ = (head_ + 1) % capacity();
+    }
+  }
+
+  // remove the oldest "n" poses
+  void pop_front(const size_t n)
+  {
+    const size_t num = std::min(n, size_);
+    head_ = (head_ + num) % capacity();
+    size_ -= num;
+  }
+
+  void clear()
+  {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return times_.size(); }
+
+  double time(const size_t i) const { return times_[(head_ + i) % capacity()]; }
+  const geometry_msgs::msg::Pose & pose(const size_t i) const
+  {
+    return poses_[(head_ + i) % capacity()];
+  }
+  double front_time() const { return time(0); }
+  double back_time() const { return time(size_ - 1); }
+
+  // index of the first pose later than "t", or size() if there is none
+  size_t upper_bound(const double t) const
+  {
+    size_t first = 0;
+    size_t count = size_;
+    while (count > 0) {
+      const size_t step = count / 2;
+      if (!(t < time(first + step))) {
+        first += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    return first;
+  }
+
+private:
+  std::vector<double> times_;
+  std::vector<geometry_msgs::msg::Pose> poses_;
+  size_t head_{0};
+  size_t size_{0};
+};
+
+#endif  // DEVIATION_EVALUATOR__POSE_RING_BUFFER_HPP_
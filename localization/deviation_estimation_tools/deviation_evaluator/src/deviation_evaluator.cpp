@@ -40,32 +40,19 @@ double double_round(const double x, const int n)
   return std::round(x * pow(10, n)) / pow(10, n);
 }
 
-double norm_xy(const geometry_msgs::msg::Point & p1, const geometry_msgs::msg::Point & p2)
-{
-  double dx = p1.x - p2.x;
-  double dy = p1.y - p2.y;
-  return std::sqrt(dx * dx + dy * dy);
-}
-
-double norm_xy_lateral(
-  const geometry_msgs::msg::Point & p1, const geometry_msgs::msg::Point & p2, const double yaw)
-{
-  double dx = p1.x - p2.x;
-  double dy = p1.y - p2.y;
-  return std::abs(dx * std::sin(yaw) - dy * std::cos(yaw));
-}
-
 DeviationEvaluator::DeviationEvaluator(
   const std::string & node_name, const rclcpp::NodeOptions & node_options)
 : rclcpp::Node(node_name, node_options)
 {
   show_debug_info_ = declare_parameter<bool>("show_debug_info", false);
   save_dir_ = declare_parameter<std::string>("save_dir");
-  wait_duration_ = declare_parameter<double>("wait_duration");
+  const double wait_duration = declare_parameter<double>("wait_duration");
   double wait_scale = declare_parameter<double>("wait_scale");
-  errors_threshold_.lateral =
+  DeviationMonitor::Errors errors_threshold;
+  errors_threshold.lateral =
     declare_parameter<double>("warn_ellipse_size_lateral_direction") * wait_scale;
-  errors_threshold_.long_radius = declare_parameter<double>("warn_ellipse_size") * wait_scale;
+  errors_threshold.long_radius = declare_parameter<double>("warn_ellipse_size") * wait_scale;
+  monitor_ = std::make_unique<DeviationMonitor>(wait_duration, errors_threshold);
 
   client_trigger_ekf_dr_ =
     create_client<std_srvs::srv::SetBool>("out_ekf_dr_trigger", rmw_qos_profile_services_default);
@@ -109,105 +96,38 @@ DeviationEvaluator::DeviationEvaluator(
   transform_listener_ = std::make_shared<autoware::universe_utils::TransformListener>(this);
 
   current_ndt_pose_ptr_ = nullptr;
-  has_published_initial_pose_ = false;
 }
 
 void DeviationEvaluator::callbackNDTPoseWithCovariance(
   const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg)
 {
-  if (!has_published_initial_pose_) {
-    geometry_msgs::msg::PoseWithCovarianceStamped pose_with_cov;
-    pose_with_cov = *msg;
-    const double initial_position_stddev = 0.05;
-    const double initial_angle_stddev = 0.01;
-    pose_with_cov.pose.covariance[0 * 6 + 0] = initial_position_stddev * initial_position_stddev;
-    pose_with_cov.pose.covariance[1 * 6 + 1] = initial_position_stddev * initial_position_stddev;
-    pose_with_cov.pose.covariance[2 * 6 + 2] = initial_position_stddev * initial_position_stddev;
-    pose_with_cov.pose.covariance[3 * 6 + 3] = initial_angle_stddev * initial_angle_stddev;
-    pose_with_cov.pose.covariance[4 * 6 + 4] = initial_angle_stddev * initial_angle_stddev;
-    pose_with_cov.pose.covariance[5 * 6 + 5] = initial_angle_stddev * initial_angle_stddev;
-    pub_init_pose_with_cov_->publish(pose_with_cov);
-    has_published_initial_pose_ = true;
-    start_time_ = rclcpp::Time(msg->header.stamp).seconds();
+  const double msg_time = rclcpp::Time(msg->header.stamp).seconds();
+
+  const auto use = monitor_->useNDTPose(msg_time);
+  if (use == DeviationMonitor::NDTPoseUse::INITIAL_POSE) {
+    pub_init_pose_with_cov_->publish(createInitialPose(*msg));
     return;
   }
 
-  const double msg_time = rclcpp::Time(msg->header.stamp).seconds();
-
-  if (msg_time - start_time_ < wait_duration_) {
+  if (use == DeviationMonitor::NDTPoseUse::DR_AND_GT) {
     pub_pose_with_cov_dr_->publish(*msg);
   }
   pub_pose_with_cov_gt_->publish(*msg);
 
-  if (
-    (current_errors_.lateral > errors_threshold_.lateral) &
-    (current_errors_.long_radius > errors_threshold_.long_radius)) {
+  if (monitor_->resetIfErrorsAreLarge(msg_time)) {
     RCLCPP_INFO(this->get_logger(), "Errors are large enough. Publish EKF initialization poses.");
-    start_time_ = msg_time;
-    has_published_initial_pose_ = false;
-    current_errors_ = Errors();
   }
 }
 
 void DeviationEvaluator::callbackEKFDROdom(const Odometry::SharedPtr msg)
 {
-  PoseStamped::SharedPtr pose_ptr(new PoseStamped);
-  pose_ptr->pose = msg->pose.pose;
-  pose_ptr->header = msg->header;
-  if (!dr_pose_queue_.empty()) {
-    if (
-      rclcpp::Time(dr_pose_queue_.back()->header.stamp).seconds() >
-      rclcpp::Time(pose_ptr->header.stamp).seconds()) {
-      dr_pose_queue_.clear();
-      RCLCPP_ERROR_STREAM(this->get_logger(), "Timestamp jump detected!");
-    }
+  const double msg_time = rclcpp::Time(msg->header.stamp).seconds();
+  if (!monitor_->addDRPose(msg_time, msg->pose.pose)) {
+    RCLCPP_ERROR_STREAM(this->get_logger(), "Timestamp jump detected!");
   }
-  dr_pose_queue_.push_back(pose_ptr);
 }
 
 void DeviationEvaluator::callbackEKFGTOdom(const Odometry::SharedPtr msg)
 {
-  if (last_gt_pose_ptr_ == nullptr) {
-    last_gt_pose_ptr_.reset(new PoseStamped);
-    last_gt_pose_ptr_->header = msg->header;
-    last_gt_pose_ptr_->pose = msg->pose.pose;
-  }
-  if (dr_pose_queue_.size() < 2) return;
-
-  double start_time = rclcpp::Time(dr_pose_queue_.front()->header.stamp).seconds();
-  double target_time = rclcpp::Time(last_gt_pose_ptr_->header.stamp).seconds();
-  if (start_time > target_time) {
-    last_gt_pose_ptr_ = nullptr;
-    return;
-  }
-
-  geometry_msgs::msg::Pose target_pose;
-  try {
-    target_pose = interpolatePose(target_time);
-  } catch (const std::runtime_error & exception) {
-    return;
-  }
-  current_errors_.long_radius = norm_xy(target_pose.position, last_gt_pose_ptr_->pose.position);
-  current_errors_.lateral = norm_xy_lateral(
-    target_pose.position, last_gt_pose_ptr_->pose.position, tf2::getYaw(target_pose.orientation));
-  last_gt_pose_ptr_ = nullptr;
-  dr_pose_queue_.clear();
-}
-
-geometry_msgs::msg::Pose DeviationEvaluator::interpolatePose(const double time)
-{
-  const auto iter_next = std::upper_bound(
-    dr_pose_queue_.begin(), dr_pose_queue_.end(), time,
-    [](double const & t1, geometry_msgs::msg::PoseStamped::SharedPtr const & t2) -> bool {
-      return t1 < rclcpp::Time(t2->header.stamp).seconds();
-    });
-
-  if ((iter_next == dr_pose_queue_.begin()) | (iter_next == dr_pose_queue_.end())) {
-    throw std::runtime_error("Interpolation failed");
-  }
-
-  const double time_start = rclcpp::Time((*(iter_next - 1))->header.stamp).seconds();
-  const double time_end = rclcpp::Time((*iter_next)->header.stamp).seconds();
-  const double ratio = (time - time_start) / (time_end - time_start);
-  return calcInterpolatedPose((*(iter_next - 1))->pose, (*iter_next)->pose, ratio);
+  monitor_->addGTPose(rclcpp::Time(msg->header.stamp).seconds(), msg->pose.pose);
 }
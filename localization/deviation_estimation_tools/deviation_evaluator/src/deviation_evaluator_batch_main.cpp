@@ -0,0 +1,435 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Evaluate the deviations on rosbag2 files without replaying them. The dead reckoning (DR) and
+// ground truth (GT) EKFs of ekf_localizer run in the process, and their timers are driven by the
+// bag time instead of the clock, so a bag is processed as fast as the CPU allows. The bags are
+// processed by parallel worker processes, and each of them writes a bag of the same topics as the
+// deviation_evaluator launch records, which the visualizer reads.
+
+#include "autoware/ekf_localizer/ekf_module.hpp"
+#include "autoware/ekf_localizer/hyper_parameters.hpp"
+#include "autoware/ekf_localizer/warning.hpp"
+#include "deviation_evaluator/deviation_monitor.hpp"
+
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <rclcpp/rclcpp.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_cpp/writer.hpp>
+#include <rosbag2_storage/metadata_io.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include "geometry_msgs/msg/pose_with_covariance_stamped.hpp"
+#include "geometry_msgs/msg/transform_stamped.hpp"
+#include "geometry_msgs/msg/twist_with_covariance_stamped.hpp"
+#include "nav_msgs/msg/odometry.hpp"
+
+#include <tf2/LinearMath/Matrix3x3.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using autoware::ekf_localizer::EKFDiagnosticInfo;
+using autoware::ekf_localizer::EKFModule;
+using autoware::ekf_localizer::HyperParameters;
+using autoware::ekf_localizer::Warning;
+using PoseWithCovarianceStamped = geometry_msgs::msg::PoseWithCovarianceStamped;
+using TwistWithCovarianceStamped = geometry_msgs::msg::TwistWithCovarianceStamped;
+using Odometry = nav_msgs::msg::Odometry;
+
+// The topics recorded by deviation_evaluator.launch.xml with its default arguments
+const char * const TOPIC_POSE_DR =
+  "/deviation_evaluator/dead_reckoning/pose_estimator/pose_with_covariance";
+const char * const TOPIC_POSE_GT =
+  "/deviation_evaluator/ground_truth/pose_estimator/pose_with_covariance";
+const char * const TOPIC_TWIST = "/deviation_evaluator/twist_estimator/twist_with_covariance";
+const char * const TOPIC_EKF_ODOM_DR =
+  "/deviation_evaluator/dead_reckoning/ekf_localizer/kinematic_state";
+const char * const TOPIC_EKF_ODOM_GT =
+  "/deviation_evaluator/ground_truth/ekf_localizer/kinematic_state";
+
+/**
+ * @brief an ekf_localizer node whose timer is called with the bag time. The measurements are
+ * applied for their smoothing steps as the aged queues of the node do, and z, roll and pitch are
+ * those of the latest pose since the outputs are only evaluated in the xy plane.
+ */
+class ReplayedEKF
+{
+public:
+  ReplayedEKF(const std::shared_ptr<Warning> & warning, const HyperParameters & params)
+  : params_(params), module_(warning, params)
+  {
+  }
+
+  void initialize(const PoseWithCovarianceStamped & initial_pose)
+  {
+    // The poses are in the pose frame of the EKF
+    geometry_msgs::msg::TransformStamped transform;
+    transform.transform.rotation.w = 1.0;
+    module_.initialize(initial_pose, transform);
+    latest_pose_ = initial_pose.pose.pose;
+    pose_queue_.clear();
+    twist_queue_.clear();
+    is_initialized_ = true;
+    has_predicted_ = false;
+  }
+
+  void addPose(const PoseWithCovarianceStamped & pose)
+  {
+    if (is_initialized_) {
+      pose_queue_.emplace_back(pose, 0);
+    }
+  }
+
+  void addTwist(const TwistWithCovarianceStamped & twist)
+  {
+    if (is_initialized_) {
+      twist_queue_.emplace_back(twist, 0);
+    }
+  }
+
+  // run the timer callback at "time", and return false if there is no output
+  bool update(const rclcpp::Time & time, Odometry & odom)
+  {
+    if (!is_initialized_) {
+      return false;
+    }
+    if (!has_predicted_) {
+      last_predict_time_ = time;
+      has_predicted_ = true;
+      return false;
+    }
+
+    const double dt = (time - last_predict_time_).seconds();
+    last_predict_time_ = time;
+    module_.accumulate_delay_time(dt);
+    module_.predict_with_delay(dt);
+
+    for (size_t i = pose_queue_.size(); i > 0; --i) {
+      auto pose = std::move(pose_queue_.front());
+      pose_queue_.pop_front();
+      if (module_.measurement_update_pose(pose.first, time, pose_diag_info_)) {
+        latest_pose_ = pose.first.pose.pose;
+      }
+      if (++pose.second < static_cast<size_t>(params_.pose_smoothing_steps)) {
+        pose_queue_.push_back(std::move(pose));
+      }
+    }
+    for (size_t i = twist_queue_.size(); i > 0; --i) {
+      auto twist = std::move(twist_queue_.front());
+      twist_queue_.pop_front();
+      module_.measurement_update_twist(twist.first, time, twist_diag_info_);
+      if (++twist.second < static_cast<size_t>(params_.twist_smoothing_steps)) {
+        twist_queue_.push_back(std::move(twist));
+      }
+    }
+
+    double roll = 0.0;
+    double pitch = 0.0;
+    double yaw = 0.0;
+    const auto & q = latest_pose_.orientation;
+    tf2::Matrix3x3(tf2::Quaternion(q.x, q.y, q.z, q.w)).getRPY(roll, pitch, yaw);
+    odom.header.stamp = time;
+    odom.header.frame_id = params_.pose_frame_id;
+    odom.child_frame_id = "base_link";
+    odom.pose.pose =
+      module_.get_current_pose(time, latest_pose_.position.z, roll, pitch, false).pose;
+    odom.pose.covariance = module_.get_current_pose_covariance();
+    odom.twist.twist = module_.get_current_twist(time).twist;
+    odom.twist.covariance = module_.get_current_twist_covariance();
+    return true;
+  }
+
+private:
+  const HyperParameters & params_;
+  EKFModule module_;
+  bool is_initialized_{false};
+  bool has_predicted_{false};
+  rclcpp::Time last_predict_time_;
+  geometry_msgs::msg::Pose latest_pose_;
+
+  // The measurements with the number of the times they have been applied
+  std::deque<std::pair<PoseWithCovarianceStamped, size_t>> pose_queue_;
+  std::deque<std::pair<TwistWithCovarianceStamped, size_t>> twist_queue_;
+  EKFDiagnosticInfo pose_diag_info_;
+  EKFDiagnosticInfo twist_diag_info_;
+};
+
+// the file or the directory name of the bag
+std::string getBagName(std::string bag_path)
+{
+  while (bag_path.size() > 1 && bag_path.back() == '/') {
+    bag_path.pop_back();
+  }
+  const auto pos = bag_path.find_last_of('/');
+  return pos == std::string::npos ? bag_path : bag_path.substr(pos + 1);
+}
+
+// run the evaluation over a bag, write the bag for the visualizer under save_dir and a row of the
+// summary to output_path
+int processBag(
+  const std::string & bag_path, const std::vector<std::string> & param_paths,
+  const std::string & save_dir, const std::string & output_path)
+{
+  // The node is only used for the parameters and the warnings of the EKFs and is never spun
+  rclcpp::init(0, nullptr);
+  std::vector<std::string> arguments = {"--ros-args"};
+  for (const auto & param_path : param_paths) {
+    arguments.push_back("--params-file");
+    arguments.push_back(param_path);
+  }
+  rclcpp::NodeOptions node_options;
+  node_options.arguments(arguments);
+  auto node = std::make_shared<rclcpp::Node>("deviation_evaluator_batch_tool", node_options);
+
+  const double wait_duration = node->declare_parameter<double>("wait_duration");
+  const double wait_scale = node->declare_parameter<double>("wait_scale");
+  DeviationMonitor::Errors errors_threshold;
+  errors_threshold.lateral =
+    node->declare_parameter<double>("warn_ellipse_size_lateral_direction") * wait_scale;
+  errors_threshold.long_radius = node->declare_parameter<double>("warn_ellipse_size") * wait_scale;
+  const auto ndt_pose_topic = node->declare_parameter<std::string>(
+    "in_ndt_pose_with_covariance", "/localization/pose_estimator/pose_with_covariance");
+  const auto twist_topic = node->declare_parameter<std::string>(
+    "in_twist_with_covariance", "/localization/twist_estimator/twist_with_covariance");
+
+  const HyperParameters ekf_params(node.get());
+  const auto warning = std::make_shared<Warning>(node.get());
+  ReplayedEKF ekf_dr(warning, ekf_params);
+  ReplayedEKF ekf_gt(warning, ekf_params);
+  DeviationMonitor monitor(wait_duration, errors_threshold);
+
+  // Prepare rosbag reader
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_path;
+  rosbag2_storage::MetadataIo metadata_io;
+  storage_options.storage_id = metadata_io.metadata_file_exists(bag_path)
+                                 ? metadata_io.read_metadata(bag_path).storage_identifier
+                                 : "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  // Read only the topics used for the evaluation
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {ndt_pose_topic, twist_topic};
+  reader.set_filter(storage_filter);
+
+  // The visualizer reads the sqlite3 file of save_dir/ros2bag
+  rosbag2_storage::StorageOptions output_storage_options;
+  output_storage_options.uri = save_dir + "/ros2bag";
+  output_storage_options.storage_id = "sqlite3";
+  rosbag2_cpp::Writer writer;
+  writer.open(output_storage_options, converter_options);
+
+  size_t num_initializations = 0;
+  DeviationMonitor::Errors max_errors;
+
+  // The timers of the EKF nodes are replaced by the ticks of the bag time
+  const auto ekf_dt_ns = static_cast<int64_t>(ekf_params.ekf_dt * 1e9);
+  int64_t next_update_time_ns = -1;
+  const auto process_until = [&](const int64_t t_ns) {
+    for (; next_update_time_ns <= t_ns; next_update_time_ns += ekf_dt_ns) {
+      const rclcpp::Time time(next_update_time_ns, RCL_ROS_TIME);
+      Odometry odom;
+      if (ekf_dr.update(time, odom)) {
+        writer.write(odom, TOPIC_EKF_ODOM_DR, time);
+        if (!monitor.addDRPose(time.seconds(), odom.pose.pose)) {
+          std::cerr << bag_path << ": Timestamp jump detected!" << std::endl;
+        }
+      }
+      if (ekf_gt.update(time, odom)) {
+        writer.write(odom, TOPIC_EKF_ODOM_GT, time);
+        monitor.addGTPose(time.seconds(), odom.pose.pose);
+        max_errors.lateral = std::max(max_errors.lateral, monitor.currentErrors().lateral);
+        max_errors.long_radius =
+          std::max(max_errors.long_radius, monitor.currentErrors().long_radius);
+      }
+    }
+  };
+
+  rclcpp::Serialization<PoseWithCovarianceStamped> serialization_pose;
+  rclcpp::Serialization<TwistWithCovarianceStamped> serialization_twist;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const int64_t t_ns = serialized_message->time_stamp;
+    if (next_update_time_ns < 0) {
+      next_update_time_ns = t_ns;
+    }
+    process_until(t_ns);
+
+    const rclcpp::Time time(t_ns, RCL_ROS_TIME);
+    rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    if (serialized_message->topic_name == ndt_pose_topic) {
+      PoseWithCovarianceStamped pose_msg;
+      serialization_pose.deserialize_message(&msg, &pose_msg);
+      writer.write(pose_msg, ndt_pose_topic, time);
+
+      const double msg_time = rclcpp::Time(pose_msg.header.stamp).seconds();
+      const auto use = monitor.useNDTPose(msg_time);
+      if (use == DeviationMonitor::NDTPoseUse::INITIAL_POSE) {
+        const auto initial_pose = createInitialPose(pose_msg);
+        ekf_dr.initialize(initial_pose);
+        ekf_gt.initialize(initial_pose);
+        ++num_initializations;
+        continue;
+      }
+
+      if (use == DeviationMonitor::NDTPoseUse::DR_AND_GT) {
+        ekf_dr.addPose(pose_msg);
+        writer.write(pose_msg, TOPIC_POSE_DR, time);
+      }
+      ekf_gt.addPose(pose_msg);
+      writer.write(pose_msg, TOPIC_POSE_GT, time);
+      monitor.resetIfErrorsAreLarge(msg_time);
+    } else {
+      TwistWithCovarianceStamped twist_msg;
+      serialization_twist.deserialize_message(&msg, &twist_msg);
+      writer.write(twist_msg, TOPIC_TWIST, time);
+      ekf_dr.addTwist(twist_msg);
+      ekf_gt.addTwist(twist_msg);
+    }
+  }
+
+  std::ofstream output_file(output_path);
+  output_file << std::fixed << bag_path << "," << save_dir << "," << num_initializations << ","
+              << max_errors.lateral << "," << max_errors.long_radius << "\n";
+  rclcpp::shutdown();
+  return output_file.good() ? 0 : 1;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t num_workers = 1;
+  const std::vector<std::string> default_param_paths = {
+    ament_index_cpp::get_package_share_directory("autoware_ekf_localizer") +
+      "/config/ekf_localizer.param.yaml",
+    ament_index_cpp::get_package_share_directory("autoware_launch") +
+      "/config/localization/localization_error_monitor.param.yaml",
+    ament_index_cpp::get_package_share_directory("deviation_evaluator") +
+      "/config/deviation_evaluator.param.yaml",
+    ament_index_cpp::get_package_share_directory("deviation_evaluator") +
+      "/config/deviation_evaluator_batch.param.yaml"};
+  std::vector<std::string> param_paths = default_param_paths;
+  std::vector<std::string> positional_args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      num_workers = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg == "-p" && i + 1 < argc) {
+      param_paths.push_back(argv[++i]);
+    } else {
+      positional_args.push_back(arg);
+    }
+  }
+  if (positional_args.size() < 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [-j num_workers] [-p param_yaml]... <output_dir> <rosbag_path>..." << std::endl;
+    return 1;
+  }
+  const std::string output_dir = positional_args.front();
+  const std::vector<std::string> bag_paths(positional_args.begin() + 1, positional_args.end());
+  if (mkdir(output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    std::cerr << "Failed to create " << output_dir << std::endl;
+    return 1;
+  }
+  // The bags of the same name are told apart by their indices
+  const auto getSaveDir = [&](const size_t i) {
+    return output_dir + "/" + std::to_string(i) + "_" + getBagName(bag_paths[i]);
+  };
+  const auto getPartPath = [&](const size_t i) { return getSaveDir(i) + ".part"; };
+
+  // Each bag is processed in a worker process, so that the EKFs and rclcpp are not shared
+  std::map<pid_t, size_t> workers;
+  std::vector<bool> is_succeeded(bag_paths.size(), false);
+  const auto waitWorker = [&]() {
+    int status = 0;
+    const pid_t pid = wait(&status);
+    const auto iter = workers.find(pid);
+    if (iter == workers.end()) {
+      return;
+    }
+    is_succeeded[iter->second] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!is_succeeded[iter->second]) {
+      std::cerr << "Failed to process " << bag_paths[iter->second] << std::endl;
+    }
+    workers.erase(iter);
+  };
+  for (size_t i = 0; i < bag_paths.size(); ++i) {
+    while (workers.size() >= num_workers) {
+      waitWorker();
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+      std::cerr << "Failed to fork a worker for " << bag_paths[i] << std::endl;
+      continue;
+    }
+    if (pid == 0) {
+      int ret = 1;
+      try {
+        ret = processBag(bag_paths[i], param_paths, getSaveDir(i), getPartPath(i));
+      } catch (const std::exception & e) {
+        std::cerr << bag_paths[i] << ": " << e.what() << std::endl;
+      }
+      _exit(ret);
+    }
+    workers[pid] = i;
+  }
+  while (!workers.empty()) {
+    waitWorker();
+  }
+
+  // Merge the results of the workers in the order of the bags
+  const std::string summary_path = output_dir + "/summary.csv";
+  std::ofstream summary(summary_path);
+  if (!summary) {
+    std::cerr << "Failed to open " << summary_path << std::endl;
+    return 1;
+  }
+  summary << "bag,save_dir,num_initializations,max_lateral_error,max_long_radius_error"
+          << std::endl;
+  size_t num_succeeded = 0;
+  for (size_t i = 0; i < bag_paths.size(); ++i) {
+    if (is_succeeded[i]) {
+      std::ifstream part(getPartPath(i));
+      summary << part.rdbuf();
+      ++num_succeeded;
+    }
+    std::remove(getPartPath(i).c_str());
+  }
+
+  std::cout << "Processed " << num_succeeded << "/" << bag_paths.size() << " bags, wrote "
+            << summary_path << std::endl;
+  return num_succeeded == bag_paths.size() ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "deviation_evaluator/deviation_monitor.hpp"
+
+#include "deviation_evaluator/autoware_universe_utils.hpp"
+
+#include <tf2/utils.h>
+
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+double norm_xy(const geometry_msgs::msg::Point & p1, const geometry_msgs::msg::Point & p2)
+{
+  double dx = p1.x - p2.x;
+  double dy = p1.y - p2.y;
+  return std::sqrt(dx * dx + dy * dy);
+}
+
+double norm_xy_lateral(
+  const geometry_msgs::msg::Point & p1, const geometry_msgs::msg::Point & p2, const double yaw)
+{
+  double dx = p1.x - p2.x;
+  double dy = p1.y - p2.y;
+  return std::abs(dx * std::sin(yaw) - dy * std::cos(yaw));
+}
+}  // namespace
+
+geometry_msgs::msg::PoseWithCovarianceStamped createInitialPose(
+  const geometry_msgs::msg::PoseWithCovarianceStamped & ndt_pose)
+{
+  geometry_msgs::msg::PoseWithCovarianceStamped pose_with_cov = ndt_pose;
+  const double initial_position_stddev = 0.05;
+  const double initial_angle_stddev = 0.01;
+  pose_with_cov.pose.covariance[0 * 6 + 0] = initial_position_stddev * initial_position_stddev;
+  pose_with_cov.pose.covariance[1 * 6 + 1] = initial_position_stddev * initial_position_stddev;
+  pose_with_cov.pose.covariance[2 * 6 + 2] = initial_position_stddev * initial_position_stddev;
+  pose_with_cov.pose.covariance[3 * 6 + 3] = initial_angle_stddev * initial_angle_stddev;
+  pose_with_cov.pose.covariance[4 * 6 + 4] = initial_angle_stddev * initial_angle_stddev;
+  pose_with_cov.pose.covariance[5 * 6 + 5] = initial_angle_stddev * initial_angle_stddev;
+  return pose_with_cov;
+}
+
+DeviationMonitor::DeviationMonitor(const double wait_duration, const Errors & errors_threshold)
+: wait_duration_(wait_duration),
+  errors_threshold_(errors_threshold),
+  start_time_(0.0),
+  has_published_initial_pose_(false),
+  dr_pose_buffer_(dr_pose_buffer_capacity_),
+  has_last_gt_pose_(false),
+  last_gt_time_(0.0)
+{
+}
+
+DeviationMonitor::NDTPoseUse DeviationMonitor::useNDTPose(const double time)
+{
+  if (!has_published_initial_pose_) {
+    has_published_initial_pose_ = true;
+    start_time_ = time;
+    return NDTPoseUse::INITIAL_POSE;
+  }
+  return time - start_time_ < wait_duration_ ? NDTPoseUse::DR_AND_GT : NDTPoseUse::GT;
+}
+
+bool DeviationMonitor::resetIfErrorsAreLarge(const double time)
+{
+  if (
+    (current_errors_.lateral > errors_threshold_.lateral) &
+    (current_errors_.long_radius > errors_threshold_.long_radius)) {
+    start_time_ = time;
+    has_published_initial_pose_ = false;
+    current_errors_ = Errors();
+    return true;
+  }
+  return false;
+}
+
+bool DeviationMonitor::addDRPose(const double time, const geometry_msgs::msg::Pose & pose)
+{
+  bool is_continuous = true;
+  if (!dr_pose_buffer_.empty()) {
+    if (dr_pose_buffer_.back_time() > time) {
+      dr_pose_buffer_.clear();
+      is_continuous = false;
+    }
+  }
+  dr_pose_buffer_.push_back(time, pose);
+  return is_continuous;
+}
+
+void DeviationMonitor::addGTPose(const double time, const geometry_msgs::msg::Pose & pose)
+{
+  if (!has_last_gt_pose_) {
+    has_last_gt_pose_ = true;
+    last_gt_time_ = time;
+    last_gt_pose_ = pose;
+  }
+  if (dr_pose_buffer_.size() < 2) return;
+
+  double start_time = dr_pose_buffer_.front_time();
+  double target_time = last_gt_time_;
+  if (start_time > target_time) {
+    has_last_gt_pose_ = false;
+    return;
+  }
+
+  geometry_msgs::msg::Pose target_pose;
+  try {
+    target_pose = interpolatePose(target_time);
+  } catch (const std::runtime_error & exception) {
+    return;
+  }
+  current_errors_.long_radius = norm_xy(target_pose.position, last_gt_pose_.position);
+  current_errors_.lateral = norm_xy_lateral(
+    target_pose.position, last_gt_pose_.position, tf2::getYaw(target_pose.orientation));
+  has_last_gt_pose_ = false;
+
+  // The poses before the pair around the target time are no longer used
+  dr_pose_buffer_.pop_front(dr_pose_buffer_.upper_bound(target_time) - 1);
+}
+
+geometry_msgs::msg::Pose DeviationMonitor::interpolatePose(const double time) const
+{
+  const size_t idx_next = dr_pose_buffer_.upper_bound(time);
+
+  if ((idx_next == 0) | (idx_next == dr_pose_buffer_.size())) {
+    throw std::runtime_error("Interpolation failed");
+  }
+
+  const double time_start = dr_pose_buffer_.time(idx_next - 1);
+  const double time_end = dr_pose_buffer_.time(idx_next);
+  const double ratio = (time - time_start) / (time_end - time_start);
+  return calcInterpolatedPose(
+    dr_pose_buffer_.pose(idx_next - 1), dr_pose_buffer_.pose(idx_next), ratio);
+}
@@ -0,0 +1,64 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__MAP_DIFF_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__MAP_DIFF_HPP_
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Structural diff of two versions of a lanelet2 map, so that the incremental map tools can limit
+// their work to the changed primitives
+namespace autoware::lanelet2_map_utils
+{
+// Sorted IDs of the primitives of a layer that are only in the new map, only in the old map, and
+// in both maps with different contents
+struct LayerDiff
+{
+  std::vector<lanelet::Id> added;
+  std::vector<lanelet::Id> removed;
+  std::vector<lanelet::Id> modified;
+
+  bool empty() const { return added.empty() && removed.empty() && modified.empty(); }
+};
+
+// A point is modified if its coordinates or attributes are. A line string is modified if its
+// attributes, the IDs of its points or any of its points are, and a lanelet if its attributes, its
+// regulatory elements or any of its bounds are, so that a modified lanelet is all a tool working on
+// lanelets has to check
+struct MapDiff
+{
+  LayerDiff points;
+  LayerDiff line_strings;
+  LayerDiff lanelets;
+};
+
+// Hash the primitives of both maps by their contents with thread_num threads, and compare them
+MapDiff diff_lanelet_maps(
+  const lanelet::LaneletMap & old_map, const lanelet::LaneletMap & new_map, size_t thread_num);
+
+// Save the diff to a binary file: the magic "LLTDIFF" and a null character, a uint32 version, and
+// the added, removed and modified IDs of the points, the line strings and the lanelets in that
+// order. Each list is its size followed by the differences between consecutive IDs, as zigzag
+// LEB128 varints, so that a diff of nearby IDs takes a byte or two per ID
+bool save_map_diff(const std::string & path, const MapDiff & diff);
+
+// Load a diff saved by save_map_diff. Return false if the file is not a valid diff
+bool load_map_diff(const std::string & path, MapDiff & diff);
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__MAP_DIFF_HPP_
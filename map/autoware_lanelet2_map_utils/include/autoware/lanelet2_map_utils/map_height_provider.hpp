@@ -0,0 +1,97 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__MAP_HEIGHT_PROVIDER_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__MAP_HEIGHT_PROVIDER_HPP_
+
+#include <Eigen/Core>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// Heights of a PCD map around query points, shared by the tools that move the lanelets to the
+// ground. Only the tiles that the queries touch are read, so the cost follows the region of the
+// queries instead of the size of the map. The points of a tile are grouped by 2D cells as large as
+// the 2D search radius and sorted by height in each cell, and the tiles are kept in an LRU cache
+class MapHeightProvider
+{
+public:
+  MapHeightProvider(
+    double search_radius2d, double search_radius3d, size_t max_cached_tiles = 16,
+    size_t thread_num = 1);
+  ~MapHeightProvider();
+
+  // Find the tiles of a PCD file, a directory of PCD files, or the output directory of the
+  // pointcloud divider, whose tile index or metadata YAML gives the bounds of the tiles. Without
+  // bounds, every file is read for every batch of queries. Return false if there is no PCD file
+  bool open(const std::string & pcd_map_path);
+
+  // Find the lowest map point within the 2D radius and the 3D radius of each point, with
+  // thread_num threads. heights[i] is NaN if there is no such point. Return the number of points
+  // whose height is found
+  size_t min_heights(const std::vector<Eigen::Vector3d> & points, std::vector<double> & heights);
+
+  size_t tile_num() const { return tiles_.size(); }
+  // Number of tiles read so far, a tile evicted from the cache is counted again when reread
+  size_t loaded_tile_num() const { return loaded_tile_num_; }
+
+private:
+  class TileGrid;
+
+  struct Tile
+  {
+    std::string path;
+    std::array<float, 4> bounds;  // Min x, min y, max x and max y of the points
+    bool bounded;
+  };
+
+  // Tiles whose bounds extended by the 2D search radius contain the point
+  void find_tiles(double x, double y, std::vector<size_t> & tile_ids) const;
+  // Get the grids of the tiles, reading those that are not in the cache in parallel. needed_cells
+  // has the cells that the queries touch in each unbounded tile, whose grids keep only those
+  // cells and are returned in partial_grids instead of the cache
+  std::vector<const TileGrid *> acquire(
+    const std::vector<size_t> & tile_ids,
+    const std::unordered_map<size_t, std::vector<uint64_t>> & needed_cells,
+    std::vector<std::unique_ptr<TileGrid>> & partial_grids);
+  void add_tile(const std::string & path, const std::array<float, 4> & bounds, bool bounded);
+  bool load_tile_index(const std::string & dir);
+  bool load_metadata(const std::string & dir);
+
+  double search_radius2d_, search_radius3d_;
+  size_t max_cached_tiles_;
+  size_t thread_num_;
+  std::vector<Tile> tiles_;
+  // Bounded tiles by the 2D buckets they overlap, and the unbounded tiles
+  double bucket_size_ = 0.0;
+  std::unordered_map<uint64_t, std::vector<size_t>> buckets_;
+  std::vector<size_t> unbounded_tiles_;
+  // Cached grids from the most recently used, by tile
+  std::list<size_t> lru_;
+  std::unordered_map<size_t, std::pair<std::list<size_t>::iterator, std::unique_ptr<TileGrid>>>
+    cache_;
+  size_t loaded_tile_num_ = 0;
+};
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__MAP_HEIGHT_PROVIDER_HPP_
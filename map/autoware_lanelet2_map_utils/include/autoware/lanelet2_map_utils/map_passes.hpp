@@ -0,0 +1,77 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__LANELET2_MAP_UTILS__MAP_PASSES_HPP_
+#define AUTOWARE__LANELET2_MAP_UTILS__MAP_PASSES_HPP_
+
+#include <Eigen/Geometry>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_io/Io.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Passes of the lanelet2 map tools. Each pass modifies a loaded map in place, so that the tools and
+// the pipeline share them
+namespace autoware::lanelet2_map_utils
+{
+bool load_lanelet_map(
+  const std::string & llt_map_path, lanelet::LaneletMapPtr & lanelet_map_ptr,
+  lanelet::Projector & projector);
+
+// Run func(i) for i in [0, size) with thread_num threads
+void run_parallel(size_t size, size_t thread_num, const std::function<void(size_t)> & func);
+
+// Move the points of the lanelet bounds to the ground of the PCD map
+bool fix_z_value_by_pcd(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const std::string & pcd_map_path,
+  size_t thread_num);
+
+void merge_points(const lanelet::LaneletMapPtr & lanelet_map_ptr, double merge_distance = 0.1);
+
+void merge_lines(lanelet::LaneletMapPtr & lanelet_map_ptr, size_t thread_num);
+
+// Remove turn_direction from the lanelets without conflicts, and set lane_change=yes on their bounds
+// shared with adjacent lanelets. With use_adjacency_index, the relations are found by indices of
+// the shared bounds with thread_num threads instead of a routing graph
+void fix_tags(
+  lanelet::LaneletMapPtr & lanelet_map_ptr, size_t thread_num = 1,
+  bool use_adjacency_index = false);
+
+void remove_unreferenced_geometry(lanelet::LaneletMapPtr & lanelet_map_ptr);
+
+// Transform the points of the lanelet map
+void transform_lanelet_map(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const Eigen::Affine3d & affine);
+
+// Transform the points of a cloud in chunks with thread_num threads
+void transform_points(
+  pcl::PointCloud<pcl::PointXYZ> & cloud, const Eigen::Affine3d & affine, size_t thread_num);
+
+// Transform a PCD map block by block, so that the map does not have to fit into memory
+bool transform_pcd_map(
+  const std::string & pcd_map_path, const std::string & pcd_output_path,
+  const Eigen::Affine3d & affine, size_t thread_num);
+
+// Roll, pitch and yaw are in degrees
+Eigen::Affine3d create_affine_matrix_from_xyzrpy(
+  const double x, const double y, const double z, const double roll, const double pitch,
+  const double yaw);
+}  // namespace autoware::lanelet2_map_utils
+
+#endif  // AUTOWARE__LANELET2_MAP_UTILS__MAP_PASSES_HPP_
@@ -0,0 +1,68 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_diff.hpp"
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/projection/mgrs_projector.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <utility>
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("lanelet2_map_diff");
+
+  const auto old_map_path = node->declare_parameter<std::string>("old_map_path");
+  const auto new_map_path = node->declare_parameter<std::string>("new_map_path");
+  const auto output_path = node->declare_parameter<std::string>("output_path");
+  const size_t thread_num = std::max(node->declare_parameter<int>("thread_num", 1), 1);
+
+  lanelet::LaneletMapPtr old_map_ptr(new lanelet::LaneletMap);
+  lanelet::LaneletMapPtr new_map_ptr(new lanelet::LaneletMap);
+  lanelet::projection::MGRSProjector projector;
+
+  if (
+    !autoware::lanelet2_map_utils::load_lanelet_map(old_map_path, old_map_ptr, projector) ||
+    !autoware::lanelet2_map_utils::load_lanelet_map(new_map_path, new_map_ptr, projector)) {
+    return EXIT_FAILURE;
+  }
+
+  const auto diff =
+    autoware::lanelet2_map_utils::diff_lanelet_maps(*old_map_ptr, *new_map_ptr, thread_num);
+
+  const std::pair<const char *, const autoware::lanelet2_map_utils::LayerDiff *> layers[] = {
+    {"points", &diff.points}, {"line strings", &diff.line_strings}, {"lanelets", &diff.lanelets}};
+
+  for (const auto & [name, layer] : layers) {
+    std::cout << name << ": " << layer->added.size() << " added, " << layer->removed.size()
+              << " removed, " << layer->modified.size() << " modified" << std::endl;
+  }
+
+  if (!autoware::lanelet2_map_utils::save_map_diff(output_path, diff)) {
+    std::cerr << "Failed to write " << output_path << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  rclcpp::shutdown();
+
+  return 0;
+}
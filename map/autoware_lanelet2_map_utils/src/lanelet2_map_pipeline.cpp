@@ -0,0 +1,137 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Load a lanelet2 map once, apply a sequence of the passes of the map tools to it in memory, and
+// write it once. Each pass reports its time
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/io/autoware_osm_parser.hpp>
+#include <autoware_lanelet2_extension/projection/mgrs_projector.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_io/Io.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// Run func and print its time. The result of func is passed through
+bool measure(const std::string & name, const std::function<bool()> & func)
+{
+  auto start = std::chrono::steady_clock::now();
+  bool result = func();
+  auto end = std::chrono::steady_clock::now();
+
+  printf("%-32s %10.3f s\n", name.c_str(), std::chrono::duration<double>(end - start).count());
+
+  return result;
+}
+}  // namespace autoware::lanelet2_map_utils
+
+int main(int argc, char * argv[])
+{
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("lanelet2_map_pipeline");
+
+  const auto llt_map_path = node->declare_parameter<std::string>("llt_map_path");
+  const auto llt_output_path = node->declare_parameter<std::string>("llt_output_path");
+  const auto passes = node->declare_parameter<std::vector<std::string>>("passes");
+  const auto thread_num = std::max(node->declare_parameter<int>("thread_num", 1), 1);
+  // Parameters of fix_z_value_by_pcd
+  const auto pcd_map_path = node->declare_parameter<std::string>("pcd_map_path", "");
+  // Parameters of fix_lane_change_tags
+  const auto use_adjacency_index = node->declare_parameter<bool>("use_adjacency_index", false);
+  // Parameters of transform_maps, only the lanelet map is transformed
+  const auto x = node->declare_parameter<double>("x", 0.0);
+  const auto y = node->declare_parameter<double>("y", 0.0);
+  const auto z = node->declare_parameter<double>("z", 0.0);
+  const auto roll = node->declare_parameter<double>("roll", 0.0);
+  const auto pitch = node->declare_parameter<double>("pitch", 0.0);
+  const auto yaw = node->declare_parameter<double>("yaw", 0.0);
+
+  lanelet::LaneletMapPtr llt_map_ptr(new lanelet::LaneletMap);
+  lanelet::projection::MGRSProjector projector;
+
+  namespace utils = autoware::lanelet2_map_utils;
+
+  const std::map<std::string, std::function<bool()>> pass_funcs = {
+    {"fix_z_value_by_pcd",
+     [&]() { return utils::fix_z_value_by_pcd(llt_map_ptr, pcd_map_path, thread_num); }},
+    {"merge_close_points",
+     [&]() {
+       utils::merge_points(llt_map_ptr);
+       return true;
+     }},
+    {"merge_close_lines",
+     [&]() {
+       utils::merge_lines(llt_map_ptr, thread_num);
+       return true;
+     }},
+    {"fix_lane_change_tags",
+     [&]() {
+       utils::fix_tags(llt_map_ptr, thread_num, use_adjacency_index);
+       return true;
+     }},
+    {"remove_unreferenced_geometry",
+     [&]() {
+       utils::remove_unreferenced_geometry(llt_map_ptr);
+       return true;
+     }},
+    {"transform_maps", [&]() {
+       auto affine = utils::create_affine_matrix_from_xyzrpy(x, y, z, roll, pitch, yaw);
+
+       utils::transform_lanelet_map(llt_map_ptr, affine);
+       return true;
+     }}};
+
+  // Check all the passes before spending time on loading the map
+  for (const auto & pass : passes) {
+    if (pass_funcs.count(pass) == 0) {
+      RCLCPP_ERROR_STREAM(node->get_logger(), "Unknown pass: " << pass);
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto load = [&]() { return utils::load_lanelet_map(llt_map_path, llt_map_ptr, projector); };
+
+  if (!utils::measure("load", load)) {
+    return EXIT_FAILURE;
+  }
+
+  for (const auto & pass : passes) {
+    if (!utils::measure(pass, pass_funcs.at(pass))) {
+      RCLCPP_ERROR_STREAM(node->get_logger(), "Pass " << pass << " failed");
+      return EXIT_FAILURE;
+    }
+  }
+
+  utils::measure("write", [&]() {
+    lanelet::write(llt_output_path, *llt_map_ptr, projector);
+    return true;
+  });
+
+  rclcpp::shutdown();
+
+  return 0;
+}
@@ -0,0 +1,397 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the passes of the map tools on synthetic maps. For each map size, a grid city of roads
+// and intersections with about the given number of points is generated with a PCD map of the
+// ground around its roads, and the passes are applied to it in the order of the pipeline. Each
+// phase reports points/s of the lanelet map and its own peak RSS.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <Eigen/Core>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/utility/Utilities.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace autoware::lanelet2_map_utils
+{
+
+struct CityParameters
+{
+  size_t lane_num;            // Lanes of a road in each direction
+  double lane_width;          // m
+  double block_length;        // Distance between the centers of adjacent intersections (m)
+  double point_interval;      // Distance between the points of a line (m)
+  double duplicate_ratio;     // Ratio of the lane dividers that the lanelet on their left copies
+  double unreferenced_ratio;  // Ratio of the points that no lanelet refers to
+};
+
+// Height of the synthetic ground
+double ground_height(double x, double y)
+{
+  return 0.01 * x + std::sin(y / 100.0);
+}
+
+// Grid cities of grid_size x grid_size intersections. The roads between them have lane_num lanes
+// in each direction, and the intersections have straight lanelets across them, which conflict with
+// the crossing ones. The points are at the ground height 0, and the copies of the dividers are a
+// few centimeters away from the originals, so that all the passes have work to do
+class CityGenerator
+{
+public:
+  CityGenerator(const CityParameters & parameters, unsigned int seed)
+  : parameters_(parameters), rng_(seed)
+  {
+  }
+
+  lanelet::LaneletMapPtr generate(size_t grid_size)
+  {
+    auto lanelet_map_ptr = std::make_shared<lanelet::LaneletMap>();
+    const double half_width = parameters_.lane_num * parameters_.lane_width;
+    const Eigen::Vector2d dx(1.0, 0.0);
+    const Eigen::Vector2d dy(0.0, 1.0);
+
+    roads_.clear();
+
+    for (size_t i = 0; i < grid_size; ++i) {
+      for (size_t j = 0; j < grid_size; ++j) {
+        const Eigen::Vector2d center(i * parameters_.block_length, j * parameters_.block_length);
+
+        add_road(*lanelet_map_ptr, center - half_width * dx, center + half_width * dx, true);
+        add_road(*lanelet_map_ptr, center - half_width * dy, center + half_width * dy, true);
+
+        if (i + 1 < grid_size) {
+          const Eigen::Vector2d next = center + parameters_.block_length * dx;
+          add_road(*lanelet_map_ptr, center + half_width * dx, next - half_width * dx, false);
+        }
+        if (j + 1 < grid_size) {
+          const Eigen::Vector2d next = center + parameters_.block_length * dy;
+          add_road(*lanelet_map_ptr, center + half_width * dy, next - half_width * dy, false);
+        }
+      }
+    }
+
+    add_unreferenced_lines(*lanelet_map_ptr, grid_size);
+
+    return lanelet_map_ptr;
+  }
+
+  // Expected number of points of a city, to find the grid size of a number of points
+  double estimate_point_num(size_t grid_size) const
+  {
+    const double half_width = parameters_.lane_num * parameters_.lane_width;
+    const double line_num = 2.0 * parameters_.lane_num + 1.0;
+    const double divider_num = 2.0 * parameters_.lane_num - 2.0;
+    const double segment_points =
+      (line_num + parameters_.duplicate_ratio * divider_num) *
+      line_point_num(parameters_.block_length - 2.0 * half_width);
+    const double intersection_points = 2.0 * line_num * line_point_num(2.0 * half_width);
+    const double n = static_cast<double>(grid_size);
+
+    return (2.0 * n * (n - 1.0) * segment_points + n * n * intersection_points) *
+           (1.0 + parameters_.unreferenced_ratio);
+  }
+
+  // Cover the roads with points of the ground, density points/m2, so that the PCD map matches
+  // the lanelet map of the last generate()
+  pcl::PointCloud<pcl::PointXYZ> generate_ground(double density)
+  {
+    const double half_width = parameters_.lane_num * parameters_.lane_width + 1.0;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> noise(0.0, 0.05);
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+
+    for (const auto & [from, to] : roads_) {
+      const Eigen::Vector2d direction = (to - from).normalized();
+      const Eigen::Vector2d normal(-direction.y(), direction.x());
+      const double length = (to - from).norm();
+      const auto point_num = static_cast<size_t>(length * 2.0 * half_width * density);
+
+      for (size_t i = 0; i < point_num; ++i) {
+        const Eigen::Vector2d p =
+          from + unit(rng_) * length * direction + (2.0 * unit(rng_) - 1.0) * half_width * normal;
+        cloud.push_back(pcl::PointXYZ(
+          static_cast<float>(p.x()), static_cast<float>(p.y()),
+          static_cast<float>(ground_height(p.x(), p.y()) + noise(rng_))));
+      }
+    }
+
+    return cloud;
+  }
+
+private:
+  size_t line_point_num(double length) const
+  {
+    const auto interval_num = static_cast<size_t>(std::ceil(length / parameters_.point_interval));
+    return std::max<size_t>(2, interval_num + 1);
+  }
+
+  lanelet::LineString3d make_line(
+    const Eigen::Vector2d & from, const Eigen::Vector2d & to, const std::string & subtype)
+  {
+    const auto point_num = line_point_num((to - from).norm());
+    lanelet::Points3d points;
+
+    points.reserve(point_num);
+
+    for (size_t i = 0; i < point_num; ++i) {
+      const Eigen::Vector2d p = from + (to - from) * (static_cast<double>(i) / (point_num - 1));
+      points.emplace_back(lanelet::utils::getId(), p.x(), p.y(), 0.0);
+    }
+
+    return lanelet::LineString3d(
+      lanelet::utils::getId(), points,
+      lanelet::AttributeMap{{"type", "line_thin"}, {"subtype", subtype}});
+  }
+
+  // A copy of a line with new points a few centimeters away
+  lanelet::LineString3d copy_line(const lanelet::LineString3d & line)
+  {
+    std::uniform_real_distribution<double> jitter(-0.02, 0.02);
+    lanelet::Points3d points;
+
+    points.reserve(line.size());
+
+    for (const auto & pt : line) {
+      points.emplace_back(
+        lanelet::utils::getId(), pt.x() + jitter(rng_), pt.y() + jitter(rng_), pt.z());
+    }
+
+    return lanelet::LineString3d(lanelet::utils::getId(), points, line.attributes());
+  }
+
+  // Lanelets from "from" to "to" on the right of the center line and back on its left
+  void add_road(
+    lanelet::LaneletMap & lanelet_map, const Eigen::Vector2d & from, const Eigen::Vector2d & to,
+    bool is_intersection)
+  {
+    const Eigen::Vector2d direction = (to - from).normalized();
+    const Eigen::Vector2d normal(-direction.y(), direction.x());
+    const auto lane_num = static_cast<int>(parameters_.lane_num);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::vector<lanelet::LineString3d> lines;
+
+    roads_.emplace_back(from, to);
+
+    // The lines from the right to the left, the k-th one is at k + lane_num
+    for (int k = -lane_num; k <= lane_num; ++k) {
+      const Eigen::Vector2d offset = k * parameters_.lane_width * normal;
+      const bool is_divider = k != -lane_num && k != 0 && k != lane_num;
+      const std::string subtype = is_intersection ? "virtual" : is_divider ? "dashed" : "solid";
+
+      lines.push_back(make_line(from + offset, to + offset, subtype));
+    }
+
+    for (int k = -lane_num; k < lane_num; ++k) {
+      auto lower = lines[k + lane_num];
+      const auto & upper = lines[k + lane_num + 1];
+      lanelet::AttributeMap attributes{
+        {"subtype", "road"}, {"location", "urban"}, {"one_way", "yes"}};
+
+      if (is_intersection) {
+        attributes["turn_direction"] = "straight";
+      } else if (k != -lane_num && k != 0 && unit(rng_) < parameters_.duplicate_ratio) {
+        lower = copy_line(lower);
+      }
+
+      if (k < 0) {
+        lanelet_map.add(lanelet::Lanelet(lanelet::utils::getId(), upper, lower, attributes));
+      } else {
+        lanelet_map.add(
+          lanelet::Lanelet(lanelet::utils::getId(), lower.invert(), upper.invert(), attributes));
+      }
+    }
+  }
+
+  // Short lines scattered over the city, which remove_unreferenced_geometry removes
+  void add_unreferenced_lines(lanelet::LaneletMap & lanelet_map, size_t grid_size)
+  {
+    const size_t point_num_per_line = 10;
+    const auto line_num = static_cast<size_t>(
+      parameters_.unreferenced_ratio * lanelet_map.pointLayer.size() / point_num_per_line);
+    const double side = std::max<double>(grid_size - 1, 1) * parameters_.block_length;
+    std::uniform_real_distribution<double> position(0.0, side);
+
+    for (size_t i = 0; i < line_num; ++i) {
+      const Eigen::Vector2d from(position(rng_), position(rng_));
+      const Eigen::Vector2d to =
+        from + Eigen::Vector2d(parameters_.point_interval * (point_num_per_line - 1), 0.0);
+      lanelet_map.add(make_line(from, to, "solid"));
+    }
+  }
+
+  CityParameters parameters_;
+  std::mt19937 rng_;
+  std::vector<std::pair<Eigen::Vector2d, Eigen::Vector2d>> roads_;
+};
+
+// Reset the peak RSS of the process, so that each phase reports its own peak
+void reset_peak_rss()
+{
+  std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+// A memory size of /proc/self/status in MB, VmHWM is the peak RSS since the last reset
+double status_mb(const std::string & key)
+{
+  std::ifstream status("/proc/self/status");
+
+  for (std::string line; std::getline(status, line);) {
+    if (line.rfind(key + ":", 0) == 0) {
+      return std::stod(line.substr(key.size() + 1)) / 1024.0;
+    }
+  }
+
+  return 0.0;
+}
+
+// Run a phase and print its throughput, its peak RSS and the increase of RSS from the start
+void measure(const std::string & name, size_t point_num, const std::function<void()> & func)
+{
+  reset_peak_rss();
+
+  double start_rss = status_mb("VmRSS");
+  auto start = std::chrono::steady_clock::now();
+  func();
+  auto end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - start).count();
+  double peak_rss = status_mb("VmHWM");
+
+  printf(
+    "%-32s %10.3f s %14.0f points/s %10.1f MB peak RSS %+10.1f MB\n", name.c_str(), sec,
+    point_num / sec, peak_rss, peak_rss - start_rss);
+}
+
+}  // namespace autoware::lanelet2_map_utils
+
+int main(int argc, char * argv[])
+{
+  namespace utils = autoware::lanelet2_map_utils;
+
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("lanelet2_map_utils_benchmark");
+
+  const auto point_nums =
+    node->declare_parameter<std::vector<int64_t>>("point_nums", {10000, 100000, 1000000});
+  utils::CityParameters parameters;
+  parameters.lane_num = std::max(node->declare_parameter<int>("lane_num", 2), 1);
+  parameters.lane_width = node->declare_parameter<double>("lane_width", 3.5);
+  parameters.block_length = node->declare_parameter<double>("block_length", 100.0);
+  parameters.point_interval = node->declare_parameter<double>("point_interval", 1.0);
+  parameters.duplicate_ratio = node->declare_parameter<double>("duplicate_ratio", 0.5);
+  parameters.unreferenced_ratio = node->declare_parameter<double>("unreferenced_ratio", 0.05);
+  const auto pcd_density = node->declare_parameter<double>("pcd_density", 2.0);
+  const auto thread_num = std::max(node->declare_parameter<int>("thread_num", 1), 1);
+  const auto work_dir =
+    node->declare_parameter<std::string>("work_dir", "/tmp/lanelet2_map_utils_benchmark");
+  const auto seed = node->declare_parameter<int>("seed", 0);
+
+  std::cout << "benchmarking with following parameters" << std::endl
+            << "lane_num " << parameters.lane_num << std::endl
+            << "block_length " << parameters.block_length << std::endl
+            << "point_interval " << parameters.point_interval << std::endl
+            << "duplicate_ratio " << parameters.duplicate_ratio << std::endl
+            << "unreferenced_ratio " << parameters.unreferenced_ratio << std::endl
+            << "pcd_density " << pcd_density << std::endl
+            << "thread_num " << thread_num << std::endl
+            << "work_dir " << work_dir << std::endl;
+
+  // The points of the copies closer than this are merged by merge_points
+  if (
+    parameters.point_interval <= 0.1 ||
+    parameters.block_length <= 2.0 * parameters.lane_num * parameters.lane_width) {
+    std::cerr << "point_interval must be larger than 0.1 and block_length larger than the roads"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  utils::CityGenerator generator(parameters, seed);
+  const std::string pcd_map_path = work_dir + "/pointcloud_map.pcd";
+
+  for (const auto target_point_num : point_nums) {
+    size_t grid_size = 2;
+
+    while (generator.estimate_point_num(grid_size) < static_cast<double>(target_point_num)) {
+      ++grid_size;
+    }
+
+    fs::remove_all(work_dir);
+    fs::create_directories(work_dir);
+
+    lanelet::LaneletMapPtr lanelet_map_ptr;
+    size_t point_num = target_point_num;
+
+    utils::measure("generate lanelet map", point_num, [&]() {
+      lanelet_map_ptr = generator.generate(grid_size);
+    });
+
+    point_num = lanelet_map_ptr->pointLayer.size();
+
+    utils::measure("generate PCD map", point_num, [&]() {
+      auto cloud = generator.generate_ground(pcd_density);
+      pcl::io::savePCDFileBinary(pcd_map_path, cloud);
+    });
+
+    std::cout << "map of " << grid_size * grid_size << " intersections, " << point_num
+              << " points, " << lanelet_map_ptr->lineStringLayer.size() << " line strings, "
+              << lanelet_map_ptr->laneletLayer.size() << " lanelets" << std::endl;
+
+    utils::measure("fix_z_value_by_pcd", point_num, [&]() {
+      utils::fix_z_value_by_pcd(lanelet_map_ptr, pcd_map_path, thread_num);
+    });
+    utils::measure("merge_points", point_num, [&]() { utils::merge_points(lanelet_map_ptr); });
+    utils::measure(
+      "merge_lines", point_num, [&]() { utils::merge_lines(lanelet_map_ptr, thread_num); });
+    utils::measure("fix_tags (routing graph)", point_num, [&]() {
+      utils::fix_tags(lanelet_map_ptr, thread_num, false);
+    });
+    utils::measure("fix_tags (adjacency index)", point_num, [&]() {
+      utils::fix_tags(lanelet_map_ptr, thread_num, true);
+    });
+    utils::measure("remove_unreferenced_geometry", point_num, [&]() {
+      utils::remove_unreferenced_geometry(lanelet_map_ptr);
+    });
+    utils::measure("transform_lanelet_map", point_num, [&]() {
+      utils::transform_lanelet_map(
+        lanelet_map_ptr, utils::create_affine_matrix_from_xyzrpy(1.0, 2.0, 3.0, 0.0, 0.0, 90.0));
+    });
+  }
+
+  fs::remove_all(work_dir);
+
+  rclcpp::shutdown();
+
+  return 0;
+}
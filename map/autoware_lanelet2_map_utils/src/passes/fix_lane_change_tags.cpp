@@ -0,0 +1,236 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/primitives/LaneletSequence.h>
+#include <lanelet2_io/Io.h>
+#include <lanelet2_routing/RoutingGraph.h>
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+lanelet::Lanelets convert_to_vector(const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::Lanelets lanelets;
+  std::copy(
+    lanelet_map_ptr->laneletLayer.begin(), lanelet_map_ptr->laneletLayer.end(),
+    std::back_inserter(lanelets));
+  return lanelets;
+}
+
+// Relations of the lanelets that fix_tags needs, like those of the routing graph, found by
+// indices of the shared bounds and end points instead of a graph of the whole map
+class LaneletAdjacency
+{
+public:
+  LaneletAdjacency(
+    const lanelet::LaneletMap & lanelet_map, const lanelet::ConstLanelets & lanelets,
+    const lanelet::traffic_rules::TrafficRules & traffic_rules)
+  : lanelet_map_(lanelet_map), lanelets_(lanelets), traffic_rules_(traffic_rules)
+  {
+    passable_.resize(lanelets_.size());
+
+    for (size_t i = 0; i < lanelets_.size(); ++i) {
+      const auto & llt = lanelets_[i];
+
+      passable_[i] = traffic_rules_.canPass(llt);
+      index_[llt.id()] = i;
+
+      if (!passable_[i]) {
+        continue;
+      }
+
+      bounds_[llt.leftBound().id()].push_back(i);
+      bounds_[llt.rightBound().id()].push_back(i);
+      starts_[end_key(llt.leftBound().front(), llt.rightBound().front())].push_back(i);
+      ends_[end_key(llt.leftBound().back(), llt.rightBound().back())].push_back(i);
+    }
+  }
+
+  // True if a passable lanelet overlaps the lanelet, or merges into or diverges from it, and is
+  // not a neighbor or a successor of it
+  bool conflicting(size_t i) const
+  {
+    if (!passable_[i]) {
+      return false;
+    }
+
+    const auto & llt = lanelets_[i];
+    auto is_conflicting = [&](const lanelet::ConstLanelet & other) {
+      auto other_it = index_.find(other.id());
+
+      return other_it != index_.end() && other_it->second != i && passable_[other_it->second] &&
+             !related(llt, other);
+    };
+
+    for (const auto * ends : {&starts_, &ends_}) {
+      auto key = (ends == &starts_) ? end_key(llt.leftBound().front(), llt.rightBound().front())
+                                    : end_key(llt.leftBound().back(), llt.rightBound().back());
+
+      for (auto j : ends->at(key)) {
+        if (is_conflicting(lanelets_[j])) {
+          return true;
+        }
+      }
+    }
+
+    auto candidates = lanelet_map_.laneletLayer.search(lanelet::geometry::boundingBox2d(llt));
+
+    for (const auto & other : candidates) {
+      if (is_conflicting(other) && lanelet::geometry::overlaps2d(llt, other)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // True if a passable lanelet shares the right (left) bound of the lanelet in the same direction,
+  // and the lane cannot be changed to it. These are the adjacent lanelets of the routing graph
+  bool adjacent(size_t i, bool right) const
+  {
+    if (!passable_[i]) {
+      return false;
+    }
+
+    const auto & llt = lanelets_[i];
+    auto bound = right ? llt.rightBound() : llt.leftBound();
+
+    for (auto j : bounds_.at(bound.id())) {
+      const auto & other = lanelets_[j];
+
+      if (j != i && (right ? other.leftBound() : other.rightBound()) == bound) {
+        return !traffic_rules_.canChangeLane(llt, other);
+      }
+    }
+
+    return false;
+  }
+
+private:
+  static std::pair<lanelet::Id, lanelet::Id> end_key(
+    const lanelet::ConstPoint3d & left, const lanelet::ConstPoint3d & right)
+  {
+    return {std::min(left.id(), right.id()), std::max(left.id(), right.id())};
+  }
+
+  struct PairHash
+  {
+    size_t operator()(const std::pair<lanelet::Id, lanelet::Id> & key) const
+    {
+      return std::hash<lanelet::Id>()(key.first) * 31 + std::hash<lanelet::Id>()(key.second);
+    }
+  };
+
+  // Neighbors and successors
+  static bool related(const lanelet::ConstLanelet & llt, const lanelet::ConstLanelet & other)
+  {
+    return llt.leftBound() == other.rightBound() || llt.rightBound() == other.leftBound() ||
+           lanelet::geometry::follows(llt, other) || lanelet::geometry::follows(other, llt);
+  }
+
+  const lanelet::LaneletMap & lanelet_map_;
+  const lanelet::ConstLanelets & lanelets_;
+  const lanelet::traffic_rules::TrafficRules & traffic_rules_;
+  std::vector<bool> passable_;
+  std::unordered_map<lanelet::Id, size_t> index_;
+  // Passable lanelets by the ids of their bounds, and by the points of their ends
+  std::unordered_map<lanelet::Id, std::vector<size_t>> bounds_;
+  std::unordered_map<std::pair<lanelet::Id, lanelet::Id>, std::vector<size_t>, PairHash> starts_,
+    ends_;
+};
+
+void fix_tags_by_adjacency(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, lanelet::Lanelets & lanelets,
+  const lanelet::traffic_rules::TrafficRules & traffic_rules, size_t thread_num)
+{
+  // Lanelets in the order of their ids, so that the result does not depend on the hash tables
+  std::sort(lanelets.begin(), lanelets.end(), [](const auto & a, const auto & b) {
+    return a.id() < b.id();
+  });
+
+  lanelet::ConstLanelets const_lanelets(lanelets.begin(), lanelets.end());
+  LaneletAdjacency adjacency(*lanelet_map_ptr, const_lanelets, traffic_rules);
+
+  // Fixes of each lanelet: not conflicting, adjacent on the right, adjacent on the left. They are
+  // found in parallel on the unmodified map, and applied in order
+  std::vector<std::array<bool, 3>> fixes(lanelets.size());
+
+  run_parallel(lanelets.size(), thread_num, [&](size_t i) {
+    bool is_fixed = !adjacency.conflicting(i);
+
+    fixes[i] = {is_fixed, is_fixed && adjacency.adjacent(i, true),
+                is_fixed && adjacency.adjacent(i, false)};
+  });
+
+  for (size_t i = 0; i < lanelets.size(); ++i) {
+    auto & llt = lanelets[i];
+
+    if (!fixes[i][0]) {
+      continue;
+    }
+    llt.attributes().erase("turn_direction");
+    if (fixes[i][1]) {
+      llt.rightBound().attributes()["lane_change"] = "yes";
+    }
+    if (fixes[i][2]) {
+      llt.leftBound().attributes()["lane_change"] = "yes";
+    }
+  }
+}
+
+void fix_tags(
+  lanelet::LaneletMapPtr & lanelet_map_ptr, size_t thread_num, bool use_adjacency_index)
+{
+  auto lanelets = convert_to_vector(lanelet_map_ptr);
+  lanelet::traffic_rules::TrafficRulesPtr traffic_rules =
+    lanelet::traffic_rules::TrafficRulesFactory::create(
+      lanelet::Locations::Germany, lanelet::Participants::Vehicle);
+
+  if (use_adjacency_index) {
+    fix_tags_by_adjacency(lanelet_map_ptr, lanelets, *traffic_rules, thread_num);
+    return;
+  }
+
+  lanelet::routing::RoutingGraphUPtr routing_graph =
+    lanelet::routing::RoutingGraph::build(*lanelet_map_ptr, *traffic_rules);
+
+  for (auto & llt : lanelets) {
+    if (!routing_graph->conflicting(llt).empty()) {
+      continue;
+    }
+    llt.attributes().erase("turn_direction");
+    if (!!routing_graph->adjacentRight(llt)) {
+      llt.rightBound().attributes()["lane_change"] = "yes";
+    }
+    if (!!routing_graph->adjacentLeft(llt)) {
+      llt.leftBound().attributes()["lane_change"] = "yes";
+    }
+  }
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,87 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_height_provider.hpp"
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_io/Io.h>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+// Points of the bounds of the lanelets, each of them once
+std::vector<lanelet::Point3d> collect_bound_points(const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  std::unordered_set<lanelet::Id> done;
+  std::vector<lanelet::Point3d> points;
+
+  for (lanelet::Lanelet & llt : lanelet_map_ptr->laneletLayer) {
+    lanelet::LineStrings3d bounds{llt.leftBound(), llt.rightBound()};
+
+    for (auto & bound : bounds) {
+      for (lanelet::Point3d & pt : bound) {
+        if (done.insert(pt.id()).second) {
+          points.push_back(pt);
+        }
+      }
+    }
+  }
+
+  return points;
+}
+
+bool fix_z_value_by_pcd(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const std::string & pcd_map_path,
+  size_t thread_num)
+{
+  const double search_radius2d = 0.5;
+  const double search_radius3d = 10;
+  auto points = collect_bound_points(lanelet_map_ptr);
+  MapHeightProvider provider(search_radius2d, search_radius3d, 16, thread_num);
+
+  if (!provider.open(pcd_map_path)) {
+    return false;
+  }
+
+  std::vector<Eigen::Vector3d> search_points;
+  std::vector<double> heights;
+
+  search_points.reserve(points.size());
+
+  for (const auto & pt : points) {
+    search_points.emplace_back(pt.x(), pt.y(), pt.z());
+  }
+
+  size_t found_num = provider.min_heights(search_points, heights);
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (!std::isnan(heights[i])) {
+      points[i].z() = heights[i];
+    }
+  }
+
+  std::cout << "Read " << provider.loaded_tile_num() << " of " << provider.tile_num()
+            << " PCD files, only those near the lanelets" << std::endl;
+  std::cout << "Adjusted " << found_num << " of " << points.size()
+            << " points, no map points were found around the others" << std::endl;
+
+  return true;
+}
+}  // namespace autoware::lanelet2_map_utils
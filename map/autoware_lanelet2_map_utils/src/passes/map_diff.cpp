@@ -0,0 +1,372 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_diff.hpp"
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/primitives/RegulatoryElement.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+namespace
+{
+constexpr char diff_magic[8] = {'L', 'L', 'T', 'D', 'I', 'F', 'F', '\0'};
+constexpr uint32_t diff_version = 1;
+
+// Primitives hashed by a task of run_parallel
+constexpr size_t chunk_size = 1024;
+
+// IDs of the primitives of a layer and the hashes of their contents, sorted by the IDs
+using LayerHashes = std::vector<std::pair<lanelet::Id, uint64_t>>;
+
+// 64 bit hash of a sequence of values, each mixed in by the finalizer of splitmix64
+class ContentHasher
+{
+public:
+  void add(uint64_t v)
+  {
+    uint64_t z = hash_ + 0x9e3779b97f4a7c15ULL + v;
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    hash_ = z ^ (z >> 31);
+  }
+
+  void add(double v)
+  {
+    uint64_t bits;
+
+    // -0.0 and 0.0 are the same coordinate
+    v = (v == 0.0) ? 0.0 : v;
+    std::memcpy(&bits, &v, sizeof(bits));
+    add(bits);
+  }
+
+  // FNV-1a of the characters, with the length so that the end of a string is not ambiguous
+  void add(const std::string & s)
+  {
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (unsigned char c : s) {
+      h = (h ^ c) * 0x100000001b3ULL;
+    }
+
+    add(static_cast<uint64_t>(s.size()));
+    add(h);
+  }
+
+  void add(const lanelet::AttributeMap & attributes)
+  {
+    // The attributes are iterated in the order of their keys
+    add(static_cast<uint64_t>(attributes.size()));
+
+    for (const auto & attr : attributes) {
+      add(attr.first);
+      add(attr.second.value());
+    }
+  }
+
+  uint64_t hash() const { return hash_; }
+
+private:
+  uint64_t hash_ = 0;
+};
+
+uint64_t hash_point(const lanelet::ConstPoint3d & pt)
+{
+  ContentHasher hasher;
+
+  hasher.add(pt.x());
+  hasher.add(pt.y());
+  hasher.add(pt.z());
+  hasher.add(pt.attributes());
+
+  return hasher.hash();
+}
+
+const uint64_t * find_hash(const LayerHashes & hashes, lanelet::Id id)
+{
+  auto it = std::lower_bound(
+    hashes.begin(), hashes.end(), id,
+    [](const std::pair<lanelet::Id, uint64_t> & h, lanelet::Id i) { return h.first < i; });
+
+  return (it != hashes.end() && it->first == id) ? &it->second : nullptr;
+}
+
+// Hash the primitives of a layer with hash_primitive in chunks, and sort the hashes by the IDs
+template <class Layer, class HashFunc>
+LayerHashes hash_layer(const Layer & layer, size_t thread_num, const HashFunc & hash_primitive)
+{
+  std::vector<typename Layer::ConstPrimitiveT> primitives(layer.begin(), layer.end());
+  LayerHashes hashes(primitives.size());
+
+  run_parallel((primitives.size() + chunk_size - 1) / chunk_size, thread_num, [&](size_t c) {
+    size_t end = std::min(primitives.size(), (c + 1) * chunk_size);
+
+    for (size_t i = c * chunk_size; i < end; ++i) {
+      hashes[i] = {primitives[i].id(), hash_primitive(primitives[i])};
+    }
+  });
+
+  std::sort(hashes.begin(), hashes.end());
+
+  return hashes;
+}
+
+// Hashes of the points, the line strings and the lanelets of a map. A line string is hashed with
+// its points and a lanelet with its bounds, so that a change of a point changes them too
+struct MapHashes
+{
+  LayerHashes points;
+  LayerHashes line_strings;
+  LayerHashes lanelets;
+
+  MapHashes(const lanelet::LaneletMap & map, size_t thread_num)
+  {
+    points = hash_layer(map.pointLayer, thread_num, hash_point);
+
+    line_strings = hash_layer(
+      map.lineStringLayer, thread_num,
+      [this](const lanelet::ConstLineString3d & line) { return hash_line_string(line); });
+
+    lanelets = hash_layer(map.laneletLayer, thread_num, [this](const lanelet::ConstLanelet & llt) {
+      ContentHasher hasher;
+
+      hasher.add(llt.attributes());
+      add_bound(hasher, llt.leftBound());
+      add_bound(hasher, llt.rightBound());
+
+      // The regulatory elements are compared by their IDs only
+      std::vector<lanelet::Id> regulatory_element_ids;
+
+      for (const auto & re : llt.regulatoryElements()) {
+        regulatory_element_ids.push_back(re->id());
+      }
+
+      std::sort(regulatory_element_ids.begin(), regulatory_element_ids.end());
+      hasher.add(static_cast<uint64_t>(regulatory_element_ids.size()));
+
+      for (lanelet::Id id : regulatory_element_ids) {
+        hasher.add(static_cast<uint64_t>(id));
+      }
+
+      return hasher.hash();
+    });
+  }
+
+  uint64_t hash_line_string(const lanelet::ConstLineString3d & line) const
+  {
+    ContentHasher hasher;
+
+    hasher.add(line.attributes());
+    hasher.add(static_cast<uint64_t>(line.size()));
+
+    for (const auto & pt : line) {
+      const uint64_t * pt_hash = find_hash(points, pt.id());
+
+      hasher.add(static_cast<uint64_t>(pt.id()));
+      hasher.add(pt_hash ? *pt_hash : hash_point(pt));
+    }
+
+    return hasher.hash();
+  }
+
+  // The hash of a bound is that of the line string in the layer, which is not inverted
+  void add_bound(ContentHasher & hasher, const lanelet::ConstLineString3d & bound) const
+  {
+    const uint64_t * line_hash = find_hash(line_strings, bound.id());
+    const auto line = bound.inverted() ? bound.invert() : bound;
+
+    hasher.add(static_cast<uint64_t>(bound.id()));
+    hasher.add(static_cast<uint64_t>(bound.inverted()));
+    hasher.add(line_hash ? *line_hash : hash_line_string(line));
+  }
+};
+
+LayerDiff diff_layers(const LayerHashes & old_hashes, const LayerHashes & new_hashes)
+{
+  LayerDiff diff;
+  auto old_it = old_hashes.begin();
+  auto new_it = new_hashes.begin();
+
+  while (old_it != old_hashes.end() || new_it != new_hashes.end()) {
+    bool old_left = old_it != old_hashes.end();
+    bool new_left = new_it != new_hashes.end();
+
+    if (!new_left || (old_left && old_it->first < new_it->first)) {
+      diff.removed.push_back((old_it++)->first);
+    } else if (!old_left || new_it->first < old_it->first) {
+      diff.added.push_back((new_it++)->first);
+    } else {
+      if (old_it->second != new_it->second) {
+        diff.modified.push_back(new_it->first);
+      }
+
+      ++old_it;
+      ++new_it;
+    }
+  }
+
+  return diff;
+}
+
+void write_varint(std::string & buffer, uint64_t v)
+{
+  while (v >= 0x80) {
+    buffer.push_back(static_cast<char>((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+
+  buffer.push_back(static_cast<char>(v));
+}
+
+bool read_varint(const char *& begin, const char * end, uint64_t & v)
+{
+  v = 0;
+
+  for (int shift = 0; shift < 64 && begin != end; shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(*begin++);
+
+    v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// The differences are computed modulo 2^64, so that any pair of IDs has one
+void write_ids(std::string & buffer, const std::vector<lanelet::Id> & ids)
+{
+  uint64_t prev = 0;
+
+  write_varint(buffer, ids.size());
+
+  for (lanelet::Id id : ids) {
+    auto delta = static_cast<int64_t>(static_cast<uint64_t>(id) - prev);
+
+    write_varint(buffer, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+    prev = static_cast<uint64_t>(id);
+  }
+}
+
+bool read_ids(const char *& begin, const char * end, std::vector<lanelet::Id> & ids)
+{
+  uint64_t size, prev = 0;
+
+  // Each ID takes a byte at least
+  if (!read_varint(begin, end, size) || size > static_cast<uint64_t>(end - begin)) {
+    return false;
+  }
+
+  ids.resize(size);
+
+  for (auto & id : ids) {
+    uint64_t zigzag;
+
+    if (!read_varint(begin, end, zigzag)) {
+      return false;
+    }
+
+    prev += (zigzag >> 1) ^ (0 - (zigzag & 1));
+    id = static_cast<lanelet::Id>(prev);
+  }
+
+  return true;
+}
+}  // namespace
+
+MapDiff diff_lanelet_maps(
+  const lanelet::LaneletMap & old_map, const lanelet::LaneletMap & new_map, size_t thread_num)
+{
+  MapHashes old_hashes(old_map, thread_num);
+  MapHashes new_hashes(new_map, thread_num);
+  MapDiff diff;
+
+  diff.points = diff_layers(old_hashes.points, new_hashes.points);
+  diff.line_strings = diff_layers(old_hashes.line_strings, new_hashes.line_strings);
+  diff.lanelets = diff_layers(old_hashes.lanelets, new_hashes.lanelets);
+
+  return diff;
+}
+
+bool save_map_diff(const std::string & path, const MapDiff & diff)
+{
+  std::string buffer(diff_magic, sizeof(diff_magic));
+
+  buffer.append(reinterpret_cast<const char *>(&diff_version), sizeof(diff_version));
+
+  for (const auto * layer : {&diff.points, &diff.line_strings, &diff.lanelets}) {
+    write_ids(buffer, layer->added);
+    write_ids(buffer, layer->removed);
+    write_ids(buffer, layer->modified);
+  }
+
+  std::ofstream ofs(path, std::ios::binary);
+
+  ofs.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+  return static_cast<bool>(ofs);
+}
+
+bool load_map_diff(const std::string & path, MapDiff & diff)
+{
+  std::ifstream ifs(path, std::ios::binary);
+
+  if (!ifs) {
+    return false;
+  }
+
+  std::string buffer((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  uint32_t version;
+
+  if (
+    buffer.size() < sizeof(diff_magic) + sizeof(version) ||
+    std::memcmp(buffer.data(), diff_magic, sizeof(diff_magic)) != 0) {
+    return false;
+  }
+
+  std::memcpy(&version, buffer.data() + sizeof(diff_magic), sizeof(version));
+
+  if (version != diff_version) {
+    return false;
+  }
+
+  const char * begin = buffer.data() + sizeof(diff_magic) + sizeof(version);
+  const char * end = buffer.data() + buffer.size();
+
+  for (auto * layer : {&diff.points, &diff.line_strings, &diff.lanelets}) {
+    if (
+      !read_ids(begin, end, layer->added) || !read_ids(begin, end, layer->removed) ||
+      !read_ids(begin, end, layer->modified)) {
+      return false;
+    }
+  }
+
+  return begin == end;
+}
+}  // namespace autoware::lanelet2_map_utils
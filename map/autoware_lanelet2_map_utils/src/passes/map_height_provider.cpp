@@ -0,0 +1,495 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_height_provider.hpp"
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware/pointcloud_divider/pcd_io_reader.hpp>
+#include <autoware/pointcloud_divider/tile_index.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+namespace
+{
+int cell_index(double v, double cell_size)
+{
+  return static_cast<int>(std::floor(v / cell_size));
+}
+
+uint64_t cell_key(int ix, int iy)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(ix)) << 32) | static_cast<uint32_t>(iy);
+}
+}  // namespace
+
+// Points of a tile sorted by 2D cell and by height in each cell
+class MapHeightProvider::TileGrid
+{
+public:
+  // If needed_cells is not null, keep only the points in those sorted cells
+  TileGrid(
+    const std::string & path, double cell_size, const std::vector<uint64_t> * needed_cells)
+  : cell_size_(cell_size)
+  {
+    autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZ> reader;
+    std::vector<std::pair<uint64_t, pcl::PointXYZ>> keyed_points;
+
+    reader.setInput(path);
+
+    do {
+      pcl::PointCloud<pcl::PointXYZ> block;
+
+      reader.readABlock(block);
+
+      for (const auto & p : block) {
+        uint64_t key = cell_key(cell_index(p.x, cell_size_), cell_index(p.y, cell_size_));
+
+        if (
+          needed_cells &&
+          !std::binary_search(needed_cells->begin(), needed_cells->end(), key)) {
+          continue;
+        }
+
+        keyed_points.emplace_back(key, p);
+      }
+    } while (reader.good());
+
+    std::sort(keyed_points.begin(), keyed_points.end(), [](const auto & a, const auto & b) {
+      return a.first < b.first || (a.first == b.first && a.second.z < b.second.z);
+    });
+
+    points_.reserve(keyed_points.size());
+
+    for (const auto & keyed_point : keyed_points) {
+      if (keys_.empty() || keys_.back() != keyed_point.first) {
+        keys_.push_back(keyed_point.first);
+        offsets_.push_back(points_.size());
+      }
+
+      points_.push_back(keyed_point.second);
+    }
+
+    offsets_.push_back(points_.size());
+  }
+
+  // Lower height to the lowest point of the tile within the radii of the search point, if any
+  void min_height(
+    const Eigen::Vector3d & search_pt, double search_radius2d, double search_radius3d,
+    double & height) const
+  {
+    for (int ix = cell_index(search_pt.x() - search_radius2d, cell_size_);
+         ix <= cell_index(search_pt.x() + search_radius2d, cell_size_); ++ix) {
+      for (int iy = cell_index(search_pt.y() - search_radius2d, cell_size_);
+           iy <= cell_index(search_pt.y() + search_radius2d, cell_size_); ++iy) {
+        auto key_it = std::lower_bound(keys_.begin(), keys_.end(), cell_key(ix, iy));
+
+        if (key_it == keys_.end() || *key_it != cell_key(ix, iy)) {
+          continue;
+        }
+
+        // Points lower than the 3D radius cannot be within it
+        size_t cell_id = key_it - keys_.begin();
+        auto end = points_.begin() + offsets_[cell_id + 1];
+        auto lower = std::lower_bound(
+          points_.begin() + offsets_[cell_id], end, search_pt.z() - search_radius3d,
+          [](const pcl::PointXYZ & p, double z) { return p.z < z; });
+
+        for (auto pt = lower; pt != end; ++pt) {
+          // The rest of the cell is higher than the lowest point found so far
+          if (pt->z > search_pt.z() + search_radius3d || !(pt->z < height)) {
+            break;
+          }
+
+          double distance2d = std::hypot(pt->x - search_pt.x(), pt->y - search_pt.y());
+          double distance3d = std::hypot(distance2d, pt->z - search_pt.z());
+
+          if (distance2d < search_radius2d && distance3d <= search_radius3d) {
+            height = pt->z;
+
+            break;
+          }
+        }
+      }
+    }
+  }
+
+private:
+  double cell_size_;
+  std::vector<uint64_t> keys_;  // Sorted keys of the cells
+  std::vector<size_t> offsets_;
+  std::vector<pcl::PointXYZ> points_;
+};
+
+MapHeightProvider::MapHeightProvider(
+  double search_radius2d, double search_radius3d, size_t max_cached_tiles, size_t thread_num)
+: search_radius2d_(search_radius2d),
+  search_radius3d_(search_radius3d),
+  max_cached_tiles_(std::max<size_t>(max_cached_tiles, 1)),
+  thread_num_(std::max<size_t>(thread_num, 1))
+{
+}
+
+MapHeightProvider::~MapHeightProvider() = default;
+
+bool MapHeightProvider::open(const std::string & pcd_map_path)
+{
+  namespace fs = std::filesystem;
+
+  tiles_.clear();
+  bucket_size_ = 0.0;
+  buckets_.clear();
+  unbounded_tiles_.clear();
+  lru_.clear();
+  cache_.clear();
+
+  const std::array<float, 4> no_bounds{0.0f, 0.0f, 0.0f, 0.0f};
+
+  if (!fs::is_directory(pcd_map_path)) {
+    add_tile(pcd_map_path, no_bounds, false);
+  } else if (load_tile_index(pcd_map_path)) {
+    std::cout << "Found " << tiles_.size() << " tiles in the tile index" << std::endl;
+  } else if (load_metadata(pcd_map_path)) {
+    std::cout << "Found " << tiles_.size() << " tiles in the metadata" << std::endl;
+  } else {
+    fs::path pcd_dir(pcd_map_path);
+    std::vector<std::string> pcd_files;
+
+    if (fs::is_directory(pcd_dir / "pointcloud_map.pcd")) {
+      pcd_dir /= "pointcloud_map.pcd";
+    }
+
+    for (const auto & entry : fs::directory_iterator(pcd_dir)) {
+      auto extension = entry.path().extension().string();
+
+      if (fs::is_regular_file(entry.status()) && (extension == ".pcd" || extension == ".PCD")) {
+        pcd_files.push_back(entry.path().string());
+      }
+    }
+
+    std::sort(pcd_files.begin(), pcd_files.end());
+
+    for (const auto & pcd_file : pcd_files) {
+      add_tile(pcd_file, no_bounds, false);
+    }
+  }
+
+  if (tiles_.empty()) {
+    RCLCPP_ERROR_STREAM(rclcpp::get_logger("MapHeightProvider"), "No PCD files found");
+    return false;
+  }
+
+  // Buckets as large as the largest tile, so that a tile overlaps a few of them
+  for (const auto & tile : tiles_) {
+    if (tile.bounded) {
+      bucket_size_ = std::max<double>(
+        bucket_size_, std::max(tile.bounds[2] - tile.bounds[0], tile.bounds[3] - tile.bounds[1]));
+    }
+  }
+
+  bucket_size_ += 2 * search_radius2d_;
+
+  for (size_t tile_id = 0; tile_id < tiles_.size(); ++tile_id) {
+    const auto & tile = tiles_[tile_id];
+
+    if (!tile.bounded) {
+      unbounded_tiles_.push_back(tile_id);
+      continue;
+    }
+
+    for (int ix = cell_index(tile.bounds[0] - search_radius2d_, bucket_size_);
+         ix <= cell_index(tile.bounds[2] + search_radius2d_, bucket_size_); ++ix) {
+      for (int iy = cell_index(tile.bounds[1] - search_radius2d_, bucket_size_);
+           iy <= cell_index(tile.bounds[3] + search_radius2d_, bucket_size_); ++iy) {
+        buckets_[cell_key(ix, iy)].push_back(tile_id);
+      }
+    }
+  }
+
+  return true;
+}
+
+void MapHeightProvider::add_tile(
+  const std::string & path, const std::array<float, 4> & bounds, bool bounded)
+{
+  tiles_.push_back(Tile{path, bounds, bounded});
+}
+
+bool MapHeightProvider::load_tile_index(const std::string & dir)
+{
+  namespace fs = std::filesystem;
+
+  autoware::pointcloud_divider::TileIndexHeader header;
+  std::vector<autoware::pointcloud_divider::TileIndexRecord> records;
+  std::vector<std::string> tile_paths;
+  auto index_path = (fs::path(dir) / "pointcloud_map_index.bin").string();
+
+  if (!autoware::pointcloud_divider::loadTileIndex(index_path, header, records, tile_paths)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    const auto & rec = records[i];
+
+    add_tile(
+      (fs::path(dir) / tile_paths[i]).string(),
+      {rec.min_pt[0], rec.min_pt[1], rec.max_pt[0], rec.max_pt[1]}, true);
+  }
+
+  return true;
+}
+
+bool MapHeightProvider::load_metadata(const std::string & dir)
+{
+  namespace fs = std::filesystem;
+
+  auto metadata_path = fs::path(dir) / "pointcloud_map_metadata.yaml";
+  auto pcd_dir = fs::path(dir) / "pointcloud_map.pcd";
+
+  if (!fs::exists(metadata_path) || !fs::is_directory(pcd_dir)) {
+    return false;
+  }
+
+  // The metadata has only the names of the tiles, which may be in the folders of large grids
+  std::unordered_map<std::string, std::string> pcd_paths;
+
+  for (const auto & entry : fs::recursive_directory_iterator(pcd_dir)) {
+    if (fs::is_regular_file(entry.status())) {
+      pcd_paths[entry.path().filename().string()] = entry.path().string();
+    }
+  }
+
+  try {
+    YAML::Node metadata = YAML::LoadFile(metadata_path.string());
+    auto x_resolution = metadata["x_resolution"].as<float>();
+    auto y_resolution = metadata["y_resolution"].as<float>();
+
+    for (const auto & entry : metadata) {
+      auto name = entry.first.as<std::string>();
+      auto path_it = pcd_paths.find(name);
+
+      if (name == "x_resolution" || name == "y_resolution" || path_it == pcd_paths.end()) {
+        continue;
+      }
+
+      // Tiles are named by the lower corner of their grid
+      auto grid = entry.second.as<std::vector<float>>();
+
+      add_tile(
+        path_it->second, {grid[0], grid[1], grid[0] + x_resolution, grid[1] + y_resolution},
+        true);
+    }
+  } catch (YAML::Exception & e) {
+    RCLCPP_WARN_STREAM(
+      rclcpp::get_logger("MapHeightProvider"),
+      "Cannot load the metadata " << metadata_path.string() << ": " << e.what());
+    tiles_.clear();
+    return false;
+  }
+
+  return !tiles_.empty();
+}
+
+void MapHeightProvider::find_tiles(double x, double y, std::vector<size_t> & tile_ids) const
+{
+  tile_ids = unbounded_tiles_;
+
+  auto bucket_it =
+    buckets_.find(cell_key(cell_index(x, bucket_size_), cell_index(y, bucket_size_)));
+
+  if (bucket_it == buckets_.end()) {
+    return;
+  }
+
+  for (auto tile_id : bucket_it->second) {
+    const auto & bounds = tiles_[tile_id].bounds;
+
+    if (
+      bounds[0] - search_radius2d_ <= x && x <= bounds[2] + search_radius2d_ &&
+      bounds[1] - search_radius2d_ <= y && y <= bounds[3] + search_radius2d_) {
+      tile_ids.push_back(tile_id);
+    }
+  }
+}
+
+std::vector<const MapHeightProvider::TileGrid *> MapHeightProvider::acquire(
+  const std::vector<size_t> & tile_ids,
+  const std::unordered_map<size_t, std::vector<uint64_t>> & needed_cells,
+  std::vector<std::unique_ptr<TileGrid>> & partial_grids)
+{
+  std::vector<const TileGrid *> grids(tile_ids.size(), nullptr);
+  std::vector<size_t> missing;
+
+  // Move the cached tiles to the front, so that the eviction keeps them
+  for (size_t i = 0; i < tile_ids.size(); ++i) {
+    auto cache_it = cache_.find(tile_ids[i]);
+
+    if (cache_it == cache_.end()) {
+      missing.push_back(i);
+      continue;
+    }
+
+    lru_.splice(lru_.begin(), lru_, cache_it->second.first);
+    grids[i] = cache_it->second.second.get();
+  }
+
+  std::vector<std::unique_ptr<TileGrid>> built(missing.size());
+
+  run_parallel(missing.size(), std::min(thread_num_, missing.size()), [&](size_t i) {
+    auto needed_it = needed_cells.find(tile_ids[missing[i]]);
+
+    built[i] = std::make_unique<TileGrid>(
+      tiles_[tile_ids[missing[i]]].path, search_radius2d_,
+      (needed_it != needed_cells.end()) ? &needed_it->second : nullptr);
+  });
+
+  loaded_tile_num_ += missing.size();
+
+  for (size_t i = 0; i < missing.size(); ++i) {
+    size_t tile_id = tile_ids[missing[i]];
+
+    grids[missing[i]] = built[i].get();
+
+    if (!tiles_[tile_id].bounded) {
+      partial_grids.push_back(std::move(built[i]));
+      continue;
+    }
+
+    if (cache_.size() >= max_cached_tiles_) {
+      cache_.erase(lru_.back());
+      lru_.pop_back();
+    }
+
+    lru_.push_front(tile_id);
+    cache_.emplace(tile_id, std::make_pair(lru_.begin(), std::move(built[i])));
+  }
+
+  return grids;
+}
+
+size_t MapHeightProvider::min_heights(
+  const std::vector<Eigen::Vector3d> & points, std::vector<double> & heights)
+{
+  const double no_height = std::numeric_limits<double>::infinity();
+
+  heights.assign(points.size(), no_height);
+
+  // Pairs of the tiles and the points whose search they touch, grouped by tile
+  std::vector<std::pair<size_t, size_t>> tile_points;
+  std::vector<size_t> tile_ids;
+
+  for (size_t pid = 0; pid < points.size(); ++pid) {
+    find_tiles(points[pid].x(), points[pid].y(), tile_ids);
+
+    for (auto tile_id : tile_ids) {
+      tile_points.emplace_back(tile_id, pid);
+    }
+  }
+
+  std::sort(tile_points.begin(), tile_points.end());
+
+  // Each batch of tiles fits into the cache, and each tile is read once
+  for (size_t begin = 0; begin < tile_points.size();) {
+    std::vector<size_t> batch_tiles;
+    std::unordered_map<size_t, std::vector<uint64_t>> needed_cells;
+    std::vector<std::pair<size_t, size_t>> point_tiles;
+    size_t end = begin;
+
+    for (; end < tile_points.size(); ++end) {
+      size_t tile_id = tile_points[end].first;
+
+      if (batch_tiles.empty() || batch_tiles.back() != tile_id) {
+        if (batch_tiles.size() == max_cached_tiles_) {
+          break;
+        }
+
+        batch_tiles.push_back(tile_id);
+      }
+
+      point_tiles.emplace_back(tile_points[end].second, batch_tiles.size() - 1);
+
+      // Unbounded tiles keep only the cells around the points
+      if (!tiles_[tile_id].bounded) {
+        const auto & pt = points[tile_points[end].second];
+        auto & cells = needed_cells[tile_id];
+
+        for (int ix = cell_index(pt.x() - search_radius2d_, search_radius2d_);
+             ix <= cell_index(pt.x() + search_radius2d_, search_radius2d_); ++ix) {
+          for (int iy = cell_index(pt.y() - search_radius2d_, search_radius2d_);
+               iy <= cell_index(pt.y() + search_radius2d_, search_radius2d_); ++iy) {
+            cells.push_back(cell_key(ix, iy));
+          }
+        }
+      }
+    }
+
+    for (auto & cells : needed_cells) {
+      std::sort(cells.second.begin(), cells.second.end());
+      cells.second.erase(std::unique(cells.second.begin(), cells.second.end()), cells.second.end());
+    }
+
+    std::vector<std::unique_ptr<TileGrid>> partial_grids;
+    auto grids = acquire(batch_tiles, needed_cells, partial_grids);
+
+    // Each point is only updated by the thread that searches its tiles of the batch
+    std::sort(point_tiles.begin(), point_tiles.end());
+
+    std::vector<size_t> group_begins;
+
+    for (size_t i = 0; i < point_tiles.size(); ++i) {
+      if (i == 0 || point_tiles[i].first != point_tiles[i - 1].first) {
+        group_begins.push_back(i);
+      }
+    }
+
+    group_begins.push_back(point_tiles.size());
+
+    run_parallel(group_begins.size() - 1, thread_num_, [&](size_t group) {
+      for (size_t i = group_begins[group]; i < group_begins[group + 1]; ++i) {
+        size_t pid = point_tiles[i].first;
+
+        grids[point_tiles[i].second]->min_height(
+          points[pid], search_radius2d_, search_radius3d_, heights[pid]);
+      }
+    });
+
+    begin = end;
+  }
+
+  size_t found_num = 0;
+
+  for (auto & height : heights) {
+    if (height == no_height) {
+      height = std::numeric_limits<double>::quiet_NaN();
+    } else {
+      ++found_num;
+    }
+  }
+
+  return found_num;
+}
+}  // namespace autoware::lanelet2_map_utils
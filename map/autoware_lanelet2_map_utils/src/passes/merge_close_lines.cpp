@@ -0,0 +1,212 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_core/primitives/LaneletSequence.h>
+#include <lanelet2_io/Io.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+lanelet::LineStrings3d convert_line_layer_to_line_strings(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::LineStrings3d lines;
+  std::copy(
+    lanelet_map_ptr->lineStringLayer.begin(), lanelet_map_ptr->lineStringLayer.end(),
+    std::back_inserter(lines));
+  return lines;
+}
+
+lanelet::ConstPoint3d get3d_point_from2d_arc_length(
+  const lanelet::ConstLineString3d & line, const double s)
+{
+  double accumulated_distance2d = 0;
+  if (line.size() < 2) {
+    return lanelet::Point3d();
+  }
+  auto prev_pt = line.front();
+  for (size_t i = 1; i < line.size(); i++) {
+    const auto & pt = line[i];
+    double distance2d =
+      lanelet::geometry::distance2d(lanelet::utils::to2D(prev_pt), lanelet::utils::to2D(pt));
+    if (accumulated_distance2d + distance2d >= s) {
+      double ratio = (s - accumulated_distance2d) / distance2d;
+      auto interpolated_pt = prev_pt.basicPoint() * (1 - ratio) + pt.basicPoint() * ratio;
+      return lanelet::ConstPoint3d{
+        lanelet::utils::getId(), interpolated_pt.x(), interpolated_pt.y(), interpolated_pt.z()};
+    }
+    accumulated_distance2d += distance2d;
+    prev_pt = pt;
+  }
+  RCLCPP_ERROR(rclcpp::get_logger("merge_close_lines"), "interpolation failed");
+  return {};
+}
+
+bool are_lines_same(
+  const lanelet::ConstLineString3d & line1, const lanelet::ConstLineString3d & line2)
+{
+  bool same_ends = false;
+  if (line1.front() == line2.front() && line1.back() == line2.back()) {
+    same_ends = true;
+  }
+  if (line1.front() == line2.back() && line1.back() == line2.front()) {
+    same_ends = true;
+  }
+  if (!same_ends) {
+    return false;
+  }
+
+  double sum_distance =
+    std::accumulate(line1.begin(), line1.end(), 0.0, [&line2](double sum, const auto & pt) {
+      return sum + boost::geometry::distance(pt.basicPoint(), line2);
+    });
+  sum_distance +=
+    std::accumulate(line2.begin(), line2.end(), 0.0, [&line1](double sum, const auto & pt) {
+      return sum + boost::geometry::distance(pt.basicPoint(), line1);
+    });
+
+  double avg_distance = sum_distance / static_cast<double>(line1.size() + line2.size());
+  return avg_distance < 1.0;
+}
+
+lanelet::BasicPoint3d get_closest_point_on_line(
+  const lanelet::BasicPoint3d & search_point, const lanelet::ConstLineString3d & line)
+{
+  auto arc_coordinate = lanelet::geometry::toArcCoordinates(
+    lanelet::utils::to2D(line), lanelet::utils::to2D(search_point));
+  return get3d_point_from2d_arc_length(line, arc_coordinate.length).basicPoint();
+}
+
+lanelet::LineString3d merge_two_lines(
+  const lanelet::LineString3d & line1, const lanelet::ConstLineString3d & line2)
+{
+  lanelet::Points3d new_points;
+  for (const auto & p1 : line1) {
+    const lanelet::BasicPoint3d & p1_basic_point = p1.basicPoint();
+    lanelet::BasicPoint3d p2_basic_point = get_closest_point_on_line(p1, line2);
+    lanelet::BasicPoint3d new_basic_point = (p1_basic_point + p2_basic_point) / 2;
+    lanelet::Point3d new_point(lanelet::utils::getId(), new_basic_point);
+    new_points.push_back(new_point);
+  }
+  return lanelet::LineString3d{lanelet::utils::getId(), new_points};
+}
+
+void copy_data(lanelet::LineString3d & dst, const lanelet::LineString3d & src)
+{
+  dst.clear();
+  for (const lanelet::ConstPoint3d & pt : src) {
+    dst.push_back(static_cast<lanelet::Point3d>(pt));
+  }
+}
+
+// Group the indices of the lines by their end points in either direction. Only lines in the same
+// group can be the same, and groups of one line are dropped
+std::vector<std::vector<size_t>> group_lines_by_ends(const lanelet::LineStrings3d & lines)
+{
+  std::map<std::pair<lanelet::Id, lanelet::Id>, std::vector<size_t>> ends_to_lines;
+
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (lines[i].empty()) {
+      continue;
+    }
+
+    auto front_id = lines[i].front().id();
+    auto back_id = lines[i].back().id();
+
+    ends_to_lines[std::minmax(front_id, back_id)].push_back(i);
+  }
+
+  std::vector<std::vector<size_t>> groups;
+
+  for (auto & ends : ends_to_lines) {
+    if (ends.second.size() > 1) {
+      groups.push_back(std::move(ends.second));
+    }
+  }
+
+  return groups;
+}
+
+// Pair each line of a group with the first earlier line that is the same, in the order of the
+// line layer. A merged line gets new end points, so it is not paired again
+std::vector<std::pair<size_t, size_t>> find_same_lines(
+  const lanelet::LineStrings3d & lines, const std::vector<size_t> & group)
+{
+  std::vector<std::pair<size_t, size_t>> pairs;
+  std::vector<bool> merged(group.size(), false);
+
+  for (size_t gi = 0; gi < group.size(); ++gi) {
+    for (size_t gj = 0; gj < gi; ++gj) {
+      if (!merged[gj] && are_lines_same(lines[group[gi]], lines[group[gj]])) {
+        pairs.emplace_back(group[gi], group[gj]);
+        merged[gi] = merged[gj] = true;
+        break;
+      }
+    }
+  }
+
+  return pairs;
+}
+
+void merge_lines(lanelet::LaneletMapPtr & lanelet_map_ptr, size_t thread_num)
+{
+  auto lines = convert_line_layer_to_line_strings(lanelet_map_ptr);
+  auto groups = group_lines_by_ends(lines);
+  std::vector<std::vector<std::pair<size_t, size_t>>> group_pairs(groups.size());
+
+  // Lines are only compared in their groups, so the groups are searched independently
+  run_parallel(groups.size(), thread_num, [&](size_t g) {
+    group_pairs[g] = find_same_lines(lines, groups[g]);
+  });
+
+  std::vector<std::pair<size_t, size_t>> pairs;
+
+  for (const auto & gp : group_pairs) {
+    pairs.insert(pairs.end(), gp.begin(), gp.end());
+  }
+
+  // Merge in the order of the line layer, so that the new IDs are the same in every run
+  std::sort(pairs.begin(), pairs.end());
+
+  for (const auto & [i, j] : pairs) {
+    auto line_i = lines.at(i);
+    auto line_j = lines.at(j);
+    auto merged_line = merge_two_lines(line_i, line_j);
+
+    copy_data(line_i, merged_line);
+    copy_data(line_j, merged_line);
+    line_i.setId(line_j.id());
+    // lanelet_map_ptr->add(merged_line);
+    for (lanelet::Point3d & pt : merged_line) {
+      lanelet_map_ptr->add(pt);
+    }
+  }
+
+  std::cout << "Merged " << pairs.size() << " pairs of lines, " << groups.size()
+            << " groups of lines with the same end points were compared" << std::endl;
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,173 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/geometry/Lanelet.h>
+#include <lanelet2_io/Io.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace autoware::lanelet2_map_utils
+{
+lanelet::Points3d convert_points_layer_to_points(const lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::Points3d points;
+  std::copy(
+    lanelet_map_ptr->pointLayer.begin(), lanelet_map_ptr->pointLayer.end(),
+    std::back_inserter(points));
+  return points;
+}
+
+// lanelet::LineString3d mergeClosePoints(const lanelet::ConstLineString3d& line1, const
+// lanelet::ConstLineString3d& line2)
+// {
+//   lanelet::Points3d new_points;
+//   for (const auto& p1 : line1)
+//   {
+//     p1_basic_point = p1.basicPoint();
+//     lanelet::BasicPoint3d p2 = getClosestPointOnLine(line2, p1);
+//     lanelet::BasicPoint3d new_basic_point = (p1_basic_point + p2_basic_point)/2;
+//     lanelet::Point3d new_point(lanelet::utils::getId(), new_basic_point);
+//     new_points.push_back(new_point);
+//   }
+//   return lanelet::LineString3d(lanelet::utils::getId(), new_points);
+// }
+
+// Disjoint sets of point indices. The root of a set is always its smallest index, so that the
+// result does not depend on the order of the unions
+class UnionFind
+{
+public:
+  explicit UnionFind(size_t size) : parents_(size)
+  {
+    for (size_t i = 0; i < size; ++i) {
+      parents_[i] = i;
+    }
+  }
+
+  size_t find(size_t i)
+  {
+    while (parents_[i] != i) {
+      parents_[i] = parents_[parents_[i]];
+      i = parents_[i];
+    }
+
+    return i;
+  }
+
+  void unite(size_t i, size_t j)
+  {
+    i = find(i);
+    j = find(j);
+
+    if (i < j) {
+      parents_[j] = i;
+    } else if (j < i) {
+      parents_[i] = j;
+    }
+  }
+
+private:
+  std::vector<size_t> parents_;
+};
+
+// Merge the points closer than merge_distance to each other, directly or through other points.
+// The points of a cluster are moved to its centroid and take the ID of its first point
+void merge_points(const lanelet::LaneletMapPtr & lanelet_map_ptr, double merge_distance)
+{
+  const auto & points = convert_points_layer_to_points(lanelet_map_ptr);
+
+  // Points in the 2D cells of merge_distance around a point are the only merge candidates. Maps
+  // are mostly flat, so the cells are not divided by height. The points are sorted by their cells,
+  // so that the candidates in a row of cells are next to each other
+  using CellKey = std::pair<int64_t, int64_t>;
+
+  std::vector<lanelet::BasicPoint3d> positions(points.size());
+  std::vector<std::pair<CellKey, size_t>> sorted_cells(points.size());
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    positions[i] = points[i].basicPoint();
+    sorted_cells[i].first = std::make_pair(
+      static_cast<int64_t>(std::floor(positions[i].x() / merge_distance)),
+      static_cast<int64_t>(std::floor(positions[i].y() / merge_distance)));
+    sorted_cells[i].second = i;
+  }
+
+  std::sort(sorted_cells.begin(), sorted_cells.end());
+
+  UnionFind clusters(points.size());
+
+  for (const auto & [cell, i] : sorted_cells) {
+    for (int64_t x = cell.first - 1; x <= cell.first + 1; ++x) {
+      auto first_cell = std::make_pair(CellKey(x, cell.second - 1), size_t{0});
+      auto it = std::lower_bound(sorted_cells.begin(), sorted_cells.end(), first_cell);
+
+      for (; it != sorted_cells.end() && it->first <= CellKey(x, cell.second + 1); ++it) {
+        auto j = it->second;
+
+        if (j < i && (positions[j] - positions[i]).norm() < merge_distance) {
+          clusters.unite(i, j);
+        }
+      }
+    }
+  }
+
+  // Centroids are computed from the original positions, in the order of the points
+  std::vector<lanelet::BasicPoint3d> sums(points.size(), lanelet::BasicPoint3d::Zero());
+  std::vector<size_t> sizes(points.size(), 0);
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    auto root = clusters.find(i);
+
+    sums[root] += positions[i];
+    ++sizes[root];
+  }
+
+  size_t merged_num = 0;
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    auto root = clusters.find(i);
+
+    if (sizes[root] < 2) {
+      continue;
+    }
+
+    auto point_i = points[i];
+    const lanelet::BasicPoint3d new_point = sums[root] / static_cast<double>(sizes[root]);
+
+    point_i.x() = new_point.x();
+    point_i.y() = new_point.y();
+    point_i.z() = new_point.z();
+
+    if (root != i) {
+      point_i.setId(points[root].id());
+      ++merged_num;
+    }
+  }
+
+  std::cout << "Merged " << merged_num << " of " << points.size() << " points" << std::endl;
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,127 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_core/primitives/RegulatoryElement.h>
+#include <lanelet2_io/Io.h>
+
+#include <iostream>
+#include <memory>
+
+namespace autoware::lanelet2_map_utils
+{
+// Points, line strings and polygons referred to by the lanelets, the areas and the regulatory
+// elements of a map. Each primitive is visited once, as it is skipped when its ID is known
+struct ReferencedGeometry
+{
+  lanelet::PointLayer::Map points;
+  lanelet::LineStringLayer::Map line_strings;
+  lanelet::PolygonLayer::Map polygons;
+
+  void add(const lanelet::Point3d & pt) { points.emplace(pt.id(), pt); }
+
+  void add(lanelet::LineString3d line)
+  {
+    // The layers keep line strings in their original direction
+    if (line.inverted()) {
+      line = line.invert();
+    }
+
+    if (line_strings.emplace(line.id(), line).second) {
+      for (lanelet::Point3d & pt : line) {
+        add(pt);
+      }
+    }
+  }
+
+  void add(lanelet::Polygon3d polygon)
+  {
+    if (polygons.emplace(polygon.id(), polygon).second) {
+      for (lanelet::Point3d & pt : polygon) {
+        add(pt);
+      }
+    }
+  }
+};
+
+// Add the geometric parameters of a regulatory element. Lanelets and areas are kept anyway
+class ParameterCollector : public lanelet::RuleParameterVisitor
+{
+public:
+  explicit ParameterCollector(ReferencedGeometry & geometry) : geometry_(geometry) {}
+
+  void operator()(const lanelet::Point3d & pt) override { geometry_.add(pt); }
+  void operator()(const lanelet::LineString3d & line) override { geometry_.add(line); }
+  void operator()(const lanelet::Polygon3d & polygon) override { geometry_.add(polygon); }
+
+private:
+  ReferencedGeometry & geometry_;
+};
+
+// Keep the lanelets, the areas and the regulatory elements, and the geometry that they refer to.
+// The new map is built from the layers at once, instead of adding the primitives one by one
+void remove_unreferenced_geometry(lanelet::LaneletMapPtr & lanelet_map_ptr)
+{
+  lanelet::LaneletLayer::Map lanelets;
+  lanelet::AreaLayer::Map areas;
+  lanelet::RegulatoryElementLayer::Map regulatory_elements;
+  ReferencedGeometry geometry;
+  ParameterCollector collector(geometry);
+
+  geometry.points.reserve(lanelet_map_ptr->pointLayer.size());
+  geometry.line_strings.reserve(lanelet_map_ptr->lineStringLayer.size());
+
+  for (auto & llt : lanelet_map_ptr->laneletLayer) {
+    lanelets.emplace(llt.id(), llt);
+    geometry.add(llt.leftBound());
+    geometry.add(llt.rightBound());
+  }
+
+  for (auto & area : lanelet_map_ptr->areaLayer) {
+    areas.emplace(area.id(), area);
+
+    for (const auto & line : area.outerBound()) {
+      geometry.add(line);
+    }
+
+    for (const auto & inner_bound : area.innerBounds()) {
+      for (const auto & line : inner_bound) {
+        geometry.add(line);
+      }
+    }
+  }
+
+  for (const auto & regulatory_element : lanelet_map_ptr->regulatoryElementLayer) {
+    regulatory_elements.emplace(regulatory_element->id(), regulatory_element);
+    regulatory_element->applyVisitor(collector);
+  }
+
+  const auto removed_point_num = lanelet_map_ptr->pointLayer.size() - geometry.points.size();
+  const auto removed_line_num =
+    lanelet_map_ptr->lineStringLayer.size() - geometry.line_strings.size();
+  const auto removed_polygon_num = lanelet_map_ptr->polygonLayer.size() - geometry.polygons.size();
+
+  std::cout << "Removed " << removed_point_num << " points, " << removed_line_num
+            << " line strings and " << removed_polygon_num << " polygons" << std::endl;
+
+  lanelet_map_ptr = std::make_shared<lanelet::LaneletMap>(
+    lanelets, areas, regulatory_elements, geometry.polygons, geometry.line_strings,
+    geometry.points);
+}
+}  // namespace autoware::lanelet2_map_utils
@@ -0,0 +1,115 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware/pointcloud_divider/pcd_io.hpp>
+
+#include <lanelet2_core/LaneletMap.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace autoware::lanelet2_map_utils
+{
+void transform_lanelet_map(
+  const lanelet::LaneletMapPtr & lanelet_map_ptr, const Eigen::Affine3d & affine)
+{
+  for (lanelet::Point3d & pt : lanelet_map_ptr->pointLayer) {
+    Eigen::Vector3d eigen_pt(pt.x(), pt.y(), pt.z());
+    auto transformed_pt = affine * eigen_pt;
+    pt.x() = transformed_pt.x();
+    pt.y() = transformed_pt.y();
+    pt.z() = transformed_pt.z();
+  }
+}
+
+void transform_points(
+  pcl::PointCloud<pcl::PointXYZ> & cloud, const Eigen::Affine3d & affine, size_t thread_num)
+{
+  // Each chunk is a 3xN matrix on the memory of the points, so that Eigen vectorizes the
+  // transformation. It is computed in double like the transformation of a single point
+  const size_t chunk_size = 65536;
+  const size_t chunk_num = (cloud.size() + chunk_size - 1) / chunk_size;
+  const Eigen::Matrix3d rotation = affine.linear();
+  const Eigen::Vector3d translation = affine.translation();
+  using PointMatrix = Eigen::Map<Eigen::Matrix<float, 3, Eigen::Dynamic>, 0, Eigen::OuterStride<>>;
+
+  run_parallel(chunk_num, thread_num, [&](size_t c) {
+    size_t begin = c * chunk_size;
+    size_t size = std::min(chunk_size, cloud.size() - begin);
+    PointMatrix points(
+      &cloud.points[begin].x, 3, size, Eigen::OuterStride<>(sizeof(pcl::PointXYZ) / sizeof(float)));
+    Eigen::Matrix<double, 3, Eigen::Dynamic> transformed =
+      (rotation * points.cast<double>()).colwise() + translation;
+
+    points = transformed.cast<float>();
+  });
+}
+
+bool transform_pcd_map(
+  const std::string & pcd_map_path, const std::string & pcd_output_path,
+  const Eigen::Affine3d & affine, size_t thread_num)
+{
+  const size_t block_size = 1000000;
+  autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZ> reader;
+  autoware::pointcloud_divider::CustomPCDWriter<pcl::PointXYZ> writer;
+  size_t point_num = 0;
+
+  reader.setBlockSize(block_size);
+  reader.setInput(pcd_map_path);
+
+  // The number of points is updated at the end, in case the input has fewer than its header says
+  writer.setResizableMetadata(true);
+  writer.setOutput(pcd_output_path);
+  writer.setBlockSize(block_size);
+  writer.writeMetadata(reader.point_num(), true);
+
+  do {
+    pcl::PointCloud<pcl::PointXYZ> block;
+
+    reader.readABlock(block);
+    transform_points(block, affine, thread_num);
+    writer.write(block);
+    point_num += block.size();
+  } while (reader.good());
+
+  writer.updateMetadata(point_num);
+
+  bool written = writer.good();
+
+  writer.close();
+
+  std::cout << "Transformed " << point_num << " data points." << std::endl;
+  return written;
+}
+
+Eigen::Affine3d create_affine_matrix_from_xyzrpy(
+  const double x, const double y, const double z, const double roll, const double pitch,
+  const double yaw)
+{
+  double roll_rad = roll * M_PI / 180.0;
+  double pitch_rad = pitch * M_PI / 180.0;
+  double yaw_rad = yaw * M_PI / 180.0;
+
+  Eigen::Translation<double, 3> trans(x, y, z);
+  Eigen::Matrix3d rot;
+  rot = Eigen::AngleAxisd(yaw_rad, Eigen::Vector3d::UnitZ()) *
+        Eigen::AngleAxisd(pitch_rad, Eigen::Vector3d::UnitY()) *
+        Eigen::AngleAxisd(roll_rad, Eigen::Vector3d::UnitX());
+  return trans * rot;
+}
+}  // namespace autoware::lanelet2_map_utils
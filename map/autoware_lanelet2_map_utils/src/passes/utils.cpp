@@ -0,0 +1,52 @@
+// Copyright 2020 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
+#include <autoware/task_scheduler/task_scheduler.hpp>
+#include <autoware_lanelet2_extension/io/autoware_osm_parser.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace autoware::lanelet2_map_utils
+{
+bool load_lanelet_map(
+  const std::string & llt_map_path, lanelet::LaneletMapPtr & lanelet_map_ptr,
+  lanelet::Projector & projector)
+{
+  lanelet::LaneletMapPtr lanelet_map;
+  lanelet::ErrorMessages errors;
+  lanelet_map_ptr = lanelet::load(llt_map_path, "autoware_osm_handler", projector, &errors);
+
+  for (const auto & error : errors) {
+    RCLCPP_ERROR_STREAM(rclcpp::get_logger("loadLaneletMap"), error);
+  }
+  if (!errors.empty()) {
+    return false;
+  }
+  std::cout << "Loaded Lanelet2 map" << std::endl;
+  return true;
+}
+
+// Run func(i) for i in [0, size) with thread_num threads of the scheduler of the process, so that
+// the passes do not create threads beyond its budget
+void run_parallel(size_t size, size_t thread_num, const std::function<void(size_t)> & func)
+{
+  autoware::task_scheduler::TaskScheduler::global().parallel_for(
+    size, func, std::max<size_t>(thread_num, 1));
+}
+}  // namespace autoware::lanelet2_map_utils
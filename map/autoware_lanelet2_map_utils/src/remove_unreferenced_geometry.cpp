@@ -12,68 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "autoware/lanelet2_map_utils/map_passes.hpp"
+
 #include <autoware_lanelet2_extension/io/autoware_osm_parser.hpp>
 #include <autoware_lanelet2_extension/projection/mgrs_projector.hpp>
-#include <autoware_lanelet2_extension/utility/message_conversion.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 #include <lanelet2_core/LaneletMap.h>
-#include <lanelet2_core/geometry/Lanelet.h>
 #include <lanelet2_io/Io.h>
 
-#include <iostream>
 #include <string>
-#include <unordered_set>
-#include <vector>
-
-namespace autoware::lanelet2_map_utils
-{
-bool load_lanelet_map(
-  const std::string & llt_map_path, lanelet::LaneletMapPtr & lanelet_map_ptr,
-  lanelet::Projector & projector)
-{
-  lanelet::LaneletMapPtr lanelet_map;
-  lanelet::ErrorMessages errors;
-  lanelet_map_ptr = lanelet::load(llt_map_path, "autoware_osm_handler", projector, &errors);
-
-  for (const auto & error : errors) {
-    RCLCPP_ERROR_STREAM(rclcpp::get_logger("loadLaneletMap"), error);
-  }
-  if (!errors.empty()) {
-    return false;
-  }
-  std::cout << "Loaded Lanelet2 map" << std::endl;
-  return true;
-}
-
-lanelet::Points3d convert_points_layer_to_points(const lanelet::LaneletMapPtr & lanelet_map_ptr)
-{
-  lanelet::Points3d points;
-  std::copy(
-    lanelet_map_ptr->pointLayer.begin(), lanelet_map_ptr->pointLayer.end(),
-    std::back_inserter(points));
-  return points;
-}
-
-lanelet::LineStrings3d convert_line_layer_to_line_strings(
-  const lanelet::LaneletMapPtr & lanelet_map_ptr)
-{
-  lanelet::LineStrings3d lines;
-  std::copy(
-    lanelet_map_ptr->lineStringLayer.begin(), lanelet_map_ptr->lineStringLayer.end(),
-    std::back_inserter(lines));
-  return lines;
-}
-
-void remove_unreferenced_geometry(lanelet::LaneletMapPtr & lanelet_map_ptr)
-{
-  lanelet::LaneletMapPtr new_map(new lanelet::LaneletMap);
-  for (const auto & llt : lanelet_map_ptr->laneletLayer) {
-    new_map->add(llt);
-  }
-  lanelet_map_ptr = new_map;
-}
-}  // namespace autoware::lanelet2_map_utils
 
 int main(int argc, char * argv[])
 {
@@ -0,0 +1,370 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__ASYNC_FILE_WRITER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__ASYNC_FILE_WRITER_HPP_
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Sequential writer that queues large page-aligned buffers to io_uring, so that the caller fills
+// the next buffer while the kernel writes the previous ones. Completions are reaped in batches
+// when a buffer is needed. Without io_uring (old kernels, seccomp), the buffers are written
+// with pwrite when they are submitted
+class AsyncFileWriter
+{
+public:
+  static constexpr size_t buffer_size = 4 << 20;
+  static constexpr unsigned queue_depth = 8;
+
+  AsyncFileWriter() = default;
+  AsyncFileWriter(const AsyncFileWriter &) = delete;
+  AsyncFileWriter & operator=(const AsyncFileWriter &) = delete;
+
+  ~AsyncFileWriter()
+  {
+    close();
+    closeRing();
+
+    for (auto * buffer : buffers_) {
+      std::free(buffer);
+    }
+  }
+
+  // Open an existing file to write from offset. The ring and the buffers are kept for the next
+  // files
+  void open(const std::string & path, size_t offset)
+  {
+    close();
+
+    if (buffers_.empty()) {
+      setup();
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY);
+
+    if (fd_ < 0) {
+      fail("Failed to open a file at", path);
+    }
+
+    path_ = path;
+    offset_ = offset;
+  }
+
+  bool is_open() const { return fd_ >= 0; }
+  bool usesIOUring() const { return ring_fd_ >= 0; }
+  // Offset of the end of the submitted data
+  size_t offset() const { return offset_; }
+
+  // Get a free buffer of buffer_size bytes, waiting for a write to complete if all are queued
+  char * acquire()
+  {
+    while (free_ids_.empty()) {
+      reap(true);
+    }
+
+    return buffers_[free_ids_.back()];
+  }
+
+  // Queue the first size bytes of the buffer given by the last acquire
+  void submit(size_t size)
+  {
+    unsigned id = free_ids_.back();
+
+    if (size == 0) {
+      return;
+    }
+
+    if (!usesIOUring()) {
+      writeAll(buffers_[id], size, offset_);
+      offset_ += size;
+      return;
+    }
+
+    free_ids_.pop_back();
+    pending_[id] = {offset_, size};
+
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe * sqe = sqes_ + index;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(buffers_[id]);
+    sqe->len = size;
+    sqe->off = offset_;
+    sqe->user_data = id;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        fail("Failed to submit a write to", path_);
+      }
+
+      // The completion queue is full, make room for the submission
+      reap(true);
+    }
+
+    offset_ += size;
+  }
+
+  // Copy data to the queued buffers
+  void write(const char * data, size_t size)
+  {
+    while (size > 0) {
+      size_t chunk = std::min(size, buffer_size);
+
+      memcpy(acquire(), data, chunk);
+      submit(chunk);
+      data += chunk;
+      size -= chunk;
+    }
+  }
+
+  // Wait until all queued writes are on the file
+  void flush()
+  {
+    while (free_ids_.size() < buffers_.size()) {
+      reap(true);
+    }
+  }
+
+  void close()
+  {
+    if (fd_ < 0) {
+      return;
+    }
+
+    flush();
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+private:
+  struct PendingWrite
+  {
+    size_t offset, size;
+  };
+
+  void setup()
+  {
+    buffers_.resize(queue_depth);
+    pending_.resize(queue_depth);
+
+    for (unsigned id = 0; id < queue_depth; ++id) {
+      buffers_[id] = static_cast<char *>(std::aligned_alloc(4096, buffer_size));
+
+      if (!buffers_[id]) {
+        fail("Failed to allocate the write buffers of", path_);
+      }
+
+      free_ids_.push_back(id);
+    }
+
+    io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+
+    int ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+
+    // IORING_OP_WRITE is available from the kernels with IORING_FEAT_RW_CUR_POS
+    if (ring_fd < 0) {
+      return;
+    }
+
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+      ::close(ring_fd);
+      return;
+    }
+
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+    }
+
+    sq_map_ = mmap(
+      nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+      IORING_OFF_SQ_RING);
+    cq_map_ = (params.features & IORING_FEAT_SINGLE_MMAP)
+                ? sq_map_
+                : mmap(
+                    nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd, IORING_OFF_CQ_RING);
+    sqes_map_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+    void * sqes = mmap(
+      nullptr, sqes_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+      IORING_OFF_SQES);
+
+    if (sq_map_ == MAP_FAILED || cq_map_ == MAP_FAILED || sqes == MAP_FAILED) {
+      // Fall back to pwrite
+      ring_fd_ = ring_fd;
+      sqes_ = (sqes == MAP_FAILED) ? nullptr : static_cast<io_uring_sqe *>(sqes);
+      closeRing();
+      return;
+    }
+
+    char * sq = static_cast<char *>(sq_map_);
+    char * cq = static_cast<char *>(cq_map_);
+
+    ring_fd_ = ring_fd;
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+  }
+
+  void closeRing()
+  {
+    if (ring_fd_ >= 0) {
+      if (sqes_) {
+        munmap(sqes_, sqes_map_size_);
+      }
+
+      if (cq_map_ && cq_map_ != MAP_FAILED && cq_map_ != sq_map_) {
+        munmap(cq_map_, cq_map_size_);
+      }
+
+      if (sq_map_ && sq_map_ != MAP_FAILED) {
+        munmap(sq_map_, sq_map_size_);
+      }
+
+      ::close(ring_fd_);
+      ring_fd_ = -1;
+      sq_map_ = cq_map_ = nullptr;
+      sqes_ = nullptr;
+    }
+  }
+
+  // Release the buffers of the completed writes. If wait is true, wait for at least one
+  void reap(bool wait)
+  {
+    if (!usesIOUring()) {
+      return;
+    }
+
+    unsigned head = *cq_head_;
+
+    while (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      if (!wait) {
+        return;
+      }
+
+      if (
+        syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+        errno != EINTR) {
+        fail("Failed to wait for the writes to", path_);
+      }
+    }
+
+    // Take all available completions at once
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+      const io_uring_cqe & cqe = cqes_[head & *cq_mask_];
+      unsigned id = cqe.user_data;
+      const PendingWrite & write = pending_[id];
+
+      if (cqe.res < 0) {
+        errno = -cqe.res;
+        fail("Failed to write to", path_);
+      }
+
+      // Short writes are completed synchronously
+      if (static_cast<size_t>(cqe.res) < write.size) {
+        writeAll(buffers_[id] + cqe.res, write.size - cqe.res, write.offset + cqe.res);
+      }
+
+      free_ids_.push_back(id);
+    }
+
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+
+  void writeAll(const char * data, size_t size, size_t offset)
+  {
+    while (size > 0) {
+      ssize_t written = pwrite(fd_, data, size, offset);
+
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+
+      if (written <= 0) {
+        fail("Failed to write to", path_);
+      }
+
+      data += written;
+      size -= written;
+      offset += written;
+    }
+  }
+
+  [[noreturn]] void fail(const char * message, const std::string & path) const
+  {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: %s %s: %s\n", __FILE__, __LINE__, __func__, message,
+      path.c_str(), strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  int fd_ = -1;
+  std::string path_;
+  size_t offset_ = 0;
+
+  std::vector<char *> buffers_;
+  std::vector<PendingWrite> pending_;  // Writes of the queued buffers
+  std::vector<unsigned> free_ids_;     // Buffers that are not queued
+
+  // Rings shared with the kernel
+  int ring_fd_ = -1;
+  void * sq_map_ = nullptr;
+  void * cq_map_ = nullptr;
+  size_t sq_map_size_ = 0, cq_map_size_ = 0, sqes_map_size_ = 0;
+  unsigned * sq_tail_ = nullptr;
+  unsigned * sq_mask_ = nullptr;
+  unsigned * sq_array_ = nullptr;
+  unsigned * cq_head_ = nullptr;
+  unsigned * cq_tail_ = nullptr;
+  unsigned * cq_mask_ = nullptr;
+  io_uring_cqe * cqes_ = nullptr;
+  io_uring_sqe * sqes_ = nullptr;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__ASYNC_FILE_WRITER_HPP_
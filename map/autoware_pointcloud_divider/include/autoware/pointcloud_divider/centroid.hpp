@@ -19,57 +19,157 @@
 
 #include <pcl/point_types.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
 namespace autoware::pointcloud_divider
 {
 
+// Values of a point averaged in a voxel: one per float field, and one per byte of a color field.
+// The other fields, e.g. ring, are labels and are taken from the first point of the voxel
 template <typename PointT>
-void accumulate(const PointT & p, const PointT & first_p, PointT & acc_diff);
+constexpr size_t channel_num()
+{
+  typedef util::FieldLayout<PointT> Layout;
+  size_t num = 0;
+
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    if (util::is_color_field(Layout::names[k])) {
+      num += Layout::sizes[k];
+    } else if (Layout::types[k] == 'F' && Layout::sizes[k] == sizeof(float)) {
+      ++num;
+    }
+  }
+
+  return num;
+}
+
 template <typename PointT>
-void compute_centroid(
-  const PointT & acc_diff, const PointT & first_p, size_t point_num, PointT & centroid);
+using Channels = std::array<float, channel_num<PointT>()>;
 
-template <>
-void accumulate(const pcl::PointXYZ & p, const pcl::PointXYZ & first_p, pcl::PointXYZ & acc_diff)
+// Sums of the channels of many points. The points are relative to the first point of their voxel
+// and the sums are in double, so that neither the map coordinates nor the number of points of a
+// voxel cost the precision of the centroid
+template <typename PointT>
+using ChannelSums = std::array<double, channel_num<PointT>()>;
+
+// Call func(channel id, location of the channel in PointT, true if the channel is a color byte)
+// for all channels of PointT
+template <typename PointT, typename Func>
+inline void for_each_channel(Func func)
 {
-  acc_diff.x += p.x - first_p.x;
-  acc_diff.y += p.y - first_p.y;
-  acc_diff.z += p.z - first_p.z;
+  typedef util::FieldLayout<PointT> Layout;
+
+  for (size_t k = 0, c = 0; k < Layout::field_num; ++k) {
+    if (util::is_color_field(Layout::names[k])) {
+      for (size_t b = 0; b < Layout::sizes[k]; ++b) {
+        func(c++, Layout::offsets[k] + b, true);
+      }
+    } else if (Layout::types[k] == 'F' && Layout::sizes[k] == sizeof(float)) {
+      func(c++, Layout::offsets[k], false);
+    }
+  }
 }
 
-template <>
-void accumulate(const pcl::PointXYZI & p, const pcl::PointXYZI & first_p, pcl::PointXYZI & acc_diff)
+template <typename PointT>
+inline float get_channel(const PointT & p, size_t loc, bool is_color)
 {
-  acc_diff.x += p.x - first_p.x;
-  acc_diff.y += p.y - first_p.y;
-  acc_diff.z += p.z - first_p.z;
-  acc_diff.intensity += p.intensity - first_p.intensity;
+  const char * src = reinterpret_cast<const char *>(&p);
+
+  if (is_color) {
+    return static_cast<uint8_t>(src[loc]);
+  }
+
+  float val;
+
+  memcpy(&val, src + loc, sizeof(float));
+
+  return val;
 }
 
-template <>
-void compute_centroid(
-  const pcl::PointXYZ & acc_diff, const pcl::PointXYZ & first_p, size_t point_num,
-  pcl::PointXYZ & centroid)
+template <typename PointT>
+inline void get_channels(const PointT & p, Channels<PointT> & channels)
 {
-  double double_point_num = static_cast<double>(point_num);
+  for_each_channel<PointT>(
+    [&](size_t c, size_t loc, bool is_color) { channels[c] = get_channel(p, loc, is_color); });
+}
 
-  centroid.x = acc_diff.x / double_point_num + first_p.x;
-  centroid.y = acc_diff.y / double_point_num + first_p.y;
-  centroid.z = acc_diff.z / double_point_num + first_p.z;
+template <typename PointT>
+inline void accumulate(const PointT & p, const PointT & first_p, ChannelSums<PointT> & acc_diff)
+{
+  for_each_channel<PointT>([&](size_t c, size_t loc, bool is_color) {
+    acc_diff[c] += get_channel(p, loc, is_color) - get_channel(first_p, loc, is_color);
+  });
 }
 
-template <>
-void compute_centroid(
-  const pcl::PointXYZI & acc_diff, const pcl::PointXYZI & first_p, size_t point_num,
-  pcl::PointXYZI & centroid)
+template <typename PointT>
+inline void compute_centroid(
+  const ChannelSums<PointT> & acc_diff, const PointT & first_p, size_t point_num, PointT & centroid)
 {
   double double_point_num = static_cast<double>(point_num);
+  char * dst = reinterpret_cast<char *>(&centroid);
 
-  centroid.x = acc_diff.x / double_point_num + first_p.x;
-  centroid.y = acc_diff.y / double_point_num + first_p.y;
-  centroid.z = acc_diff.z / double_point_num + first_p.z;
-  centroid.intensity = acc_diff.intensity / double_point_num + first_p.intensity;
+  // Labels are those of the first point
+  centroid = first_p;
+
+  for_each_channel<PointT>([&](size_t c, size_t loc, bool is_color) {
+    double val = acc_diff[c] / double_point_num + get_channel(first_p, loc, is_color);
+
+    if (is_color) {
+      dst[loc] = static_cast<char>(std::min(std::max(std::round(val), 0.0), 255.0));
+    } else {
+      float fval = val;
+
+      memcpy(dst + loc, &fval, sizeof(float));
+    }
+  });
+}
+
+// Add the accumulation of another group of points, whose first point is other_first_p
+template <typename PointT>
+inline void merge_accumulation(
+  const ChannelSums<PointT> & other_acc_diff, const PointT & other_first_p,
+  size_t other_point_num, const PointT & first_p, ChannelSums<PointT> & acc_diff)
+{
+  double double_point_num = static_cast<double>(other_point_num);
+
+  for_each_channel<PointT>([&](size_t c, size_t loc, bool is_color) {
+    acc_diff[c] +=
+      other_acc_diff[c] +
+      (get_channel(other_first_p, loc, is_color) - get_channel(first_p, loc, is_color)) *
+        double_point_num;
+  });
+}
+
+// Centroid of a run of point_num points, e.g. those of a voxel in the sorted order, where
+// point_at(i) is the i-th point of the run. The sums are the same as those of Centroid::add, but
+// the channels of a point are copied to an array first, so the compiler can vectorize the sums
+// over the channels instead of going through the fields one by one
+template <typename PointT, typename PointAt>
+inline PointT reduce_run(size_t point_num, const PointAt & point_at)
+{
+  const PointT & first_p = point_at(0);
+  Channels<PointT> first_channels, channels;
+  ChannelSums<PointT> acc_diff{};
+  PointT centroid;
+
+  get_channels(first_p, first_channels);
+
+  for (size_t i = 1; i < point_num; ++i) {
+    get_channels(point_at(i), channels);
+
+    for (size_t c = 0; c < channels.size(); ++c) {
+      acc_diff[c] += channels[c] - first_channels[c];
+    }
+  }
+
+  compute_centroid(acc_diff, first_p, point_num, centroid);
+
+  return centroid;
 }
 
 template <typename PointT>
@@ -78,7 +178,7 @@ struct Centroid
   Centroid()
   {
     point_num_ = 0;
-    util::zero_point(acc_diff_);
+    acc_diff_.fill(0);
     util::zero_point(first_point_);
   }
 
@@ -93,6 +193,22 @@ struct Centroid
     ++point_num_;
   }
 
+  // Add all points of another centroid group
+  void add(const Centroid & other)
+  {
+    if (other.point_num_ == 0) {
+      return;
+    }
+
+    if (point_num_ == 0) {
+      *this = other;
+    } else {
+      merge_accumulation(
+        other.acc_diff_, other.first_point_, other.point_num_, first_point_, acc_diff_);
+      point_num_ += other.point_num_;
+    }
+  }
+
   PointT get()
   {
     PointT centroid;
@@ -107,7 +223,9 @@ struct Centroid
     return centroid;
   }
 
-  PointT acc_diff_, first_point_;
+  // Sums of the differences between the channels of the points and those of the first point
+  ChannelSums<PointT> acc_diff_;
+  PointT first_point_;
   size_t point_num_;
 };
 
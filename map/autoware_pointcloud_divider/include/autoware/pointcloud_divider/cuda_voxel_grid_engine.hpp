@@ -0,0 +1,73 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__CUDA_VOXEL_GRID_ENGINE_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__CUDA_VOXEL_GRID_ENGINE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// GPU engine of VoxelGridFilter, built when POINTCLOUD_DIVIDER_USE_CUDA is ON. This header does
+// not depend on CUDA, so the templates of the filter stay in the C++ translation units
+
+namespace autoware::pointcloud_divider::cuda
+{
+
+// True if a CUDA device is found
+bool isDeviceAvailable();
+
+// Voxels of the points, in the order of their packed keys as in the sort-based CPU engine
+struct VoxelReduction
+{
+  // Input index of the first point of each voxel, whose labels the centroid takes
+  std::vector<uint32_t> first_indices;
+  std::vector<uint32_t> point_nums;
+  // Sums of the differences to the first point, channel_num values per voxel, as in Centroid
+  std::vector<double> acc_diffs;
+};
+
+class VoxelGridEngine
+{
+public:
+  VoxelGridEngine();
+  ~VoxelGridEngine();
+  VoxelGridEngine(const VoxelGridEngine &) = delete;
+  VoxelGridEngine & operator=(const VoxelGridEngine &) = delete;
+
+  // Start a cloud of point_num points with channel_num channels, the first 3 of which are x, y, z
+  bool begin(size_t point_num, size_t channel_num);
+
+  // Pinned host buffer of blockCapacity() points to fill with the channels of the next block,
+  // point after point. It waits until the previous copy from this buffer finishes
+  float * blockBuffer();
+  size_t blockCapacity() const;
+
+  // Copy the first point_num points of the block buffer to the device asynchronously. The next
+  // block is filled in the other pinned buffer while this one is copied
+  bool uploadBlock(size_t point_num);
+
+  // Compute the voxel keys, sort them and reduce each voxel. Return false on a CUDA error or
+  // if the voxel indices do not fit into a 64-bit key, in which case the CPU engines are used
+  bool reduce(float resolution, VoxelReduction & result);
+
+private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace autoware::pointcloud_divider::cuda
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__CUDA_VOXEL_GRID_ENGINE_HPP_
@@ -0,0 +1,124 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__DUPLICATE_FILTER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__DUPLICATE_FILTER_HPP_
+
+#include "grid_info.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Bits of each axis in the key of a quantized point
+constexpr int duplicate_key_bits = 21;
+
+// Key of the cube of size 1 / inv_resolution containing a point of a grid. The coordinates are
+// relative to the grid horizontally, and wrap around every 2^21 cubes vertically
+template <typename PointT>
+inline uint64_t duplicate_key(const PointT & p, const GridInfo<2> & grid, float inv_resolution)
+{
+  constexpr int64_t mask = (int64_t(1) << duplicate_key_bits) - 1;
+  int64_t qx = static_cast<int64_t>(std::floor((p.x - grid.ix) * inv_resolution));
+  int64_t qy = static_cast<int64_t>(std::floor((p.y - grid.iy) * inv_resolution));
+  int64_t qz = static_cast<int64_t>(std::floor(p.z * inv_resolution));
+
+  qx = std::clamp<int64_t>(qx, 0, mask);
+  qy = std::clamp<int64_t>(qy, 0, mask);
+
+  return (static_cast<uint64_t>(qx) << (2 * duplicate_key_bits)) |
+         (static_cast<uint64_t>(qy) << duplicate_key_bits) | static_cast<uint64_t>(qz & mask);
+}
+
+// Set of the keys of the points of a grid, in an open addressing table of 8 bytes per slot
+class DuplicateKeySet
+{
+public:
+  // Add a key, return false if it was already in the set
+  bool insert(uint64_t key)
+  {
+    if ((size_ + 1) * 10 > slots_.size() * 7) {
+      grow();
+    }
+
+    size_t mask = slots_.size() - 1;
+
+    for (size_t i = mix(key) & mask;; i = (i + 1) & mask) {
+      if (slots_[i] == empty_key) {
+        slots_[i] = key;
+        ++size_;
+        return true;
+      }
+
+      if (slots_[i] == key) {
+        return false;
+      }
+    }
+  }
+
+  // Remove all keys and release the memory
+  void clear()
+  {
+    std::vector<uint64_t>().swap(slots_);
+    size_ = 0;
+  }
+
+  void reserve(size_t key_num)
+  {
+    while (key_num * 10 > slots_.size() * 7) {
+      grow();
+    }
+  }
+
+  size_t size() const { return size_; }
+  size_t bytes() const { return slots_.capacity() * sizeof(uint64_t); }
+
+private:
+  // Keys have 63 bits, so they are never empty_key
+  static constexpr uint64_t empty_key = ~uint64_t(0);
+
+  static uint64_t mix(uint64_t key)
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+
+    return key;
+  }
+
+  void grow()
+  {
+    std::vector<uint64_t> old_slots(std::max<size_t>(64, slots_.size() * 2), empty_key);
+
+    old_slots.swap(slots_);
+    size_ = 0;
+
+    for (auto key : old_slots) {
+      if (key != empty_key) {
+        insert(key);
+      }
+    }
+  }
+
+  std::vector<uint64_t> slots_;
+  size_t size_ = 0;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__DUPLICATE_FILTER_HPP_
@@ -0,0 +1,184 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__GRID_HASH_MAP_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__GRID_HASH_MAP_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Map of the grids in an open addressing table with linear probing, so a lookup reads contiguous
+// slots instead of following the nodes of std::unordered_map. The slots are moved when the table
+// grows, so unlike std::unordered_map the references to the values do not stay valid. Hash must
+// mix the bits of the keys, e.g. GridKeyHash.
+template <typename Key, typename T, typename Hash>
+class GridHashMap
+{
+public:
+  typedef std::pair<Key, T> value_type;
+
+  template <typename MapT, typename ValueT>
+  class Iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ValueT value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef ValueT * pointer;
+    typedef ValueT & reference;
+
+    Iterator(MapT * map, size_t id) : map_(map), id_(id) { skipEmpty(); }
+
+    reference operator*() const { return map_->slots_[id_]; }
+    pointer operator->() const { return &map_->slots_[id_]; }
+
+    Iterator & operator++()
+    {
+      ++id_;
+      skipEmpty();
+      return *this;
+    }
+
+    friend bool operator==(const Iterator & one, const Iterator & other)
+    {
+      return one.id_ == other.id_;
+    }
+
+    friend bool operator!=(const Iterator & one, const Iterator & other)
+    {
+      return one.id_ != other.id_;
+    }
+
+  private:
+    void skipEmpty()
+    {
+      while (id_ < map_->used_.size() && !map_->used_[id_]) {
+        ++id_;
+      }
+    }
+
+    MapT * map_;
+    size_t id_;
+  };
+
+  typedef Iterator<GridHashMap, value_type> iterator;
+  typedef Iterator<const GridHashMap, const value_type> const_iterator;
+
+  // Value of a key, which is default constructed if the key is not in the map
+  T & operator[](const Key & key)
+  {
+    if ((size_ + 1) * 10 > slots_.size() * 7) {
+      grow();
+    }
+
+    size_t id = probe(key);
+
+    if (!used_[id]) {
+      used_[id] = 1;
+      slots_[id].first = key;
+      ++size_;
+    }
+
+    return slots_[id].second;
+  }
+
+  // Value of a key, or nullptr if the key is not in the map
+  T * find(const Key & key)
+  {
+    if (size_ == 0) {
+      return nullptr;
+    }
+
+    size_t id = probe(key);
+
+    return used_[id] ? &slots_[id].second : nullptr;
+  }
+
+  void reserve(size_t key_num)
+  {
+    while (key_num * 10 > slots_.size() * 7) {
+      grow();
+    }
+  }
+
+  // Remove all keys and release the memory
+  void clear()
+  {
+    std::vector<value_type>().swap(slots_);
+    std::vector<uint8_t>().swap(used_);
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Shard of a key when the keys are split into shard_num maps, which are then filled in parallel
+  // without a lock. The high bits of the hash are taken, since the low bits pick the slots
+  static size_t shardOf(const Key & key, size_t shard_num)
+  {
+    return static_cast<size_t>((static_cast<uint64_t>(Hash{}(key)) >> 32) % shard_num);
+  }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, slots_.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, slots_.size()); }
+
+private:
+  // Slot of the key, or the empty slot where it would be inserted
+  size_t probe(const Key & key) const
+  {
+    size_t mask = slots_.size() - 1;
+    size_t id = Hash{}(key) & mask;
+
+    while (used_[id] && !(slots_[id].first == key)) {
+      id = (id + 1) & mask;
+    }
+
+    return id;
+  }
+
+  void grow()
+  {
+    std::vector<value_type> old_slots(std::max<size_t>(64, slots_.size() * 2));
+    std::vector<uint8_t> old_used(old_slots.size(), 0);
+
+    old_slots.swap(slots_);
+    old_used.swap(used_);
+
+    for (size_t i = 0; i < old_slots.size(); ++i) {
+      if (old_used[i]) {
+        size_t id = probe(old_slots[i].first);
+
+        used_[id] = 1;
+        slots_[id] = std::move(old_slots[i]);
+      }
+    }
+  }
+
+  std::vector<value_type> slots_;
+  std::vector<uint8_t> used_;
+  size_t size_ = 0;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__GRID_HASH_MAP_HPP_
@@ -15,6 +15,9 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__GRID_INFO_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__GRID_INFO_HPP_
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <tuple>
@@ -110,4 +113,79 @@ autoware::pointcloud_divider::GridInfo<3> pointToGrid3(
   return autoware::pointcloud_divider::GridInfo<3>(x_id, y_id, z_id);
 }
 
+namespace autoware::pointcloud_divider
+{
+
+// Pack the indices of a 2D grid into a 64-bit key, which keeps all the bits of both indices
+inline uint64_t gridToKey2(const GridInfo<2> & grid)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(grid.ix)) << 32) |
+         static_cast<uint32_t>(grid.iy);
+}
+
+inline GridInfo<2> keyToGrid2(uint64_t key)
+{
+  int ix = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+  int iy = static_cast<int32_t>(static_cast<uint32_t>(key));
+
+  return GridInfo<2>(ix, iy);
+}
+
+// Hash of the packed keys. The bits are mixed by the finalizer of MurmurHash3, since the grid
+// indices are multiples of the grid size and their low bits are mostly the same.
+struct GridKeyHash
+{
+  size_t operator()(uint64_t key) const
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return static_cast<size_t>(key);
+  }
+};
+
+// Hash of the 3D grids for GridHashMap, whose probing needs the bits of std::hash to be mixed
+struct GridHash3
+{
+  size_t operator()(const GridInfo<3> & grid) const
+  {
+    return GridKeyHash{}(std::hash<GridInfo<3>>{}(grid));
+  }
+};
+
+// Number of points whose keys are computed at once, small enough to keep the keys in the L1 cache
+constexpr size_t grid_key_block_size = 1024;
+
+// Compute the packed 2D keys of num points, the same as pointToGrid2 and gridToKey2 do. The keys
+// of a block are computed in a loop of their own before they are hashed, so the arithmetic is not
+// interleaved with the lookups of the hash map.
+template <typename PointT>
+void pointsToGridKeys2(const PointT * points, size_t num, float res_x, float res_y, uint64_t * keys)
+{
+  for (size_t i = 0; i < num; ++i) {
+    int x_id = static_cast<int>(std::floor(points[i].x / res_x) * res_x);
+    int y_id = static_cast<int>(std::floor(points[i].y / res_y) * res_y);
+
+    keys[i] = (static_cast<uint64_t>(static_cast<uint32_t>(x_id)) << 32) |
+              static_cast<uint32_t>(y_id);
+  }
+}
+
+// Compute the 3D grids of num points, the same as pointToGrid3 does
+template <typename PointT>
+void pointsToGrid3(
+  const PointT * points, size_t num, float res_x, float res_y, float res_z, GridInfo<3> * grids)
+{
+  for (size_t i = 0; i < num; ++i) {
+    grids[i].ix = static_cast<int>(std::floor(points[i].x / res_x));
+    grids[i].iy = static_cast<int>(std::floor(points[i].y / res_y));
+    grids[i].iz = static_cast<int>(std::floor(points[i].z / res_z));
+  }
+}
+
+}  // namespace autoware::pointcloud_divider
+
 #endif  // AUTOWARE__POINTCLOUD_DIVIDER__GRID_INFO_HPP_
@@ -0,0 +1,118 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__MORTON_ORDER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__MORTON_ORDER_HPP_
+
+#include <pcl/point_cloud.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Number of bits of each axis in a 3D Morton key
+constexpr int morton_bits = 21;
+
+// Insert two zero bits between each of the lowest morton_bits bits of val
+inline uint64_t spread_bits3(uint64_t val)
+{
+  val &= (uint64_t(1) << morton_bits) - 1;
+  val = (val | val << 32) & 0x001F00000000FFFFull;
+  val = (val | val << 16) & 0x001F0000FF0000FFull;
+  val = (val | val << 8) & 0x100F00F00F00F00Full;
+  val = (val | val << 4) & 0x10C30C30C30C30C3ull;
+  val = (val | val << 2) & 0x1249249249249249ull;
+
+  return val;
+}
+
+// Interleave the bits of x, y, and z, x being the lowest
+inline uint64_t morton_key3(uint32_t x, uint32_t y, uint32_t z)
+{
+  return spread_bits3(x) | (spread_bits3(y) << 1) | (spread_bits3(z) << 2);
+}
+
+// Sort the points by the Morton (Z-order) keys of their coordinates, quantized to morton_bits bits
+// in cubic cells over the bounding box of the cloud. Points that are close in space are then close
+// in memory. Points with the same key keep their order
+template <typename PointT>
+void sortByMortonOrder(pcl::PointCloud<PointT> & cloud)
+{
+  if (cloud.size() < 2) {
+    return;
+  }
+
+  float min_pt[3] = {
+    std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+    std::numeric_limits<float>::max()};
+  float max_pt[3] = {
+    std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+    std::numeric_limits<float>::lowest()};
+
+  for (const auto & p : cloud) {
+    const float xyz[3] = {p.x, p.y, p.z};
+
+    for (int k = 0; k < 3; ++k) {
+      min_pt[k] = std::min(min_pt[k], xyz[k]);
+      max_pt[k] = std::max(max_pt[k], xyz[k]);
+    }
+  }
+
+  double extent = 0;
+
+  for (int k = 0; k < 3; ++k) {
+    extent = std::max(extent, static_cast<double>(max_pt[k]) - min_pt[k]);
+  }
+
+  const double max_cell = static_cast<double>((uint32_t(1) << morton_bits) - 1);
+  const double scale = (extent > 0) ? max_cell / extent : 0.0;
+  std::vector<std::pair<uint64_t, uint32_t>> keys(cloud.size());
+
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    const auto & p = cloud[i];
+    uint32_t cells[3];
+    const float xyz[3] = {p.x, p.y, p.z};
+
+    for (int k = 0; k < 3; ++k) {
+      double cell = (static_cast<double>(xyz[k]) - min_pt[k]) * scale;
+
+      cells[k] = static_cast<uint32_t>(std::min(std::max(cell, 0.0), max_cell));
+    }
+
+    keys[i] = std::make_pair(morton_key3(cells[0], cells[1], cells[2]), static_cast<uint32_t>(i));
+  }
+
+  // The indices break the ties, so the order is the same as that of a stable sort
+  std::sort(keys.begin(), keys.end());
+
+  pcl::PointCloud<PointT> sorted;
+
+  sorted.reserve(cloud.size());
+
+  for (const auto & key : keys) {
+    sorted.push_back(cloud[key.second]);
+  }
+
+  cloud.swap(sorted);
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__MORTON_ORDER_HPP_
@@ -0,0 +1,125 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__OUTLIER_FILTER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__OUTLIER_FILTER_HPP_
+
+#include <pcl/point_cloud.h>
+#include <pcl/search/kdtree.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace autoware::pointcloud_divider
+{
+
+// Statistical outlier removal of a tile, like pcl::StatisticalOutlierRemoval. The neighbors of
+// the points near the borders are also searched among the halo, the points of the neighboring
+// tiles, so a tile gives the same result as if it was filtered with the whole map around it
+template <typename PointT>
+class StatisticalOutlierFilter
+{
+  typedef pcl::PointCloud<PointT> PclCloudType;
+  typedef typename PclCloudType::Ptr PclCloudPtr;
+
+public:
+  void setMeanK(int mean_k) { mean_k_ = mean_k; }
+  void setStddevMult(double stddev_mult) { stddev_mult_ = stddev_mult; }
+  void setThreadNum(int thread_num) { thread_num_ = (thread_num > 1) ? thread_num : 1; }
+
+  // Remove the points of cloud whose mean distance to their mean_k nearest neighbors is above
+  // the mean of the cloud by more than stddev_mult standard deviations. The statistics are the
+  // ones of cloud only. Return the number of removed points
+  size_t filter(const PclCloudPtr & cloud, const PclCloudType & halo) const
+  {
+    size_t point_num = cloud->size();
+
+    if (mean_k_ <= 0 || point_num <= 1) {
+      return 0;
+    }
+
+    // The halo is appended to the cloud for the search only
+    cloud->insert(cloud->end(), halo.begin(), halo.end());
+
+    pcl::search::KdTree<PointT> tree(false);
+
+    tree.setInputCloud(cloud);
+
+    std::vector<float> distances(point_num);
+    size_t worker_num = std::min(thread_num_, point_num);
+    size_t chunk_size = (point_num + worker_num - 1) / worker_num;
+    std::vector<std::thread> workers;
+
+    workers.reserve(worker_num);
+
+    for (size_t wid = 0; wid < worker_num; ++wid) {
+      workers.emplace_back([&, wid]() {
+        size_t begin = wid * chunk_size;
+        size_t end = std::min(begin + chunk_size, point_num);
+        pcl::Indices indices(mean_k_ + 1);
+        std::vector<float> sqr_distances(mean_k_ + 1);
+
+        for (size_t pid = begin; pid < end; ++pid) {
+          // The first neighbor is the point itself
+          int found = tree.nearestKSearch(*cloud, pid, mean_k_ + 1, indices, sqr_distances);
+          double sum = 0.0;
+
+          for (int k = 1; k < found; ++k) {
+            sum += std::sqrt(sqr_distances[k]);
+          }
+
+          distances[pid] = (found > 1) ? sum / (found - 1) : 0.0f;
+        }
+      });
+    }
+
+    for (auto & worker : workers) {
+      worker.join();
+    }
+
+    double sum = 0.0, sq_sum = 0.0;
+
+    for (auto distance : distances) {
+      sum += distance;
+      sq_sum += distance * distance;
+    }
+
+    double mean = sum / point_num;
+    double variance = (sq_sum - sum * sum / point_num) / (point_num - 1);
+    double threshold = mean + stddev_mult_ * std::sqrt(std::max(variance, 0.0));
+    size_t kept_num = 0;
+
+    for (size_t pid = 0; pid < point_num; ++pid) {
+      if (distances[pid] <= threshold) {
+        (*cloud)[kept_num++] = (*cloud)[pid];
+      }
+    }
+
+    cloud->resize(kept_num);
+
+    return point_num - kept_num;
+  }
+
+private:
+  int mean_k_ = 0;
+  double stddev_mult_ = 1.0;
+  size_t thread_num_ = 1;
+};
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__OUTLIER_FILTER_HPP_
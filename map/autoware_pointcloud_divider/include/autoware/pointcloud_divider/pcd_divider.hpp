@@ -46,9 +46,18 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <list>
 #include <map>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -56,8 +65,12 @@
 #include <vector>
 
 #define PCL_NO_PRECOMPILE
+#include "duplicate_filter.hpp"
 #include "grid_info.hpp"
+#include "outlier_filter.hpp"
+#include "pcd_header.hpp"
 #include "pcd_io.hpp"
+#include "tile_index.hpp"
 
 #include <rclcpp/rclcpp.hpp>
 
@@ -74,14 +87,22 @@ class PCDDivider
 {
   typedef pcl::PointCloud<PointT> PclCloudType;
   typedef typename PclCloudType::Ptr PclCloudPtr;
-  typedef std::unordered_map<GridInfo<2>, std::tuple<PclCloudType, int, size_t>> GridMapType;
+  // Points of a grid, number of saved blocks, size at the last update of seg_by_size_, the time
+  // of the last point insertion, and the keys of the resident points to remove duplicates
+  typedef std::unordered_map<
+    GridInfo<2>, std::tuple<PclCloudType, int, size_t, size_t, DuplicateKeySet>>
+    GridMapType;
   typedef typename GridMapType::iterator GridMapItr;
+  // Points of the neighboring grids within the halo of a grid, and number of saved halo files
+  typedef std::unordered_map<GridInfo<2>, std::pair<PclCloudType, int>> HaloMapType;
   typedef std::multimap<size_t, GridMapItr> GridMapSizeType;
   typedef typename GridMapSizeType::iterator GridMapSizeItr;
 
 public:
   explicit PCDDivider(const rclcpp::Logger & logger) : logger_(logger) {}
 
+  ~PCDDivider() { stopWriter(); }
+
   // Functions to set input parameters
   void setInput(const std::string & input_pcd_or_dir) { input_pcd_or_dir_ = input_pcd_or_dir; }
 
@@ -115,6 +136,116 @@ public:
 
   void setDebugMode(bool mode) { debug_mode_ = mode; }
 
+  // Number of threads used to bin points into grids and to parse ascii inputs. 1 means serial
+  // processing
+  void setThreadNum(int thread_num)
+  {
+    thread_num_ = (thread_num > 1) ? thread_num : 1;
+    reader_.setThreadNum(thread_num_);
+  }
+
+  // Overlap reading input blocks, dividing points, and writing segments to the tmp directory
+  void setAsyncIO(bool use_async_io) { use_async_io_ = use_async_io; }
+
+  // Write the segments of the tmp directory and the appended tiles through io_uring, see
+  // AsyncFileWriter
+  void setIOUringWrite(bool use_io_uring) { use_io_uring_ = use_io_uring; }
+
+  // Save the output segments in the binary_compressed format
+  void setCompression(bool use_compression) { use_compression_ = use_compression; }
+
+  // Downsample segments with the sort-based engine of VoxelGridFilter
+  void setSortVoxelFilter(bool use_sort) { use_sort_voxel_filter_ = use_sort; }
+
+  // Downsample segments on the GPU when the package is built with POINTCLOUD_DIVIDER_USE_CUDA
+  void setCudaVoxelFilter(bool use_cuda) { use_cuda_voxel_filter_ = use_cuda; }
+
+  // Write segments directly to the output tiles instead of the tmp directory when possible.
+  // Without downsampling, points are appended to the tiles. With downsampling, segments that
+  // never left the memory are downsampled and saved without going through the tmp directory
+  void setDirectWrite(bool use_direct_write) { use_direct_write_ = use_direct_write; }
+
+  // Update an existing output instead of rebuilding it. Tiles touched by the input are
+  // replaced by the input points in them, other tiles and their metadata are kept
+  void setIncrementalUpdate(bool incremental) { incremental_update_ = incremental; }
+
+  // Limit the memory used by resident segments in MB instead of max_resident_point_num_.
+  // The memory reserved by the segment clouds is counted. 0 disables the byte budget
+  void setMemoryBudget(int budget_mb)
+  {
+    memory_budget_ = static_cast<size_t>(std::max(budget_mb, 0)) * 1024 * 1024;
+  }
+
+  // Estimate the points per grid from the given ratio of the input blocks before dividing, and
+  // reserve the clouds of the grids for their estimated points instead of a whole block.
+  // 0 disables the first pass
+  void setPresizeSampleRatio(double ratio) { presize_sample_ratio_ = std::min(ratio, 1.0); }
+
+  // How to choose the resident segment to be saved when the memory limit is reached.
+  // "largest": the segment with the most points, "lru": the least recently updated segment
+  void setSpillPolicy(const std::string & policy) { spill_policy_ = policy; }
+
+  // Period in seconds of the progress reports. 0 or negative disables them
+  void setProgressInterval(double interval) { progress_interval_ = interval; }
+
+  // Period in seconds of the checkpoints of the dividing phase. A checkpoint saves the resident
+  // segments to the tmp directory and records the divided input blocks, so that a killed run
+  // resumes from the last checkpoint. 0 or negative disables them
+  void setCheckpointInterval(double interval) { checkpoint_interval_ = interval; }
+
+  // Divide the map on several machines sharing the output directory. Every step runs on each of
+  // the shard_num workers, the next one starting when all workers finished the previous one.
+  // "divide": divide the inputs of the shard, balanced by their points, to OUTPUT_DIR/tmp.
+  // "merge": merge the segments of all shards of the tiles assigned to the shard.
+  // "finalize": combine the metadata and tile indices of the shards, on a single worker.
+  // "none": divide and merge everything in this process
+  void setShard(const std::string & mode, int shard_id, int shard_num)
+  {
+    shard_mode_ = mode;
+    shard_id_ = shard_id;
+    shard_num_ = shard_num;
+  }
+
+  // Save the JSON summary of the run to a file, in addition to the log
+  void setSummaryFile(const std::string & path) { summary_file_ = path; }
+
+  // Keep only the first of the points of a tile in the same cube of this size, e.g. the overlaps
+  // of survey passes. Duplicates are removed while dividing among the resident points of a
+  // segment, and among its saved parts when merging them. 0 or negative disables it
+  void setDuplicateResolution(double resolution) { duplicate_resolution_ = resolution; }
+
+  // Remove the points of each tile whose mean distance to their mean_k nearest neighbors is above
+  // the mean of the tile by more than stddev_mult standard deviations, before downsampling it.
+  // The neighbors are also searched among the points of the neighboring tiles within halo
+  // meters, which are saved with the segments while dividing. 0 or negative mean_k disables it
+  void setOutlierFilter(int mean_k, double stddev_mult, double halo)
+  {
+    outlier_mean_k_ = mean_k;
+    outlier_stddev_mult_ = stddev_mult;
+    outlier_halo_ = halo;
+  }
+
+  // Sort the points of each output tile by their 3D Morton keys before saving it, so that spatial
+  // lookups on the tiles have a good locality. The order is recorded in the tile index. Points
+  // are then not appended to the tiles by the direct write mode
+  void setMortonOrder(bool use_morton_order) { use_morton_order_ = use_morton_order; }
+
+  // Save the bounds, numbers of points, sizes and checksums of the tiles to
+  // pointcloud_map_index.bin, see tile_index.hpp
+  void setTileIndex(bool save_tile_index) { save_tile_index_ = save_tile_index; }
+
+  // Also save coarser levels of detail of the tiles, one per leaf size, to OUTPUT_DIR/lod_<leaf
+  // size>. Each level is downsampled from the previous one, so the leaf sizes must be larger
+  // than leaf_size_ and increasing. Non-positive leaf sizes are ignored
+  void setLodLeafSizes(const std::vector<double> & leaf_sizes) { lod_leaf_sizes_ = leaf_sizes; }
+
+  // Modify every block of points after it is read and before it is divided, e.g. to convert the
+  // map to another projection. With the async IO mode, it runs in the reading thread
+  void setPointTransform(const std::function<void(PclCloudType &)> & transform)
+  {
+    point_transform_ = transform;
+  }
+
   std::pair<double, double> getGridSize() const
   {
     return std::pair<double, double>(grid_size_x_, grid_size_y_);
@@ -127,6 +258,7 @@ private:
   std::string input_pcd_or_dir_, output_dir_, file_prefix_, config_file_;
 
   std::unordered_set<GridInfo<2>> grid_set_;
+  std::mutex grid_set_mtx_;  // Segments are merged by multiple threads
 
   // Params from yaml
   bool use_large_grid_ = false;
@@ -149,28 +281,229 @@ private:
   // Only 100 million points are allowed to reside in the main memory at max
   const size_t max_resident_point_num_ = 100000000;
   size_t resident_point_num_ = 0;
+  // Maximum number of points waiting in the write queue. In the async I/O mode, this is
+  // taken from the resident budget above, so the total stays under max_resident_point_num_
+  const size_t max_queued_point_num_ = 10000000;
+  // Number of resident points that triggers saving the biggest segment
+  size_t resident_limit_ = max_resident_point_num_;
+  // Byte budget of resident segments. 0 means the budget is given by resident_limit_
+  size_t memory_budget_ = 0;
+  size_t resident_byte_limit_ = 0;
+  std::string spill_policy_ = "largest";
+  // First pass that estimates the points per grid, see setPresizeSampleRatio
+  double presize_sample_ratio_ = 0.0;
+  const size_t presize_block_size_ = 4096;  // Points per sampled block
+  bool is_presized_ = false;
+  // Estimated points of the grids, minus the points saved from their clouds
+  std::unordered_map<GridInfo<2>, size_t> estimated_point_num_;
+  // Bytes reserved by the clouds of resident segments
+  size_t resident_bytes_ = 0;
+  // Incremented with every point insertion, used by the lru spill policy
+  size_t touch_time_ = 0;
+
+  // Spill statistics
+  size_t full_save_num_ = 0;       // Number of segments saved because they were full
+  size_t spill_num_ = 0;           // Number of segments saved to respect the memory limit
+  size_t spilled_point_num_ = 0;   // Number of points in the segments above
+  std::atomic<size_t> duplicate_point_num_{0};  // Removed by duplicate_resolution_
+  std::atomic<size_t> outlier_point_num_{0};    // Removed by the outlier filter
+  size_t peak_resident_bytes_ = 0;
+
+  // Phases whose elapsed time is reported. Phases that run on several threads add the time
+  // of every thread. The write phase covers all PCD writes, including those of spills.
+  // Checkpoints are counted as spills, and the outlier filter as downsampling
+  enum Phase { READ = 0, DIVIDE, SPILL, MERGE, DOWNSAMPLE, WRITE, PHASE_NUM };
+  std::array<std::atomic<int64_t>, PHASE_NUM> phase_ns_;
+  std::atomic<size_t> written_bytes_{0};
+  std::atomic<size_t> merged_seg_num_{0};
+  std::atomic<size_t> read_point_num_{0};  // Updated by the reading thread in async mode
+  size_t divided_point_num_ = 0;           // Points of the blocks given to dividePointCloud
+  size_t input_point_num_ = 0;             // Total number of points in the headers of the inputs
+  size_t seg_num_ = 0;
+  std::chrono::steady_clock::time_point start_time_, last_report_time_;
+  std::mutex report_mtx_;
+  double progress_interval_ = 10.0;
+  std::string summary_file_;
+
+  // Checkpoints of the dividing phase, see setCheckpointInterval
+  double checkpoint_interval_ = 0.0;
+  bool is_checkpointing_ = false;
+  std::chrono::steady_clock::time_point last_checkpoint_time_;
+  size_t checkpoint_num_ = 0;
+  // Position of the last checkpoint of a resumed run: index of the input file, and number of
+  // its blocks that were divided
+  size_t resume_file_id_ = 0;
+  size_t resume_block_num_ = 0;
+  // Counters of the segments saved before the last checkpoint of a resumed run
+  std::unordered_map<GridInfo<2>, int> resumed_counters_;
+
+  // Halos of the grids, see setOutlierFilter
+  HaloMapType halo_to_cloud_;
+
+  // Distributed run, see setShard
+  std::string shard_mode_ = "none";
+  int shard_id_ = 0;
+  int shard_num_ = 1;
+
   std::string tmp_dir_;
   CustomPCDReader<PointT> reader_;
   bool debug_mode_ = true;  // Print debug messages or not
+  size_t thread_num_ = 1;   // Number of threads to compute grid keys
+  bool use_async_io_ = false;
+  bool use_io_uring_ = false;
+  bool use_compression_ = false;
+  bool use_sort_voxel_filter_ = false;
+  bool use_cuda_voxel_filter_ = false;
+  bool use_direct_write_ = false;
+  bool incremental_update_ = false;
+  double duplicate_resolution_ = 0.0;
+  float inv_duplicate_resolution_ = 0.0f;
+  int outlier_mean_k_ = 0;
+  double outlier_stddev_mult_ = 1.0;
+  double outlier_halo_ = 1.0;
   rclcpp::Logger logger_;
 
+  // Writer thread and its bounded queue of segments to be saved
+  std::thread writer_thread_;
+  std::mutex write_mtx_;
+  std::condition_variable write_cv_;
+  // A job with an empty segment path appends the cloud to the output tile of the grid
+  std::deque<std::tuple<std::string, std::string, GridInfo<2>, PclCloudPtr>> write_queue_;
+  size_t queued_point_num_ = 0;
+  bool writer_stop_ = false;
+  // Writer of the segments with use_io_uring_, used by one thread at a time
+  CustomPCDWriter<PointT> seg_writer_;
+
+  // Writer and numbers of points of output tiles that points are appended to
+  CustomPCDWriter<PointT> tile_writer_;
+  std::unordered_map<GridInfo<2>, size_t> tile_point_num_;
+
+  // Bounds and numbers of points of the tiles written by this run, guarded by grid_set_mtx_.
+  // Sizes and checksums are computed from the files by writeTileIndex
+  bool save_tile_index_ = true;
+  bool use_morton_order_ = false;
+  std::unordered_map<GridInfo<2>, TileIndexRecord> tile_records_;
+
+  // Leaf sizes of the levels of detail, and their output directories
+  std::vector<double> lod_leaf_sizes_;
+  std::vector<std::string> lod_dirs_;
+
+  std::function<void(PclCloudType &)> point_transform_;
+
+  // Headers of the input files, scanned once and reused by later runs
+  std::unordered_map<std::string, PCDHeaderInfo> pcd_headers_;
+
   // Find all PCD files from the input path
   std::vector<std::string> discoverPCDs(const std::string & input);
+  // Read the headers of the files that are not in pcd_headers_ yet, in parallel
+  void scanHeaders(const std::vector<std::string> & pcd_names);
 
   std::string makeFileName(const GridInfo<2> & grid) const;
+  // Parse the name gx_gy of a segment folder
+  static GridInfo<2> parseGridName(const std::string & name)
+  {
+    auto underbar_pos = name.rfind("_");
+
+    return GridInfo<2>(
+      std::stoi(name.substr(0, underbar_pos)), std::stoi(name.substr(underbar_pos + 1)));
+  }
+  // Make the path to the output tile of the grid, and create its folder if necessary
+  std::string makeTilePath(const GridInfo<2> & grid, bool create_dir = true);
+  // Make the path to the tile of the grid at a level of detail, and create its folder
+  std::string makeLodTilePath(size_t level, const GridInfo<2> & grid);
+  // Sort the leaf sizes of the levels of detail and remove the invalid ones
+  void checkLodLeafSizes();
+  // True if segments are appended to the output tiles instead of the tmp directory
+  bool appendToTiles() const
+  {
+    return use_direct_write_ && leaf_size_ <= 0 && !use_compression_ && lod_leaf_sizes_.empty() &&
+           !use_morton_order_ && shard_mode_ != "divide" && duplicate_resolution_ <= 0 &&
+           outlier_mean_k_ <= 0;
+  }
+
+  // Exit if the shard parameters are invalid
+  void checkShardMode();
+  // Inputs divided by this shard. Files are assigned to the shard with the fewest points so far,
+  // from the largest one, so that every worker chooses the same files
+  std::vector<std::string> selectShardPCDs(const std::vector<std::string> & pcd_names);
+  // Shard merging the segments of a grid, the same on every worker
+  int shardOfGrid(const GridInfo<2> & grid) const;
+  // Merge step of a distributed run
+  void mergeShard();
+  // Final step of a distributed run
+  void finalizeShards();
 
   PclCloudPtr loadPCD(const std::string & pcd_name);
   void savePCD(const std::string & pcd_name, const pcl::PointCloud<PointT> & cloud);
+  // Fill estimated_point_num_ from a sample of the input blocks
+  void estimateGridPointNum(const std::vector<std::string> & pcd_names);
+  // Points to reserve for the cloud of a grid
+  size_t reservedPointNum(const GridInfo<2> & grid) const;
   void dividePointCloud(const PclCloudPtr & cloud_ptr);
+  void dividePointCloudParallel(const PclCloudPtr & cloud_ptr);
+  GridMapItr findOrCreateGrid(const GridInfo<2> & grid);
+  // Return false if the point is removed as a duplicate
+  bool addPointToGrid(GridMapItr & grid_it, const PointT & p);
+  // Remove the points of a grid in the same cubes as earlier points. Return the removed points
+  size_t removeDuplicates(const GridInfo<2> & grid, PclCloudType & cloud) const;
+  // Add a point of a grid to the halos of the neighboring grids within outlier_halo_
+  void addPointToHalos(const GridInfo<2> & grid, const PointT & p);
+  // Save the halo points of a grid to halo_<counter>_<number of points>.pcd in its segment folder
+  void saveHalo(typename HaloMapType::iterator halo_it);
+  bool isOverMemoryLimit() const;
+  // Save a resident segment chosen by the spill policy
+  void spillSegment();
+  // Bytes reserved by a cloud
+  static size_t reservedBytes(const PclCloudType & cloud)
+  {
+    return cloud.points.capacity() * sizeof(PointT);
+  }
   void paramInitialize();
+  std::string checkpointPath() const { return tmp_dir_ + "checkpoint.yaml"; }
+  // Restore the position of the checkpoint left by a killed run on the same inputs, and remove
+  // the segments saved after it. Return false if there is no valid checkpoint
+  bool loadCheckpoint(const std::vector<std::string> & pcd_names);
+  // Save all resident segments and record that the first block_num blocks of the file are divided
+  void saveCheckpoint(
+    const std::vector<std::string> & pcd_names, size_t file_id, size_t block_num);
+  // Save a checkpoint if checkpoint_interval_ has passed since the last one
+  void checkpointIfDue(
+    const std::vector<std::string> & pcd_names, size_t file_id, size_t block_num);
+  // Add the time elapsed since start to a phase
+  void addPhaseTime(Phase phase, const std::chrono::steady_clock::time_point & start);
+  // Log the progress if progress_interval_ has passed since the last report
+  void reportProgress();
+  // Log the statistics of the run in JSON, and save them to summary_file_ if it is set
+  void reportSummary();
   void saveGridInfoToYAML(const std::string & yaml_file_path);
-  void checkOutputDirectoryValidity();
+  void loadGridInfoFromYAML(const std::string & yaml_file_path);
+  // Add the points of a cloud to the record of its tile
+  void updateTileRecord(const GridInfo<2> & grid, const PclCloudType & cloud);
+  void writeTileIndex(const std::string & index_file_path);
+  // Clean the output and tmp directories, except when the run resumes from a checkpoint
+  void checkOutputDirectoryValidity(bool resume = false);
 
   void saveGridPCD(GridMapItr & grid_it);
+  // Downsample the cloud if needed, and save it as the output tile of the grid
+  void saveTile(const GridInfo<2> & grid, PclCloudPtr cloud, size_t filter_thread_num);
+  void appendToTile(const GridInfo<2> & grid, const PclCloudType & cloud);
+  void finalizeTiles();
+  void writeSegment(
+    const std::string & seg_path, const std::string & file_path, const PclCloudType & cloud);
+  void startWriter();
+  void stopWriter();
+  // Wait until the writer thread saved all queued segments
+  void waitWriter();
+  void enqueueWrite(
+    const std::string & seg_path, const std::string & file_path, const GridInfo<2> & grid,
+    const PclCloudPtr & cloud_ptr);
   void saveTheRest();
   void mergeAndDownsample();
+  // Merge the segment files of a grid, which are in several folders for a distributed run.
+  // halo_list has the files of the halo of the grid, used by the outlier filter
   void mergeAndDownsample(
-    const std::string & dir_path, std::list<std::string> & pcd_list, size_t total_point_num);
+    const std::vector<std::string> & dir_paths, std::list<std::string> & pcd_list,
+    const std::list<std::string> & halo_list, size_t total_point_num, size_t filter_thread_num);
 };
 
 }  // namespace autoware::pointcloud_divider
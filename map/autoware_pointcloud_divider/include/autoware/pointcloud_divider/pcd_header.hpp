@@ -0,0 +1,140 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__PCD_HEADER_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__PCD_HEADER_HPP_
+
+#include "utility.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Header-only scan of PCD files, so that the numbers of points and the layouts of many inputs are
+// known before any of them is read
+namespace autoware::pointcloud_divider
+{
+
+struct PCDHeaderInfo
+{
+  std::string path;
+  bool valid = false;  // False if the file cannot be opened or has no DATA line
+  size_t point_num = 0;
+  std::vector<std::string> field_names;
+  std::vector<size_t> field_sizes;
+  std::vector<std::string> field_types;
+  std::string data_type;  // ascii, binary or binary_compressed
+  size_t file_size = 0;
+};
+
+// Read the header of a PCD file. Unlike CustomPCDReader, an invalid file does not stop the
+// program, and info.valid is set to false instead
+inline bool readPCDHeader(const std::string & path, PCDHeaderInfo & info)
+{
+  info = PCDHeaderInfo();
+  info.path = path;
+
+  std::ifstream file(path);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::string line;
+  std::vector<std::string> vals;
+
+  try {
+    while (std::getline(file, line)) {
+      if (line.empty() || util::split(line, " ", vals) == 0 || vals[0] == "#") {
+        continue;
+      }
+
+      if (vals[0] == "FIELDS") {
+        for (size_t i = 1; i < vals.size(); ++i) {
+          info.field_names.push_back(util::trim(vals[i]));
+        }
+      } else if (vals[0] == "SIZE") {
+        for (size_t i = 1; i < vals.size(); ++i) {
+          info.field_sizes.push_back(std::stoi(vals[i]));
+        }
+      } else if (vals[0] == "TYPE") {
+        for (size_t i = 1; i < vals.size(); ++i) {
+          info.field_types.push_back(util::trim(vals[i]));
+        }
+      } else if (vals[0] == "POINTS") {
+        // The same count as CustomPCDReader::point_num
+        info.point_num = std::stoul(vals[1]);
+      } else if (vals[0] == "DATA") {
+        info.data_type = util::trim(vals[1]);
+        info.valid = true;
+
+        break;
+      }
+    }
+  } catch (...) {
+    info.valid = false;
+  }
+
+  std::error_code ec;
+
+  info.file_size = std::filesystem::file_size(path, ec);
+
+  if (ec) {
+    info.file_size = 0;
+  }
+
+  return info.valid;
+}
+
+// Read the headers of the files with up to thread_num threads. The results are in the same order
+// as the paths
+inline std::vector<PCDHeaderInfo> scanPCDHeaders(
+  const std::vector<std::string> & paths, size_t thread_num)
+{
+  std::vector<PCDHeaderInfo> infos(paths.size());
+  std::atomic<size_t> next_file(0);
+
+  auto worker = [&]() {
+    for (size_t fid = next_file++; fid < paths.size(); fid = next_file++) {
+      readPCDHeader(paths[fid], infos[fid]);
+    }
+  };
+
+  // Scanning is bound by the latency of opening the files, so more threads than files are useless
+  thread_num = std::min(std::max<size_t>(thread_num, 1), std::max<size_t>(paths.size(), 1));
+
+  std::vector<std::thread> workers;
+
+  for (size_t i = 1; i < thread_num; ++i) {
+    workers.emplace_back(worker);
+  }
+
+  worker();
+
+  for (auto & w : workers) {
+    w.join();
+  }
+
+  return infos;
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__PCD_HEADER_HPP_
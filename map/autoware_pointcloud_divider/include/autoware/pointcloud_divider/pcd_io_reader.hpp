@@ -56,13 +56,25 @@
 
 #include "utility.hpp"
 
+#include <pcl/io/lzf.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace autoware::pointcloud_divider
@@ -81,6 +93,9 @@ public:
   CustomPCDReader()
   {
     buffer_ = nullptr;
+    map_ = nullptr;
+    map_size_ = 0;
+    compressed_ = false;
     clear();
   }
 
@@ -88,13 +103,30 @@ public:
   void setInput(const std::string & pcd_path);
   // Read a block of points from the input stream
   size_t readABlock(PclCloudType & output);
+  // Skip a block of points without converting them, e.g. to sample the input. Mapped and
+  // compressed files skip it for free, binary files seek over it. Return the skipped points
+  size_t skipABlock();
 
   // Get path to the current opening PCD
   const std::string & get_path() const { return pcd_path_; }
 
   void setBlockSize(size_t block_size) { block_size_ = block_size; }
 
-  bool good() { return file_.good(); }
+  // Read binary and ascii PCDs through a memory-mapped view of the file instead of std::ifstream.
+  // Takes effect from the next setInput
+  void setMmapMode(bool use_mmap) { use_mmap_ = use_mmap; }
+
+  // Number of threads parsing a block of a mapped ascii PCD. 1 means serial parsing
+  void setThreadNum(size_t thread_num) { thread_num_ = std::max<size_t>(thread_num, 1); }
+
+  bool good()
+  {
+    if (map_ || compressed_) {
+      return loaded_point_num_ < point_num_;
+    }
+
+    return file_.good();
+  }
 
   size_t point_num()
   {
@@ -113,6 +145,34 @@ private:
 
   size_t readABlockBinary(std::ifstream & input, PclCloudType & output);
   size_t readABlockASCII(std::ifstream & input, PclCloudType & output);
+  size_t readABlockMapped(PclCloudType & output);
+  size_t readABlockMappedASCII(PclCloudType & output);
+  size_t readABlockCompressed(PclCloudType & output);
+
+  // Find the next line_num lines of a mapped ascii PCD. The offsets of the first line of every
+  // chunk_line_num lines and of the end of the last line are stored in ascii_chunks_. Return the
+  // number of found lines, which is less than line_num if the file ends before
+  size_t scanLinesASCII(size_t line_num, size_t chunk_line_num);
+
+  // Convert point_num points stored one after another from src, using the fastest way allowed
+  // by the layout of the file
+  void readPoints(const char * src, size_t point_num, PointT * output);
+
+  // Read and decompress the binary_compressed data section of the opening file
+  void readCompressedData(std::ifstream & input);
+
+  // Map the data section of the opening file. Return false if the file cannot be mapped
+  bool mapFile(size_t data_offset);
+  void unmapFile()
+  {
+    if (map_) {
+      munmap(map_, map_size_);
+    }
+
+    map_ = nullptr;
+    map_size_ = 0;
+    data_ = nullptr;
+  }
 
   void clear()
   {
@@ -127,6 +187,10 @@ private:
     point_num_ = 0;
     loaded_point_num_ = 0;
     binary_ = true;
+    compressed_ = false;
+    std::vector<char>().swap(decompressed_);
+    soa_loc_.clear();
+    soa_strides_.clear();
 
     if (file_.is_open()) {
       file_.close();
@@ -141,6 +205,13 @@ private:
 
     buffer_ = nullptr;
     block_size_ = 30000000;
+
+    unmapFile();
+    ascii_pos_ = 0;
+    ascii_chunks_.clear();
+    ascii_token_fields_.clear();
+    same_layout_ = false;
+    same_field_sizes_ = false;
   }
 
   // Metadata
@@ -158,6 +229,7 @@ private:
   // Number of points loaded so far, reset every time setInput is called
   size_t loaded_point_num_;
   bool binary_;                   // Data: true: binary, false: ascii
+  bool compressed_;               // Data: binary_compressed
   std::ifstream file_;            // Input stream of the PCD file
   size_t block_size_ = 30000000;  // Number of points to read in each readABlock
   size_t point_size_, read_size_;
@@ -165,6 +237,23 @@ private:
   std::string pcd_path_;            // Path to the current opening PCD
   std::vector<size_t> read_loc_;    // Locations to read fields of a point
   std::vector<size_t> read_sizes_;  // Sizes of fields of a point
+  bool use_mmap_ = true;            // Map PCDs to memory instead of streaming them
+  char * map_;                      // Start of the mapped file, nullptr if not mapped
+  size_t map_size_;                 // Size of the mapped region
+  const char * data_ = nullptr;     // Start of the point data in the mapped region
+  bool same_layout_ = false;        // True if points on disk have the same layout as PointT
+  bool same_field_sizes_ = false;   // True if all fields of PointT are stored with their sizes
+  // Decompressed data of a binary_compressed PCD. Fields are stored one after another
+  // (all x, then all y, ...) instead of point by point
+  std::vector<char> decompressed_;
+  std::vector<size_t> soa_loc_;      // Locations of fields of PointT in decompressed_
+  std::vector<size_t> soa_strides_;  // Distances between two consecutive values of a field
+  size_t thread_num_ = 1;            // Number of threads parsing mapped ascii PCDs
+  // Mapped ascii PCDs. The offset of the next line from data_, the chunks of lines parsed by the
+  // threads, and the field of PointT of each value of a line (INVALID_LOC_ if it is dropped)
+  size_t ascii_pos_ = 0;
+  std::vector<size_t> ascii_chunks_;
+  std::vector<size_t> ascii_token_fields_;
 };
 
 template <typename PointT>
@@ -183,6 +272,136 @@ void CustomPCDReader<PointT>::setInput(const std::string & pcd_path)
 
   pcd_path_ = pcd_path;
   readHeader(file_);
+
+  if (compressed_) {
+    readCompressedData(file_);
+  } else if (use_mmap_ && point_size_ > 0 && file_) {
+    // The stream is now at the beginning of the point data
+    auto data_offset = static_cast<size_t>(file_.tellg());
+
+    if (mapFile(data_offset)) {
+      // Points are read directly from the mapped pages, so the read buffer is not needed
+      delete[] buffer_;
+      buffer_ = nullptr;
+    }
+  }
+}
+
+// Check if points on disk can be copied to PointT as they are (all fields of PointT are
+// stored at the same offsets as in PointT, and a point on disk has the same size as PointT)
+template <typename PointT>
+inline bool isSameLayout(
+  const std::vector<size_t> & read_loc, const std::vector<size_t> & read_sizes,
+  size_t point_size)
+{
+  typedef util::FieldLayout<PointT> Layout;
+
+  if (point_size != sizeof(PointT) || read_loc.size() != Layout::field_num) {
+    return false;
+  }
+
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    if (read_loc[k] != Layout::offsets[k] || read_sizes[k] != Layout::sizes[k]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Check if all fields of PointT are stored with their sizes in PointT, so that gatherPoints can be
+// used
+template <typename PointT>
+inline bool hasSameFieldSizes(const std::vector<size_t> & read_sizes)
+{
+  typedef util::FieldLayout<PointT> Layout;
+
+  if (read_sizes.size() != Layout::field_num) {
+    return false;
+  }
+
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    if (read_sizes[k] != Layout::sizes[k]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Copy point_num points to output. base[k] is the location of field k of the first point, and
+// two consecutive values of field k are strides[k] bytes apart. The number of fields and their
+// offsets in PointT are compile-time constants, so the loop over fields is unrolled and the
+// field metadata is not looked up for every point
+template <typename PointT>
+inline void gatherPoints(
+  const std::array<const char *, util::FieldLayout<PointT>::field_num> & base,
+  const std::array<size_t, util::FieldLayout<PointT>::field_num> & strides, size_t point_num,
+  PointT * output)
+{
+  typedef util::FieldLayout<PointT> Layout;
+
+  for (size_t i = 0; i < point_num; ++i) {
+    char * dst = reinterpret_cast<char *>(output + i);
+
+    for (size_t k = 0; k < Layout::field_num; ++k) {
+      memcpy(dst + Layout::offsets[k], base[k] + i * strides[k], Layout::sizes[k]);
+    }
+  }
+}
+
+template <typename PointT>
+bool CustomPCDReader<PointT>::mapFile(size_t data_offset)
+{
+  int fd = open(pcd_path_.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat file_stat;
+
+  if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) <= data_offset) {
+    close(fd);
+    return false;
+  }
+
+  map_size_ = file_stat.st_size;
+
+  void * map = mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  // The mapping stays valid after the descriptor is closed
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    map_size_ = 0;
+    return false;
+  }
+
+  // Points are consumed from the beginning to the end, so let the kernel read ahead
+  madvise(map, map_size_, MADV_SEQUENTIAL);
+
+  map_ = static_cast<char *>(map);
+  data_ = map_ + data_offset;
+
+  // Lines of ascii files have no fixed length, so their number is checked while they are read
+  if (!binary_) {
+    return true;
+  }
+
+  // Do not read beyond the end of the file if the header claims more points than it has
+  size_t available_point_num = (map_size_ - data_offset) / point_size_;
+
+  if (available_point_num < point_num_) {
+    fprintf(
+      stderr,
+      "[%s, %d] %s::Warning: The file has only %lu points while the header has %lu points. File "
+      "%s\n",
+      __FILE__, __LINE__, __func__, available_point_num, point_num_, pcd_path_.c_str());
+    point_num_ = available_point_num;
+  }
+
+  return true;
 }
 
 template <typename PointT>
@@ -191,6 +410,49 @@ size_t CustomPCDReader<PointT>::readABlock(PclCloudType & output)
   return readABlock(file_, output);
 }
 
+template <typename PointT>
+size_t CustomPCDReader<PointT>::skipABlock()
+{
+  size_t skip_num = std::min(block_size_, point_num_ - loaded_point_num_);
+
+  if (map_ && !binary_) {
+    // The lines are found without being parsed
+    skip_num = scanLinesASCII(skip_num, std::max<size_t>(skip_num, 1));
+    ascii_pos_ = ascii_chunks_.back();
+    loaded_point_num_ += skip_num;
+
+    return skip_num;
+  }
+
+  if (map_ || compressed_) {
+    loaded_point_num_ += skip_num;
+
+    return skip_num;
+  }
+
+  if (binary_) {
+    if (!file_) {
+      return 0;
+    }
+
+    file_.seekg(skip_num * point_size_, std::ios_base::cur);
+    loaded_point_num_ += skip_num;
+
+    if (loaded_point_num_ == point_num_) {
+      file_.setstate(std::ios_base::eofbit);
+    }
+
+    return skip_num;
+  }
+
+  // Lines of ascii files have no fixed length
+  PclCloudType skipped;
+
+  readABlockASCII(file_, skipped);
+
+  return skipped.size();
+}
+
 // Build the location vectors for reading binary points
 template <typename PointT>
 inline void buildReadMetadata(
@@ -203,6 +465,11 @@ template <typename PointT>
 inline void buildReadMetadataASCII(
   std::vector<std::string> & field_names, std::vector<size_t> & read_loc);
 
+// Warn about the fields of the file that PointT does not have. They are not written to the output
+template <typename PointT>
+inline void warnDroppedFields(
+  const std::vector<std::string> & field_names, const std::string & pcd_path);
+
 template <typename PointT>
 void CustomPCDReader<PointT>::readHeader(std::ifstream & input)
 {
@@ -335,6 +602,7 @@ void CustomPCDReader<PointT>::readHeader(std::ifstream & input)
 
       if (vals[0] == "DATA") {
         binary_ = vals[1].find("binary") != std::string::npos;
+        compressed_ = util::trim(vals[1]) == "binary_compressed";
 
         break;
       }
@@ -369,9 +637,27 @@ void CustomPCDReader<PointT>::readHeader(std::ifstream & input)
     // Construct read loc and read size, used to read data from files to points
     if (binary_) {
       buildReadMetadata<PointT>(field_names_, field_sizes_, field_counts_, read_loc_, read_sizes_);
+
+      // Choose how points are converted, once for the whole file
+      same_layout_ = isSameLayout<PointT>(read_loc_, read_sizes_, point_size_);
+      same_field_sizes_ = hasSameFieldSizes<PointT>(read_sizes_);
     } else {
       buildReadMetadataASCII<PointT>(field_names_, read_loc_);
+
+      for (size_t k = 0; k < read_loc_.size(); ++k) {
+        if (read_loc_[k] == INVALID_LOC_) {
+          continue;
+        }
+
+        if (ascii_token_fields_.size() <= read_loc_[k]) {
+          ascii_token_fields_.resize(read_loc_[k] + 1, INVALID_LOC_);
+        }
+
+        ascii_token_fields_[read_loc_[k]] = k;
+      }
     }
+
+    warnDroppedFields<PointT>(field_names_, pcd_path_);
   }
 }
 
@@ -411,16 +697,17 @@ inline void setFieldReadMetadata(
   read_loc = INVALID_LOC_;
 }
 
-template <>
-inline void buildReadMetadata<pcl::PointXYZ>(
+template <typename PointT>
+inline void buildReadMetadata(
   std::vector<std::string> & field_names, std::vector<size_t> & field_sizes,
   std::vector<size_t> & field_counts, std::vector<size_t> & read_loc,
   std::vector<size_t> & read_sizes)
 {
+  typedef util::FieldLayout<PointT> Layout;
   size_t field_num = field_names.size();
 
-  read_loc.resize(3);
-  read_sizes.resize(3);
+  read_loc.resize(Layout::field_num);
+  read_sizes.resize(Layout::field_num);
 
   std::vector<size_t> tmp_read_loc(field_num);
 
@@ -430,104 +717,81 @@ inline void buildReadMetadata<pcl::PointXYZ>(
     tmp_read_loc[i + 1] = field_sizes[i] * field_counts[i] + tmp_read_loc[i];
   }
 
-  // Find field x, y, z
-  setFieldReadMetadata("x", field_names, field_sizes, tmp_read_loc, read_loc[0], read_sizes[0]);
-  setFieldReadMetadata("y", field_names, field_sizes, tmp_read_loc, read_loc[1], read_sizes[1]);
-  setFieldReadMetadata("z", field_names, field_sizes, tmp_read_loc, read_loc[2], read_sizes[2]);
+  // Find the fields of PointT
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    setFieldReadMetadata(
+      Layout::names[k], field_names, field_sizes, tmp_read_loc, read_loc[k], read_sizes[k]);
+  }
 }
 
-template <>
-inline void buildReadMetadata<pcl::PointXYZI>(
-  std::vector<std::string> & field_names, std::vector<size_t> & field_sizes,
-  std::vector<size_t> & field_counts, std::vector<size_t> & read_loc,
-  std::vector<size_t> & read_sizes)
+template <typename PointT>
+inline void buildReadMetadataASCII(
+  std::vector<std::string> & field_names, std::vector<size_t> & read_loc)
 {
-  size_t field_num = field_names.size();
-
-  read_loc.resize(4);
-  read_sizes.resize(4);
-
-  std::vector<size_t> tmp_read_loc(field_num);
+  typedef util::FieldLayout<PointT> Layout;
 
-  tmp_read_loc[0] = 0;
+  read_loc.resize(Layout::field_num);
 
-  for (size_t i = 0; i < field_num - 1; ++i) {
-    tmp_read_loc[i + 1] = field_sizes[i] * field_counts[i] + tmp_read_loc[i];
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    setFieldReadMetadata(Layout::names[k], field_names, read_loc[k]);
   }
-
-  // Find field x, y, z, intensity
-  setFieldReadMetadata("x", field_names, field_sizes, tmp_read_loc, read_loc[0], read_sizes[0]);
-  setFieldReadMetadata("y", field_names, field_sizes, tmp_read_loc, read_loc[1], read_sizes[1]);
-  setFieldReadMetadata("z", field_names, field_sizes, tmp_read_loc, read_loc[2], read_sizes[2]);
-  setFieldReadMetadata(
-    "intensity", field_names, field_sizes, tmp_read_loc, read_loc[3], read_sizes[3]);
 }
 
-template <>
-inline void buildReadMetadataASCII<pcl::PointXYZ>(
-  std::vector<std::string> & field_names, std::vector<size_t> & read_loc)
+template <typename PointT>
+inline void warnDroppedFields(
+  const std::vector<std::string> & field_names, const std::string & pcd_path)
 {
-  read_loc.resize(3);
+  typedef util::FieldLayout<PointT> Layout;
+  std::string dropped_fields;
 
-  setFieldReadMetadata("x", field_names, read_loc[0]);
-  setFieldReadMetadata("y", field_names, read_loc[1]);
-  setFieldReadMetadata("z", field_names, read_loc[2]);
-}
+  for (const auto & name : field_names) {
+    // Skip the padding
+    if (name == "_") {
+      continue;
+    }
 
-template <>
-inline void buildReadMetadataASCII<pcl::PointXYZI>(
-  std::vector<std::string> & field_names, std::vector<size_t> & read_loc)
-{
-  read_loc.resize(4);
+    if (std::find(Layout::names.begin(), Layout::names.end(), name) == Layout::names.end()) {
+      dropped_fields += " " + name;
+    }
+  }
 
-  setFieldReadMetadata("x", field_names, read_loc[0]);
-  setFieldReadMetadata("y", field_names, read_loc[1]);
-  setFieldReadMetadata("z", field_names, read_loc[2]);
-  setFieldReadMetadata("intensity", field_names, read_loc[3]);
+  if (!dropped_fields.empty()) {
+    fprintf(
+      stderr,
+      "[%s, %d] %s::Warning: Fields%s are not in the point type, and will be dropped. File %s\n",
+      __FILE__, __LINE__, __func__, dropped_fields.c_str(), pcd_path.c_str());
+  }
 }
 
+// Copy the fields of a point on disk at input to output. A field that is not in the file has a
+// read size of 0, and is left as it is
 template <typename PointT>
 inline void parsePoint(
-  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc, PointT & output);
-
-template <>
-inline void parsePoint(
-  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc,
-  pcl::PointXYZ & output)
+  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc, PointT & output)
 {
-  memcpy(&(output.x), input + loc[0], rsize[0]);
-  memcpy(&(output.y), input + loc[1], rsize[1]);
-  memcpy(&(output.z), input + loc[2], rsize[2]);
-}
+  typedef util::FieldLayout<PointT> Layout;
+  char * dst = reinterpret_cast<char *>(&output);
 
-template <>
-inline void parsePoint(
-  const char * input, std::vector<size_t> & rsize, std::vector<size_t> & loc,
-  pcl::PointXYZI & output)
-{
-  memcpy(&(output.x), input + loc[0], rsize[0]);
-  memcpy(&(output.y), input + loc[1], rsize[1]);
-  memcpy(&(output.z), input + loc[2], rsize[2]);
-  memcpy(&(output.intensity), input + loc[3], rsize[3]);
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    memcpy(dst + Layout::offsets[k], input + loc[k], std::min(rsize[k], Layout::sizes[k]));
+  }
 }
 
 template <typename PointT>
 size_t CustomPCDReader<PointT>::readABlockBinary(std::ifstream & input, PclCloudType & output)
 {
   output.clear();
-  output.reserve(block_size_);
-
-  PointT p;
 
   if (input) {
     input.read(buffer_, read_size_);
 
     // Parse the buffer and convert to point
-    for (int i = 0; i < input.gcount() && loaded_point_num_ < point_num_;
-         i += point_size_, ++loaded_point_num_) {
-      parsePoint(buffer_ + i, read_sizes_, read_loc_, p);
-      output.push_back(p);
-    }
+    size_t proc_num =
+      std::min(static_cast<size_t>(input.gcount()) / point_size_, point_num_ - loaded_point_num_);
+
+    output.resize(proc_num);
+    readPoints(buffer_, proc_num, output.points.data());
+    loaded_point_num_ += proc_num;
 
     if (loaded_point_num_ == point_num_) {
       input.setstate(std::ios_base::eofbit);
@@ -540,31 +804,166 @@ size_t CustomPCDReader<PointT>::readABlockBinary(std::ifstream & input, PclCloud
 }
 
 template <typename PointT>
-void parsePoint(const std::string & point_line, const std::vector<size_t> & loc, PointT & output);
-
-template <>
 inline void parsePoint(
-  const std::string & point_line, const std::vector<size_t> & loc, pcl::PointXYZ & output)
+  const std::string & point_line, const std::vector<size_t> & loc, PointT & output)
 {
+  typedef util::FieldLayout<PointT> Layout;
   std::vector<std::string> vals;
+  char * dst = reinterpret_cast<char *>(&output);
 
   util::split(point_line, " ", vals);
-  output.x = (loc[0] != INVALID_LOC_) ? std::stof(vals[loc[0]]) : 0;
-  output.y = (loc[1] != INVALID_LOC_) ? std::stof(vals[loc[1]]) : 0;
-  output.z = (loc[2] != INVALID_LOC_) ? std::stof(vals[loc[2]]) : 0;
+
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    if (loc[k] != INVALID_LOC_) {
+      // Packed colors are written as uint32 to ascii files, despite their float type
+      char type = util::is_color_field(Layout::names[k]) ? 'U' : Layout::types[k];
+
+      util::parse_field(vals[loc[k]], type, Layout::sizes[k], dst + Layout::offsets[k]);
+    } else {
+      memset(dst + Layout::offsets[k], 0, Layout::sizes[k]);
+    }
+  }
 }
 
-template <>
-inline void parsePoint(
-  const std::string & point_line, const std::vector<size_t> & loc, pcl::PointXYZI & output)
+// Parse a line [begin, end) of an ascii PCD without allocating. The i-th value of the line is
+// stored in the field token_fields[i] of output, and the fields that are not in the line are set to
+// 0. Return false if a value is missing or is not a number
+template <typename PointT>
+inline bool parsePoint(
+  const char * begin, const char * end, const std::vector<size_t> & token_fields, PointT & output)
 {
-  std::vector<std::string> vals;
+  typedef util::FieldLayout<PointT> Layout;
+  char * dst = reinterpret_cast<char *>(&output);
+  auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
 
-  util::split(point_line, " ", vals);
-  output.x = (loc[0] != INVALID_LOC_) ? std::stof(vals[loc[0]]) : 0;
-  output.y = (loc[1] != INVALID_LOC_) ? std::stof(vals[loc[1]]) : 0;
-  output.z = (loc[2] != INVALID_LOC_) ? std::stof(vals[loc[2]]) : 0;
-  output.intensity = (loc[3] != INVALID_LOC_) ? std::stof(vals[loc[3]]) : 0;
+  util::zero_point(output);
+
+  for (size_t i = 0; i < token_fields.size(); ++i) {
+    while (begin < end && is_space(*begin)) {
+      ++begin;
+    }
+
+    const char * token_end = begin;
+
+    while (token_end < end && !is_space(*token_end)) {
+      ++token_end;
+    }
+
+    if (token_end == begin) {
+      return false;
+    }
+
+    size_t k = token_fields[i];
+
+    if (k != INVALID_LOC_) {
+      // Packed colors are written as uint32 to ascii files, despite their float type
+      char type = util::is_color_field(Layout::names[k]) ? 'U' : Layout::types[k];
+
+      if (!util::parse_field(begin, token_end, type, Layout::sizes[k], dst + Layout::offsets[k])) {
+        return false;
+      }
+    }
+
+    begin = token_end;
+  }
+
+  return true;
+}
+
+template <typename PointT>
+size_t CustomPCDReader<PointT>::scanLinesASCII(size_t line_num, size_t chunk_line_num)
+{
+  const char * end = map_ + map_size_;
+  const char * pos = data_ + ascii_pos_;
+  size_t found_num = 0;
+
+  ascii_chunks_.clear();
+
+  for (; found_num < line_num && pos < end; ++found_num) {
+    if (found_num % chunk_line_num == 0) {
+      ascii_chunks_.push_back(pos - data_);
+    }
+
+    auto eol = static_cast<const char *>(memchr(pos, '\n', end - pos));
+
+    pos = eol ? eol + 1 : end;
+  }
+
+  ascii_chunks_.push_back(pos - data_);
+
+  if (found_num < line_num) {
+    fprintf(
+      stderr,
+      "[%s, %d] %s::Warning: The file has only %lu points while the header has %lu points. File "
+      "%s\n",
+      __FILE__, __LINE__, __func__, loaded_point_num_ + found_num, point_num_, pcd_path_.c_str());
+    point_num_ = loaded_point_num_ + found_num;
+  }
+
+  return found_num;
+}
+
+template <typename PointT>
+size_t CustomPCDReader<PointT>::readABlockMappedASCII(PclCloudType & output)
+{
+  size_t proc_num = std::min(block_size_, point_num_ - loaded_point_num_);
+  // A few chunks per thread balance the lines of different lengths
+  size_t chunk_line_num = std::max<size_t>(proc_num / (thread_num_ * 4), 1);
+
+  // The lines are split into chunks serially, which is much faster than parsing them
+  proc_num = scanLinesASCII(proc_num, chunk_line_num);
+
+  output.clear();
+  output.resize(proc_num);
+
+  size_t chunk_num = ascii_chunks_.size() - 1;
+  std::atomic<size_t> next_chunk(0);
+  std::atomic<bool> failed(false);
+
+  auto worker = [&]() {
+    for (size_t cid = next_chunk++; cid < chunk_num; cid = next_chunk++) {
+      const char * pos = data_ + ascii_chunks_[cid];
+      const char * chunk_end = data_ + ascii_chunks_[cid + 1];
+      PointT * point = output.points.data() + cid * chunk_line_num;
+
+      for (; pos < chunk_end; ++point) {
+        auto eol = static_cast<const char *>(memchr(pos, '\n', chunk_end - pos));
+        const char * line_end = eol ? eol : chunk_end;
+
+        if (!parsePoint(pos, line_end, ascii_token_fields_, *point)) {
+          failed = true;
+        }
+
+        pos = eol ? eol + 1 : chunk_end;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+
+  for (size_t i = 1; i < std::min(thread_num_, chunk_num); ++i) {
+    workers.emplace_back(worker);
+  }
+
+  worker();
+
+  for (auto & w : workers) {
+    w.join();
+  }
+
+  if (failed) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: Failed to read a block of points from file. File %s\n",
+      __FILE__, __LINE__, __func__, pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  size_t read_byte_num = ascii_chunks_.back() - ascii_pos_;
+
+  ascii_pos_ = ascii_chunks_.back();
+  loaded_point_num_ += proc_num;
+
+  return read_byte_num;
 }
 
 template <typename PointT>
@@ -603,9 +1002,163 @@ size_t CustomPCDReader<PointT>::readABlockASCII(std::ifstream & input, PclCloudT
   return read_byte_num;
 }
 
+template <typename PointT>
+void CustomPCDReader<PointT>::readCompressedData(std::ifstream & input)
+{
+  // The data section starts with the compressed and uncompressed sizes, then the LZF data
+  uint32_t compressed_size = 0, uncompressed_size = 0;
+
+  input.read(reinterpret_cast<char *>(&compressed_size), sizeof(uint32_t));
+  input.read(reinterpret_cast<char *>(&uncompressed_size), sizeof(uint32_t));
+
+  if (!input || uncompressed_size < point_num_ * point_size_) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: Invalid binary_compressed data. File %s\n", __FILE__, __LINE__,
+      __func__, pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  // The read buffer is not needed, points are taken from the decompressed data
+  delete[] buffer_;
+  buffer_ = nullptr;
+
+  {
+    std::vector<char> compressed(compressed_size);
+
+    input.read(compressed.data(), compressed_size);
+
+    if (static_cast<size_t>(input.gcount()) != compressed_size) {
+      fprintf(
+        stderr, "[%s, %d] %s::Error: Failed to read the compressed data. File %s\n", __FILE__,
+        __LINE__, __func__, pcd_path_.c_str());
+      exit(EXIT_FAILURE);
+    }
+
+    decompressed_.resize(uncompressed_size);
+
+    if (
+      pcl::lzfDecompress(
+        compressed.data(), compressed_size, decompressed_.data(), uncompressed_size) !=
+      uncompressed_size) {
+      fprintf(
+        stderr, "[%s, %d] %s::Error: Failed to decompress the data. File %s\n", __FILE__,
+        __LINE__, __func__, pcd_path_.c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // A field that starts at byte k of a point starts at byte k * point_num_ of the
+  // decompressed data, and its values are field_size * field_count bytes apart
+  soa_loc_.resize(read_loc_.size());
+  soa_strides_.resize(read_loc_.size());
+
+  for (size_t i = 0; i < read_loc_.size(); ++i) {
+    soa_loc_[i] = read_loc_[i] * point_num_;
+    soa_strides_[i] = 0;
+
+    for (size_t fid = 0, aos_loc = 0; fid < field_sizes_.size(); ++fid) {
+      if (aos_loc == read_loc_[i]) {
+        soa_strides_[i] = field_sizes_[fid] * field_counts_[fid];
+        break;
+      }
+
+      aos_loc += field_sizes_[fid] * field_counts_[fid];
+    }
+  }
+}
+
+template <typename PointT>
+size_t CustomPCDReader<PointT>::readABlockCompressed(PclCloudType & output)
+{
+  size_t proc_num = std::min(block_size_, point_num_ - loaded_point_num_);
+  std::vector<size_t> loc(soa_loc_.size());
+
+  output.clear();
+  output.resize(proc_num);
+
+  if (same_field_sizes_) {
+    // Each field is a contiguous array of values, gather them column by column
+    std::array<const char *, util::FieldLayout<PointT>::field_num> base;
+    std::array<size_t, util::FieldLayout<PointT>::field_num> strides;
+
+    for (size_t k = 0; k < base.size(); ++k) {
+      base[k] = decompressed_.data() + soa_loc_[k] + loaded_point_num_ * soa_strides_[k];
+      strides[k] = soa_strides_[k];
+    }
+
+    gatherPoints(base, strides, proc_num, output.points.data());
+    loaded_point_num_ += proc_num;
+
+    return proc_num * point_size_;
+  }
+
+  for (size_t i = 0; i < proc_num; ++i) {
+    size_t pid = loaded_point_num_ + i;
+
+    for (size_t k = 0; k < loc.size(); ++k) {
+      loc[k] = soa_loc_[k] + pid * soa_strides_[k];
+    }
+
+    parsePoint(decompressed_.data(), read_sizes_, loc, output[i]);
+  }
+
+  loaded_point_num_ += proc_num;
+
+  return proc_num * point_size_;
+}
+
+template <typename PointT>
+size_t CustomPCDReader<PointT>::readABlockMapped(PclCloudType & output)
+{
+  size_t proc_num = std::min(block_size_, point_num_ - loaded_point_num_);
+  const char * src = data_ + loaded_point_num_ * point_size_;
+
+  output.clear();
+  output.resize(proc_num);
+
+  // Points are converted directly from the mapped pages
+  readPoints(src, proc_num, output.points.data());
+
+  loaded_point_num_ += proc_num;
+
+  return proc_num * point_size_;
+}
+
+template <typename PointT>
+void CustomPCDReader<PointT>::readPoints(const char * src, size_t point_num, PointT * output)
+{
+  if (same_layout_) {
+    // Points on disk are already PointT, copy the whole block at once
+    memcpy(static_cast<void *>(output), src, point_num * point_size_);
+  } else if (same_field_sizes_) {
+    std::array<const char *, util::FieldLayout<PointT>::field_num> base;
+    std::array<size_t, util::FieldLayout<PointT>::field_num> strides;
+
+    for (size_t k = 0; k < base.size(); ++k) {
+      base[k] = src + read_loc_[k];
+      strides[k] = point_size_;
+    }
+
+    gatherPoints(base, strides, point_num, output);
+  } else {
+    // Generic path, e.g. for missing fields or fields that are not floats
+    for (size_t i = 0; i < point_num; ++i, src += point_size_) {
+      parsePoint(src, read_sizes_, read_loc_, output[i]);
+    }
+  }
+}
+
 template <typename PointT>
 size_t CustomPCDReader<PointT>::readABlock(std::ifstream & input, PclCloudType & output)
 {
+  if (map_) {
+    return binary_ ? readABlockMapped(output) : readABlockMappedASCII(output);
+  }
+
+  if (compressed_) {
+    return readABlockCompressed(output);
+  }
+
   if (binary_) {
     return readABlockBinary(input, output);
   }
@@ -54,15 +54,22 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_WRITER_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__PCD_IO_WRITER_HPP_
 
+#include "async_file_writer.hpp"
 #include "utility.hpp"
 
 #include <pcl/PCLPointField.h>
+#include <pcl/io/lzf.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -81,6 +88,7 @@ public:
     point_num_ = 0;
     written_point_num_ = 0;
     binary_ = true;
+    compressed_ = false;
     point_size_ = 0;
     write_size_ = 0;
 
@@ -89,23 +97,78 @@ public:
 
   // Set a file for writing
   void setOutput(const std::string & pcd_path);
-  // Write metadata to the output
-  void writeMetadata(size_t point_num, bool binary_mode);
+  // Open a binary PCD written by this class to append points to its end. The metadata is not
+  // written again, use updateMetadata to update the number of points afterwards
+  void appendOutput(const std::string & pcd_path);
+  // Write metadata to the output. If compressed is true, the data is written in the
+  // binary_compressed format when the output is closed
+  void writeMetadata(size_t point_num, bool binary_mode, bool compressed = false);
+  // Rewrite the number of points in the metadata of the opening file. The metadata must have
+  // been written with the resizable metadata mode on
+  void updateMetadata(size_t point_num);
   // Write a block of points to the output stream
   void write(const PclCloudType & input);
 
+  // Extend the opening binary file to the size given by the metadata without writing the
+  // points, and close it. The points can then be written to disjoint parts of the data by
+  // several threads, using serialize. Return the offset of the data in the file
+  size_t presize();
+  // Number of bytes of a point in the binary data
+  size_t point_size() const { return point_size_; }
+  // Convert points to the binary data layout. dst must have room for input.size() points
+  void serialize(const PclCloudType & input, size_t loc, size_t proc_size, char * dst) const;
+
   // Get path to the current opening PCD
   const std::string & get_path() const { return pcd_path_; }
 
-  void setBlockSize(size_t block_size) { block_size_ = block_size; }
+  // Must be called after setOutput, which resets the block size
+  void setBlockSize(size_t block_size)
+  {
+    if (block_size == block_size_ || block_size == 0) {
+      return;
+    }
+
+    block_size_ = block_size;
+    write_size_ = point_size_ * block_size_;
+
+    delete[] buffer_;
+    buffer_ = new char[write_size_];
+  }
+
+  // Write the number of points in the metadata with a fixed width, so that it can be
+  // updated later without moving the data
+  void setResizableMetadata(bool resizable) { resizable_metadata_ = resizable; }
+
+  // Write the binary data through AsyncFileWriter, so that points are serialized while the
+  // previous ones are being written
+  void setAsyncMode(bool use_async) { use_async_ = use_async; }
 
   bool good() { return file_.good(); }
 
+  // Finish writing and close the opening file
+  void close() { clear(); }
+
   ~CustomPCDWriter() { clear(); }
 
 private:
   void writeABlockBinary(const PclCloudType & input, size_t loc, size_t proc_size);
   void writeABlockASCII(const PclCloudType & input, size_t loc, size_t proc_size);
+  void writeABlockCompressed(const PclCloudType & input, size_t loc, size_t proc_size);
+
+  // Compress the buffered data and write it to the file
+  void flushCompressed();
+
+  // Wait for the asynchronous writes, and move the stream to the end of their data
+  void syncAsync()
+  {
+    if (async_file_.is_open()) {
+      async_file_.flush();
+      file_.seekp(async_file_.offset());
+    }
+  }
+
+  // Generate the metadata except the DATA line
+  std::string makeMetadata(size_t point_num);
 
   // If the number of points written to file is less than the number of points
   // in the header, fill the remaining points with 0. This often indicates
@@ -116,12 +179,20 @@ private:
   void clear()
   {
     padding();
+    syncAsync();
+    async_file_.close();
+
+    if (compressed_) {
+      flushCompressed();
+    }
 
     fields_.clear();
     field_sizes_.clear();
     point_num_ = 0;
     written_point_num_ = 0;
     binary_ = true;
+    compressed_ = false;
+    std::vector<char>().swap(soa_buffer_);
 
     if (file_.is_open()) {
       file_.close();
@@ -159,6 +230,16 @@ private:
 
     fields_.resize(i);
 
+    // The fields are usually those of FieldLayout, in the same order
+    typedef util::FieldLayout<PointT> Layout;
+
+    packed_fields_ = (fields_.size() == Layout::field_num);
+
+    for (size_t k = 0; packed_fields_ && k < fields_.size(); ++k) {
+      packed_fields_ =
+        (fields_[k].offset == Layout::offsets[k] && field_sizes_[k] == Layout::sizes[k]);
+    }
+
     // Reserve a buffer for writing
     write_size_ = point_size_ * block_size_;
     buffer_ = new char[write_size_];
@@ -171,12 +252,21 @@ private:
   // Number of points in the PCD file
   size_t point_num_;
   bool binary_;                   // Data: true: binary, false: ascii
+  bool compressed_;               // Data: binary_compressed
   std::ofstream file_;            // Input stream of the PCD file
   size_t block_size_ = 30000000;  // Maximum number of points to write in each writeABlock
   size_t point_size_, write_size_;
   char * buffer_;
   std::string pcd_path_;      // Path to the current opening PCD
   size_t written_point_num_;  // To track the number of points written to the file
+  // Points waiting for compression. Fields are stored one after another (all x, then all y, ...)
+  std::vector<char> soa_buffer_;
+  bool resizable_metadata_ = false;
+  // True if the written fields are those of FieldLayout<PointT>, in the same order
+  bool packed_fields_ = false;
+  bool use_async_ = false;
+  // Writer of the binary data, opened at the first block. Its buffers are kept for the next files
+  AsyncFileWriter async_file_;
 };
 
 template <typename PointT>
@@ -198,24 +288,104 @@ void CustomPCDWriter<PointT>::setOutput(const std::string & pcd_path)
 }
 
 template <typename PointT>
-void CustomPCDWriter<PointT>::writeMetadata(size_t point_num, bool binary_mode)
+void CustomPCDWriter<PointT>::appendOutput(const std::string & pcd_path)
 {
+  clear();
+  init();
+
+  // Open without truncating the file
+  file_.open(pcd_path, std::ios::in | std::ios::out | std::ios::binary);
+
   if (!file_.is_open()) {
     fprintf(
-      stderr, "[%s, %d] %s::Error: File is not opening at %s!\n", __FILE__, __LINE__, __func__,
-      pcd_path_.c_str());
+      stderr, "[%s, %d] %s::Error: Failed to open a file at %s\n", __FILE__, __LINE__, __func__,
+      pcd_path.c_str());
     exit(EXIT_FAILURE);
   }
 
+  file_.seekp(0, std::ios::end);
+  pcd_path_ = pcd_path;
+  binary_ = true;
+}
+
+template <typename PointT>
+std::string CustomPCDWriter<PointT>::makeMetadata(size_t point_num)
+{
   pcl::PCDWriter pcd_writer;
   std::string pcd_metadata = pcd_writer.generateHeader(PclCloudType(), point_num);
 
-  file_ << pcd_metadata;
+  if (resizable_metadata_) {
+    // Replace the numbers of points by zero-padded ones
+    std::ostringstream padded_num;
+
+    padded_num << std::setw(12) << std::setfill('0') << point_num;
+
+    for (const std::string tag : {"WIDTH ", "POINTS "}) {
+      auto num_str = tag + std::to_string(point_num) + "\n";
+      auto pos = pcd_metadata.find(num_str);
+
+      if (pos != std::string::npos) {
+        pcd_metadata.replace(pos, num_str.size(), tag + padded_num.str() + "\n");
+      }
+    }
+  }
+
+  return pcd_metadata;
+}
+
+template <typename PointT>
+void CustomPCDWriter<PointT>::updateMetadata(size_t point_num)
+{
+  if (!file_.is_open() || !resizable_metadata_) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: Cannot update the metadata of %s!\n", __FILE__, __LINE__,
+      __func__, pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  syncAsync();
+
+  auto end_pos = file_.tellp();
+
+  // The new metadata has the same size as the old one, so it overwrites only the metadata
+  file_.seekp(0, std::ios::beg);
+  file_ << makeMetadata(point_num);
+  file_.seekp(end_pos);
+
+  point_num_ = point_num;
+  written_point_num_ = point_num;
+}
+
+template <typename PointT>
+void CustomPCDWriter<PointT>::writeMetadata(size_t point_num, bool binary_mode, bool compressed)
+{
+  if (!file_.is_open()) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: File is not opening at %s!\n", __FILE__, __LINE__, __func__,
+      pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  file_ << makeMetadata(point_num);
 
   binary_ = binary_mode;
   point_num_ = point_num;
 
-  if (binary_) {
+  // LZF works on the whole data at once, and the sizes are stored in 32 bits
+  if (compressed && point_num * point_size_ > std::numeric_limits<uint32_t>::max()) {
+    fprintf(
+      stderr,
+      "[%s, %d] %s::Warning: Too many points to compress. Write uncompressed data to %s\n",
+      __FILE__, __LINE__, __func__, pcd_path_.c_str());
+    compressed = false;
+  }
+
+  compressed_ = binary_ && compressed;
+
+  if (compressed_) {
+    soa_buffer_.assign(point_num * point_size_, 0);
+    file_ << "DATA binary_compressed" << std::endl;
+  } else if (binary_) {
     file_ << "DATA binary" << std::endl;
   } else {
     file_ << "DATA ascii" << std::endl;
@@ -229,7 +399,9 @@ void CustomPCDWriter<PointT>::write(const PclCloudType & input)
     size_t proc_size =
       (read_loc + block_size_ < input.size()) ? block_size_ : input.size() - read_loc;
 
-    if (binary_) {
+    if (compressed_) {
+      writeABlockCompressed(input, read_loc, proc_size);
+    } else if (binary_) {
       writeABlockBinary(input, read_loc, proc_size);
     } else {
       writeABlockASCII(input, read_loc, proc_size);
@@ -243,18 +415,98 @@ template <typename PointT>
 void CustomPCDWriter<PointT>::writeABlockBinary(
   const PclCloudType & input, size_t loc, size_t proc_size)
 {
+  if (use_async_) {
+    if (!async_file_.is_open()) {
+      // The data follows what the stream wrote
+      file_.flush();
+      async_file_.open(pcd_path_, file_.tellp());
+    }
+
+    // Serialize the points straight to the queued buffers
+    size_t chunk_size = std::max<size_t>(AsyncFileWriter::buffer_size / point_size_, 1);
+
+    for (size_t i = loc; i < loc + proc_size; i += chunk_size) {
+      size_t n = std::min(chunk_size, loc + proc_size - i);
+
+      if (n * point_size_ > AsyncFileWriter::buffer_size) {
+        // Points larger than a buffer
+        serialize(input, i, n, buffer_);
+        async_file_.write(buffer_, n * point_size_);
+      } else {
+        serialize(input, i, n, async_file_.acquire());
+        async_file_.submit(n * point_size_);
+      }
+    }
+
+    return;
+  }
+
   // Read points to the write buffer
-  for (size_t i = loc, write_loc = 0; i < proc_size; ++i) {
+  serialize(input, loc, proc_size, buffer_);
+
+  // Write the buffer to the file
+  file_.write(buffer_, proc_size * point_size_);
+}
+
+template <typename PointT>
+void CustomPCDWriter<PointT>::serialize(
+  const PclCloudType & input, size_t loc, size_t proc_size, char * dst) const
+{
+  if (packed_fields_) {
+    // The written fields and their offsets are compile-time constants, so the loop over
+    // fields is unrolled
+    typedef util::FieldLayout<PointT> Layout;
+
+    for (size_t i = loc; i < loc + proc_size; ++i) {
+      const char * p = reinterpret_cast<const char *>(&input[i]);
+
+      for (size_t k = 0; k < Layout::field_num; ++k) {
+        memcpy(dst, p + Layout::offsets[k], Layout::sizes[k]);
+        dst += Layout::sizes[k];
+      }
+    }
+
+    return;
+  }
+
+  for (size_t i = loc, write_loc = 0; i < loc + proc_size; ++i) {
     const char * p = reinterpret_cast<const char *>(&input[i]);
 
     for (size_t fid = 0; fid < fields_.size(); ++fid) {
-      memcpy(buffer_ + write_loc, p + fields_[fid].offset, field_sizes_[fid]);
+      memcpy(dst + write_loc, p + fields_[fid].offset, field_sizes_[fid]);
       write_loc += field_sizes_[fid];
     }
   }
+}
 
-  // Write the buffer to the file
-  file_.write(buffer_, proc_size * point_size_);
+template <typename PointT>
+size_t CustomPCDWriter<PointT>::presize()
+{
+  if (!file_.is_open() || !binary_ || compressed_) {
+    fprintf(
+      stderr, "[%s, %d] %s::Error: Cannot presize %s, the output must be binary!\n", __FILE__,
+      __LINE__, __func__, pcd_path_.c_str());
+    exit(EXIT_FAILURE);
+  }
+
+  syncAsync();
+  file_.flush();
+
+  size_t data_offset = file_.tellp();
+  std::string pcd_path = pcd_path_;
+
+  // The points are not written by this object, so skip the padding
+  written_point_num_ = point_num_;
+
+  size_t point_size = point_size_;
+  size_t point_num = point_num_;
+
+  clear();
+
+  // The unwritten part of the file reads as zeros, like the padding
+  std::filesystem::resize_file(pcd_path, data_offset + point_num * point_size);
+
+  return data_offset;
 }
 
 template <typename PointT>
@@ -267,7 +519,7 @@ void CustomPCDWriter<PointT>::writeABlockASCII(
   const size_t max_point_num = 10;
   size_t packed_point_num = 0;
 
-  for (size_t i = loc; i < proc_size; ++i) {
+  for (size_t i = loc; i < loc + proc_size; ++i) {
     auto & point = cloud[i];
 
     // Copied from the PCL library
@@ -435,6 +687,64 @@ void CustomPCDWriter<PointT>::writeABlockASCII(
   }
 }
 
+template <typename PointT>
+void CustomPCDWriter<PointT>::writeABlockCompressed(
+  const PclCloudType & input, size_t loc, size_t proc_size)
+{
+  // Index of the first point of this block in the output
+  size_t first_pid = written_point_num_ + loc;
+
+  if (first_pid >= point_num_) {
+    return;
+  }
+
+  proc_size = std::min(proc_size, point_num_ - first_pid);
+
+  // Scatter fields of points to their own sections of the buffer
+  for (size_t fid = 0, field_loc = 0; fid < fields_.size(); ++fid) {
+    char * dst = soa_buffer_.data() + point_num_ * field_loc + first_pid * field_sizes_[fid];
+
+    for (size_t i = loc; i < loc + proc_size; ++i, dst += field_sizes_[fid]) {
+      const char * p = reinterpret_cast<const char *>(&input[i]);
+
+      memcpy(dst, p + fields_[fid].offset, field_sizes_[fid]);
+    }
+
+    field_loc += field_sizes_[fid];
+  }
+}
+
+template <typename PointT>
+void CustomPCDWriter<PointT>::flushCompressed()
+{
+  if (!file_.is_open()) {
+    return;
+  }
+
+  uint32_t uncompressed_size = soa_buffer_.size();
+  uint32_t compressed_size = 0;
+  // Same margin as PCL, LZF may expand data that cannot be compressed
+  std::vector<char> compressed(static_cast<size_t>(uncompressed_size) * 3 / 2 + 8);
+
+  if (uncompressed_size > 0) {
+    compressed_size = pcl::lzfCompress(
+      soa_buffer_.data(), uncompressed_size, compressed.data(), compressed.size());
+
+    if (compressed_size == 0) {
+      fprintf(
+        stderr, "[%s, %d] %s::Error: Failed to compress the data of %s\n", __FILE__, __LINE__,
+        __func__, pcd_path_.c_str());
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  file_.write(reinterpret_cast<const char *>(&compressed_size), sizeof(uint32_t));
+  file_.write(reinterpret_cast<const char *>(&uncompressed_size), sizeof(uint32_t));
+  file_.write(compressed.data(), compressed_size);
+
+  compressed_ = false;
+}
+
 template <typename PointT>
 void CustomPCDWriter<PointT>::padding()
 {
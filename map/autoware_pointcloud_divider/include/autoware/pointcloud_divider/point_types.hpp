@@ -0,0 +1,43 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__POINT_TYPES_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__POINT_TYPES_HPP_
+
+#include <pcl/point_types.h>
+#include <pcl/register_point_struct.h>
+
+#include <cstdint>
+
+namespace autoware::pointcloud_divider
+{
+
+// Point with the ring and time fields of raw lidar scans, e.g. maps built from Velodyne data
+struct EIGEN_ALIGN16 PointXYZIRT
+{
+  PCL_ADD_POINT4D;
+  float intensity;
+  std::uint16_t ring;
+  float time;
+  PCL_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+}  // namespace autoware::pointcloud_divider
+
+POINT_CLOUD_REGISTER_POINT_STRUCT(
+  autoware::pointcloud_divider::PointXYZIRT,
+  (float, x, x)(float, y, y)(float, z, z)(float, intensity, intensity)(std::uint16_t, ring, ring)(
+    float, time, time))
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__POINT_TYPES_HPP_
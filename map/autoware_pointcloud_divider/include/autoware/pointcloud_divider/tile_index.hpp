@@ -0,0 +1,202 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_DIVIDER__TILE_INDEX_HPP_
+#define AUTOWARE__POINTCLOUD_DIVIDER__TILE_INDEX_HPP_
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Binary index of the output tiles, so that map loaders can select tiles by their bounds without
+// opening them. The file is a TileIndexHeader, followed by tile_num TileIndexRecords, followed by
+// the path table. All values are little endian, and the records have a fixed size, so the file can
+// be memory-mapped and the records used in place
+namespace autoware::pointcloud_divider
+{
+
+struct TileIndexHeader
+{
+  char magic[8];             // "PCDTIDX" and a null character
+  uint32_t version;          // Version of the format, currently 1
+  uint32_t tile_num;         // Number of records
+  double x_resolution;       // Size of a tile along the X-axis
+  double y_resolution;       // Size of a tile along the Y-axis
+  uint64_t path_table_size;  // Size of the path table in bytes
+};
+
+struct TileIndexRecord
+{
+  int32_t ix, iy;               // Grid coordinates, the same as in the metadata YAML
+  std::array<float, 3> min_pt;  // Bounding box of the points of the tile
+  std::array<float, 3> max_pt;
+  uint64_t point_num;           // Number of points in the tile
+  uint64_t byte_size;           // Size of the tile file
+  uint32_t crc32;               // CRC-32 (that of zlib) of the tile file
+  uint32_t path_offset;         // Location of the path in the path table
+  uint32_t path_length;         // Length of the path, without a null character
+  uint32_t flags;               // Bits of tile_index_flags, 0 in older indices
+};
+
+static_assert(sizeof(TileIndexHeader) == 40, "Unexpected size of TileIndexHeader");
+static_assert(sizeof(TileIndexRecord) == 64, "Unexpected size of TileIndexRecord");
+
+constexpr char tile_index_magic[8] = "PCDTIDX";
+constexpr uint32_t tile_index_version = 1;
+
+// Bits of TileIndexRecord::flags
+enum tile_index_flags : uint32_t {
+  // The points of the tile are sorted by their 3D Morton keys, see morton_order.hpp
+  tile_index_morton_order = 1,
+};
+
+// Update a CRC-32 with size bytes at data. Start with crc = 0
+inline uint32_t crc32(uint32_t crc, const char * data, size_t size)
+{
+  static const std::array<uint32_t, 256> table = []() {
+    std::array<uint32_t, 256> t;
+
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+      }
+
+      t[i] = c;
+    }
+
+    return t;
+  }();
+
+  crc = ~crc;
+
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+
+  return ~crc;
+}
+
+// Compute the CRC-32 and the size of a file. Return false if the file cannot be read
+inline bool file_crc32(const std::string & path, uint32_t & crc, uint64_t & byte_size)
+{
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::vector<char> buffer(1 << 20);
+
+  crc = 0;
+  byte_size = 0;
+
+  while (file) {
+    file.read(buffer.data(), buffer.size());
+
+    auto read_size = static_cast<size_t>(file.gcount());
+
+    crc = crc32(crc, buffer.data(), read_size);
+    byte_size += read_size;
+  }
+
+  return file.eof();
+}
+
+// Save the records and the paths of the tiles, whose path_offset and path_length are filled here
+inline bool saveTileIndex(
+  const std::string & path, double x_resolution, double y_resolution,
+  std::vector<TileIndexRecord> & records, const std::vector<std::string> & tile_paths)
+{
+  TileIndexHeader header;
+  std::string path_table;
+
+  memcpy(header.magic, tile_index_magic, sizeof(header.magic));
+  header.version = tile_index_version;
+  header.tile_num = records.size();
+  header.x_resolution = x_resolution;
+  header.y_resolution = y_resolution;
+
+  for (size_t i = 0; i < records.size(); ++i) {
+    records[i].path_offset = path_table.size();
+    records[i].path_length = tile_paths[i].size();
+    path_table += tile_paths[i];
+  }
+
+  header.path_table_size = path_table.size();
+
+  std::ofstream file(path, std::ios::binary);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(
+    reinterpret_cast<const char *>(records.data()), records.size() * sizeof(TileIndexRecord));
+  file.write(path_table.data(), path_table.size());
+
+  return file.good();
+}
+
+// Load a tile index. Return false if the file does not exist or is not a valid index
+inline bool loadTileIndex(
+  const std::string & path, TileIndexHeader & header, std::vector<TileIndexRecord> & records,
+  std::vector<std::string> & tile_paths)
+{
+  std::ifstream file(path, std::ios::binary);
+
+  if (!file.is_open()) {
+    return false;
+  }
+
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+  if (
+    !file || memcmp(header.magic, tile_index_magic, sizeof(header.magic)) != 0 ||
+    header.version != tile_index_version) {
+    return false;
+  }
+
+  std::string path_table(header.path_table_size, '\0');
+
+  records.resize(header.tile_num);
+  file.read(reinterpret_cast<char *>(records.data()), records.size() * sizeof(TileIndexRecord));
+  file.read(&path_table[0], path_table.size());
+
+  if (!file) {
+    return false;
+  }
+
+  tile_paths.clear();
+
+  for (const auto & rec : records) {
+    if (static_cast<size_t>(rec.path_offset) + rec.path_length > path_table.size()) {
+      return false;
+    }
+
+    tile_paths.push_back(path_table.substr(rec.path_offset, rec.path_length));
+  }
+
+  return true;
+}
+
+}  // namespace autoware::pointcloud_divider
+
+#endif  // AUTOWARE__POINTCLOUD_DIVIDER__TILE_INDEX_HPP_
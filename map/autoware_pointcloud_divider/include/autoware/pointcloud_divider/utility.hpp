@@ -15,15 +15,23 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__UTILITY_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__UTILITY_HPP_
 
+#include "point_types.hpp"
+
 #include <pcl/point_types.h>
 
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <system_error>
 #include <vector>
 
 namespace autoware::pointcloud_divider::util
@@ -53,6 +61,15 @@ inline bool remove(const std::string & path)
   return true;
 }
 
+// Return the size of the file at @path in bytes, or 0 if it cannot be read
+inline size_t file_size(const std::string & path)
+{
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+
+  return ec ? 0 : static_cast<size_t>(size);
+}
+
 // Parse the name of the PCD file, and return the number of points in the file
 // Can only be used for file names of "***_<point_number>.pcd" format
 inline size_t point_num(const std::string & pcd_path)
@@ -96,19 +113,170 @@ inline int split(const std::string & line, const std::string & del, std::vector<
   return vals.size();
 }
 
+// Fields of PointT that are read from and written to PCD files, known at compile time. For each
+// field, the name, the offset in PointT, the size in bytes and the PCD type (F, U or I) are given.
+// To support a new point type, register it to PCL and add a specialization here
 template <typename PointT>
-inline void zero_point(PointT & p);
+struct FieldLayout;
 
 template <>
-inline void zero_point(pcl::PointXYZ & p)
+struct FieldLayout<pcl::PointXYZ>
 {
-  p.x = p.y = p.z = 0;
-}
+  static constexpr size_t field_num = 3;
+  static constexpr std::array<const char *, field_num> names = {"x", "y", "z"};
+  static constexpr std::array<size_t, field_num> offsets = {
+    offsetof(pcl::PointXYZ, x), offsetof(pcl::PointXYZ, y), offsetof(pcl::PointXYZ, z)};
+  static constexpr std::array<size_t, field_num> sizes = {4, 4, 4};
+  static constexpr std::array<char, field_num> types = {'F', 'F', 'F'};
+};
+
+template <>
+struct FieldLayout<pcl::PointXYZI>
+{
+  static constexpr size_t field_num = 4;
+  static constexpr std::array<const char *, field_num> names = {"x", "y", "z", "intensity"};
+  static constexpr std::array<size_t, field_num> offsets = {
+    offsetof(pcl::PointXYZI, x), offsetof(pcl::PointXYZI, y), offsetof(pcl::PointXYZI, z),
+    offsetof(pcl::PointXYZI, intensity)};
+  static constexpr std::array<size_t, field_num> sizes = {4, 4, 4, 4};
+  static constexpr std::array<char, field_num> types = {'F', 'F', 'F', 'F'};
+};
+
+// The 4 bytes of rgb are the b, g, r, a channels, see is_color_field
+template <>
+struct FieldLayout<pcl::PointXYZRGB>
+{
+  static constexpr size_t field_num = 4;
+  static constexpr std::array<const char *, field_num> names = {"x", "y", "z", "rgb"};
+  static constexpr std::array<size_t, field_num> offsets = {
+    offsetof(pcl::PointXYZRGB, x), offsetof(pcl::PointXYZRGB, y), offsetof(pcl::PointXYZRGB, z),
+    offsetof(pcl::PointXYZRGB, rgb)};
+  static constexpr std::array<size_t, field_num> sizes = {4, 4, 4, 4};
+  static constexpr std::array<char, field_num> types = {'F', 'F', 'F', 'F'};
+};
+
+template <>
+struct FieldLayout<pcl::PointNormal>
+{
+  static constexpr size_t field_num = 7;
+  static constexpr std::array<const char *, field_num> names = {
+    "x", "y", "z", "normal_x", "normal_y", "normal_z", "curvature"};
+  static constexpr std::array<size_t, field_num> offsets = {
+    offsetof(pcl::PointNormal, x),
+    offsetof(pcl::PointNormal, y),
+    offsetof(pcl::PointNormal, z),
+    offsetof(pcl::PointNormal, normal_x),
+    offsetof(pcl::PointNormal, normal_y),
+    offsetof(pcl::PointNormal, normal_z),
+    offsetof(pcl::PointNormal, curvature)};
+  static constexpr std::array<size_t, field_num> sizes = {4, 4, 4, 4, 4, 4, 4};
+  static constexpr std::array<char, field_num> types = {'F', 'F', 'F', 'F', 'F', 'F', 'F'};
+};
 
 template <>
-inline void zero_point(pcl::PointXYZI & p)
+struct FieldLayout<pcl::PointXYZINormal>
+{
+  static constexpr size_t field_num = 8;
+  static constexpr std::array<const char *, field_num> names = {
+    "x", "y", "z", "intensity", "normal_x", "normal_y", "normal_z", "curvature"};
+  static constexpr std::array<size_t, field_num> offsets = {
+    offsetof(pcl::PointXYZINormal, x),
+    offsetof(pcl::PointXYZINormal, y),
+    offsetof(pcl::PointXYZINormal, z),
+    offsetof(pcl::PointXYZINormal, intensity),
+    offsetof(pcl::PointXYZINormal, normal_x),
+    offsetof(pcl::PointXYZINormal, normal_y),
+    offsetof(pcl::PointXYZINormal, normal_z),
+    offsetof(pcl::PointXYZINormal, curvature)};
+  static constexpr std::array<size_t, field_num> sizes = {4, 4, 4, 4, 4, 4, 4, 4};
+  static constexpr std::array<char, field_num> types = {'F', 'F', 'F', 'F', 'F', 'F', 'F', 'F'};
+};
+
+template <>
+struct FieldLayout<PointXYZIRT>
+{
+  static constexpr size_t field_num = 6;
+  static constexpr std::array<const char *, field_num> names = {
+    "x", "y", "z", "intensity", "ring", "time"};
+  static constexpr std::array<size_t, field_num> offsets = {
+    offsetof(PointXYZIRT, x),         offsetof(PointXYZIRT, y),    offsetof(PointXYZIRT, z),
+    offsetof(PointXYZIRT, intensity), offsetof(PointXYZIRT, ring), offsetof(PointXYZIRT, time)};
+  static constexpr std::array<size_t, field_num> sizes = {4, 4, 4, 4, 2, 4};
+  static constexpr std::array<char, field_num> types = {'F', 'F', 'F', 'F', 'U', 'F'};
+};
+
+// Check if a field is a packed color (rgb or rgba), whose bytes are averaged one by one
+constexpr bool is_color_field(const char * name)
 {
-  p.x = p.y = p.z = p.intensity = 0;
+  return name[0] == 'r' && name[1] == 'g' && name[2] == 'b' &&
+         (name[3] == '\0' || (name[3] == 'a' && name[4] == '\0'));
+}
+
+// Set all fields of FieldLayout<PointT> to zero
+template <typename PointT>
+inline void zero_point(PointT & p)
+{
+  typedef FieldLayout<PointT> Layout;
+  char * dst = reinterpret_cast<char *>(&p);
+
+  for (size_t k = 0; k < Layout::field_num; ++k) {
+    memset(dst + Layout::offsets[k], 0, Layout::sizes[k]);
+  }
+}
+
+// Convert a value in an ascii PCD to a field of type type and size size, and store it at dst
+inline void parse_field(const std::string & val, char type, size_t size, char * dst)
+{
+  if (type == 'F') {
+    if (size == sizeof(double)) {
+      double v = std::stod(val);
+      memcpy(dst, &v, size);
+    } else {
+      float v = std::stof(val);
+      memcpy(dst, &v, size);
+    }
+  } else if (type == 'U') {
+    // Little endian, the lower bytes of the value are stored first
+    uint64_t v = std::stoull(val);
+    memcpy(dst, &v, size);
+  } else {
+    int64_t v = std::stoll(val);
+    memcpy(dst, &v, size);
+  }
+}
+
+// Convert the value in [begin, end) like parse_field, without allocating a string. Return false if
+// the value is not a number of the type
+inline bool parse_field(const char * begin, const char * end, char type, size_t size, char * dst)
+{
+  // std::from_chars does not take the plus sign
+  if (begin < end && *begin == '+') {
+    ++begin;
+  }
+
+  std::from_chars_result result{begin, std::errc::invalid_argument};
+
+  if (type == 'F') {
+    if (size == sizeof(double)) {
+      double v = 0.0;
+      result = std::from_chars(begin, end, v);
+      memcpy(dst, &v, size);
+    } else {
+      float v = 0.0f;
+      result = std::from_chars(begin, end, v);
+      memcpy(dst, &v, size);
+    }
+  } else if (type == 'U') {
+    uint64_t v = 0;
+    result = std::from_chars(begin, end, v);
+    memcpy(dst, &v, size);
+  } else {
+    int64_t v = 0;
+    result = std::from_chars(begin, end, v);
+    memcpy(dst, &v, size);
+  }
+
+  return result.ec == std::errc() && result.ptr == end;
 }
 
 // Remove trailing whitespace, newline, and carriage return characters from a string
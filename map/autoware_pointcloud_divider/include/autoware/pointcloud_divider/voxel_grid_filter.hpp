@@ -15,9 +15,12 @@
 #ifndef AUTOWARE__POINTCLOUD_DIVIDER__VOXEL_GRID_FILTER_HPP_
 #define AUTOWARE__POINTCLOUD_DIVIDER__VOXEL_GRID_FILTER_HPP_
 
+#include "point_types.hpp"
+
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
+#include <cstddef>
 #include <iostream>
 
 namespace autoware::pointcloud_divider
@@ -39,14 +42,39 @@ public:
     }
   }
 
+  // Use the sort-based engine instead of the hash map. Voxel keys are packed to 64 bits,
+  // sorted by radix sort, and contiguous runs of the same key are reduced to centroids
+  void setSortMode(bool use_sort) { use_sort_ = use_sort; }
+
+  // Number of threads used by the sort-based engine
+  void setThreadNum(int thread_num) { thread_num_ = (thread_num > 1) ? thread_num : 1; }
+
+  // Use the CUDA engine, which sorts and reduces the voxels on the GPU like the sort-based
+  // engine. It falls back to the CPU engines if the package is built without
+  // POINTCLOUD_DIVIDER_USE_CUDA or no device is found
+  void setCudaMode(bool use_cuda) { use_cuda_ = use_cuda; }
+
   void filter(const PclCloudType & input, PclCloudType & output);
 
 private:
+  // Return false if the voxel indices of the input do not fit into a 64-bit key
+  bool filterBySort(const PclCloudType & input, PclCloudType & output);
+
+  // Return false if the CUDA engine is not available or fails
+  bool filterByCuda(const PclCloudType & input, PclCloudType & output);
+
   float resolution_;
+  bool use_sort_ = false;
+  bool use_cuda_ = false;
+  size_t thread_num_ = 1;
 };
 
 template class VoxelGridFilter<pcl::PointXYZ>;
 template class VoxelGridFilter<pcl::PointXYZI>;
+template class VoxelGridFilter<pcl::PointXYZRGB>;
+template class VoxelGridFilter<pcl::PointNormal>;
+template class VoxelGridFilter<pcl::PointXYZINormal>;
+template class VoxelGridFilter<PointXYZIRT>;
 
 }  // namespace autoware::pointcloud_divider
 
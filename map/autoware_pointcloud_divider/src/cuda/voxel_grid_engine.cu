@@ -0,0 +1,393 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <autoware/pointcloud_divider/cuda_voxel_grid_engine.hpp>
+
+#include <cuda_runtime.h>
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/execution_policy.h>
+#include <thrust/extrema.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/sequence.h>
+#include <thrust/sort.h>
+#include <thrust/system_error.h>
+
+#include <exception>
+#include <iostream>
+#include <new>
+
+namespace autoware::pointcloud_divider::cuda
+{
+
+namespace
+{
+// Points copied to the device at once. Two pinned buffers of this size are kept
+constexpr size_t block_capacity = size_t(1) << 20;
+constexpr int block_dim = 256;
+
+bool check(cudaError_t err, const char * what)
+{
+  if (err != cudaSuccess) {
+    std::cerr << "Error: " << what << " failed on the GPU: " << cudaGetErrorString(err)
+              << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+int blockNum(size_t n)
+{
+  return static_cast<int>((n + block_dim - 1) / block_dim);
+}
+
+// Same as pointToGrid3
+__global__ void computeGrids(
+  const float * channels, size_t channel_num, size_t point_num, float resolution, int * ix,
+  int * iy, int * iz)
+{
+  size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+
+  if (i < point_num) {
+    const float * p = channels + i * channel_num;
+
+    ix[i] = static_cast<int>(floorf(p[0] / resolution));
+    iy[i] = static_cast<int>(floorf(p[1] / resolution));
+    iz[i] = static_cast<int>(floorf(p[2] / resolution));
+  }
+}
+
+// Same packing as the sort-based CPU engine
+__global__ void packKeys(
+  const int * ix, const int * iy, const int * iz, size_t point_num, int min_x, int min_y,
+  int min_z, int x_bits, int y_bits, uint64_t * keys)
+{
+  size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+
+  if (i < point_num) {
+    uint64_t kx = static_cast<int64_t>(ix[i]) - min_x;
+    uint64_t ky = static_cast<int64_t>(iy[i]) - min_y;
+    uint64_t kz = static_cast<int64_t>(iz[i]) - min_z;
+
+    keys[i] = kx | (ky << x_bits) | (kz << (x_bits + y_bits));
+  }
+}
+
+__global__ void markHeads(const uint64_t * keys, size_t point_num, uint32_t * heads)
+{
+  size_t i = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+
+  if (i < point_num) {
+    heads[i] = (i == 0 || keys[i] != keys[i - 1]) ? 1 : 0;
+  }
+}
+
+// One thread per voxel adds the differences of its points to the first point in the input order,
+// in double as Centroid::add does, so that the sums are the same as those of the CPU engines
+__global__ void reduceVoxels(
+  const float * channels, size_t channel_num, const uint32_t * sorted_indices,
+  const uint32_t * voxel_begins, size_t voxel_num, size_t point_num, uint32_t * first_indices,
+  uint32_t * point_nums, double * acc_diffs)
+{
+  size_t v = blockIdx.x * static_cast<size_t>(blockDim.x) + threadIdx.x;
+
+  if (v >= voxel_num) {
+    return;
+  }
+
+  uint32_t begin = voxel_begins[v];
+  uint32_t end = (v + 1 < voxel_num) ? voxel_begins[v + 1] : static_cast<uint32_t>(point_num);
+  const float * first = channels + static_cast<size_t>(sorted_indices[begin]) * channel_num;
+  double * acc = acc_diffs + v * channel_num;
+
+  for (size_t c = 0; c < channel_num; ++c) {
+    acc[c] = 0;
+  }
+
+  for (uint32_t j = begin + 1; j < end; ++j) {
+    const float * p = channels + static_cast<size_t>(sorted_indices[j]) * channel_num;
+
+    for (size_t c = 0; c < channel_num; ++c) {
+      acc[c] += p[c] - first[c];
+    }
+  }
+
+  first_indices[v] = sorted_indices[begin];
+  point_nums[v] = end - begin;
+}
+
+int bitWidth(uint64_t val)
+{
+  int width = 0;
+
+  for (; val > 0; val >>= 1) {
+    ++width;
+  }
+
+  return width;
+}
+
+}  // namespace
+
+bool isDeviceAvailable()
+{
+  int device_num = 0;
+
+  return cudaGetDeviceCount(&device_num) == cudaSuccess && device_num > 0;
+}
+
+struct VoxelGridEngine::Impl
+{
+  cudaStream_t streams[2] = {nullptr, nullptr};
+  cudaEvent_t copied[2] = {nullptr, nullptr};
+  float * pinned[2] = {nullptr, nullptr};
+  size_t pinned_channel_num = 0;
+  int current = 0;
+  bool ok = true;
+
+  size_t point_num = 0;
+  size_t channel_num = 0;
+  size_t uploaded_num = 0;
+  thrust::device_vector<float> channels;
+
+  ~Impl()
+  {
+    for (int b = 0; b < 2; ++b) {
+      if (streams[b]) {
+        cudaStreamSynchronize(streams[b]);
+        cudaStreamDestroy(streams[b]);
+      }
+      if (copied[b]) {
+        cudaEventDestroy(copied[b]);
+      }
+      if (pinned[b]) {
+        cudaFreeHost(pinned[b]);
+      }
+    }
+  }
+};
+
+VoxelGridEngine::VoxelGridEngine() : impl_(new Impl)
+{
+  for (int b = 0; b < 2 && impl_->ok; ++b) {
+    impl_->ok =
+      check(
+        cudaStreamCreateWithFlags(&impl_->streams[b], cudaStreamNonBlocking), "cudaStreamCreate") &&
+      check(cudaEventCreateWithFlags(&impl_->copied[b], cudaEventDisableTiming), "cudaEventCreate");
+  }
+}
+
+VoxelGridEngine::~VoxelGridEngine() = default;
+
+bool VoxelGridEngine::begin(size_t point_num, size_t channel_num)
+{
+  auto & impl = *impl_;
+
+  if (!impl.ok || channel_num < 3) {
+    return false;
+  }
+
+  // The pinned buffers are kept for the next clouds of the same point type
+  if (impl.pinned_channel_num != channel_num) {
+    size_t byte_num = block_capacity * channel_num * sizeof(float);
+
+    for (int b = 0; b < 2; ++b) {
+      cudaEventSynchronize(impl.copied[b]);
+      cudaFreeHost(impl.pinned[b]);
+      impl.pinned[b] = nullptr;
+      impl.ok = impl.ok && check(
+                             cudaMallocHost(reinterpret_cast<void **>(&impl.pinned[b]), byte_num),
+                             "cudaMallocHost");
+    }
+    impl.pinned_channel_num = impl.ok ? channel_num : 0;
+  }
+
+  impl.point_num = point_num;
+  impl.channel_num = channel_num;
+  impl.uploaded_num = 0;
+  impl.current = 0;
+
+  try {
+    impl.channels.resize(point_num * channel_num);
+  } catch (const std::exception & e) {
+    std::cerr << "Error: cannot allocate " << point_num << " points on the GPU: " << e.what()
+              << std::endl;
+    impl.channels.clear();
+    impl.channels.shrink_to_fit();
+    return false;
+  }
+
+  return impl.ok;
+}
+
+float * VoxelGridEngine::blockBuffer()
+{
+  auto & impl = *impl_;
+
+  impl.ok = impl.ok && check(cudaEventSynchronize(impl.copied[impl.current]), "cudaEventSync");
+
+  return impl.pinned[impl.current];
+}
+
+size_t VoxelGridEngine::blockCapacity() const
+{
+  return block_capacity;
+}
+
+bool VoxelGridEngine::uploadBlock(size_t point_num)
+{
+  auto & impl = *impl_;
+  int cur = impl.current;
+
+  if (!impl.ok || impl.uploaded_num + point_num > impl.point_num) {
+    return false;
+  }
+
+  float * dst =
+    thrust::raw_pointer_cast(impl.channels.data()) + impl.uploaded_num * impl.channel_num;
+  size_t byte_num = point_num * impl.channel_num * sizeof(float);
+
+  impl.ok = check(
+              cudaMemcpyAsync(
+                dst, impl.pinned[cur], byte_num, cudaMemcpyHostToDevice, impl.streams[cur]),
+              "cudaMemcpyAsync") &&
+            check(cudaEventRecord(impl.copied[cur], impl.streams[cur]), "cudaEventRecord");
+  impl.uploaded_num += point_num;
+  impl.current = 1 - cur;
+
+  return impl.ok;
+}
+
+bool VoxelGridEngine::reduce(float resolution, VoxelReduction & result)
+{
+  auto & impl = *impl_;
+  size_t point_num = impl.point_num;
+
+  result.first_indices.clear();
+  result.point_nums.clear();
+  result.acc_diffs.clear();
+
+  for (int b = 0; b < 2 && impl.ok; ++b) {
+    impl.ok = check(cudaStreamSynchronize(impl.streams[b]), "cudaStreamSynchronize");
+  }
+
+  if (!impl.ok || impl.uploaded_num != point_num) {
+    return false;
+  }
+
+  if (point_num == 0) {
+    return true;
+  }
+
+  try {
+    const float * channels = thrust::raw_pointer_cast(impl.channels.data());
+    thrust::device_vector<int> ix(point_num), iy(point_num), iz(point_num);
+
+    computeGrids<<<blockNum(point_num), block_dim>>>(
+      channels, impl.channel_num, point_num, resolution, thrust::raw_pointer_cast(ix.data()),
+      thrust::raw_pointer_cast(iy.data()), thrust::raw_pointer_cast(iz.data()));
+
+    if (!check(cudaGetLastError(), "computeGrids")) {
+      return false;
+    }
+
+    auto x_range = thrust::minmax_element(thrust::device, ix.begin(), ix.end());
+    auto y_range = thrust::minmax_element(thrust::device, iy.begin(), iy.end());
+    auto z_range = thrust::minmax_element(thrust::device, iz.begin(), iz.end());
+    int min_x = *x_range.first, min_y = *y_range.first, min_z = *z_range.first;
+    int x_bits = bitWidth(static_cast<int64_t>(*x_range.second) - min_x);
+    int y_bits = bitWidth(static_cast<int64_t>(*y_range.second) - min_y);
+    int z_bits = bitWidth(static_cast<int64_t>(*z_range.second) - min_z);
+
+    if (x_bits + y_bits + z_bits > 64) {
+      return false;
+    }
+
+    thrust::device_vector<uint64_t> keys(point_num);
+
+    packKeys<<<blockNum(point_num), block_dim>>>(
+      thrust::raw_pointer_cast(ix.data()), thrust::raw_pointer_cast(iy.data()),
+      thrust::raw_pointer_cast(iz.data()), point_num, min_x, min_y, min_z, x_bits, y_bits,
+      thrust::raw_pointer_cast(keys.data()));
+
+    if (!check(cudaGetLastError(), "packKeys")) {
+      return false;
+    }
+
+    // Release the grids before the sort, which needs the most memory
+    thrust::device_vector<int>().swap(ix);
+    thrust::device_vector<int>().swap(iy);
+    thrust::device_vector<int>().swap(iz);
+
+    // The sort is stable, so the first point of each voxel is the first one in the input
+    thrust::device_vector<uint32_t> sorted_indices(point_num);
+
+    thrust::sequence(thrust::device, sorted_indices.begin(), sorted_indices.end());
+    thrust::stable_sort_by_key(thrust::device, keys.begin(), keys.end(), sorted_indices.begin());
+
+    // Find where each voxel starts in the sorted points
+    thrust::device_vector<uint32_t> heads(point_num);
+
+    markHeads<<<blockNum(point_num), block_dim>>>(
+      thrust::raw_pointer_cast(keys.data()), point_num, thrust::raw_pointer_cast(heads.data()));
+
+    if (!check(cudaGetLastError(), "markHeads")) {
+      return false;
+    }
+
+    thrust::device_vector<uint64_t>().swap(keys);
+
+    size_t voxel_num = thrust::reduce(thrust::device, heads.begin(), heads.end(), size_t(0));
+    thrust::device_vector<uint32_t> voxel_begins(voxel_num);
+
+    thrust::copy_if(
+      thrust::device, thrust::counting_iterator<uint32_t>(0),
+      thrust::counting_iterator<uint32_t>(static_cast<uint32_t>(point_num)), heads.begin(),
+      voxel_begins.begin(), thrust::identity<uint32_t>());
+    thrust::device_vector<uint32_t>().swap(heads);
+
+    thrust::device_vector<uint32_t> first_indices(voxel_num), point_nums(voxel_num);
+    thrust::device_vector<double> acc_diffs(voxel_num * impl.channel_num);
+
+    reduceVoxels<<<blockNum(voxel_num), block_dim>>>(
+      channels, impl.channel_num, thrust::raw_pointer_cast(sorted_indices.data()),
+      thrust::raw_pointer_cast(voxel_begins.data()), voxel_num, point_num,
+      thrust::raw_pointer_cast(first_indices.data()), thrust::raw_pointer_cast(point_nums.data()),
+      thrust::raw_pointer_cast(acc_diffs.data()));
+
+    if (!check(cudaGetLastError(), "reduceVoxels")) {
+      return false;
+    }
+
+    result.first_indices.resize(voxel_num);
+    result.point_nums.resize(voxel_num);
+    result.acc_diffs.resize(voxel_num * impl.channel_num);
+    thrust::copy(first_indices.begin(), first_indices.end(), result.first_indices.begin());
+    thrust::copy(point_nums.begin(), point_nums.end(), result.point_nums.begin());
+    thrust::copy(acc_diffs.begin(), acc_diffs.end(), result.acc_diffs.begin());
+  } catch (const thrust::system_error & e) {
+    std::cerr << "Error: voxel grid filter failed on the GPU: " << e.what() << std::endl;
+    return false;
+  } catch (const std::bad_alloc & e) {
+    std::cerr << "Error: not enough GPU memory for " << point_num << " points" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace autoware::pointcloud_divider::cuda
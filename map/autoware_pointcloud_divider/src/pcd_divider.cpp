@@ -41,17 +41,32 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <autoware/pointcloud_divider/grid_hash_map.hpp>
+#include <autoware/pointcloud_divider/morton_order.hpp>
 #include <autoware/pointcloud_divider/pcd_divider.hpp>
 #include <autoware/pointcloud_divider/utility.hpp>
 #include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
+#include <autoware/profiling_utils/profiling_utils.hpp>
 
 #include <pcl/common/transforms.h>
 #include <pcl/filters/voxel_grid.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
 #include <list>
 #include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -97,9 +112,44 @@ std::vector<std::string> PCDDivider<PointT>::discoverPCDs(const std::string & in
     exit(EXIT_FAILURE);
   }
 
+  scanHeaders(pcd_list);
+
   return pcd_list;
 }
 
+template <class PointT>
+void PCDDivider<PointT>::scanHeaders(const std::vector<std::string> & pcd_names)
+{
+  std::vector<std::string> new_names;
+
+  for (const auto & pcd_name : pcd_names) {
+    if (pcd_headers_.count(pcd_name) == 0) {
+      new_names.push_back(pcd_name);
+    }
+  }
+
+  if (new_names.empty()) {
+    return;
+  }
+
+  auto infos = scanPCDHeaders(new_names, thread_num_);
+  size_t point_num = 0, byte_size = 0;
+
+  for (auto & info : infos) {
+    if (!info.valid) {
+      RCLCPP_WARN(logger_, "Failed to read the header of %s", info.path.c_str());
+    }
+
+    point_num += info.point_num;
+    byte_size += info.file_size;
+    pcd_headers_[info.path] = std::move(info);
+  }
+
+  RCLCPP_INFO(
+    logger_, "Scanned %lu PCD headers: %lu points, %.1f MB", new_names.size(), point_num,
+    byte_size / (1024.0 * 1024.0));
+}
+
 template <class PointT>
 void PCDDivider<PointT>::run()
 {
@@ -111,14 +161,131 @@ void PCDDivider<PointT>::run()
 }
 
 template <class PointT>
-void PCDDivider<PointT>::run(const std::vector<std::string> & pcd_names)
+void PCDDivider<PointT>::run(const std::vector<std::string> & input_names)
 {
-  checkOutputDirectoryValidity();
+  AUTOWARE_PROFILE_FUNCTION();
+  checkLodLeafSizes();
+  checkShardMode();
+
+  // The keys hold 2^21 cubes per axis
+  if (
+    duplicate_resolution_ > 0 &&
+    std::max(grid_size_x_, grid_size_y_) / duplicate_resolution_ >= (1 << duplicate_key_bits)) {
+    RCLCPP_WARN(
+      logger_, "Duplicate resolution %f is too small for the grid size, duplicates are kept",
+      duplicate_resolution_);
+    duplicate_resolution_ = 0;
+  }
+
+  inv_duplicate_resolution_ = (duplicate_resolution_ > 0) ? 1.0 / duplicate_resolution_ : 0.0;
+  duplicate_point_num_ = 0;
+
+  // Halos only reach the adjacent grids. Without the filter, no halo is saved
+  if (outlier_mean_k_ <= 0) {
+    outlier_halo_ = 0;
+  } else if (outlier_halo_ >= std::min(grid_size_x_, grid_size_y_)) {
+    RCLCPP_WARN(
+      logger_, "Outlier halo %f must be smaller than the grid size, it is reduced to half of it",
+      outlier_halo_);
+    outlier_halo_ = std::min(grid_size_x_, grid_size_y_) * 0.5;
+  }
+
+  outlier_point_num_ = 0;
+
+  if (shard_mode_ == "merge") {
+    mergeShard();
+    return;
+  }
+
+  if (shard_mode_ == "finalize") {
+    finalizeShards();
+    return;
+  }
+
+  const auto pcd_names = (shard_mode_ == "divide") ? selectShardPCDs(input_names) : input_names;
+
+  scanHeaders(pcd_names);
+
+  input_point_num_ = 0;
+
+  for (const auto & pcd_name : pcd_names) {
+    input_point_num_ += pcd_headers_[pcd_name].point_num;
+  }
+
+  // Points appended to the output tiles cannot be rolled back to a checkpoint
+  is_checkpointing_ = checkpoint_interval_ > 0 && !appendToTiles();
+
+  if (checkpoint_interval_ > 0 && !is_checkpointing_) {
+    RCLCPP_WARN(logger_, "Checkpoints are disabled because points are appended to the tiles");
+  }
+
+  tmp_dir_ = output_dir_ + "/tmp/";
+
+  // Shards divide to their own folders, merged by the next step
+  if (shard_mode_ == "divide") {
+    tmp_dir_ += "shard_" + std::to_string(shard_id_) + "/";
+  }
+
+  read_point_num_ = divided_point_num_ = 0;
+  resume_file_id_ = resume_block_num_ = 0;
+  resumed_counters_.clear();
+  halo_to_cloud_.clear();
+
+  bool resume = is_checkpointing_ && loadCheckpoint(pcd_names);
+
+  checkOutputDirectoryValidity(resume);
 
   grid_set_.clear();
+  tile_point_num_.clear();
+  tile_records_.clear();
+
+  std::string yaml_file_path = output_dir_ + "/pointcloud_map_metadata.yaml";
+
+  // Keep the tiles of the existing output
+  if (incremental_update_) {
+    loadGridInfoFromYAML(yaml_file_path);
+  }
+
+  if (use_async_io_) {
+    resident_limit_ = max_resident_point_num_ - max_queued_point_num_;
+    size_t queued_bytes = max_queued_point_num_ * sizeof(PointT);
+    resident_byte_limit_ = memory_budget_ - std::min(memory_budget_, queued_bytes);
+    startWriter();
+  } else {
+    resident_limit_ = max_resident_point_num_;
+    resident_byte_limit_ = memory_budget_;
+  }
+
+  if (spill_policy_ != "largest" && spill_policy_ != "lru") {
+    RCLCPP_WARN(
+      logger_, "Unknown spill policy %s, the largest segment is saved instead",
+      spill_policy_.c_str());
+    spill_policy_ = "largest";
+  }
+
+  seg_writer_.setAsyncMode(use_io_uring_);
+  tile_writer_.setAsyncMode(use_io_uring_);
+
+  full_save_num_ = spill_num_ = spilled_point_num_ = 0;
+  peak_resident_bytes_ = resident_bytes_ = 0;
+  touch_time_ = 0;
+
+  for (auto & ns : phase_ns_) {
+    ns = 0;
+  }
+
+  estimateGridPointNum(pcd_names);
+
+  written_bytes_ = merged_seg_num_ = 0;
+  seg_num_ = checkpoint_num_ = 0;
+  start_time_ = last_report_time_ = last_checkpoint_time_ = std::chrono::steady_clock::now();
+
+  for (size_t fid = resume_file_id_; fid < pcd_names.size(); ++fid) {
+    const std::string & pcd_name = pcd_names[fid];
+    size_t block_num = 0;
 
-  for (const std::string & pcd_name : pcd_names) {
     if (!rclcpp::ok()) {
+      stopWriter();
       return;
     }
 
@@ -126,308 +293,1440 @@ void PCDDivider<PointT>::run(const std::vector<std::string> & pcd_names)
       RCLCPP_INFO(logger_, "Dividing file %s", pcd_name.c_str());
     }
 
-    do {
-      auto cloud_ptr = loadPCD(pcd_name);
+    if (fid == resume_file_id_ && resume_block_num_ > 0) {
+      // Skip the blocks divided before the checkpoint
+      reader_.setInput(pcd_name);
+
+      for (; block_num < resume_block_num_; ++block_num) {
+        reader_.skipABlock();
+      }
+    }
+
+    if (use_async_io_) {
+      // Read the next block in the background while the current block is being divided
+      auto load_block = [this, &pcd_name]() { return loadPCD(pcd_name); };
+      auto next_block = std::async(std::launch::async, load_block);
+      bool has_next = true;
+
+      while (has_next) {
+        auto cloud_ptr = next_block.get();
+
+        has_next = reader_.good() && rclcpp::ok();
 
-      dividePointCloud(cloud_ptr);
-    } while (reader_.good() && rclcpp::ok());
+        if (has_next) {
+          next_block = std::async(std::launch::async, load_block);
+        }
+
+        dividePointCloud(cloud_ptr);
+        reportProgress();
+        checkpointIfDue(pcd_names, fid, ++block_num);
+      }
+    } else {
+      do {
+        auto cloud_ptr = loadPCD(pcd_name);
+
+        dividePointCloud(cloud_ptr);
+        reportProgress();
+        checkpointIfDue(pcd_names, fid, ++block_num);
+      } while (reader_.good() && rclcpp::ok());
+    }
   }
 
   saveTheRest();
 
+  // All segments must be on the disk before merging them
+  stopWriter();
+  finalizeTiles();
+
+  // A run killed from now on starts over, the segments are merged into tiles and removed
+  if (is_checkpointing_) {
+    fs::remove(checkpointPath());
+  }
+
+  // The segments of the shard are merged with those of the other shards by the next step
+  if (shard_mode_ == "divide") {
+    reportSummary();
+    RCLCPP_INFO(logger_, "Shard %d/%d divided", shard_id_, shard_num_);
+    return;
+  }
+
   RCLCPP_INFO(logger_, "Merge and downsampling... ");
 
   // Now merge and downsample
   mergeAndDownsample();
 
-  std::string yaml_file_path = output_dir_ + "/pointcloud_map_metadata.yaml";
   saveGridInfoToYAML(yaml_file_path);
 
+  // The levels of detail have the same tiles as the output
+  for (const auto & lod_dir : lod_dirs_) {
+    saveGridInfoToYAML(lod_dir + "/pointcloud_map_metadata.yaml");
+  }
+
+  if (save_tile_index_) {
+    writeTileIndex(output_dir_ + "/pointcloud_map_index.bin");
+  }
+
+  reportSummary();
+
   RCLCPP_INFO(logger_, "Done!");
 }
 
 template <class PointT>
-void PCDDivider<PointT>::checkOutputDirectoryValidity()
+void PCDDivider<PointT>::addPhaseTime(
+  Phase phase, const std::chrono::steady_clock::time_point & start)
 {
-  tmp_dir_ = output_dir_ + "/tmp/";
+  auto elapsed = std::chrono::steady_clock::now() - start;
 
-  if (fs::exists(tmp_dir_)) {
-    fs::remove_all(tmp_dir_);
+  phase_ns_[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::reportProgress()
+{
+  if (progress_interval_ <= 0) {
+    return;
   }
 
-  if (fs::exists(output_dir_)) {
-    fs::remove_all(output_dir_);
+  std::lock_guard<std::mutex> lock(report_mtx_);
+  auto now = std::chrono::steady_clock::now();
+
+  AUTOWARE_PROFILE_COUNTER("read_point_num", static_cast<double>(read_point_num_.load()));
+  AUTOWARE_PROFILE_COUNTER("resident_point_num", static_cast<double>(resident_point_num_));
+
+  if (std::chrono::duration<double>(now - last_report_time_).count() < progress_interval_) {
+    return;
   }
 
-  util::make_dir(output_dir_ + "/pointcloud_map.pcd/");
-  util::make_dir(tmp_dir_);
+  last_report_time_ = now;
+
+  double elapsed = std::chrono::duration<double>(now - start_time_).count();
+  double read_ratio = (input_point_num_ > 0) ? 100.0 * read_point_num_ / input_point_num_ : 0.0;
+
+  RCLCPP_INFO(
+    logger_,
+    "Progress: %.1f s, %lu/%lu points read (%.1f%%, %.0f points/s), %lu resident points, %lu "
+    "spilled segments, %lu/%lu segments merged, %.1f MB written",
+    elapsed, read_point_num_.load(), input_point_num_, read_ratio, read_point_num_ / elapsed,
+    resident_point_num_, spill_num_, merged_seg_num_.load(), seg_num_,
+    written_bytes_ / (1024.0 * 1024.0));
 }
 
 template <class PointT>
-typename pcl::PointCloud<PointT>::Ptr PCDDivider<PointT>::loadPCD(const std::string & pcd_name)
+void PCDDivider<PointT>::reportSummary()
 {
-  if (pcd_name != reader_.get_path()) {
-    reader_.setInput(pcd_name);
+  const char * phase_names[PHASE_NUM] = {"read",  "divide",     "spill",
+                                         "merge", "downsample", "write"};
+  double elapsed =
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+  std::ostringstream summary;
+
+  summary << "{\"elapsed_sec\": " << elapsed << ", \"input_point_num\": " << read_point_num_
+          << ", \"points_per_sec\": " << read_point_num_ / elapsed
+          << ", \"tile_num\": " << grid_set_.size() << ", \"bytes_written\": " << written_bytes_
+          << ", \"full_segment_num\": " << full_save_num_
+          << ", \"spilled_segment_num\": " << spill_num_
+          << ", \"spilled_point_num\": " << spilled_point_num_
+          << ", \"duplicate_point_num\": " << duplicate_point_num_
+          << ", \"outlier_point_num\": " << outlier_point_num_
+          << ", \"checkpoint_num\": " << checkpoint_num_
+          << ", \"peak_resident_mb\": " << peak_resident_bytes_ / (1024.0 * 1024.0)
+          << ", \"phase_sec\": {";
+
+  for (int phase = 0; phase < PHASE_NUM; ++phase) {
+    summary << ((phase > 0) ? ", \"" : "\"") << phase_names[phase]
+            << "\": " << phase_ns_[phase] / 1e9;
   }
 
-  PclCloudPtr cloud_ptr(new PclCloudType);
+  summary << "}}";
 
-  reader_.readABlock(*cloud_ptr);
+  RCLCPP_INFO(logger_, "Summary: %s", summary.str().c_str());
 
-  return cloud_ptr;
-}
+  if (!summary_file_.empty()) {
+    std::ofstream summary_stream(summary_file_);
 
-template <class PointT>
-void PCDDivider<PointT>::savePCD(const std::string & path, const pcl::PointCloud<PointT> & cloud)
-{
-  if (pcl::io::savePCDFileBinary(path, cloud) == -1) {
-    RCLCPP_ERROR(logger_, "Error: Cannot save PCD: %s", path.c_str());
-    rclcpp::shutdown();
-    exit(EXIT_FAILURE);
+    if (!summary_stream.is_open()) {
+      RCLCPP_WARN(logger_, "Failed to save the summary to %s", summary_file_.c_str());
+      return;
+    }
+
+    summary_stream << summary.str() << std::endl;
   }
 }
 
 template <class PointT>
-void PCDDivider<PointT>::dividePointCloud(const PclCloudPtr & cloud_ptr)
+void PCDDivider<PointT>::checkOutputDirectoryValidity(bool resume)
 {
-  if (!cloud_ptr || cloud_ptr->size() <= 0) {
-    return;
+  // A resumed run keeps the segments saved by the killed run
+  if (fs::exists(tmp_dir_) && !resume) {
+    fs::remove_all(tmp_dir_);
   }
 
-  for (const PointT p : *cloud_ptr) {
-    if (!rclcpp::ok()) {
-      rclcpp::shutdown();
-      exit(EXIT_SUCCESS);
-    }
+  // The output of a distributed run is shared by the shards, so it must be cleaned beforehand
+  if (fs::exists(output_dir_) && !incremental_update_ && !resume && shard_mode_ == "none") {
+    fs::remove_all(output_dir_);
+  }
 
-    auto tmp = pointToGrid2(p, grid_size_x_, grid_size_y_);
-    auto it = grid_to_cloud_.find(tmp);
+  util::make_dir(output_dir_ + "/pointcloud_map.pcd/");
+  util::make_dir(tmp_dir_);
 
-    // If the grid has not existed yet, create a new one
-    if (it == grid_to_cloud_.end()) {
-      auto & new_grid = grid_to_cloud_[tmp];
+  for (const auto & lod_dir : lod_dirs_) {
+    util::make_dir(lod_dir + "/pointcloud_map.pcd/");
+  }
+}
 
-      std::get<0>(new_grid).reserve(max_block_size_);
+template <class PointT>
+void PCDDivider<PointT>::checkLodLeafSizes()
+{
+  std::vector<double> leaf_sizes;
 
-      std::get<0>(new_grid).push_back(p);  // Push the first point to the cloud
-      std::get<1>(new_grid) = 0;           // Counter set to 0
-      std::get<2>(new_grid) = 0;           // Prev size is 0
-    } else {
-      auto & cloud = std::get<0>(it->second);
-      auto & prev_size = std::get<2>(it->second);
+  for (auto leaf_size : lod_leaf_sizes_) {
+    if (leaf_size <= 0) {
+      continue;
+    }
 
-      cloud.push_back(p);
+    if (leaf_size <= leaf_size_) {
+      RCLCPP_WARN(
+        logger_, "The level of detail %f is not coarser than the leaf size %f, and is ignored",
+        leaf_size, leaf_size_);
+      continue;
+    }
 
-      ++resident_point_num_;
+    leaf_sizes.push_back(leaf_size);
+  }
 
-      // If the number of points in the segment reach maximum, save the segment to file
-      if (cloud.size() == max_block_size_) {
-        saveGridPCD(it);
-      } else {
-        // Otherwise, update the seg_by_size_ if the change of size is significant
-        if (cloud.size() - prev_size >= 10000) {
-          prev_size = cloud.size();
-          auto seg_to_size_it = seg_to_size_itr_map_.find(tmp);
-
-          if (seg_to_size_it == seg_to_size_itr_map_.end()) {
-            auto size_it = seg_by_size_.insert(std::make_pair(prev_size, it));
-            seg_to_size_itr_map_[tmp] = size_it;
-          } else {
-            seg_by_size_.erase(seg_to_size_it->second);
-            auto new_size_it = seg_by_size_.insert(std::make_pair(prev_size, it));
-            seg_to_size_it->second = new_size_it;
-          }
-        }
-      }
+  std::sort(leaf_sizes.begin(), leaf_sizes.end());
+  leaf_sizes.erase(std::unique(leaf_sizes.begin(), leaf_sizes.end()), leaf_sizes.end());
+  lod_leaf_sizes_ = leaf_sizes;
+  lod_dirs_.clear();
 
-      // If the number of resident points reach maximum, save the biggest resident segment to SSD
-      if (resident_point_num_ >= max_resident_point_num_) {
-        auto max_size_seg_it = seg_by_size_.rbegin();
+  for (auto leaf_size : lod_leaf_sizes_) {
+    std::ostringstream lod_dir;
 
-        saveGridPCD(max_size_seg_it->second);
-      }
-    }
+    lod_dir << output_dir_ << "/lod_" << leaf_size;
+    lod_dirs_.push_back(lod_dir.str());
   }
 }
 
 template <class PointT>
-void PCDDivider<PointT>::saveGridPCD(GridMapItr & grid_it)
+void PCDDivider<PointT>::checkShardMode()
 {
-  auto & cloud = std::get<0>(grid_it->second);
-  auto & counter = std::get<1>(grid_it->second);
-  auto & prev_size = std::get<2>(grid_it->second);
-
-  // Try to create a new directory to contain the cloud
-  std::ostringstream seg_path, file_path;
-
-  seg_path << tmp_dir_ << "/" << grid_it->first << "/";
-  file_path << seg_path.str() << counter << "_" << cloud.size() << ".pcd";
-
-  util::make_dir(seg_path.str());
+  if (
+    shard_mode_ != "none" && shard_mode_ != "divide" && shard_mode_ != "merge" &&
+    shard_mode_ != "finalize") {
+    RCLCPP_ERROR(logger_, "Error: Unknown shard mode %s", shard_mode_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
 
-  if (pcl::io::savePCDFileBinary(file_path.str(), cloud)) {
-    RCLCPP_ERROR(logger_, "Error: Cannot save a PCD file at %s", file_path.str().c_str());
+  if (shard_num_ < 1 || shard_id_ < 0 || shard_id_ >= shard_num_) {
+    RCLCPP_ERROR(logger_, "Error: Invalid shard %d of %d shards", shard_id_, shard_num_);
     rclcpp::shutdown();
     exit(EXIT_FAILURE);
   }
+}
 
-  resident_point_num_ -= cloud.size();
+template <class PointT>
+std::vector<std::string> PCDDivider<PointT>::selectShardPCDs(
+  const std::vector<std::string> & pcd_names)
+{
+  scanHeaders(pcd_names);
 
-  // Clear the content of the segment cloud and reserve space for further points
-  cloud.clear();
-  cloud.reserve(max_block_size_);
-  ++counter;  // Increase the counter so the next segment save will not overwrite the previously
-              // saved one
-  prev_size = 0;
+  // Equal files are sorted by name, so that the order does not depend on the file system
+  std::vector<std::string> sorted_names(pcd_names);
 
-  // Update the seg_by_size_ and seg_to_size_itr_map_
-  auto it = seg_to_size_itr_map_.find(grid_it->first);
+  std::sort(
+    sorted_names.begin(), sorted_names.end(), [this](const std::string & a, const std::string & b) {
+      size_t a_num = pcd_headers_.at(a).point_num, b_num = pcd_headers_.at(b).point_num;
 
-  if (it != seg_to_size_itr_map_.end()) {
-    seg_by_size_.erase(it->second);
-    seg_to_size_itr_map_.erase(it);
+      return (a_num != b_num) ? a_num > b_num : a < b;
+    });
+
+  std::vector<size_t> shard_point_nums(shard_num_, 0);
+  std::vector<std::string> shard_names;
+
+  for (const auto & pcd_name : sorted_names) {
+    auto min_it = std::min_element(shard_point_nums.begin(), shard_point_nums.end());
+
+    *min_it += pcd_headers_.at(pcd_name).point_num;
+
+    if (min_it - shard_point_nums.begin() == shard_id_) {
+      shard_names.push_back(pcd_name);
+    }
   }
+
+  RCLCPP_INFO(
+    logger_, "Shard %d/%d divides %lu of %lu files, %lu points", shard_id_, shard_num_,
+    shard_names.size(), pcd_names.size(), shard_point_nums[shard_id_]);
+
+  return shard_names;
 }
 
 template <class PointT>
-void PCDDivider<PointT>::saveTheRest()
+int PCDDivider<PointT>::shardOfGrid(const GridInfo<2> & grid) const
 {
-  for (auto it = grid_to_cloud_.begin(); it != grid_to_cloud_.end(); ++it) {
-    auto & cloud = std::get<0>(it->second);
+  // Mix the bits of the hash, since the grid indices are multiples of the grid size
+  uint64_t h = std::hash<GridInfo<2>>{}(grid);
 
-    if (cloud.size() > 0) {
-      saveGridPCD(it);
-    }
-  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return static_cast<int>(h % static_cast<uint64_t>(shard_num_));
 }
 
 template <class PointT>
-void PCDDivider<PointT>::mergeAndDownsample()
+void PCDDivider<PointT>::mergeShard()
 {
-  // Scan the tmp directory and find the segment folders
-  fs::path tmp_path(tmp_dir_);
+  tmp_dir_ = output_dir_ + "/tmp/";
+
+  if (!fs::is_directory(tmp_dir_)) {
+    RCLCPP_ERROR(logger_, "Error: No divided shards in %s", tmp_dir_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
 
-  // Count the number of sub folders, to estimate progress
-  int seg_num = 0;
+  util::make_dir(output_dir_ + "/pointcloud_map.pcd/");
 
-  for (auto & entry : fs::directory_iterator(tmp_path)) {
-    if (fs::is_directory(entry.symlink_status())) {
-      ++seg_num;
-    }
+  for (const auto & lod_dir : lod_dirs_) {
+    util::make_dir(lod_dir + "/pointcloud_map.pcd/");
   }
 
-  for (auto & tmp_dir_entry : fs::directory_iterator(tmp_path)) {
-    if (fs::is_directory(tmp_dir_entry.symlink_status())) {
-      if (debug_mode_) {
-        RCLCPP_INFO(logger_, "Saving segment %s", tmp_dir_entry.path().string().c_str());
-      }
-      std::list<std::string> pcd_list;
-      size_t total_point_num = 0;
+  grid_set_.clear();
+  tile_records_.clear();
 
-      for (auto & seg_entry : fs::directory_iterator(tmp_dir_entry.path())) {
-        if (fs::is_regular_file(seg_entry.symlink_status())) {
-          auto fname = seg_entry.path().string();
-          auto ext = fname.substr(fname.size() - 4);
+  for (auto & ns : phase_ns_) {
+    ns = 0;
+  }
 
-          if (ext == ".pcd") {
-            pcd_list.push_back(fname);
-            total_point_num += util::point_num(fname);
-          }
-        }
-      }
+  full_save_num_ = spill_num_ = spilled_point_num_ = 0;
+  peak_resident_bytes_ = 0;
+  written_bytes_ = merged_seg_num_ = 0;
+  read_point_num_ = seg_num_ = checkpoint_num_ = 0;
+  start_time_ = last_report_time_ = std::chrono::steady_clock::now();
 
-      // Fuse all PCDs and downsample if necessary
-      mergeAndDownsample(tmp_dir_entry.path().string(), pcd_list, total_point_num);
-    }
+  RCLCPP_INFO(logger_, "Merge and downsampling the tiles of shard %d/%d...", shard_id_, shard_num_);
+
+  mergeAndDownsample();
+
+  // The tiles of all shards are combined by the final step
+  std::string shard_name = "shard_" + std::to_string(shard_id_);
+
+  saveGridInfoToYAML(tmp_dir_ + "metadata_" + shard_name + ".yaml");
+
+  if (save_tile_index_) {
+    writeTileIndex(tmp_dir_ + "index_" + shard_name + ".bin");
   }
 
-  // Remove tmp dir
-  util::remove(tmp_dir_);
+  reportSummary();
+
+  RCLCPP_INFO(logger_, "Shard %d/%d merged", shard_id_, shard_num_);
 }
 
 template <class PointT>
-void PCDDivider<PointT>::mergeAndDownsample(
-  const std::string & dir_path, std::list<std::string> & pcd_list, size_t total_point_num)
+void PCDDivider<PointT>::finalizeShards()
 {
-  PclCloudPtr new_cloud(new PclCloudType);
-
-  new_cloud->reserve(total_point_num);
+  tmp_dir_ = output_dir_ + "/tmp/";
+  grid_set_.clear();
+  tile_records_.clear();
 
-  // Merge all PCDs that belong to the specified segment to a single segment point cloud
-  for (auto & fname : pcd_list) {
-    PclCloudType seg_cloud;
+  // Every shard must have been merged
+  for (int shard_id = 0; shard_id < shard_num_; ++shard_id) {
+    std::string shard_yaml_path = tmp_dir_ + "metadata_shard_" + std::to_string(shard_id) + ".yaml";
 
-    if (pcl::io::loadPCDFile(fname, seg_cloud)) {
-      RCLCPP_ERROR(logger_, "Error: Failed to open a PCD file at %s", fname.c_str());
+    if (!fs::exists(shard_yaml_path)) {
+      RCLCPP_ERROR(
+        logger_, "Error: Shard %d is not merged, %s is missing", shard_id, shard_yaml_path.c_str());
       rclcpp::shutdown();
       exit(EXIT_FAILURE);
     }
 
-    for (auto & p : seg_cloud) {
-      new_cloud->push_back(p);
-    }
+    loadGridInfoFromYAML(shard_yaml_path);
   }
 
-  // Downsample if needed
-  if (leaf_size_ > 0) {
-    VoxelGridFilter<PointT> vgf;
-    PclCloudPtr filtered_cloud(new PclCloudType);
-
-    vgf.setResolution(leaf_size_);
-    vgf.filter(*new_cloud, *filtered_cloud);
+  std::string yaml_file_path = output_dir_ + "/pointcloud_map_metadata.yaml";
 
-    new_cloud = filtered_cloud;
+  if (incremental_update_) {
+    loadGridInfoFromYAML(yaml_file_path);
   }
 
-  // Save the new_cloud
-  // Extract segment name only (format gx_gy)
-  int end_name, start_name;
+  saveGridInfoToYAML(yaml_file_path);
 
-  for (end_name = dir_path.size() - 1; end_name >= 0 && dir_path[end_name] == '/'; --end_name) {
-  }
-  for (start_name = end_name; start_name >= 0 && dir_path[start_name] != '/'; --start_name) {
+  for (const auto & lod_dir : lod_dirs_) {
+    saveGridInfoToYAML(lod_dir + "/pointcloud_map_metadata.yaml");
   }
 
-  std::string seg_name_only = dir_path.substr(start_name + 1, end_name - start_name);
+  if (save_tile_index_) {
+    writeTileIndex(output_dir_ + "/pointcloud_map_index.bin");
+  }
 
-  // Parse the @seg_path to get the indices of the segment
-  auto underbar_pos = seg_name_only.rfind("_");
-  int gx = std::stoi(seg_name_only.substr(0, underbar_pos));
-  int gy = std::stoi(seg_name_only.substr(underbar_pos + 1));
+  util::remove(tmp_dir_);
 
-  grid_set_.insert(GridInfo<2>(gx, gy));
+  RCLCPP_INFO(logger_, "Done!");
+}
 
-  // Construct the path to save the new_cloud
-  std::string save_path;
+template <class PointT>
+typename pcl::PointCloud<PointT>::Ptr PCDDivider<PointT>::loadPCD(const std::string & pcd_name)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  if (pcd_name != reader_.get_path()) {
+    reader_.setInput(pcd_name);
+  }
 
-  // If save large pcd was turned on, create a folder to contain segment pcds
-  if (use_large_grid_) {
-    int large_gx = static_cast<int>(std::floor(static_cast<float>(gx) / g_grid_size_x_));
-    int large_gy = static_cast<int>(std::floor(static_cast<float>(gy) / g_grid_size_y_));
-    std::string large_folder = output_dir_ + "/pointcloud_map.pcd/" + std::to_string(large_gx) +
-                               "_" + std::to_string(large_gy) + "/";
+  PclCloudPtr cloud_ptr(new PclCloudType);
+  auto start = std::chrono::steady_clock::now();
 
-    // Create a new folder for the large grid
-    util::make_dir(large_folder);
+  reader_.readABlock(*cloud_ptr);
+  read_point_num_ += cloud_ptr->size();
 
-    save_path = large_folder + file_prefix_ + "_" + seg_name_only + ".pcd";
-  } else {
-    save_path = output_dir_ + "/pointcloud_map.pcd/" + file_prefix_ + "_" + seg_name_only + ".pcd";
+  if (point_transform_) {
+    point_transform_(*cloud_ptr);
   }
 
-  // Save the merged (filtered) cloud
-  if (pcl::io::savePCDFileBinary(save_path, *new_cloud)) {
-    RCLCPP_ERROR(logger_, "Error: Failed to save a point cloud at %s", save_path.c_str());
-    rclcpp::shutdown();
-    exit(EXIT_FAILURE);
-  }
+  addPhaseTime(READ, start);
 
-  // Delete the folder containing the segments
-  util::remove(dir_path);
+  return cloud_ptr;
 }
 
 template <class PointT>
-std::string PCDDivider<PointT>::makeFileName(const GridInfo<2> & grid) const
+void PCDDivider<PointT>::savePCD(const std::string & path, const pcl::PointCloud<PointT> & cloud)
+{
+  if (pcl::io::savePCDFileBinary(path, cloud) == -1) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save PCD: %s", path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::estimateGridPointNum(const std::vector<std::string> & pcd_names)
+{
+  estimated_point_num_.clear();
+  is_presized_ = false;
+
+  if (presize_sample_ratio_ <= 0 || pcd_names.empty()) {
+    return;
+  }
+
+  AUTOWARE_PROFILE_FUNCTION();
+  auto start = std::chrono::steady_clock::now();
+  double ratio = presize_sample_ratio_;
+  // The point transform may not be thread-safe, e.g. a projection, so it is run by one thread
+  size_t worker_num = point_transform_ ? 1 : std::min(thread_num_, pcd_names.size());
+  std::vector<GridHashMap<uint64_t, size_t, GridKeyHash>> histograms(worker_num);
+  std::vector<size_t> sampled_point_nums(worker_num, 0);
+  std::atomic<size_t> next_file{0};
+  std::vector<std::thread> workers;
+
+  workers.reserve(worker_num);
+
+  for (size_t wid = 0; wid < worker_num; ++wid) {
+    workers.emplace_back([&, wid]() {
+      CustomPCDReader<PointT> reader;
+      PclCloudType block;
+      auto & histogram = histograms[wid];
+      uint64_t keys[grid_key_block_size];
+
+      // Small blocks spread the sample over the whole map, and the skipped pages of mapped
+      // files are not read
+      reader.setMmapMode(true);
+      reader.setBlockSize(presize_block_size_);
+
+      for (size_t fid = next_file++; fid < pcd_names.size() && rclcpp::ok(); fid = next_file++) {
+        reader.setInput(pcd_names[fid]);
+
+        // A block is sampled when floor(block id * ratio) increases, i.e. evenly over the file
+        for (size_t bid = 0; reader.good(); ++bid) {
+          if (std::floor((bid + 1) * ratio) == std::floor(bid * ratio)) {
+            reader.skipABlock();
+            continue;
+          }
+
+          reader.readABlock(block);
+
+          if (point_transform_) {
+            point_transform_(block);
+          }
+
+          for (size_t i = 0; i < block.size(); i += grid_key_block_size) {
+            size_t num = std::min(grid_key_block_size, block.size() - i);
+
+            pointsToGridKeys2(&block[i], num, grid_size_x_, grid_size_y_, keys);
+
+            for (size_t j = 0; j < num; ++j) {
+              ++histogram[keys[j]];
+            }
+          }
+
+          sampled_point_nums[wid] += block.size();
+        }
+      }
+    });
+  }
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  size_t sampled_point_num = 0;
+
+  for (size_t wid = 0; wid < worker_num; ++wid) {
+    for (const auto & bin : histograms[wid]) {
+      estimated_point_num_[keyToGrid2(bin.first)] += bin.second;
+    }
+
+    sampled_point_num += sampled_point_nums[wid];
+  }
+
+  // Scale the sampled points to the whole input
+  for (auto & bin : estimated_point_num_) {
+    bin.second = static_cast<size_t>(std::ceil(bin.second / ratio));
+  }
+
+  is_presized_ = true;
+  addPhaseTime(READ, start);
+
+  RCLCPP_INFO(
+    logger_, "Estimated the points of %lu grids from %lu sampled points in %.1f s",
+    estimated_point_num_.size(), sampled_point_num,
+    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+template <class PointT>
+size_t PCDDivider<PointT>::reservedPointNum(const GridInfo<2> & grid) const
+{
+  if (!is_presized_) {
+    // With a byte budget, clouds grow on demand so that reserved memory stays small
+    return (memory_budget_ == 0) ? max_block_size_ : 0;
+  }
+
+  auto it = estimated_point_num_.find(grid);
+
+  // Grids missed by the sample are small, and grow on demand
+  if (it == estimated_point_num_.end()) {
+    return 0;
+  }
+
+  // A margin for the sampling error, the cloud grows on demand beyond it
+  return std::min(max_block_size_, it->second + it->second / 8 + presize_block_size_);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::dividePointCloud(const PclCloudPtr & cloud_ptr)
+{
+  if (!cloud_ptr || cloud_ptr->size() <= 0) {
+    return;
+  }
+
+  AUTOWARE_PROFILE_FUNCTION();
+  // Spills happen only in this thread, so their time can be excluded from dividing
+  auto start = std::chrono::steady_clock::now();
+  int64_t spill_ns = phase_ns_[SPILL];
+
+  divided_point_num_ += cloud_ptr->size();
+
+  if (thread_num_ > 1) {
+    dividePointCloudParallel(cloud_ptr);
+  } else {
+    for (const PointT p : *cloud_ptr) {
+      if (!rclcpp::ok()) {
+        rclcpp::shutdown();
+        exit(EXIT_SUCCESS);
+      }
+
+      auto grid = pointToGrid2(p, grid_size_x_, grid_size_y_);
+      auto it = findOrCreateGrid(grid);
+
+      if (addPointToGrid(it, p) && outlier_halo_ > 0) {
+        addPointToHalos(grid, p);
+      }
+    }
+  }
+
+  addPhaseTime(DIVIDE, start);
+  phase_ns_[DIVIDE] -= phase_ns_[SPILL] - spill_ns;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::dividePointCloudParallel(const PclCloudPtr & cloud_ptr)
+{
+  const auto & cloud = *cloud_ptr;
+  size_t worker_num = std::min(thread_num_, cloud.size());
+  size_t chunk_size = (cloud.size() + worker_num - 1) / worker_num;
+
+  // Each worker bins a contiguous chunk of the input into its own buckets. A bucket only
+  // keeps the indices of the points, so the cloud is not copied.
+  std::vector<GridHashMap<uint64_t, std::vector<size_t>, GridKeyHash>> buckets(worker_num);
+  std::vector<std::thread> workers;
+
+  workers.reserve(worker_num);
+
+  for (size_t wid = 0; wid < worker_num; ++wid) {
+    workers.emplace_back([&, wid]() {
+      size_t begin = wid * chunk_size;
+      size_t end = std::min(begin + chunk_size, cloud.size());
+      auto & local_buckets = buckets[wid];
+      uint64_t keys[grid_key_block_size];
+
+      for (size_t i = begin; i < end; i += grid_key_block_size) {
+        size_t num = std::min(grid_key_block_size, end - i);
+
+        pointsToGridKeys2(&cloud[i], num, grid_size_x_, grid_size_y_, keys);
+
+        for (size_t j = 0; j < num; ++j) {
+          local_buckets[keys[j]].push_back(i + j);
+        }
+      }
+    });
+  }
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  // Merge the buckets following the order of chunks. Points of a grid are then appended
+  // in the same order as the serial version, so the output segments do not change.
+  for (auto & local_buckets : buckets) {
+    for (auto & bucket : local_buckets) {
+      if (!rclcpp::ok()) {
+        rclcpp::shutdown();
+        exit(EXIT_SUCCESS);
+      }
+
+      auto grid = keyToGrid2(bucket.first);
+      auto it = findOrCreateGrid(grid);
+
+      for (auto pid : bucket.second) {
+        if (addPointToGrid(it, cloud[pid]) && outlier_halo_ > 0) {
+          addPointToHalos(grid, cloud[pid]);
+        }
+      }
+    }
+
+    // Release the memory of the merged buckets as soon as possible
+    local_buckets.clear();
+  }
+}
+
+template <class PointT>
+typename PCDDivider<PointT>::GridMapItr PCDDivider<PointT>::findOrCreateGrid(
+  const GridInfo<2> & grid)
+{
+  auto it = grid_to_cloud_.find(grid);
+
+  // If the grid has not existed yet, create a new one
+  if (it == grid_to_cloud_.end()) {
+    it = grid_to_cloud_.emplace(grid, typename GridMapType::mapped_type()).first;
+
+    std::get<0>(it->second).reserve(reservedPointNum(grid));
+    resident_bytes_ += reservedBytes(std::get<0>(it->second));
+
+    // Counter set to 0, or after the segments saved before the checkpoint of a resumed run
+    auto counter_it = resumed_counters_.find(grid);
+
+    std::get<1>(it->second) = (counter_it != resumed_counters_.end()) ? counter_it->second : 0;
+    std::get<2>(it->second) = 0;  // Prev size is 0
+    std::get<3>(it->second) = 0;  // Not touched yet
+  }
+
+  return it;
+}
+
+template <class PointT>
+bool PCDDivider<PointT>::addPointToGrid(GridMapItr & grid_it, const PointT & p)
+{
+  auto & cloud = std::get<0>(grid_it->second);
+  auto & prev_size = std::get<2>(grid_it->second);
+  size_t old_bytes = reservedBytes(cloud);
+
+  if (duplicate_resolution_ > 0) {
+    auto & keys = std::get<4>(grid_it->second);
+    size_t old_key_bytes = keys.bytes();
+    bool is_new = keys.insert(duplicate_key(p, grid_it->first, inv_duplicate_resolution_));
+
+    resident_bytes_ += keys.bytes() - old_key_bytes;
+
+    if (!is_new) {
+      ++duplicate_point_num_;
+      return false;
+    }
+  }
+
+  cloud.push_back(p);
+
+  ++resident_point_num_;
+  resident_bytes_ += reservedBytes(cloud) - old_bytes;
+  peak_resident_bytes_ = std::max(peak_resident_bytes_, resident_bytes_);
+  std::get<3>(grid_it->second) = ++touch_time_;
+
+  // If the number of points in the segment reach maximum, save the segment to file
+  if (cloud.size() == max_block_size_) {
+    ++full_save_num_;
+    saveGridPCD(grid_it);
+  } else if (!is_presized_) {
+    // Otherwise, update the seg_by_size_ if the change of size is significant. Presized runs
+    // look for the biggest segment only when they spill, which is rare with the reservations
+    // following the estimates
+    if (cloud.size() - prev_size >= 10000) {
+      prev_size = cloud.size();
+      auto seg_to_size_it = seg_to_size_itr_map_.find(grid_it->first);
+
+      if (seg_to_size_it == seg_to_size_itr_map_.end()) {
+        auto size_it = seg_by_size_.insert(std::make_pair(prev_size, grid_it));
+        seg_to_size_itr_map_[grid_it->first] = size_it;
+      } else {
+        seg_by_size_.erase(seg_to_size_it->second);
+        auto new_size_it = seg_by_size_.insert(std::make_pair(prev_size, grid_it));
+        seg_to_size_it->second = new_size_it;
+      }
+    }
+  }
+
+  // If the resident points reach the limit, save a resident segment to SSD
+  if (isOverMemoryLimit()) {
+    spillSegment();
+  }
+
+  return true;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::addPointToHalos(const GridInfo<2> & grid, const PointT & p)
+{
+  const double offsets[3] = {-outlier_halo_, 0.0, outlier_halo_};
+  GridInfo<2> halo_grids[9];
+  size_t halo_num = 0;
+
+  // The halo is smaller than the grids, so the neighbors are the grids of the corners of the
+  // square around the point
+  for (auto dx : offsets) {
+    for (auto dy : offsets) {
+      PointT q = p;
+
+      q.x += dx;
+      q.y += dy;
+
+      auto halo_grid = pointToGrid2(q, grid_size_x_, grid_size_y_);
+
+      if (halo_grid == grid || std::find(halo_grids, halo_grids + halo_num, halo_grid) !=
+                                 halo_grids + halo_num) {
+        continue;
+      }
+
+      halo_grids[halo_num++] = halo_grid;
+
+      auto halo_it = halo_to_cloud_.try_emplace(halo_grid).first;
+      auto & halo = halo_it->second.first;
+      size_t old_bytes = reservedBytes(halo);
+
+      halo.push_back(p);
+      resident_bytes_ += reservedBytes(halo) - old_bytes;
+      peak_resident_bytes_ = std::max(peak_resident_bytes_, resident_bytes_);
+
+      if (halo.size() >= max_block_size_) {
+        saveHalo(halo_it);
+      }
+    }
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveHalo(typename HaloMapType::iterator halo_it)
+{
+  auto & cloud = halo_it->second.first;
+  auto & counter = halo_it->second.second;
+  std::ostringstream seg_path, file_path;
+
+  seg_path << tmp_dir_ << "/" << halo_it->first << "/";
+  file_path << seg_path.str() << "halo_" << counter << "_" << cloud.size() << ".pcd";
+
+  resident_bytes_ -= reservedBytes(cloud);
+
+  if (use_async_io_) {
+    PclCloudPtr cloud_ptr(new PclCloudType);
+
+    cloud_ptr->swap(cloud);
+    enqueueWrite(seg_path.str(), file_path.str(), halo_it->first, cloud_ptr);
+  } else {
+    writeSegment(seg_path.str(), file_path.str(), cloud);
+  }
+
+  cloud = PclCloudType();
+  ++counter;
+}
+
+template <class PointT>
+size_t PCDDivider<PointT>::removeDuplicates(const GridInfo<2> & grid, PclCloudType & cloud) const
+{
+  DuplicateKeySet keys;
+  size_t kept_num = 0;
+
+  keys.reserve(cloud.size());
+
+  for (size_t pid = 0; pid < cloud.size(); ++pid) {
+    if (keys.insert(duplicate_key(cloud[pid], grid, inv_duplicate_resolution_))) {
+      cloud[kept_num++] = cloud[pid];
+    }
+  }
+
+  size_t removed_num = cloud.size() - kept_num;
+
+  cloud.resize(kept_num);
+
+  return removed_num;
+}
+
+template <class PointT>
+bool PCDDivider<PointT>::isOverMemoryLimit() const
+{
+  if (memory_budget_ > 0) {
+    return resident_bytes_ >= resident_byte_limit_;
+  }
+
+  return resident_point_num_ >= resident_limit_;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::spillSegment()
+{
+  auto victim = grid_to_cloud_.end();
+
+  if (spill_policy_ == "lru") {
+    // The segment that has not received points for the longest time
+    for (auto it = grid_to_cloud_.begin(); it != grid_to_cloud_.end(); ++it) {
+      if (
+        std::get<0>(it->second).size() > 0 &&
+        (victim == grid_to_cloud_.end() || std::get<3>(it->second) < std::get<3>(victim->second))) {
+        victim = it;
+      }
+    }
+  } else if (!seg_by_size_.empty()) {
+    // The biggest resident segment
+    victim = seg_by_size_.rbegin()->second;
+  } else {
+    // No segment is big enough to be in seg_by_size_, look for the biggest one
+    for (auto it = grid_to_cloud_.begin(); it != grid_to_cloud_.end(); ++it) {
+      if (
+        victim == grid_to_cloud_.end() ||
+        std::get<0>(it->second).size() > std::get<0>(victim->second).size()) {
+        victim = it;
+      }
+    }
+  }
+
+  if (victim == grid_to_cloud_.end() || std::get<0>(victim->second).size() == 0) {
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  ++spill_num_;
+  spilled_point_num_ += std::get<0>(victim->second).size();
+  saveGridPCD(victim);
+  addPhaseTime(SPILL, start);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveGridPCD(GridMapItr & grid_it)
+{
+  auto & cloud = std::get<0>(grid_it->second);
+  auto & counter = std::get<1>(grid_it->second);
+  auto & prev_size = std::get<2>(grid_it->second);
+
+  // Try to create a new directory to contain the cloud
+  std::ostringstream seg_path, file_path;
+
+  seg_path << tmp_dir_ << "/" << grid_it->first << "/";
+  file_path << seg_path.str() << counter << "_" << cloud.size() << ".pcd";
+
+  size_t saved_point_num = cloud.size();
+
+  resident_point_num_ -= saved_point_num;
+
+  if (appendToTiles()) {
+    // The tile is written by appendToTile, no need for the tmp paths
+    seg_path.str("");
+  }
+
+  if (use_async_io_) {
+    // Hand the points over to the writer thread
+    PclCloudPtr cloud_ptr(new PclCloudType);
+
+    cloud_ptr->swap(cloud);
+    enqueueWrite(seg_path.str(), file_path.str(), grid_it->first, cloud_ptr);
+  } else if (appendToTiles()) {
+    appendToTile(grid_it->first, cloud);
+  } else {
+    writeSegment(seg_path.str(), file_path.str(), cloud);
+  }
+
+  // Clear the content of the segment cloud and reserve space for further points. Duplicates of
+  // the saved points are removed when the segment is merged
+  resident_bytes_ -= reservedBytes(cloud) + std::get<4>(grid_it->second).bytes();
+  std::get<4>(grid_it->second).clear();
+
+  if (is_presized_) {
+    // Reserve the estimated points that have not been saved yet
+    auto estimate_it = estimated_point_num_.find(grid_it->first);
+
+    if (estimate_it != estimated_point_num_.end()) {
+      estimate_it->second -= std::min(estimate_it->second, saved_point_num);
+    }
+
+    cloud = PclCloudType();
+    cloud.reserve(reservedPointNum(grid_it->first));
+  } else if (memory_budget_ > 0) {
+    // Release the memory, the cloud grows again on demand
+    cloud = PclCloudType();
+  } else {
+    cloud.clear();
+    cloud.reserve(max_block_size_);
+  }
+
+  resident_bytes_ += reservedBytes(cloud);
+  ++counter;  // Increase the counter so the next segment save will not overwrite the previously
+              // saved one
+  prev_size = 0;
+
+  // Update the seg_by_size_ and seg_to_size_itr_map_
+  auto it = seg_to_size_itr_map_.find(grid_it->first);
+
+  if (it != seg_to_size_itr_map_.end()) {
+    seg_by_size_.erase(it->second);
+    seg_to_size_itr_map_.erase(it);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::writeSegment(
+  const std::string & seg_path, const std::string & file_path, const PclCloudType & cloud)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  util::make_dir(seg_path);
+
+  if (use_io_uring_) {
+    seg_writer_.setOutput(file_path);
+    seg_writer_.writeMetadata(cloud.size(), true);
+    seg_writer_.write(cloud);
+    seg_writer_.close();
+  } else if (pcl::io::savePCDFileBinary(file_path, cloud)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save a PCD file at %s", file_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  written_bytes_ += util::file_size(file_path);
+  addPhaseTime(WRITE, start);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::startWriter()
+{
+  stopWriter();
+
+  writer_stop_ = false;
+  writer_thread_ = std::thread([this]() {
+    std::unique_lock<std::mutex> lock(write_mtx_);
+
+    while (true) {
+      write_cv_.wait(lock, [this]() { return writer_stop_ || !write_queue_.empty(); });
+
+      if (write_queue_.empty()) {
+        // Stop was requested and there is nothing left to write
+        break;
+      }
+
+      auto job = std::move(write_queue_.front());
+
+      write_queue_.pop_front();
+
+      // Write without holding the lock, so the dividing thread can keep pushing segments
+      lock.unlock();
+
+      auto & cloud_ptr = std::get<3>(job);
+
+      if (std::get<0>(job).empty()) {
+        appendToTile(std::get<2>(job), *cloud_ptr);
+      } else {
+        writeSegment(std::get<0>(job), std::get<1>(job), *cloud_ptr);
+      }
+
+      size_t written_point_num = cloud_ptr->size();
+
+      cloud_ptr.reset();
+      lock.lock();
+      queued_point_num_ -= written_point_num;
+      write_cv_.notify_all();
+    }
+  });
+}
+
+template <class PointT>
+void PCDDivider<PointT>::stopWriter()
+{
+  if (!writer_thread_.joinable()) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(write_mtx_);
+    writer_stop_ = true;
+  }
+
+  write_cv_.notify_all();
+  writer_thread_.join();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::waitWriter()
+{
+  if (!writer_thread_.joinable()) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(write_mtx_);
+
+  // The writer releases the points of a job after saving it
+  write_cv_.wait(lock, [this]() { return queued_point_num_ == 0; });
+}
+
+template <class PointT>
+void PCDDivider<PointT>::enqueueWrite(
+  const std::string & seg_path, const std::string & file_path, const GridInfo<2> & grid,
+  const PclCloudPtr & cloud_ptr)
+{
+  std::unique_lock<std::mutex> lock(write_mtx_);
+
+  // Block until the writer frees enough room, so the queue stays within its point budget
+  write_cv_.wait(lock, [this, &cloud_ptr]() {
+    return queued_point_num_ == 0 ||
+           queued_point_num_ + cloud_ptr->size() <= max_queued_point_num_;
+  });
+
+  queued_point_num_ += cloud_ptr->size();
+  write_queue_.emplace_back(seg_path, file_path, grid, cloud_ptr);
+  write_cv_.notify_all();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveTheRest()
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  for (auto it = grid_to_cloud_.begin(); it != grid_to_cloud_.end(); ++it) {
+    auto & cloud = std::get<0>(it->second);
+    auto & counter = std::get<1>(it->second);
+
+    if (cloud.size() <= 0) {
+      continue;
+    }
+
+    if (
+      use_direct_write_ && counter == 0 && !appendToTiles() && shard_mode_ != "divide" &&
+      outlier_mean_k_ <= 0) {
+      // All points of the segment are in the memory, so it becomes a tile right away
+      PclCloudPtr cloud_ptr(new PclCloudType);
+
+      resident_point_num_ -= cloud.size();
+      resident_bytes_ -= reservedBytes(cloud) + std::get<4>(it->second).bytes();
+      std::get<4>(it->second).clear();
+      cloud_ptr->swap(cloud);
+      saveTile(it->first, cloud_ptr, thread_num_);
+    } else {
+      saveGridPCD(it);
+    }
+  }
+
+  for (auto halo_it = halo_to_cloud_.begin(); halo_it != halo_to_cloud_.end(); ++halo_it) {
+    if (halo_it->second.first.size() > 0) {
+      saveHalo(halo_it);
+    }
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::appendToTile(const GridInfo<2> & grid, const PclCloudType & cloud)
+{
+  auto start = std::chrono::steady_clock::now();
+  auto tile_it = tile_point_num_.find(grid);
+
+  if (tile_it == tile_point_num_.end()) {
+    // Create the tile. The number of points in the metadata is updated by finalizeTiles
+    tile_it = tile_point_num_.emplace(grid, 0).first;
+
+    tile_writer_.setResizableMetadata(true);
+    tile_writer_.setOutput(makeTilePath(grid));
+    tile_writer_.writeMetadata(0, true);
+  } else {
+    tile_writer_.appendOutput(makeTilePath(grid));
+  }
+
+  tile_writer_.setBlockSize(max_block_size_);
+  tile_writer_.write(cloud);
+  tile_it->second += cloud.size();
+  tile_writer_.updateMetadata(tile_it->second);
+  updateTileRecord(grid, cloud);
+
+  written_bytes_ += cloud.size() * tile_writer_.point_size();
+  addPhaseTime(WRITE, start);
+}
+
+template <class PointT>
+void PCDDivider<PointT>::finalizeTiles()
+{
+  // Close the last opening tile
+  tile_writer_.close();
+
+  for (auto & tile : tile_point_num_) {
+    grid_set_.insert(tile.first);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::mergeAndDownsample()
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  // The tmp directory of a distributed run has the segment folders of every shard
+  std::vector<fs::path> seg_roots;
+
+  if (shard_mode_ == "merge") {
+    for (auto & shard_entry : fs::directory_iterator(tmp_dir_)) {
+      if (
+        fs::is_directory(shard_entry.symlink_status()) &&
+        shard_entry.path().filename().string().rfind("shard_", 0) == 0) {
+        seg_roots.push_back(shard_entry.path());
+      }
+    }
+  } else {
+    seg_roots.push_back(tmp_dir_);
+  }
+
+  // Segment folders of every grid, the PCD files in them, their number of points, and the files
+  // of the halo of the grid
+  typedef std::tuple<
+    std::vector<std::string>, std::list<std::string>, size_t, std::list<std::string>>
+    SegmentType;
+  std::unordered_map<GridInfo<2>, SegmentType> seg_map;
+
+  for (const auto & seg_root : seg_roots) {
+    for (auto & tmp_dir_entry : fs::directory_iterator(seg_root)) {
+      if (!fs::is_directory(tmp_dir_entry.symlink_status())) {
+        continue;
+      }
+
+      auto grid = parseGridName(tmp_dir_entry.path().filename().string());
+
+      if (shard_mode_ == "merge" && shardOfGrid(grid) != shard_id_) {
+        continue;
+      }
+
+      auto & seg = seg_map[grid];
+
+      std::get<0>(seg).push_back(tmp_dir_entry.path().string());
+
+      for (auto & seg_entry : fs::directory_iterator(tmp_dir_entry.path())) {
+        if (fs::is_regular_file(seg_entry.symlink_status())) {
+          auto fname = seg_entry.path().string();
+          auto ext = fname.substr(fname.size() - 4);
+
+          if (ext != ".pcd") {
+            continue;
+          }
+
+          if (seg_entry.path().filename().string().rfind("halo_", 0) == 0) {
+            std::get<3>(seg).push_back(fname);
+          } else {
+            std::get<1>(seg).push_back(fname);
+            std::get<2>(seg) += util::point_num(fname);
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<SegmentType> segments;
+
+  segments.reserve(seg_map.size());
+
+  // Grids with halo points only are outside the map
+  for (auto & seg : seg_map) {
+    if (!std::get<1>(seg.second).empty()) {
+      segments.push_back(std::move(seg.second));
+    }
+  }
+
+  size_t worker_num = std::min(thread_num_, segments.size());
+
+  seg_num_ = segments.size();
+
+  if (worker_num <= 1) {
+    for (auto & seg : segments) {
+      if (debug_mode_) {
+        RCLCPP_INFO(logger_, "Saving segment %s", std::get<0>(seg).front().c_str());
+      }
+
+      // Fuse all PCDs and downsample if necessary
+      mergeAndDownsample(
+        std::get<0>(seg), std::get<1>(seg), std::get<3>(seg), std::get<2>(seg), thread_num_);
+      ++merged_seg_num_;
+      reportProgress();
+    }
+  } else {
+    // Merge multiple segments at once. A segment starts only when the points of all
+    // segments in progress fit into the memory limit, except when it is the only one
+    size_t point_budget =
+      (memory_budget_ > 0) ? memory_budget_ / sizeof(PointT) : max_resident_point_num_;
+    std::mutex mtx;
+    std::condition_variable cv;
+    size_t next_seg = 0;
+    size_t in_progress_point_num = 0;
+    std::vector<std::thread> workers;
+
+    workers.reserve(worker_num);
+
+    for (size_t wid = 0; wid < worker_num; ++wid) {
+      workers.emplace_back([&]() {
+        while (rclcpp::ok()) {
+          std::unique_lock<std::mutex> lock(mtx);
+
+          if (next_seg >= segments.size()) {
+            break;
+          }
+
+          auto & seg = segments[next_seg++];
+          size_t seg_point_num = std::get<2>(seg);
+
+          cv.wait(lock, [&]() {
+            return in_progress_point_num == 0 ||
+                   in_progress_point_num + seg_point_num <= point_budget;
+          });
+
+          in_progress_point_num += seg_point_num;
+          lock.unlock();
+
+          if (debug_mode_) {
+            RCLCPP_INFO(logger_, "Saving segment %s", std::get<0>(seg).front().c_str());
+          }
+
+          // Each worker filters its segment with a single thread
+          mergeAndDownsample(
+            std::get<0>(seg), std::get<1>(seg), std::get<3>(seg), seg_point_num, 1);
+          ++merged_seg_num_;
+          reportProgress();
+
+          lock.lock();
+          in_progress_point_num -= seg_point_num;
+          cv.notify_all();
+        }
+      });
+    }
+
+    for (auto & worker : workers) {
+      worker.join();
+    }
+  }
+
+  // Remove tmp dir. That of a distributed run is removed by the final step
+  if (shard_mode_ != "merge") {
+    util::remove(tmp_dir_);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::mergeAndDownsample(
+  const std::vector<std::string> & dir_paths, std::list<std::string> & pcd_list,
+  const std::list<std::string> & halo_list, size_t total_point_num, size_t filter_thread_num)
+{
+  AUTOWARE_PROFILE_SCOPE("mergeAndDownsampleSegment");
+  PclCloudPtr new_cloud(new PclCloudType);
+  auto start = std::chrono::steady_clock::now();
+
+  new_cloud->reserve(total_point_num);
+
+  // Merge all PCDs that belong to the specified segment to a single segment point cloud
+  for (auto & fname : pcd_list) {
+    PclCloudType seg_cloud;
+
+    if (pcl::io::loadPCDFile(fname, seg_cloud)) {
+      RCLCPP_ERROR(logger_, "Error: Failed to open a PCD file at %s", fname.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    for (auto & p : seg_cloud) {
+      new_cloud->push_back(p);
+    }
+  }
+
+  // The segment folders are named gx_gy
+  auto grid = parseGridName(fs::path(dir_paths.front()).filename().string());
+
+  // The parts were deduplicated separately while dividing
+  if (duplicate_resolution_ > 0 && pcd_list.size() > 1) {
+    duplicate_point_num_ += removeDuplicates(grid, *new_cloud);
+  }
+
+  addPhaseTime(MERGE, start);
+
+  // Outliers are removed before downsampling, so they do not shift the centroids of the voxels
+  if (outlier_mean_k_ > 0) {
+    StatisticalOutlierFilter<PointT> sof;
+    PclCloudType halo;
+
+    start = std::chrono::steady_clock::now();
+
+    for (auto & fname : halo_list) {
+      PclCloudType halo_cloud;
+
+      if (pcl::io::loadPCDFile(fname, halo_cloud)) {
+        RCLCPP_ERROR(logger_, "Error: Failed to open a PCD file at %s", fname.c_str());
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+
+      halo.insert(halo.end(), halo_cloud.begin(), halo_cloud.end());
+    }
+
+    sof.setMeanK(outlier_mean_k_);
+    sof.setStddevMult(outlier_stddev_mult_);
+    sof.setThreadNum(filter_thread_num);
+    outlier_point_num_ += sof.filter(new_cloud, halo);
+    addPhaseTime(DOWNSAMPLE, start);
+  }
+  saveTile(grid, new_cloud, filter_thread_num);
+
+  // Delete the folders containing the segments
+  for (const auto & dir_path : dir_paths) {
+    util::remove(dir_path);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveTile(
+  const GridInfo<2> & grid, PclCloudPtr cloud, size_t filter_thread_num)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  auto start = std::chrono::steady_clock::now();
+
+  // Downsample if needed
+  if (leaf_size_ > 0) {
+    VoxelGridFilter<PointT> vgf;
+    PclCloudPtr filtered_cloud(new PclCloudType);
+
+    vgf.setResolution(leaf_size_);
+    vgf.setSortMode(use_sort_voxel_filter_);
+    vgf.setCudaMode(use_cuda_voxel_filter_);
+    vgf.setThreadNum(filter_thread_num);
+    vgf.filter(*cloud, *filtered_cloud);
+
+    cloud = filtered_cloud;
+    addPhaseTime(DOWNSAMPLE, start);
+  }
+
+  if (use_morton_order_) {
+    start = std::chrono::steady_clock::now();
+    sortByMortonOrder(*cloud);
+    addPhaseTime(MERGE, start);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(grid_set_mtx_);
+    grid_set_.insert(grid);
+  }
+
+  updateTileRecord(grid, *cloud);
+
+  std::string save_path = makeTilePath(grid);
+
+  start = std::chrono::steady_clock::now();
+
+  // Save the merged (filtered) cloud
+  int save_ret = use_compression_ ? pcl::io::savePCDFileBinaryCompressed(save_path, *cloud)
+                                  : pcl::io::savePCDFileBinary(save_path, *cloud);
+
+  if (save_ret) {
+    RCLCPP_ERROR(logger_, "Error: Failed to save a point cloud at %s", save_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  written_bytes_ += util::file_size(save_path);
+  addPhaseTime(WRITE, start);
+
+  // Each level of detail is downsampled from the previous one
+  for (size_t level = 0; level < lod_leaf_sizes_.size(); ++level) {
+    VoxelGridFilter<PointT> vgf;
+    PclCloudPtr filtered_cloud(new PclCloudType);
+
+    start = std::chrono::steady_clock::now();
+    vgf.setResolution(lod_leaf_sizes_[level]);
+    vgf.setSortMode(use_sort_voxel_filter_);
+    vgf.setCudaMode(use_cuda_voxel_filter_);
+    vgf.setThreadNum(filter_thread_num);
+    vgf.filter(*cloud, *filtered_cloud);
+    cloud = filtered_cloud;
+    addPhaseTime(DOWNSAMPLE, start);
+
+    if (use_morton_order_) {
+      start = std::chrono::steady_clock::now();
+      sortByMortonOrder(*cloud);
+      addPhaseTime(MERGE, start);
+    }
+
+    start = std::chrono::steady_clock::now();
+    save_path = makeLodTilePath(level, grid);
+    save_ret = use_compression_ ? pcl::io::savePCDFileBinaryCompressed(save_path, *cloud)
+                                : pcl::io::savePCDFileBinary(save_path, *cloud);
+
+    if (save_ret) {
+      RCLCPP_ERROR(logger_, "Error: Failed to save a point cloud at %s", save_path.c_str());
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    written_bytes_ += util::file_size(save_path);
+    addPhaseTime(WRITE, start);
+  }
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeTilePath(const GridInfo<2> & grid, bool create_dir)
+{
+  std::string seg_name_only = std::to_string(grid.ix) + "_" + std::to_string(grid.iy);
+
+  // If save large pcd was turned on, create a folder to contain segment pcds
+  if (use_large_grid_) {
+    int large_gx = static_cast<int>(std::floor(static_cast<float>(grid.ix) / g_grid_size_x_));
+    int large_gy = static_cast<int>(std::floor(static_cast<float>(grid.iy) / g_grid_size_y_));
+    std::string large_folder = output_dir_ + "/pointcloud_map.pcd/" + std::to_string(large_gx) +
+                               "_" + std::to_string(large_gy) + "/";
+
+    // Create a new folder for the large grid
+    if (create_dir) {
+      util::make_dir(large_folder);
+    }
+
+    return large_folder + file_prefix_ + "_" + seg_name_only + ".pcd";
+  }
+
+  return output_dir_ + "/pointcloud_map.pcd/" + file_prefix_ + "_" + seg_name_only + ".pcd";
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeLodTilePath(size_t level, const GridInfo<2> & grid)
+{
+  // The tiles of a level are laid out as those of the output
+  std::string rel_path = makeTilePath(grid, false).substr(output_dir_.size());
+  std::string lod_path = lod_dirs_[level] + rel_path;
+
+  fs::create_directories(fs::path(lod_path).parent_path());
+
+  return lod_path;
+}
+
+template <class PointT>
+std::string PCDDivider<PointT>::makeFileName(const GridInfo<2> & grid) const
 {
   return file_prefix_ + "_" + std::to_string(grid.ix) + "_" + std::to_string(grid.iy) + ".pcd";
 }
@@ -442,6 +1741,90 @@ void PCDDivider<PointT>::paramInitialize()
     leaf_size_ = params["leaf_size"].as<double>();
     grid_size_x_ = params["grid_size_x"].as<double>();
     grid_size_y_ = params["grid_size_y"].as<double>();
+
+    if (params["thread_num"]) {
+      setThreadNum(params["thread_num"].as<int>());
+    }
+
+    if (params["use_async_io"]) {
+      use_async_io_ = params["use_async_io"].as<bool>();
+    }
+
+    if (params["use_io_uring"]) {
+      use_io_uring_ = params["use_io_uring"].as<bool>();
+    }
+
+    if (params["use_compression"]) {
+      use_compression_ = params["use_compression"].as<bool>();
+    }
+
+    if (params["use_sort_voxel_filter"]) {
+      use_sort_voxel_filter_ = params["use_sort_voxel_filter"].as<bool>();
+    }
+
+    if (params["use_cuda_voxel_filter"]) {
+      use_cuda_voxel_filter_ = params["use_cuda_voxel_filter"].as<bool>();
+    }
+
+    if (params["use_direct_write"]) {
+      use_direct_write_ = params["use_direct_write"].as<bool>();
+    }
+
+    if (params["use_incremental_update"]) {
+      incremental_update_ = params["use_incremental_update"].as<bool>();
+    }
+
+    if (params["memory_budget_mb"]) {
+      setMemoryBudget(params["memory_budget_mb"].as<int>());
+    }
+
+    if (params["presize_sample_ratio"]) {
+      setPresizeSampleRatio(params["presize_sample_ratio"].as<double>());
+    }
+
+    if (params["spill_policy"]) {
+      spill_policy_ = params["spill_policy"].as<std::string>();
+    }
+
+    if (params["progress_interval"]) {
+      progress_interval_ = params["progress_interval"].as<double>();
+    }
+
+    if (params["checkpoint_interval"]) {
+      checkpoint_interval_ = params["checkpoint_interval"].as<double>();
+    }
+
+    if (params["summary_file"]) {
+      summary_file_ = params["summary_file"].as<std::string>();
+    }
+
+    if (params["duplicate_resolution"]) {
+      duplicate_resolution_ = params["duplicate_resolution"].as<double>();
+    }
+
+    if (params["outlier_mean_k"]) {
+      outlier_mean_k_ = params["outlier_mean_k"].as<int>();
+    }
+
+    if (params["outlier_stddev_mult"]) {
+      outlier_stddev_mult_ = params["outlier_stddev_mult"].as<double>();
+    }
+
+    if (params["outlier_halo"]) {
+      outlier_halo_ = params["outlier_halo"].as<double>();
+    }
+
+    if (params["use_morton_order"]) {
+      use_morton_order_ = params["use_morton_order"].as<bool>();
+    }
+
+    if (params["save_tile_index"]) {
+      save_tile_index_ = params["save_tile_index"].as<bool>();
+    }
+
+    if (params["lod_leaf_sizes"]) {
+      lod_leaf_sizes_ = params["lod_leaf_sizes"].as<std::vector<double>>();
+    }
   } catch (YAML::Exception & e) {
     RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
     rclcpp::shutdown();
@@ -452,13 +1835,59 @@ void PCDDivider<PointT>::paramInitialize()
   g_grid_size_y_ = grid_size_y_ * 10;
 }
 
+template <class PointT>
+void PCDDivider<PointT>::loadGridInfoFromYAML(const std::string & yaml_file_path)
+{
+  if (!fs::exists(yaml_file_path)) {
+    RCLCPP_WARN(
+      logger_, "No metadata found at %s. All tiles will be generated.", yaml_file_path.c_str());
+    return;
+  }
+
+  try {
+    YAML::Node metadata = YAML::LoadFile(yaml_file_path);
+
+    // The existing tiles must have the same size as the new ones
+    double x_res = metadata["x_resolution"].as<double>();
+    double y_res = metadata["y_resolution"].as<double>();
+
+    if (std::abs(x_res - grid_size_x_) > 1e-6 || std::abs(y_res - grid_size_y_) > 1e-6) {
+      RCLCPP_ERROR(
+        logger_, "Error: The existing tiles are %f x %f while the grid size is %f x %f", x_res,
+        y_res, grid_size_x_, grid_size_y_);
+      rclcpp::shutdown();
+      exit(EXIT_FAILURE);
+    }
+
+    for (const auto & entry : metadata) {
+      auto key = entry.first.as<std::string>();
+
+      if (key == "x_resolution" || key == "y_resolution") {
+        continue;
+      }
+
+      grid_set_.insert(GridInfo<2>(entry.second[0].as<int>(), entry.second[1].as<int>()));
+    }
+  } catch (YAML::Exception & e) {
+    RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  RCLCPP_INFO(
+    logger_, "Loaded %lu existing tiles from %s", grid_set_.size(), yaml_file_path.c_str());
+}
+
 template <class PointT>
 void PCDDivider<PointT>::saveGridInfoToYAML(const std::string & yaml_file_path)
 {
-  std::ofstream yaml_file(yaml_file_path);
+  // Write to a temporary file first, then replace the old metadata with it, so readers
+  // never see a partially written metadata file
+  std::string tmp_yaml_file_path = yaml_file_path + ".tmp";
+  std::ofstream yaml_file(tmp_yaml_file_path);
 
   if (!yaml_file.is_open()) {
-    RCLCPP_ERROR(logger_, "Error: Cannot open YAML file: %s", yaml_file_path.c_str());
+    RCLCPP_ERROR(logger_, "Error: Cannot open YAML file: %s", tmp_yaml_file_path.c_str());
     rclcpp::shutdown();
     exit(EXIT_FAILURE);
   }
@@ -473,9 +1902,416 @@ void PCDDivider<PointT>::saveGridInfoToYAML(const std::string & yaml_file_path)
   }
 
   yaml_file.close();
+
+  std::error_code ec;
+
+  fs::rename(tmp_yaml_file_path, yaml_file_path, ec);
+
+  if (ec) {
+    RCLCPP_ERROR(
+      logger_, "Error: Cannot save YAML file %s: %s", yaml_file_path.c_str(), ec.message().c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+}
+
+template <class PointT>
+bool PCDDivider<PointT>::loadCheckpoint(const std::vector<std::string> & pcd_names)
+{
+  std::string checkpoint_path = checkpointPath();
+
+  if (!fs::exists(checkpoint_path)) {
+    return false;
+  }
+
+  size_t file_id = 0, block_num = 0, divided_point_num = 0;
+  std::unordered_map<GridInfo<2>, int> counters, halo_counters;
+
+  try {
+    YAML::Node checkpoint = YAML::LoadFile(checkpoint_path);
+
+    if (
+      checkpoint["inputs"].as<std::vector<std::string>>() != pcd_names ||
+      checkpoint["input_point_num"].as<size_t>() != input_point_num_ ||
+      std::abs(checkpoint["grid_size_x"].as<double>() - grid_size_x_) > 1e-6 ||
+      std::abs(checkpoint["grid_size_y"].as<double>() - grid_size_y_) > 1e-6) {
+      RCLCPP_WARN(
+        logger_, "The checkpoint at %s is not of these inputs and grids, the run starts over",
+        checkpoint_path.c_str());
+      return false;
+    }
+
+    file_id = checkpoint["file_id"].as<size_t>();
+    block_num = checkpoint["block_num"].as<size_t>();
+    divided_point_num = checkpoint["divided_point_num"].as<size_t>();
+
+    if (checkpoint["segments"]) {
+      for (const auto & seg : checkpoint["segments"]) {
+        counters[GridInfo<2>(seg[0].as<int>(), seg[1].as<int>())] = seg[2].as<int>();
+      }
+    }
+
+    if (checkpoint["halos"]) {
+      for (const auto & halo : checkpoint["halos"]) {
+        halo_counters[GridInfo<2>(halo[0].as<int>(), halo[1].as<int>())] = halo[2].as<int>();
+      }
+    }
+  } catch (YAML::Exception & e) {
+    RCLCPP_WARN(
+      logger_, "Cannot load the checkpoint at %s: %s, the run starts over", checkpoint_path.c_str(),
+      e.what());
+    return false;
+  }
+
+  // Remove the segments saved after the checkpoint, their points are divided again
+  std::vector<fs::path> removed_paths;
+
+  for (auto & seg_dir : fs::directory_iterator(tmp_dir_)) {
+    if (!fs::is_directory(seg_dir.symlink_status())) {
+      continue;
+    }
+
+    auto grid = parseGridName(seg_dir.path().filename().string());
+
+    if (!counters.count(grid) && !halo_counters.count(grid)) {
+      removed_paths.push_back(seg_dir.path());
+      continue;
+    }
+
+    // Segment files are named <counter>_<number of points>.pcd, and halo files
+    // halo_<counter>_<number of points>.pcd
+    for (auto & seg_entry : fs::directory_iterator(seg_dir.path())) {
+      auto fname = seg_entry.path().filename().string();
+      bool is_halo = fname.rfind("halo_", 0) == 0;
+      const auto & file_counters = is_halo ? halo_counters : counters;
+      auto counter_it = file_counters.find(grid);
+
+      if (is_halo) {
+        fname = fname.substr(5);
+      }
+
+      if (
+        counter_it == file_counters.end() ||
+        std::stoi(fname.substr(0, fname.find("_"))) >= counter_it->second) {
+        removed_paths.push_back(seg_entry.path());
+      }
+    }
+  }
+
+  for (const auto & path : removed_paths) {
+    fs::remove_all(path);
+  }
+
+  resume_file_id_ = file_id;
+  resume_block_num_ = block_num;
+  read_point_num_ = divided_point_num_ = divided_point_num;
+  resumed_counters_ = std::move(counters);
+
+  for (const auto & halo_counter : halo_counters) {
+    halo_to_cloud_[halo_counter.first].second = halo_counter.second;
+  }
+
+  RCLCPP_INFO(
+    logger_, "Resuming from the checkpoint at %s, %lu/%lu points were divided",
+    checkpoint_path.c_str(), divided_point_num, input_point_num_);
+
+  return true;
+}
+
+template <class PointT>
+void PCDDivider<PointT>::saveCheckpoint(
+  const std::vector<std::string> & pcd_names, size_t file_id, size_t block_num)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  auto start = std::chrono::steady_clock::now();
+
+  // Resident points are lost with the process, so they must be on the disk first
+  for (auto it = grid_to_cloud_.begin(); it != grid_to_cloud_.end(); ++it) {
+    if (std::get<0>(it->second).size() > 0) {
+      saveGridPCD(it);
+    }
+  }
+
+  for (auto halo_it = halo_to_cloud_.begin(); halo_it != halo_to_cloud_.end(); ++halo_it) {
+    if (halo_it->second.first.size() > 0) {
+      saveHalo(halo_it);
+    }
+  }
+
+  waitWriter();
+
+  // Next counter of every segment. Files from it on are saved after the checkpoint
+  auto counters = resumed_counters_;
+
+  for (const auto & seg : grid_to_cloud_) {
+    if (std::get<1>(seg.second) > 0) {
+      counters[seg.first] = std::get<1>(seg.second);
+    }
+  }
+
+  YAML::Node checkpoint;
+
+  checkpoint["grid_size_x"] = grid_size_x_;
+  checkpoint["grid_size_y"] = grid_size_y_;
+  checkpoint["inputs"] = pcd_names;
+  checkpoint["input_point_num"] = input_point_num_;
+  checkpoint["file_id"] = file_id;
+  checkpoint["block_num"] = block_num;
+  checkpoint["divided_point_num"] = divided_point_num_;
+
+  for (const auto & counter : counters) {
+    checkpoint["segments"].push_back(
+      std::vector<int>{counter.first.ix, counter.first.iy, counter.second});
+  }
+
+  for (const auto & halo : halo_to_cloud_) {
+    if (halo.second.second > 0) {
+      checkpoint["halos"].push_back(
+        std::vector<int>{halo.first.ix, halo.first.iy, halo.second.second});
+    }
+  }
+
+  // Replace the previous checkpoint at once, so a kill never leaves a partial one
+  std::string checkpoint_path = checkpointPath();
+  std::string tmp_checkpoint_path = checkpoint_path + ".tmp";
+  std::ofstream checkpoint_file(tmp_checkpoint_path);
+
+  if (!checkpoint_file.is_open()) {
+    RCLCPP_ERROR(logger_, "Error: Cannot open the checkpoint %s", tmp_checkpoint_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  checkpoint_file << checkpoint << std::endl;
+  checkpoint_file.close();
+
+  std::error_code ec;
+
+  fs::rename(tmp_checkpoint_path, checkpoint_path, ec);
+
+  if (ec) {
+    RCLCPP_ERROR(
+      logger_, "Error: Cannot save the checkpoint %s: %s", checkpoint_path.c_str(),
+      ec.message().c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  ++checkpoint_num_;
+  addPhaseTime(SPILL, start);
+
+  if (debug_mode_) {
+    RCLCPP_INFO(
+      logger_, "Saved checkpoint %lu after %lu/%lu points", checkpoint_num_, divided_point_num_,
+      input_point_num_);
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::checkpointIfDue(
+  const std::vector<std::string> & pcd_names, size_t file_id, size_t block_num)
+{
+  if (!is_checkpointing_) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+
+  if (std::chrono::duration<double>(now - last_checkpoint_time_).count() < checkpoint_interval_) {
+    return;
+  }
+
+  saveCheckpoint(pcd_names, file_id, block_num);
+  last_checkpoint_time_ = std::chrono::steady_clock::now();
+}
+
+template <class PointT>
+void PCDDivider<PointT>::updateTileRecord(const GridInfo<2> & grid, const PclCloudType & cloud)
+{
+  if (!save_tile_index_) {
+    return;
+  }
+
+  std::array<float, 3> min_pt, max_pt;
+
+  min_pt.fill(std::numeric_limits<float>::max());
+  max_pt.fill(std::numeric_limits<float>::lowest());
+
+  for (const auto & p : cloud) {
+    min_pt[0] = std::min(min_pt[0], p.x);
+    min_pt[1] = std::min(min_pt[1], p.y);
+    min_pt[2] = std::min(min_pt[2], p.z);
+    max_pt[0] = std::max(max_pt[0], p.x);
+    max_pt[1] = std::max(max_pt[1], p.y);
+    max_pt[2] = std::max(max_pt[2], p.z);
+  }
+
+  std::lock_guard<std::mutex> lock(grid_set_mtx_);
+  auto rec_it = tile_records_.find(grid);
+
+  if (rec_it == tile_records_.end()) {
+    TileIndexRecord rec;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.ix = grid.ix;
+    rec.iy = grid.iy;
+    rec.min_pt = min_pt;
+    rec.max_pt = max_pt;
+    rec_it = tile_records_.emplace(grid, rec).first;
+  } else {
+    for (int k = 0; k < 3; ++k) {
+      rec_it->second.min_pt[k] = std::min(rec_it->second.min_pt[k], min_pt[k]);
+      rec_it->second.max_pt[k] = std::max(rec_it->second.max_pt[k], max_pt[k]);
+    }
+  }
+
+  rec_it->second.point_num += cloud.size();
+
+  if (use_morton_order_) {
+    rec_it->second.flags |= tile_index_morton_order;
+  }
+}
+
+template <class PointT>
+void PCDDivider<PointT>::writeTileIndex(const std::string & index_file_path)
+{
+  // Sort the tiles so that the index does not depend on the order of processing
+  std::vector<GridInfo<2>> grids(grid_set_.begin(), grid_set_.end());
+
+  std::sort(grids.begin(), grids.end(), [](const GridInfo<2> & a, const GridInfo<2> & b) {
+    return std::tie(a.ix, a.iy) < std::tie(b.ix, b.iy);
+  });
+
+  // Tiles kept by an incremental update are taken from the existing index if they did not
+  // change since then. The final step of a distributed run takes the tiles from the indices
+  // of the shards first
+  std::vector<std::string> old_index_paths;
+  std::unordered_map<GridInfo<2>, TileIndexRecord> old_records;
+
+  if (shard_mode_ == "finalize") {
+    for (int shard_id = 0; shard_id < shard_num_; ++shard_id) {
+      old_index_paths.push_back(tmp_dir_ + "index_shard_" + std::to_string(shard_id) + ".bin");
+    }
+  }
+
+  if (incremental_update_) {
+    old_index_paths.push_back(index_file_path);
+  }
+
+  for (const auto & old_index_path : old_index_paths) {
+    TileIndexHeader header;
+    std::vector<TileIndexRecord> records;
+    std::vector<std::string> paths;
+
+    if (loadTileIndex(old_index_path, header, records, paths)) {
+      for (const auto & rec : records) {
+        old_records.emplace(GridInfo<2>(rec.ix, rec.iy), rec);
+      }
+    }
+  }
+
+  std::vector<TileIndexRecord> records(grids.size());
+  std::vector<std::string> tile_paths(grids.size());
+  std::atomic<size_t> next_tile(0);
+
+  // Checksums are computed from the files, usually still in the page cache
+  auto work = [&]() {
+    for (size_t i = next_tile++; i < grids.size(); i = next_tile++) {
+      const auto & grid = grids[i];
+      std::string tile_path = makeTilePath(grid, false);
+      auto & rec = records[i];
+
+      tile_paths[i] = tile_path.substr(output_dir_.size() + 1);
+
+      auto rec_it = tile_records_.find(grid);
+      auto old_it = old_records.find(grid);
+
+      if (rec_it != tile_records_.end()) {
+        rec = rec_it->second;
+      } else if (
+        old_it != old_records.end() && old_it->second.byte_size == util::file_size(tile_path)) {
+        rec = old_it->second;
+        continue;
+      } else {
+        // A tile of an older output without index, scan its points
+        CustomPCDReader<PointT> reader;
+        PclCloudType cloud;
+
+        memset(&rec, 0, sizeof(rec));
+        rec.ix = grid.ix;
+        rec.iy = grid.iy;
+        rec.min_pt.fill(std::numeric_limits<float>::max());
+        rec.max_pt.fill(std::numeric_limits<float>::lowest());
+        reader.setInput(tile_path);
+
+        do {
+          reader.readABlock(cloud);
+
+          for (const auto & p : cloud) {
+            rec.min_pt = {
+              std::min(rec.min_pt[0], p.x), std::min(rec.min_pt[1], p.y),
+              std::min(rec.min_pt[2], p.z)};
+            rec.max_pt = {
+              std::max(rec.max_pt[0], p.x), std::max(rec.max_pt[1], p.y),
+              std::max(rec.max_pt[2], p.z)};
+          }
+
+          rec.point_num += cloud.size();
+        } while (reader.good());
+      }
+
+      if (!file_crc32(tile_path, rec.crc32, rec.byte_size)) {
+        RCLCPP_ERROR(logger_, "Error: Failed to read the tile %s", tile_path.c_str());
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+
+      // Empty tiles have no bounds
+      if (rec.point_num == 0) {
+        rec.min_pt.fill(0);
+        rec.max_pt.fill(0);
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+
+  for (size_t wid = 1; wid < std::min(thread_num_, grids.size()); ++wid) {
+    workers.emplace_back(work);
+  }
+
+  work();
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+
+  // Write to a temporary file first, as the metadata YAML
+  std::string tmp_index_file_path = index_file_path + ".tmp";
+  std::error_code ec;
+
+  if (!saveTileIndex(tmp_index_file_path, grid_size_x_, grid_size_y_, records, tile_paths)) {
+    RCLCPP_ERROR(logger_, "Error: Cannot save the tile index %s", tmp_index_file_path.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  fs::rename(tmp_index_file_path, index_file_path, ec);
+
+  if (ec) {
+    RCLCPP_ERROR(
+      logger_, "Error: Cannot save the tile index %s: %s", index_file_path.c_str(),
+      ec.message().c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
 }
 
 template class PCDDivider<pcl::PointXYZ>;
 template class PCDDivider<pcl::PointXYZI>;
+template class PCDDivider<pcl::PointXYZRGB>;
+template class PCDDivider<pcl::PointNormal>;
+template class PCDDivider<pcl::PointXYZINormal>;
+template class PCDDivider<PointXYZIRT>;
 
 }  // namespace autoware::pointcloud_divider
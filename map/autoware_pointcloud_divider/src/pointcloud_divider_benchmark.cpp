@@ -0,0 +1,294 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the throughput of the divider on a synthetic map. The map is generated with a given
+// number of points, density (points/m2) and spatial distribution, saved to work_dir, and then
+// read, downsampled and divided. Each phase reports points/s, peak RSS and bytes written.
+
+#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/pcd_io.hpp>
+#include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace autoware::pointcloud_divider
+{
+
+typedef pcl::PointXYZI PointT;
+typedef pcl::PointCloud<PointT> PclCloudType;
+
+// Generate points on a square (uniform), along a winding 15m wide strip (road), or around
+// random centers (clustered). The covered area is point_num / density
+PclCloudType generate_cloud(
+  size_t point_num, double density, const std::string & distribution, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> unit(0.0, 1.0);
+  std::normal_distribution<float> normal(0.0, 1.0);
+  double area = static_cast<double>(point_num) / density;
+  double side = std::sqrt(area);
+  PclCloudType cloud;
+
+  cloud.reserve(point_num);
+
+  if (distribution == "road") {
+    const double road_width = 15.0;
+    double length = area / road_width;
+
+    for (size_t i = 0; i < point_num; ++i) {
+      PointT p;
+      float s = unit(rng) * length;
+
+      p.x = s;
+      p.y = 50.0 * std::sin(s / 200.0) + (unit(rng) - 0.5) * road_width;
+      p.z = 0.2 * normal(rng);
+      p.intensity = unit(rng) * 255;
+      cloud.push_back(p);
+    }
+  } else if (distribution == "clustered") {
+    const size_t cluster_num = 100;
+    float sigma = side / 50.0;
+    std::vector<std::pair<float, float>> centers(cluster_num);
+
+    for (auto & c : centers) {
+      c = std::make_pair(unit(rng) * side, unit(rng) * side);
+    }
+
+    for (size_t i = 0; i < point_num; ++i) {
+      PointT p;
+      const auto & c = centers[i % cluster_num];
+
+      p.x = c.first + sigma * normal(rng);
+      p.y = c.second + sigma * normal(rng);
+      p.z = 2.0 * normal(rng);
+      p.intensity = unit(rng) * 255;
+      cloud.push_back(p);
+    }
+  } else {
+    if (distribution != "uniform") {
+      std::cerr << "Unknown distribution " << distribution << ", use uniform" << std::endl;
+    }
+
+    for (size_t i = 0; i < point_num; ++i) {
+      PointT p;
+
+      p.x = unit(rng) * side;
+      p.y = unit(rng) * side;
+      p.z = unit(rng) * 2.0;
+      p.intensity = unit(rng) * 255;
+      cloud.push_back(p);
+    }
+  }
+
+  return cloud;
+}
+
+// Peak resident set size of the process in MB
+double peak_rss_mb()
+{
+  struct rusage usage;
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss / 1024.0;
+}
+
+size_t directory_size(const std::string & path)
+{
+  size_t size = 0;
+
+  if (!fs::exists(path)) {
+    return 0;
+  }
+
+  for (auto & entry : fs::recursive_directory_iterator(path)) {
+    if (fs::is_regular_file(entry.symlink_status())) {
+      size += fs::file_size(entry.path());
+    }
+  }
+
+  return size;
+}
+
+// Run a phase and print its throughput. func returns the number of bytes it wrote
+void measure(const std::string & name, size_t point_num, const std::function<size_t()> & func)
+{
+  auto start = std::chrono::steady_clock::now();
+  size_t written_bytes = func();
+  auto end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - start).count();
+
+  printf(
+    "%-24s %10.3f s %14.0f points/s %10.1f MB peak RSS %12.1f MB written\n", name.c_str(), sec,
+    point_num / sec, peak_rss_mb(), written_bytes / (1024.0 * 1024.0));
+}
+
+}  // namespace autoware::pointcloud_divider
+
+int main(int argc, char * argv[])
+{
+  using autoware::pointcloud_divider::PclCloudType;
+  using autoware::pointcloud_divider::PointT;
+
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("pointcloud_divider_benchmark");
+
+  const auto point_num = node->declare_parameter<int>("point_num", 10000000);
+  const auto density = node->declare_parameter<double>("density", 1000.0);
+  const auto distribution = node->declare_parameter<std::string>("distribution", "uniform");
+  const auto leaf_size = node->declare_parameter<double>("leaf_size", 0.2);
+  const auto grid_size = node->declare_parameter<double>("grid_size", 20.0);
+  const auto thread_num = node->declare_parameter<int>("thread_num", 1);
+  const auto work_dir =
+    node->declare_parameter<std::string>("work_dir", "/tmp/pointcloud_divider_benchmark");
+  const auto seed = node->declare_parameter<int>("seed", 0);
+
+  std::cout << "benchmarking with following parameters" << std::endl
+            << "point_num " << point_num << std::endl
+            << "density " << density << std::endl
+            << "distribution " << distribution << std::endl
+            << "leaf_size " << leaf_size << std::endl
+            << "grid_size " << grid_size << std::endl
+            << "thread_num " << thread_num << std::endl
+            << "work_dir " << work_dir << std::endl;
+
+  if (point_num <= 0 || density <= 0) {
+    std::cerr << "point_num and density must be positive" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  fs::remove_all(work_dir);
+  fs::create_directories(work_dir);
+
+  const std::string input_pcd = work_dir + "/input.pcd";
+  PclCloudType cloud;
+
+  autoware::pointcloud_divider::measure("generate", point_num, [&]() {
+    cloud = autoware::pointcloud_divider::generate_cloud(point_num, density, distribution, seed);
+    return 0;
+  });
+
+  autoware::pointcloud_divider::measure("CustomPCDWriter::write", point_num, [&]() {
+    autoware::pointcloud_divider::CustomPCDWriter<PointT> writer;
+
+    writer.setOutput(input_pcd);
+    writer.writeMetadata(cloud.size(), true);
+    writer.write(cloud);
+    writer.close();
+
+    return fs::file_size(input_pcd);
+  });
+
+  autoware::pointcloud_divider::measure("CustomPCDWriter::write (io_uring)", point_num, [&]() {
+    autoware::pointcloud_divider::CustomPCDWriter<PointT> writer;
+
+    writer.setAsyncMode(true);
+    writer.setOutput(input_pcd);
+    writer.writeMetadata(cloud.size(), true);
+    writer.write(cloud);
+    writer.close();
+
+    return fs::file_size(input_pcd);
+  });
+
+  autoware::pointcloud_divider::measure("CustomPCDReader::read", point_num, [&]() {
+    autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+
+    reader.setInput(input_pcd);
+
+    do {
+      PclCloudType block;
+
+      reader.readABlock(block);
+    } while (reader.good());
+
+    return 0;
+  });
+
+  for (bool use_sort : {false, true}) {
+    std::string name = use_sort ? "VoxelGridFilter (sort)" : "VoxelGridFilter (hash)";
+
+    autoware::pointcloud_divider::measure(name, point_num, [&]() {
+      autoware::pointcloud_divider::VoxelGridFilter<PointT> filter;
+      PclCloudType output;
+
+      filter.setResolution(leaf_size);
+      filter.setSortMode(use_sort);
+      filter.setThreadNum(thread_num);
+      filter.filter(cloud, output);
+
+      return 0;
+    });
+  }
+
+#ifdef POINTCLOUD_DIVIDER_USE_CUDA
+  autoware::pointcloud_divider::measure("VoxelGridFilter (cuda)", point_num, [&]() {
+    autoware::pointcloud_divider::VoxelGridFilter<PointT> filter;
+    PclCloudType output;
+
+    filter.setResolution(leaf_size);
+    filter.setCudaMode(true);
+    filter.setThreadNum(thread_num);
+    filter.filter(cloud, output);
+
+    return 0;
+  });
+#endif
+
+  // Free the memory of the generated cloud so that it does not count in the divider's RSS
+  PclCloudType().swap(cloud);
+
+  // The divider without downsampling measures dividing, with downsampling it also measures
+  // mergeAndDownsample
+  for (double divider_leaf_size : {-1.0, leaf_size}) {
+    std::string name = (divider_leaf_size > 0) ? "PCDDivider (downsample)" : "PCDDivider";
+    std::string output_dir = work_dir + "/output";
+
+    autoware::pointcloud_divider::measure(name, point_num, [&]() {
+      autoware::pointcloud_divider::PCDDivider<PointT> divider(node->get_logger());
+
+      divider.setOutputDir(output_dir);
+      divider.setPrefix("benchmark");
+      divider.setGridSize(grid_size, grid_size);
+      divider.setLeafSize(divider_leaf_size);
+      divider.setThreadNum(thread_num);
+      divider.setDebugMode(false);
+      divider.run(std::vector<std::string>{input_pcd});
+
+      return autoware::pointcloud_divider::directory_size(output_dir);
+    });
+  }
+
+  fs::remove_all(work_dir);
+
+  rclcpp::shutdown();
+
+  return 0;
+}
@@ -15,10 +15,13 @@
 #include "include/pointcloud_divider_node.hpp"
 
 #include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/point_types.hpp>
+#include <autoware/profiling_utils/profiling_utils.hpp>
 
 #include <pcl/point_types.h>
 
 #include <string>
+#include <vector>
 
 namespace autoware::pointcloud_divider
 {
@@ -26,6 +29,8 @@ namespace autoware::pointcloud_divider
 PointCloudDivider::PointCloudDivider(const rclcpp::NodeOptions & node_options)
 : Node("pointcloud_divider", node_options)
 {
+  AUTOWARE_PROFILE_INIT(*this);
+
   // Load command parameters
   bool use_large_grid = declare_parameter<bool>("use_large_grid", false);
   float leaf_size = declare_parameter<float>("leaf_size");
@@ -35,6 +40,31 @@ PointCloudDivider::PointCloudDivider(const rclcpp::NodeOptions & node_options)
   std::string output_pcd_dir = declare_parameter<std::string>("output_pcd_dir");
   std::string file_prefix = declare_parameter<std::string>("prefix");
   std::string point_type = declare_parameter<std::string>("point_type");
+  int thread_num = declare_parameter<int>("thread_num", 1);
+  bool use_async_io = declare_parameter<bool>("use_async_io", false);
+  bool use_io_uring = declare_parameter<bool>("use_io_uring", false);
+  bool use_compression = declare_parameter<bool>("use_compression", false);
+  bool use_sort_voxel_filter = declare_parameter<bool>("use_sort_voxel_filter", false);
+  bool use_cuda_voxel_filter = declare_parameter<bool>("use_cuda_voxel_filter", false);
+  bool use_direct_write = declare_parameter<bool>("use_direct_write", false);
+  bool use_incremental_update = declare_parameter<bool>("use_incremental_update", false);
+  int memory_budget_mb = declare_parameter<int>("memory_budget_mb", 0);
+  std::string spill_policy = declare_parameter<std::string>("spill_policy", "largest");
+  double presize_sample_ratio = declare_parameter<double>("presize_sample_ratio", 0.0);
+  double progress_interval = declare_parameter<double>("progress_interval", 10.0);
+  double checkpoint_interval = declare_parameter<double>("checkpoint_interval", 0.0);
+  std::string shard_mode = declare_parameter<std::string>("shard_mode", "none");
+  int shard_id = declare_parameter<int>("shard_id", 0);
+  int shard_num = declare_parameter<int>("shard_num", 1);
+  std::string summary_file = declare_parameter<std::string>("summary_file", "");
+  bool save_tile_index = declare_parameter<bool>("save_tile_index", true);
+  double duplicate_resolution = declare_parameter<double>("duplicate_resolution", 0.0);
+  int outlier_mean_k = declare_parameter<int>("outlier_mean_k", 0);
+  double outlier_stddev_mult = declare_parameter<double>("outlier_stddev_mult", 1.0);
+  double outlier_halo = declare_parameter<double>("outlier_halo", 1.0);
+  bool use_morton_order = declare_parameter<bool>("use_morton_order", false);
+  std::vector<double> lod_leaf_sizes =
+    declare_parameter<std::vector<double>>("lod_leaf_sizes", std::vector<double>{0.0});
   // Enter a new line and clear it
   // This is to get rid of the prefix of RCLCPP_INFO
   std::string line_breaker(102, ' ');
@@ -59,12 +89,90 @@ PointCloudDivider::PointCloudDivider(const rclcpp::NodeOptions & node_options)
   param_display << "\toutput_pcd_dir: " << output_pcd_dir << line_breaker;
   param_display << "\tfile_prefix: " << file_prefix << line_breaker;
   param_display << "\tpoint_type: " << point_type << line_breaker;
+  param_display << "\tthread_num: " << thread_num << line_breaker;
+
+  if (use_async_io) {
+    param_display << "\tuse_async_io: True" << line_breaker;
+  } else {
+    param_display << "\tuse_async_io: False" << line_breaker;
+  }
+
+  if (use_io_uring) {
+    param_display << "\tuse_io_uring: True" << line_breaker;
+  } else {
+    param_display << "\tuse_io_uring: False" << line_breaker;
+  }
+
+  if (use_compression) {
+    param_display << "\tuse_compression: True" << line_breaker;
+  } else {
+    param_display << "\tuse_compression: False" << line_breaker;
+  }
+
+  if (use_sort_voxel_filter) {
+    param_display << "\tuse_sort_voxel_filter: True" << line_breaker;
+  } else {
+    param_display << "\tuse_sort_voxel_filter: False" << line_breaker;
+  }
+
+  if (use_cuda_voxel_filter) {
+    param_display << "\tuse_cuda_voxel_filter: True" << line_breaker;
+  } else {
+    param_display << "\tuse_cuda_voxel_filter: False" << line_breaker;
+  }
+
+  if (use_direct_write) {
+    param_display << "\tuse_direct_write: True" << line_breaker;
+  } else {
+    param_display << "\tuse_direct_write: False" << line_breaker;
+  }
+
+  if (use_incremental_update) {
+    param_display << "\tuse_incremental_update: True" << line_breaker;
+  } else {
+    param_display << "\tuse_incremental_update: False" << line_breaker;
+  }
+
+  param_display << "\tmemory_budget_mb: " << memory_budget_mb << line_breaker;
+  param_display << "\tspill_policy: " << spill_policy << line_breaker;
+  param_display << "\tpresize_sample_ratio: " << presize_sample_ratio << line_breaker;
+  param_display << "\tprogress_interval: " << progress_interval << line_breaker;
+  param_display << "\tcheckpoint_interval: " << checkpoint_interval << line_breaker;
+  param_display << "\tshard: " << shard_mode << ", " << shard_id << "/" << shard_num
+                << line_breaker;
+  param_display << "\tsummary_file: " << summary_file << line_breaker;
+
+  if (save_tile_index) {
+    param_display << "\tsave_tile_index: True" << line_breaker;
+  } else {
+    param_display << "\tsave_tile_index: False" << line_breaker;
+  }
+
+  param_display << "\tduplicate_resolution: " << duplicate_resolution << line_breaker;
+  param_display << "\toutlier_mean_k: " << outlier_mean_k << line_breaker;
+  param_display << "\toutlier_stddev_mult: " << outlier_stddev_mult << line_breaker;
+  param_display << "\toutlier_halo: " << outlier_halo << line_breaker;
+
+  if (use_morton_order) {
+    param_display << "\tuse_morton_order: True" << line_breaker;
+  } else {
+    param_display << "\tuse_morton_order: False" << line_breaker;
+  }
+
+  param_display << "\tlod_leaf_sizes:";
+
+  for (auto lod_leaf_size : lod_leaf_sizes) {
+    param_display << " " << lod_leaf_size;
+  }
+
+  param_display << line_breaker;
+
   param_display << "######################################" << line_breaker;
 
   RCLCPP_INFO(get_logger(), "%s", param_display.str().c_str());
 
-  if (point_type == "point_xyz") {
-    autoware::pointcloud_divider::PCDDivider<pcl::PointXYZ> pcd_divider_exe(get_logger());
+  auto run = [&](auto point) {
+    autoware::pointcloud_divider::PCDDivider<decltype(point)> pcd_divider_exe(get_logger());
 
     pcd_divider_exe.setLargeGridMode(use_large_grid);
     pcd_divider_exe.setLeafSize(leaf_size);
@@ -72,19 +180,44 @@ PointCloudDivider::PointCloudDivider(const rclcpp::NodeOptions & node_options)
     pcd_divider_exe.setInput(input_pcd_or_dir);
     pcd_divider_exe.setOutputDir(output_pcd_dir);
     pcd_divider_exe.setPrefix(file_prefix);
+    pcd_divider_exe.setThreadNum(thread_num);
+    pcd_divider_exe.setAsyncIO(use_async_io);
+    pcd_divider_exe.setIOUringWrite(use_io_uring);
+    pcd_divider_exe.setCompression(use_compression);
+    pcd_divider_exe.setSortVoxelFilter(use_sort_voxel_filter);
+    pcd_divider_exe.setCudaVoxelFilter(use_cuda_voxel_filter);
+    pcd_divider_exe.setDirectWrite(use_direct_write);
+    pcd_divider_exe.setIncrementalUpdate(use_incremental_update);
+    pcd_divider_exe.setMemoryBudget(memory_budget_mb);
+    pcd_divider_exe.setSpillPolicy(spill_policy);
+    pcd_divider_exe.setPresizeSampleRatio(presize_sample_ratio);
+    pcd_divider_exe.setProgressInterval(progress_interval);
+    pcd_divider_exe.setCheckpointInterval(checkpoint_interval);
+    pcd_divider_exe.setShard(shard_mode, shard_id, shard_num);
+    pcd_divider_exe.setSummaryFile(summary_file);
+    pcd_divider_exe.setTileIndex(save_tile_index);
+    pcd_divider_exe.setDuplicateResolution(duplicate_resolution);
+    pcd_divider_exe.setOutlierFilter(outlier_mean_k, outlier_stddev_mult, outlier_halo);
+    pcd_divider_exe.setMortonOrder(use_morton_order);
+    pcd_divider_exe.setLodLeafSizes(lod_leaf_sizes);
 
     pcd_divider_exe.run();
-  } else if (point_type == "point_xyzi") {
-    autoware::pointcloud_divider::PCDDivider<pcl::PointXYZI> pcd_divider_exe(get_logger());
-
-    pcd_divider_exe.setLargeGridMode(use_large_grid);
-    pcd_divider_exe.setLeafSize(leaf_size);
-    pcd_divider_exe.setGridSize(grid_size_x, grid_size_y);
-    pcd_divider_exe.setInput(input_pcd_or_dir);
-    pcd_divider_exe.setOutputDir(output_pcd_dir);
-    pcd_divider_exe.setPrefix(file_prefix);
+  };
 
-    pcd_divider_exe.run();
+  if (point_type == "point_xyz") {
+    run(pcl::PointXYZ());
+  } else if (point_type == "point_xyzi") {
+    run(pcl::PointXYZI());
+  } else if (point_type == "point_xyzrgb") {
+    run(pcl::PointXYZRGB());
+  } else if (point_type == "point_normal") {
+    run(pcl::PointNormal());
+  } else if (point_type == "point_xyzinormal") {
+    run(pcl::PointXYZINormal());
+  } else if (point_type == "point_xyzirt") {
+    run(PointXYZIRT());
+  } else {
+    RCLCPP_ERROR(get_logger(), "Error: Unknown point type %s", point_type.c_str());
   }
 
   rclcpp::shutdown();
@@ -13,14 +13,118 @@
 // limitations under the License.
 
 #include <autoware/pointcloud_divider/centroid.hpp>
+#include <autoware/pointcloud_divider/cuda_voxel_grid_engine.hpp>
+#include <autoware/pointcloud_divider/grid_hash_map.hpp>
 #include <autoware/pointcloud_divider/grid_info.hpp>
 #include <autoware/pointcloud_divider/voxel_grid_filter.hpp>
 
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace autoware::pointcloud_divider
 {
 
+namespace
+{
+// Number of bits sorted in each pass of the radix sort
+constexpr int radix_bits = 8;
+constexpr size_t radix_size = size_t(1) << radix_bits;
+
+typedef std::pair<uint64_t, uint32_t> KeyIndex;
+
+// Split [0, n) into at most thread_num contiguous chunks and process them in parallel
+template <typename Func>
+void parallelFor(size_t n, size_t thread_num, const Func & func)
+{
+  thread_num = std::max<size_t>(1, std::min(thread_num, n));
+
+  if (thread_num == 1) {
+    func(0, n, 0);
+    return;
+  }
+
+  size_t chunk_size = (n + thread_num - 1) / thread_num;
+  std::vector<std::thread> workers;
+
+  workers.reserve(thread_num);
+
+  for (size_t tid = 0; tid < thread_num; ++tid) {
+    size_t begin = std::min(n, tid * chunk_size);
+    size_t end = std::min(n, begin + chunk_size);
+
+    workers.emplace_back([&func, begin, end, tid]() { func(begin, end, tid); });
+  }
+
+  for (auto & worker : workers) {
+    worker.join();
+  }
+}
+
+// Number of bits needed to represent val
+int bitWidth(uint64_t val)
+{
+  int width = 0;
+
+  for (; val > 0; val >>= 1) {
+    ++width;
+  }
+
+  return width;
+}
+
+// Sort pairs by the lowest key_bit_num bits of their keys with LSD radix sort. The sort is
+// stable, so points in a voxel keep their input order
+void radixSort(std::vector<KeyIndex> & pairs, int key_bit_num, size_t thread_num)
+{
+  size_t n = pairs.size();
+  size_t chunk_num = std::max<size_t>(1, std::min(thread_num, n));
+  std::vector<KeyIndex> tmp(n);
+  std::vector<std::vector<size_t>> offsets(chunk_num, std::vector<size_t>(radix_size));
+
+  for (int shift = 0; shift < key_bit_num; shift += radix_bits) {
+    // Count the digits in each chunk
+    parallelFor(n, chunk_num, [&](size_t begin, size_t end, size_t tid) {
+      auto & count = offsets[tid];
+
+      std::fill(count.begin(), count.end(), 0);
+
+      for (size_t i = begin; i < end; ++i) {
+        ++count[(pairs[i].first >> shift) & (radix_size - 1)];
+      }
+    });
+
+    // Compute where each chunk starts writing each digit. Earlier chunks are placed first
+    // to keep the sort stable
+    size_t sum = 0;
+
+    for (size_t d = 0; d < radix_size; ++d) {
+      for (size_t tid = 0; tid < chunk_num; ++tid) {
+        size_t count = offsets[tid][d];
+
+        offsets[tid][d] = sum;
+        sum += count;
+      }
+    }
+
+    parallelFor(n, chunk_num, [&](size_t begin, size_t end, size_t tid) {
+      auto & offset = offsets[tid];
+
+      for (size_t i = begin; i < end; ++i) {
+        tmp[offset[(pairs[i].first >> shift) & (radix_size - 1)]++] = pairs[i];
+      }
+    });
+
+    pairs.swap(tmp);
+  }
+}
+
+}  // namespace
+
 template <typename PointT>
 void VoxelGridFilter<PointT>::filter(const PclCloudType & input, PclCloudType & output)
 {
@@ -28,20 +132,297 @@ void VoxelGridFilter<PointT>::filter(const PclCloudType & input, PclCloudType &
     return;
   }
 
-  std::unordered_map<GridInfo<3>, Centroid<PointT>> grid_map;
+  if (use_cuda_ && filterByCuda(input, output)) {
+    return;
+  }
+
+  if (use_sort_ && filterBySort(input, output)) {
+    return;
+  }
+
+  typedef GridHashMap<GridInfo<3>, Centroid<PointT>, GridHash3> CentroidMap;
+
+  if (thread_num_ == 1 || input.size() < thread_num_ * grid_key_block_size) {
+    CentroidMap grid_map;
+    GridInfo<3> grids[grid_key_block_size];
+
+    for (size_t i = 0; i < input.size(); i += grid_key_block_size) {
+      size_t num = std::min(grid_key_block_size, input.size() - i);
 
-  for (auto & p : input) {
-    auto gkey = pointToGrid3(p, resolution_, resolution_, resolution_);
+      pointsToGrid3(&input[i], num, resolution_, resolution_, resolution_, grids);
 
-    grid_map[gkey].add(p);
+      for (size_t j = 0; j < num; ++j) {
+        grid_map[grids[j]].add(input[i + j]);
+      }
+    }
+
+    // Extract centroids
+    output.reserve(grid_map.size());
+
+    for (auto & it : grid_map) {
+      output.push_back(it.second.get());
+    }
+
+    return;
   }
 
+  std::vector<GridInfo<3>> grids(input.size());
+
+  parallelFor(input.size(), thread_num_, [&](size_t begin, size_t end, size_t) {
+    pointsToGrid3(
+      input.points.data() + begin, end - begin, resolution_, resolution_, resolution_,
+      grids.data() + begin);
+  });
+
+  // Each shard takes the voxels whose hashes fall in it, so the shards are filled in parallel
+  // without a lock, and the points of a voxel are still added in the input order
+  std::vector<CentroidMap> shards(thread_num_);
+
+  parallelFor(thread_num_, thread_num_, [&](size_t begin, size_t end, size_t) {
+    for (size_t sid = begin; sid < end; ++sid) {
+      auto & shard = shards[sid];
+
+      for (size_t i = 0; i < grids.size(); ++i) {
+        if (CentroidMap::shardOf(grids[i], thread_num_) == sid) {
+          shard[grids[i]].add(input[i]);
+        }
+      }
+    }
+  });
+
+  std::vector<GridInfo<3>>().swap(grids);
+
   // Extract centroids
-  output.reserve(grid_map.size());
+  size_t voxel_num = 0;
+
+  for (const auto & shard : shards) {
+    voxel_num += shard.size();
+  }
+
+  output.reserve(voxel_num);
+
+  for (auto & shard : shards) {
+    for (auto & it : shard) {
+      output.push_back(it.second.get());
+    }
+
+    shard.clear();
+  }
+}
+
+template <typename PointT>
+bool VoxelGridFilter<PointT>::filterBySort(const PclCloudType & input, PclCloudType & output)
+{
+  size_t point_num = input.size();
 
-  for (auto & it : grid_map) {
-    output.push_back(it.second.get());
+  if (point_num == 0) {
+    return true;
   }
+
+  if (point_num > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+
+  // Compute the voxel of each point and the range of voxel indices
+  std::vector<GridInfo<3>> grids(point_num);
+  std::vector<GridInfo<3>> min_grids(
+    thread_num_, GridInfo<3>(
+                   std::numeric_limits<int>::max(), std::numeric_limits<int>::max(),
+                   std::numeric_limits<int>::max()));
+  std::vector<GridInfo<3>> max_grids(
+    thread_num_, GridInfo<3>(
+                   std::numeric_limits<int>::min(), std::numeric_limits<int>::min(),
+                   std::numeric_limits<int>::min()));
+
+  parallelFor(point_num, thread_num_, [&](size_t begin, size_t end, size_t tid) {
+    auto & min_g = min_grids[tid];
+    auto & max_g = max_grids[tid];
+
+    pointsToGrid3(
+      input.points.data() + begin, end - begin, resolution_, resolution_, resolution_,
+      grids.data() + begin);
+
+    for (size_t i = begin; i < end; ++i) {
+      const auto & g = grids[i];
+
+      min_g.ix = std::min(min_g.ix, g.ix);
+      min_g.iy = std::min(min_g.iy, g.iy);
+      min_g.iz = std::min(min_g.iz, g.iz);
+      max_g.ix = std::max(max_g.ix, g.ix);
+      max_g.iy = std::max(max_g.iy, g.iy);
+      max_g.iz = std::max(max_g.iz, g.iz);
+    }
+  });
+
+  GridInfo<3> min_grid = min_grids[0], max_grid = max_grids[0];
+
+  for (size_t tid = 1; tid < thread_num_; ++tid) {
+    min_grid.ix = std::min(min_grid.ix, min_grids[tid].ix);
+    min_grid.iy = std::min(min_grid.iy, min_grids[tid].iy);
+    min_grid.iz = std::min(min_grid.iz, min_grids[tid].iz);
+    max_grid.ix = std::max(max_grid.ix, max_grids[tid].ix);
+    max_grid.iy = std::max(max_grid.iy, max_grids[tid].iy);
+    max_grid.iz = std::max(max_grid.iz, max_grids[tid].iz);
+  }
+
+  // Pack the indices relative to the minimum ones as tightly as possible, so the radix
+  // sort needs as few passes as possible
+  int x_bits = bitWidth(static_cast<int64_t>(max_grid.ix) - min_grid.ix);
+  int y_bits = bitWidth(static_cast<int64_t>(max_grid.iy) - min_grid.iy);
+  int z_bits = bitWidth(static_cast<int64_t>(max_grid.iz) - min_grid.iz);
+  int key_bit_num = x_bits + y_bits + z_bits;
+
+  if (key_bit_num > 64) {
+    return false;
+  }
+
+  std::vector<KeyIndex> pairs(point_num);
+
+  parallelFor(point_num, thread_num_, [&](size_t begin, size_t end, size_t) {
+    for (size_t i = begin; i < end; ++i) {
+      uint64_t kx = static_cast<int64_t>(grids[i].ix) - min_grid.ix;
+      uint64_t ky = static_cast<int64_t>(grids[i].iy) - min_grid.iy;
+      uint64_t kz = static_cast<int64_t>(grids[i].iz) - min_grid.iz;
+
+      pairs[i].first = kx | (ky << x_bits) | (kz << (x_bits + y_bits));
+      pairs[i].second = static_cast<uint32_t>(i);
+    }
+  });
+
+  std::vector<GridInfo<3>>().swap(grids);
+
+  radixSort(pairs, key_bit_num, thread_num_);
+
+  // Split the sorted pairs so that no voxel spans two chunks
+  size_t chunk_num = std::max<size_t>(1, std::min(thread_num_, point_num));
+  std::vector<size_t> bounds(chunk_num + 1, point_num);
+
+  bounds[0] = 0;
+
+  for (size_t cid = 1; cid < chunk_num; ++cid) {
+    size_t pos = std::max(bounds[cid - 1], cid * point_num / chunk_num);
+
+    while (pos > 0 && pos < point_num && pairs[pos].first == pairs[pos - 1].first) {
+      ++pos;
+    }
+
+    bounds[cid] = pos;
+  }
+
+  // Reduce each run of the same key to a centroid
+  std::vector<std::vector<PointT>> centroids(chunk_num);
+
+  parallelFor(chunk_num, chunk_num, [&](size_t begin, size_t end, size_t) {
+    for (size_t cid = begin; cid < end; ++cid) {
+      for (size_t i = bounds[cid]; i < bounds[cid + 1];) {
+        size_t j = i + 1;
+
+        while (j < bounds[cid + 1] && pairs[j].first == pairs[i].first) {
+          ++j;
+        }
+
+        centroids[cid].push_back(reduce_run<PointT>(
+          j - i, [&](size_t k) -> const PointT & { return input[pairs[i + k].second]; }));
+        i = j;
+      }
+    }
+  });
+
+  size_t voxel_num = 0;
+
+  for (auto & chunk : centroids) {
+    voxel_num += chunk.size();
+  }
+
+  output.reserve(output.size() + voxel_num);
+
+  for (auto & chunk : centroids) {
+    for (auto & p : chunk) {
+      output.push_back(p);
+    }
+  }
+
+  return true;
+}
+
+template <typename PointT>
+bool VoxelGridFilter<PointT>::filterByCuda(const PclCloudType & input, PclCloudType & output)
+{
+#ifdef POINTCLOUD_DIVIDER_USE_CUDA
+  size_t point_num = input.size();
+
+  if (point_num > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+
+  static const bool is_device_available = cuda::isDeviceAvailable();
+
+  if (!is_device_available) {
+    return false;
+  }
+
+  // Tiles are filtered by several threads, but one cloud at a time fits into the GPU. The
+  // engine keeps its pinned buffers for the next clouds
+  static std::mutex engine_mtx;
+  static cuda::VoxelGridEngine engine;
+  std::lock_guard<std::mutex> lock(engine_mtx);
+  constexpr size_t ch_num = channel_num<PointT>();
+
+  if (!engine.begin(point_num, ch_num)) {
+    return false;
+  }
+
+  // Fill a pinned buffer while the previous one is copied to the device
+  for (size_t begin = 0; begin < point_num;) {
+    float * block = engine.blockBuffer();
+    size_t block_point_num = std::min(engine.blockCapacity(), point_num - begin);
+
+    if (!block) {
+      return false;
+    }
+
+    for (size_t i = 0; i < block_point_num; ++i) {
+      const PointT & p = input[begin + i];
+      float * dst = block + i * ch_num;
+
+      for_each_channel<PointT>(
+        [&](size_t c, size_t loc, bool is_color) { dst[c] = get_channel(p, loc, is_color); });
+    }
+
+    if (!engine.uploadBlock(block_point_num)) {
+      return false;
+    }
+
+    begin += block_point_num;
+  }
+
+  cuda::VoxelReduction reduction;
+
+  if (!engine.reduce(resolution_, reduction)) {
+    return false;
+  }
+
+  size_t voxel_num = reduction.first_indices.size();
+
+  output.reserve(output.size() + voxel_num);
+
+  for (size_t v = 0; v < voxel_num; ++v) {
+    ChannelSums<PointT> acc_diff;
+    PointT centroid;
+
+    std::copy_n(reduction.acc_diffs.begin() + v * ch_num, ch_num, acc_diff.begin());
+    compute_centroid(
+      acc_diff, input[reduction.first_indices[v]], reduction.point_nums[v], centroid);
+    output.push_back(centroid);
+  }
+
+  return true;
+#else
+  (void)input;
+  (void)output;
+
+  return false;
+#endif
 }
 
 }  // namespace autoware::pointcloud_divider
@@ -46,11 +46,18 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #define PCL_NO_PRECOMPILE
+#include <autoware/pointcloud_divider/centroid.hpp>
+#include <autoware/pointcloud_divider/grid_info.hpp>
+#include <autoware/pointcloud_divider/pcd_header.hpp>
 #include <autoware/pointcloud_divider/pcd_io.hpp>
+#include <autoware/pointcloud_merger/region_filter.hpp>
 #include <rclcpp/rclcpp.hpp>
 
 #include <pcl/point_cloud.h>
@@ -64,6 +71,10 @@ class PCDMerger
 {
   typedef pcl::PointCloud<PointT> PclCloudType;
   typedef typename PclCloudType::Ptr PclCloudPtr;
+  typedef autoware::pointcloud_divider::GridInfo<2> ShardKey;
+  typedef autoware::pointcloud_divider::GridInfo<3> VoxelKey;
+  typedef autoware::pointcloud_divider::Centroid<PointT> CentroidType;
+  typedef std::unordered_map<VoxelKey, CentroidType> VoxelMap;
 
 public:
   explicit PCDMerger(const rclcpp::Logger & logger) : logger_(logger) {}
@@ -81,6 +92,17 @@ public:
 
   void setLeafSize(double leaf_size) { leaf_size_ = leaf_size; }
 
+  // Save the output PCD in the binary_compressed format
+  void setCompression(bool use_compression) { use_compression_ = use_compression; }
+
+  // Number of threads that copy the input PCDs to the output at once
+  void setThreadNum(int thread_num) { thread_num_ = (thread_num > 1) ? thread_num : 1; }
+
+  // Merge only the points in a region, see RegionFilter::set. The tiles of a divided map are
+  // selected by its tile index or metadata YAML, so that the other tiles are not read. Return false
+  // if the values are not a region
+  bool setRegion(const std::vector<double> & region) { return region_.set(region); }
+
   void run();
   void run(const std::vector<std::string> & pcd_names);
 
@@ -89,18 +111,53 @@ private:
 
   // Params from yaml
   double leaf_size_ = 0.1;
+  bool use_compression_ = false;
+  int thread_num_ = 1;
+  RegionFilter region_;
 
   // Maximum number of points per PCD block
   const size_t max_block_size_ = 500000;
 
+  // Number of voxels along x and y of a shard of the downsampling accumulator
+  const int shard_size_ = 100;
+  // Maximum number of voxels kept in memory while downsampling
+  const size_t max_voxel_num_ = 20000000;
+
+  // Voxels of the downsampling accumulator, grouped by shard
+  std::unordered_map<ShardKey, VoxelMap> shards_;
+  // Shards whose voxels have been saved to the tmp directory to free memory
+  std::unordered_set<ShardKey> spilled_shards_;
+  size_t voxel_num_ = 0;
+
   std::string tmp_dir_;
   autoware::pointcloud_divider::CustomPCDWriter<PointT> writer_;
   rclcpp::Logger logger_;
 
+  // Headers of the input files, so that they are not reopened to count the points
+  std::unordered_map<std::string, autoware::pointcloud_divider::PCDHeaderInfo> pcd_headers_;
+
   std::vector<std::string> discoverPCDs(const std::string & input);
+  // Find the tiles of the divided map at input that overlap region_. All PCDs of input are used if
+  // it has neither a tile index nor a metadata YAML
+  std::vector<std::string> selectRegionTiles(const std::string & input);
+  // Read the headers of the files that are not in pcd_headers_ yet, in parallel
+  void scanHeaders(const std::vector<std::string> & pcd_names);
   void paramInitialize();
   void mergeWithoutDownsample(const std::vector<std::string> & input_pcds);
+  // Copy the input PCDs to disjoint parts of a presized binary output in parallel
+  void mergeInParallel(
+    const std::vector<std::string> & input_pcds, const std::vector<size_t> & point_offsets,
+    size_t total_point_num);
   void mergeWithDownsample(const std::vector<std::string> & input_pcds);
+  // Write the points of the inputs in region_ to the output, whose size is known at the end
+  void mergeRegion(const std::vector<std::string> & input_pcds);
+  // Add the points of a block to the voxels of the downsampling accumulator
+  void accumulate(const PclCloudType & cloud);
+  // Append the voxels of a shard to its file in the tmp directory and free them
+  void spillShard(typename std::unordered_map<ShardKey, VoxelMap>::iterator shard_it);
+  // Pass the centroids of the voxels of each shard to output, shard by shard
+  void emitShards(const std::function<void(const PclCloudType &)> & output);
+  std::string makeSpillPath(const ShardKey & shard) const;
 };
 
 }  // namespace autoware::pointcloud_merger
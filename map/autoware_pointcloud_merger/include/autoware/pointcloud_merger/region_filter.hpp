@@ -0,0 +1,225 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef AUTOWARE__POINTCLOUD_MERGER__REGION_FILTER_HPP_
+#define AUTOWARE__POINTCLOUD_MERGER__REGION_FILTER_HPP_
+
+#include <pcl/point_cloud.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace autoware::pointcloud_merger
+{
+
+// Region of the XY plane whose points are extracted, either a box or a simple polygon. Points are
+// tested in batches, with a loop over the points for each edge, so that the test is vectorized
+class RegionFilter
+{
+public:
+  // x_min, y_min, x_max, y_max of a box, or x0, y0, x1, y1, ... of a polygon with 3 or more
+  // vertices. Return false if the values are neither, and the region is left unset
+  bool set(const std::vector<double> & values)
+  {
+    if (values.size() == 4 && values[0] <= values[2] && values[1] <= values[3]) {
+      edges_.clear();
+      outline_.clear();
+      min_x_ = values[0];
+      min_y_ = values[1];
+      max_x_ = values[2];
+      max_y_ = values[3];
+      is_set_ = true;
+
+      return true;
+    }
+
+    if (values.size() < 6 || values.size() % 2 != 0) {
+      return false;
+    }
+
+    edges_.clear();
+    outline_.clear();
+    min_x_ = max_x_ = values[0];
+    min_y_ = max_y_ = values[1];
+
+    for (size_t i = 0; i < values.size(); i += 2) {
+      size_t j = (i + 2) % values.size();
+      Edge e{
+        static_cast<float>(values[i]), static_cast<float>(values[i + 1]),
+        static_cast<float>(values[j]), static_cast<float>(values[j + 1]), 0.0f};
+
+      min_x_ = std::min<float>(min_x_, values[i]);
+      min_y_ = std::min<float>(min_y_, values[i + 1]);
+      max_x_ = std::max<float>(max_x_, values[i]);
+      max_y_ = std::max<float>(max_y_, values[i + 1]);
+      outline_.push_back(e);
+
+      // A horizontal edge is never crossed by the horizontal ray of the test
+      if (e.y0 != e.y1) {
+        e.dxdy = (e.x1 - e.x0) / (e.y1 - e.y0);
+        edges_.push_back(e);
+      }
+    }
+
+    is_set_ = true;
+
+    return true;
+  }
+
+  bool isSet() const { return is_set_; }
+
+  // Check if the box of a tile overlaps the region
+  bool intersects(float min_x, float min_y, float max_x, float max_y) const
+  {
+    if (max_x < min_x_ || max_x_ < min_x || max_y < min_y_ || max_y_ < min_y) {
+      return false;
+    }
+
+    if (outline_.empty()) {
+      return true;
+    }
+
+    // The box is in the polygon, or an edge of the polygon passes the box. The horizontal edges
+    // are also checked, since a box may only overlap the polygon across one of them
+    float corner[2] = {min_x, min_y};
+    uint8_t inside = 0;
+
+    testPolygon(corner, corner + 1, 1, &inside);
+
+    if (inside) {
+      return true;
+    }
+
+    for (const auto & e : outline_) {
+      if (clipSegment(e.x0, e.y0, e.x1, e.y1, min_x, min_y, max_x, max_y)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  // Remove the points outside the region from cloud, keeping the order of the others
+  template <class PointT>
+  void filter(pcl::PointCloud<PointT> & cloud) const
+  {
+    std::array<float, batch_size> x, y;
+    std::array<uint8_t, batch_size> inside;
+    size_t kept_num = 0;
+
+    for (size_t begin = 0; begin < cloud.size(); begin += batch_size) {
+      size_t n = std::min(batch_size, cloud.size() - begin);
+
+      for (size_t i = 0; i < n; ++i) {
+        x[i] = cloud[begin + i].x;
+        y[i] = cloud[begin + i].y;
+      }
+
+      // The polygon is also bounded by its box, which rejects most of the points far from it
+      for (size_t i = 0; i < n; ++i) {
+        inside[i] = (min_x_ <= x[i]) & (x[i] <= max_x_) & (min_y_ <= y[i]) & (y[i] <= max_y_);
+      }
+
+      if (!edges_.empty()) {
+        std::array<uint8_t, batch_size> in_polygon;
+
+        testPolygon(x.data(), y.data(), n, in_polygon.data());
+
+        for (size_t i = 0; i < n; ++i) {
+          inside[i] &= in_polygon[i];
+        }
+      }
+
+      for (size_t i = 0; i < n; ++i) {
+        if (inside[i]) {
+          cloud[kept_num++] = cloud[begin + i];
+        }
+      }
+    }
+
+    cloud.resize(kept_num);
+  }
+
+private:
+  static constexpr size_t batch_size = 1024;
+
+  struct Edge
+  {
+    float x0, y0, x1, y1;
+    float dxdy;  // Change of x along the edge per unit of y
+  };
+
+  // Set inside[i] to 1 if (x[i], y[i]) is in the polygon, by counting the edges crossed by the ray
+  // from the point to +x
+  void testPolygon(const float * x, const float * y, size_t n, uint8_t * inside) const
+  {
+    std::fill(inside, inside + n, 0);
+
+    for (const auto & e : edges_) {
+      for (size_t i = 0; i < n; ++i) {
+        uint8_t straddles = (e.y0 > y[i]) != (e.y1 > y[i]);
+        uint8_t left = x[i] < e.x0 + (y[i] - e.y0) * e.dxdy;
+
+        inside[i] ^= straddles & left;
+      }
+    }
+  }
+
+  // Check if the segment from (x0, y0) to (x1, y1) passes the box, by clipping it
+  // (Liang-Barsky)
+  static bool clipSegment(
+    float x0, float y0, float x1, float y1, float min_x, float min_y, float max_x, float max_y)
+  {
+    float t0 = 0.0f, t1 = 1.0f;
+    float dx = x1 - x0, dy = y1 - y0;
+    const float p[4] = {-dx, dx, -dy, dy};
+    const float q[4] = {x0 - min_x, max_x - x0, y0 - min_y, max_y - y0};
+
+    for (int k = 0; k < 4; ++k) {
+      if (p[k] == 0.0f) {
+        if (q[k] < 0.0f) {
+          return false;
+        }
+
+        continue;
+      }
+
+      float t = q[k] / p[k];
+
+      if (p[k] < 0.0f) {
+        t0 = std::max(t0, t);
+      } else {
+        t1 = std::min(t1, t);
+      }
+
+      if (t0 > t1) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool is_set_ = false;
+  float min_x_ = 0.0f, min_y_ = 0.0f, max_x_ = 0.0f, max_y_ = 0.0f;
+  std::vector<Edge> edges_;    // Non-horizontal edges of the polygon, empty for a box
+  std::vector<Edge> outline_;  // All the edges of the polygon, empty for a box
+};
+
+}  // namespace autoware::pointcloud_merger
+
+#endif  // AUTOWARE__POINTCLOUD_MERGER__REGION_FILTER_HPP_
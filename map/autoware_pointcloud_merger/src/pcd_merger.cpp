@@ -43,14 +43,23 @@
 
 #include "include/pointcloud_merger_node.hpp"
 
-#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/tile_index.hpp>
 #include <autoware/pointcloud_divider/utility.hpp>
 #include <autoware/pointcloud_merger/pcd_merger.hpp>
+#include <autoware/profiling_utils/profiling_utils.hpp>
 
 #include <pcl/console/print.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
@@ -83,13 +92,144 @@ std::vector<std::string> PCDMerger<PointT>::discoverPCDs(const std::string & inp
 
   RCLCPP_INFO(logger_, "Found %lu PCD files", pcd_list.size());
 
+  scanHeaders(pcd_list);
+
   return pcd_list;
 }
 
+template <class PointT>
+void PCDMerger<PointT>::scanHeaders(const std::vector<std::string> & pcd_names)
+{
+  std::vector<std::string> new_names;
+
+  for (const auto & pcd_name : pcd_names) {
+    if (pcd_headers_.count(pcd_name) == 0) {
+      new_names.push_back(pcd_name);
+    }
+  }
+
+  if (new_names.empty()) {
+    return;
+  }
+
+  auto infos = autoware::pointcloud_divider::scanPCDHeaders(new_names, thread_num_);
+  size_t point_num = 0, byte_size = 0;
+
+  for (auto & info : infos) {
+    if (!info.valid) {
+      RCLCPP_WARN(logger_, "Failed to read the header of %s", info.path.c_str());
+    }
+
+    point_num += info.point_num;
+    byte_size += info.file_size;
+    pcd_headers_[info.path] = std::move(info);
+  }
+
+  RCLCPP_INFO(
+    logger_, "Scanned %lu PCD headers: %lu points, %.1f MB", new_names.size(), point_num,
+    byte_size / (1024.0 * 1024.0));
+}
+
+template <class PointT>
+std::vector<std::string> PCDMerger<PointT>::selectRegionTiles(const std::string & input)
+{
+  // The index and the metadata are next to the folder of the tiles, or in it
+  fs::path input_path(input);
+  std::vector<fs::path> map_dirs = {input_path, input_path.parent_path()};
+  std::vector<std::string> tiles;
+  size_t tile_num = 0;
+
+  for (const auto & dir : map_dirs) {
+    autoware::pointcloud_divider::TileIndexHeader header;
+    std::vector<autoware::pointcloud_divider::TileIndexRecord> records;
+    std::vector<std::string> tile_paths;
+
+    if (!autoware::pointcloud_divider::loadTileIndex(
+          (dir / "pointcloud_map_index.bin").string(), header, records, tile_paths)) {
+      continue;
+    }
+
+    // The records have the bounds of the points, which are tighter than the grids
+    for (size_t i = 0; i < records.size(); ++i) {
+      const auto & rec = records[i];
+
+      if (
+        rec.point_num > 0 &&
+        region_.intersects(rec.min_pt[0], rec.min_pt[1], rec.max_pt[0], rec.max_pt[1])) {
+        tiles.push_back((dir / tile_paths[i]).string());
+      }
+    }
+
+    tile_num = records.size();
+    break;
+  }
+
+  for (const auto & dir : map_dirs) {
+    auto metadata_path = dir / "pointcloud_map_metadata.yaml";
+
+    if (tile_num > 0 || !fs::exists(metadata_path)) {
+      continue;
+    }
+
+    // The metadata has only the names of the tiles, which may be in the folders of large grids
+    std::unordered_map<std::string, std::string> pcd_paths;
+    auto pcd_dir = dir / "pointcloud_map.pcd";
+
+    for (const auto & entry :
+         fs::recursive_directory_iterator(fs::is_directory(pcd_dir) ? pcd_dir : input_path)) {
+      if (fs::is_regular_file(entry.status()) && entry.path().extension() == ".pcd") {
+        pcd_paths[entry.path().filename().string()] = entry.path().string();
+      }
+    }
+
+    try {
+      YAML::Node metadata = YAML::LoadFile(metadata_path.string());
+      auto x_resolution = metadata["x_resolution"].as<float>();
+      auto y_resolution = metadata["y_resolution"].as<float>();
+
+      for (const auto & entry : metadata) {
+        auto name = entry.first.as<std::string>();
+        auto path_it = pcd_paths.find(name);
+
+        if (name == "x_resolution" || name == "y_resolution" || path_it == pcd_paths.end()) {
+          continue;
+        }
+
+        // Tiles are named by the lower corner of their grid
+        auto grid = entry.second.as<std::vector<float>>();
+
+        if (region_.intersects(grid[0], grid[1], grid[0] + x_resolution, grid[1] + y_resolution)) {
+          tiles.push_back(path_it->second);
+        }
+
+        ++tile_num;
+      }
+    } catch (YAML::Exception & e) {
+      RCLCPP_WARN(logger_, "Cannot load the metadata %s: %s", metadata_path.c_str(), e.what());
+      tiles.clear();
+      tile_num = 0;
+    }
+
+    break;
+  }
+
+  if (tile_num == 0) {
+    RCLCPP_WARN(
+      logger_, "No tile index or metadata in %s, all PCD files are read for the region",
+      input.c_str());
+
+    return discoverPCDs(input);
+  }
+
+  RCLCPP_INFO(logger_, "Selected %lu/%lu tiles in the region", tiles.size(), tile_num);
+
+  return tiles;
+}
+
 template <class PointT>
 void PCDMerger<PointT>::run()
 {
-  auto pcd_list = discoverPCDs(input_dir_);
+  auto pcd_list = region_.isSet() ? selectRegionTiles(input_dir_) : discoverPCDs(input_dir_);
 
   run(pcd_list);
 }
@@ -97,6 +237,7 @@ void PCDMerger<PointT>::run()
 template <class PointT>
 void PCDMerger<PointT>::run(const std::vector<std::string> & pcd_names)
 {
+  AUTOWARE_PROFILE_FUNCTION();
   // Just in case the downsampling option is on
   if (leaf_size_ > 0) {
     tmp_dir_ = "./pointcloud_merger_tmp/";
@@ -115,6 +256,8 @@ void PCDMerger<PointT>::run(const std::vector<std::string> & pcd_names)
   if (leaf_size_ > 0) {
     mergeWithDownsample(pcd_names);
     autoware::pointcloud_divider::util::remove(tmp_dir_);
+  } else if (region_.isSet()) {
+    mergeRegion(pcd_names);
   } else {
     mergeWithoutDownsample(pcd_names);
   }
@@ -123,57 +266,282 @@ void PCDMerger<PointT>::run(const std::vector<std::string> & pcd_names)
 template <class PointT>
 void PCDMerger<PointT>::mergeWithDownsample(const std::vector<std::string> & input_pcds)
 {
-  RCLCPP_INFO(logger_, "Downsampling by PointCloudDivider");
-  // Divide the input clouds to smaller segments
-  autoware::pointcloud_divider::PCDDivider<PointT> pcd_divider(logger_);
-
-  pcd_divider.setOutputDir(tmp_dir_);
-  pcd_divider.setGridSize(leaf_size_ * 100, leaf_size_ * 100);
-  pcd_divider.setPrefix("tmp_segment");
-  pcd_divider.setLeafSize(leaf_size_);
-  pcd_divider.setDebugMode(false);
-  pcd_divider.run(input_pcds);
-
-  // Now go get path of the segmentation pcd
-  std::vector<std::string> seg_names;
-  fs::path tmp_path(tmp_dir_);
-
-  for (auto & entry : fs::recursive_directory_iterator(tmp_path)) {
-    if (fs::is_regular_file(entry.symlink_status())) {
-      auto fname = entry.path().string();
-      auto ext = fname.substr(fname.size() - 4);
+  AUTOWARE_PROFILE_FUNCTION();
+  RCLCPP_INFO(logger_, "Downsampling by a streaming voxel grid");
+
+  shards_.clear();
+  spilled_shards_.clear();
+  voxel_num_ = 0;
 
-      if (ext == ".pcd") {
-        seg_names.push_back(fname);
+  // Accumulate the points of all inputs to the voxels
+  autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+  size_t file_counter = 0;
+
+  reader.setBlockSize(max_block_size_);
+
+  for (const auto & pcd_name : input_pcds) {
+    if (!rclcpp::ok()) {
+      return;
+    }
+
+    RCLCPP_INFO(
+      logger_, "Processing file [%lu/%lu] %s", file_counter, input_pcds.size(), pcd_name.c_str());
+    ++file_counter;
+
+    reader.setInput(pcd_name);
+
+    do {
+      PclCloudType new_cloud;
+
+      reader.readABlock(new_cloud);
+
+      if (region_.isSet()) {
+        region_.filter(new_cloud);
+      }
+
+      accumulate(new_cloud);
+
+      // Save the biggest shards to the tmp directory until the voxels fit into memory again
+      while (voxel_num_ > max_voxel_num_ && !shards_.empty()) {
+        auto max_it = shards_.begin();
+
+        for (auto it = shards_.begin(); it != shards_.end(); ++it) {
+          if (it->second.size() > max_it->second.size()) {
+            max_it = it;
+          }
+        }
+
+        spillShard(max_it);
       }
+      AUTOWARE_PROFILE_COUNTER("voxel_num", static_cast<double>(voxel_num_));
+    } while (reader.good() && rclcpp::ok());
+  }
+
+  if (spilled_shards_.size() > 0) {
+    RCLCPP_INFO(logger_, "%lu shards were saved to the tmp directory", spilled_shards_.size());
+  }
+
+  // Write the centroids of the voxels to the output
+  if (use_compression_) {
+    // The compressed data is written at once, so the number of points must be known first
+    PclCloudType output_cloud;
+
+    emitShards([&output_cloud](const PclCloudType & cloud) { output_cloud += cloud; });
+
+    writer_.setOutput(output_pcd_);
+    writer_.writeMetadata(output_cloud.size(), true, true);
+    writer_.write(output_cloud);
+  } else {
+    size_t output_point_num = 0;
+
+    writer_.setResizableMetadata(true);
+    writer_.setOutput(output_pcd_);
+    writer_.writeMetadata(0, true);
+
+    emitShards([this, &output_point_num](const PclCloudType & cloud) {
+      writer_.write(cloud);
+      output_point_num += cloud.size();
+    });
+
+    writer_.updateMetadata(output_point_num);
+  }
+
+  writer_.close();
+  writer_.setResizableMetadata(false);
+}
+
+template <class PointT>
+void PCDMerger<PointT>::accumulate(const PclCloudType & cloud)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  auto to_shard = [this](const VoxelKey & voxel) {
+    auto floor_div = [this](int v) {
+      return (v >= 0) ? v / shard_size_ : (v - shard_size_ + 1) / shard_size_;
+    };
+
+    return ShardKey(floor_div(voxel.ix), floor_div(voxel.iy));
+  };
+
+  if (thread_num_ <= 1) {
+    for (const auto & p : cloud) {
+      auto voxel = pointToGrid3(p, leaf_size_, leaf_size_, leaf_size_);
+      auto & shard = shards_[to_shard(voxel)];
+      auto prev_size = shard.size();
+
+      shard[voxel].add(p);
+      voxel_num_ += shard.size() - prev_size;
     }
+
+    return;
   }
 
-  // Now merge the downsampled segments
-  mergeWithoutDownsample(seg_names);
+  // Each thread updates only the shards assigned to it, so no lock is needed on the voxels.
+  // The shards are created here because the map of shards cannot be modified concurrently
+  std::vector<ShardKey> point_shards(cloud.size());
+  std::vector<VoxelMap *> shard_ptrs(cloud.size());
+
+  for (size_t i = 0; i < cloud.size(); ++i) {
+    point_shards[i] = to_shard(pointToGrid3(cloud[i], leaf_size_, leaf_size_, leaf_size_));
+    shard_ptrs[i] = &shards_[point_shards[i]];
+  }
+
+  std::vector<size_t> new_voxel_nums(thread_num_, 0);
+  std::vector<std::thread> workers;
+  std::hash<ShardKey> shard_hash;
+
+  for (int tid = 0; tid < thread_num_; ++tid) {
+    workers.emplace_back([&, tid]() {
+      for (size_t i = 0; i < cloud.size(); ++i) {
+        if (shard_hash(point_shards[i]) % thread_num_ != static_cast<size_t>(tid)) {
+          continue;
+        }
+
+        auto & shard = *shard_ptrs[i];
+        auto prev_size = shard.size();
+
+        shard[pointToGrid3(cloud[i], leaf_size_, leaf_size_, leaf_size_)].add(cloud[i]);
+        new_voxel_nums[tid] += shard.size() - prev_size;
+      }
+    });
+  }
+
+  for (auto & w : workers) {
+    w.join();
+  }
+
+  for (auto n : new_voxel_nums) {
+    voxel_num_ += n;
+  }
+}
+
+template <class PointT>
+std::string PCDMerger<PointT>::makeSpillPath(const ShardKey & shard) const
+{
+  std::ostringstream path;
+
+  path << tmp_dir_ << "shard_" << shard << ".bin";
+
+  return path.str();
+}
+
+template <class PointT>
+void PCDMerger<PointT>::spillShard(
+  typename std::unordered_map<ShardKey, VoxelMap>::iterator shard_it)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  std::vector<std::pair<VoxelKey, CentroidType>> records(
+    shard_it->second.begin(), shard_it->second.end());
+  std::ofstream spill_file(
+    makeSpillPath(shard_it->first), std::ios::binary | std::ios::out | std::ios::app);
+
+  if (!spill_file.is_open()) {
+    RCLCPP_ERROR(logger_, "Error: Failed to open %s", makeSpillPath(shard_it->first).c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  // The file is only read by emitShards, so the records are saved as they are in memory
+  spill_file.write(
+    reinterpret_cast<const char *>(records.data()), records.size() * sizeof(records[0]));
+
+  spilled_shards_.insert(shard_it->first);
+  voxel_num_ -= shard_it->second.size();
+  shards_.erase(shard_it);
+}
+
+template <class PointT>
+void PCDMerger<PointT>::emitShards(const std::function<void(const PclCloudType &)> & output)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  // Reload the saved voxels of the spilled shards, which may overlap the resident ones
+  for (const auto & shard : spilled_shards_) {
+    std::string spill_path = makeSpillPath(shard);
+    std::ifstream spill_file(spill_path, std::ios::binary);
+    std::vector<std::pair<VoxelKey, CentroidType>> records(
+      fs::file_size(spill_path) / sizeof(std::pair<VoxelKey, CentroidType>));
+
+    spill_file.read(reinterpret_cast<char *>(records.data()), records.size() * sizeof(records[0]));
+
+    auto & voxels = shards_[shard];
+
+    for (const auto & rec : records) {
+      voxels[rec.first].add(rec.second);
+    }
+
+    PclCloudType cloud;
+
+    cloud.reserve(voxels.size());
+
+    for (auto & v : voxels) {
+      cloud.push_back(v.second.get());
+    }
+
+    output(cloud);
+
+    // Free the memory for the next spilled shard
+    voxel_num_ -= std::min(voxel_num_, voxels.size());
+    shards_.erase(shard);
+    fs::remove(spill_path);
+  }
+
+  for (auto & shard : shards_) {
+    PclCloudType cloud;
+
+    cloud.reserve(shard.second.size());
+
+    for (auto & v : shard.second) {
+      cloud.push_back(v.second.get());
+    }
+
+    output(cloud);
+  }
+
+  shards_.clear();
+  spilled_shards_.clear();
+  voxel_num_ = 0;
 }
 
 template <class PointT>
 void PCDMerger<PointT>::mergeWithoutDownsample(const std::vector<std::string> & input_pcds)
 {
+  AUTOWARE_PROFILE_FUNCTION();
   if (input_pcds.size() == 0) {
     RCLCPP_INFO(logger_, "No input PCDs. Return!");
 
     return;
   }
 
-  // Check the number of points of the merger
+  // Check the number of points of the merger, and where each input starts in the output
   size_t total_point_num = 0;
+  std::vector<size_t> point_offsets;
   autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
 
+  scanHeaders(input_pcds);
+  point_offsets.reserve(input_pcds.size());
+
   for (const auto & pcd_name : input_pcds) {
-    reader.setInput(pcd_name);
+    const auto & header = pcd_headers_[pcd_name];
+
+    point_offsets.push_back(total_point_num);
 
-    total_point_num += reader.point_num();
+    if (header.valid) {
+      total_point_num += header.point_num;
+    } else {
+      // Let the reader report why the file cannot be read
+      reader.setInput(pcd_name);
+      total_point_num += reader.point_num();
+    }
+  }
+
+  // The compressed data is a single chunk, so it cannot be written in parts
+  if (thread_num_ > 1 && !use_compression_) {
+    mergeInParallel(input_pcds, point_offsets, total_point_num);
+
+    return;
   }
 
   writer_.setOutput(output_pcd_);
-  writer_.writeMetadata(total_point_num, true);
+  writer_.writeMetadata(total_point_num, true, use_compression_);
 
   size_t file_counter = 0;
 
@@ -195,6 +563,165 @@ void PCDMerger<PointT>::mergeWithoutDownsample(const std::vector<std::string> &
       writer_.write(new_cloud);
     } while (reader.good() && rclcpp::ok());
   }
+
+  // Flush the output, so that it is complete when run returns
+  writer_.close();
+}
+
+template <class PointT>
+void PCDMerger<PointT>::mergeRegion(const std::vector<std::string> & input_pcds)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+  // The compressed data is written at once, so its points are kept until the end
+  PclCloudType output_cloud;
+  size_t output_point_num = 0;
+  size_t file_counter = 0;
+
+  reader.setBlockSize(max_block_size_);
+  reader.setThreadNum(thread_num_);
+
+  if (!use_compression_) {
+    writer_.setResizableMetadata(true);
+    writer_.setOutput(output_pcd_);
+    writer_.writeMetadata(0, true);
+  }
+
+  for (const auto & pcd_name : input_pcds) {
+    if (!rclcpp::ok()) {
+      return;
+    }
+
+    RCLCPP_INFO(
+      logger_, "Processing file [%lu/%lu] %s", file_counter, input_pcds.size(), pcd_name.c_str());
+    ++file_counter;
+
+    reader.setInput(pcd_name);
+
+    do {
+      PclCloudType new_cloud;
+
+      reader.readABlock(new_cloud);
+      region_.filter(new_cloud);
+
+      if (use_compression_) {
+        output_cloud += new_cloud;
+      } else {
+        writer_.write(new_cloud);
+      }
+
+      output_point_num += new_cloud.size();
+    } while (reader.good() && rclcpp::ok());
+  }
+
+  if (use_compression_) {
+    writer_.setOutput(output_pcd_);
+    writer_.writeMetadata(output_cloud.size(), true, true);
+    writer_.write(output_cloud);
+  } else {
+    writer_.updateMetadata(output_point_num);
+  }
+
+  writer_.close();
+  writer_.setResizableMetadata(false);
+
+  RCLCPP_INFO(logger_, "Extracted %lu points in the region", output_point_num);
+}
+
+template <class PointT>
+void PCDMerger<PointT>::mergeInParallel(
+  const std::vector<std::string> & input_pcds, const std::vector<size_t> & point_offsets,
+  size_t total_point_num)
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  writer_.setOutput(output_pcd_);
+  writer_.writeMetadata(total_point_num, true);
+
+  size_t point_size = writer_.point_size();
+  size_t data_offset = writer_.presize();
+
+  int fd = open(output_pcd_.c_str(), O_WRONLY);
+
+  if (fd < 0) {
+    RCLCPP_ERROR(logger_, "Error: Failed to open %s for writing", output_pcd_.c_str());
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
+
+  std::atomic<size_t> next_file(0);
+  std::atomic<size_t> file_counter(0);
+  std::atomic<bool> failed(false);
+
+  auto worker = [&]() {
+    autoware::pointcloud_divider::CustomPCDReader<PointT> reader;
+    autoware::pointcloud_divider::CustomPCDWriter<PointT> serializer;
+    std::vector<char> buffer;
+
+    reader.setBlockSize(max_block_size_);
+    // Only the field layout of the serializer is used, not its write buffer
+    serializer.setBlockSize(1);
+
+    for (size_t fid = next_file++; fid < input_pcds.size() && rclcpp::ok() && !failed;
+         fid = next_file++) {
+      RCLCPP_INFO(
+        logger_, "Processing file [%lu/%lu] %s", file_counter++, input_pcds.size(),
+        input_pcds[fid].c_str());
+
+      reader.setInput(input_pcds[fid]);
+
+      // Points beyond the header of this input would overwrite the next input
+      size_t end_point = point_offsets[fid] + reader.point_num();
+      size_t write_point = point_offsets[fid];
+
+      do {
+        PclCloudType new_cloud;
+
+        reader.readABlock(new_cloud);
+
+        size_t proc_size = std::min(new_cloud.size(), end_point - write_point);
+
+        buffer.resize(proc_size * point_size);
+        serializer.serialize(new_cloud, 0, proc_size, buffer.data());
+
+        // pwrite may write less than requested, so write until the whole block is done
+        size_t written = 0;
+
+        while (written < buffer.size()) {
+          ssize_t res = pwrite(
+            fd, buffer.data() + written, buffer.size() - written,
+            data_offset + write_point * point_size + written);
+
+          if (res <= 0) {
+            RCLCPP_ERROR(logger_, "Error: Failed to write to %s", output_pcd_.c_str());
+            failed = true;
+            break;
+          }
+
+          written += res;
+        }
+
+        write_point += proc_size;
+      } while (reader.good() && write_point < end_point && rclcpp::ok() && !failed);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  int thread_num = std::min(thread_num_, static_cast<int>(input_pcds.size()));
+
+  for (int i = 0; i < thread_num; ++i) {
+    workers.emplace_back(worker);
+  }
+
+  for (auto & w : workers) {
+    w.join();
+  }
+
+  close(fd);
+
+  if (failed) {
+    rclcpp::shutdown();
+    exit(EXIT_FAILURE);
+  }
 }
 
 template <class PointT>
@@ -205,6 +732,24 @@ void PCDMerger<PointT>::paramInitialize()
     auto params = conf["/**"]["ros__parameters"];
 
     leaf_size_ = params["leaf_size"].as<double>();
+
+    if (params["use_compression"]) {
+      use_compression_ = params["use_compression"].as<bool>();
+    }
+
+    if (params["thread_num"]) {
+      setThreadNum(params["thread_num"].as<int>());
+    }
+
+    if (params["region"]) {
+      auto region = params["region"].as<std::vector<double>>();
+
+      if (!region.empty() && !setRegion(region)) {
+        RCLCPP_ERROR(logger_, "Error: Invalid region of %lu values", region.size());
+        rclcpp::shutdown();
+        exit(EXIT_FAILURE);
+      }
+    }
   } catch (YAML::Exception & e) {
     RCLCPP_ERROR(logger_, "YAML Error: %s", e.what());
     rclcpp::shutdown();
@@ -214,8 +759,9 @@ void PCDMerger<PointT>::paramInitialize()
 
 template class PCDMerger<pcl::PointXYZ>;
 template class PCDMerger<pcl::PointXYZI>;
-// template class PCDMerger<pcl::PointXYZINormal>;
-// template class PCDMerger<pcl::PointXYZRGB>;
-// template class PCDMerger<pcl::PointNormal>;
+template class PCDMerger<pcl::PointXYZRGB>;
+template class PCDMerger<pcl::PointNormal>;
+template class PCDMerger<pcl::PointXYZINormal>;
+template class PCDMerger<autoware::pointcloud_divider::PointXYZIRT>;
 
 }  // namespace autoware::pointcloud_merger
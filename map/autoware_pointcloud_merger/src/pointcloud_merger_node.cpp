@@ -14,11 +14,14 @@
 
 #include "include/pointcloud_merger_node.hpp"
 
+#include <autoware/pointcloud_divider/point_types.hpp>
 #include <autoware/pointcloud_merger/pcd_merger.hpp>
+#include <autoware/profiling_utils/profiling_utils.hpp>
 
 #include <pcl/point_types.h>
 
 #include <string>
+#include <vector>
 
 namespace autoware::pointcloud_merger
 {
@@ -26,11 +29,16 @@ namespace autoware::pointcloud_merger
 PointCloudMerger::PointCloudMerger(const rclcpp::NodeOptions & node_options)
 : Node("pointcloud_merger", node_options)
 {
+  AUTOWARE_PROFILE_INIT(*this);
+
   // Load command parameters
   float leaf_size = declare_parameter<float>("leaf_size");
   std::string input_pcd_dir = declare_parameter<std::string>("input_pcd_dir");
   std::string output_pcd = declare_parameter<std::string>("output_pcd");
   std::string point_type = declare_parameter<std::string>("point_type");
+  bool use_compression = declare_parameter<bool>("use_compression", false);
+  int thread_num = declare_parameter<int>("thread_num", 1);
+  auto region = declare_parameter<std::vector<double>>("region", std::vector<double>());
 
   // Enter a new line and clear it
   // This is to get rid of the prefix of RCLCPP_INFO
@@ -48,26 +56,60 @@ PointCloudMerger::PointCloudMerger(const rclcpp::NodeOptions & node_options)
   param_display << "\tinput_pcd_dir: " << input_pcd_dir << line_breaker;
   param_display << "\toutput_pcd: " << output_pcd << line_breaker;
   param_display << "\tpoint_type: " << point_type << line_breaker;
+
+  if (use_compression) {
+    param_display << "\tuse_compression: True" << line_breaker;
+  } else {
+    param_display << "\tuse_compression: False" << line_breaker;
+  }
+
+  param_display << "\tthread_num: " << thread_num << line_breaker;
+
+  if (!region.empty()) {
+    param_display << "\tregion:";
+
+    for (auto v : region) {
+      param_display << " " << v;
+    }
+
+    param_display << line_breaker;
+  }
+
   param_display << "######################################" << line_breaker;
 
   RCLCPP_INFO(get_logger(), "%s", param_display.str().c_str());
 
-  if (point_type == "point_xyz") {
-    autoware::pointcloud_merger::PCDMerger<pcl::PointXYZ> pcd_merger_exe(get_logger());
+  auto run = [&](auto point) {
+    autoware::pointcloud_merger::PCDMerger<decltype(point)> pcd_merger_exe(get_logger());
 
     pcd_merger_exe.setLeafSize(leaf_size);
     pcd_merger_exe.setInput(input_pcd_dir);
     pcd_merger_exe.setOutput(output_pcd);
+    pcd_merger_exe.setCompression(use_compression);
+    pcd_merger_exe.setThreadNum(thread_num);
 
-    pcd_merger_exe.run();
-  } else if (point_type == "point_xyzi") {
-    autoware::pointcloud_merger::PCDMerger<pcl::PointXYZI> pcd_merger_exe(get_logger());
-
-    pcd_merger_exe.setLeafSize(leaf_size);
-    pcd_merger_exe.setInput(input_pcd_dir);
-    pcd_merger_exe.setOutput(output_pcd);
+    if (!region.empty() && !pcd_merger_exe.setRegion(region)) {
+      RCLCPP_ERROR(get_logger(), "Error: Invalid region of %lu values", region.size());
+      return;
+    }
 
     pcd_merger_exe.run();
+  };
+
+  if (point_type == "point_xyz") {
+    run(pcl::PointXYZ());
+  } else if (point_type == "point_xyzi") {
+    run(pcl::PointXYZI());
+  } else if (point_type == "point_xyzrgb") {
+    run(pcl::PointXYZRGB());
+  } else if (point_type == "point_normal") {
+    run(pcl::PointNormal());
+  } else if (point_type == "point_xyzinormal") {
+    run(pcl::PointXYZINormal());
+  } else if (point_type == "point_xyzirt") {
+    run(autoware::pointcloud_divider::PointXYZIRT());
+  } else {
+    RCLCPP_ERROR(get_logger(), "Error: Unknown point type %s", point_type.c_str());
   }
 
   rclcpp::shutdown();
@@ -0,0 +1,75 @@
+// Copyright 2024 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "autoware/pointcloud_merger/region_filter.hpp"
+
+#include <gtest/gtest.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+using autoware::pointcloud_merger::RegionFilter;
+
+TEST(RegionFilter, Box)
+{
+  RegionFilter region;
+
+  ASSERT_TRUE(region.set({0.0, 10.0, 100.0, 50.0}));
+  EXPECT_TRUE(region.intersects(40.0f, 0.0f, 60.0f, 20.0f));
+  EXPECT_TRUE(region.intersects(-10.0f, -10.0f, 200.0f, 200.0f));
+  EXPECT_FALSE(region.intersects(40.0f, 60.0f, 60.0f, 80.0f));
+  EXPECT_FALSE(region.set({0.0, 10.0, 100.0}));
+}
+
+TEST(RegionFilter, TileAcrossHorizontalEdge)
+{
+  RegionFilter region;
+
+  // The tiles are only crossed by the horizontal edges of an axis-aligned polygon
+  ASSERT_TRUE(region.set({0.0, 10.0, 100.0, 10.0, 100.0, 50.0, 0.0, 50.0}));
+  EXPECT_TRUE(region.intersects(40.0f, 0.0f, 60.0f, 20.0f));
+  EXPECT_TRUE(region.intersects(40.0f, 40.0f, 60.0f, 60.0f));
+  EXPECT_TRUE(region.intersects(40.0f, 20.0f, 60.0f, 30.0f));
+  EXPECT_FALSE(region.intersects(40.0f, 60.0f, 60.0f, 80.0f));
+  EXPECT_FALSE(region.intersects(110.0f, 0.0f, 120.0f, 20.0f));
+}
+
+TEST(RegionFilter, TriangleCorner)
+{
+  RegionFilter region;
+
+  // The tile is in the box of the triangle, but not in the triangle
+  ASSERT_TRUE(region.set({0.0, 0.0, 100.0, 0.0, 0.0, 100.0}));
+  EXPECT_TRUE(region.intersects(10.0f, 10.0f, 20.0f, 20.0f));
+  EXPECT_FALSE(region.intersects(80.0f, 80.0f, 90.0f, 90.0f));
+}
+
+TEST(RegionFilter, Filter)
+{
+  RegionFilter region;
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+
+  ASSERT_TRUE(region.set({0.0, 0.0, 100.0, 0.0, 0.0, 100.0}));
+
+  for (float v : {5.0f, 40.0f, 60.0f, 95.0f}) {
+    cloud.push_back(pcl::PointXYZ(v, v, 0.0f));
+  }
+
+  region.filter(cloud);
+
+  ASSERT_EQ(cloud.size(), 2u);
+  EXPECT_FLOAT_EQ(cloud[0].x, 5.0f);
+  EXPECT_FLOAT_EQ(cloud[1].x, 40.0f);
+}
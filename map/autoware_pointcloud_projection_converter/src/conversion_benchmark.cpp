@@ -0,0 +1,229 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the throughput and the accuracy of the conversion between the projections of two YAML
+// configuration files. Random points are generated over a square of the input projection, and
+// converted exactly and through the conversion grid with 1, 8 and 32 threads. The errors of the
+// grid are measured against the exact conversion, and the round-trip errors of both against the
+// input points, converting back with GeographicLib.
+
+#include "conversion_grid.hpp"
+#include "converter_from_llh.hpp"
+#include "converter_to_llh.hpp"
+
+#include <GeographicLib/MGRS.hpp>
+#include <GeographicLib/TransverseMercatorExact.hpp>
+
+#include <omp.h>
+#include <yaml-cpp/yaml.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace autoware::pointcloud_projection_converter
+{
+
+// Conversion grid parameters of pointcloud_projection_converter
+constexpr double grid_spacing = 100.0;   // [m]
+constexpr double grid_tolerance = 5e-4;  // [m]
+
+struct ErrorStats
+{
+  double max = 0.0;
+  double sum_sq = 0.0;
+  size_t num = 0;
+
+  void add(double error)
+  {
+    max = std::max(max, error);
+    sum_sq += error * error;
+    ++num;
+  }
+
+  double rms() const { return (num > 0) ? std::sqrt(sum_sq / num) : 0.0; }
+};
+
+// Run a conversion of point_num points and print its throughput, or only its time if point_num
+// is 0
+void measure(const std::string & name, size_t point_num, const std::function<void()> & func)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  func();
+
+  auto end = std::chrono::steady_clock::now();
+  double sec = std::chrono::duration<double>(end - start).count();
+
+  if (point_num > 0) {
+    printf("%-24s %10.3f s %14.0f points/s\n", name.c_str(), sec, point_num / sec);
+  } else {
+    printf("%-24s %10.3f s\n", name.c_str(), sec);
+  }
+}
+
+// Convert the output of a MGRS to Transverse Mercator conversion back to the input, as
+// ConverterToLLH and ConverterFromLLH have no inverse
+class InverseConverter
+{
+public:
+  InverseConverter(const YAML::Node & input_config, const YAML::Node & output_config)
+  {
+    int prec;
+
+    GeographicLib::MGRS::Reverse(
+      input_config["mgrs_grid"].as<std::string>(), zone_, northern_hemisphere_, mgrs_base_x_,
+      mgrs_base_y_, prec, false);
+
+    central_meridian_ = output_config["map_origin"]["longitude"].as<double>();
+    GeographicLib::TransverseMercatorExact::UTM().Forward(
+      central_meridian_, output_config["map_origin"]["latitude"].as<double>(), central_meridian_,
+      origin_x_, origin_y_);
+  }
+
+  void convert(double x, double y, double & input_x, double & input_y) const
+  {
+    double lat, lon, gamma, k;
+    int zone;
+    bool northern_hemisphere;
+
+    GeographicLib::TransverseMercatorExact::UTM().Reverse(
+      central_meridian_, x + origin_x_, y + origin_y_, lat, lon);
+    GeographicLib::UTMUPS::Forward(
+      lat, lon, zone, northern_hemisphere, input_x, input_y, gamma, k, zone_);
+    input_x -= mgrs_base_x_;
+    input_y -= mgrs_base_y_;
+  }
+
+private:
+  int zone_;
+  bool northern_hemisphere_;
+  double mgrs_base_x_, mgrs_base_y_;
+  double central_meridian_, origin_x_, origin_y_;
+};
+
+}  // namespace autoware::pointcloud_projection_converter
+
+int main(int argc, char ** argv)
+{
+  namespace converter = autoware::pointcloud_projection_converter;
+
+  if (argc < 3) {
+    std::cerr << "Usage: ros2 run autoware_pointcloud_projection_converter "
+                 "pointcloud_projection_converter_benchmark input_yaml output_yaml "
+                 "[point_num] [extent]"
+              << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  YAML::Node input_config = YAML::LoadFile(argv[1]);
+  YAML::Node output_config = YAML::LoadFile(argv[2]);
+  const size_t point_num = (argc > 3) ? std::stoul(argv[3]) : 10000000;
+  const double extent = (argc > 4) ? std::stod(argv[4]) : 10000.0;  // Side of the square [m]
+
+  if (
+    input_config["projector_type"].as<std::string>() != "MGRS" ||
+    output_config["projector_type"].as<std::string>() != "TransverseMercator") {
+    std::cerr << "Only the conversion from MGRS to TransverseMercator is supported" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  converter::ConverterToLLH to_llh(input_config);
+  converter::ConverterFromLLH from_llh(output_config);
+  converter::InverseConverter inverse(input_config, output_config);
+
+  std::cout << "benchmarking with following parameters" << std::endl
+            << "point_num " << point_num << std::endl
+            << "extent " << extent << std::endl
+            << "mgrs_grid " << input_config["mgrs_grid"].as<std::string>() << std::endl;
+
+  // Points over a square at the center of the 100 km MGRS grid
+  std::mt19937 rng(0);
+  std::uniform_real_distribution<double> coordinate(50000.0 - extent / 2, 50000.0 + extent / 2);
+  std::vector<double> input_x(point_num), input_y(point_num);
+
+  for (size_t i = 0; i < point_num; ++i) {
+    input_x[i] = coordinate(rng);
+    input_y[i] = coordinate(rng);
+  }
+
+  std::vector<double> exact_x(point_num), exact_y(point_num);
+  std::vector<double> approx_x(point_num), approx_y(point_num);
+
+  auto exact = [&](double x, double y, double & out_x, double & out_y) {
+    double lat, lon;
+
+    return to_llh.convert(x, y, lat, lon) && from_llh.convert(lat, lon, out_x, out_y);
+  };
+
+  const double min_xy = 50000.0 - extent / 2;
+  const double max_xy = 50000.0 + extent / 2;
+  std::unique_ptr<converter::ConversionGrid> grid;
+
+  converter::measure("grid construction", 0, [&]() {
+    grid = std::make_unique<converter::ConversionGrid>(
+      exact, min_xy, min_xy, max_xy, max_xy, converter::grid_spacing, converter::grid_tolerance);
+  });
+
+  std::cout << grid->valid_cell_num() << " of " << grid->cell_num() << " cells are used"
+            << std::endl;
+
+  for (int thread_num : {1, 8, 32}) {
+    omp_set_num_threads(thread_num);
+
+    converter::measure("exact (" + std::to_string(thread_num) + " threads)", point_num, [&]() {
+#pragma omp parallel for
+      for (size_t i = 0; i < point_num; ++i) {
+        exact(input_x[i], input_y[i], exact_x[i], exact_y[i]);
+      }
+    });
+
+    converter::measure("grid (" + std::to_string(thread_num) + " threads)", point_num, [&]() {
+#pragma omp parallel for
+      for (size_t i = 0; i < point_num; ++i) {
+        if (!grid->convert(input_x[i], input_y[i], approx_x[i], approx_y[i])) {
+          exact(input_x[i], input_y[i], approx_x[i], approx_y[i]);
+        }
+      }
+    });
+  }
+
+  converter::ErrorStats grid_error, exact_round_trip, grid_round_trip;
+
+  for (size_t i = 0; i < point_num; ++i) {
+    double x, y;
+
+    grid_error.add(std::hypot(approx_x[i] - exact_x[i], approx_y[i] - exact_y[i]));
+
+    inverse.convert(exact_x[i], exact_y[i], x, y);
+    exact_round_trip.add(std::hypot(x - input_x[i], y - input_y[i]));
+
+    inverse.convert(approx_x[i], approx_y[i], x, y);
+    grid_round_trip.add(std::hypot(x - input_x[i], y - input_y[i]));
+  }
+
+  printf("%-24s %14s %14s\n", "error [m]", "max", "rms");
+  printf("%-24s %14.3e %14.3e\n", "grid vs exact", grid_error.max, grid_error.rms());
+  printf("%-24s %14.3e %14.3e\n", "exact round trip", exact_round_trip.max, exact_round_trip.rms());
+  printf("%-24s %14.3e %14.3e\n", "grid round trip", grid_round_trip.max, grid_round_trip.rms());
+
+  return 0;
+}
@@ -0,0 +1,118 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "conversion_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace autoware::pointcloud_projection_converter
+{
+
+ConversionGrid::ConversionGrid(
+  const ExactConversion & exact, double min_x, double min_y, double max_x, double max_y,
+  double spacing, double tolerance)
+: min_x_(min_x), min_y_(min_y)
+{
+  const double extent = std::max(max_x - min_x, max_y - min_y);
+
+  spacing_ = std::max(spacing, extent / max_cell_num_per_axis);
+  nx_ = std::max<size_t>(static_cast<size_t>(std::ceil((max_x - min_x) / spacing_)), 1);
+  ny_ = std::max<size_t>(static_cast<size_t>(std::ceil((max_y - min_y) / spacing_)), 1);
+
+  const size_t node_num = (nx_ + 1) * (ny_ + 1);
+  std::vector<uint8_t> node_valid(node_num);
+
+  node_x_.resize(node_num);
+  node_y_.resize(node_num);
+  valid_.resize(nx_ * ny_);
+
+#pragma omp parallel for
+  for (size_t i = 0; i < node_num; ++i) {
+    const double x = min_x_ + (i % (nx_ + 1)) * spacing_;
+    const double y = min_y_ + (i / (nx_ + 1)) * spacing_;
+
+    node_valid[i] = exact(x, y, node_x_[i], node_y_[i]);
+  }
+
+  // Points at which each cell is checked, in units of the spacing
+  constexpr double check_points[5][2] = {
+    {0.5, 0.5}, {0.5, 0.0}, {0.5, 1.0}, {0.0, 0.5}, {1.0, 0.5}};
+
+#pragma omp parallel for
+  for (size_t i = 0; i < valid_.size(); ++i) {
+    const size_t ix = i % nx_;
+    const size_t iy = i / nx_;
+    const size_t corner = iy * (nx_ + 1) + ix;
+    bool valid = node_valid[corner] && node_valid[corner + 1] && node_valid[corner + nx_ + 1] &&
+                 node_valid[corner + nx_ + 2];
+
+    for (size_t k = 0; k < 5 && valid; ++k) {
+      const double fx = check_points[k][0];
+      const double fy = check_points[k][1];
+      double exact_x, exact_y, approx_x, approx_y;
+
+      valid = exact(
+        min_x_ + (ix + fx) * spacing_, min_y_ + (iy + fy) * spacing_, exact_x, exact_y);
+      interpolate(ix, iy, fx, fy, approx_x, approx_y);
+      valid = valid && std::hypot(exact_x - approx_x, exact_y - approx_y) <= tolerance;
+    }
+
+    valid_[i] = valid;
+  }
+}
+
+bool ConversionGrid::convert(double x, double y, double & out_x, double & out_y) const
+{
+  const double gx = (x - min_x_) / spacing_;
+  const double gy = (y - min_y_) / spacing_;
+
+  if (!(gx >= 0 && gy >= 0 && gx <= nx_ && gy <= ny_)) {
+    return false;
+  }
+
+  // Points on the upper edges of the grid belong to the last cells
+  const size_t ix = std::min(static_cast<size_t>(gx), nx_ - 1);
+  const size_t iy = std::min(static_cast<size_t>(gy), ny_ - 1);
+
+  if (!valid_[iy * nx_ + ix]) {
+    return false;
+  }
+
+  interpolate(ix, iy, gx - ix, gy - iy, out_x, out_y);
+
+  return true;
+}
+
+size_t ConversionGrid::valid_cell_num() const
+{
+  return std::count(valid_.begin(), valid_.end(), 1);
+}
+
+void ConversionGrid::interpolate(
+  size_t ix, size_t iy, double fx, double fy, double & out_x, double & out_y) const
+{
+  const size_t n00 = iy * (nx_ + 1) + ix;
+  const size_t n10 = n00 + 1;
+  const size_t n01 = n00 + nx_ + 1;
+  const size_t n11 = n01 + 1;
+
+  // Affine part from the lower left node, plus the bilinear correction
+  out_x = node_x_[n00] + fx * (node_x_[n10] - node_x_[n00]) + fy * (node_x_[n01] - node_x_[n00]) +
+          fx * fy * (node_x_[n11] - node_x_[n10] - node_x_[n01] + node_x_[n00]);
+  out_y = node_y_[n00] + fx * (node_y_[n10] - node_y_[n00]) + fy * (node_y_[n01] - node_y_[n00]) +
+          fx * fy * (node_y_[n11] - node_y_[n10] - node_y_[n01] + node_y_[n00]);
+}
+
+}  // namespace autoware::pointcloud_projection_converter
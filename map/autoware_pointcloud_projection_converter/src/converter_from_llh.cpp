@@ -41,20 +41,16 @@ ConverterFromLLH::ConverterFromLLH(const YAML::Node & config)
   }
 }
 
-pcl::PointXYZI ConverterFromLLH::convert(const LatLonAlt & llh)
+pcl::PointXYZI ConverterFromLLH::convert(const LatLonAlt & llh) const
 {
   pcl::PointXYZI xyz;
   if (projector_type_ == "TransverseMercator") {
-    const GeographicLib::TransverseMercatorExact & proj =
-      GeographicLib::TransverseMercatorExact::UTM();
-
     // Variables to hold the results
-    double x, y;
+    double x = 0.0, y = 0.0;
 
-    // Convert to transverse mercator coordinates
-    proj.Forward(central_meridian_, llh.lat, llh.lon, x, y);
-    xyz.x = x - origin_xy_.first;
-    xyz.y = y - origin_xy_.second;
+    convert(llh.lat, llh.lon, x, y);
+    xyz.x = x;
+    xyz.y = y;
     xyz.z = llh.alt;
 
   } else {
@@ -66,4 +62,21 @@ pcl::PointXYZI ConverterFromLLH::convert(const LatLonAlt & llh)
   return xyz;
 }
 
+bool ConverterFromLLH::convert(double lat, double lon, double & x, double & y) const
+{
+  if (projector_type_ != "TransverseMercator") {
+    return false;
+  }
+
+  const GeographicLib::TransverseMercatorExact & proj =
+    GeographicLib::TransverseMercatorExact::UTM();
+
+  // Convert to transverse mercator coordinates
+  proj.Forward(central_meridian_, lat, lon, x, y);
+  x -= origin_xy_.first;
+  y -= origin_xy_.second;
+
+  return true;
+}
+
 }  // namespace autoware::pointcloud_projection_converter
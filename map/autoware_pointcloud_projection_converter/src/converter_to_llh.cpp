@@ -28,33 +28,48 @@ ConverterToLLH::ConverterToLLH(const YAML::Node & config)
   projector_type_ = config["projector_type"].as<std::string>();
   if (projector_type_ == "MGRS") {
     mgrs_grid_ = config["mgrs_grid"].as<std::string>();
-  }
-}
 
-LatLonAlt ConverterToLLH::convert(const pcl::PointXYZI & xyz)
-{
-  LatLonAlt llh;
-  if (projector_type_ == "MGRS") {
     try {
-      int zone;
-      bool northern_hemisphere;
-      double mgrs_base_x, mgrs_base_y;
       int prec = 8;
       constexpr bool longpath = false;
       GeographicLib::MGRS::Reverse(
-        mgrs_grid_, zone, northern_hemisphere, mgrs_base_x, mgrs_base_y, prec, longpath);
-
-      // Convert UTM to LLH
-      GeographicLib::UTMUPS::Reverse(
-        zone, northern_hemisphere, xyz.x + mgrs_base_x, xyz.y + mgrs_base_y, llh.lat, llh.lon);
-
-      llh.alt = xyz.z;
+        mgrs_grid_, zone_, northern_hemisphere_, mgrs_base_x_, mgrs_base_y_, prec, longpath);
+      mgrs_valid_ = true;
     } catch (const std::exception & e) {
       std::cerr << "Error: Could not convert from MGRS to UTM: " << e.what() << std::endl;
+    }
+  }
+}
+
+LatLonAlt ConverterToLLH::convert(const pcl::PointXYZI & xyz) const
+{
+  LatLonAlt llh;
+  if (projector_type_ == "MGRS") {
+    if (!convert(xyz.x, xyz.y, llh.lat, llh.lon)) {
       return LatLonAlt();
     }
+
+    llh.alt = xyz.z;
   }
   return llh;
 }
 
+bool ConverterToLLH::convert(double x, double y, double & lat, double & lon) const
+{
+  if (projector_type_ != "MGRS" || !mgrs_valid_) {
+    return false;
+  }
+
+  try {
+    // Convert UTM to LLH
+    GeographicLib::UTMUPS::Reverse(
+      zone_, northern_hemisphere_, x + mgrs_base_x_, y + mgrs_base_y_, lat, lon);
+  } catch (const std::exception & e) {
+    std::cerr << "Error: Could not convert from UTM to LLH: " << e.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 }  // namespace autoware::pointcloud_projection_converter
@@ -0,0 +1,65 @@
+// Copyright 2025 Autoware Foundation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CONVERSION_GRID_HPP_
+#define CONVERSION_GRID_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace autoware::pointcloud_projection_converter
+{
+
+// Exact conversion of horizontal coordinates. Return false if the point cannot be converted
+using ExactConversion = std::function<bool(double x, double y, double & out_x, double & out_y)>;
+
+// Piecewise bilinear approximation of a conversion between two projections. Over a cell of the
+// grid, the conversion is close to a local affine map, and the bilinear term takes up most of the
+// rest. A cell is used only if the approximation is within the tolerance of the exact conversion
+// at its center and at the middles of its edges, where the error of the interpolation is largest
+class ConversionGrid
+{
+public:
+  // Sample the conversion on a grid of the given spacing that covers [min_x, max_x] x
+  // [min_y, max_y]. The spacing is increased if more than max_cell_num_per_axis cells are needed
+  ConversionGrid(
+    const ExactConversion & exact, double min_x, double min_y, double max_x, double max_y,
+    double spacing, double tolerance);
+
+  // Approximate the conversion. Return false if the point is outside the grid or in a cell that
+  // failed the check, so that the point is converted exactly instead
+  bool convert(double x, double y, double & out_x, double & out_y) const;
+
+  size_t cell_num() const { return valid_.size(); }
+  size_t valid_cell_num() const;
+
+  static constexpr size_t max_cell_num_per_axis = 4096;
+
+private:
+  void interpolate(
+    size_t ix, size_t iy, double fx, double fy, double & out_x, double & out_y) const;
+
+  double min_x_, min_y_;
+  double spacing_;
+  size_t nx_, ny_;              // Number of cells along the axes
+  std::vector<double> node_x_;  // Converted coordinates of the (nx_ + 1) x (ny_ + 1) nodes
+  std::vector<double> node_y_;
+  std::vector<uint8_t> valid_;  // Whether each cell passed the check
+};
+
+}  // namespace autoware::pointcloud_projection_converter
+
+#endif  // CONVERSION_GRID_HPP_
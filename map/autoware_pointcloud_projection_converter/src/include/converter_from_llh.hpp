@@ -36,7 +36,10 @@ class ConverterFromLLH
 {
 public:
   explicit ConverterFromLLH(const YAML::Node & config);
-  pcl::PointXYZI convert(const LatLonAlt & xyz);
+  pcl::PointXYZI convert(const LatLonAlt & xyz) const;
+
+  // Horizontal part of convert in double precision. Return false if the point cannot be converted
+  bool convert(double lat, double lon, double & x, double & y) const;
 
 private:
   std::string projector_type_;
@@ -34,12 +34,20 @@ class ConverterToLLH
 {
 public:
   explicit ConverterToLLH(const YAML::Node & config);
-  LatLonAlt convert(const pcl::PointXYZI & llh);
+  LatLonAlt convert(const pcl::PointXYZI & llh) const;
+
+  // Horizontal part of convert in double precision. Return false if the point cannot be converted
+  bool convert(double x, double y, double & lat, double & lon) const;
 
 private:
   std::string projector_type_;
   std::string mgrs_grid_;
-  double lat_, lon_;
+
+  // The grid is parsed once, instead of for every point
+  bool mgrs_valid_ = false;
+  int zone_;
+  bool northern_hemisphere_;
+  double mgrs_base_x_, mgrs_base_y_;
 };
 
 }  // namespace autoware::pointcloud_projection_converter
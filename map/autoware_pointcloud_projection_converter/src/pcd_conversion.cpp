@@ -14,60 +14,617 @@
 
 // The original code was written by Koji Minoda
 
+#include "conversion_grid.hpp"
 #include "converter_from_llh.hpp"
 #include "converter_to_llh.hpp"
 #include "lat_lon_alt.hpp"
 
 #include <GeographicLib/MGRS.hpp>
+#include <autoware/pointcloud_divider/pcd_divider.hpp>
+#include <autoware/pointcloud_divider/pcd_io.hpp>
+#include <autoware/task_scheduler/budget.hpp>
+#include <autoware/task_scheduler/task_scheduler.hpp>
+#include <rclcpp/rclcpp.hpp>
 
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_types.h>
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace autoware::pointcloud_projection_converter
+{
+
+using PclCloudType = pcl::PointCloud<pcl::PointXYZI>;
+
+// The altitude is kept by both converters, so only the horizontal conversion is approximated.
+// A grid over the points costs a few exact conversions per cell, instead of two per point
+constexpr double grid_spacing = 100.0;   // [m]
+constexpr double grid_tolerance = 5e-4;  // [m]
+
+// Number of points read, converted and written at once in the streaming modes
+constexpr size_t block_size = 1000000;
+
+struct Bounds
+{
+  double min_x = 0.0, min_y = 0.0, max_x = 0.0, max_y = 0.0;
+  bool empty = true;
+
+  void add(double x, double y)
+  {
+    if (empty) {
+      min_x = max_x = x;
+      min_y = max_y = y;
+      empty = false;
+    } else {
+      min_x = std::min(min_x, x);
+      min_y = std::min(min_y, y);
+      max_x = std::max(max_x, x);
+      max_y = std::max(max_y, y);
+    }
+  }
+
+  void add(const PclCloudType & cloud)
+  {
+    for (const auto & point : cloud) {
+      add(point.x, point.y);
+    }
+  }
+};
+
+ConversionGrid make_grid(
+  const ConverterToLLH & to_llh, const ConverterFromLLH & from_llh, const Bounds & bounds)
+{
+  auto exact = [&](double x, double y, double & out_x, double & out_y) {
+    double lat, lon;
+
+    return to_llh.convert(x, y, lat, lon) && from_llh.convert(lat, lon, out_x, out_y);
+  };
+
+  ConversionGrid grid(
+    exact, bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y, grid_spacing, grid_tolerance);
+
+  std::cout << grid.valid_cell_num() << " of " << grid.cell_num()
+            << " cells of the conversion grid are within " << grid_tolerance * 1000.0 << " mm"
+            << std::endl;
+
+  return grid;
+}
+
+// Origin of the output near the center of the map, rounded to meters. The points are stored
+// relative to it, so that they keep their precision as floats far from the map origin
+std::pair<double, double> local_origin(
+  const ConverterToLLH & to_llh, const ConverterFromLLH & from_llh, const Bounds & bounds)
+{
+  double lat, lon, x, y;
+
+  if (
+    !to_llh.convert(
+      (bounds.min_x + bounds.max_x) / 2.0, (bounds.min_y + bounds.max_y) / 2.0, lat, lon) ||
+    !from_llh.convert(lat, lon, x, y)) {
+    return std::pair<double, double>(0.0, 0.0);
+  }
+
+  return std::pair<double, double>(std::round(x), std::round(y));
+}
+
+// Save the origin of an output PCD next to it, to <output>.origin.yaml
+void save_origin(const std::string & pcd_path, const std::pair<double, double> & origin)
+{
+  const std::string origin_path = fs::path(pcd_path).replace_extension(".origin.yaml").string();
+  std::ofstream origin_file(origin_path);
+
+  origin_file << std::fixed << std::setprecision(3);
+  origin_file << "# Add the origin to the points of " << fs::path(pcd_path).filename().string()
+              << " to get the coordinates in the output projection" << std::endl;
+  origin_file << "x: " << origin.first << std::endl;
+  origin_file << "y: " << origin.second << std::endl;
+  origin_file << "z: 0.0" << std::endl;
+
+  if (!origin_file.good()) {
+    std::cerr << "Couldn't write file " << origin_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::cout << "Saved the origin of the points to " << origin_path << std::endl;
+}
+
+// Output of a conversion, of a projection given by an output YAML
+struct Target
+{
+  std::string path;  // Output PCD or directory
+  ConverterFromLLH from_llh;
+};
+
+// Exact latitude and longitude of a point, computed once for all the outputs that need them
+struct PointLLH
+{
+  int state = 0;  // 0: not computed yet, 1: computed, -1: the point cannot be converted
+  double lat = 0.0, lon = 0.0;
+};
+
+// Convert a point to an output. Only the coordinates are replaced, so that the intensity is kept.
+// The origin is subtracted in double precision, before the coordinates are rounded to floats
+void convert_point(
+  const pcl::PointXYZI & input, const ConversionGrid & grid, const ConverterToLLH & to_llh,
+  const ConverterFromLLH & from_llh, const std::pair<double, double> & origin, PointLLH & llh,
+  pcl::PointXYZI & output)
+{
+  double x, y;
+
+  if (!grid.convert(input.x, input.y, x, y)) {
+    if (llh.state == 0) {
+      llh.state = to_llh.convert(input.x, input.y, llh.lat, llh.lon) ? 1 : -1;
+    }
+
+    if (llh.state < 0 || !from_llh.convert(llh.lat, llh.lon, x, y)) {
+      const auto converted = from_llh.convert(to_llh.convert(input));
+
+      output.x = converted.x;
+      output.y = converted.y;
+      output.z = converted.z;
+
+      return;
+    }
+  }
+
+  output.x = x - origin.first;
+  output.y = y - origin.second;
+}
+
+// Call func(begin, end) for the chunks of the points on the scheduler of the process, which the
+// divider shares
+void for_each_point_chunk(size_t n_points, const std::function<void(size_t, size_t)> & func)
+{
+  constexpr size_t chunk_size = 4096;
+
+  autoware::task_scheduler::TaskScheduler::global().parallel_for(
+    (n_points + chunk_size - 1) / chunk_size,
+    [&](size_t c) { func(c * chunk_size, std::min(n_points, (c + 1) * chunk_size)); });
+}
+
+// Convert the points in place
+void convert_points(
+  PclCloudType & cloud, const ConversionGrid & grid, const ConverterToLLH & to_llh,
+  const ConverterFromLLH & from_llh,
+  const std::pair<double, double> & origin = std::pair<double, double>(0.0, 0.0))
+{
+  for_each_point_chunk(cloud.points.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      PointLLH llh;
+
+      convert_point(cloud.points[i], grid, to_llh, from_llh, origin, llh, cloud.points[i]);
+    }
+  });
+}
+
+// Convert the points to several outputs at once, each through its own grid. The latitude and the
+// longitude of a point are computed at most once, for the outputs whose grids do not cover it
+void convert_points(
+  const PclCloudType & cloud, const std::vector<ConversionGrid> & grids,
+  const ConverterToLLH & to_llh, const std::vector<Target> & targets,
+  const std::vector<std::pair<double, double>> & origins, std::vector<PclCloudType> & outputs)
+{
+  outputs.resize(targets.size());
+
+  for (auto & output : outputs) {
+    output = cloud;
+  }
+
+  for_each_point_chunk(cloud.points.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      PointLLH llh;
+
+      for (size_t t = 0; t < targets.size(); ++t) {
+        convert_point(
+          cloud.points[i], grids[t], to_llh, targets[t].from_llh, origins[t], llh,
+          outputs[t].points[i]);
+      }
+    }
+  });
+}
+
+// Bounds of the points of the files, read block by block
+Bounds read_bounds(const std::vector<std::string> & pcd_paths)
+{
+  Bounds bounds;
+
+  for (const auto & path : pcd_paths) {
+    autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZI> reader;
+
+    reader.setBlockSize(block_size);
+    reader.setInput(path);
+
+    do {
+      PclCloudType block;
+
+      reader.readABlock(block);
+      bounds.add(block);
+    } while (reader.good());
+  }
+
+  return bounds;
+}
+
+// Convert a file block by block to the outputs, so that the whole map is never in memory. The
+// input is read once for all the outputs
+void convert_file_streaming(
+  const std::string & input_path, const std::vector<Target> & targets,
+  const ConverterToLLH & to_llh, bool use_local_origin)
+{
+  const auto bounds = read_bounds({input_path});
+  std::vector<ConversionGrid> grids;
+  std::vector<std::pair<double, double>> origins;
+  autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZI> reader;
+  std::vector<autoware::pointcloud_divider::CustomPCDWriter<pcl::PointXYZI>> writers(
+    targets.size());
+  size_t point_num = 0;
+
+  for (const auto & target : targets) {
+    grids.push_back(make_grid(to_llh, target.from_llh, bounds));
+    origins.push_back(
+      use_local_origin ? local_origin(to_llh, target.from_llh, bounds)
+                       : std::pair<double, double>(0.0, 0.0));
+  }
+
+  reader.setBlockSize(block_size);
+  reader.setInput(input_path);
+
+  // The number of points is updated at the end, in case the input has fewer than its header says
+  for (size_t t = 0; t < targets.size(); ++t) {
+    writers[t].setResizableMetadata(true);
+    writers[t].setOutput(targets[t].path);
+    writers[t].setBlockSize(block_size);
+    writers[t].writeMetadata(reader.point_num(), true);
+  }
+
+  do {
+    PclCloudType block;
+    std::vector<PclCloudType> converted_blocks;
+
+    reader.readABlock(block);
+    convert_points(block, grids, to_llh, targets, origins, converted_blocks);
+
+    for (size_t t = 0; t < targets.size(); ++t) {
+      writers[t].write(converted_blocks[t]);
+    }
+
+    point_num += block.size();
+  } while (reader.good());
+
+  for (size_t t = 0; t < targets.size(); ++t) {
+    writers[t].updateMetadata(point_num);
+
+    if (!writers[t].good()) {
+      std::cerr << "Couldn't write file " << targets[t].path << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+
+    writers[t].close();
+
+    if (use_local_origin) {
+      save_origin(targets[t].path, origins[t]);
+    }
+  }
+}
+
+// Tiles of a divided map, i.e. an output of the divider or a directory of tiles
+struct TileSet
+{
+  std::vector<std::string> paths;
+  std::string prefix = "pointcloud_map";
+  double x_resolution = 20.0, y_resolution = 20.0;
+  Bounds bounds;
+};
+
+TileSet find_tiles(const std::string & input_dir)
+{
+  std::string tile_dir = input_dir;
+  std::string metadata_path = input_dir + "/pointcloud_map_metadata.yaml";
+
+  if (fs::is_directory(input_dir + "/pointcloud_map.pcd")) {
+    tile_dir = input_dir + "/pointcloud_map.pcd";
+  }
+
+  if (!fs::exists(metadata_path)) {
+    metadata_path = tile_dir + "/pointcloud_map_metadata.yaml";
+  }
+
+  TileSet tiles;
+
+  if (fs::exists(metadata_path)) {
+    // The tiles and their bounds are known from the metadata without reading them
+    YAML::Node metadata = YAML::LoadFile(metadata_path);
+
+    tiles.x_resolution = metadata["x_resolution"].as<double>();
+    tiles.y_resolution = metadata["y_resolution"].as<double>();
+
+    for (const auto & entry : metadata) {
+      const auto key = entry.first.as<std::string>();
+
+      if (key == "x_resolution" || key == "y_resolution") {
+        continue;
+      }
+
+      const double x = entry.second[0].as<double>();
+      const double y = entry.second[1].as<double>();
+
+      tiles.paths.push_back(tile_dir + "/" + key);
+      tiles.bounds.add(x, y);
+      tiles.bounds.add(x + tiles.x_resolution, y + tiles.y_resolution);
+    }
+
+    // The names of the tiles are <prefix>_<x>_<y>.pcd
+    if (!tiles.paths.empty()) {
+      std::string name = fs::path(tiles.paths.front()).stem().string();
+      auto pos = name.rfind('_');
+
+      pos = (pos == std::string::npos || pos == 0) ? pos : name.rfind('_', pos - 1);
+
+      if (pos != std::string::npos && pos > 0) {
+        tiles.prefix = name.substr(0, pos);
+      }
+    }
+  } else {
+    for (const auto & entry : fs::directory_iterator(tile_dir)) {
+      if (entry.path().extension() == ".pcd") {
+        tiles.paths.push_back(entry.path().string());
+      }
+    }
+
+    tiles.bounds = read_bounds(tiles.paths);
+  }
+
+  std::sort(tiles.paths.begin(), tiles.paths.end());
+
+  if (tiles.paths.empty()) {
+    std::cerr << "No PCD files found in " << input_dir << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  return tiles;
+}
+
+// Divide the points of the files into tiles of the size of the input tiles, transformed by
+// point_transform if it is given
+void divide_tiles(
+  const std::vector<std::string> & pcd_paths, const std::string & output_dir,
+  const TileSet & tiles, const std::function<void(PclCloudType &)> & point_transform)
+{
+  autoware::pointcloud_divider::PCDDivider<pcl::PointXYZI> divider(
+    rclcpp::get_logger("pointcloud_projection_converter"));
+
+  // The next block is read and converted while the current one is divided
+  divider.setOutputDir(output_dir);
+  divider.setPrefix(tiles.prefix);
+  divider.setGridSize(tiles.x_resolution, tiles.y_resolution);
+  divider.setLeafSize(-1.0);
+  divider.setThreadNum(static_cast<int>(autoware::task_scheduler::thread_budget()));
+  divider.setAsyncIO(true);
+  divider.setDebugMode(false);
+
+  if (point_transform) {
+    divider.setPointTransform(point_transform);
+  }
+
+  divider.run(pcd_paths);
+}
+
+// Convert the tiles of a divided map to the outputs. The converted points are divided again into
+// tiles of the same size, as the tiles of the input are not aligned with the grid of the new
+// projection. With several outputs, the tiles are read and converted to all of them in one pass,
+// to a PCD per output next to its directory, and the PCDs are divided one by one
+void convert_tiles(
+  const std::string & input_dir, const std::vector<Target> & targets,
+  const ConverterToLLH & to_llh)
+{
+  // The divider clears its output directory first
+  for (const auto & target : targets) {
+    std::error_code ec;
+
+    if (fs::exists(target.path) && fs::equivalent(input_dir, target.path, ec)) {
+      std::cerr << "The output directory must differ from the input directory" << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  const auto tiles = find_tiles(input_dir);
+  std::vector<ConversionGrid> grids;
+
+  for (const auto & target : targets) {
+    grids.push_back(make_grid(to_llh, target.from_llh, tiles.bounds));
+  }
+
+  if (targets.size() == 1) {
+    const auto & grid = grids.front();
+    const auto & from_llh = targets.front().from_llh;
+
+    divide_tiles(tiles.paths, targets.front().path, tiles, [&](PclCloudType & block) {
+      convert_points(block, grid, to_llh, from_llh);
+    });
+
+    return;
+  }
+
+  const std::vector<std::pair<double, double>> origins(targets.size());
+  std::vector<std::string> converted_paths;
+  std::vector<autoware::pointcloud_divider::CustomPCDWriter<pcl::PointXYZI>> writers(
+    targets.size());
+  size_t point_num = 0;
+
+  for (size_t t = 0; t < targets.size(); ++t) {
+    fs::path output_dir(targets[t].path);
+
+    if (output_dir.filename().empty()) {
+      output_dir = output_dir.parent_path();
+    }
+
+    converted_paths.push_back(output_dir.string() + ".converted.pcd");
+    writers[t].setResizableMetadata(true);
+    writers[t].setOutput(converted_paths[t]);
+    writers[t].setBlockSize(block_size);
+    writers[t].writeMetadata(0, true);
+  }
+
+  for (const auto & tile_path : tiles.paths) {
+    autoware::pointcloud_divider::CustomPCDReader<pcl::PointXYZI> reader;
+
+    reader.setBlockSize(block_size);
+    reader.setInput(tile_path);
+
+    do {
+      PclCloudType block;
+      std::vector<PclCloudType> converted_blocks;
+
+      reader.readABlock(block);
+      convert_points(block, grids, to_llh, targets, origins, converted_blocks);
+
+      for (size_t t = 0; t < targets.size(); ++t) {
+        writers[t].write(converted_blocks[t]);
+      }
+
+      point_num += block.size();
+    } while (reader.good());
+  }
+
+  for (size_t t = 0; t < targets.size(); ++t) {
+    writers[t].updateMetadata(point_num);
+
+    if (!writers[t].good()) {
+      std::cerr << "Couldn't write file " << converted_paths[t] << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+
+    writers[t].close();
+  }
+
+  std::cout << "Converted " << point_num << " points to " << targets.size() << " projections"
+            << std::endl;
+
+  for (size_t t = 0; t < targets.size(); ++t) {
+    divide_tiles({converted_paths[t]}, targets[t].path, tiles, nullptr);
+    fs::remove(converted_paths[t]);
+  }
+}
+
+}  // namespace autoware::pointcloud_projection_converter
 
 int main(int argc, char ** argv)
 {
   if (argc < 5) {
     std::cerr << "Usage: ros2 run autoware_pointcloud_projection_converter "
-                 "pointcloud_projection_converter input_pcd output_pcd "
-                 "input_yaml output_yaml"
+                 "pointcloud_projection_converter input_pcd_or_dir output_pcd_or_dir "
+                 "input_yaml output_yaml [--output output_pcd_or_dir output_yaml]... [--streaming] "
+                 "[--local-origin]"
               << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
-  // Load point cloud data from file
-  pcl::PointCloud<pcl::PointXYZI>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZI>);
-  if (pcl::io::loadPCDFile<pcl::PointXYZI>(argv[1], *cloud) == -1) {
-    std::cerr << "Couldn't read file " << argv[1] << std::endl;
-    std::exit(EXIT_FAILURE);
+  namespace converter = autoware::pointcloud_projection_converter;
+
+  // The divider stops when rclcpp is not running
+  rclcpp::init(argc, argv);
+
+  const std::string input_path = argv[1];
+  bool use_streaming = false;
+  bool use_local_origin = false;
+  std::vector<std::pair<std::string, std::string>> outputs = {{argv[2], argv[4]}};
+
+  for (int i = 5; i < argc; ++i) {
+    const std::string option = argv[i];
+
+    if (option == "--streaming") {
+      use_streaming = true;
+    } else if (option == "--local-origin") {
+      use_local_origin = true;
+    } else if (option == "--output" && i + 2 < argc) {
+      outputs.emplace_back(argv[i + 1], argv[i + 2]);
+      i += 2;
+    } else if (option.rfind("--ros-args", 0) == 0) {
+      break;
+    } else {
+      std::cerr << "Unknown option " << option << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
   }
 
-  // Parse YAML configuration files
+  // Parse YAML configuration files, and define converters
   YAML::Node input_config = YAML::LoadFile(argv[3]);
-  YAML::Node output_config = YAML::LoadFile(argv[4]);
+  converter::ConverterToLLH to_llh(input_config);
+  std::vector<converter::Target> targets;
 
-  // Define converters
-  autoware::pointcloud_projection_converter::ConverterToLLH to_llh(input_config);
-  autoware::pointcloud_projection_converter::ConverterFromLLH from_llh(output_config);
+  for (const auto & output : outputs) {
+    targets.push_back(
+      converter::Target{output.first, converter::ConverterFromLLH(YAML::LoadFile(output.second))});
+  }
 
-  // Convert points
-  const size_t n_points = cloud->points.size();
+  if (fs::is_directory(input_path)) {
+    // The tiles of a divided map keep the coordinates of the projection, as map loaders expect
+    if (use_local_origin) {
+      std::cerr << "--local-origin is ignored for divided maps" << std::endl;
+    }
 
-#pragma omp parallel for
-  for (size_t i = 0; i < n_points; ++i) {
-    auto & point = cloud->points[i];
-    autoware::pointcloud_projection_converter::LatLonAlt llh = to_llh.convert(point);
-    point = from_llh.convert(llh);
-  }
+    converter::convert_tiles(input_path, targets, to_llh);
+  } else if (use_streaming) {
+    converter::convert_file_streaming(input_path, targets, to_llh, use_local_origin);
+  } else {
+    // Load point cloud data from file
+    converter::PclCloudType::Ptr cloud(new converter::PclCloudType);
+    if (pcl::io::loadPCDFile<pcl::PointXYZI>(input_path, *cloud) == -1) {
+      std::cerr << "Couldn't read file " << input_path << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+
+    converter::Bounds bounds;
+
+    bounds.add(*cloud);
+
+    // Convert points to all the outputs at once
+    std::vector<converter::ConversionGrid> grids;
+    std::vector<std::pair<double, double>> origins;
+    std::vector<converter::PclCloudType> converted_clouds;
 
-  // Save converted point cloud to file
-  pcl::io::savePCDFileBinary(argv[2], *cloud);
+    for (const auto & target : targets) {
+      grids.push_back(converter::make_grid(to_llh, target.from_llh, bounds));
+      origins.push_back(
+        use_local_origin ? converter::local_origin(to_llh, target.from_llh, bounds)
+                         : std::pair<double, double>(0.0, 0.0));
+    }
+
+    // A single output is converted in place, without a copy of the map
+    if (targets.size() == 1) {
+      converter::convert_points(*cloud, grids[0], to_llh, targets[0].from_llh, origins[0]);
+      converted_clouds.push_back(std::move(*cloud));
+    } else {
+      converter::convert_points(*cloud, grids, to_llh, targets, origins, converted_clouds);
+    }
+
+    // Save converted point clouds to files
+    for (size_t t = 0; t < targets.size(); ++t) {
+      pcl::io::savePCDFileBinary(targets[t].path, converted_clouds[t]);
+
+      if (use_local_origin) {
+        converter::save_origin(targets[t].path, origins[t]);
+      }
+    }
+  }
 
   std::cout << "Point cloud projection conversion completed successfully" << std::endl;
 
+  rclcpp::shutdown();
+
   return 0;
 }
@@ -0,0 +1,292 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bag_cache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+constexpr char cache_magic[8] = "BACACHE";
+constexpr uint32_t cache_version = 1;
+
+// Everything in the image is aligned to 8 bytes
+size_t aligned(const size_t size)
+{
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+template <class T>
+void put(std::vector<uint8_t> & image, const T & value)
+{
+  const auto * bytes = reinterpret_cast<const uint8_t *>(&value);
+  image.insert(image.end(), bytes, bytes + sizeof(T));
+}
+
+void put_bytes(std::vector<uint8_t> & image, const uint8_t * data, const size_t size)
+{
+  image.insert(image.end(), data, data + size);
+  image.resize(aligned(image.size()), 0);
+}
+
+template <class T>
+bool get(const uint8_t * image, const size_t size, size_t & offset, T & value)
+{
+  if (offset + sizeof(T) > size) return false;
+  std::memcpy(&value, image + offset, sizeof(T));
+  offset += sizeof(T);
+  return true;
+}
+
+// FNV-1a
+void hash(uint64_t & h, const std::string & value)
+{
+  for (const auto c : value) {
+    h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+  }
+  h = (h ^ 0xFF) * 1099511628211ULL;
+}
+}  // namespace
+
+BagCache::BagCache(
+  rosbag2_cpp::Reader & reader, const std::vector<std::string> & topics,
+  const std::string & directory)
+: topics_{topics}
+{
+  const auto path = directory.empty()
+                      ? std::string{}
+                      : directory + "/" + key(reader.get_metadata(), topics) + ".cache";
+
+  if (!path.empty() && map(path)) {
+    return;
+  }
+
+  build(reader);
+
+  if (!parse(image_.data(), image_.size())) {
+    throw std::logic_error("failed to build bag cache.");
+  }
+
+  if (path.empty()) {
+    return;
+  }
+
+  // Written to a temporary file first, so that an interrupted run does not leave a broken cache
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+
+  const auto tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(image_.data()), image_.size());
+    if (!file.good()) {
+      std::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp_path, path, ec);
+}
+
+BagCache::~BagCache()
+{
+  if (map_ != nullptr) {
+    munmap(map_, map_size_);
+  }
+}
+
+auto BagCache::key(
+  const rosbag2_storage::BagMetadata & metadata, const std::vector<std::string> & topics)
+  -> std::string
+{
+  uint64_t h = 14695981039346656037ULL;
+
+  hash(h, std::to_string(cache_version));
+  for (const auto & file : metadata.relative_file_paths) {
+    hash(h, file);
+  }
+  hash(h, std::to_string(metadata.starting_time.time_since_epoch().count()));
+  hash(h, std::to_string(metadata.duration.count()));
+  hash(h, std::to_string(metadata.message_count));
+  for (const auto & topic : metadata.topics_with_message_count) {
+    hash(h, topic.topic_metadata.name);
+    hash(h, std::to_string(topic.message_count));
+  }
+  for (const auto & topic : topics) {
+    hash(h, topic);
+  }
+
+  std::ostringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << h;
+  return ss.str();
+}
+
+auto BagCache::read_next() -> std::shared_ptr<rosbag2_storage::SerializedBagMessage>
+{
+  const auto & record = records_.at(next_++);
+
+  auto serialized_data =
+    std::make_shared<rcutils_uint8_array_t>(rcutils_get_zero_initialized_uint8_array());
+  serialized_data->buffer = const_cast<uint8_t *>(record.data);
+  serialized_data->buffer_length = record.size;
+  serialized_data->buffer_capacity = record.size;
+
+  auto message = std::make_shared<rosbag2_storage::SerializedBagMessage>();
+  message->topic_name = topics_.at(record.topic);
+  message->serialized_data = serialized_data;
+
+  return message;
+}
+
+bool BagCache::map(const std::string & path)
+{
+  const auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+
+  auto * map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (map == MAP_FAILED) {
+    return false;
+  }
+
+  if (!parse(static_cast<const uint8_t *>(map), st.st_size)) {
+    munmap(map, st.st_size);
+    return false;
+  }
+
+  map_ = map;
+  map_size_ = st.st_size;
+
+  return true;
+}
+
+void BagCache::build(rosbag2_cpp::Reader & reader)
+{
+  std::unordered_map<std::string, uint32_t> topic_ids;
+  for (size_t i = 0; i < topics_.size(); i++) {
+    topic_ids.emplace(topics_.at(i), i);
+  }
+
+  std::vector<uint8_t> records;
+  uint64_t record_num = 0;
+
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = topics_;
+  reader.set_filter(filter);
+  reader.seek(0);
+
+  while (reader.has_next()) {
+    const auto next_data = reader.read_next();
+    const auto itr = topic_ids.find(next_data->topic_name);
+    if (itr == topic_ids.end()) {
+      continue;
+    }
+
+    const auto & serialized_data = *next_data->serialized_data;
+    put(records, itr->second);
+    put(records, static_cast<uint32_t>(0));
+    put(records, static_cast<uint64_t>(serialized_data.buffer_length));
+    put_bytes(records, serialized_data.buffer, serialized_data.buffer_length);
+    record_num++;
+  }
+
+  reader.seek(0);
+
+  image_.clear();
+  image_.insert(image_.end(), cache_magic, cache_magic + sizeof(cache_magic));
+  put(image_, cache_version);
+  put(image_, static_cast<uint32_t>(topics_.size()));
+  put(image_, record_num);
+  for (const auto & topic : topics_) {
+    put(image_, static_cast<uint32_t>(topic.size()));
+    put_bytes(image_, reinterpret_cast<const uint8_t *>(topic.data()), topic.size());
+  }
+  image_.insert(image_.end(), records.begin(), records.end());
+}
+
+bool BagCache::parse(const uint8_t * image, const size_t size)
+{
+  size_t offset = 0;
+  uint32_t version = 0;
+  uint32_t topic_num = 0;
+  uint64_t record_num = 0;
+
+  if (size < sizeof(cache_magic) || std::memcmp(image, cache_magic, sizeof(cache_magic)) != 0) {
+    return false;
+  }
+  offset += sizeof(cache_magic);
+
+  if (
+    !get(image, size, offset, version) || version != cache_version ||
+    !get(image, size, offset, topic_num) || !get(image, size, offset, record_num)) {
+    return false;
+  }
+
+  std::vector<std::string> topics;
+  for (uint32_t i = 0; i < topic_num; i++) {
+    uint32_t length = 0;
+    if (!get(image, size, offset, length) || offset + length > size) {
+      return false;
+    }
+    topics.emplace_back(reinterpret_cast<const char *>(image + offset), length);
+    offset = aligned(offset + length);
+  }
+
+  std::vector<Record> records;
+  records.reserve(record_num);
+  for (uint64_t i = 0; i < record_num; i++) {
+    uint32_t topic = 0;
+    uint32_t reserved = 0;
+    uint64_t data_size = 0;
+    if (
+      !get(image, size, offset, topic) || !get(image, size, offset, reserved) ||
+      !get(image, size, offset, data_size) || topic >= topic_num || offset + data_size > size) {
+      return false;
+    }
+    records.push_back(Record{topic, image + offset, data_size});
+    offset = aligned(offset + data_size);
+  }
+
+  topics_ = topics;
+  records_ = records;
+  next_ = 0;
+
+  return true;
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,88 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BAG_CACHE_HPP_
+#define BAG_CACHE_HPP_
+
+#include "rosbag2_cpp/reader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// The serialized messages of some topics of a bag, read once so that rewinds and grid search
+// passes do not read the bag again. The messages are kept in one image, which is also written to
+// <directory>/<key>.cache and memory-mapped by later runs on the same bag
+class BagCache
+{
+public:
+  // An empty directory keeps the image in memory only
+  BagCache(
+    rosbag2_cpp::Reader & reader, const std::vector<std::string> & topics,
+    const std::string & directory);
+
+  ~BagCache();
+
+  BagCache(const BagCache &) = delete;
+  BagCache & operator=(const BagCache &) = delete;
+
+  // A key of the bag and the topics, computed from the metadata without reading the messages
+  static auto key(
+    const rosbag2_storage::BagMetadata & metadata, const std::vector<std::string> & topics)
+    -> std::string;
+
+  bool has_next() const { return next_ < records_.size(); }
+
+  // The serialized data of the message refers to the image, so it is valid while the cache is
+  auto read_next() -> std::shared_ptr<rosbag2_storage::SerializedBagMessage>;
+
+  void rewind() { next_ = 0; }
+
+  size_t size() const { return records_.size(); }
+
+  bool mapped() const { return map_ != nullptr; }
+
+private:
+  struct Record
+  {
+    uint32_t topic;
+    const uint8_t * data;
+    size_t size;
+  };
+
+  bool map(const std::string & path);
+
+  void build(rosbag2_cpp::Reader & reader);
+
+  bool parse(const uint8_t * image, const size_t size);
+
+  std::vector<std::string> topics_;
+
+  std::vector<Record> records_;
+
+  std::vector<uint8_t> image_;
+
+  void * map_{nullptr};
+
+  size_t map_size_{0};
+
+  size_t next_{0};
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // BAG_CACHE_HPP_
@@ -0,0 +1,81 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bag_prefetcher.hpp"
+
+#include <autoware/profiling_utils/profiling_utils.hpp>
+
+#include <memory>
+#include <utility>
+
+namespace autoware::behavior_analyzer
+{
+BagPrefetcher::BagPrefetcher(
+  const std::shared_ptr<BagData> & bag_data, std::function<bool()> has_next,
+  std::function<void(const std::shared_ptr<BagData> &)> read, const size_t window_num)
+: queue_(window_num)
+{
+  thread_ = std::thread(
+    [this, bag_data, has_next = std::move(has_next), read = std::move(read)]() {
+      run(bag_data, has_next, read);
+    });
+}
+
+BagPrefetcher::~BagPrefetcher()
+{
+  queue_.close();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto BagPrefetcher::next() -> std::shared_ptr<BagData>
+{
+  auto bag_data = queue_.pop();
+  if (bag_data) {
+    return std::move(bag_data.value());
+  }
+
+  std::lock_guard<std::mutex> lock(error_mutex_);
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+
+  return nullptr;
+}
+
+void BagPrefetcher::run(
+  const std::shared_ptr<BagData> & bag_data, const std::function<bool()> & has_next,
+  const std::function<void(const std::shared_ptr<BagData> &)> & read)
+{
+  try {
+    while (has_next()) {
+      {
+        AUTOWARE_PROFILE_SCOPE("prefetch_window");
+        read(bag_data);
+      }
+
+      if (!bag_data->ready()) break;
+
+      // The push fails once the prefetcher is destroyed
+      if (!queue_.push(bag_data->snapshot())) return;
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    error_ = std::current_exception();
+  }
+
+  queue_.close();
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,68 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BAG_PREFETCHER_HPP_
+#define BAG_PREFETCHER_HPP_
+
+#include "data_structs.hpp"
+
+#include <autoware/task_scheduler/bounded_queue.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace autoware::behavior_analyzer
+{
+// Reads the windows of a bag on a thread of its own, up to window_num windows ahead of the
+// evaluation, so that the bag is read while the previous windows are evaluated. The windows are
+// handed out in time order, and each one is a snapshot that is not modified afterwards
+class BagPrefetcher
+{
+public:
+  // read(bag_data) advances bag_data by one time step. The windows are read as long as has_next()
+  // is true and the buffers of bag_data are ready after a read
+  BagPrefetcher(
+    const std::shared_ptr<BagData> & bag_data, std::function<bool()> has_next,
+    std::function<void(const std::shared_ptr<BagData> &)> read, const size_t window_num);
+
+  // Stops the reader after the window it is reading
+  ~BagPrefetcher();
+
+  BagPrefetcher(const BagPrefetcher &) = delete;
+  BagPrefetcher & operator=(const BagPrefetcher &) = delete;
+
+  // The next window, blocking until it is read, or nullptr once the bag is read through. An
+  // exception thrown by read is rethrown here after the windows read before it
+  auto next() -> std::shared_ptr<BagData>;
+
+private:
+  void run(
+    const std::shared_ptr<BagData> & bag_data, const std::function<bool()> & has_next,
+    const std::function<void(const std::shared_ptr<BagData> &)> & read);
+
+  autoware::task_scheduler::BoundedQueue<std::shared_ptr<BagData>> queue_;
+
+  std::mutex error_mutex_;
+
+  std::exception_ptr error_{nullptr};
+
+  std::thread thread_;
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // BAG_PREFETCHER_HPP_
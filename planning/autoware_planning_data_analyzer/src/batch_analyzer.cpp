@@ -0,0 +1,419 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Evaluate bags without the ROS graph. The bags are processed in parallel as fast as they are
+// read, nothing is published, and the scores, the loss and the metrics of every time step are
+// written to a CSV file. With batch.mode weight_shard, the losses of a slice of the weight grid
+// summed over the bags are written instead, and weight_reduce adds up such shards
+
+#include "bag_cache.hpp"
+#include "data_structs.hpp"
+#include "loader.hpp"
+#include "sampling_cache.hpp"
+#include "type_alias.hpp"
+#include "weight_shard.hpp"
+#include "worker_pool.hpp"
+
+#include <autoware_vehicle_info_utils/vehicle_info_utils.hpp>
+#include <magic_enum.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+// The same metrics and scores as the ones published by BehaviorAnalyzerNode
+const std::vector<METRIC> metric_types{
+  METRIC::LATERAL_ACCEL, METRIC::LONGITUDINAL_JERK, METRIC::TRAVEL_DISTANCE, METRIC::MINIMUM_TTC};
+
+const std::vector<SCORE> score_types{
+  SCORE::LONGITUDINAL_COMFORTABILITY, SCORE::LATERAL_COMFORTABILITY, SCORE::EFFICIENCY,
+  SCORE::SAFETY};
+
+auto header(const Parameters & p) -> std::string
+{
+  std::ostringstream ss;
+
+  ss << "bag,timestamp,source";
+  for (const auto score_type : score_types) {
+    ss << "," << magic_enum::enum_name(score_type);
+  }
+  ss << ",TOTAL,LOSS";
+  for (const auto metric_type : metric_types) {
+    for (size_t i = 0; i < p.resample_num; i++) {
+      ss << "," << magic_enum::enum_name(metric_type) << "_" << i;
+    }
+  }
+  ss << "\n";
+
+  return ss.str();
+}
+
+// The loss is the error of the trajectory against the driver's one, the same as DataSet::loss
+void write_row(
+  std::ostream & os, const std::string & bag_path, const rcutils_time_point_value_t timestamp,
+  const std::string & source, const CommonData & data, const Parameters & p, const double loss)
+{
+  os << bag_path << "," << timestamp << "," << source;
+  for (const auto score_type : score_types) {
+    os << "," << data.scores.at(static_cast<size_t>(score_type));
+  }
+  os << "," << data.total(p.w0, p.w1, p.w2, p.w3) << "," << loss;
+  for (const auto metric_type : metric_types) {
+    const auto & values = data.values.at(static_cast<size_t>(metric_type));
+    for (size_t i = 0; i < p.resample_num; i++) {
+      os << "," << (i < values.size() ? values.at(i) : std::numeric_limits<double>::quiet_NaN());
+    }
+  }
+  os << "\n";
+}
+
+// Rows of the manual driving, the autoware trajectory and the best sampled trajectory of every
+// time step of the bag
+auto process(
+  const std::string & bag_path, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & p, const double dt, const std::string & cache_directory)
+  -> std::string
+{
+  rosbag2_cpp::Reader reader;
+  reader.open(bag_path);
+
+  const auto bag_data = std::make_shared<BagData>(
+    duration_cast<nanoseconds>(reader.get_metadata().starting_time.time_since_epoch()).count());
+
+  // Only the cache file is useful here, since each bag is read once
+  std::unique_ptr<BagCache> cache;
+  if (!cache_directory.empty()) {
+    cache = std::make_unique<BagCache>(reader, analyzed_topics(), cache_directory);
+  }
+
+  const auto has_next = [&]() { return cache ? cache->has_next() : reader.has_next(); };
+
+  std::ostringstream rows;
+  SamplingCache sampling_cache;
+
+  while (has_next() && rclcpp::ok()) {
+    if (cache) {
+      load_messages(*cache, bag_data, dt);
+    } else {
+      load_messages(reader, bag_data, dt);
+    }
+
+    if (!bag_data->ready()) break;
+
+    std::shared_ptr<DataSet> data_set;
+    try {
+      data_set = std::make_shared<DataSet>(bag_data, vehicle_info, p, nullptr, &sampling_cache);
+    } catch (const std::logic_error &) {
+      continue;
+    }
+
+    write_row(rows, bag_path, bag_data->timestamp, "manual", data_set->manual, *p, 0.0);
+
+    const auto & trajectories = data_set->sampling.data;
+    for (size_t i = 0; i < trajectories.size(); i++) {
+      if (trajectories.at(i).tag == "autoware") {
+        write_row(
+          rows, bag_path, bag_data->timestamp, "autoware", trajectories.at(i), *p,
+          data_set->loss_table.trajectory_loss.at(i));
+      }
+    }
+
+    const auto best = data_set->sampling.best_index(p->w0, p->w1, p->w2, p->w3);
+    if (best.has_value()) {
+      auto loss = std::numeric_limits<double>::quiet_NaN();
+      try {
+        loss = data_set->loss(p->w0, p->w1, p->w2, p->w3);
+      } catch (const std::logic_error &) {
+      }
+      write_row(rows, bag_path, bag_data->timestamp, "best", trajectories.at(*best), *p, loss);
+    }
+  }
+
+  return rows.str();
+}
+
+// Losses of the tuples from begin to end of the grid summed over the data sets of the bag, at the
+// same time steps as the weight grid search of BehaviorAnalyzerNode. The k-th sum is the one of
+// the tuple begin + k
+auto shard_losses(
+  const std::string & bag_path, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & p, const std::vector<Result> & grid, const size_t begin,
+  const size_t end, const std::string & cache_directory) -> std::vector<double>
+{
+  rosbag2_cpp::Reader reader;
+  reader.open(bag_path);
+
+  const auto bag_data = std::make_shared<BagData>(
+    duration_cast<nanoseconds>(reader.get_metadata().starting_time.time_since_epoch()).count());
+
+  std::unique_ptr<BagCache> cache;
+  if (!cache_directory.empty()) {
+    cache = std::make_unique<BagCache>(reader, analyzed_topics(), cache_directory);
+  }
+
+  const auto has_next = [&]() { return cache ? cache->has_next() : reader.has_next(); };
+
+  std::vector<double> sums(end - begin, 0.0);
+  std::vector<double> losses(grid.size(), 0.0);
+  SamplingCache sampling_cache;
+
+  while (has_next() && rclcpp::ok()) {
+    if (cache) {
+      load_messages(*cache, bag_data, p->grid_search.dt);
+    } else {
+      load_messages(reader, bag_data, p->grid_search.dt);
+    }
+
+    if (!bag_data->ready()) break;
+
+    // The time steps without enough data do not depend on the weights, so they are skipped in
+    // every shard alike
+    std::shared_ptr<DataSet> data_set;
+    try {
+      data_set = std::make_shared<DataSet>(bag_data, vehicle_info, p, nullptr, &sampling_cache);
+    } catch (const std::logic_error &) {
+      continue;
+    }
+
+    data_set->loss(grid, begin, end, losses);
+    for (size_t k = begin; k < end; k++) {
+      sums.at(k - begin) += losses.at(k);
+    }
+  }
+
+  return sums;
+}
+
+// Tuples sorted by loss, the same format as the weight grid search of BehaviorAnalyzerNode
+void show_ranking(const WeightShard & shard, const size_t top_k)
+{
+  std::vector<Result> ranking;
+  ranking.reserve(shard.results.size());
+  for (const auto & result : shard.results) {
+    ranking.push_back(result.second);
+  }
+  std::stable_sort(ranking.begin(), ranking.end(), [](const auto & a, const auto & b) {
+    return a.loss < b.loss;
+  });
+
+  std::cout << std::fixed;
+  std::cout << std::setprecision(4);
+  for (size_t i = 0; i < std::min(top_k, ranking.size()); i++) {
+    const auto & r = ranking.at(i);
+    std::cout << " [w0]:" << r.w0 << " [w1]:" << r.w1 << " [w2]:" << r.w2 << " [w3]:" << r.w3
+              << " [loss]:" << r.loss << std::endl;
+  }
+}
+auto run_evaluate(rclcpp::Node & node) -> int
+{
+  const auto bag_paths = node.declare_parameter<std::vector<std::string>>("bag_paths");
+  const auto output_path = node.declare_parameter<std::string>("output_path");
+  const auto dt = node.declare_parameter<double>("batch.dt");
+  const auto thread_num = node.declare_parameter<int>("batch.thread_num");
+  const auto cache_directory = node.declare_parameter<bool>("bag_cache.enable")
+                                 ? node.declare_parameter<std::string>("bag_cache.directory")
+                                 : std::string{};
+
+  const auto vehicle_info = autoware::vehicle_info_utils::VehicleInfoUtils(node).getVehicleInfo();
+  const auto parameters = load_parameters(node);
+
+  std::ofstream output(output_path);
+  if (!output.is_open()) {
+    RCLCPP_ERROR(node.get_logger(), "failed to open %s.", output_path.c_str());
+    return EXIT_FAILURE;
+  }
+
+  // Each bag is processed by one thread, and the rows are written in the order of the bags
+  std::vector<std::string> rows(bag_paths.size());
+  std::vector<std::string> errors(bag_paths.size());
+
+  WorkerPool pool(thread_num);
+  pool.run(bag_paths.size(), [&](const size_t idx) {
+    try {
+      rows.at(idx) = process(bag_paths.at(idx), vehicle_info, parameters, dt, cache_directory);
+    } catch (const std::exception & e) {
+      errors.at(idx) = e.what();
+    }
+  });
+
+  output << header(*parameters);
+
+  size_t failed_num = 0;
+  for (size_t idx = 0; idx < bag_paths.size(); idx++) {
+    if (!errors.at(idx).empty()) {
+      RCLCPP_ERROR(
+        node.get_logger(), "failed to process %s: %s", bag_paths.at(idx).c_str(),
+        errors.at(idx).c_str());
+      failed_num++;
+      continue;
+    }
+    output << rows.at(idx);
+  }
+
+  RCLCPP_INFO(
+    node.get_logger(), "processed %zu bags (%zu failed), wrote %s.", bag_paths.size(), failed_num,
+    output_path.c_str());
+
+  return failed_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// The shard has the bags that are processed without errors, so that it is still reduced exactly
+auto run_weight_shard(rclcpp::Node & node) -> int
+{
+  const auto bag_paths = node.declare_parameter<std::vector<std::string>>("bag_paths");
+  const auto output_path = node.declare_parameter<std::string>("output_path");
+  const auto thread_num = node.declare_parameter<int>("batch.thread_num");
+  const auto shard_index = node.declare_parameter<int>("weight_shard.index");
+  const auto shard_count = node.declare_parameter<int>("weight_shard.count");
+  const auto cache_directory = node.declare_parameter<bool>("bag_cache.enable")
+                                 ? node.declare_parameter<std::string>("bag_cache.directory")
+                                 : std::string{};
+
+  const auto vehicle_info = autoware::vehicle_info_utils::VehicleInfoUtils(node).getVehicleInfo();
+  const auto parameters = load_parameters(node);
+
+  if (shard_index < 0 || shard_count <= shard_index) {
+    RCLCPP_ERROR(node.get_logger(), "weight_shard.index must be in [0, weight_shard.count).");
+    return EXIT_FAILURE;
+  }
+
+  const auto grid = weight_grid(parameters->grid_search);
+  const auto range = shard_range(grid.size(), shard_index, shard_count);
+  const auto begin = range.first;
+  const auto end = range.second;
+
+  std::vector<std::vector<double>> sums(bag_paths.size());
+  std::vector<std::string> errors(bag_paths.size());
+
+  WorkerPool pool(thread_num);
+  pool.run(bag_paths.size(), [&](const size_t idx) {
+    try {
+      sums.at(idx) = shard_losses(
+        bag_paths.at(idx), vehicle_info, parameters, grid, begin, end, cache_directory);
+    } catch (const std::exception & e) {
+      errors.at(idx) = e.what();
+    }
+  });
+
+  WeightShard shard;
+  shard.min = parameters->grid_search.min;
+  shard.max = parameters->grid_search.max;
+  shard.resolution = parameters->grid_search.resolution;
+  shard.tuple_num = grid.size();
+  for (size_t k = begin; k < end; k++) {
+    shard.results.emplace_back(k, grid.at(k));
+  }
+
+  // The sums are added in the order of the bags, so the shard does not depend on the threads
+  size_t failed_num = 0;
+  for (size_t idx = 0; idx < bag_paths.size(); idx++) {
+    if (!errors.at(idx).empty()) {
+      RCLCPP_ERROR(
+        node.get_logger(), "failed to process %s: %s", bag_paths.at(idx).c_str(),
+        errors.at(idx).c_str());
+      failed_num++;
+      continue;
+    }
+    shard.bags.push_back(bag_paths.at(idx));
+    for (size_t k = 0; k < shard.results.size(); k++) {
+      shard.results.at(k).second.loss += sums.at(idx).at(k);
+    }
+  }
+
+  try {
+    write_weight_shard(output_path, shard);
+  } catch (const std::runtime_error & e) {
+    RCLCPP_ERROR(node.get_logger(), "%s", e.what());
+    return EXIT_FAILURE;
+  }
+
+  RCLCPP_INFO(
+    node.get_logger(), "evaluated tuples [%zu, %zu) of %zu on %zu bags (%zu failed), wrote %s.",
+    begin, end, grid.size(), bag_paths.size(), failed_num, output_path.c_str());
+
+  return failed_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+auto run_weight_reduce(rclcpp::Node & node) -> int
+{
+  const auto shard_paths = node.declare_parameter<std::vector<std::string>>("shard_paths");
+  const auto output_path = node.declare_parameter<std::string>("output_path");
+  const auto top_k = node.declare_parameter<int>("grid_search.top_k");
+
+  WeightShard reduced;
+  try {
+    std::vector<WeightShard> shards;
+    for (const auto & shard_path : shard_paths) {
+      shards.push_back(read_weight_shard(shard_path));
+    }
+    reduced = reduce_weight_shards(shards);
+    write_weight_shard(output_path, reduced);
+  } catch (const std::runtime_error & e) {
+    RCLCPP_ERROR(node.get_logger(), "%s", e.what());
+    return EXIT_FAILURE;
+  }
+
+  if (reduced.results.size() < reduced.tuple_num) {
+    RCLCPP_WARN(
+      node.get_logger(), "the shards have %zu of the %zu tuples of the grid.",
+      reduced.results.size(), reduced.tuple_num);
+  }
+
+  show_ranking(reduced, std::max(top_k, 1));
+
+  RCLCPP_INFO(
+    node.get_logger(), "reduced %zu shards of %zu bags, wrote %s.", shard_paths.size(),
+    reduced.bags.size(), output_path.c_str());
+
+  return EXIT_SUCCESS;
+}
+}  // namespace
+}  // namespace autoware::behavior_analyzer
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+
+  const auto node = std::make_shared<rclcpp::Node>("behavior_analyzer_batch");
+
+  const auto mode = node->declare_parameter<std::string>("batch.mode");
+
+  auto ret = EXIT_FAILURE;
+  if (mode == "evaluate") {
+    ret = autoware::behavior_analyzer::run_evaluate(*node);
+  } else if (mode == "weight_shard") {
+    ret = autoware::behavior_analyzer::run_weight_shard(*node);
+  } else if (mode == "weight_reduce") {
+    ret = autoware::behavior_analyzer::run_weight_reduce(*node);
+  } else {
+    RCLCPP_ERROR(node->get_logger(), "unknown batch.mode %s.", mode.c_str());
+  }
+
+  rclcpp::shutdown();
+
+  return ret;
+}
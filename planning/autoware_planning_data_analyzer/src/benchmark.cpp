@@ -0,0 +1,277 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measure the cost of the analyzer without a bag. The messages of a drive on a straight road among
+// moving objects are synthesized into a BagData, and the evaluation of a time step and its parts
+// are repeated on it. Each phase reports the mean time per call.
+
+#include "data_structs.hpp"
+#include "sampling_cache.hpp"
+#include "type_alias.hpp"
+#include "utils.hpp"
+#include "weight_shard.hpp"
+#include "worker_pool.hpp"
+
+#include <autoware_vehicle_info_utils/vehicle_info_utils.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+constexpr double ego_speed = 10.0;
+constexpr double message_rate = 10.0;
+
+// Centered values of a target state dimension of the sampling lattice
+auto linspace(const size_t num, const double half_width) -> std::vector<double>
+{
+  if (num < 2) return {0.0};
+
+  std::vector<double> values;
+  for (size_t i = 0; i < num; i++) {
+    values.push_back(-half_width + 2.0 * half_width * i / (num - 1));
+  }
+  return values;
+}
+
+template <typename T>
+void append(const std::shared_ptr<BagData> & bag_data, const std::string & topic, const T & msg)
+{
+  std::dynamic_pointer_cast<Buffer<T>>(bag_data->buffers.at(topic))
+    ->append(std::make_shared<const T>(msg));
+  if constexpr (std::is_same_v<T, TFMessage>) {
+    bag_data->transforms.append(msg);
+  }
+}
+
+// Messages of duration [s] from the timestamp of bag_data. The ego drives along x at a constant
+// speed, the planning trajectory has trajectory_length points every meter ahead of it, and the
+// objects keep their random velocities from random positions around the road
+void synthesize(
+  const std::shared_ptr<BagData> & bag_data, const size_t object_num,
+  const size_t trajectory_length, const double duration, const unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> along(-50.0, 50.0 + ego_speed * duration);
+  std::uniform_real_distribution<double> across(-10.0, 10.0);
+  std::uniform_real_distribution<double> speed(-5.0, 15.0);
+
+  std::vector<std::array<double, 3>> objects(object_num);
+  for (auto & object : objects) {
+    object = {along(rng), across(rng), speed(rng)};
+  }
+
+  const auto step_num = static_cast<size_t>(duration * message_rate);
+  for (size_t i = 0; i <= step_num; i++) {
+    const auto t = static_cast<double>(i) / message_rate;
+    const auto stamp = rclcpp::Time(bag_data->timestamp + static_cast<int64_t>(t * 1e9));
+    const auto x = ego_speed * t;
+
+    Odometry odometry;
+    odometry.header.stamp = stamp;
+    odometry.header.frame_id = "map";
+    odometry.pose.pose.position.x = x;
+    odometry.pose.pose.orientation.w = 1.0;
+    odometry.twist.twist.linear.x = ego_speed;
+    append(bag_data, TOPIC::ODOMETRY, odometry);
+
+    AccelWithCovarianceStamped accel;
+    accel.header.stamp = stamp;
+    accel.accel.accel.linear.x = 0.1 * std::sin(t);
+    append(bag_data, TOPIC::ACCELERATION, accel);
+
+    SteeringReport steering;
+    steering.stamp = stamp;
+    steering.steering_tire_angle = 0.01 * std::sin(t);
+    append(bag_data, TOPIC::STEERING, steering);
+
+    TFMessage tf;
+    tf.transforms.emplace_back();
+    tf.transforms.back().header.stamp = stamp;
+    tf.transforms.back().header.frame_id = "map";
+    tf.transforms.back().child_frame_id = "base_link";
+    tf.transforms.back().transform.translation.x = x;
+    tf.transforms.back().transform.rotation.w = 1.0;
+    append(bag_data, TOPIC::TF, tf);
+
+    Trajectory trajectory;
+    trajectory.header = odometry.header;
+    for (size_t j = 0; j < trajectory_length; j++) {
+      TrajectoryPoint point;
+      point.pose.position.x = x + static_cast<double>(j);
+      point.pose.orientation.w = 1.0;
+      point.longitudinal_velocity_mps = ego_speed;
+      trajectory.points.push_back(point);
+    }
+    append(bag_data, TOPIC::TRAJECTORY, trajectory);
+
+    PredictedObjects predicted_objects;
+    predicted_objects.header = odometry.header;
+    for (const auto & [x0, y0, v] : objects) {
+      autoware_perception_msgs::msg::PredictedObject object;
+      auto & pose = object.kinematics.initial_pose_with_covariance.pose;
+      pose.position.x = x0 + v * t;
+      pose.position.y = y0;
+      pose.orientation.w = 1.0;
+      object.kinematics.initial_twist_with_covariance.twist.linear.x = v;
+      predicted_objects.objects.push_back(object);
+    }
+    append(bag_data, TOPIC::OBJECTS, predicted_objects);
+  }
+}
+
+// Run func repeat times and print the mean time per call
+void measure(const std::string & name, const size_t repeat, const std::function<void()> & func)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repeat; i++) {
+    func();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  const auto us = std::chrono::duration<double, std::micro>(end - start).count() / repeat;
+
+  printf("%-40s %12.3f us/call %10zu calls\n", name.c_str(), us, repeat);
+}
+}  // namespace
+}  // namespace autoware::behavior_analyzer
+
+int main(int argc, char * argv[])
+{
+  using autoware::behavior_analyzer::BagData;
+  using autoware::behavior_analyzer::DataSet;
+  using autoware::behavior_analyzer::measure;
+  using autoware::behavior_analyzer::Parameters;
+
+  rclcpp::init(argc, argv);
+
+  auto node = rclcpp::Node::make_shared("behavior_analyzer_benchmark");
+
+  const auto object_num = node->declare_parameter<int>("object_num", 50);
+  const auto trajectory_length = node->declare_parameter<int>("trajectory_length", 200);
+  const auto resample_num = node->declare_parameter<int>("resample_num", 20);
+  const auto lateral_sample_num = node->declare_parameter<int>("lateral_sample_num", 5);
+  const auto longitudinal_sample_num = node->declare_parameter<int>("longitudinal_sample_num", 5);
+  const auto grid_resolution = node->declare_parameter<double>("grid_resolution", 0.1);
+  const auto thread_num = node->declare_parameter<int>("thread_num", 1);
+  const auto repeat = node->declare_parameter<int>("repeat", 100);
+  const auto seed = node->declare_parameter<int>("seed", 0);
+
+  std::cout << "benchmarking with following parameters" << std::endl
+            << "object_num " << object_num << std::endl
+            << "trajectory_length " << trajectory_length << std::endl
+            << "resample_num " << resample_num << std::endl
+            << "lateral_sample_num " << lateral_sample_num << std::endl
+            << "longitudinal_sample_num " << longitudinal_sample_num << std::endl
+            << "grid_resolution " << grid_resolution << std::endl
+            << "thread_num " << thread_num << std::endl
+            << "repeat " << repeat << std::endl;
+
+  if (
+    object_num < 0 || trajectory_length < 2 || resample_num < 2 || lateral_sample_num < 1 ||
+    longitudinal_sample_num < 1 || grid_resolution <= 0.0 || repeat < 1) {
+    std::cerr << "invalid parameters" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const auto parameters = std::make_shared<Parameters>();
+  parameters->resample_num = resample_num;
+  parameters->target_state.lat_positions =
+    autoware::behavior_analyzer::linspace(lateral_sample_num, 4.0);
+  parameters->target_state.lat_velocities = {0.0};
+  parameters->target_state.lat_accelerations = {0.0};
+  parameters->target_state.lon_positions = {0.0};
+  parameters->target_state.lon_velocities = {0.0};
+  parameters->target_state.lon_accelerations =
+    autoware::behavior_analyzer::linspace(longitudinal_sample_num, 0.2);
+  parameters->grid_search.resolution = grid_resolution;
+  parameters->update_discount();
+
+  const auto vehicle_info = autoware::vehicle_info_utils::createVehicleInfo(
+    0.39, 0.42, 2.74, 1.63, 1.0, 1.03, 0.1, 0.1, 2.5, 0.70);
+
+  // The evaluated horizon, and the buffer time for the buffers to be ready
+  const auto duration = parameters->resample_num * parameters->time_resolution + 25.0;
+  const auto bag_data = std::make_shared<BagData>(0);
+  autoware::behavior_analyzer::synthesize(
+    bag_data, object_num, trajectory_length, duration, seed);
+
+  std::unique_ptr<autoware::behavior_analyzer::WorkerPool> pool;
+  if (thread_num > 1) {
+    pool = std::make_unique<autoware::behavior_analyzer::WorkerPool>(thread_num);
+  }
+
+  std::shared_ptr<DataSet> data_set;
+  try {
+    data_set = std::make_shared<DataSet>(bag_data, vehicle_info, parameters, pool.get());
+  } catch (const std::logic_error & e) {
+    std::cerr << "failed to build a data set: " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "candidates " << data_set->sampling.data.size() << std::endl;
+
+  measure("DataSet", repeat, [&]() {
+    [[maybe_unused]] const DataSet d(bag_data, vehicle_info, parameters, pool.get());
+  });
+
+  autoware::behavior_analyzer::SamplingCache sampling_cache;
+  measure("DataSet (sampling cache)", repeat, [&]() {
+    [[maybe_unused]] const DataSet d(
+      bag_data, vehicle_info, parameters, pool.get(), &sampling_cache);
+  });
+
+  auto trajectory = data_set->sampling.data.front();
+  measure("CommonData::calculate", repeat, [&]() { trajectory.calculate(); });
+
+  const auto & objects = data_set->sampling.data.front().object_states->front();
+  const auto & p_ego = data_set->manual.odometry_history.front()->pose.pose;
+  const tf2::Vector3 v_ego(autoware::behavior_analyzer::ego_speed, 0.0, 0.0);
+  volatile double ttc = 0.0;
+  measure("utils::time_to_collision", repeat * 100, [&]() {
+    ttc = autoware::behavior_analyzer::utils::time_to_collision(objects, p_ego, v_ego);
+  });
+
+  measure("SamplingTrajectoryData::best", repeat, [&]() {
+    data_set->sampling.best(parameters->w0, parameters->w1, parameters->w2, parameters->w3);
+  });
+
+  measure("SamplingTrajectoryData::best_index", repeat, [&]() {
+    data_set->sampling.best_index(parameters->w0, parameters->w1, parameters->w2, parameters->w3);
+  });
+
+  // The losses of a data set for all tuples, the unit of work of the weight grid search
+  const auto grid = autoware::behavior_analyzer::weight_grid(parameters->grid_search);
+  std::vector<double> losses(grid.size());
+  std::cout << "weight tuples " << grid.size() << std::endl;
+  measure("DataSet::loss (grid)", repeat, [&]() {
+    data_set->loss(grid, 0, grid.size(), losses);
+  });
+
+  rclcpp::shutdown();
+
+  return 0;
+}
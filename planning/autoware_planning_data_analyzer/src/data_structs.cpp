@@ -14,11 +14,17 @@
 
 #include "data_structs.hpp"
 
+#include "sampling_cache.hpp"
 #include "utils.hpp"
+#include "worker_pool.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cmath>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -26,7 +32,6 @@
 
 namespace autoware::behavior_analyzer
 {
-
 std::string TOPIC::TF = "/tf";                                          // NOLINT
 std::string TOPIC::ODOMETRY = "/localization/kinematic_state";          // NOLINT
 std::string TOPIC::ACCELERATION = "/localization/acceleration";         // NOLINT
@@ -35,97 +40,145 @@ std::string TOPIC::TRAJECTORY = "/planning/trajectory";                 // NOLIN
 std::string TOPIC::STEERING = "/vehicle/status/steering_status";        // NOLINT
                                                                         //
 template <>
-bool Buffer<SteeringReport>::ready() const
+auto Buffer<SteeringReport>::stamp(const SteeringReport & msg) -> rcutils_time_point_value_t
 {
-  if (msgs.empty()) {
-    return false;
-  }
+  return rclcpp::Time(msg.stamp).nanoseconds();
+}
 
-  return rclcpp::Time(msgs.back().stamp).nanoseconds() -
-           rclcpp::Time(msgs.front().stamp).nanoseconds() >
-         BUFFER_TIME;
+template <>
+auto Buffer<TFMessage>::stamp(const TFMessage & msg) -> rcutils_time_point_value_t
+{
+  return rclcpp::Time(msg.transforms.front().header.stamp).nanoseconds();
 }
 
+// A TF message without transforms has no stamp
 template <>
-bool Buffer<TFMessage>::ready() const
+bool Buffer<TFMessage>::valid(const TFMessage & msg)
 {
-  if (msgs.empty()) {
-    return false;
-  }
+  return !msg.transforms.empty();
+}
 
-  if (msgs.front().transforms.empty()) {
-    return false;
+void TransformCache::append(const TFMessage & msg)
+{
+  for (const auto & transform : msg.transforms) {
+    auto & track = tracks_[transform.child_frame_id];
+    const auto t = rclcpp::Time(transform.header.stamp).nanoseconds();
+    const auto & p = transform.transform.translation;
+    const auto & q = transform.transform.rotation;
+
+    track.parent = transform.header.frame_id;
+
+    // The transforms of a bag are usually in order, otherwise a transform is inserted at its place
+    const auto itr = std::upper_bound(track.stamps.begin(), track.stamps.end(), t);
+    const auto idx = std::distance(track.stamps.begin(), itr);
+    track.stamps.insert(itr, t);
+    track.translations.insert(track.translations.begin() + idx, tf2::Vector3(p.x, p.y, p.z));
+    track.rotations.insert(track.rotations.begin() + idx, tf2::Quaternion(q.x, q.y, q.z, q.w));
   }
+}
 
-  if (msgs.back().transforms.empty()) {
-    return false;
+void TransformCache::remove_old_data(const rcutils_time_point_value_t now)
+{
+  for (auto & [frame, track] : tracks_) {
+    while (track.stamps.size() > 1 && track.stamps.at(1) <= now) {
+      track.stamps.pop_front();
+      track.translations.pop_front();
+      track.rotations.pop_front();
+    }
   }
-
-  return rclcpp::Time(msgs.back().transforms.front().header.stamp).nanoseconds() -
-           rclcpp::Time(msgs.front().transforms.front().header.stamp).nanoseconds() >
-         BUFFER_TIME;
 }
 
-template <>
-void Buffer<SteeringReport>::remove_old_data(const rcutils_time_point_value_t now)
+auto TransformCache::Track::interpolate(const rcutils_time_point_value_t t) const
+  -> std::optional<tf2::Transform>
 {
-  if (msgs.empty()) {
-    return;
+  const auto itr = std::upper_bound(stamps.begin(), stamps.end(), t);
+
+  if (itr == stamps.begin()) {
+    return std::nullopt;
   }
 
-  const auto itr = std::remove_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.stamp).nanoseconds() < now;
-  });
-  msgs.erase(itr, msgs.end());
-}
+  const auto idx = static_cast<size_t>(std::distance(stamps.begin(), itr)) - 1;
 
-template <>
-void Buffer<TFMessage>::remove_old_data(const rcutils_time_point_value_t now)
-{
-  if (msgs.empty()) {
-    return;
+  if (itr == stamps.end()) {
+    if (stamps.at(idx) != t) {
+      return std::nullopt;
+    }
+    return tf2::Transform(rotations.at(idx), translations.at(idx));
   }
 
-  const auto itr = std::remove_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.transforms.front().header.stamp).nanoseconds() < now;
-  });
-  msgs.erase(itr, msgs.end());
+  const auto ratio = static_cast<double>(t - stamps.at(idx)) /
+                     static_cast<double>(stamps.at(idx + 1) - stamps.at(idx));
+
+  return tf2::Transform(
+    rotations.at(idx).slerp(rotations.at(idx + 1), ratio),
+    translations.at(idx).lerp(translations.at(idx + 1), ratio));
 }
 
-template <>
-auto Buffer<SteeringReport>::get(const rcutils_time_point_value_t now) const
-  -> SteeringReport::SharedPtr
+auto TransformCache::lookup(
+  const std::string & target_frame, const std::string & source_frame,
+  const rcutils_time_point_value_t t) const -> std::optional<tf2::Transform>
 {
-  const auto itr = std::find_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.stamp).nanoseconds() > now;
-  });
+  tf2::Transform transform = tf2::Transform::getIdentity();
+  std::string frame = source_frame;
+
+  // A loop in the parents ends after as many steps as the frames
+  for (size_t depth = 0; depth <= tracks_.size(); ++depth) {
+    if (frame == target_frame) {
+      return transform;
+    }
+
+    const auto itr = tracks_.find(frame);
+    if (itr == tracks_.end()) {
+      return std::nullopt;
+    }
 
-  if (itr == msgs.end()) {
-    return nullptr;
+    const auto parent_transform = itr->second.interpolate(t);
+    if (!parent_transform) {
+      return std::nullopt;
+    }
+
+    transform = parent_transform.value() * transform;
+    frame = itr->second.parent;
   }
 
-  return std::make_shared<SteeringReport>(*itr);
+  return std::nullopt;
 }
 
-template <>
-auto Buffer<TFMessage>::get(const rcutils_time_point_value_t now) const -> TFMessage::SharedPtr
+auto TransformCache::at(const rcutils_time_point_value_t t) const -> TFMessage
 {
-  const auto itr = std::find_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-    return rclcpp::Time(msg.transforms.front().header.stamp).nanoseconds() > now;
-  });
+  TFMessage msg;
 
-  if (itr == msgs.end()) {
-    return nullptr;
+  for (const auto & [frame, track] : tracks_) {
+    const auto transform = track.interpolate(t);
+    if (!transform) {
+      continue;
+    }
+
+    geometry_msgs::msg::TransformStamped stamped;
+    stamped.header.stamp = rclcpp::Time(t);
+    stamped.header.frame_id = track.parent;
+    stamped.child_frame_id = frame;
+    stamped.transform.translation.x = transform->getOrigin().x();
+    stamped.transform.translation.y = transform->getOrigin().y();
+    stamped.transform.translation.z = transform->getOrigin().z();
+    stamped.transform.rotation.x = transform->getRotation().x();
+    stamped.transform.rotation.y = transform->getRotation().y();
+    stamped.transform.rotation.z = transform->getRotation().z();
+    stamped.transform.rotation.w = transform->getRotation().w();
+    msg.transforms.push_back(stamped);
   }
 
-  return std::make_shared<TFMessage>(*itr);
+  return msg;
 }
 
-CommonData::CommonData(
-  const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
-  const std::shared_ptr<Parameters> & parameters, const std::string & tag)
-: vehicle_info{vehicle_info}, parameters{parameters}, tag{tag}
+namespace
 {
+auto get_objects_history(
+  const std::shared_ptr<BagData> & bag_data, const std::shared_ptr<Parameters> & parameters,
+  std::pmr::memory_resource * resource = std::pmr::get_default_resource())
+  -> std::pmr::vector<PredictedObjects::ConstSharedPtr>
+{
+  std::pmr::vector<PredictedObjects::ConstSharedPtr> objects_history{resource};
   objects_history.reserve(parameters->resample_num);
 
   const auto objects_buffer_ptr = std::dynamic_pointer_cast<Buffer<PredictedObjects>>(
@@ -139,59 +192,189 @@ CommonData::CommonData(
     objects_history.push_back(opt_objects);
   }
 
+  return objects_history;
+}
+
+auto pack_objects_history(
+  const std::pmr::vector<PredictedObjects::ConstSharedPtr> & objects_history)
+  -> std::shared_ptr<const ObjectStatesHistory>
+{
+  auto object_states = std::make_shared<ObjectStatesHistory>();
+  object_states->reserve(objects_history.size());
+
+  for (const auto & objects : objects_history) {
+    object_states->emplace_back(*objects);
+  }
+
+  return object_states;
+}
+
+constexpr double TIME_FACTOR = 0.8;
+
+// Normalization of the discounted metrics into [0, 1], the comforts decrease with the metric
+constexpr double COMFORTABILITY_MAX = 0.5;
+constexpr double EFFICIENCY_MAX = 20.0;
+constexpr double SAFETY_MAX = 5.0;
+
+inline double comfortability_score(const double discount, const double value)
+{
+  return (COMFORTABILITY_MAX - std::clamp(discount * std::abs(value), 0.0, COMFORTABILITY_MAX)) /
+         COMFORTABILITY_MAX;
+}
+
+inline double efficiency_score(const double discount, const double travel_distance)
+{
+  return std::clamp(discount * travel_distance / 0.5, 0.0, EFFICIENCY_MAX) / EFFICIENCY_MAX;
+}
+
+inline double safety_score(const double discount, const double ttc)
+{
+  return std::clamp(discount * ttc, 0.0, SAFETY_MAX) / SAFETY_MAX;
+}
+
+// Discount table of the parameters, or a local one if it was not built for this resample_num
+auto discount_table(const Parameters & parameters, std::vector<double> & local) -> const double *
+{
+  if (parameters.discount.size() >= parameters.resample_num) {
+    return parameters.discount.data();
+  }
+
+  local.resize(parameters.resample_num);
+  for (size_t i = 0; i < parameters.resample_num; i++) {
+    local[i] = std::pow(TIME_FACTOR, i);
+  }
+
+  return local.data();
+}
+
+// Bytes a candidate allocates from its arena, so that the first buffer of an arena fits the
+// candidates of its thread
+auto candidate_arena_size(const Parameters & parameters) -> size_t
+{
+  const auto n = parameters.resample_num;
+  constexpr auto metric_num = static_cast<size_t>(METRIC::SIZE);
+  constexpr auto score_num = static_cast<size_t>(SCORE::SIZE);
+  constexpr size_t alignment_margin = 16 * (metric_num + 4);
+  return n * sizeof(TrajectoryPoint) + n * sizeof(PredictedObjects::ConstSharedPtr) +
+         metric_num * (sizeof(std::pmr::vector<double>) + n * sizeof(double)) +
+         score_num * sizeof(double) + alignment_margin;
+}
+}  // namespace
+
+void Parameters::update_discount()
+{
+  discount.resize(resample_num);
+  for (size_t i = 0; i < resample_num; i++) {
+    discount[i] = std::pow(TIME_FACTOR, i);
+  }
+}
+
+ObjectStates::ObjectStates(const PredictedObjects & objects)
+{
+  const auto object_num = objects.objects.size();
+  for (auto * v : {&x, &y, &z, &vx, &vy, &vz}) {
+    v->reserve(object_num);
+  }
+
+  for (const auto & object : objects.objects) {
+    const auto & p_object = object.kinematics.initial_pose_with_covariance.pose.position;
+    const auto v_object = utils::get_velocity_in_world_coordinate(object.kinematics);
+
+    x.push_back(p_object.x);
+    y.push_back(p_object.y);
+    z.push_back(p_object.z);
+    vx.push_back(v_object.x());
+    vy.push_back(v_object.y());
+    vz.push_back(v_object.z());
+  }
+}
+
+CommonData::CommonData(
+  const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & parameters, const std::string & tag,
+  const std::shared_ptr<const ObjectStatesHistory> & shared_object_states,
+  std::pmr::memory_resource * resource)
+: objects_history{get_objects_history(bag_data, parameters, resource)},
+  object_states{shared_object_states},
+  values{resource},
+  scores{resource},
+  vehicle_info{vehicle_info},
+  parameters{parameters},
+  tag{tag}
+{
+  if (!object_states || object_states->size() != objects_history.size()) {
+    object_states = pack_objects_history(objects_history);
+  }
+
   values.resize(static_cast<size_t>(METRIC::SIZE));
   scores.resize(static_cast<size_t>(SCORE::SIZE));
 }
 
 void CommonData::calculate()
 {
-  std::vector<double> lateral_accel_values;
-  std::vector<double> minimum_ttc_values;
-  std::vector<double> longitudinal_jerk_values;
-  std::vector<double> travel_distance_values;
-
-  for (size_t i = 0; i < parameters->resample_num - 1; i++) {
-    lateral_accel_values.push_back(lateral_accel(i));
-    longitudinal_jerk_values.push_back(longitudinal_jerk(i));
-    minimum_ttc_values.push_back(minimum_ttc(i));
-    travel_distance_values.push_back(travel_distance(i));
+  const auto n = parameters->resample_num;
+
+  // The metric arrays keep their capacity between calls, since the candidates are calculated
+  // concurrently and share the allocator
+  auto & lateral_accel_values = values[static_cast<size_t>(METRIC::LATERAL_ACCEL)];
+  auto & longitudinal_jerk_values = values[static_cast<size_t>(METRIC::LONGITUDINAL_JERK)];
+  auto & minimum_ttc_values = values[static_cast<size_t>(METRIC::MINIMUM_TTC)];
+  auto & travel_distance_values = values[static_cast<size_t>(METRIC::TRAVEL_DISTANCE)];
+
+  lateral_accel_values.resize(n);
+  longitudinal_jerk_values.resize(n);
+  minimum_ttc_values.resize(n);
+  travel_distance_values.resize(n);
+
+  for (size_t i = 0; i + 1 < n; i++) {
+    lateral_accel_values[i] = lateral_accel(i);
+    longitudinal_jerk_values[i] = longitudinal_jerk(i);
+    minimum_ttc_values[i] = minimum_ttc(i);
+    travel_distance_values[i] = travel_distance(i);
   }
 
-  {
-    lateral_accel_values.push_back(lateral_accel(parameters->resample_num - 1));
-    longitudinal_jerk_values.push_back(0.0);
-    minimum_ttc_values.push_back(minimum_ttc(parameters->resample_num - 1));
-    travel_distance_values.push_back(travel_distance(parameters->resample_num - 1));
+  if (n > 0) {
+    lateral_accel_values[n - 1] = lateral_accel(n - 1);
+    longitudinal_jerk_values[n - 1] = 0.0;
+    minimum_ttc_values[n - 1] = minimum_ttc(n - 1);
+    travel_distance_values[n - 1] = travel_distance(n - 1);
   }
 
-  values.at(static_cast<size_t>(METRIC::LATERAL_ACCEL)) = lateral_accel_values;
-  values.at(static_cast<size_t>(METRIC::LONGITUDINAL_JERK)) = longitudinal_jerk_values;
-  values.at(static_cast<size_t>(METRIC::MINIMUM_TTC)) = minimum_ttc_values;
-  values.at(static_cast<size_t>(METRIC::TRAVEL_DISTANCE)) = travel_distance_values;
+  std::vector<double> local_discount;
+  const double * discount = discount_table(*parameters, local_discount);
+  const double * lat_accel = lateral_accel_values.data();
+  const double * lon_jerk = longitudinal_jerk_values.data();
+  const double * ttc = minimum_ttc_values.data();
+  const double * distance = travel_distance_values.data();
+
+  // All the scores in one pass over the metric arrays, without branches so that it vectorizes
+  double lat_score = 0.0;
+  double lon_score = 0.0;
+  double efficiency_sum = 0.0;
+  double safety_sum = 0.0;
+
+  for (size_t i = 0; i < n; i++) {
+    lat_score += comfortability_score(discount[i], lat_accel[i]);
+    lon_score += comfortability_score(discount[i], lon_jerk[i]);
+    efficiency_sum += efficiency_score(discount[i], distance[i]);
+    safety_sum += safety_score(discount[i], ttc[i]);
+  }
 
-  scores.at(static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY)) = lateral_comfortability();
-  scores.at(static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY)) =
-    longitudinal_comfortability();
-  scores.at(static_cast<size_t>(SCORE::EFFICIENCY)) = efficiency();
-  scores.at(static_cast<size_t>(SCORE::SAFETY)) = safety();
+  scores[static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY)] = lat_score / n;
+  scores[static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY)] = lon_score / n;
+  scores[static_cast<size_t>(SCORE::EFFICIENCY)] = efficiency_sum / n;
+  scores[static_cast<size_t>(SCORE::SAFETY)] = safety_sum / n;
 }
 
 double CommonData::longitudinal_comfortability() const
 {
-  constexpr double TIME_FACTOR = 0.8;
+  std::vector<double> local_discount;
+  const double * discount = discount_table(*parameters, local_discount);
+  const auto & metric = values[static_cast<size_t>(METRIC::LONGITUDINAL_JERK)];
 
   double score = 0.0;
-
-  const auto min = 0.0;
-  const auto max = 0.5;
-  const auto normalize = [&min, &max](const double value) {
-    return (max - std::clamp(value, min, max)) / (max - min);
-  };
-
   for (size_t i = 0; i < parameters->resample_num; i++) {
-    score += normalize(
-      std::pow(TIME_FACTOR, i) *
-      std::abs(values.at(static_cast<size_t>(METRIC::LONGITUDINAL_JERK)).at(i)));
+    score += comfortability_score(discount[i], metric[i]);
   }
 
   return score / parameters->resample_num;
@@ -199,20 +382,13 @@ double CommonData::longitudinal_comfortability() const
 
 double CommonData::lateral_comfortability() const
 {
-  constexpr double TIME_FACTOR = 0.8;
+  std::vector<double> local_discount;
+  const double * discount = discount_table(*parameters, local_discount);
+  const auto & metric = values[static_cast<size_t>(METRIC::LATERAL_ACCEL)];
 
   double score = 0.0;
-
-  const auto min = 0.0;
-  const auto max = 0.5;
-  const auto normalize = [&min, &max](const double value) {
-    return (max - std::clamp(value, min, max)) / (max - min);
-  };
-
   for (size_t i = 0; i < parameters->resample_num; i++) {
-    score += normalize(
-      std::pow(TIME_FACTOR, i) *
-      std::abs(values.at(static_cast<size_t>(METRIC::LATERAL_ACCEL)).at(i)));
+    score += comfortability_score(discount[i], metric[i]);
   }
 
   return score / parameters->resample_num;
@@ -220,20 +396,13 @@ double CommonData::lateral_comfortability() const
 
 double CommonData::efficiency() const
 {
-  constexpr double TIME_FACTOR = 0.8;
+  std::vector<double> local_discount;
+  const double * discount = discount_table(*parameters, local_discount);
+  const auto & metric = values[static_cast<size_t>(METRIC::TRAVEL_DISTANCE)];
 
   double score = 0.0;
-
-  const auto min = 0.0;
-  const auto max = 20.0;
-  const auto normalize = [&min, &max](const double value) {
-    return std::clamp(value, min, max) / (max - min);
-  };
-
   for (size_t i = 0; i < parameters->resample_num; i++) {
-    score += normalize(
-      std::pow(TIME_FACTOR, i) * values.at(static_cast<size_t>(METRIC::TRAVEL_DISTANCE)).at(i) /
-      0.5);
+    score += efficiency_score(discount[i], metric[i]);
   }
 
   return score / parameters->resample_num;
@@ -241,19 +410,13 @@ double CommonData::efficiency() const
 
 double CommonData::safety() const
 {
-  constexpr double TIME_FACTOR = 0.8;
+  std::vector<double> local_discount;
+  const double * discount = discount_table(*parameters, local_discount);
+  const auto & metric = values[static_cast<size_t>(METRIC::MINIMUM_TTC)];
 
   double score = 0.0;
-
-  const auto min = 0.0;
-  const auto max = 5.0;
-  const auto normalize = [&min, &max](const double value) {
-    return std::clamp(value, min, max) / (max - min);
-  };
-
   for (size_t i = 0; i < parameters->resample_num; i++) {
-    score += normalize(
-      std::pow(TIME_FACTOR, i) * values.at(static_cast<size_t>(METRIC::MINIMUM_TTC)).at(i));
+    score += safety_score(discount[i], metric[i]);
   }
 
   return score / parameters->resample_num;
@@ -261,10 +424,10 @@ double CommonData::safety() const
 
 double CommonData::total(const double w0, const double w1, const double w2, const double w3) const
 {
-  return w0 * scores.at(static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY)) +
-         w1 * scores.at(static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY)) +
-         w2 * scores.at(static_cast<size_t>(SCORE::EFFICIENCY)) +
-         w3 * scores.at(static_cast<size_t>(SCORE::SAFETY));
+  return w0 * scores[static_cast<size_t>(SCORE::LATERAL_COMFORTABILITY)] +
+         w1 * scores[static_cast<size_t>(SCORE::LONGITUDINAL_COMFORTABILITY)] +
+         w2 * scores[static_cast<size_t>(SCORE::EFFICIENCY)] +
+         w3 * scores[static_cast<size_t>(SCORE::SAFETY)];
 }
 
 ManualDrivingData::ManualDrivingData(
@@ -334,7 +497,7 @@ double ManualDrivingData::minimum_ttc(const size_t idx) const
   const auto p_ego = odometry_history.at(idx)->pose.pose;
   const auto v_ego = utils::get_velocity_in_world_coordinate(*odometry_history.at(idx));
 
-  return utils::time_to_collision(*objects_history.at(idx), p_ego, v_ego);
+  return utils::time_to_collision(object_states->at(idx), p_ego, v_ego);
 }
 
 double ManualDrivingData::travel_distance(const size_t idx) const
@@ -371,8 +534,11 @@ bool ManualDrivingData::ready() const
 TrajectoryData::TrajectoryData(
   const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
   const std::shared_ptr<Parameters> & parameters, const std::string & tag,
-  const std::vector<TrajectoryPoint> & points)
-: CommonData(bag_data, vehicle_info, parameters, tag), points{points}
+  const std::vector<TrajectoryPoint> & points,
+  const std::shared_ptr<const ObjectStatesHistory> & shared_object_states,
+  std::pmr::memory_resource * resource)
+: CommonData(bag_data, vehicle_info, parameters, tag, shared_object_states, resource),
+  points(points.begin(), points.end(), resource)
 {
   calculate();
 }
@@ -394,7 +560,7 @@ double TrajectoryData::minimum_ttc(const size_t idx) const
   const auto p_ego = points.at(idx).pose;
   const auto v_ego = utils::get_velocity_in_world_coordinate(points.at(idx));
 
-  return utils::time_to_collision(*objects_history.at(idx), p_ego, v_ego);
+  return utils::time_to_collision(object_states->at(idx), p_ego, v_ego);
 }
 
 double TrajectoryData::travel_distance(const size_t idx) const
@@ -423,7 +589,7 @@ bool TrajectoryData::ready() const
 
 SamplingTrajectoryData::SamplingTrajectoryData(
   const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
-  const std::shared_ptr<Parameters> & parameters)
+  const std::shared_ptr<Parameters> & parameters, WorkerPool * pool, SamplingCache * cache)
 {
   const auto opt_odometry = std::dynamic_pointer_cast<Buffer<Odometry>>(
                               bag_data->buffers.at("/localization/kinematic_state"))
@@ -445,22 +611,59 @@ SamplingTrajectoryData::SamplingTrajectoryData(
   if (!opt_trajectory) {
     throw std::logic_error("data is not enough.");
   }
-  data.emplace_back(
-    bag_data, vehicle_info, parameters, "autoware",
-    utils::resampling(
-      *opt_trajectory, opt_odometry->pose.pose, parameters->resample_num,
-      parameters->time_resolution));
 
-  for (const auto & sample : utils::sampling(
-         *opt_trajectory, opt_odometry->pose.pose, opt_odometry->twist.twist.linear.x,
-         opt_accel->accel.accel.linear.x, vehicle_info, parameters)) {
-    data.emplace_back(bag_data, vehicle_info, parameters, "frenet", sample);
+  // The points of all candidates are generated first, and their metrics are calculated after
+  std::vector<std::pair<std::string, std::vector<TrajectoryPoint>>> candidates;
+
+  auto autoware_points = utils::resampling(
+    *opt_trajectory, opt_odometry->pose.pose, parameters->resample_num,
+    parameters->time_resolution);
+  candidates.emplace_back("autoware", std::move(autoware_points));
+
+  SamplingCache local_cache;
+  for (auto & sample : utils::sampling(
+         opt_trajectory, opt_odometry->pose.pose, opt_odometry->twist.twist.linear.x,
+         opt_accel->accel.accel.linear.x, vehicle_info, parameters,
+         cache != nullptr ? *cache : local_cache)) {
+    candidates.emplace_back("frenet", std::move(sample));
   }
 
   std::vector<TrajectoryPoint> stop_points(parameters->resample_num);
   for (auto & stop_point : stop_points) {
     stop_point.pose = opt_odometry->pose.pose;
   }
-  data.emplace_back(bag_data, vehicle_info, parameters, "stop", stop_points);
+  candidates.emplace_back("stop", std::move(stop_points));
+
+  // The objects are the same for all candidates, so they are packed once for this time step
+  const auto object_states = pack_objects_history(get_objects_history(bag_data, parameters));
+
+  // Each candidate is written to its own slot, so the order is the same as the sequential one
+  std::vector<std::optional<TrajectoryData>> slots(candidates.size());
+
+  // A monotonic arena is not thread-safe, so each thread allocates from its own one
+  const auto worker_num = pool == nullptr || pool->size() < 2 ? 1 : pool->size();
+  const auto arena_size =
+    candidate_arena_size(*parameters) * ((candidates.size() + worker_num - 1) / worker_num);
+  arenas.reserve(worker_num);
+  for (size_t i = 0; i < worker_num; i++) {
+    arenas.push_back(std::make_shared<std::pmr::monotonic_buffer_resource>(arena_size));
+  }
+
+  const auto build = [&](const size_t idx, const size_t worker) {
+    slots.at(idx).emplace(
+      bag_data, vehicle_info, parameters, candidates.at(idx).first, candidates.at(idx).second,
+      object_states, arenas.at(worker).get());
+  };
+
+  if (worker_num == 1) {
+    for (size_t idx = 0; idx < candidates.size(); idx++) build(idx, 0);
+  } else {
+    pool->run(candidates.size(), build);
+  }
+
+  data.reserve(slots.size());
+  for (auto & slot : slots) {
+    data.push_back(std::move(*slot));
+  }
 }
 }  // namespace autoware::behavior_analyzer
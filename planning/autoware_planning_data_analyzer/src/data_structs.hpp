@@ -19,10 +19,16 @@
 
 #include <autoware/universe_utils/geometry/geometry.hpp>
 
+#include <tf2/LinearMath/Transform.h>
+
 #include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <limits>
 #include <map>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -31,6 +37,9 @@
 namespace autoware::behavior_analyzer
 {
 
+class WorkerPool;
+struct SamplingCache;
+
 enum class METRIC {
   LATERAL_ACCEL = 0,
   LONGITUDINAL_ACCEL = 1,
@@ -81,6 +90,10 @@ struct GridSearchParameters
   double resolution{0.01};
   double dt{1.0};
   size_t thread_num{4};
+  bool adaptive{false};
+  double coarse_resolution{0.1};
+  size_t top_k{8};
+  double prune_margin{0.0};
 };
 
 struct Parameters
@@ -93,6 +106,12 @@ struct Parameters
   double w3{1.0};
   GridSearchParameters grid_search{};
   TargetStateParameters target_state{};
+
+  // Discount factor of each time step in the scores, shared by all the candidates. Rebuilt by
+  // update_discount() whenever resample_num changes
+  std::vector<double> discount{};
+
+  void update_discount();
 };
 
 struct Result
@@ -112,68 +131,125 @@ struct BufferBase
 {
   virtual bool ready() const = 0;
   virtual void remove_old_data(const rcutils_time_point_value_t now) = 0;
+  virtual auto clone() const -> std::shared_ptr<BufferBase> = 0;
 };
 
+// Messages sorted by their stamps, which are kept next to them, so that a message is found by a
+// binary search and handed out without copying it, and old messages are removed from the front
 template <typename T>
 struct Buffer : BufferBase
 {
-  std::vector<T> msgs;
+  std::deque<std::shared_ptr<const T>> msgs;
+
+  std::deque<rcutils_time_point_value_t> stamps;
 
   const double BUFFER_TIME = 20.0 * 1e9;
 
+  static auto stamp(const T & msg) -> rcutils_time_point_value_t
+  {
+    return rclcpp::Time(msg.header.stamp).nanoseconds();
+  }
+
+  static bool valid([[maybe_unused]] const T & msg) { return true; }
+
   bool ready() const override
   {
-    if (msgs.empty()) {
+    if (stamps.empty()) {
       return false;
     }
 
-    return rclcpp::Time(msgs.back().header.stamp).nanoseconds() -
-             rclcpp::Time(msgs.front().header.stamp).nanoseconds() >
-           BUFFER_TIME;
+    return stamps.back() - stamps.front() > BUFFER_TIME;
   }
 
   void remove_old_data(const rcutils_time_point_value_t now) override
   {
-    const auto itr = std::remove_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-      return rclcpp::Time(msg.header.stamp).nanoseconds() < now;
-    });
-    msgs.erase(itr, msgs.end());
+    while (!stamps.empty() && stamps.front() < now) {
+      stamps.pop_front();
+      msgs.pop_front();
+    }
   }
 
-  void append(const T & msg) { msgs.push_back(msg); }
+  auto clone() const -> std::shared_ptr<BufferBase> override
+  {
+    return std::make_shared<Buffer<T>>(*this);
+  }
 
-  auto get(const rcutils_time_point_value_t now) const -> typename T::SharedPtr
+  void append(const std::shared_ptr<const T> & msg)
   {
-    const auto itr = std::find_if(msgs.begin(), msgs.end(), [&now, this](const auto & msg) {
-      return rclcpp::Time(msg.header.stamp).nanoseconds() > now;
-    });
+    if (!valid(*msg)) {
+      return;
+    }
+
+    const auto t = stamp(*msg);
+
+    // The messages of a bag are usually in order, otherwise a message is inserted at its place
+    if (stamps.empty() || t >= stamps.back()) {
+      stamps.push_back(t);
+      msgs.push_back(msg);
+      return;
+    }
 
-    if (itr == msgs.end()) {
+    const auto itr = std::upper_bound(stamps.begin(), stamps.end(), t);
+    msgs.insert(msgs.begin() + std::distance(stamps.begin(), itr), msg);
+    stamps.insert(itr, t);
+  }
+
+  // The first message after now
+  auto get(const rcutils_time_point_value_t now) const -> typename T::ConstSharedPtr
+  {
+    const auto itr = std::upper_bound(stamps.begin(), stamps.end(), now);
+
+    if (itr == stamps.end()) {
       return nullptr;
     }
 
-    return std::make_shared<T>(*itr);
+    return msgs.at(std::distance(stamps.begin(), itr));
   }
 };
 
 template <>
-bool Buffer<SteeringReport>::ready() const;
+auto Buffer<SteeringReport>::stamp(const SteeringReport & msg) -> rcutils_time_point_value_t;
 
 template <>
-bool Buffer<TFMessage>::ready() const;
+auto Buffer<TFMessage>::stamp(const TFMessage & msg) -> rcutils_time_point_value_t;
 
 template <>
-void Buffer<SteeringReport>::remove_old_data(const rcutils_time_point_value_t now);
+bool Buffer<TFMessage>::valid(const TFMessage & msg);
 
-template <>
-void Buffer<TFMessage>::remove_old_data(const rcutils_time_point_value_t now);
+// Transforms of the TF messages decomposed per child frame, with the stamps, translations and
+// rotations kept in arrays, so that the transform of a frame at any time is interpolated after a
+// binary search instead of a search of the messages. The lookups do not modify the cache, so the
+// workers read it concurrently as long as nothing is appended
+class TransformCache
+{
+public:
+  void append(const TFMessage & msg);
 
-template <>
-auto Buffer<SteeringReport>::get(const rcutils_time_point_value_t now) const
-  -> SteeringReport::SharedPtr;
+  // The last transform before now is kept, since the transforms at now are interpolated from it
+  void remove_old_data(const rcutils_time_point_value_t now);
 
-template <>
-auto Buffer<TFMessage>::get(const rcutils_time_point_value_t now) const -> TFMessage::SharedPtr;
+  // Transform from source_frame to target_frame at t, composed along the parents of source_frame.
+  // nullopt if target_frame is not one of the parents or a transform is not known around t
+  auto lookup(
+    const std::string & target_frame, const std::string & source_frame,
+    const rcutils_time_point_value_t t) const -> std::optional<tf2::Transform>;
+
+  // The transform of every frame to its parent at t, for the frames known around t
+  auto at(const rcutils_time_point_value_t t) const -> TFMessage;
+
+private:
+  struct Track
+  {
+    std::string parent;
+    std::deque<rcutils_time_point_value_t> stamps;
+    std::deque<tf2::Vector3> translations;
+    std::deque<tf2::Quaternion> rotations;
+
+    auto interpolate(const rcutils_time_point_value_t t) const -> std::optional<tf2::Transform>;
+  };
+
+  std::unordered_map<std::string, Track> tracks_;
+};
 
 struct BagData
 {
@@ -189,6 +265,9 @@ struct BagData
 
   std::map<std::string, std::shared_ptr<BufferBase>> buffers{};
 
+  // The messages of TOPIC::TF are also appended here
+  TransformCache transforms{};
+
   rcutils_time_point_value_t timestamp;
 
   void update(const rcutils_time_point_value_t dt)
@@ -202,6 +281,7 @@ struct BagData
     std::for_each(buffers.begin(), buffers.end(), [this](const auto & buffer) {
       buffer.second->remove_old_data(timestamp);
     });
+    transforms.remove_old_data(timestamp);
   }
 
   bool ready() const
@@ -209,14 +289,42 @@ struct BagData
     return std::all_of(
       buffers.begin(), buffers.end(), [](const auto & buffer) { return buffer.second->ready(); });
   }
+
+  // A copy whose buffers share the messages with these ones, so that it is evaluated while this
+  // one is advanced
+  auto snapshot() const -> std::shared_ptr<BagData>
+  {
+    auto copy = std::make_shared<BagData>(*this);
+    for (auto & buffer : copy->buffers) {
+      buffer.second = buffer.second->clone();
+    }
+    return copy;
+  }
+};
+
+// Positions and velocities in the world coordinate of the objects at one time step, stored as
+// arrays so that the TTC against an ego state is a single pass over contiguous data
+struct ObjectStates
+{
+  explicit ObjectStates(const PredictedObjects & objects);
+
+  std::vector<double> x, y, z;
+  std::vector<double> vx, vy, vz;
 };
 
+using ObjectStatesHistory = std::vector<ObjectStates>;
+
 struct CommonData
 {
+  // The object states are packed from objects_history unless they are shared by the caller. The
+  // containers are allocated from resource, and their copies from the default resource
   CommonData(
     const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
-    const std::shared_ptr<Parameters> & parameters, const std::string & tag);
+    const std::shared_ptr<Parameters> & parameters, const std::string & tag,
+    const std::shared_ptr<const ObjectStatesHistory> & shared_object_states = nullptr,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
+  // Fill the metrics of every time step and score them in a single pass
   void calculate();
 
   double longitudinal_comfortability() const;
@@ -241,11 +349,13 @@ struct CommonData
 
   virtual bool ready() const = 0;
 
-  std::vector<PredictedObjects::SharedPtr> objects_history;
+  std::pmr::vector<PredictedObjects::ConstSharedPtr> objects_history;
+
+  std::shared_ptr<const ObjectStatesHistory> object_states;
 
-  std::vector<std::vector<double>> values;
+  std::pmr::vector<std::pmr::vector<double>> values;
 
-  std::vector<double> scores;
+  std::pmr::vector<double> scores;
 
   // std::unordered_map<METRIC, std::vector<double>> values;
 
@@ -276,9 +386,9 @@ struct ManualDrivingData : CommonData
 
   bool ready() const override;
 
-  std::vector<Odometry::SharedPtr> odometry_history;
-  std::vector<AccelWithCovarianceStamped::SharedPtr> accel_history;
-  std::vector<SteeringReport::SharedPtr> steer_history;
+  std::vector<Odometry::ConstSharedPtr> odometry_history;
+  std::vector<AccelWithCovarianceStamped::ConstSharedPtr> accel_history;
+  std::vector<SteeringReport::ConstSharedPtr> steer_history;
 };
 
 struct TrajectoryData : CommonData
@@ -286,7 +396,9 @@ struct TrajectoryData : CommonData
   TrajectoryData(
     const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
     const std::shared_ptr<Parameters> & parameters, const std::string & tag,
-    const std::vector<TrajectoryPoint> & points);
+    const std::vector<TrajectoryPoint> & points,
+    const std::shared_ptr<const ObjectStatesHistory> & shared_object_states = nullptr,
+    std::pmr::memory_resource * resource = std::pmr::get_default_resource());
 
   double lateral_accel(const size_t idx) const override;
 
@@ -300,34 +412,41 @@ struct TrajectoryData : CommonData
 
   bool ready() const override;
 
-  std::vector<TrajectoryPoint> points;
+  std::pmr::vector<TrajectoryPoint> points;
 };
 
 struct SamplingTrajectoryData
 {
+  // The candidates are independent, so they are evaluated on the threads of pool if it is given.
+  // The sampling reuses the spline of the previous time step in cache if it is given
   SamplingTrajectoryData(
     const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
-    const std::shared_ptr<Parameters> & parameters);
+    const std::shared_ptr<Parameters> & parameters, WorkerPool * pool = nullptr,
+    SamplingCache * cache = nullptr);
+
+  // Index of the feasible trajectory of the highest total score, the first one among equal scores
+  auto best_index(const double w0, const double w1, const double w2, const double w3) const
+    -> std::optional<size_t>
+  {
+    std::optional<size_t> best;
+    auto best_score = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < data.size(); i++) {
+      if (!data[i].feasible()) continue;
+      const auto score = data[i].total(w0, w1, w2, w3);
+      if (!best.has_value() || score > best_score) {
+        best = i;
+        best_score = score;
+      }
+    }
+    return best;
+  }
 
   auto best(const double w0, const double w1, const double w2, const double w3) const
     -> std::optional<TrajectoryData>
   {
-    auto sort_by_score = data;
-
-    std::sort(
-      sort_by_score.begin(), sort_by_score.end(),
-      [&w0, &w1, &w2, &w3](const auto & a, const auto & b) {
-        return a.total(w0, w1, w2, w3) > b.total(w0, w1, w2, w3);
-      });
-
-    const auto itr = std::remove_if(
-      sort_by_score.begin(), sort_by_score.end(), [](const auto & d) { return !d.feasible(); });
-
-    sort_by_score.erase(itr, sort_by_score.end());
-
-    if (sort_by_score.empty()) return std::nullopt;
-
-    return sort_by_score.front();
+    const auto idx = best_index(w0, w1, w2, w3);
+    if (!idx.has_value()) return std::nullopt;
+    return data.at(idx.value());
   }
 
   auto autoware() const -> std::optional<TrajectoryData>
@@ -339,47 +458,125 @@ struct SamplingTrajectoryData
     return *itr;
   }
 
+  // Monotonic arenas, one per thread that builds the candidates, from which the containers of
+  // data are allocated. They are released at once with this time step instead of one by one, and
+  // are declared first so that they outlive data
+  std::vector<std::shared_ptr<std::pmr::monotonic_buffer_resource>> arenas;
+
   std::vector<TrajectoryData> data;
 };
 
-struct DataSet
+// The scores, the feasibility and the error of every trajectory of a data set. The loss depends on
+// the weights only through the best trajectory, so they are computed once for all weight tuples,
+// and kept alone when the trajectories themselves are no longer needed
+struct LossTable
 {
-  DataSet(
-    const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
-    const std::shared_ptr<Parameters> & parameters)
-  : manual{ManualDrivingData(bag_data, vehicle_info, parameters)},
-    sampling{SamplingTrajectoryData(bag_data, vehicle_info, parameters)},
-    parameters{parameters}
+  LossTable(const ManualDrivingData & manual, const SamplingTrajectoryData & sampling)
   {
+    constexpr size_t score_num = static_cast<size_t>(SCORE::SIZE);
+
+    const auto trajectory_num = sampling.data.size();
+    score_matrix.resize(trajectory_num * score_num);
+    feasible_mask.resize(trajectory_num);
+    trajectory_loss.resize(trajectory_num);
+
+    for (size_t i = 0; i < trajectory_num; i++) {
+      const auto & trajectory = sampling.data.at(i);
+
+      for (size_t j = 0; j < score_num; j++) {
+        score_matrix.at(i * score_num + j) = trajectory.scores.at(j);
+      }
+      feasible_mask.at(i) = trajectory.feasible() ? 1 : 0;
+
+      const auto min_size = std::min(manual.odometry_history.size(), trajectory.points.size());
+
+      double mse = 0.0;
+      for (size_t j = 0; j < min_size; j++) {
+        const auto & p1 = manual.odometry_history.at(j)->pose.pose;
+        const auto & p2 = trajectory.points.at(j);
+        mse = (mse * j + autoware::universe_utils::calcSquaredDistance2d(p1, p2)) / (j + 1);
+      }
+
+      trajectory_loss.at(i) = mse;
+    }
   }
 
   auto loss(const double w0, const double w1, const double w2, const double w3) const -> double
   {
-    const auto best = sampling.best(w0, w1, w2, w3);
-    if (!best.has_value()) {
-      throw std::logic_error("no found best trajectory.");
+    constexpr size_t score_num = static_cast<size_t>(SCORE::SIZE);
+    const auto trajectory_num = feasible_mask.size();
+
+    // The argmax of the product of the score matrix and the weights over the feasible
+    // trajectories, the same as SamplingTrajectoryData::best
+    auto best = trajectory_num;
+    auto best_score = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < trajectory_num; i++) {
+      const auto * s = score_matrix.data() + i * score_num;
+      const auto score = w0 * s[0] + w1 * s[1] + w2 * s[2] + w3 * s[3];
+      if (feasible_mask[i] && (best == trajectory_num || score > best_score)) {
+        best = i;
+        best_score = score;
+      }
     }
 
-    const auto min_size = std::min(manual.odometry_history.size(), best.value().points.size());
-
-    double mse = 0.0;
-    for (size_t i = 0; i < min_size; i++) {
-      const auto & p1 = manual.odometry_history.at(i)->pose.pose;
-      const auto & p2 = best.value().points.at(i);
-      mse = (mse * i + autoware::universe_utils::calcSquaredDistance2d(p1, p2)) / (i + 1);
+    if (best == trajectory_num) {
+      throw std::logic_error("no found best trajectory.");
     }
 
-    if (!std::isfinite(mse)) {
+    if (!std::isfinite(trajectory_loss[best])) {
       throw std::logic_error("loss value is invalid.");
     }
 
-    return mse;
+    return trajectory_loss[best];
+  }
+
+  // Losses of the weight tuples grid[begin, end), written to losses[begin, end)
+  void loss(
+    const std::vector<Result> & grid, const size_t begin, const size_t end,
+    std::vector<double> & losses) const
+  {
+    for (size_t k = begin; k < end; k++) {
+      const auto & w = grid.at(k);
+      losses.at(k) = loss(w.w0, w.w1, w.w2, w.w3);
+    }
+  }
+
+  std::vector<double> score_matrix;  // trajectory_num x SCORE::SIZE, row-major
+  std::vector<uint8_t> feasible_mask;
+  std::vector<double> trajectory_loss;
+};
+
+struct DataSet
+{
+  DataSet(
+    const std::shared_ptr<BagData> & bag_data, const vehicle_info_utils::VehicleInfo & vehicle_info,
+    const std::shared_ptr<Parameters> & parameters, WorkerPool * pool = nullptr,
+    SamplingCache * cache = nullptr)
+  : manual{ManualDrivingData(bag_data, vehicle_info, parameters)},
+    sampling{SamplingTrajectoryData(bag_data, vehicle_info, parameters, pool, cache)},
+    parameters{parameters},
+    loss_table{manual, sampling}
+  {
+  }
+
+  auto loss(const double w0, const double w1, const double w2, const double w3) const -> double
+  {
+    return loss_table.loss(w0, w1, w2, w3);
+  }
+
+  void loss(
+    const std::vector<Result> & grid, const size_t begin, const size_t end,
+    std::vector<double> & losses) const
+  {
+    loss_table.loss(grid, begin, end, losses);
   }
 
   ManualDrivingData manual;
   SamplingTrajectoryData sampling;
 
   std::shared_ptr<Parameters> parameters;
+
+  LossTable loss_table;
 };
 
 }  // namespace autoware::behavior_analyzer
@@ -0,0 +1,144 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "loader.hpp"
+
+#include <rmw/rmw.h>
+#include <rosidl_typesupport_cpp/message_type_support.hpp>
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+using MessageHandler = std::function<void(const rcutils_uint8_array_t &)>;
+
+// Deserialize a message straight from the bag's buffer, without copying it into an
+// rclcpp::SerializedMessage, and append it to the buffer of the topic
+template <class T>
+auto make_handler(const std::shared_ptr<BagData> & bag_data, const std::string & topic)
+  -> MessageHandler
+{
+  const auto buffer = std::dynamic_pointer_cast<Buffer<T>>(bag_data->buffers.at(topic));
+  const auto * type_support = rosidl_typesupport_cpp::get_message_type_support_handle<T>();
+
+  return [bag_data, buffer, type_support](const rcutils_uint8_array_t & serialized_data) {
+    const auto deserialized_message = std::make_shared<T>();
+    if (rmw_deserialize(&serialized_data, type_support, deserialized_message.get()) != RMW_RET_OK) {
+      throw std::runtime_error("failed to deserialize message.");
+    }
+    buffer->append(deserialized_message);
+    if constexpr (std::is_same_v<T, TFMessage>) {
+      bag_data->transforms.append(*deserialized_message);
+    }
+  };
+}
+
+// The source is a rosbag2_cpp::Reader or a BagCache, which have the same interface to read the
+// messages in order
+template <class Source>
+void load(Source & source, const std::shared_ptr<BagData> & bag_data, const double dt)
+{
+  // The buffers and the type supports are looked up once, and each message costs one hash of its
+  // topic name
+  const std::unordered_map<std::string, MessageHandler> handlers{
+    {TOPIC::TF, make_handler<TFMessage>(bag_data, TOPIC::TF)},
+    {TOPIC::ODOMETRY, make_handler<Odometry>(bag_data, TOPIC::ODOMETRY)},
+    {TOPIC::ACCELERATION, make_handler<AccelWithCovarianceStamped>(bag_data, TOPIC::ACCELERATION)},
+    {TOPIC::OBJECTS, make_handler<PredictedObjects>(bag_data, TOPIC::OBJECTS)},
+    {TOPIC::STEERING, make_handler<SteeringReport>(bag_data, TOPIC::STEERING)},
+    {TOPIC::TRAJECTORY, make_handler<Trajectory>(bag_data, TOPIC::TRAJECTORY)},
+  };
+
+  bag_data->update(dt * 1e9);
+
+  while (source.has_next()) {
+    const auto next_data = source.read_next();
+
+    if (bag_data->ready()) {
+      break;
+    }
+
+    const auto itr = handlers.find(next_data->topic_name);
+    if (itr != handlers.end()) {
+      itr->second(*next_data->serialized_data);
+    }
+  }
+}
+}  // namespace
+
+auto load_parameters(rclcpp::Node & node) -> std::shared_ptr<Parameters>
+{
+  const auto parameters = std::make_shared<Parameters>();
+  parameters->resample_num = node.declare_parameter<int>("resample_num");
+  parameters->time_resolution = node.declare_parameter<double>("time_resolution");
+  parameters->w0 = node.declare_parameter<double>("weight.lat_comfortability");
+  parameters->w1 = node.declare_parameter<double>("weight.lon_comfortability");
+  parameters->w2 = node.declare_parameter<double>("weight.efficiency");
+  parameters->w3 = node.declare_parameter<double>("weight.safety");
+  parameters->grid_search.dt = node.declare_parameter<double>("grid_search.dt");
+  parameters->grid_search.min = node.declare_parameter<double>("grid_search.min");
+  parameters->grid_search.max = node.declare_parameter<double>("grid_search.max");
+  parameters->grid_search.resolution = node.declare_parameter<double>("grid_search.resolution");
+  parameters->grid_search.thread_num = node.declare_parameter<int>("grid_search.thread_num");
+  parameters->grid_search.adaptive = node.declare_parameter<bool>("grid_search.adaptive");
+  parameters->grid_search.coarse_resolution =
+    node.declare_parameter<double>("grid_search.coarse_resolution");
+  parameters->grid_search.top_k = node.declare_parameter<int>("grid_search.top_k");
+  parameters->grid_search.prune_margin = node.declare_parameter<double>("grid_search.prune_margin");
+  parameters->target_state.lat_positions =
+    node.declare_parameter<std::vector<double>>("target_state.lateral_positions");
+  parameters->target_state.lat_velocities =
+    node.declare_parameter<std::vector<double>>("target_state.lateral_velocities");
+  parameters->target_state.lat_accelerations =
+    node.declare_parameter<std::vector<double>>("target_state.lateral_accelerations");
+  parameters->target_state.lon_positions =
+    node.declare_parameter<std::vector<double>>("target_state.longitudinal_positions");
+  parameters->target_state.lon_velocities =
+    node.declare_parameter<std::vector<double>>("target_state.longitudinal_velocities");
+  parameters->target_state.lon_accelerations =
+    node.declare_parameter<std::vector<double>>("target_state.longitudinal_accelerations");
+  parameters->update_discount();
+
+  return parameters;
+}
+
+auto analyzed_topics() -> std::vector<std::string>
+{
+  return std::vector<std::string>{TOPIC::TF,      TOPIC::ODOMETRY, TOPIC::ACCELERATION,
+                                  TOPIC::OBJECTS, TOPIC::STEERING, TOPIC::TRAJECTORY};
+}
+
+void load_messages(
+  rosbag2_cpp::Reader & reader, const std::shared_ptr<BagData> & bag_data, const double dt)
+{
+  rosbag2_storage::StorageFilter filter;
+  filter.topics = analyzed_topics();
+  reader.set_filter(filter);
+
+  load(reader, bag_data, dt);
+}
+
+void load_messages(BagCache & cache, const std::shared_ptr<BagData> & bag_data, const double dt)
+{
+  load(cache, bag_data, dt);
+}
+}  // namespace autoware::behavior_analyzer
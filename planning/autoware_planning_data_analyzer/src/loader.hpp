@@ -0,0 +1,44 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LOADER_HPP_
+#define LOADER_HPP_
+
+#include "bag_cache.hpp"
+#include "data_structs.hpp"
+#include "rosbag2_cpp/reader.hpp"
+
+#include <rclcpp/rclcpp.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// Declare the parameters of the analyzer on the node and return their values
+auto load_parameters(rclcpp::Node & node) -> std::shared_ptr<Parameters>;
+
+// Topics of the bag that are read by the analyzer
+auto analyzed_topics() -> std::vector<std::string>;
+
+// Advance bag_data by dt [s] and read messages from the reader until its buffers are ready
+void load_messages(
+  rosbag2_cpp::Reader & reader, const std::shared_ptr<BagData> & bag_data, const double dt);
+
+// The same as above, from the messages of the cache
+void load_messages(BagCache & cache, const std::shared_ptr<BagData> & bag_data, const double dt);
+}  // namespace autoware::behavior_analyzer
+
+#endif  // LOADER_HPP_
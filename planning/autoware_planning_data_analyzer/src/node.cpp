@@ -15,12 +15,20 @@
 #include "node.hpp"
 
 #include "autoware/universe_utils/system/stop_watch.hpp"
+#include "loader.hpp"
+#include "weight_search.hpp"
+#include "weight_shard.hpp"
 
+#include <autoware/profiling_utils/profiling_utils.hpp>
 #include <autoware/universe_utils/ros/marker_helper.hpp>
 
+#include <tf2/utils.h>
+
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -29,9 +37,44 @@ namespace autoware::behavior_analyzer
 using autoware::universe_utils::createDefaultMarker;
 using autoware::universe_utils::createMarkerColor;
 using autoware::universe_utils::createMarkerScale;
+using autoware::universe_utils::createPoint;
 using autoware::universe_utils::Point2d;
 using autoware::universe_utils::Polygon2d;
 
+namespace
+{
+// One marker per namespace, the arrows and the candidates are drawn as line lists
+enum MARKER { MANUAL = 0, CANDIDATES, INFEASIBLE, BEST, SYSTEM, SIZE };
+
+// The shaft and the head of an arrow along the heading of the pose, as segments of a line list
+void add_arrow(const Pose & pose, const double length, std::vector<Point> & points)
+{
+  constexpr double head_angle = M_PI - M_PI / 6.0;
+  const auto yaw = tf2::getYaw(pose.orientation);
+  const auto & p = pose.position;
+  const auto tip = createPoint(p.x + length * std::cos(yaw), p.y + length * std::sin(yaw), p.z);
+  const auto head_length = 0.3 * length;
+
+  points.push_back(p);
+  points.push_back(tip);
+  for (const auto side : {-1.0, 1.0}) {
+    const auto angle = yaw + side * head_angle;
+    points.push_back(tip);
+    points.push_back(createPoint(
+      tip.x + head_length * std::cos(angle), tip.y + head_length * std::sin(angle), p.z));
+  }
+}
+
+void add_line_list(
+  const std::pmr::vector<TrajectoryPoint> & trajectory, std::vector<Point> & points)
+{
+  for (size_t i = 1; i < trajectory.size(); i++) {
+    points.push_back(trajectory[i - 1].pose.position);
+    points.push_back(trajectory[i].pose.position);
+  }
+}
+}  // namespace
+
 BehaviorAnalyzerNode::BehaviorAnalyzerNode(const rclcpp::NodeOptions & node_options)
 : Node("path_selector_node", node_options)
 {
@@ -55,6 +98,8 @@ BehaviorAnalyzerNode::BehaviorAnalyzerNode(const rclcpp::NodeOptions & node_opti
     create_publisher<Float32MultiArrayStamped>("~/system_metrics", rclcpp::QoS{1});
   pub_manual_score_ = create_publisher<Float32MultiArrayStamped>("~/manual_score", rclcpp::QoS{1});
   pub_system_score_ = create_publisher<Float32MultiArrayStamped>("~/system_score", rclcpp::QoS{1});
+  pub_weight_progress_ =
+    create_publisher<Float32MultiArrayStamped>("~/weight_grid_search/progress", rclcpp::QoS{1});
 
   srv_play_ = this->create_service<SetBool>(
     "play",
@@ -71,107 +116,105 @@ BehaviorAnalyzerNode::BehaviorAnalyzerNode(const rclcpp::NodeOptions & node_opti
     std::bind(&BehaviorAnalyzerNode::weight, this, std::placeholders::_1, std::placeholders::_2),
     rclcpp::ServicesQoS().get_rmw_qos_profile());
 
-  reader_.open(declare_parameter<std::string>("bag_path"));
+  srv_cancel_weight_ = this->create_service<Trigger>(
+    "cancel_weight_grid_search",
+    std::bind(
+      &BehaviorAnalyzerNode::cancel_weight, this, std::placeholders::_1, std::placeholders::_2),
+    rclcpp::ServicesQoS().get_rmw_qos_profile());
 
-  bag_data_ = std::make_shared<BagData>(
-    duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
+  bag_path_ = declare_parameter<std::string>("bag_path");
+  reader_.open(bag_path_);
+
+  parameters_ = load_parameters(*this);
+
+  visualization_interval_ = declare_parameter<double>("visualization.interval");
+
+  prefetch_window_num_ =
+    static_cast<size_t>(std::max(declare_parameter<int>("prefetch.window_num"), 1));
+
+  marker_array_.markers.resize(MARKER::SIZE);
+  marker_array_.markers.at(MARKER::MANUAL) = createDefaultMarker(
+    "map", now(), "manual", MARKER::MANUAL, Marker::LINE_LIST, createMarkerScale(0.1, 0.0, 0.0),
+    createMarkerColor(1.0, 0.0, 0.0, 0.999));
+  marker_array_.markers.at(MARKER::CANDIDATES) = createDefaultMarker(
+    "map", now(), "candidates", MARKER::CANDIDATES, Marker::LINE_LIST,
+    createMarkerScale(0.05, 0.0, 0.0), createMarkerColor(0.0, 0.0, 1.0, 0.999));
+  marker_array_.markers.at(MARKER::INFEASIBLE) = createDefaultMarker(
+    "map", now(), "infeasible", MARKER::INFEASIBLE, Marker::LINE_LIST,
+    createMarkerScale(0.05, 0.0, 0.0), createMarkerColor(0.1, 0.1, 0.1, 0.5));
+  marker_array_.markers.at(MARKER::BEST) = createDefaultMarker(
+    "map", now(), "best", MARKER::BEST, Marker::LINE_STRIP, createMarkerScale(0.2, 0.0, 0.0),
+    createMarkerColor(1.0, 1.0, 1.0, 0.999));
+  marker_array_.markers.at(MARKER::SYSTEM) = createDefaultMarker(
+    "map", now(), "system", MARKER::SYSTEM, Marker::LINE_LIST, createMarkerScale(0.1, 0.0, 0.0),
+    createMarkerColor(1.0, 1.0, 0.0, 0.999));
+
+  pool_ = std::make_unique<WorkerPool>(parameters_->grid_search.thread_num);
+  sampling_cache_ = std::make_unique<SamplingCache>();
+
+  AUTOWARE_PROFILE_INIT(*this);
+
+  if (declare_parameter<bool>("bag_cache.enable")) {
+    bag_cache_directory_ = declare_parameter<std::string>("bag_cache.directory");
+    cache_ = std::make_unique<BagCache>(reader_, analyzed_topics(), bag_cache_directory_);
+    RCLCPP_INFO(
+      get_logger(), "%s bag cache of %zu messages.", cache_->mapped() ? "mapped" : "built",
+      cache_->size());
+  }
 
-  parameters_ = std::make_shared<Parameters>();
-  parameters_->resample_num = declare_parameter<int>("resample_num");
-  parameters_->time_resolution = declare_parameter<double>("time_resolution");
-  parameters_->w0 = declare_parameter<double>("weight.lat_comfortability");
-  parameters_->w1 = declare_parameter<double>("weight.lon_comfortability");
-  parameters_->w2 = declare_parameter<double>("weight.efficiency");
-  parameters_->w3 = declare_parameter<double>("weight.safety");
-  parameters_->grid_search.dt = declare_parameter<double>("grid_search.dt");
-  parameters_->grid_search.min = declare_parameter<double>("grid_search.min");
-  parameters_->grid_search.max = declare_parameter<double>("grid_search.max");
-  parameters_->grid_search.resolution = declare_parameter<double>("grid_search.resolution");
-  parameters_->grid_search.thread_num = declare_parameter<int>("grid_search.thread_num");
-  parameters_->target_state.lat_positions =
-    declare_parameter<std::vector<double>>("target_state.lateral_positions");
-  parameters_->target_state.lat_velocities =
-    declare_parameter<std::vector<double>>("target_state.lateral_velocities");
-  parameters_->target_state.lat_accelerations =
-    declare_parameter<std::vector<double>>("target_state.lateral_accelerations");
-  parameters_->target_state.lon_positions =
-    declare_parameter<std::vector<double>>("target_state.longitudinal_positions");
-  parameters_->target_state.lon_velocities =
-    declare_parameter<std::vector<double>>("target_state.longitudinal_velocities");
-  parameters_->target_state.lon_accelerations =
-    declare_parameter<std::vector<double>>("target_state.longitudinal_accelerations");
+  start_prefetch();
 }
 
-void BehaviorAnalyzerNode::update(const std::shared_ptr<BagData> & bag_data, const double dt) const
+BehaviorAnalyzerNode::~BehaviorAnalyzerNode()
 {
-  rosbag2_storage::StorageFilter filter;
-  filter.topics.emplace_back(TOPIC::TF);
-  filter.topics.emplace_back(TOPIC::ODOMETRY);
-  filter.topics.emplace_back(TOPIC::ACCELERATION);
-  filter.topics.emplace_back(TOPIC::OBJECTS);
-  filter.topics.emplace_back(TOPIC::STEERING);
-  filter.topics.emplace_back(TOPIC::TRAJECTORY);
-  reader_.set_filter(filter);
-
-  bag_data->update(dt * 1e9);
-
-  while (reader_.has_next()) {
-    const auto next_data = reader_.read_next();
-    rclcpp::SerializedMessage serialized_msg(*next_data->serialized_data);
-
-    if (bag_data->ready()) {
-      break;
-    }
+  weight_job_canceled_ = true;
+  if (weight_job_.joinable()) {
+    weight_job_.join();
+  }
+}
 
-    if (next_data->topic_name == TOPIC::TF) {
-      rclcpp::Serialization<TFMessage> serializer;
-      const auto deserialized_message = std::make_shared<TFMessage>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<TFMessage>>(bag_data->buffers.at(TOPIC::TF))
-        ->append(*deserialized_message);
-    }
+void BehaviorAnalyzerNode::JobSource::update(
+  const std::shared_ptr<BagData> & bag_data, const double dt)
+{
+  if (cache) {
+    load_messages(*cache, bag_data, dt);
+  } else {
+    load_messages(reader, bag_data, dt);
+  }
+}
 
-    if (next_data->topic_name == TOPIC::ODOMETRY) {
-      rclcpp::Serialization<Odometry> serializer;
-      const auto deserialized_message = std::make_shared<Odometry>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<Odometry>>(bag_data->buffers.at(TOPIC::ODOMETRY))
-        ->append(*deserialized_message);
-    }
+void BehaviorAnalyzerNode::update(const std::shared_ptr<BagData> & bag_data, const double dt) const
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  if (cache_) {
+    load_messages(*cache_, bag_data, dt);
+  } else {
+    load_messages(reader_, bag_data, dt);
+  }
+}
 
-    if (next_data->topic_name == TOPIC::ACCELERATION) {
-      rclcpp::Serialization<AccelWithCovarianceStamped> serializer;
-      const auto deserialized_message = std::make_shared<AccelWithCovarianceStamped>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<AccelWithCovarianceStamped>>(
-        bag_data->buffers.at(TOPIC::ACCELERATION))
-        ->append(*deserialized_message);
-    }
+void BehaviorAnalyzerNode::seek_to_start() const
+{
+  if (cache_) {
+    cache_->rewind();
+  } else {
+    reader_.seek(0);
+  }
+}
 
-    if (next_data->topic_name == TOPIC::OBJECTS) {
-      rclcpp::Serialization<PredictedObjects> serializer;
-      const auto deserialized_message = std::make_shared<PredictedObjects>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<PredictedObjects>>(bag_data->buffers.at(TOPIC::OBJECTS))
-        ->append(*deserialized_message);
-    }
+bool BehaviorAnalyzerNode::has_next() const
+{
+  return cache_ ? cache_->has_next() : reader_.has_next();
+}
 
-    if (next_data->topic_name == TOPIC::STEERING) {
-      rclcpp::Serialization<SteeringReport> serializer;
-      const auto deserialized_message = std::make_shared<SteeringReport>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<SteeringReport>>(bag_data->buffers.at(TOPIC::STEERING))
-        ->append(*deserialized_message);
-    }
+void BehaviorAnalyzerNode::start_prefetch()
+{
+  const auto bag_data = std::make_shared<BagData>(
+    duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
 
-    if (next_data->topic_name == TOPIC::TRAJECTORY) {
-      rclcpp::Serialization<Trajectory> serializer;
-      const auto deserialized_message = std::make_shared<Trajectory>();
-      serializer.deserialize_message(&serialized_msg, deserialized_message.get());
-      std::dynamic_pointer_cast<Buffer<Trajectory>>(bag_data->buffers.at(TOPIC::TRAJECTORY))
-        ->append(*deserialized_message);
-    }
-  }
+  prefetcher_ = std::make_unique<BagPrefetcher>(
+    bag_data, [this]() { return has_next(); },
+    [this](const std::shared_ptr<BagData> & data) { update(data, 0.1); }, prefetch_window_num_);
 }
 
 void BehaviorAnalyzerNode::play(
@@ -192,11 +235,11 @@ void BehaviorAnalyzerNode::rewind(
   [[maybe_unused]] const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res)
 {
   std::lock_guard<std::mutex> lock(mutex_);
-  reader_.seek(0);
 
-  bag_data_.reset();
-  bag_data_ = std::make_shared<BagData>(
-    duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
+  // The windows read ahead are dropped, and the reader is stopped before the bag is rewound
+  prefetcher_.reset();
+  seek_to_start();
+  start_prefetch();
 
   res->success = true;
 }
@@ -204,37 +247,97 @@ void BehaviorAnalyzerNode::rewind(
 void BehaviorAnalyzerNode::weight(
   [[maybe_unused]] const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res)
 {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::lock_guard<std::mutex> lock(weight_job_mutex_);
+  if (weight_job_running_) {
+    res->success = false;
+    res->message = "weight grid search is running.";
+    return;
+  }
+
+  if (weight_job_.joinable()) {
+    weight_job_.join();
+  }
+
+  weight_job_canceled_ = false;
+  weight_job_running_ = true;
+  weight_job_ = std::thread([this]() {
+    try {
+      weight_search();
+    } catch (const std::exception & e) {
+      RCLCPP_ERROR(get_logger(), "weight grid search failed: %s", e.what());
+    }
+    weight_job_running_ = false;
+  });
+
+  res->success = true;
+  res->message = "started weight grid search.";
+}
+
+void BehaviorAnalyzerNode::cancel_weight(
+  [[maybe_unused]] const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res)
+{
+  weight_job_canceled_ = true;
+  res->success = weight_job_running_;
+  res->message = res->success ? "canceling weight grid search." : "no weight grid search.";
+}
+
+void BehaviorAnalyzerNode::publish_progress(
+  const rosbag2_storage::BagMetadata & metadata, const std::shared_ptr<BagData> & bag_data,
+  const size_t data_set_num) const
+{
+  const auto start = duration_cast<nanoseconds>(metadata.starting_time.time_since_epoch()).count();
+  const auto duration = static_cast<double>(metadata.duration.count());
+
+  Float32MultiArrayStamped msg{};
+  msg.stamp = now();
+  msg.data.push_back(
+    duration > 0.0 ? static_cast<float>((bag_data->timestamp - start) / duration) : 1.0f);
+  msg.data.push_back(static_cast<float>(data_set_num));
+  pub_weight_progress_->publish(msg);
+}
+
+void BehaviorAnalyzerNode::weight_search() const
+{
+  AUTOWARE_PROFILE_FUNCTION();
   RCLCPP_INFO(get_logger(), "start weight grid search.");
 
   const auto & p = parameters_;
 
-  reader_.seek(0);
-  const auto bag_data = std::make_shared<BagData>(
-    duration_cast<nanoseconds>(reader_.get_metadata().starting_time.time_since_epoch()).count());
-
-  std::vector<Result> weight_grid;
-
-  double resolution = p->grid_search.resolution;
-  double min = p->grid_search.min;
-  double max = p->grid_search.max;
-  for (double w0 = min; w0 < max + 0.1 * resolution; w0 += resolution) {
-    for (double w1 = min; w1 < max + 0.1 * resolution; w1 += resolution) {
-      for (double w2 = min; w2 < max + 0.1 * resolution; w2 += resolution) {
-        for (double w3 = min; w3 < max + 0.1 * resolution; w3 += resolution) {
-          weight_grid.emplace_back(w0, w1, w2, w3);
-        }
-      }
-    }
+  // The playback keeps the reader and the pool of the node. A cache file is mapped again, which
+  // shares its pages with the node, and a cache in memory only is not built again for one pass
+  JobSource source;
+  source.reader.open(bag_path_);
+  if (cache_ && !bag_cache_directory_.empty()) {
+    source.cache =
+      std::make_unique<BagCache>(source.reader, analyzed_topics(), bag_cache_directory_);
+  }
+  WorkerPool pool(p->grid_search.thread_num);
+
+  // The metadata is copied before the prefetcher reads the bag on its thread
+  const auto metadata = source.reader.get_metadata();
+
+  // The data sets are evaluated one by one on the pool while the next windows are read, and the
+  // prefetcher stops reading once the search is done or canceled
+  BagPrefetcher prefetcher(
+    std::make_shared<BagData>(
+      duration_cast<nanoseconds>(metadata.starting_time.time_since_epoch()).count()),
+    [&source]() { return source.has_next(); },
+    [&source, &p](const std::shared_ptr<BagData> & data) {
+      source.update(data, p->grid_search.dt);
+    },
+    prefetch_window_num_);
+
+  if (p->grid_search.adaptive) {
+    adaptive_weight(metadata, prefetcher, pool);
+    return;
   }
 
-  const auto show_best_result = [&weight_grid]() {
-    auto sort_by_loss = weight_grid;
-    std::sort(sort_by_loss.begin(), sort_by_loss.end(), [](const auto & a, const auto & b) {
-      return a.loss < b.loss;
-    });
+  auto weight_grid = autoware::behavior_analyzer::weight_grid(p->grid_search);
 
-    const auto best = sort_by_loss.front();
+  const auto show_best_result = [&weight_grid]() {
+    const auto best = *std::min_element(
+      weight_grid.begin(), weight_grid.end(),
+      [](const auto & a, const auto & b) { return a.loss < b.loss; });
 
     std::cout << std::fixed;
     std::cout << std::setprecision(4);
@@ -244,74 +347,108 @@ void BehaviorAnalyzerNode::weight(
 
   autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
 
+  // Each weight tuple is evaluated by one thread per data set, so the losses are written
+  // without locks, and added to the grid once the data set is done
+  std::vector<double> losses(weight_grid.size(), 0.0);
+
+  SamplingCache sampling_cache;
+
+  size_t data_set_num = 0;
+
   stop_watch.tic("total_time");
-  while (reader_.has_next() && rclcpp::ok()) {
-    update(bag_data, p->grid_search.dt);
-
-    if (!bag_data->ready()) break;
-
-    const auto data_set = std::make_shared<DataSet>(bag_data, vehicle_info_, p);
-
-    std::mutex grid_mutex;
-
-    const auto update = [&weight_grid, &grid_mutex](const auto & data_set, const auto idx) {
-      double w0 = 0.0;
-      double w1 = 0.0;
-      double w2 = 0.0;
-      double w3 = 0.0;
-
-      {
-        std::lock_guard<std::mutex> lock(grid_mutex);
-        if (idx + 1 > weight_grid.size()) return;
-        w0 = weight_grid.at(idx).w0;
-        w1 = weight_grid.at(idx).w1;
-        w2 = weight_grid.at(idx).w2;
-        w3 = weight_grid.at(idx).w3;
-      }
-
-      const auto loss = data_set->loss(w0, w1, w2, w3);
-
-      {
-        std::lock_guard<std::mutex> lock(grid_mutex);
-        if (idx < weight_grid.size()) {
-          weight_grid.at(idx).loss += loss;
-        }
-      }
-    };
+  while (rclcpp::ok() && !weight_job_canceled_) {
+    const auto bag_data = prefetcher.next();
 
-    size_t i = 0;
-    while (rclcpp::ok()) {
-      std::vector<std::thread> threads;
-      for (size_t thread_id = 0; thread_id < p->grid_search.thread_num; thread_id++) {
-        threads.emplace_back(update, data_set, i + thread_id);
-      }
+    if (!bag_data) break;
 
-      for (auto & t : threads) t.join();
+    AUTOWARE_PROFILE_SCOPE("evaluate_data_set");
+    const auto data_set =
+      std::make_shared<DataSet>(bag_data, vehicle_info_, p, &pool, &sampling_cache);
 
-      if (i + 1 > weight_grid.size()) break;
+    // A weight tuple costs a few products per trajectory, so the tuples are given to the
+    // threads in batches
+    constexpr size_t batch_size = 256;
+    const auto batch_num = (weight_grid.size() + batch_size - 1) / batch_size;
+
+    pool.run(batch_num, [&weight_grid, &losses, &data_set](const size_t batch) {
+      const auto begin = batch * batch_size;
+      const auto end = std::min(begin + batch_size, weight_grid.size());
+      data_set->loss(weight_grid, begin, end, losses);
+    });
 
-      i += p->grid_search.thread_num;
+    for (size_t idx = 0; idx < weight_grid.size(); idx++) {
+      weight_grid.at(idx).loss += losses.at(idx);
     }
 
     show_best_result();
+    publish_progress(metadata, bag_data, ++data_set_num);
   }
   std::cout << "process time: " << stop_watch.toc("total_time") << "[ms]" << std::endl;
 
+  if (weight_job_canceled_) {
+    RCLCPP_INFO(get_logger(), "cancel weight grid search after %zu data sets.", data_set_num);
+    return;
+  }
+
   RCLCPP_INFO(get_logger(), "finish weight grid search.");
+}
 
-  res->success = true;
+void BehaviorAnalyzerNode::adaptive_weight(
+  const rosbag2_storage::BagMetadata & metadata, BagPrefetcher & prefetcher,
+  WorkerPool & pool) const
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  const auto & p = parameters_;
+
+  autoware::universe_utils::StopWatch<std::chrono::milliseconds> stop_watch;
+  stop_watch.tic("total_time");
+
+  // The bag is read once, and only the loss tables of the data sets are kept for all levels
+  std::vector<LossTable> tables;
+  SamplingCache sampling_cache;
+  while (rclcpp::ok() && !weight_job_canceled_) {
+    const auto bag_data = prefetcher.next();
+
+    if (!bag_data) break;
+
+    AUTOWARE_PROFILE_SCOPE("build_loss_table");
+    tables.push_back(DataSet(bag_data, vehicle_info_, p, &pool, &sampling_cache).loss_table);
+    publish_progress(metadata, bag_data, tables.size());
+  }
+
+  if (weight_job_canceled_) {
+    RCLCPP_INFO(get_logger(), "cancel adaptive weight search after %zu data sets.", tables.size());
+    return;
+  }
+
+  const auto best = [&]() {
+    AUTOWARE_PROFILE_SCOPE("adaptive_weight_search");
+    return adaptive_weight_search(tables, p->grid_search, pool);
+  }();
+
+  std::cout << std::fixed;
+  std::cout << std::setprecision(4);
+  for (const auto & r : best) {
+    std::cout << " [w0]:" << r.w0 << " [w1]:" << r.w1 << " [w2]:" << r.w2 << " [w3]:" << r.w3
+              << " [loss]:" << r.loss << std::endl;
+  }
+  std::cout << "process time: " << stop_watch.toc("total_time") << "[ms]" << std::endl;
+
+  RCLCPP_INFO(get_logger(), "finish adaptive weight search over %zu data sets.", tables.size());
 }
 
 void BehaviorAnalyzerNode::analyze(const std::shared_ptr<BagData> & bag_data) const
 {
   if (!bag_data->ready()) return;
 
-  const auto data_set = std::make_shared<DataSet>(bag_data, vehicle_info_, parameters_);
+  AUTOWARE_PROFILE_FUNCTION();
+  const auto data_set = std::make_shared<DataSet>(
+    bag_data, vehicle_info_, parameters_, pool_.get(), sampling_cache_.get());
 
-  const auto opt_tf = std::dynamic_pointer_cast<Buffer<TFMessage>>(bag_data->buffers.at(TOPIC::TF))
-                        ->get(bag_data->timestamp);
-  if (opt_tf) {
-    pub_tf_->publish(*opt_tf);
+  // Every frame at the timestamp, rather than the frames of the first TF message after it
+  const auto tf = bag_data->transforms.at(bag_data->timestamp);
+  if (!tf.transforms.empty()) {
+    pub_tf_->publish(tf);
   }
 
   const auto opt_objects =
@@ -332,13 +469,18 @@ void BehaviorAnalyzerNode::analyze(const std::shared_ptr<BagData> & bag_data) co
 
   score(data_set);
 
-  visualize(data_set);
+  // The best trajectory is searched once for both the markers and the console
+  const auto & p = parameters_;
+  const auto best = data_set->sampling.best_index(p->w0, p->w1, p->w2, p->w3);
 
-  print(data_set);
+  visualize(data_set, best);
+
+  print(data_set, best);
 }
 
 void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) const
 {
+  AUTOWARE_PROFILE_FUNCTION();
   {
     Float32MultiArrayStamped msg{};
 
@@ -383,6 +525,7 @@ void BehaviorAnalyzerNode::metrics(const std::shared_ptr<DataSet> & data_set) co
 
 void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) const
 {
+  AUTOWARE_PROFILE_FUNCTION();
   {
     Float32MultiArrayStamped msg{};
 
@@ -423,90 +566,98 @@ void BehaviorAnalyzerNode::score(const std::shared_ptr<DataSet> & data_set) cons
   }
 }
 
-void BehaviorAnalyzerNode::visualize(const std::shared_ptr<DataSet> & data_set) const
+void BehaviorAnalyzerNode::visualize(
+  const std::shared_ptr<DataSet> & data_set, const std::optional<size_t> & best) const
 {
-  MarkerArray msg;
+  AUTOWARE_PROFILE_FUNCTION();
+  const auto subscription_num = pub_marker_->get_subscription_count() +
+                                pub_marker_->get_intra_process_subscription_count();
+  if (subscription_num == 0) {
+    return;
+  }
 
-  size_t i = 0;
+  const auto wall_now = std::chrono::steady_clock::now();
+  if (
+    last_visualization_time_.has_value() &&
+    std::chrono::duration<double>(wall_now - last_visualization_time_.value()).count() <
+      visualization_interval_) {
+    return;
+  }
+  last_visualization_time_ = wall_now;
+
+  const auto stamp = now();
+  for (auto & marker : marker_array_.markers) {
+    marker.header.stamp = stamp;
+    marker.points.clear();
+  }
+
+  auto & manual = marker_array_.markers.at(MARKER::MANUAL).points;
   for (const auto & point : data_set->manual.odometry_history) {
-    Marker marker = createDefaultMarker(
-      "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "manual", i++, Marker::ARROW,
-      createMarkerScale(0.7, 0.3, 0.3), createMarkerColor(1.0, 0.0, 0.0, 0.999));
-    marker.pose = point->pose.pose;
-    msg.markers.push_back(marker);
+    add_arrow(point->pose.pose, 0.7, manual);
   }
 
+  auto & candidates = marker_array_.markers.at(MARKER::CANDIDATES).points;
+  auto & infeasible = marker_array_.markers.at(MARKER::INFEASIBLE).points;
   for (const auto & trajectory : data_set->sampling.data) {
-    Marker marker = createDefaultMarker(
-      "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "candidates", i++, Marker::LINE_STRIP,
-      createMarkerScale(0.05, 0.0, 0.0), createMarkerColor(0.0, 0.0, 1.0, 0.999));
-    if (!trajectory.feasible()) {
-      for (const auto & point : trajectory.points) {
-        marker.points.push_back(point.pose.position);
-        marker.colors.push_back(createMarkerColor(0.1, 0.1, 0.1, 0.5));
-      }
-    } else {
-      for (const auto & point : trajectory.points) {
-        marker.points.push_back(point.pose.position);
-        marker.colors.push_back(createMarkerColor(0.0, 0.0, 1.0, 0.999));
-      }
-    }
-    msg.markers.push_back(marker);
+    add_line_list(trajectory.points, trajectory.feasible() ? candidates : infeasible);
   }
 
-  const auto best_trajectory =
-    data_set->sampling.best(parameters_->w0, parameters_->w1, parameters_->w2, parameters_->w3);
-  if (best_trajectory.has_value()) {
-    Marker marker = createDefaultMarker(
-      "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "best", i++, Marker::LINE_STRIP,
-      createMarkerScale(0.2, 0.0, 0.0), createMarkerColor(1.0, 1.0, 1.0, 0.999));
-    for (const auto & point : best_trajectory.value().points) {
-      marker.points.push_back(point.pose.position);
+  if (best.has_value()) {
+    auto & best_points = marker_array_.markers.at(MARKER::BEST).points;
+    for (const auto & point : data_set->sampling.data.at(best.value()).points) {
+      best_points.push_back(point.pose.position);
     }
-    msg.markers.push_back(marker);
   }
 
   const auto autoware_trajectory = data_set->sampling.autoware();
   if (autoware_trajectory.has_value()) {
+    auto & system = marker_array_.markers.at(MARKER::SYSTEM).points;
     for (const auto & point : autoware_trajectory.value().points) {
-      Marker marker = createDefaultMarker(
-        "map", rclcpp::Clock{RCL_ROS_TIME}.now(), "system", i++, Marker::ARROW,
-        createMarkerScale(0.7, 0.3, 0.3), createMarkerColor(1.0, 1.0, 0.0, 0.999));
-      marker.pose = point.pose;
-      msg.markers.push_back(marker);
+      add_arrow(point.pose, 0.7, system);
     }
   }
 
-  pub_marker_->publish(msg);
+  // A marker without points is deleted instead of drawing the one of the previous time step
+  for (auto & marker : marker_array_.markers) {
+    marker.action = marker.points.empty() ? Marker::DELETE : Marker::ADD;
+  }
+
+  pub_marker_->publish(marker_array_);
 }
 
-void BehaviorAnalyzerNode::print(const std::shared_ptr<DataSet> & data_set) const
+void BehaviorAnalyzerNode::print(
+  const std::shared_ptr<DataSet> & data_set, const std::optional<size_t> & best) const
 {
   const auto autoware_trajectory = data_set->sampling.autoware();
   if (!autoware_trajectory.has_value()) {
     return;
   }
 
-  const auto & p = parameters_;
-
-  const auto best_trajectory = data_set->sampling.best(p->w0, p->w1, p->w2, p->w3);
-  if (!best_trajectory.has_value()) {
+  if (!best.has_value()) {
     return;
   }
 
+  const auto & p = parameters_;
+  const auto & best_trajectory = data_set->sampling.data.at(best.value());
+
   std::cout << "---result---" << std::endl;
   std::cout << "[HUMAN] SCORE:" << data_set->manual.total(p->w0, p->w1, p->w2, p->w3) << std::endl;
   std::cout << "[AUTOWARE] SCORE:" << autoware_trajectory.value().total(p->w0, p->w1, p->w2, p->w3)
             << std::endl;
-  std::cout << "[SAMPLING] BEST SCORE:" << best_trajectory.value().total(p->w0, p->w1, p->w2, p->w3)
-            << "(" << best_trajectory.value().tag << ")" << std::endl;
+  std::cout << "[SAMPLING] BEST SCORE:" << best_trajectory.total(p->w0, p->w1, p->w2, p->w3) << "("
+            << best_trajectory.tag << ")" << std::endl;
 }
 
 void BehaviorAnalyzerNode::on_timer()
 {
   std::lock_guard<std::mutex> lock(mutex_);
-  update(bag_data_, 0.1);
-  analyze(bag_data_);
+  AUTOWARE_PROFILE_FUNCTION();
+
+  // Nothing is analyzed once the bag is read through, until it is rewound
+  const auto bag_data = prefetcher_->next();
+  if (bag_data) {
+    analyze(bag_data);
+  }
 }
 }  // namespace autoware::behavior_analyzer
 
@@ -15,9 +15,13 @@
 #ifndef NODE_HPP_
 #define NODE_HPP_
 
+#include "bag_cache.hpp"
+#include "bag_prefetcher.hpp"
 #include "data_structs.hpp"
 #include "rosbag2_cpp/reader.hpp"
+#include "sampling_cache.hpp"
 #include "type_alias.hpp"
+#include "worker_pool.hpp"
 
 #include <autoware/route_handler/route_handler.hpp>
 #include <autoware_vehicle_info_utils/vehicle_info_utils.hpp>
@@ -25,10 +29,14 @@
 #include <rclcpp/rclcpp.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <limits>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -40,26 +48,64 @@ class BehaviorAnalyzerNode : public rclcpp::Node
 public:
   explicit BehaviorAnalyzerNode(const rclcpp::NodeOptions & node_options);
 
+  ~BehaviorAnalyzerNode() override;
+
 private:
+  // The bag of a job, read by a reader of its own so that the playback goes on meanwhile
+  struct JobSource
+  {
+    rosbag2_cpp::Reader reader;
+
+    std::unique_ptr<BagCache> cache;
+
+    bool has_next() { return cache ? cache->has_next() : reader.has_next(); }
+
+    void update(const std::shared_ptr<BagData> & bag_data, const double dt);
+  };
+
   void on_timer();
 
   void play(const SetBool::Request::SharedPtr req, SetBool::Response::SharedPtr res);
 
   void rewind(const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res);
 
+  // Starts the grid search on weight_job_ and returns, unless a search is running
   void weight(const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res);
 
+  void cancel_weight(const Trigger::Request::SharedPtr req, Trigger::Response::SharedPtr res);
+
+  // Runs on weight_job_ without mutex_, and stops between data sets once it is canceled
+  void weight_search() const;
+
+  void adaptive_weight(
+    const rosbag2_storage::BagMetadata & metadata, BagPrefetcher & prefetcher,
+    WorkerPool & pool) const;
+
+  // The ratio of the bag time gone through and the number of data sets so far
+  void publish_progress(
+    const rosbag2_storage::BagMetadata & metadata, const std::shared_ptr<BagData> & bag_data,
+    const size_t data_set_num) const;
+
   void update(const std::shared_ptr<BagData> & bag_data, const double dt) const;
 
+  void seek_to_start() const;
+
+  // Starts reading the playback from the start of the bag
+  void start_prefetch();
+
+  bool has_next() const;
+
   void analyze(const std::shared_ptr<BagData> & bag_data) const;
 
   void metrics(const std::shared_ptr<DataSet> & data_set) const;
 
   void score(const std::shared_ptr<DataSet> & data_set) const;
 
-  void visualize(const std::shared_ptr<DataSet> & data_set) const;
+  // Skipped without subscribers, or if the last one was less than visualization.interval ago
+  void visualize(
+    const std::shared_ptr<DataSet> & data_set, const std::optional<size_t> & best) const;
 
-  void print(const std::shared_ptr<DataSet> & data_set) const;
+  void print(const std::shared_ptr<DataSet> & data_set, const std::optional<size_t> & best) const;
 
   rclcpp::TimerBase::SharedPtr timer_;
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_marker_;
@@ -71,19 +117,53 @@ private:
   rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_system_metrics_;
   rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_manual_score_;
   rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_system_score_;
+  rclcpp::Publisher<Float32MultiArrayStamped>::SharedPtr pub_weight_progress_;
   rclcpp::Service<SetBool>::SharedPtr srv_play_;
   rclcpp::Service<Trigger>::SharedPtr srv_rewind_;
   rclcpp::Service<Trigger>::SharedPtr srv_weight_;
+  rclcpp::Service<Trigger>::SharedPtr srv_cancel_weight_;
 
   vehicle_info_utils::VehicleInfo vehicle_info_;
 
-  std::shared_ptr<BagData> bag_data_;
-
   std::shared_ptr<Parameters> parameters_;
 
+  // Shared by the evaluation of the sampled trajectories and the weight grid search
+  std::unique_ptr<WorkerPool> pool_;
+
+  // Spline of the playback, which goes through the time steps in order
+  std::unique_ptr<SamplingCache> sampling_cache_;
+
+  // Markers of the visualization, whose points keep their capacity between time steps
+  mutable MarkerArray marker_array_;
+
+  mutable std::optional<std::chrono::steady_clock::time_point> last_visualization_time_;
+
+  double visualization_interval_{0.0};
+
   mutable std::mutex mutex_;
 
   mutable rosbag2_cpp::Reader reader_;
+
+  // Replaces the reader after it is built, if bag_cache.enable is true
+  std::unique_ptr<BagCache> cache_;
+
+  std::string bag_path_;
+
+  std::string bag_cache_directory_;
+
+  size_t prefetch_window_num_{1};
+
+  // Reads the playback through reader_ or cache_, so it is destroyed before them
+  std::unique_ptr<BagPrefetcher> prefetcher_;
+
+  // One grid search at a time, since a search already uses all the threads of its pool
+  std::thread weight_job_;
+
+  std::mutex weight_job_mutex_;
+
+  std::atomic<bool> weight_job_running_{false};
+
+  std::atomic<bool> weight_job_canceled_{false};
 };
 }  // namespace autoware::behavior_analyzer
 
@@ -0,0 +1,43 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SAMPLING_CACHE_HPP_
+#define SAMPLING_CACHE_HPP_
+
+#include "autoware_frenet_planner/structures.hpp"
+#include "autoware_sampler_common/transform/spline_transform.hpp"
+#include "type_alias.hpp"
+
+#include <optional>
+
+namespace autoware::behavior_analyzer
+{
+// What the sampling of consecutive time steps has in common. The planning trajectory is published
+// much less often than the analyzer steps, so its spline is rebuilt only when the message changes,
+// and the lattice of the sampling parameters keeps its capacity. A cache is used by one sequence
+// of time steps at a time
+struct SamplingCache
+{
+  // The message of the spline, kept alive so that its address identifies it
+  Trajectory::ConstSharedPtr trajectory;
+
+  std::optional<autoware::sampler_common::transform::Spline2D> path_spline;
+
+  double trajectory_length{0.0};
+
+  autoware::frenet_planner::SamplingParameters sampling_parameters;
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // SAMPLING_CACHE_HPP_
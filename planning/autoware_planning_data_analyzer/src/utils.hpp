@@ -21,6 +21,7 @@
 #include "autoware_path_sampler/prepare_inputs.hpp"
 #include "autoware_path_sampler/utils/trajectory_utils.hpp"
 #include "data_structs.hpp"
+#include "sampling_cache.hpp"
 #include "type_alias.hpp"
 
 #include <algorithm>
@@ -72,34 +73,43 @@ tf2::Vector3 get_velocity_in_world_coordinate(const TrajectoryPoint & point)
 }
 
 double time_to_collision(
-  const PredictedObjects & objects, const Pose & p_ego, const tf2::Vector3 & v_ego)
+  const ObjectStates & objects, const Pose & p_ego, const tf2::Vector3 & v_ego)
 {
-  if (objects.objects.empty()) {
-    return std::numeric_limits<double>::max();
-  }
-
-  std::vector<double> time_to_collisions(objects.objects.size());
-
-  for (const auto & object : objects.objects) {
-    const auto p_object = object.kinematics.initial_pose_with_covariance.pose;
-    const auto v_ego2object =
-      autoware::universe_utils::point2tfVector(p_ego.position, p_object.position);
-
-    const auto v_object = get_velocity_in_world_coordinate(object.kinematics);
-    const auto v_relative = tf2::tf2Dot(v_ego2object.normalized(), v_ego) -
-                            tf2::tf2Dot(v_ego2object.normalized(), v_object);
-
-    time_to_collisions.push_back(v_ego2object.length() / v_relative);
+  const auto object_num = objects.x.size();
+  const auto * x = objects.x.data();
+  const auto * y = objects.y.data();
+  const auto * z = objects.z.data();
+  const auto * vx = objects.vx.data();
+  const auto * vy = objects.vy.data();
+  const auto * vz = objects.vz.data();
+
+  const auto ex = p_ego.position.x;
+  const auto ey = p_ego.position.y;
+  const auto ez = p_ego.position.z;
+  const auto evx = v_ego.x();
+  const auto evy = v_ego.y();
+  const auto evz = v_ego.z();
+
+  // The TTC is distance / (closing speed along the line of sight), i.e. distance^2 / (relative
+  // velocity . line of sight), so no square root is needed. The loop has no branches so that it
+  // is vectorized, and an object that is not approaching drops out by the sign of its TTC
+  auto min_ttc = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < object_num; i++) {
+    const auto dx = x[i] - ex;
+    const auto dy = y[i] - ey;
+    const auto dz = z[i] - ez;
+    const auto closing = dx * (evx - vx[i]) + dy * (evy - vy[i]) + dz * (evz - vz[i]);
+    const auto ttc = (dx * dx + dy * dy + dz * dz) / closing;
+    min_ttc = (ttc >= 1e-3 && ttc < min_ttc) ? ttc : min_ttc;
   }
 
-  const auto itr = std::remove_if(
-    time_to_collisions.begin(), time_to_collisions.end(),
-    [](const auto & value) { return value < 1e-3; });
-  time_to_collisions.erase(itr, time_to_collisions.end());
-
-  std::sort(time_to_collisions.begin(), time_to_collisions.end());
+  return min_ttc;
+}
 
-  return time_to_collisions.front();
+double time_to_collision(
+  const PredictedObjects & objects, const Pose & p_ego, const tf2::Vector3 & v_ego)
+{
+  return time_to_collision(ObjectStates(objects), p_ego, v_ego);
 }
 
 auto convertToTrajectoryPoints(
@@ -141,17 +151,22 @@ auto convertToFrenetPoint(const T & points, const Point & search_point_geom, con
   return frenet_point;
 }
 
-auto prepareSamplingParameters(
+// The parameters are written to sampling_parameters, whose lattice keeps its capacity between calls
+void prepareSamplingParameters(
   const autoware::sampler_common::Configuration & initial_state, const double base_length,
   const autoware::sampler_common::transform::Spline2D & path_spline,
-  [[maybe_unused]] const double trajectory_length, const TargetStateParameters & parameters)
-  -> autoware::frenet_planner::SamplingParameters
+  [[maybe_unused]] const double trajectory_length, const TargetStateParameters & parameters,
+  autoware::frenet_planner::SamplingParameters & sampling_parameters)
 {
-  autoware::frenet_planner::SamplingParameters sampling_parameters;
+  sampling_parameters.parameters.clear();
+  sampling_parameters.parameters.reserve(
+    parameters.lon_accelerations.size() * parameters.lat_positions.size() *
+    parameters.lat_velocities.size() * parameters.lat_accelerations.size());
 
   // calculate target lateral positions
   sampling_parameters.resolution = 0.5;
   const auto max_s = path_spline.lastS();
+  const auto initial_s = path_spline.frenet(initial_state.pose).s;
   autoware::frenet_planner::SamplingParameter p;
   p.target_duration = 10.0;
   for (const auto lon_acceleration : parameters.lon_accelerations) {
@@ -159,7 +174,7 @@ auto prepareSamplingParameters(
     p.target_state.longitudinal_velocity =
       initial_state.velocity + lon_acceleration * p.target_duration;
     p.target_state.position.s = std::min(
-      max_s, path_spline.frenet(initial_state.pose).s +
+      max_s, initial_s +
                std::max(
                  0.0, initial_state.velocity * p.target_duration +
                         0.5 * lon_acceleration * std::pow(p.target_duration, 2.0) - base_length));
@@ -175,7 +190,6 @@ auto prepareSamplingParameters(
     }
     if (p.target_state.position.s == max_s) break;
   }
-  return sampling_parameters;
 }
 
 auto resampling(
@@ -206,13 +220,19 @@ auto resampling(
   return output;
 }
 
+// The spline of the trajectory is taken from cache while the trajectory is the same message
 auto sampling(
-  const Trajectory & trajectory, const Pose & p_ego, const double v_ego, const double a_ego,
-  const vehicle_info_utils::VehicleInfo & vehicle_info,
-  const std::shared_ptr<Parameters> & parameters) -> std::vector<std::vector<TrajectoryPoint>>
+  const Trajectory::ConstSharedPtr & trajectory, const Pose & p_ego, const double v_ego,
+  const double a_ego, const vehicle_info_utils::VehicleInfo & vehicle_info,
+  const std::shared_ptr<Parameters> & parameters, SamplingCache & cache)
+  -> std::vector<std::vector<TrajectoryPoint>>
 {
-  const auto reference_trajectory =
-    autoware::path_sampler::preparePathSpline(trajectory.points, true);
+  if (cache.trajectory != trajectory || !cache.path_spline) {
+    cache.path_spline = autoware::path_sampler::preparePathSpline(trajectory->points, true);
+    cache.trajectory_length = autoware::motion_utils::calcArcLength(trajectory->points);
+    cache.trajectory = trajectory;
+  }
+  const auto & reference_trajectory = *cache.path_spline;
 
   autoware::sampler_common::Configuration current_state;
   current_state.pose = {p_ego.position.x, p_ego.position.y};
@@ -224,12 +244,13 @@ auto sampling(
   current_state.heading = reference_trajectory.yaw(current_state.frenet.s);
   current_state.curvature = reference_trajectory.curvature(current_state.frenet.s);
 
-  const auto trajectory_length = autoware::motion_utils::calcArcLength(trajectory.points);
-  const auto sampling_parameters = prepareSamplingParameters(
-    current_state, 0.0, reference_trajectory, trajectory_length, parameters->target_state);
+  auto & sampling_parameters = cache.sampling_parameters;
+  prepareSamplingParameters(
+    current_state, 0.0, reference_trajectory, cache.trajectory_length, parameters->target_state,
+    sampling_parameters);
 
   autoware::frenet_planner::FrenetState initial_frenet_state;
-  initial_frenet_state.position = reference_trajectory.frenet(current_state.pose);
+  initial_frenet_state.position = current_state.frenet;
   initial_frenet_state.longitudinal_velocity = v_ego;
   initial_frenet_state.longitudinal_acceleration = a_ego;
   const auto s = initial_frenet_state.position.s;
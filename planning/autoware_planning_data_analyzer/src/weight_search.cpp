@@ -0,0 +1,187 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "weight_search.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+using Key = std::array<int64_t, 4>;
+
+// All tuples are on the lattice of grid_search.resolution, and are handled by their indices on it
+struct Lattice
+{
+  double min;
+  double resolution;
+  int64_t size;  // The largest index, the same range as the one of the full grid search
+
+  auto weight(const int64_t index) const -> double { return min + index * resolution; }
+
+  auto index(const double w) const -> int64_t { return std::llround((w - min) / resolution); }
+
+  auto key(const Result & r) const -> Key
+  {
+    return {index(r.w0), index(r.w1), index(r.w2), index(r.w3)};
+  }
+
+  auto result(const Key & k) const -> Result
+  {
+    return Result(weight(k[0]), weight(k[1]), weight(k[2]), weight(k[3]));
+  }
+};
+
+// Every step-th tuple of the lattice
+auto coarse(const Lattice & lattice, const int64_t step) -> std::vector<Result>
+{
+  std::vector<Result> grid;
+  for (int64_t i0 = 0; i0 <= lattice.size; i0 += step) {
+    for (int64_t i1 = 0; i1 <= lattice.size; i1 += step) {
+      for (int64_t i2 = 0; i2 <= lattice.size; i2 += step) {
+        for (int64_t i3 = 0; i3 <= lattice.size; i3 += step) {
+          grid.push_back(lattice.result({i0, i1, i2, i3}));
+        }
+      }
+    }
+  }
+  return grid;
+}
+
+// Tuples at the step within the previous step of the best tuples
+auto refine(
+  const Lattice & lattice, const std::vector<Result> & best, const int64_t previous_step,
+  const int64_t step) -> std::vector<Result>
+{
+  const auto range = (previous_step + step - 1) / step;
+  const auto in_range = [&lattice](const int64_t i) { return i >= 0 && i <= lattice.size; };
+
+  std::set<Key> keys;
+  std::vector<Result> grid;
+  for (const auto & center : best) {
+    const auto c = lattice.key(center);
+    for (int64_t j0 = -range; j0 <= range; j0++) {
+      for (int64_t j1 = -range; j1 <= range; j1++) {
+        for (int64_t j2 = -range; j2 <= range; j2++) {
+          for (int64_t j3 = -range; j3 <= range; j3++) {
+            const Key k{c[0] + j0 * step, c[1] + j1 * step, c[2] + j2 * step, c[3] + j3 * step};
+            if (!std::all_of(k.begin(), k.end(), in_range)) {
+              continue;
+            }
+            if (keys.insert(k).second) {
+              grid.push_back(lattice.result(k));
+            }
+          }
+        }
+      }
+    }
+  }
+  return grid;
+}
+
+// Set the losses of the candidates, or infinity for the ones that cannot be in the top_k
+void evaluate(
+  std::vector<Result> & candidates, const std::vector<LossTable> & tables,
+  const std::vector<Result> & best, const size_t top_k, const double margin, WorkerPool & pool)
+{
+  constexpr auto inf = std::numeric_limits<double>::infinity();
+
+  // The k smallest losses found so far, whose largest bounds the loss of a tuple in the top_k
+  std::priority_queue<double> heap;
+  for (const auto & r : best) heap.push(r.loss);
+
+  std::mutex mutex;
+  std::atomic<double> threshold{heap.size() < top_k ? inf : heap.top()};
+
+  pool.run(candidates.size(), [&](const size_t idx) {
+    auto & candidate = candidates.at(idx);
+    const auto limit = threshold.load(std::memory_order_relaxed) * (1.0 + margin);
+
+    double loss = 0.0;
+    for (const auto & table : tables) {
+      loss += table.loss(candidate.w0, candidate.w1, candidate.w2, candidate.w3);
+      if (loss > limit) {
+        candidate.loss = inf;
+        return;
+      }
+    }
+    candidate.loss = loss;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (heap.size() < top_k || loss < heap.top()) {
+      heap.push(loss);
+      if (heap.size() > top_k) heap.pop();
+      if (heap.size() == top_k) threshold.store(heap.top(), std::memory_order_relaxed);
+    }
+  });
+}
+}  // namespace
+
+auto adaptive_weight_search(
+  const std::vector<LossTable> & tables, const GridSearchParameters & parameters, WorkerPool & pool)
+  -> std::vector<Result>
+{
+  const auto top_k = std::max<size_t>(parameters.top_k, 1);
+  const auto margin = std::max(parameters.prune_margin, 0.0);
+  const auto resolution = parameters.resolution;
+  const Lattice lattice{
+    parameters.min, resolution,
+    static_cast<int64_t>(std::floor((parameters.max - parameters.min) / resolution + 0.1))};
+
+  auto step = std::max<int64_t>(std::llround(parameters.coarse_resolution / resolution), 1);
+  auto candidates = coarse(lattice, step);
+
+  std::vector<Result> best;
+  while (true) {
+    evaluate(candidates, tables, best, top_k, margin, pool);
+
+    // The best tuples of the previous levels are in the candidates again as the cell centers, so
+    // the duplicates are removed by their positions on the lattice
+    for (const auto & candidate : candidates) {
+      if (std::isfinite(candidate.loss)) best.push_back(candidate);
+    }
+    std::stable_sort(best.begin(), best.end(), [](const auto & a, const auto & b) {
+      return a.loss < b.loss;
+    });
+
+    std::set<Key> keys;
+    std::vector<Result> unique_best;
+    for (const auto & r : best) {
+      if (unique_best.size() == top_k) break;
+      if (keys.insert(lattice.key(r)).second) unique_best.push_back(r);
+    }
+    best = unique_best;
+
+    if (best.empty() || step == 1) {
+      break;
+    }
+
+    const auto next_step = std::max<int64_t>(step / 2, 1);
+    candidates = refine(lattice, best, step, next_step);
+    step = next_step;
+  }
+
+  return best;
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,36 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WEIGHT_SEARCH_HPP_
+#define WEIGHT_SEARCH_HPP_
+
+#include "data_structs.hpp"
+#include "worker_pool.hpp"
+
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// Coarse-to-fine search of the weights that minimize the sum of the losses of the tables. The
+// lattice at grid_search.coarse_resolution is evaluated first, and then the neighborhoods of the
+// top_k tuples are evaluated at half the spacing until it reaches grid_search.resolution. A
+// tuple is dropped as soon as its partial loss exceeds the k-th best loss by prune_margin, which
+// is exact for a zero margin since the losses are not negative. Return the top_k tuples sorted by
+// loss
+auto adaptive_weight_search(
+  const std::vector<LossTable> & tables, const GridSearchParameters & parameters, WorkerPool & pool)
+  -> std::vector<Result>;
+}  // namespace autoware::behavior_analyzer
+
+#endif  // WEIGHT_SEARCH_HPP_
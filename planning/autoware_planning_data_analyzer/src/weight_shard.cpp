@@ -0,0 +1,219 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "weight_shard.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+namespace
+{
+constexpr auto format_version = 1;
+
+void expect(std::istream & is, const std::string & key, const std::string & path)
+{
+  std::string token;
+  if (!(is >> token) || token != key) {
+    throw std::runtime_error(path + " is not a weight shard, expected " + key + ".");
+  }
+}
+
+bool same_grid(const WeightShard & a, const WeightShard & b)
+{
+  return a.min == b.min && a.max == b.max && a.resolution == b.resolution &&
+         a.tuple_num == b.tuple_num;
+}
+}  // namespace
+
+auto weight_grid(const GridSearchParameters & parameters) -> std::vector<Result>
+{
+  std::vector<Result> grid;
+
+  const auto resolution = parameters.resolution;
+  const auto min = parameters.min;
+  const auto max = parameters.max;
+  for (double w0 = min; w0 < max + 0.1 * resolution; w0 += resolution) {
+    for (double w1 = min; w1 < max + 0.1 * resolution; w1 += resolution) {
+      for (double w2 = min; w2 < max + 0.1 * resolution; w2 += resolution) {
+        for (double w3 = min; w3 < max + 0.1 * resolution; w3 += resolution) {
+          grid.emplace_back(w0, w1, w2, w3);
+        }
+      }
+    }
+  }
+
+  return grid;
+}
+
+auto shard_range(const size_t tuple_num, const size_t index, const size_t count)
+  -> std::pair<size_t, size_t>
+{
+  if (count == 0 || index >= count) {
+    throw std::invalid_argument("the shard index must be less than the shard count.");
+  }
+
+  return {tuple_num * index / count, tuple_num * (index + 1) / count};
+}
+
+void write_weight_shard(const std::string & path, const WeightShard & shard)
+{
+  std::ofstream os(path);
+  if (!os.is_open()) {
+    throw std::runtime_error("failed to open " + path + ".");
+  }
+
+  // No precision of the losses is lost through the files
+  os.precision(std::numeric_limits<double>::max_digits10);
+
+  os << "weight_shard " << format_version << "\n";
+  os << "grid " << shard.min << " " << shard.max << " " << shard.resolution << " "
+     << shard.tuple_num << "\n";
+  os << "bags " << shard.bags.size() << "\n";
+  for (const auto & bag : shard.bags) {
+    os << bag << "\n";
+  }
+  os << "results " << shard.results.size() << "\n";
+  for (const auto & [index, r] : shard.results) {
+    os << index << " " << r.w0 << " " << r.w1 << " " << r.w2 << " " << r.w3 << " " << r.loss
+       << "\n";
+  }
+
+  if (!os) {
+    throw std::runtime_error("failed to write " + path + ".");
+  }
+}
+
+auto read_weight_shard(const std::string & path) -> WeightShard
+{
+  std::ifstream is(path);
+  if (!is.is_open()) {
+    throw std::runtime_error("failed to open " + path + ".");
+  }
+
+  WeightShard shard;
+
+  int version = 0;
+  expect(is, "weight_shard", path);
+  if (!(is >> version) || version != format_version) {
+    throw std::runtime_error(path + " has an unsupported weight shard version.");
+  }
+
+  expect(is, "grid", path);
+  is >> shard.min >> shard.max >> shard.resolution >> shard.tuple_num;
+
+  size_t bag_num = 0;
+  expect(is, "bags", path);
+  is >> bag_num;
+  is.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+  shard.bags.resize(bag_num);
+  for (auto & bag : shard.bags) {
+    std::getline(is, bag);
+  }
+
+  size_t result_num = 0;
+  expect(is, "results", path);
+  is >> result_num;
+  shard.results.reserve(result_num);
+  for (size_t i = 0; i < result_num && is; i++) {
+    size_t index = 0;
+    double w0 = 0.0, w1 = 0.0, w2 = 0.0, w3 = 0.0, loss = 0.0;
+    is >> index >> w0 >> w1 >> w2 >> w3 >> loss;
+    if (index >= shard.tuple_num) {
+      throw std::runtime_error(path + " has a tuple out of the grid.");
+    }
+    shard.results.emplace_back(index, Result(w0, w1, w2, w3));
+    shard.results.back().second.loss = loss;
+  }
+
+  if (!is) {
+    throw std::runtime_error(path + " is truncated.");
+  }
+
+  return shard;
+}
+
+auto reduce_weight_shards(const std::vector<WeightShard> & shards) -> WeightShard
+{
+  if (shards.empty()) {
+    throw std::runtime_error("no weight shard to reduce.");
+  }
+
+  WeightShard reduced;
+  reduced.min = shards.front().min;
+  reduced.max = shards.front().max;
+  reduced.resolution = shards.front().resolution;
+  reduced.tuple_num = shards.front().tuple_num;
+
+  std::set<std::string> bags;
+  for (const auto & shard : shards) {
+    if (!same_grid(shard, reduced)) {
+      throw std::runtime_error("the weight shards are of different grids.");
+    }
+    bags.insert(shard.bags.begin(), shard.bags.end());
+  }
+  reduced.bags.assign(bags.begin(), bags.end());
+
+  // The shards that evaluated each tuple, and the sums of their losses
+  std::vector<std::vector<size_t>> coverage(reduced.tuple_num);
+  std::vector<std::optional<Result>> results(reduced.tuple_num);
+  for (size_t shard_id = 0; shard_id < shards.size(); shard_id++) {
+    for (const auto & [index, r] : shards.at(shard_id).results) {
+      coverage.at(index).push_back(shard_id);
+      if (!results.at(index).has_value()) {
+        results.at(index) = Result(r.w0, r.w1, r.w2, r.w3);
+      }
+      results.at(index).value().loss += r.loss;
+    }
+  }
+
+  // The tuples evaluated by the same shards are checked once, their bags must be all the bags
+  std::map<std::vector<size_t>, bool> complete;
+  for (size_t index = 0; index < reduced.tuple_num; index++) {
+    if (coverage.at(index).empty()) {
+      continue;
+    }
+
+    auto itr = complete.find(coverage.at(index));
+    if (itr == complete.end()) {
+      std::vector<std::string> covered;
+      for (const auto shard_id : coverage.at(index)) {
+        const auto & shard_bags = shards.at(shard_id).bags;
+        covered.insert(covered.end(), shard_bags.begin(), shard_bags.end());
+      }
+      std::sort(covered.begin(), covered.end());
+      itr = complete.emplace(coverage.at(index), covered == reduced.bags).first;
+    }
+
+    if (!itr->second) {
+      throw std::runtime_error(
+        "the tuple " + std::to_string(index) +
+        " is not evaluated exactly once on every bag of the shards.");
+    }
+
+    reduced.results.emplace_back(index, results.at(index).value());
+  }
+
+  return reduced;
+}
+}  // namespace autoware::behavior_analyzer
@@ -0,0 +1,60 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WEIGHT_SHARD_HPP_
+#define WEIGHT_SHARD_HPP_
+
+#include "data_structs.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// Tuples of the full weight grid search, whose positions are their indices in the shards
+auto weight_grid(const GridSearchParameters & parameters) -> std::vector<Result>;
+
+// First and last + 1 indices of the tuples of the index-th of count equal slices of the grid
+auto shard_range(const size_t tuple_num, const size_t index, const size_t count)
+  -> std::pair<size_t, size_t>;
+
+// Sums of the losses of a slice of the weight grid over a set of bags. The loss is additive over
+// the data sets, so the shards of disjoint sets of bags and of disjoint slices are reduced to the
+// result of the single search over all of them
+struct WeightShard
+{
+  // The grid the indices refer to
+  double min{0.0};
+  double max{0.0};
+  double resolution{0.0};
+  size_t tuple_num{0};
+
+  std::vector<std::string> bags;
+
+  // The tuples of the shard with their indices in the grid, and the losses summed over the bags
+  std::vector<std::pair<size_t, Result>> results;
+};
+
+// Throw std::runtime_error if the file cannot be written or read, or is not a shard
+void write_weight_shard(const std::string & path, const WeightShard & shard);
+
+auto read_weight_shard(const std::string & path) -> WeightShard;
+
+// Add up the losses of the shards by tuple. Throw std::runtime_error if the grids differ, or if
+// some tuple is not evaluated exactly once on every bag of the shards
+auto reduce_weight_shards(const std::vector<WeightShard> & shards) -> WeightShard;
+}  // namespace autoware::behavior_analyzer
+
+#endif  // WEIGHT_SHARD_HPP_
@@ -0,0 +1,136 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef WORKER_POOL_HPP_
+#define WORKER_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace autoware::behavior_analyzer
+{
+// Threads that are created once and process the indices of one job after another. The indices
+// are taken one by one from a shared counter, so that fast threads take over the work of slow ones
+class WorkerPool
+{
+public:
+  explicit WorkerPool(const size_t thread_num)
+  {
+    for (size_t i = 0; i < std::max<size_t>(thread_num, 1); i++) {
+      threads_.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+
+    cv_start_.notify_all();
+
+    for (auto & t : threads_) t.join();
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool & operator=(const WorkerPool &) = delete;
+
+  // Call func for every index in [0, size) and wait for all of them. An exception thrown by func
+  // is rethrown here, after the other indices are processed
+  void run(const size_t size, const std::function<void(const size_t)> & func)
+  {
+    run(size, [&func](const size_t idx, [[maybe_unused]] const size_t worker) { func(idx); });
+  }
+
+  // The same as above, and func is also given the index of the thread in [0, size()) that calls
+  // it, e.g. to use a buffer per thread
+  void run(const size_t size, const std::function<void(const size_t, const size_t)> & func)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    func_ = &func;
+    size_ = size;
+    next_ = 0;
+    busy_num_ = threads_.size();
+    error_ = nullptr;
+    generation_++;
+
+    cv_start_.notify_all();
+    cv_done_.wait(lock, [this] { return busy_num_ == 0; });
+
+    func_ = nullptr;
+
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  size_t size() const { return threads_.size(); }
+
+private:
+  void work(const size_t worker)
+  {
+    size_t generation = 0;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_start_.wait(lock, [this, &generation] { return stop_ || generation_ != generation; });
+
+        if (stop_) return;
+
+        generation = generation_;
+      }
+
+      for (size_t idx = next_++; idx < size_; idx = next_++) {
+        try {
+          (*func_)(idx, worker);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (!error_) error_ = std::current_exception();
+        }
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_num_ == 0) cv_done_.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_start_;
+  std::condition_variable cv_done_;
+
+  const std::function<void(const size_t, const size_t)> * func_{nullptr};
+  size_t size_{0};
+  std::atomic<size_t> next_{0};
+  size_t busy_num_{0};
+  size_t generation_{0};
+  bool stop_{false};
+  std::exception_ptr error_{nullptr};
+};
+}  // namespace autoware::behavior_analyzer
+
+#endif  // WORKER_POOL_HPP_
@@ -0,0 +1,114 @@
+// Copyright 2022 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RTC_REPLAYER__RTC_COMMAND_SCHEDULE_HPP_
+#define RTC_REPLAYER__RTC_COMMAND_SCHEDULE_HPP_
+
+#include "tier4_rtc_msgs/msg/cooperate_command.hpp"
+#include "tier4_rtc_msgs/msg/cooperate_status_array.hpp"
+#include <builtin_interfaces/msg/time.hpp>
+#include <unique_identifier_msgs/msg/uuid.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace autoware::rtc_replayer
+{
+using tier4_rtc_msgs::msg::CooperateCommand;
+using tier4_rtc_msgs::msg::CooperateStatusArray;
+
+using UUIDBytes = std::array<uint8_t, 16>;
+
+// the uuids are random, so the xor of the two halves is already a good hash
+struct UUIDHash
+{
+  size_t operator()(const UUIDBytes & uuid) const
+  {
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    std::memcpy(&lo, uuid.data(), sizeof(lo));
+    std::memcpy(&hi, uuid.data() + sizeof(lo), sizeof(hi));
+    return static_cast<size_t>(lo ^ hi);
+  }
+};
+
+/**
+ * @brief commands sent at once to the rtc interface
+ */
+struct RTCCommandBatch
+{
+  builtin_interfaces::msg::Time stamp;
+  std::vector<CooperateCommand> commands;
+};
+
+/**
+ * @brief find the command changes between the rtc statuses, the same way for the live replay and
+ * for the schedule generation
+ */
+class RTCCommandTracker
+{
+public:
+  /**
+   * @brief return the commands of the statuses whose command changed from the previous statuses
+   * @param [in] msg statuses of the rtc modules
+   * @param [out] stamp stamp of the last changed status, unchanged if there is no change
+   */
+  std::vector<CooperateCommand> update(
+    const CooperateStatusArray & msg, builtin_interfaces::msg::Time & stamp);
+
+private:
+  std::unordered_map<UUIDBytes, uint8_t, UUIDHash> prev_cmd_status_;
+};
+
+/**
+ * @brief build the schedule of the commands from all the rtc statuses of a bag
+ * @param [in] batch_period the commands whose stamps are in the same period are merged into one
+ * batch at the end of the period, and each status message is a batch if it is not positive
+ */
+class RTCCommandScheduleBuilder
+{
+public:
+  explicit RTCCommandScheduleBuilder(const double batch_period) : batch_period_(batch_period) {}
+
+  void addStatuses(const CooperateStatusArray & msg);
+  const std::vector<RTCCommandBatch> & getSchedule() const { return schedule_; }
+
+private:
+  double batch_period_;
+  RTCCommandTracker tracker_;
+  std::vector<RTCCommandBatch> schedule_;
+  int64_t last_bucket_{0};
+};
+
+/**
+ * @brief save the schedule in a compact binary file, which is the magic "RTCSCHD", the version,
+ * the number of batches, and for each batch its stamp, the number of commands and the commands
+ * of 18 bytes (uuid, module type and command type)
+ * @return false if the file cannot be written
+ */
+bool saveSchedule(const std::string & path, const std::vector<RTCCommandBatch> & schedule);
+
+/**
+ * @brief load a schedule saved by saveSchedule
+ * @return false if the file cannot be read or is not a schedule
+ */
+bool loadSchedule(const std::string & path, std::vector<RTCCommandBatch> & schedule);
+
+}  // namespace autoware::rtc_replayer
+
+#endif  // RTC_REPLAYER__RTC_COMMAND_SCHEDULE_HPP_
@@ -16,6 +16,7 @@
 #define RTC_REPLAYER__RTC_REPLAYER_NODE_HPP_
 
 #include "rclcpp/rclcpp.hpp"
+#include "rtc_replayer/rtc_command_schedule.hpp"
 
 #include "tier4_rtc_msgs/msg/command.hpp"
 #include "tier4_rtc_msgs/msg/cooperate_command.hpp"
@@ -25,7 +26,6 @@
 #include "tier4_rtc_msgs/srv/cooperate_commands.hpp"
 #include <unique_identifier_msgs/msg/uuid.hpp>
 
-#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -48,10 +48,20 @@ public:
 
 private:
   void onCooperateStatus(const CooperateStatusArray::ConstSharedPtr msg);
+  void onScheduleTimer();
+  void sendCommands(
+    const builtin_interfaces::msg::Time & stamp, const std::vector<CooperateCommand> & commands);
 
   rclcpp::Subscription<CooperateStatusArray>::SharedPtr sub_statuses_;
   rclcpp::Client<CooperateCommands>::SharedPtr client_rtc_commands_;
-  std::map<std::string, uint8_t> prev_cmd_status_;
+  RTCCommandTracker tracker_;
+
+  // the commands of a schedule generated from a bag, which are sent at their stamps instead of
+  // the commands from the live statuses
+  rclcpp::TimerBase::SharedPtr timer_schedule_;
+  std::vector<RTCCommandBatch> schedule_;
+  size_t next_batch_index_{0};
+  rclcpp::Time prev_schedule_time_;
 };
 
 }  // namespace autoware::rtc_replayer
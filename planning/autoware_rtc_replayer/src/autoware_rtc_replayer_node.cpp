@@ -15,9 +15,13 @@
 #include "rtc_replayer/rtc_replayer_node.hpp"
 
 #include <algorithm>
-#include <iostream>
+#include <chrono>
+#include <iomanip>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace autoware::rtc_replayer
 {
@@ -93,38 +97,77 @@ std::string to_string(const unique_identifier_msgs::msg::UUID & uuid)
 RTCReplayerNode::RTCReplayerNode(const rclcpp::NodeOptions & node_options)
 : Node("rtc_replayer_node", node_options)
 {
-  sub_statuses_ = create_subscription<CooperateStatusArray>(
-    "/debug/rtc_status", 1, std::bind(&RTCReplayerNode::onCooperateStatus, this, _1));
   client_rtc_commands_ = create_client<CooperateCommands>("/api/external/set/rtc_commands");
+
+  const auto schedule_file = declare_parameter<std::string>("schedule_file", "");
+  if (schedule_file.empty()) {
+    // the statuses of the planners in the same container are received without a copy
+    rclcpp::SubscriptionOptions sub_options;
+    sub_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+    sub_statuses_ = create_subscription<CooperateStatusArray>(
+      "/debug/rtc_status", 1, std::bind(&RTCReplayerNode::onCooperateStatus, this, _1),
+      sub_options);
+    return;
+  }
+
+  if (!loadSchedule(schedule_file, schedule_)) {
+    throw std::runtime_error("failed to load the rtc command schedule " + schedule_file);
+  }
+  RCLCPP_INFO(
+    get_logger(), "loaded %zu batches of rtc commands from %s", schedule_.size(),
+    schedule_file.c_str());
+  prev_schedule_time_ = now();
+  timer_schedule_ = rclcpp::create_timer(
+    this, get_clock(), std::chrono::milliseconds(10),
+    std::bind(&RTCReplayerNode::onScheduleTimer, this));
 }
 
 void RTCReplayerNode::onCooperateStatus(const CooperateStatusArray::ConstSharedPtr msg)
 {
   if (msg->statuses.empty()) return;
-  CooperateCommands::Request::SharedPtr request = std::make_shared<CooperateCommands::Request>();
-  for (auto status : msg->statuses) {
-    const auto cmd_status = status.command_status.type;
-    const auto uuid_string = to_string(status.uuid);
-    // add command which has change from previous status and command is already registered
-    if (
-      prev_cmd_status_.find(uuid_string) != prev_cmd_status_.end() &&
-      cmd_status != prev_cmd_status_[uuid_string]) {
-      CooperateCommand cc;
-      // send previous command status
-      cc.command.type = cmd_status;
-      cc.uuid = status.uuid;
-      cc.module = status.module;
-      request->stamp = status.stamp;
-      request->commands.emplace_back(cc);
-      std::cerr << "uuid: " << uuid_string << " module: " << getModuleName(cc.module.type)
-                << " status: " << getModuleStatus(cmd_status) << std::endl;
-    }
-    // post process
-    prev_cmd_status_[uuid_string] = cmd_status;
+  builtin_interfaces::msg::Time stamp;
+  const auto commands = tracker_.update(*msg, stamp);
+  if (!commands.empty()) {
+    sendCommands(stamp, commands);
   }
-  if (!request->commands.empty()) {
-    client_rtc_commands_->async_send_request(request);
+}
+
+void RTCReplayerNode::onScheduleTimer()
+{
+  const auto current_time = now();
+
+  // start over when the time goes back, e.g. the scenario is re-simulated again
+  if (current_time < prev_schedule_time_) {
+    next_batch_index_ = std::distance(
+      schedule_.begin(),
+      std::lower_bound(
+        schedule_.begin(), schedule_.end(), current_time, [](const auto & batch, const auto & t) {
+          return rclcpp::Time(batch.stamp, t.get_clock_type()) < t;
+        }));
+  }
+  prev_schedule_time_ = current_time;
+
+  for (; next_batch_index_ < schedule_.size(); ++next_batch_index_) {
+    const auto & batch = schedule_.at(next_batch_index_);
+    if (rclcpp::Time(batch.stamp, current_time.get_clock_type()) > current_time) {
+      break;
+    }
+    sendCommands(batch.stamp, batch.commands);
+  }
+}
+
+void RTCReplayerNode::sendCommands(
+  const builtin_interfaces::msg::Time & stamp, const std::vector<CooperateCommand> & commands)
+{
+  auto request = std::make_shared<CooperateCommands::Request>();
+  request->stamp = stamp;
+  request->commands = commands;
+  for (const auto & cc : commands) {
+    RCLCPP_DEBUG(
+      get_logger(), "uuid: %s module: %s status: %s", to_string(cc.uuid).c_str(),
+      getModuleName(cc.module.type).c_str(), getModuleStatus(cc.command.type).c_str());
   }
+  client_rtc_commands_->async_send_request(request);
 }
 
 }  // namespace autoware::rtc_replayer
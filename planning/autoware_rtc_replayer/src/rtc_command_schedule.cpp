@@ -0,0 +1,168 @@
+// Copyright 2022 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rtc_replayer/rtc_command_schedule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace autoware::rtc_replayer
+{
+namespace
+{
+constexpr char schedule_magic[8] = "RTCSCHD";
+constexpr uint32_t schedule_version = 1;
+
+template <class T>
+void writeValue(std::ofstream & ofs, const T & value)
+{
+  ofs.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <class T>
+bool readValue(std::ifstream & ifs, T & value)
+{
+  return static_cast<bool>(ifs.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+}  // namespace
+
+std::vector<CooperateCommand> RTCCommandTracker::update(
+  const CooperateStatusArray & msg, builtin_interfaces::msg::Time & stamp)
+{
+  std::vector<CooperateCommand> commands;
+  for (const auto & status : msg.statuses) {
+    const auto cmd_status = status.command_status.type;
+    // add command which has change from previous status and command is already registered
+    const auto [itr, is_new] = prev_cmd_status_.try_emplace(status.uuid.uuid, cmd_status);
+    if (!is_new && itr->second != cmd_status) {
+      CooperateCommand cc;
+      // send previous command status
+      cc.command.type = cmd_status;
+      cc.uuid = status.uuid;
+      cc.module = status.module;
+      stamp = status.stamp;
+      commands.emplace_back(cc);
+    }
+    // post process
+    itr->second = cmd_status;
+  }
+  return commands;
+}
+
+void RTCCommandScheduleBuilder::addStatuses(const CooperateStatusArray & msg)
+{
+  builtin_interfaces::msg::Time stamp;
+  auto commands = tracker_.update(msg, stamp);
+  if (commands.empty()) {
+    return;
+  }
+
+  if (batch_period_ <= 0.0) {
+    schedule_.push_back({stamp, std::move(commands)});
+    return;
+  }
+
+  const double t = stamp.sec + stamp.nanosec * 1e-9;
+  const auto bucket = static_cast<int64_t>(std::floor(t / batch_period_));
+  if (schedule_.empty() || bucket != last_bucket_) {
+    // the batch is sent at the end of the period, so that no command is sent before its status
+    const int64_t bucket_ns =
+      static_cast<int64_t>(std::llround((bucket + 1) * batch_period_ * 1e9));
+    RTCCommandBatch batch;
+    batch.stamp.sec = static_cast<int32_t>(bucket_ns / 1000000000);
+    batch.stamp.nanosec = static_cast<uint32_t>(bucket_ns % 1000000000);
+    schedule_.push_back(batch);
+    last_bucket_ = bucket;
+  }
+
+  // a module changed twice in a period is sent once with its last command
+  auto & batch_commands = schedule_.back().commands;
+  for (auto & command : commands) {
+    const auto itr = std::find_if(
+      batch_commands.begin(), batch_commands.end(),
+      [&](const auto & c) { return c.uuid.uuid == command.uuid.uuid; });
+    if (itr != batch_commands.end()) {
+      *itr = command;
+    } else {
+      batch_commands.push_back(command);
+    }
+  }
+}
+
+bool saveSchedule(const std::string & path, const std::vector<RTCCommandBatch> & schedule)
+{
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs.is_open()) {
+    return false;
+  }
+
+  ofs.write(schedule_magic, sizeof(schedule_magic));
+  writeValue(ofs, schedule_version);
+  writeValue(ofs, static_cast<uint32_t>(schedule.size()));
+  for (const auto & batch : schedule) {
+    writeValue(ofs, batch.stamp.sec);
+    writeValue(ofs, batch.stamp.nanosec);
+    writeValue(ofs, static_cast<uint32_t>(batch.commands.size()));
+    for (const auto & command : batch.commands) {
+      writeValue(ofs, command.uuid.uuid);
+      writeValue(ofs, command.module.type);
+      writeValue(ofs, command.command.type);
+    }
+  }
+  return ofs.good();
+}
+
+bool loadSchedule(const std::string & path, std::vector<RTCCommandBatch> & schedule)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs.is_open()) {
+    return false;
+  }
+
+  char magic[sizeof(schedule_magic)];
+  uint32_t version = 0;
+  uint32_t batch_num = 0;
+  if (
+    !ifs.read(magic, sizeof(magic)) || std::memcmp(magic, schedule_magic, sizeof(magic)) != 0 ||
+    !readValue(ifs, version) || version != schedule_version || !readValue(ifs, batch_num)) {
+    return false;
+  }
+
+  schedule.clear();
+  schedule.reserve(batch_num);
+  for (uint32_t i = 0; i < batch_num; ++i) {
+    RTCCommandBatch batch;
+    uint32_t command_num = 0;
+    if (
+      !readValue(ifs, batch.stamp.sec) || !readValue(ifs, batch.stamp.nanosec) ||
+      !readValue(ifs, command_num)) {
+      return false;
+    }
+    batch.commands.resize(command_num);
+    for (auto & command : batch.commands) {
+      if (
+        !readValue(ifs, command.uuid.uuid) || !readValue(ifs, command.module.type) ||
+        !readValue(ifs, command.command.type)) {
+        return false;
+      }
+    }
+    schedule.push_back(std::move(batch));
+  }
+  return true;
+}
+
+}  // namespace autoware::rtc_replayer
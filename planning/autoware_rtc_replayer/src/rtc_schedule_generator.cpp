@@ -0,0 +1,84 @@
+// Copyright 2022 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "rtc_replayer/rtc_command_schedule.hpp"
+
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/metadata_io.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Generate the schedule of the rtc commands from the rtc statuses of a bag in one pass, so that
+// rtc_replayer can send them at their stamps during a re-simulation
+int main(int argc, char ** argv)
+{
+  using autoware::rtc_replayer::CooperateStatusArray;
+  using autoware::rtc_replayer::RTCCommandScheduleBuilder;
+
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <bag> <output_schedule> [batch_period]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string bag_path = argv[1];
+  const std::string output_path = argv[2];
+  const double batch_period = argc > 3 ? std::stod(argv[3]) : 0.0;
+  const std::string status_topic = "/debug/rtc_status";
+
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_path;
+  rosbag2_storage::MetadataIo metadata_io;
+  storage_options.storage_id = metadata_io.metadata_file_exists(bag_path)
+                                 ? metadata_io.read_metadata(bag_path).storage_identifier
+                                 : "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {status_topic};
+  reader.set_filter(storage_filter);
+
+  RTCCommandScheduleBuilder builder(batch_period);
+  rclcpp::Serialization<CooperateStatusArray> serialization;
+  size_t status_num = 0;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    CooperateStatusArray statuses;
+    serialization.deserialize_message(&msg, &statuses);
+    builder.addStatuses(statuses);
+    ++status_num;
+  }
+
+  const auto & schedule = builder.getSchedule();
+  if (!autoware::rtc_replayer::saveSchedule(output_path, schedule)) {
+    std::cerr << "Failed to write " << output_path << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  size_t command_num = 0;
+  for (const auto & batch : schedule) {
+    command_num += batch.commands.size();
+  }
+  std::cout << "Read " << status_num << " status messages, and wrote " << command_num
+            << " commands in " << schedule.size() << " batches to " << output_path << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -14,53 +14,106 @@
 
 #include "centerline_source/bag_ego_trajectory_based_centerline.hpp"
 
+#include "autoware/bag_index/cdr_view.hpp"
 #include "rclcpp/serialization.hpp"
 #include "rosbag2_cpp/reader.hpp"
 #include "static_centerline_generator_node.hpp"
 
 #include <nav_msgs/msg/odometry.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace autoware::static_centerline_generator
 {
+namespace
+{
+struct OdometryPosition
+{
+  double stamp;  // [s]
+  geometry_msgs::msg::Point position;
+};
+
+// Read the stamp and the position of nav_msgs::msg::Odometry in place from the CDR buffer, which
+// skips deserializing the frame ids, the covariances and the twist.
+std::optional<OdometryPosition> read_odometry_position(const rcutils_uint8_array_t & buffer)
+{
+  const auto odometry = autoware::bag_index::cdr::OdometryView::parse(buffer);
+  if (!odometry) {
+    return std::nullopt;
+  }
+  return OdometryPosition{
+    odometry->header.stamp.sec + odometry->header.stamp.nanosec * 1e-9, odometry->position()};
+}
+}  // namespace
+
 std::vector<TrajectoryPoint> generate_centerline_with_bag(rclcpp::Node & node)
 {
   const auto bag_filename = node.declare_parameter<std::string>("bag_filename");
+  const auto start_time = node.declare_parameter<double>("bag_ego_trajectory.start_time");
+  const auto end_time = node.declare_parameter<double>("bag_ego_trajectory.end_time");
+  const auto decimation = std::max(node.declare_parameter<int>("bag_ego_trajectory.decimation"), 1);
 
   // open rosbag
   rosbag2_cpp::Reader bag_reader;
   bag_reader.open(bag_filename);
 
+  rosbag2_storage::StorageFilter filter;
+  filter.topics.emplace_back("/localization/kinematic_state");
+  bag_reader.set_filter(filter);
+
+  // NOTE: The time range is compared with the stamps of the odometry, which are not later than the
+  //       time they are recorded, so seeking to the start time does not skip any of them.
+  const double bag_start_time =
+    std::chrono::duration<double>(bag_reader.get_metadata().starting_time.time_since_epoch())
+      .count();
+  if (0.0 < start_time) {
+    bag_reader.seek(static_cast<rcutils_time_point_value_t>((bag_start_time + start_time) * 1e9));
+  }
+
   // extract 2D position of ego's trajectory from rosbag
   rclcpp::Serialization<nav_msgs::msg::Odometry> bag_serialization;
   std::vector<TrajectoryPoint> centerline_traj_points;
-  while (bag_reader.has_next()) {
+  for (int msg_idx = 0; bag_reader.has_next(); ++msg_idx) {
     const rosbag2_storage::SerializedBagMessageSharedPtr msg = bag_reader.read_next();
 
-    if (msg->topic_name != "/localization/kinematic_state") {
-      continue;
-    }
+    const auto odometry_position = [&]() {
+      const auto read_position = read_odometry_position(*msg->serialized_data);
+      if (read_position) {
+        return *read_position;
+      }
 
-    rclcpp::SerializedMessage serialized_msg(*msg->serialized_data);
-    const auto ros_msg = std::make_shared<nav_msgs::msg::Odometry>();
+      rclcpp::SerializedMessage serialized_msg(*msg->serialized_data);
+      const auto ros_msg = std::make_shared<nav_msgs::msg::Odometry>();
+      bag_serialization.deserialize_message(&serialized_msg, ros_msg.get());
+      return OdometryPosition{
+        rclcpp::Time(ros_msg->header.stamp).seconds(), ros_msg->pose.pose.position};
+    }();
 
-    bag_serialization.deserialize_message(&serialized_msg, ros_msg.get());
+    const double time_from_start = odometry_position.stamp - bag_start_time;
+    if (0.0 <= end_time && end_time < time_from_start) {
+      break;
+    }
+    if (time_from_start < start_time || msg_idx % decimation != 0) {
+      continue;
+    }
 
     if (!centerline_traj_points.empty()) {
       constexpr double epsilon = 1e-1;
       if (
-        std::abs(centerline_traj_points.back().pose.position.x - ros_msg->pose.pose.position.x) <
+        std::abs(centerline_traj_points.back().pose.position.x - odometry_position.position.x) <
           epsilon &&
-        std::abs(centerline_traj_points.back().pose.position.y - ros_msg->pose.pose.position.y) <
+        std::abs(centerline_traj_points.back().pose.position.y - odometry_position.position.y) <
           epsilon) {
         continue;
       }
     }
     TrajectoryPoint centerline_traj_point;
-    centerline_traj_point.pose.position = ros_msg->pose.pose.position;
+    centerline_traj_point.pose.position = odometry_position.position;
     centerline_traj_points.push_back(centerline_traj_point);
   }
 
@@ -27,8 +27,11 @@
 #include "utils.hpp"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <utility>
@@ -79,6 +82,49 @@ std_msgs::msg::Header create_header(const rclcpp::Time & now)
   header.stamp = now;
   return header;
 }
+
+// FNV-1a
+void hash_bytes(uint64_t & hash, const void * data, const size_t size)
+{
+  const auto * bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+void hash_pose(uint64_t & hash, const Pose & pose)
+{
+  const std::array<double, 7> values{pose.position.x,    pose.position.y,    pose.position.z,
+                                     pose.orientation.x, pose.orientation.y, pose.orientation.z,
+                                     pose.orientation.w};
+  hash_bytes(hash, values.data(), sizeof(values));
+}
+
+std::vector<OptimizationCache::Segment> split_into_segments(
+  const PathWithLaneId & path_with_lane_id, const Pose & goal_pose)
+{
+  std::vector<OptimizationCache::Segment> segments;
+  const auto & points = path_with_lane_id.points;
+  for (size_t i = 0; i < points.size(); ++i) {
+    const auto & lane_ids = points.at(i).lane_ids;
+    if (i == 0 || lane_ids != points.at(i - 1).lane_ids) {
+      segments.push_back(OptimizationCache::Segment{i, 14695981039346656037ULL});
+      hash_bytes(segments.back().hash, lane_ids.data(), lane_ids.size() * sizeof(lane_ids.front()));
+    }
+    hash_pose(segments.back().hash, points.at(i).point.pose);
+    hash_bytes(
+      segments.back().hash, &points.at(i).point.longitudinal_velocity_mps,
+      sizeof(points.at(i).point.longitudinal_velocity_mps));
+  }
+
+  // NOTE: The goal connection changes the path close to the goal.
+  if (!segments.empty()) {
+    hash_pose(segments.back().hash, goal_pose);
+  }
+
+  return segments;
+}
 }  // namespace
 
 OptimizationTrajectoryBasedCenterline::OptimizationTrajectoryBasedCenterline(rclcpp::Node & node)
@@ -110,6 +156,10 @@ OptimizationTrajectoryBasedCenterline::generate_centerline_with_optimization(
   const double behavior_vel_interval =
     autoware::universe_utils::getOrDeclareParameter<double>(node, "behavior_output_path_interval");
 
+  // NOTE: The path generator is created again since the route is registered only when it is
+  //       created.
+  path_generator_node_ = nullptr;
+
   // update route_handler for the behavior_path_planner
   const auto route_lanelets = utils::get_lanelets_from_route(*route_handler_ptr, route);
   route_handler_ptr->setRoute(route);
@@ -135,9 +185,55 @@ OptimizationTrajectoryBasedCenterline::generate_centerline_with_optimization(
   pub_raw_path_->publish(raw_path);
   RCLCPP_INFO(node.get_logger(), "Converted to path and published.");
 
+  // find the first point of the raw path changed from the last route
+  const bool enable_cache =
+    autoware::universe_utils::getOrDeclareParameter<bool>(node, "optimization.cache.enable");
+  const int invalidated_points_num = autoware::universe_utils::getOrDeclareParameter<int>(
+    node, "optimization.cache.invalidated_points_num");
+
+  const int points_num = static_cast<int>(raw_path_with_lane_id.points.size());
+  const auto segments = split_into_segments(raw_path_with_lane_id, route.goal_pose);
+  const int changed_idx = [&]() {
+    if (
+      !enable_cache || segments.empty() || optimization_cache_.map_bin_ptr != map_bin_ptr ||
+      optimization_cache_.optimized_traj_points.empty()) {
+      return 0;
+    }
+    const auto & cached_segments = optimization_cache_.segments;
+    for (size_t i = 0; i < segments.size(); ++i) {
+      if (
+        cached_segments.size() <= i ||
+        segments.at(i).begin_idx != cached_segments.at(i).begin_idx ||
+        segments.at(i).hash != cached_segments.at(i).hash) {
+        return static_cast<int>(segments.at(i).begin_idx);
+      }
+    }
+    return segments.size() == cached_segments.size() ? points_num : 0;
+  }();
+
   // smooth trajectory and road collision avoidance
-  const auto optimized_traj_points =
-    optimize_trajectory(node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route);
+  // NOTE: The optimization at a virtual ego pose looks ahead, so the trajectory is optimized again
+  //       from invalidated_points_num points before the first changed point.
+  std::vector<TrajectoryPoint> optimized_traj_points;
+  bool is_optimization_succeeded = true;
+  if (changed_idx == points_num) {
+    optimized_traj_points = optimization_cache_.optimized_traj_points;
+    RCLCPP_INFO(node.get_logger(), "Reused the optimized trajectory of the same path.");
+  } else {
+    const int begin_idx = std::max(changed_idx - std::max(invalidated_points_num, 0), 0);
+    if (0 < begin_idx) {
+      optimized_traj_points = optimization_cache_.optimized_traj_points;
+      RCLCPP_INFO(
+        node.get_logger(), "Reused the optimized trajectory until the point %d of %d.", begin_idx,
+        points_num);
+    }
+    is_optimization_succeeded = optimize_trajectory(
+      node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route, begin_idx,
+      optimized_traj_points);
+  }
+  if (enable_cache && is_optimization_succeeded) {
+    optimization_cache_ = OptimizationCache{map_bin_ptr, segments, optimized_traj_points};
+  }
   RCLCPP_INFO(
     node.get_logger(),
     "Smoothed trajectory and made it collision free with the road and published.");
@@ -145,15 +241,112 @@ OptimizationTrajectoryBasedCenterline::generate_centerline_with_optimization(
   return optimized_traj_points;
 }
 
-std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_trajectory(
+bool OptimizationTrajectoryBasedCenterline::optimize_trajectory(
   rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
   std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
-  const LaneletRoute & route) const
+  const LaneletRoute & route, const int begin_idx,
+  std::vector<TrajectoryPoint> & whole_optimized_traj_points) const
 {
+  const int window_num = autoware::universe_utils::getOrDeclareParameter<int>(
+    node, "optimization.window_num");
+  const int window_overlap_points_num = autoware::universe_utils::getOrDeclareParameter<int>(
+    node, "optimization.window_overlap_points_num");
+  const bool publish_iterative_trajectory = autoware::universe_utils::getOrDeclareParameter<bool>(
+    node, "debug.publish_iterative_trajectory");
   const int wait_time_during_planning_iteration =
     autoware::universe_utils::getOrDeclareParameter<int>(
       node, "debug.wait_time_during_planning_iteration");
 
+  const int points_num = static_cast<int>(raw_path_with_lane_id.points.size());
+  const int valid_window_num = std::clamp(window_num, 1, std::max(points_num - begin_idx, 1));
+
+  // NOTE: The goal connection is calculated by a planner shared with all the windows.
+  std::mutex goal_connection_mutex;
+
+  bool is_succeeded = true;
+  if (valid_window_num == 1 && begin_idx == 0) {
+    is_succeeded = optimize_trajectory_in_window(
+      node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route, 0, points_num,
+      publish_iterative_trajectory, wait_time_during_planning_iteration, goal_connection_mutex,
+      whole_optimized_traj_points);
+  } else {
+    // The virtual ego poses are split into windows optimized in parallel. Each window starts
+    // window_overlap_points_num points before its range so that the warm start of the
+    // optimization is stable in the range.
+    const auto get_window_begin_idx = [&](const int window_idx) {
+      return begin_idx + (points_num - begin_idx) * window_idx / valid_window_num;
+    };
+    std::vector<std::vector<TrajectoryPoint>> window_traj_points(valid_window_num);
+    std::vector<char> is_window_succeeded(valid_window_num, false);
+    const auto optimize_window = [&](const int window_idx) {
+      const int begin_idx =
+        std::max(get_window_begin_idx(window_idx) - std::max(window_overlap_points_num, 0), 0);
+      is_window_succeeded.at(window_idx) = optimize_trajectory_in_window(
+        node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route, begin_idx,
+        get_window_begin_idx(window_idx + 1), publish_iterative_trajectory,
+        wait_time_during_planning_iteration, goal_connection_mutex,
+        window_traj_points.at(window_idx));
+    };
+
+    std::vector<std::thread> threads;
+    for (int window_idx = 1; window_idx < valid_window_num; ++window_idx) {
+      threads.emplace_back(optimize_window, window_idx);
+    }
+    optimize_window(0);
+    for (auto & thread : threads) {
+      thread.join();
+    }
+
+    // stitch the windows at the first virtual ego pose of each window
+    for (int window_idx = 0; window_idx < valid_window_num; ++window_idx) {
+      const auto & traj_points = window_traj_points.at(window_idx);
+      if (traj_points.empty()) {
+        is_succeeded = false;
+        break;
+      }
+
+      const auto & stitch_pose =
+        raw_path_with_lane_id.points.at(get_window_begin_idx(window_idx)).point.pose;
+      if (!whole_optimized_traj_points.empty()) {
+        const size_t nearest_segment_idx =
+          autoware::motion_utils::findFirstNearestSegmentIndexWithSoftConstraints(
+            whole_optimized_traj_points, stitch_pose, 1.0, 0.35);
+        whole_optimized_traj_points.resize(nearest_segment_idx + 1);
+      }
+      const size_t nearest_idx = autoware::motion_utils::findFirstNearestIndexWithSoftConstraints(
+        traj_points, stitch_pose, 1.0, 0.35);
+      whole_optimized_traj_points.insert(
+        whole_optimized_traj_points.end(), traj_points.begin() + nearest_idx, traj_points.end());
+
+      // the windows after a failed one are not connected to the optimized trajectory
+      if (!is_window_succeeded.at(window_idx)) {
+        is_succeeded = false;
+        break;
+      }
+    }
+  }
+
+  // remove the visualization of iterative trajectories
+  Trajectory empty_traj;
+  empty_traj.header = create_header(node.get_clock()->now());
+  pub_iterative_smoothed_traj_->publish(empty_traj);
+  pub_iterative_optimized_traj_->publish(empty_traj);
+
+  Path empty_path;
+  empty_path.header = create_header(node.get_clock()->now());
+  pub_iterative_path_->publish(empty_path);
+
+  return is_succeeded;
+}
+
+bool OptimizationTrajectoryBasedCenterline::optimize_trajectory_in_window(
+  rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
+  std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
+  const LaneletRoute & route, const int begin_idx, const int end_idx,
+  const bool publish_iterative_trajectory, const int wait_time_during_planning_iteration,
+  std::mutex & goal_connection_mutex,
+  std::vector<TrajectoryPoint> & whole_optimized_traj_points) const
+{
   // create an instance of elastic band and model predictive trajectory.
   const auto eb_path_smoother_ptr =
     autoware::path_smoother::ElasticBandSmoother(create_node_options()).getElasticBandSmoother();
@@ -169,18 +362,22 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
 
   // move the virtual_ego_pose forward following the raw_path_with_lane_id every cycle
   // and plan an optimized trajectory
-  std::vector<TrajectoryPoint> whole_optimized_traj_points;
-  for (int virtual_ego_pose_idx = num_initial_optimization;
-       virtual_ego_pose_idx < static_cast<int>(raw_path_with_lane_id.points.size());
+  whole_optimized_traj_points.clear();
+  for (int virtual_ego_pose_idx = begin_idx + num_initial_optimization;
+       virtual_ego_pose_idx < end_idx;
        virtual_ego_pose_idx += virtual_ego_pose_lon_shift_points_num) {
     // calculate virtual ego pose for the optimization
     const auto virtual_ego_pose =
-      raw_path_with_lane_id.points.at(static_cast<size_t>(std::max(virtual_ego_pose_idx, 0)))
+      raw_path_with_lane_id.points
+        .at(static_cast<size_t>(std::max(virtual_ego_pose_idx, begin_idx)))
         .point.pose;
 
     // create path_with_lane_id by goal_method
-    const auto path_with_lane_id_with_goal_connection = modify_goal_connection(
-      node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route, virtual_ego_pose);
+    const auto path_with_lane_id_with_goal_connection = [&]() {
+      std::lock_guard<std::mutex> lock(goal_connection_mutex);
+      return modify_goal_connection(
+        node, raw_path_with_lane_id, route_handler_ptr, map_bin_ptr, route, virtual_ego_pose);
+    }();
     if (path_with_lane_id_with_goal_connection.points.empty()) {
       continue;
     }
@@ -188,9 +385,11 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
     // NOTE: path_with_lane_id is not used for the visualization since the
     // tier4_planning_rviz_plugin
     //       has an issue to die.
-    auto path = convert_to_path(path_with_lane_id_with_goal_connection);
-    path.header = create_header(node.get_clock()->now());
-    pub_iterative_path_->publish(path);
+    if (publish_iterative_trajectory) {
+      auto path = convert_to_path(path_with_lane_id_with_goal_connection);
+      path.header = create_header(node.get_clock()->now());
+      pub_iterative_path_->publish(path);
+    }
 
     // convert trajectory
     const auto traj_points = convert_to_trajectory_points(path_with_lane_id_with_goal_connection);
@@ -198,9 +397,11 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
     // smooth trajectory by elastic band in the autoware_path_smoother package
     const auto smoothed_traj_points =
       eb_path_smoother_ptr->smoothTrajectory(traj_points, virtual_ego_pose);
-    pub_iterative_smoothed_traj_->publish(
-      autoware::motion_utils::convertToTrajectory(
-        smoothed_traj_points, create_header(node.get_clock()->now())));
+    if (publish_iterative_trajectory) {
+      pub_iterative_smoothed_traj_->publish(
+        autoware::motion_utils::convertToTrajectory(
+          smoothed_traj_points, create_header(node.get_clock()->now())));
+    }
 
     // road collision avoidance by model predictive trajectory in the autoware_path_optimizer
     // package
@@ -209,18 +410,20 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
       raw_path_with_lane_id.right_bound, virtual_ego_pose};
     const auto optimized_traj_points = mpt_optimizer_ptr->optimizeTrajectory(planner_data);
     if (!optimized_traj_points) {
-      return whole_optimized_traj_points;
+      return false;
+    }
+    if (publish_iterative_trajectory) {
+      pub_iterative_optimized_traj_->publish(
+        autoware::motion_utils::convertToTrajectory(
+          *optimized_traj_points, create_header(node.get_clock()->now())));
     }
-    pub_iterative_optimized_traj_->publish(
-      autoware::motion_utils::convertToTrajectory(
-        *optimized_traj_points, create_header(node.get_clock()->now())));
 
     // connect the previously and currently optimized trajectory points
     // 1. generate valid_optimized_traj_points
     // NOTE: We assume that the trajectory before the ego pose is not valid
     //       since it tens to be inner curve due to the bug
     const auto valid_optimized_traj_points = [&]() {
-      if (virtual_ego_pose_idx <= 0) {
+      if (virtual_ego_pose_idx <= begin_idx) {
         return *optimized_traj_points;
       }
       const size_t nearest_idx = autoware::motion_utils::findFirstNearestIndexWithSoftConstraints(
@@ -228,7 +431,6 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
       return std::vector<TrajectoryPoint>(
         optimized_traj_points->begin() + nearest_idx, optimized_traj_points->end());
     }();
-
     // 2. fill whole_optimized_traj_points if it is empty.
     if (whole_optimized_traj_points.empty()) {
       whole_optimized_traj_points = valid_optimized_traj_points;
@@ -260,22 +462,15 @@ std::vector<TrajectoryPoint> OptimizationTrajectoryBasedCenterline::optimize_tra
     }
 
     // wait for debugging purpose to visualize the iteration.
-    if (1e-5 < static_cast<double>(wait_time_during_planning_iteration)) {
+    if (
+      publish_iterative_trajectory &&
+      1e-5 < static_cast<double>(wait_time_during_planning_iteration)) {
       std::this_thread::sleep_for(std::chrono::milliseconds(wait_time_during_planning_iteration));
     }
   }
 
-  // remove the visualization of iterative trajectories
-  Trajectory empty_traj;
-  empty_traj.header = create_header(node.get_clock()->now());
-  pub_iterative_smoothed_traj_->publish(empty_traj);
-  pub_iterative_optimized_traj_->publish(empty_traj);
-
-  Path empty_path;
-  empty_path.header = create_header(node.get_clock()->now());
-  pub_iterative_path_->publish(empty_path);
 
-  return whole_optimized_traj_points;
+  return true;
 }
 
 std::shared_ptr<autoware_planning_msgs::msg::LaneletRoute>
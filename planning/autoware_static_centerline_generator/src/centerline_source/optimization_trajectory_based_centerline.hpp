@@ -23,13 +23,32 @@
 #include "rclcpp/rclcpp.hpp"
 #include "type_alias.hpp"
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace autoware::static_centerline_generator
 {
+// Optimized trajectory of the last route. The raw path is split into segments of the same lane
+// ids, and the segments of the next route are compared with them so that only the trajectory
+// after the first changed segment is optimized again.
+struct OptimizationCache
+{
+  struct Segment
+  {
+    size_t begin_idx{0};
+    // hash of the lane ids and the poses of the points, and of the goal pose for the last segment
+    uint64_t hash{0};
+  };
+
+  LaneletMapBin::ConstSharedPtr map_bin_ptr{nullptr};
+  std::vector<Segment> segments;
+  std::vector<TrajectoryPoint> optimized_traj_points;
+};
+
 class OptimizationTrajectoryBasedCenterline
 {
 public:
@@ -40,10 +59,23 @@ public:
     LaneletMapBin::ConstSharedPtr & map_bin_ptr, const LaneletRoute & route);
 
 private:
-  std::vector<TrajectoryPoint> optimize_trajectory(
+  // Optimize the trajectory with the virtual ego poses from begin_idx of the raw path, and connect
+  // it to whole_optimized_traj_points optimized before begin_idx. Return false if the optimization
+  // fails, where the trajectory is optimized until the failure.
+  bool optimize_trajectory(
     rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
     std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
-    const LaneletRoute & route) const;
+    const LaneletRoute & route, const int begin_idx,
+    std::vector<TrajectoryPoint> & whole_optimized_traj_points) const;
+  // Optimize the trajectory with the virtual ego poses in [begin_idx, end_idx) of the raw path.
+  // Return false if the optimization fails, where the trajectory is optimized until the failure.
+  bool optimize_trajectory_in_window(
+    rclcpp::Node & node, const PathWithLaneId & raw_path_with_lane_id,
+    std::shared_ptr<RouteHandler> & route_handler_ptr, LaneletMapBin::ConstSharedPtr & map_bin_ptr,
+    const LaneletRoute & route, const int begin_idx, const int end_idx,
+    const bool publish_iterative_trajectory, const int wait_time_during_planning_iteration,
+    std::mutex & goal_connection_mutex,
+    std::vector<TrajectoryPoint> & whole_optimized_traj_points) const;
 
   // publisher
   rclcpp::Publisher<PathWithLaneId>::SharedPtr pub_raw_path_with_lane_id_{nullptr};
@@ -73,6 +105,8 @@ private:
     const LaneletRoute & route, const Pose & current_pose) const;
 
   mutable std::shared_ptr<autoware::path_generator::PathGenerator> path_generator_node_;
+
+  OptimizationCache optimization_cache_;
 };
 }  // namespace autoware::static_centerline_generator
 // clang-format off
@@ -40,6 +40,12 @@ int main(int argc, char * argv[])
       node->save_map();
     } else if (mode == "GUI") {
       node->generate_centerline();
+    } else if (mode == "BATCH") {
+      node->generate_centerlines_in_batch();
+    } else if (mode == "COMPARE") {
+      node->compare_centerline_sources();
+    } else if (mode == "MAP_VALIDATION") {
+      node->validate_map_centerlines();
     } else if (mode == "VMB") {
       // Do nothing
     } else {
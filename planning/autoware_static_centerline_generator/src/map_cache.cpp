@@ -0,0 +1,192 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "map_cache.hpp"
+
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+namespace autoware::static_centerline_generator
+{
+namespace
+{
+// NOTE: The magic with the format version is also a part of the key so that the maps saved in
+//       another format are not used.
+constexpr char map_cache_magic[8] = "SCGMAP1";
+
+template <typename T>
+void write_message(std::ofstream & file, const T & msg)
+{
+  rclcpp::Serialization<T> serialization;
+  rclcpp::SerializedMessage serialized_msg;
+  serialization.serialize_message(&msg, &serialized_msg);
+
+  const uint64_t size = serialized_msg.size();
+  file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+  file.write(
+    reinterpret_cast<const char *>(serialized_msg.get_rcl_serialized_message().buffer), size);
+}
+
+template <typename T>
+bool read_message(std::ifstream & file, const uint64_t file_size, T & msg)
+{
+  uint64_t size;
+  if (!file.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+    return false;
+  }
+  if (file_size - static_cast<uint64_t>(file.tellg()) < size) {
+    return false;
+  }
+
+  rclcpp::SerializedMessage serialized_msg(size);
+  auto & rcl_serialized_msg = serialized_msg.get_rcl_serialized_message();
+  if (!file.read(reinterpret_cast<char *>(rcl_serialized_msg.buffer), size)) {
+    return false;
+  }
+  rcl_serialized_msg.buffer_length = size;
+
+  rclcpp::Serialization<T> serialization;
+  serialization.deserialize_message(&serialized_msg, &msg);
+  return true;
+}
+}  // namespace
+
+MapCache::MapCache(const std::string & directory, const size_t max_memory_entry_num)
+: directory_(directory), max_memory_entry_num_(max_memory_entry_num)
+{
+  std::filesystem::create_directories(directory_);
+}
+
+std::string MapCache::get_key(const std::string & lanelet2_file_path)
+{
+  std::ifstream file(lanelet2_file_path, std::ios::binary);
+  const std::string content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : std::string(map_cache_magic) + content) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  std::stringstream ss;
+  ss << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+std::shared_ptr<CachedMap> MapCache::find(const std::string & key)
+{
+  for (auto itr = memory_entries_.begin(); itr != memory_entries_.end(); ++itr) {
+    if (itr->first == key) {
+      memory_entries_.splice(memory_entries_.begin(), memory_entries_, itr);
+      return itr->second;
+    }
+  }
+
+  const auto cached_map = load(key);
+  if (!cached_map) {
+    return nullptr;
+  }
+
+  cached_map->route_handler_ptr = std::make_shared<RouteHandler>();
+  cached_map->route_handler_ptr->setMap(*cached_map->map_bin_ptr);
+  insert(key, cached_map);
+  return cached_map;
+}
+
+void MapCache::insert(const std::string & key, const std::shared_ptr<CachedMap> & cached_map)
+{
+  if (!std::filesystem::exists(get_file_path(key))) {
+    save(key, *cached_map);
+  }
+
+  memory_entries_.emplace_front(key, cached_map);
+  while (max_memory_entry_num_ < memory_entries_.size()) {
+    memory_entries_.pop_back();
+  }
+}
+
+std::string MapCache::get_file_path(const std::string & key) const
+{
+  return (std::filesystem::path(directory_) / (key + ".bin")).string();
+}
+
+std::shared_ptr<CachedMap> MapCache::load(const std::string & key) const
+{
+  const auto file_path = get_file_path(key);
+  std::ifstream file(file_path, std::ios::binary);
+  if (!file.is_open()) {
+    return nullptr;
+  }
+  const uint64_t file_size = std::filesystem::file_size(file_path);
+
+  char magic[sizeof(map_cache_magic)];
+  if (
+    !file.read(magic, sizeof(magic)) ||
+    std::memcmp(magic, map_cache_magic, sizeof(map_cache_magic)) != 0) {
+    return nullptr;
+  }
+
+  auto cached_map = std::make_shared<CachedMap>();
+  auto map_bin = std::make_shared<LaneletMapBin>();
+  auto original_map_bin = std::make_shared<LaneletMapBin>();
+  try {
+    if (
+      !read_message(file, file_size, cached_map->map_projector_info) ||
+      !read_message(file, file_size, *map_bin) ||
+      !read_message(file, file_size, *original_map_bin)) {
+      return nullptr;
+    }
+  } catch (const std::exception &) {
+    return nullptr;
+  }
+
+  cached_map->map_bin_ptr = map_bin;
+  cached_map->original_map_bin_ptr = original_map_bin;
+  return cached_map;
+}
+
+void MapCache::save(const std::string & key, const CachedMap & cached_map) const
+{
+  // NOTE: The map is written to a temporary file first so that another process never reads a
+  //       partially written file.
+  const auto file_path = get_file_path(key);
+  const auto tmp_file_path = file_path + ".tmp";
+  {
+    std::ofstream file(tmp_file_path, std::ios::binary);
+    file.write(map_cache_magic, sizeof(map_cache_magic));
+    write_message(file, cached_map.map_projector_info);
+    write_message(file, *cached_map.map_bin_ptr);
+    write_message(file, *cached_map.original_map_bin_ptr);
+    if (!file) {
+      std::remove(tmp_file_path.c_str());
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_file_path, file_path, ec);
+}
+}  // namespace autoware::static_centerline_generator
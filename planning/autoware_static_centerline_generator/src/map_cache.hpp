@@ -0,0 +1,68 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAP_CACHE_HPP_
+#define MAP_CACHE_HPP_
+
+#include "type_alias.hpp"
+
+#include "autoware_map_msgs/msg/map_projector_info.hpp"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace autoware::static_centerline_generator
+{
+using autoware_map_msgs::msg::MapProjectorInfo;
+
+struct CachedMap
+{
+  MapProjectorInfo map_projector_info;
+  LaneletMapBin::ConstSharedPtr map_bin_ptr;
+  // NOTE: The original map is kept as a binary message since it is modified when saving the map.
+  LaneletMapBin::ConstSharedPtr original_map_bin_ptr;
+  // NOTE: The route handler is kept only in memory.
+  std::shared_ptr<RouteHandler> route_handler_ptr;
+};
+
+// Maps loaded from Lanelet2 files with the hash of the file content as the key. The recently used
+// maps are kept in memory, and all the maps are saved in the directory so that they are reused
+// after the process restarts.
+class MapCache
+{
+public:
+  MapCache(const std::string & directory, const size_t max_memory_entry_num);
+
+  static std::string get_key(const std::string & lanelet2_file_path);
+
+  // Return nullptr if the map is neither in memory nor in the directory.
+  std::shared_ptr<CachedMap> find(const std::string & key);
+  void insert(const std::string & key, const std::shared_ptr<CachedMap> & cached_map);
+
+private:
+  std::string get_file_path(const std::string & key) const;
+  std::shared_ptr<CachedMap> load(const std::string & key) const;
+  void save(const std::string & key, const CachedMap & cached_map) const;
+
+  std::string directory_;
+  size_t max_memory_entry_num_;
+  // the most recently used map comes first
+  std::list<std::pair<std::string, std::shared_ptr<CachedMap>>> memory_entries_;
+};
+}  // namespace autoware::static_centerline_generator
+
+#endif  // MAP_CACHE_HPP_
@@ -0,0 +1,250 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "map_patch.hpp"
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace autoware::static_centerline_generator
+{
+namespace
+{
+std::string escape(const std::string & value)
+{
+  std::string escaped;
+  for (const char c : value) {
+    switch (c) {
+      case '&':
+        escaped += "&amp;";
+        break;
+      case '<':
+        escaped += "&lt;";
+        break;
+      case '>':
+        escaped += "&gt;";
+        break;
+      case '"':
+        escaped += "&quot;";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// e.g. "node" of <node id="1">, and "/node" of </node>
+std::string get_element_name(const std::string & tag)
+{
+  size_t end = 1;
+  while (end < tag.size() && !std::isspace(static_cast<unsigned char>(tag.at(end))) &&
+         tag.at(end) != '>' && (tag.at(end) != '/' || end == 1)) {
+    ++end;
+  }
+  return tag.substr(1, end - 1);
+}
+
+// Return an empty string if the element does not have the attribute.
+std::string get_attribute(const std::string & tag, const std::string & key)
+{
+  for (size_t pos = tag.find(key + "="); pos != std::string::npos;
+       pos = tag.find(key + "=", pos + 1)) {
+    const size_t value_begin = pos + key.size() + 2;
+    if (
+      !std::isspace(static_cast<unsigned char>(tag.at(pos - 1))) || tag.size() <= value_begin) {
+      continue;
+    }
+    const char quote = tag.at(value_begin - 1);
+    const size_t value_end = tag.find(quote, value_begin);
+    if (value_end == std::string::npos) {
+      return "";
+    }
+    return tag.substr(value_begin, value_end - value_begin);
+  }
+  return "";
+}
+
+void write_tags(std::ostream & os, const lanelet::AttributeMap & attributes)
+{
+  for (const auto & [key, attribute] : attributes) {
+    os << "    <tag k=\"" << escape(key) << "\" v=\"" << escape(attribute.value()) << "\"/>\n";
+  }
+}
+
+std::string create_centerline_member(const lanelet::Id centerline_id)
+{
+  return "<member type=\"way\" role=\"centerline\" ref=\"" + std::to_string(centerline_id) +
+         "\"/>";
+}
+}  // namespace
+
+void write_centerline_patch(
+  const std::string & input_file_path, const std::string & output_file_path,
+  const lanelet::LaneletMap & lanelet_map, const std::vector<lanelet::Id> & lane_ids,
+  const lanelet::Projector & projector)
+{
+  // create the elements of the new centerlines
+  std::unordered_map<std::string, lanelet::Id> centerline_ids;
+  std::unordered_set<std::string> new_node_ids;
+  std::unordered_set<std::string> new_way_ids;
+  std::ostringstream nodes;
+  std::ostringstream ways;
+  nodes << std::setprecision(12);
+  for (const auto lane_id : lane_ids) {
+    const auto lanelet = lanelet_map.laneletLayer.get(lane_id);
+    if (!lanelet.hasCustomCenterline()) {
+      continue;
+    }
+    const auto centerline = lanelet.centerline3d();
+    if (!new_way_ids.insert(std::to_string(centerline.id())).second) {
+      continue;
+    }
+    centerline_ids.emplace(std::to_string(lane_id), centerline.id());
+
+    ways << "  <way id=\"" << centerline.id() << "\" visible=\"true\" version=\"1\">\n";
+    for (const auto & point : centerline) {
+      ways << "    <nd ref=\"" << point.id() << "\"/>\n";
+      if (!new_node_ids.insert(std::to_string(point.id())).second) {
+        continue;
+      }
+
+      const auto gps_point = projector.reverse(point.basicPoint());
+      nodes << "  <node id=\"" << point.id() << "\" visible=\"true\" version=\"1\" lat=\""
+            << gps_point.lat << "\" lon=\"" << gps_point.lon << "\">\n";
+      nodes << "    <tag k=\"ele\" v=\"" << gps_point.ele << "\"/>\n";
+      auto attributes = point.attributes();
+      attributes.erase("ele");
+      write_tags(nodes, attributes);
+      nodes << "  </node>\n";
+    }
+    write_tags(ways, centerline.attributes());
+    ways << "  </way>\n";
+  }
+
+  std::ifstream input(input_file_path);
+  if (!input.is_open()) {
+    throw std::runtime_error("Failed to open " + input_file_path + ".");
+  }
+  const auto tmp_output_file_path = output_file_path + ".tmp";
+  std::ofstream output(tmp_output_file_path);
+  if (!output.is_open()) {
+    throw std::runtime_error("Failed to open " + tmp_output_file_path + ".");
+  }
+  const auto fail = [&](const std::string & message) {
+    output.close();
+    std::filesystem::remove(tmp_output_file_path);
+    throw std::runtime_error(message);
+  };
+
+  // NOTE: The new nodes and ways are written after the existing ones following the order of the
+  //       elements in an OSM file. They are written between the line break and the indent before
+  //       the next element.
+  bool is_nodes_written = false;
+  bool is_ways_written = false;
+  std::string text;
+  const auto write_new_elements = [&](const bool with_ways) {
+    if (is_nodes_written && (!with_ways || is_ways_written)) {
+      return;
+    }
+    const size_t indent_begin = text.rfind('\n');
+    output << (indent_begin == std::string::npos ? text + "\n" : text.substr(0, indent_begin + 1));
+    if (!is_nodes_written) {
+      output << nodes.str();
+      is_nodes_written = true;
+    }
+    if (with_ways && !is_ways_written) {
+      output << ways.str();
+      is_ways_written = true;
+    }
+    text = indent_begin == std::string::npos ? "" : text.substr(indent_begin + 1);
+  };
+
+  // copy the input file element by element, replacing the centerline members of the lanelets
+  std::unordered_set<std::string> patched_lane_ids;
+  std::string patched_lane_id;
+  bool is_centerline_replaced = false;
+  std::string piece;
+  while (std::getline(input, piece, '>')) {
+    if (!input.eof()) {
+      piece += '>';
+    }
+    const size_t tag_begin = piece.find('<');
+    if (tag_begin == std::string::npos) {
+      output << piece;
+      continue;
+    }
+    text = piece.substr(0, tag_begin);
+    const auto tag = piece.substr(tag_begin);
+    const auto name = get_element_name(tag);
+
+    if (name == "node" || name == "way") {
+      const auto & new_ids = name == "node" ? new_node_ids : new_way_ids;
+      if (new_ids.count(get_attribute(tag, "id")) != 0) {
+        fail(
+          "The id " + get_attribute(tag, "id") + " of a new centerline is used in " +
+          input_file_path + ".");
+      }
+      if (name == "way") {
+        write_new_elements(false);
+      }
+    } else if (name == "relation") {
+      write_new_elements(true);
+      const auto id = get_attribute(tag, "id");
+      if (centerline_ids.count(id) != 0 && tag.compare(tag.size() - 2, 2, "/>") != 0) {
+        patched_lane_id = id;
+        is_centerline_replaced = false;
+      }
+    } else if (
+      name == "member" && !patched_lane_id.empty() && get_attribute(tag, "role") == "centerline") {
+      output << text << create_centerline_member(centerline_ids.at(patched_lane_id));
+      is_centerline_replaced = true;
+      continue;
+    } else if (name == "/relation" && !patched_lane_id.empty()) {
+      if (!is_centerline_replaced) {
+        output << "\n    " << create_centerline_member(centerline_ids.at(patched_lane_id));
+      }
+      patched_lane_ids.insert(patched_lane_id);
+      patched_lane_id.clear();
+    } else if (name == "/osm") {
+      write_new_elements(true);
+    }
+
+    output << text << tag;
+  }
+
+  if (input.bad()) {
+    fail("Failed to read " + input_file_path + ".");
+  }
+  for (const auto & [lane_id, centerline_id] : centerline_ids) {
+    if (patched_lane_ids.count(lane_id) == 0) {
+      fail("The lanelet " + lane_id + " is not in " + input_file_path + ".");
+    }
+  }
+  output.close();
+  if (!output) {
+    fail("Failed to write " + tmp_output_file_path + ".");
+  }
+
+  std::filesystem::rename(tmp_output_file_path, output_file_path);
+}
+}  // namespace autoware::static_centerline_generator
@@ -0,0 +1,37 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAP_PATCH_HPP_
+#define MAP_PATCH_HPP_
+
+#include <lanelet2_core/LaneletMap.h>
+#include <lanelet2_io/Projection.h>
+
+#include <string>
+#include <vector>
+
+namespace autoware::static_centerline_generator
+{
+// Copy the Lanelet2 file of input_file_path to output_file_path with the centerlines of the
+// lanelets of lane_ids in lanelet_map. The file is processed element by element, and the other
+// elements are copied as they are so that the difference from the input file is only the new
+// centerlines. The old centerlines are kept in the file as lanelet::write does.
+// Throw std::runtime_error if the files cannot be read or written.
+void write_centerline_patch(
+  const std::string & input_file_path, const std::string & output_file_path,
+  const lanelet::LaneletMap & lanelet_map, const std::vector<lanelet::Id> & lane_ids,
+  const lanelet::Projector & projector);
+}  // namespace autoware::static_centerline_generator
+
+#endif  // MAP_PATCH_HPP_
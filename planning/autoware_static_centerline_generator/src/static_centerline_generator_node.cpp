@@ -28,11 +28,13 @@
 #include "autoware_lanelet2_extension/utility/utilities.hpp"
 #include "autoware_static_centerline_generator/msg/points_with_lane_id.hpp"
 #include "centerline_source/bag_ego_trajectory_based_centerline.hpp"
+#include "map_patch.hpp"
 #include "type_alias.hpp"
 #include "utils.hpp"
 
 #include <autoware/geography_utils/lanelet2_projector.hpp>
 #include <autoware/mission_planner_universe/mission_planner_plugin.hpp>
+#include <autoware/profiling_utils/profiling_utils.hpp>
 #include <autoware/universe_utils/ros/marker_helper.hpp>
 #include <pluginlib/class_loader.hpp>
 
@@ -41,7 +43,6 @@
 #include "std_msgs/msg/int32.hpp"
 
 #include <boost/geometry/algorithms/correct.hpp>
-#include <boost/geometry/algorithms/distance.hpp>
 
 #include <glog/logging.h>
 #include <lanelet2_core/LaneletMap.h>
@@ -50,14 +51,20 @@
 #include <lanelet2_projection/UTM.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #define RESET_TEXT "\x1B[0m"
@@ -69,12 +76,6 @@ namespace autoware::static_centerline_generator
 {
 namespace
 {
-lanelet::BasicPoint2d convert_to_lanelet_point(const geometry_msgs::msg::Point & geom_point)
-{
-  lanelet::BasicPoint2d point(geom_point.x, geom_point.y);
-  return point;
-}
-
 LinearRing2d create_vehicle_footprint(
   const geometry_msgs::msg::Pose & pose,
   const autoware::vehicle_info_utils::VehicleInfo & vehicle_info, const double margin = 0.0)
@@ -172,13 +173,16 @@ std::vector<TrajectoryPoint> resample_trajectory_points(
 }
 
 std::vector<std::vector<geometry_msgs::msg::Point>> convert_to_geometry_points_vector(
-  const std::unordered_map<lanelet::Id, LineString2d> & lanelet_points_map,
-  const std::vector<lanelet::Id> & centerline_lane_id_map_order)
+  const std::unordered_map<lanelet::Id, LaneletBounds> & lanelet_bounds_map,
+  const std::vector<lanelet::Id> & centerline_lane_id_map_order, const bool is_left)
 {
   std::vector<std::vector<geometry_msgs::msg::Point>> points_vec;
   for (const lanelet::Id centerline_lane_id : centerline_lane_id_map_order) {
+    const auto & lanelet_bounds = lanelet_bounds_map.at(centerline_lane_id);
+    const auto & lanelet_points =
+      is_left ? lanelet_bounds.left.line_string() : lanelet_bounds.right.line_string();
     points_vec.push_back(std::vector<geometry_msgs::msg::Point>{});
-    for (const auto & lanelet_point : lanelet_points_map.at(centerline_lane_id)) {
+    for (const auto & lanelet_point : lanelet_points) {
       geometry_msgs::msg::Point point;
       point.x = lanelet_point.x();
       point.y = lanelet_point.y();
@@ -210,6 +214,14 @@ std::vector<std::vector<geometry_msgs::msg::Point>> convert_to_geometry_points_v
 
   return points_vec;
 }
+
+bool is_same_pose(const geometry_msgs::msg::Pose & a, const geometry_msgs::msg::Pose & b)
+{
+  return a.position.x == b.position.x && a.position.y == b.position.y &&
+         a.position.z == b.position.z && a.orientation.x == b.orientation.x &&
+         a.orientation.y == b.orientation.y && a.orientation.z == b.orientation.z &&
+         a.orientation.w == b.orientation.w;
+}
 }  // namespace
 
 StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
@@ -222,6 +234,8 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
     google::InstallFailureSignalHandler();
   }
 
+  AUTOWARE_PROFILE_INIT(*this);
+
   // publishers
   pub_map_bin_ =
     create_publisher<LaneletMapBin>("lanelet2_map_topic", utils::create_transient_local_qos());
@@ -298,6 +312,13 @@ StaticCenterlineGeneratorNode::StaticCenterlineGeneratorNode(
   // vehicle info
   vehicle_info_ = autoware::vehicle_info_utils::VehicleInfoUtils(*this).getVehicleInfo();
 
+  // map cache
+  if (getRosParameter<bool>("map_cache.enable")) {
+    map_cache_ = std::make_unique<MapCache>(
+      getRosParameter<std::string>("map_cache.directory"),
+      std::max(getRosParameter<int>("map_cache.max_memory_entry_num"), 1));
+  }
+
   centerline_source_ = [&]() {
     const auto centerline_source_param = declare_parameter<std::string>("centerline_source");
     if (centerline_source_param == "optimization_trajectory_base") {
@@ -319,16 +340,52 @@ void StaticCenterlineGeneratorNode::visualize_selected_centerline()
     autoware::motion_utils::convertToTrajectory(selected_centerline, create_header(this->now())));
 
   // delete markers for validation
+  // NOTE: The markers of each point in the selected range are still valid since their ids are the
+  //       indices in the whole centerline.
   pub_validation_results_->publish(utils::create_delete_all_marker_array({}, now()));
-  pub_debug_markers_->publish(
-    utils::create_delete_all_marker_array(
-      {"unsafe_footprints", "unsafe_footprints_distance"}, now()));
+  MarkerArray selected_marker_array;
+  for (const auto & [key, marker] : published_debug_markers_) {
+    const bool is_point_marker = key.first == "unsafe_footprints" ||
+                                 key.first == "unsafe_footprints_distance" ||
+                                 key.first == "curvature";
+    const bool is_selected =
+      centerline_handler_.start_index <= key.second && key.second <= centerline_handler_.end_index;
+    if (is_point_marker && !is_selected) {
+      continue;
+    }
+    selected_marker_array.markers.push_back(marker);
+  }
+  publish_debug_markers(selected_marker_array);
   pub_debug_ego_footprint_bounds_->publish(
     utils::create_delete_all_marker_array({"road_bounds"}, now()));
 }
 
+void StaticCenterlineGeneratorNode::publish_debug_markers(const MarkerArray & marker_array)
+{
+  auto diff_marker_array =
+    utils::update_published_markers(published_debug_markers_, marker_array, now());
+
+  // NOTE: A new subscriber has received only the last difference, so all the markers are published.
+  const size_t subscription_num = pub_debug_markers_->get_subscription_count();
+  if (debug_markers_subscription_num_ < subscription_num) {
+    auto & markers = diff_marker_array.markers;
+    markers.erase(
+      std::remove_if(
+        markers.begin(), markers.end(),
+        [](const Marker & marker) { return marker.action != Marker::DELETE; }),
+      markers.end());
+    markers.insert(markers.end(), marker_array.markers.begin(), marker_array.markers.end());
+  }
+  debug_markers_subscription_num_ = subscription_num;
+
+  if (!diff_marker_array.markers.empty()) {
+    pub_debug_markers_->publish(diff_marker_array);
+  }
+}
+
 void StaticCenterlineGeneratorNode::generate_centerline()
 {
+  AUTOWARE_PROFILE_FUNCTION();
   // declare planning setting parameters
   const auto lanelet2_input_file_path = declare_parameter<std::string>("lanelet2_input_file_path");
   if (lanelet2_input_file_path == "") {
@@ -343,8 +400,415 @@ void StaticCenterlineGeneratorNode::generate_centerline()
   visualize_selected_centerline();
 }
 
+void StaticCenterlineGeneratorNode::generate_centerlines_in_batch()
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  // declare planning setting parameters
+  const auto lanelet2_input_file_path = declare_parameter<std::string>("lanelet2_input_file_path");
+  const auto start_lanelet_ids = declare_parameter<std::vector<int64_t>>("batch.start_lanelet_ids");
+  const auto end_lanelet_ids = declare_parameter<std::vector<int64_t>>("batch.end_lanelet_ids");
+  const int thread_num = getRosParameter<int>("batch.thread_num");
+  const double output_trajectory_interval = declare_parameter<double>("output_trajectory_interval");
+  if (start_lanelet_ids.size() != end_lanelet_ids.size()) {
+    throw std::invalid_argument(
+      "The sizes of batch.start_lanelet_ids and batch.end_lanelet_ids are different.");
+  }
+  if (centerline_source_ != CenterlineSource::OptimizationTrajectoryBase) {
+    throw std::logic_error("The batch mode supports only optimization_trajectory_base.");
+  }
+
+  load_map(lanelet2_input_file_path);
+  if (!route_handler_ptr_) {
+    RCLCPP_ERROR(get_logger(), "Route handler is not ready.");
+    return;
+  }
+
+  // 1. plan the routes and the centerlines in parallel
+  // NOTE: Each route has a copy of the route handler, which shares the map and the routing graph,
+  //       since the route is set to the route handler during the optimization. Each thread has its
+  //       own optimizer, whose publishers are created here.
+  const size_t route_num = start_lanelet_ids.size();
+  const size_t valid_thread_num = std::max(thread_num, 1);
+  std::vector<OptimizationTrajectoryBasedCenterline> optimization_trajectory_based_centerlines;
+  for (size_t i = 0; i < valid_thread_num; ++i) {
+    optimization_trajectory_based_centerlines.emplace_back(*this);
+  }
+
+  std::vector<CenterlineWithRoute> centerlines_with_route(route_num);
+  std::mutex plan_route_mutex;
+  const auto generate_centerline_of_route = [&](const size_t thread_idx, const size_t route_idx) {
+    AUTOWARE_PROFILE_SCOPE("generate_centerline_of_route");
+    const auto route = [&]() {
+      std::lock_guard<std::mutex> lock(plan_route_mutex);
+      return plan_route(
+        utils::get_center_pose(*route_handler_ptr_, start_lanelet_ids.at(route_idx)),
+        utils::get_center_pose(*route_handler_ptr_, end_lanelet_ids.at(route_idx)));
+    }();
+    if (route.segments.empty()) {
+      RCLCPP_ERROR(
+        get_logger(), "Route planning failed from %ld to %ld.", start_lanelet_ids.at(route_idx),
+        end_lanelet_ids.at(route_idx));
+      return;
+    }
+
+    auto route_handler_ptr = std::make_shared<RouteHandler>(*route_handler_ptr_);
+    const auto optimized_centerline =
+      optimization_trajectory_based_centerlines.at(thread_idx)
+        .generate_centerline_with_optimization(*this, route_handler_ptr, map_bin_ptr_, route);
+    centerlines_with_route.at(route_idx) = CenterlineWithRoute{
+      resample_trajectory_points(optimized_centerline, output_trajectory_interval), route};
+  };
+
+  // NOTE: The first route is planned before the other threads start so that the parameters used
+  //       in the optimization are declared only once.
+  if (0 < route_num) {
+    generate_centerline_of_route(0, 0);
+  }
+  std::atomic<size_t> next_route_idx{1};
+  const auto generate_centerlines = [&](const size_t thread_idx) {
+    for (size_t route_idx = next_route_idx++; route_idx < route_num;
+         route_idx = next_route_idx++) {
+      generate_centerline_of_route(thread_idx, route_idx);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t thread_idx = 1; thread_idx < valid_thread_num; ++thread_idx) {
+    threads.emplace_back(generate_centerlines, thread_idx);
+  }
+  generate_centerlines(0);
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  // 2. validate the centerlines and embed them into the map
+  // NOTE: The validation is not parallelized since it publishes the results of each centerline,
+  //       while the distances to the road bounds in it are calculated in parallel.
+  for (size_t route_idx = 0; route_idx < route_num; ++route_idx) {
+    const auto & centerline_with_route = centerlines_with_route.at(route_idx);
+    if (centerline_with_route.centerline.empty()) {
+      RCLCPP_ERROR(
+        get_logger(), "Centerline is not generated from %ld to %ld.",
+        start_lanelet_ids.at(route_idx), end_lanelet_ids.at(route_idx));
+      continue;
+    }
+
+    centerline_handler_ = CenterlineHandler(centerline_with_route);
+    connect_centerline_to_lanelet();
+    validate_centerline();
+    utils::update_centerline(
+      original_map_ptr_, centerline_handler_.get_selected_centerline(),
+      centerline_handler_.get_centerline_lane_ids());
+    const auto centerline_lane_ids = centerline_handler_.get_centerline_lane_ids();
+    updated_lane_ids_.insert(centerline_lane_ids.begin(), centerline_lane_ids.end());
+  }
+  RCLCPP_INFO(get_logger(), "Updated centerlines of %lu routes in map.", route_num);
+
+  // 3. save the map with all the centerlines
+  write_map();
+}
+
+void StaticCenterlineGeneratorNode::compare_centerline_sources()
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  // declare planning setting parameters
+  const auto lanelet2_input_file_path = declare_parameter<std::string>("lanelet2_input_file_path");
+  const lanelet::Id start_lanelet_id = declare_parameter<int64_t>("start_lanelet_id");
+  const lanelet::Id end_lanelet_id = declare_parameter<int64_t>("end_lanelet_id");
+  const double output_trajectory_interval = declare_parameter<double>("output_trajectory_interval");
+  const bool export_both = getRosParameter<bool>("compare.export_both");
+  const double dist_thresh_to_road_border =
+    getRosParameter<double>("validation.dist_threshold_to_road_border");
+
+  load_map(lanelet2_input_file_path);
+  if (!route_handler_ptr_) {
+    RCLCPP_ERROR(get_logger(), "Route handler is not ready.");
+    return;
+  }
+
+  // 1. generate the centerlines of both the sources in parallel
+  // NOTE: The routes are planned outside the thread since the mission planner is not thread-safe,
+  //       and the optimization has a copy of the route handler as in the batch mode.
+  const auto optimization_route = plan_route_by_lane_ids(start_lanelet_id, end_lanelet_id);
+  OptimizationTrajectoryBasedCenterline optimization_trajectory_based_centerline(*this);
+  std::vector<TrajectoryPoint> optimized_centerline;
+  std::thread optimization_thread([&]() {
+    auto route_handler_ptr = std::make_shared<RouteHandler>(*route_handler_ptr_);
+    optimized_centerline =
+      optimization_trajectory_based_centerline.generate_centerline_with_optimization(
+        *this, route_handler_ptr, map_bin_ptr_, optimization_route);
+  });
+  std::vector<TrajectoryPoint> bag_centerline;
+  try {
+    bag_centerline = generate_centerline_with_bag(*this);
+  } catch (const std::exception & e) {
+    RCLCPP_ERROR(get_logger(), "Failed to generate the centerline with the bag. %s", e.what());
+  }
+  optimization_thread.join();
+
+  std::vector<std::pair<std::string, CenterlineWithRoute>> candidates;
+  candidates.emplace_back(
+    "optimization_trajectory_base",
+    CenterlineWithRoute{
+      resample_trajectory_points(optimized_centerline, output_trajectory_interval),
+      optimization_route});
+  candidates.emplace_back(
+    "bag_ego_trajectory_base",
+    CenterlineWithRoute{
+      resample_trajectory_points(bag_centerline, output_trajectory_interval),
+      bag_centerline.empty()
+        ? LaneletRoute{}
+        : plan_route(bag_centerline.front().pose, bag_centerline.back().pose)});
+
+  // 2. validate the centerlines, and select the one inside the lanelets with the larger distance
+  //    to the road bounds
+  std::vector<std::vector<lanelet::Id>> candidate_lane_ids(candidates.size());
+  std::vector<std::optional<CenterlineMetrics>> candidate_metrics(candidates.size());
+  std::optional<size_t> selected_idx;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const auto & centerline_with_route = candidates.at(i).second;
+    if (centerline_with_route.centerline.empty() || centerline_with_route.route.segments.empty()) {
+      continue;
+    }
+    centerline_handler_ = CenterlineHandler(centerline_with_route);
+    connect_centerline_to_lanelet();
+    candidate_lane_ids.at(i) = centerline_handler_.get_centerline_lane_ids();
+    if (candidate_lane_ids.at(i).size() != centerline_with_route.centerline.size()) {
+      continue;
+    }
+    candidate_metrics.at(i) = calc_centerline_metrics();
+
+    const auto is_better = [&](const CenterlineMetrics & lhs, const CenterlineMetrics & rhs) {
+      const bool is_lhs_inside = dist_thresh_to_road_border < lhs.min_dist_to_bound;
+      const bool is_rhs_inside = dist_thresh_to_road_border < rhs.min_dist_to_bound;
+      if (is_lhs_inside != is_rhs_inside) {
+        return is_lhs_inside;
+      }
+      return rhs.min_dist_to_bound < lhs.min_dist_to_bound;
+    };
+    if (
+      !selected_idx ||
+      is_better(*candidate_metrics.at(i), *candidate_metrics.at(selected_idx.value()))) {
+      selected_idx = i;
+    }
+  }
+
+  // show the comparison results
+  std::cerr << std::endl
+            << "############################################## Comparison Results "
+               "##############################################"
+            << std::endl;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    std::cerr << (selected_idx == i ? BOLD_TEXT : "") << candidates.at(i).first
+              << (selected_idx == i ? " (selected)" : "") << RESET_TEXT << std::endl;
+    const auto & metrics = candidate_metrics.at(i);
+    if (!metrics) {
+      std::cerr << RED_TEXT << "  The centerline is not generated or not on the route."
+                << RESET_TEXT << std::endl;
+      continue;
+    }
+    std::cerr << "  min distance to road bounds: " << metrics->min_dist_to_bound << "[m]"
+              << std::endl
+              << "  max curvature: " << metrics->max_curvature << "[1/m]" << std::endl
+              << "  steer angle margin: "
+              << autoware::universe_utils::rad2deg(metrics->steer_angle_margin) << "[deg]"
+              << std::endl;
+  }
+  std::cerr << "###################################################################################"
+               "#############################"
+            << std::endl
+            << std::endl;
+  if (!selected_idx) {
+    RCLCPP_ERROR(get_logger(), "No centerline is generated from the sources.");
+    return;
+  }
+
+  // 3. save the map with each centerline, or with the selected one
+  if (export_both) {
+    const auto lanelet2_output_file_path =
+      getRosParameter<std::string>("lanelet2_output_file_path");
+    const auto map_projector =
+      autoware::geography_utils::get_lanelet2_projector(*map_projector_info_);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (!candidate_metrics.at(i)) {
+        continue;
+      }
+      auto output_file_path = std::filesystem::path(lanelet2_output_file_path).replace_extension();
+      output_file_path += "_" + candidates.at(i).first + ".osm";
+
+      // NOTE: Only the centerline of the source is written to the map file of the source.
+      utils::update_centerline(
+        original_map_ptr_, candidates.at(i).second.centerline, candidate_lane_ids.at(i));
+      try {
+        write_centerline_patch(
+          lanelet2_input_file_path_, output_file_path, *original_map_ptr_,
+          candidate_lane_ids.at(i), *map_projector);
+        RCLCPP_INFO(get_logger(), "Saved map in %s", output_file_path.c_str());
+      } catch (const std::runtime_error & e) {
+        RCLCPP_ERROR(get_logger(), "%s", e.what());
+      }
+    }
+  }
+
+  centerline_handler_ = CenterlineHandler(candidates.at(selected_idx.value()).second);
+  pub_whole_centerline_->publish(
+    autoware::motion_utils::convertToTrajectory(
+      centerline_handler_.get_selected_centerline(), create_header(this->now())));
+  visualize_selected_centerline();
+  connect_centerline_to_lanelet();
+  validate_centerline();
+  if (!export_both) {
+    save_map();
+  }
+}
+
+void StaticCenterlineGeneratorNode::validate_map_centerlines()
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  // declare planning setting parameters
+  const auto lanelet2_input_file_path = declare_parameter<std::string>("lanelet2_input_file_path");
+  const bool use_batch_routes = getRosParameter<bool>("map_validation.use_batch_routes");
+  const int thread_num = getRosParameter<int>("map_validation.thread_num");
+  const auto output_path = getRosParameter<std::string>("map_validation.output_path");
+  const double dist_thresh_to_road_border =
+    getRosParameter<double>("validation.dist_threshold_to_road_border");
+  const double max_steer_angle_margin =
+    getRosParameter<double>("validation.max_steer_angle_margin");
+  const double steer_angle_threshold = vehicle_info_.max_steer_angle_rad - max_steer_angle_margin;
+
+  load_map(lanelet2_input_file_path);
+  if (!route_handler_ptr_) {
+    RCLCPP_ERROR(get_logger(), "Route handler is not ready.");
+    return;
+  }
+
+  // 1. collect the lanelets of the routes in the batch, or all the road lanelets in the map
+  lanelet::ConstLanelets lanelets;
+  if (use_batch_routes) {
+    const auto start_lanelet_ids =
+      declare_parameter<std::vector<int64_t>>("batch.start_lanelet_ids");
+    const auto end_lanelet_ids = declare_parameter<std::vector<int64_t>>("batch.end_lanelet_ids");
+    if (start_lanelet_ids.size() != end_lanelet_ids.size()) {
+      throw std::invalid_argument(
+        "The sizes of batch.start_lanelet_ids and batch.end_lanelet_ids are different.");
+    }
+    std::set<lanelet::Id> collected_lane_ids;
+    for (size_t route_idx = 0; route_idx < start_lanelet_ids.size(); ++route_idx) {
+      const auto route = plan_route(
+        utils::get_center_pose(*route_handler_ptr_, start_lanelet_ids.at(route_idx)),
+        utils::get_center_pose(*route_handler_ptr_, end_lanelet_ids.at(route_idx)));
+      if (route.segments.empty()) {
+        RCLCPP_ERROR(
+          get_logger(), "Route planning failed from %ld to %ld.", start_lanelet_ids.at(route_idx),
+          end_lanelet_ids.at(route_idx));
+        continue;
+      }
+      for (const auto & lanelet : utils::get_lanelets_from_route(*route_handler_ptr_, route)) {
+        if (collected_lane_ids.insert(lanelet.id()).second) {
+          lanelets.push_back(lanelet);
+        }
+      }
+    }
+  } else {
+    lanelets = lanelet::utils::query::roadLanelets(
+      lanelet::utils::query::laneletLayer(route_handler_ptr_->getLaneletMapPtr()));
+  }
+
+  // 2. validate the centerline of each lanelet against its own bounds in parallel
+  // NOTE: The bounds are indexed by each thread since every lanelet is validated only once.
+  struct Violation
+  {
+    size_t point_idx;
+    geometry_msgs::msg::Point point;
+    double dist_to_bound;
+    double steer_angle;
+  };
+  std::vector<std::vector<Violation>> violations(lanelets.size());
+  const auto validate_lanelet = [&](const size_t lanelet_idx) {
+    const auto & lanelet = lanelets.at(lanelet_idx);
+    const auto & centerline_3d = lanelet.centerline();
+    if (centerline_3d.size() < 2) {
+      return;
+    }
+
+    std::vector<TrajectoryPoint> centerline(centerline_3d.size());
+    for (size_t i = 0; i < centerline_3d.size(); ++i) {
+      // the yaw of the segment to the next point, or from the previous one at the last point
+      const auto & p = centerline_3d[i];
+      const size_t from_idx = i + 1 < centerline_3d.size() ? i : i - 1;
+      const auto & p_from = centerline_3d[from_idx];
+      const auto & p_to = centerline_3d[from_idx + 1];
+      centerline.at(i).pose.position = autoware::universe_utils::createPoint(p.x(), p.y(), p.z());
+      centerline.at(i).pose.orientation = autoware::universe_utils::createQuaternionFromYaw(
+        std::atan2(p_to.y() - p_from.y(), p_to.x() - p_from.x()));
+    }
+
+    const LaneletBounds lanelet_bounds{
+      utils::IndexedBound(lanelet.leftBound()), utils::IndexedBound(lanelet.rightBound())};
+    const auto curvature_vec = autoware::motion_utils::calcCurvature(centerline);
+    constexpr size_t invalid_idx = std::numeric_limits<size_t>::max();
+    size_t right_segment_idx = invalid_idx;
+    size_t left_segment_idx = invalid_idx;
+    for (size_t i = 0; i < centerline.size(); ++i) {
+      const auto footprint_poly = create_vehicle_footprint(centerline.at(i).pose, vehicle_info_);
+      const double dist_to_bound = std::min(
+        lanelet_bounds.right.distance(footprint_poly, right_segment_idx),
+        lanelet_bounds.left.distance(footprint_poly, left_segment_idx));
+      const double steer_angle =
+        vehicle_info_.calcSteerAngleFromCurvature(std::abs(curvature_vec.at(i)));
+      if (dist_to_bound < dist_thresh_to_road_border || steer_angle_threshold < steer_angle) {
+        violations.at(lanelet_idx).push_back(
+          Violation{i, centerline.at(i).pose.position, dist_to_bound, steer_angle});
+      }
+    }
+  };
+
+  std::atomic<size_t> next_lanelet_idx{0};
+  const auto validate_lanelets = [&]() {
+    for (size_t lanelet_idx = next_lanelet_idx++; lanelet_idx < lanelets.size();
+         lanelet_idx = next_lanelet_idx++) {
+      try {
+        validate_lanelet(lanelet_idx);
+      } catch (const std::exception & e) {
+        RCLCPP_ERROR(
+          get_logger(), "Validation of lanelet %ld failed: %s", lanelets.at(lanelet_idx).id(),
+          e.what());
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int thread_idx = 1; thread_idx < thread_num; ++thread_idx) {
+    threads.emplace_back(validate_lanelets);
+  }
+  validate_lanelets();
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  // 3. write the violations in the order of the lanelets
+  std::ofstream ofs(output_path);
+  if (!ofs) {
+    RCLCPP_ERROR(get_logger(), "Failed to open %s.", output_path.c_str());
+    return;
+  }
+  ofs << "lanelet_id,point_index,x,y,dist_to_bound,steer_angle\n";
+  size_t violation_num = 0;
+  size_t violated_lanelet_num = 0;
+  for (size_t lanelet_idx = 0; lanelet_idx < lanelets.size(); ++lanelet_idx) {
+    for (const auto & v : violations.at(lanelet_idx)) {
+      ofs << lanelets.at(lanelet_idx).id() << ',' << v.point_idx << ',' << v.point.x << ','
+          << v.point.y << ',' << v.dist_to_bound << ',' << v.steer_angle << '\n';
+    }
+    violation_num += violations.at(lanelet_idx).size();
+    violated_lanelet_num += violations.at(lanelet_idx).empty() ? 0 : 1;
+  }
+  RCLCPP_INFO(
+    get_logger(), "Validated %lu lanelets, and wrote %lu violations in %lu lanelets to %s.",
+    lanelets.size(), violation_num, violated_lanelet_num, output_path.c_str());
+}
+
 CenterlineWithRoute StaticCenterlineGeneratorNode::generate_whole_centerline_with_route()
 {
+  AUTOWARE_PROFILE_FUNCTION();
   if (!route_handler_ptr_) {
     RCLCPP_ERROR(get_logger(), "Route handler is not ready. Return empty trajectory.");
     return CenterlineWithRoute{};
@@ -383,6 +847,7 @@ CenterlineWithRoute StaticCenterlineGeneratorNode::generate_whole_centerline_wit
 
 void StaticCenterlineGeneratorNode::load_map(const std::string & lanelet2_input_file_path)
 {
+  AUTOWARE_PROFILE_FUNCTION();
   // copy the input LL2 map to the temporary file for debugging
   const std::string debug_input_file_dir{"/tmp/autoware_static_centerline_generator/input/"};
   std::filesystem::create_directories(debug_input_file_dir);
@@ -390,8 +855,24 @@ void StaticCenterlineGeneratorNode::load_map(const std::string & lanelet2_input_
     lanelet2_input_file_path, debug_input_file_dir + "lanelet2_map.osm",
     std::filesystem::copy_options::overwrite_existing);
 
+  // load map from the cache if the same map has been loaded
+  const auto map_cache_key =
+    map_cache_ ? MapCache::get_key(lanelet2_input_file_path) : std::string{};
+  const auto cached_map = map_cache_ ? map_cache_->find(map_cache_key) : nullptr;
+
   // load map by the map_loader package
   map_bin_ptr_ = [&]() -> LaneletMapBin::ConstSharedPtr {
+    if (cached_map) {
+      map_projector_info_ = std::make_unique<MapProjectorInfo>(cached_map->map_projector_info);
+      original_map_ptr_ = std::make_shared<lanelet::LaneletMap>();
+      lanelet::utils::conversion::fromBinMsg(*cached_map->original_map_bin_ptr, original_map_ptr_);
+
+      auto map_bin_msg = std::make_shared<LaneletMapBin>(*cached_map->map_bin_ptr);
+      map_bin_msg->header.stamp = now();
+      RCLCPP_INFO(get_logger(), "Found map in the cache.");
+      return map_bin_msg;
+    }
+
     // load map
     map_projector_info_ = std::make_unique<MapProjectorInfo>(
       autoware::map_projection_loader::load_info_from_lanelet2_map(lanelet2_input_file_path));
@@ -429,8 +910,33 @@ void StaticCenterlineGeneratorNode::load_map(const std::string & lanelet2_input_
   RCLCPP_INFO(get_logger(), "Published map.");
 
   // create route_handler
-  route_handler_ptr_ = std::make_shared<RouteHandler>();
-  route_handler_ptr_->setMap(*map_bin_ptr_);
+  if (cached_map) {
+    route_handler_ptr_ = cached_map->route_handler_ptr;
+  } else {
+    route_handler_ptr_ = std::make_shared<RouteHandler>();
+    route_handler_ptr_->setMap(*map_bin_ptr_);
+  }
+
+  // register the map to the cache
+  if (map_cache_ && !cached_map) {
+    auto map_to_cache = std::make_shared<CachedMap>();
+    map_to_cache->map_projector_info = *map_projector_info_;
+    map_to_cache->map_bin_ptr = map_bin_ptr_;
+    auto original_map_bin_msg = std::make_shared<LaneletMapBin>();
+    lanelet::utils::conversion::toBinMsg(original_map_ptr_, original_map_bin_msg.get());
+    map_to_cache->original_map_bin_ptr = original_map_bin_msg;
+    map_to_cache->route_handler_ptr = route_handler_ptr_;
+    map_cache_->insert(map_cache_key, map_to_cache);
+  }
+
+  lanelet2_input_file_path_ = lanelet2_input_file_path;
+  updated_lane_ids_.clear();
+
+  // the bounds and the validation results of the previous map are not valid any more
+  lanelet_bounds_cache_.clear();
+  validated_centerline_.clear();
+  validated_lane_ids_.clear();
+  validated_dists_to_bound_.clear();
 }
 
 void StaticCenterlineGeneratorNode::on_load_map(
@@ -498,6 +1004,7 @@ LaneletRoute StaticCenterlineGeneratorNode::plan_route(
   const geometry_msgs::msg::Pose & start_center_pose,
   const geometry_msgs::msg::Pose & end_center_pose)
 {
+  AUTOWARE_PROFILE_FUNCTION();
   if (!map_bin_ptr_) {
     RCLCPP_ERROR(get_logger(), "Map or route handler is not ready. Return empty lane ids.");
     return LaneletRoute{};
@@ -607,14 +1114,15 @@ void StaticCenterlineGeneratorNode::on_plan_path(
   validate_centerline();
 
   // create output data
+  const utils::RouteLaneletIndex route_lanelet_index(route_lanelets);
   auto target_traj_point = optimized_traj_points.cbegin();
   bool is_end_lanelet = false;
-  for (const auto & lanelet : route_lanelets) {
+  for (size_t lanelet_idx = 0; lanelet_idx < route_lanelets.size(); ++lanelet_idx) {
+    const auto & lanelet = route_lanelets.at(lanelet_idx);
     std::vector<geometry_msgs::msg::Point> current_lanelet_points;
 
     // check if target point is inside the lanelet
-    while (lanelet::geometry::inside(
-      lanelet, convert_to_lanelet_point(target_traj_point->pose.position))) {
+    while (route_lanelet_index.is_inside(lanelet_idx, target_traj_point->pose.position)) {
       // memorize points inside the lanelet
       current_lanelet_points.push_back(target_traj_point->pose.position);
       target_traj_point++;
@@ -644,6 +1152,7 @@ void StaticCenterlineGeneratorNode::on_plan_path(
 
 void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
 {
+  AUTOWARE_PROFILE_FUNCTION();
   centerline_handler_.clear_centerline_lane_ids();
 
   const auto centerline = centerline_handler_.get_selected_centerline();
@@ -652,18 +1161,11 @@ void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
   }
   const auto route = centerline_handler_.get_route();
   const auto route_lanelets = utils::get_lanelets_from_route(*route_handler_ptr_, route);
+  const utils::RouteLaneletIndex route_lanelet_index(route_lanelets);
 
   // 1. calculate the lanelet of the centerline's front.
-  std::optional<size_t> centerline_front_lanelet_idx{std::nullopt};
-  for (size_t i = 0; i < route_lanelets.size(); ++i) {
-    const auto & lanelet = route_lanelets.at(i);
-    const bool is_inside =
-      lanelet::geometry::inside(lanelet, convert_to_lanelet_point(centerline.at(0).pose.position));
-    if (is_inside) {
-      centerline_front_lanelet_idx = i;
-      break;
-    }
-  }
+  const auto centerline_front_lanelet_idx =
+    route_lanelet_index.find_first_lanelet(centerline.at(0).pose.position);
 
   // 2. update centerline_lane_ids in centerline_handler_
   size_t centerline_idx = 0;
@@ -675,8 +1177,8 @@ void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
 
     while (true) {
       // check if target point is inside the lanelet
-      const bool is_inside = lanelet::geometry::inside(
-        lanelet, convert_to_lanelet_point(centerline.at(centerline_idx).pose.position));
+      const bool is_inside =
+        route_lanelet_index.is_inside(lanelet_idx, centerline.at(centerline_idx).pose.position);
       if (is_inside) {
         was_once_inside_lanelet = true;
       }
@@ -716,8 +1218,124 @@ void StaticCenterlineGeneratorNode::connect_centerline_to_lanelet()
   }
 }
 
+const LaneletBounds & StaticCenterlineGeneratorNode::get_lanelet_bounds(
+  const lanelet::Id lane_id)
+{
+  const auto itr = lanelet_bounds_cache_.find(lane_id);
+  if (itr != lanelet_bounds_cache_.end()) {
+    return itr->second;
+  }
+
+  const auto lanelet = route_handler_ptr_->getLaneletsFromId(lane_id);
+  LaneletBounds lanelet_bounds{
+    utils::IndexedBound(lanelet.leftBound()), utils::IndexedBound(lanelet.rightBound())};
+  return lanelet_bounds_cache_.emplace(lane_id, std::move(lanelet_bounds)).first->second;
+}
+
+std::vector<double> StaticCenterlineGeneratorNode::calc_dist_to_bounds(
+  const std::vector<TrajectoryPoint> & centerline,
+  const std::vector<lanelet::Id> & centerline_lane_ids)
+{
+  // NOTE: The points in the common prefix and suffix with the last validated centerline keep their
+  //       distances, e.g. when only the start or end index of the centerline is modified.
+  const auto is_same_point = [&](const size_t idx, const size_t prev_idx) {
+    return centerline_lane_ids.at(idx) == validated_lane_ids_.at(prev_idx) &&
+           is_same_pose(centerline.at(idx).pose, validated_centerline_.at(prev_idx).pose);
+  };
+  const size_t size = centerline.size();
+  const size_t prev_size = validated_dists_to_bound_.size();
+
+  size_t prefix_size = 0;
+  while (prefix_size < std::min(size, prev_size) && is_same_point(prefix_size, prefix_size)) {
+    ++prefix_size;
+  }
+  size_t suffix_size = 0;
+  while (suffix_size < std::min(size, prev_size) - prefix_size &&
+         is_same_point(size - 1 - suffix_size, prev_size - 1 - suffix_size)) {
+    ++suffix_size;
+  }
+
+  const size_t begin_idx = prefix_size;
+  const size_t end_idx = size - suffix_size;
+  std::vector<double> dist_to_bounds(size);
+  std::copy(
+    validated_dists_to_bound_.begin(), validated_dists_to_bound_.begin() + prefix_size,
+    dist_to_bounds.begin());
+  std::copy(
+    validated_dists_to_bound_.end() - suffix_size, validated_dists_to_bound_.end(),
+    dist_to_bounds.end() - suffix_size);
+
+  // NOTE: The bounds are created before the threads start since the cache is not thread-safe.
+  for (size_t i = begin_idx; i < end_idx; ++i) {
+    get_lanelet_bounds(centerline_lane_ids.at(i));
+  }
+
+  // The points are split into chunks calculated in parallel. In a chunk, the closest segments of
+  // the previous point are where the search of the next point starts.
+  const auto calc_chunk = [&](const size_t chunk_begin_idx, const size_t chunk_end_idx) {
+    constexpr size_t invalid_idx = std::numeric_limits<size_t>::max();
+    size_t right_segment_idx = invalid_idx;
+    size_t left_segment_idx = invalid_idx;
+    for (size_t i = chunk_begin_idx; i < chunk_end_idx; ++i) {
+      if (0 < i && centerline_lane_ids.at(i) != centerline_lane_ids.at(i - 1)) {
+        right_segment_idx = invalid_idx;
+        left_segment_idx = invalid_idx;
+      }
+
+      const auto footprint_poly = create_vehicle_footprint(centerline.at(i).pose, vehicle_info_);
+      const auto & lanelet_bounds = lanelet_bounds_cache_.at(centerline_lane_ids.at(i));
+      dist_to_bounds.at(i) = std::min(
+        lanelet_bounds.right.distance(footprint_poly, right_segment_idx),
+        lanelet_bounds.left.distance(footprint_poly, left_segment_idx));
+    }
+  };
+
+  const size_t point_num = end_idx - begin_idx;
+  const size_t thread_num = std::min<size_t>(
+    std::max(getRosParameter<int>("validation.thread_num"), 1), std::max<size_t>(point_num, 1));
+  const size_t chunk_size = (point_num + thread_num - 1) / thread_num;
+
+  std::vector<std::thread> threads;
+  for (size_t chunk_begin_idx = begin_idx + chunk_size; chunk_begin_idx < end_idx;
+       chunk_begin_idx += chunk_size) {
+    threads.emplace_back(
+      calc_chunk, chunk_begin_idx, std::min(chunk_begin_idx + chunk_size, end_idx));
+  }
+  calc_chunk(begin_idx, std::min(begin_idx + chunk_size, end_idx));
+  for (auto & thread : threads) {
+    thread.join();
+  }
+
+  validated_centerline_ = centerline;
+  validated_lane_ids_ = centerline_lane_ids;
+  validated_dists_to_bound_ = dist_to_bounds;
+
+  return dist_to_bounds;
+}
+
+CenterlineMetrics StaticCenterlineGeneratorNode::calc_centerline_metrics()
+{
+  const auto centerline = centerline_handler_.get_selected_centerline();
+  const auto centerline_lane_ids = centerline_handler_.get_centerline_lane_ids();
+
+  CenterlineMetrics metrics;
+  for (const double dist_to_bound : calc_dist_to_bounds(centerline, centerline_lane_ids)) {
+    metrics.min_dist_to_bound = std::min(metrics.min_dist_to_bound, dist_to_bound);
+  }
+  for (const double curvature : autoware::motion_utils::calcCurvature(centerline)) {
+    metrics.max_curvature = std::max(metrics.max_curvature, std::abs(curvature));
+  }
+  metrics.max_steer_angle = vehicle_info_.calcSteerAngleFromCurvature(metrics.max_curvature);
+  metrics.steer_angle_margin = vehicle_info_.max_steer_angle_rad -
+                               getRosParameter<double>("validation.max_steer_angle_margin") -
+                               metrics.max_steer_angle;
+
+  return metrics;
+}
+
 void StaticCenterlineGeneratorNode::validate_centerline()
 {
+  AUTOWARE_PROFILE_FUNCTION();
   const auto centerline = centerline_handler_.get_selected_centerline();
   const auto centerline_lane_ids = centerline_handler_.get_centerline_lane_ids();
 
@@ -740,49 +1358,37 @@ void StaticCenterlineGeneratorNode::validate_centerline()
   };
 
   // create right/left bound for each lanelet
-  std::unordered_map<lanelet::Id, LineString2d> lanelet_right_bound_map;
-  std::unordered_map<lanelet::Id, LineString2d> lanelet_left_bound_map;
   std::vector<lanelet::Id> centerline_lane_id_map_order;
-  for (size_t centerline_idx = 0; centerline_idx < centerline_lane_ids.size(); ++centerline_idx) {
-    const lanelet::Id centerline_lane_id = centerline_lane_ids.at(centerline_idx);
-    if (0 < lanelet_right_bound_map.count(centerline_lane_id)) {
+  for (const lanelet::Id centerline_lane_id : centerline_lane_ids) {
+    if (
+      std::find(
+        centerline_lane_id_map_order.begin(), centerline_lane_id_map_order.end(),
+        centerline_lane_id) != centerline_lane_id_map_order.end()) {
       continue;
     }
-
-    lanelet_right_bound_map.emplace(centerline_lane_id, LineString2d{});
-    lanelet_left_bound_map.emplace(centerline_lane_id, LineString2d{});
+    get_lanelet_bounds(centerline_lane_id);
     centerline_lane_id_map_order.push_back(centerline_lane_id);
-
-    const auto lanelet = route_handler_ptr_->getLaneletsFromId(centerline_lane_id);
-    for (const auto & point : lanelet.rightBound()) {
-      boost::geometry::append(
-        lanelet_right_bound_map.at(centerline_lane_id), Point2d(point.x(), point.y()));
-    }
-    for (const auto & point : lanelet.leftBound()) {
-      boost::geometry::append(
-        lanelet_left_bound_map.at(centerline_lane_id), Point2d(point.x(), point.y()));
-    }
   }
 
+  // calculate the distance between footprint and right/left bounds
+  const auto dist_to_bounds = calc_dist_to_bounds(centerline, centerline_lane_ids);
+
   // calculate curvature
   const auto curvature_vec = autoware::motion_utils::calcCurvature(centerline);
   const double steer_angle_threshold = vehicle_info_.max_steer_angle_rad - max_steer_angle_margin;
 
-  // calculate the distance between footprint and right/left bounds
+  // create markers of the footprints and the curvature
+  // NOTE: The markers of each point have the index in the whole centerline as the id, so that they
+  //       are published again only when they change.
   MarkerArray marker_array;
   double min_dist = std::numeric_limits<double>::max();
   double max_curvature = std::numeric_limits<double>::min();
   for (size_t i = 0; i < centerline.size(); ++i) {
     const auto & traj_point = centerline.at(i);
-    const lanelet::Id centerline_lane_id = centerline_lane_ids.at(i);
+    const size_t marker_id = centerline_handler_.start_index + i;
 
     const auto footprint_poly = create_vehicle_footprint(traj_point.pose, vehicle_info_);
-
-    const double dist_to_right =
-      boost::geometry::distance(footprint_poly, lanelet_right_bound_map.at(centerline_lane_id));
-    const double dist_to_left =
-      boost::geometry::distance(footprint_poly, lanelet_left_bound_map.at(centerline_lane_id));
-    const double min_dist_to_bound = std::min(dist_to_right, dist_to_left);
+    const double min_dist_to_bound = dist_to_bounds.at(i);
 
     if (min_dist_to_bound < min_dist) {
       min_dist = min_dist_to_bound;
@@ -797,20 +1403,20 @@ void StaticCenterlineGeneratorNode::validate_centerline()
       // add footprint marker
       const auto footprint_marker = utils::create_footprint_marker(
         "unsafe_footprints", footprint_poly, 0.05, marker_color.at(0), marker_color.at(1),
-        marker_color.at(2), 0.7, now(), i);
+        marker_color.at(2), 0.7, now(), marker_id);
       marker_array.markers.push_back(footprint_marker);
 
       // add text of distance to bounds marker
       const auto text_marker = utils::create_text_marker(
         "unsafe_footprints_distance", text_pose, min_dist_to_bound, marker_color.at(0),
-        marker_color.at(1), marker_color.at(2), 0.999, now(), i);
+        marker_color.at(1), marker_color.at(2), 0.999, now(), marker_id);
       marker_array.markers.push_back(text_marker);
     }
 
     const double curvature = curvature_vec.at(i);
     const auto curvature_text_pose = get_text_pose(traj_point.pose, vehicle_info_, -0.4);
     const auto text_marker = utils::create_text_marker(
-      "curvature", curvature_text_pose, curvature, 1.0, 1.0, 1.0, 0.8, now(), i);
+      "curvature", curvature_text_pose, curvature, 1.0, 1.0, 1.0, 0.8, now(), marker_id);
     marker_array.markers.push_back(text_marker);
 
     if (max_curvature < std::abs(curvature)) {
@@ -822,9 +1428,9 @@ void StaticCenterlineGeneratorNode::validate_centerline()
   // add centerline and road boundaries to debug markers
   const auto centerline_vec = convert_to_geometry_points_vector(centerline, centerline_lane_ids);
   const auto left_bound_vec =
-    convert_to_geometry_points_vector(lanelet_left_bound_map, centerline_lane_id_map_order);
+    convert_to_geometry_points_vector(lanelet_bounds_cache_, centerline_lane_id_map_order, true);
   const auto right_bound_vec =
-    convert_to_geometry_points_vector(lanelet_right_bound_map, centerline_lane_id_map_order);
+    convert_to_geometry_points_vector(lanelet_bounds_cache_, centerline_lane_id_map_order, false);
 
   // add start/goal pose to debug markers
   const auto route = centerline_handler_.get_route();
@@ -843,7 +1449,7 @@ void StaticCenterlineGeneratorNode::validate_centerline()
   utils::create_points_marker(marker_array, "right_bound", right_bound_vec, 0.05, now());
 
   // publish debug markers
-  pub_debug_markers_->publish(marker_array);
+  publish_debug_markers(marker_array);
 
   // show the validation results
   std::cerr << std::endl
@@ -910,17 +1516,41 @@ void StaticCenterlineGeneratorNode::save_map()
   const auto centerline = centerline_handler_.get_selected_centerline();
   const auto centerline_lane_ids = centerline_handler_.get_centerline_lane_ids();
 
-  const auto lanelet2_output_file_path = getRosParameter<std::string>("lanelet2_output_file_path");
-
   // update centerline in map
   utils::update_centerline(original_map_ptr_, centerline, centerline_lane_ids);
+  updated_lane_ids_.insert(centerline_lane_ids.begin(), centerline_lane_ids.end());
   RCLCPP_INFO(get_logger(), "Updated centerline in map.");
 
+  write_map();
+}
+
+void StaticCenterlineGeneratorNode::write_map()
+{
+  AUTOWARE_PROFILE_FUNCTION();
+  const auto lanelet2_output_file_path = getRosParameter<std::string>("lanelet2_output_file_path");
+
   // save map with modified center line
   std::filesystem::create_directory("/tmp/autoware_static_centerline_generator");
   const auto map_projector =
     autoware::geography_utils::get_lanelet2_projector(*map_projector_info_);
-  lanelet::write(lanelet2_output_file_path, *original_map_ptr_, *map_projector);
+  const bool is_patched = [&]() {
+    if (!getRosParameter<bool>("save_map.patch")) {
+      return false;
+    }
+    try {
+      write_centerline_patch(
+        lanelet2_input_file_path_, lanelet2_output_file_path, *original_map_ptr_,
+        std::vector<lanelet::Id>(updated_lane_ids_.begin(), updated_lane_ids_.end()),
+        *map_projector);
+    } catch (const std::runtime_error & e) {
+      RCLCPP_WARN(get_logger(), "%s Write the whole map instead.", e.what());
+      return false;
+    }
+    return true;
+  }();
+  if (!is_patched) {
+    lanelet::write(lanelet2_output_file_path, *original_map_ptr_, *map_projector);
+  }
   RCLCPP_INFO(
     get_logger(), "Saved map in %s", "/tmp/autoware_static_centerline_generator/lanelet2_map.osm");
 
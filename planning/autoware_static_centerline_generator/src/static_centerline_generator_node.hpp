@@ -21,22 +21,27 @@
 #include "autoware_static_centerline_generator/srv/plan_route.hpp"
 #include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
 #include "centerline_source/optimization_trajectory_based_centerline.hpp"
+#include "map_cache.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "type_alias.hpp"
+#include "utils.hpp"
 
 #include "autoware_map_msgs/msg/map_projector_info.hpp"
 #include "std_msgs/msg/empty.hpp"
 #include "std_msgs/msg/float32.hpp"
 #include "std_msgs/msg/int32.hpp"
 
+#include <limits>
 #include <memory>
+#include <optional>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace autoware::static_centerline_generator
 {
-using autoware_map_msgs::msg::MapProjectorInfo;
 using autoware_static_centerline_generator::srv::LoadMap;
 using autoware_static_centerline_generator::srv::PlanPath;
 using autoware_static_centerline_generator::srv::PlanRoute;
@@ -98,17 +103,37 @@ struct CenterlineHandler
   std::vector<lanelet::Id> centerline_lane_ids;
 };
 
+struct CenterlineMetrics
+{
+  double min_dist_to_bound{std::numeric_limits<double>::max()};
+  double max_curvature{0.0};
+  // estimated from max_curvature
+  double max_steer_angle{0.0};
+  // threshold minus max_steer_angle, which is negative when the threshold is exceeded
+  double steer_angle_margin{0.0};
+};
+
 struct RoadBounds
 {
   std::vector<geometry_msgs::msg::Point> left_bound;
   std::vector<geometry_msgs::msg::Point> right_bound;
 };
 
+struct LaneletBounds
+{
+  utils::IndexedBound left;
+  utils::IndexedBound right;
+};
+
 class StaticCenterlineGeneratorNode : public rclcpp::Node
 {
 public:
   explicit StaticCenterlineGeneratorNode(const rclcpp::NodeOptions & node_options);
   void generate_centerline();
+  void generate_centerlines_in_batch();
+  void compare_centerline_sources();
+  // validate the centerlines of the lanelets in the map without generating them
+  void validate_map_centerlines();
   void connect_centerline_to_lanelet();
   void validate_centerline();
   void save_map();
@@ -136,7 +161,19 @@ private:
   void on_plan_path(
     const PlanPath::Request::SharedPtr request, const PlanPath::Response::SharedPtr response);
 
+  // save map
+  void write_map();
+
   void visualize_selected_centerline();
+  void publish_debug_markers(const MarkerArray & marker_array);
+
+  // validate centerline
+  const LaneletBounds & get_lanelet_bounds(const lanelet::Id lane_id);
+  std::vector<double> calc_dist_to_bounds(
+    const std::vector<TrajectoryPoint> & centerline,
+    const std::vector<lanelet::Id> & centerline_lane_ids);
+  // metrics of the selected centerline connected to the lanelets
+  CenterlineMetrics calc_centerline_metrics();
 
   // parameter
   template <typename T>
@@ -149,11 +186,23 @@ private:
   LaneletMapBin::ConstSharedPtr map_bin_ptr_{nullptr};
   std::shared_ptr<RouteHandler> route_handler_ptr_{nullptr};
   std::unique_ptr<MapProjectorInfo> map_projector_info_{nullptr};
+  std::unique_ptr<MapCache> map_cache_{nullptr};
+
+  // input file of the map and the lanelets whose centerlines are updated, to save only them
+  std::string lanelet2_input_file_path_;
+  std::set<lanelet::Id> updated_lane_ids_;
 
   CenterlineHandler centerline_handler_;
 
   float footprint_margin_for_road_bound_{0.0};
 
+  // bounds of the lanelets in the map, and the centerline with its distances to the bounds in the
+  // last validation, so that only the modified range of the centerline is validated again
+  std::unordered_map<lanelet::Id, LaneletBounds> lanelet_bounds_cache_;
+  std::vector<TrajectoryPoint> validated_centerline_;
+  std::vector<lanelet::Id> validated_lane_ids_;
+  std::vector<double> validated_dists_to_bound_;
+
   enum class CenterlineSource {
     OptimizationTrajectoryBase = 0,
     BagEgoTrajectoryBase,
@@ -170,6 +219,10 @@ private:
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_debug_ego_footprint_bounds_{nullptr};
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_debug_markers_{nullptr};
 
+  // debug markers shown in rviz, so that only the changed markers are published
+  utils::PublishedMarkers published_debug_markers_;
+  size_t debug_markers_subscription_num_{0};
+
   // subscriber
   rclcpp::Subscription<std_msgs::msg::Int32>::SharedPtr sub_traj_start_index_;
   rclcpp::Subscription<std_msgs::msg::Int32>::SharedPtr sub_traj_end_index_;
@@ -29,9 +29,11 @@
 namespace autoware::static_centerline_generator
 {
 using autoware::route_handler::RouteHandler;
+using autoware::universe_utils::Box2d;
 using autoware::universe_utils::LinearRing2d;
 using autoware::universe_utils::LineString2d;
 using autoware::universe_utils::Point2d;
+using autoware::universe_utils::Segment2d;
 using autoware_internal_planning_msgs::msg::PathWithLaneId;
 using autoware_map_msgs::msg::LaneletMapBin;
 using autoware_perception_msgs::msg::PredictedObjects;
@@ -21,6 +21,15 @@
 #include <lanelet2_core/LaneletMap.h>
 #include <lanelet2_core/geometry/Lanelet.h>
 
+#include <boost/geometry/algorithms/assign.hpp>
+#include <boost/geometry/algorithms/covered_by.hpp>
+#include <boost/geometry/algorithms/distance.hpp>
+#include <boost/geometry/algorithms/envelope.hpp>
+#include <boost/geometry/algorithms/expand.hpp>
+#include <boost/geometry/algorithms/within.hpp>
+
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
@@ -292,5 +301,135 @@ MarkerArray create_delete_all_marker_array(
   return marker_array;
 }
 
+MarkerArray update_published_markers(
+  PublishedMarkers & published_markers, const MarkerArray & marker_array, const rclcpp::Time & now)
+{
+  // NOTE: The stamps are not compared since the markers are created again every time.
+  const auto is_same_marker = [](const Marker & published_marker, const Marker & marker) {
+    auto stamped_marker = published_marker;
+    stamped_marker.header.stamp = marker.header.stamp;
+    return stamped_marker == marker;
+  };
+
+  MarkerArray diff_marker_array;
+  PublishedMarkers next_published_markers;
+  for (const auto & marker : marker_array.markers) {
+    const auto key = std::make_pair(marker.ns, marker.id);
+    const auto itr = published_markers.find(key);
+    if (itr == published_markers.end() || !is_same_marker(itr->second, marker)) {
+      diff_marker_array.markers.push_back(marker);
+    }
+    next_published_markers.insert_or_assign(key, marker);
+  }
+
+  for (const auto & [key, published_marker] : published_markers) {
+    if (next_published_markers.count(key) != 0) {
+      continue;
+    }
+    Marker delete_marker;
+    delete_marker.header.frame_id = published_marker.header.frame_id;
+    delete_marker.header.stamp = now;
+    delete_marker.ns = key.first;
+    delete_marker.id = key.second;
+    delete_marker.action = Marker::DELETE;
+    diff_marker_array.markers.push_back(delete_marker);
+  }
+
+  published_markers = std::move(next_published_markers);
+  return diff_marker_array;
+}
+
+IndexedBound::IndexedBound(const lanelet::ConstLineString3d & bound)
+{
+  for (const auto & point : bound) {
+    boost::geometry::append(line_string_, Point2d(point.x(), point.y()));
+  }
+
+  std::vector<std::pair<Segment2d, size_t>> indexed_segments;
+  for (size_t i = 1; i < line_string_.size(); ++i) {
+    segments_.emplace_back(line_string_.at(i - 1), line_string_.at(i));
+    indexed_segments.emplace_back(segments_.back(), i - 1);
+  }
+  rtree_ = decltype(rtree_)(indexed_segments.begin(), indexed_segments.end());
+}
+
+double IndexedBound::distance(const LinearRing2d & footprint, size_t & segment_idx) const
+{
+  if (segments_.empty()) {
+    return boost::geometry::distance(footprint, line_string_);
+  }
+
+  // The segments are visited in the order of the distance from the envelope of the footprint,
+  // which is not larger than the one from the footprint. Once it reaches the minimum distance,
+  // the rest of the segments cannot be closer.
+  Box2d envelope;
+  boost::geometry::envelope(footprint, envelope);
+
+  // The distance from the closest segment of the nearby footprint makes the search stop early.
+  double min_dist = std::numeric_limits<double>::max();
+  if (segment_idx < segments_.size()) {
+    min_dist = boost::geometry::distance(footprint, segments_.at(segment_idx));
+  }
+  for (auto itr = rtree_.qbegin(boost::geometry::index::nearest(envelope, rtree_.size()));
+       itr != rtree_.qend(); ++itr) {
+    if (min_dist <= boost::geometry::distance(envelope, itr->first)) {
+      break;
+    }
+    const double dist = boost::geometry::distance(footprint, itr->first);
+    if (dist < min_dist) {
+      min_dist = dist;
+      segment_idx = itr->second;
+    }
+  }
+  return min_dist;
+}
+
+RouteLaneletIndex::RouteLaneletIndex(const lanelet::ConstLanelets & route_lanelets)
+{
+  std::vector<std::pair<Box2d, size_t>> indexed_envelopes;
+  for (size_t i = 0; i < route_lanelets.size(); ++i) {
+    polygons_.push_back(route_lanelets.at(i).polygon2d().basicPolygon());
+
+    Box2d envelope;
+    boost::geometry::assign_inverse(envelope);
+    for (const auto & point : polygons_.back()) {
+      boost::geometry::expand(envelope, Point2d(point.x(), point.y()));
+    }
+    envelopes_.push_back(envelope);
+    indexed_envelopes.emplace_back(envelope, i);
+  }
+  rtree_ = decltype(rtree_)(indexed_envelopes.begin(), indexed_envelopes.end());
+}
+
+bool RouteLaneletIndex::is_inside(
+  const size_t lanelet_idx, const geometry_msgs::msg::Point & point) const
+{
+  if (!boost::geometry::covered_by(Point2d(point.x, point.y), envelopes_.at(lanelet_idx))) {
+    return false;
+  }
+  const lanelet::BasicPoint2d lanelet_point(point.x, point.y);
+  return boost::geometry::within(lanelet_point, polygons_.at(lanelet_idx));
+}
+
+std::optional<size_t> RouteLaneletIndex::find_first_lanelet(
+  const geometry_msgs::msg::Point & point) const
+{
+  std::vector<std::pair<Box2d, size_t>> candidates;
+  rtree_.query(
+    boost::geometry::index::covers(Point2d(point.x, point.y)), std::back_inserter(candidates));
+
+  const lanelet::BasicPoint2d lanelet_point(point.x, point.y);
+  std::optional<size_t> first_lanelet_idx{std::nullopt};
+  for (const auto & candidate : candidates) {
+    if (first_lanelet_idx && *first_lanelet_idx < candidate.second) {
+      continue;
+    }
+    if (boost::geometry::within(lanelet_point, polygons_.at(candidate.second))) {
+      first_lanelet_idx = candidate.second;
+    }
+  }
+  return first_lanelet_idx;
+}
+
 }  // namespace utils
 }  // namespace autoware::static_centerline_generator
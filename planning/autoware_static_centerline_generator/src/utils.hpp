@@ -21,7 +21,11 @@
 
 #include <rclcpp/time.hpp>
 
+#include <boost/geometry/index/rtree.hpp>
+
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -72,6 +76,55 @@ void create_points_marker(
 MarkerArray create_delete_all_marker_array(
   const std::vector<std::string> & ns_vec, const rclcpp::Time & now);
 
+// Markers published to a topic with their namespaces and ids as the keys
+using PublishedMarkers = std::map<std::pair<std::string, int32_t>, Marker>;
+
+// Update published_markers to marker_array, and return the difference to publish, which is the
+// added and modified markers of marker_array and the DELETE markers of the others.
+MarkerArray update_published_markers(
+  PublishedMarkers & published_markers, const MarkerArray & marker_array, const rclcpp::Time & now);
+
+// Bound of a lanelet whose segments are indexed with an R-tree, so that the distance from a
+// footprint is computed only with the segments around it
+class IndexedBound
+{
+public:
+  explicit IndexedBound(const lanelet::ConstLineString3d & bound);
+
+  // The same value as boost::geometry::distance(footprint, line_string()). segment_idx is the
+  // closest segment of a nearby footprint as a starting point of the search, which is updated to
+  // the closest one of this footprint
+  double distance(const LinearRing2d & footprint, size_t & segment_idx) const;
+
+  const LineString2d & line_string() const { return line_string_; }
+
+private:
+  LineString2d line_string_;
+  std::vector<Segment2d> segments_;
+  boost::geometry::index::rtree<std::pair<Segment2d, size_t>, boost::geometry::index::rstar<16>>
+    rtree_;
+};
+
+// Lanelets of a route whose polygons are created once and whose envelopes are indexed with an
+// R-tree, so that checking which lanelet contains a point does not create the polygons every time
+class RouteLaneletIndex
+{
+public:
+  explicit RouteLaneletIndex(const lanelet::ConstLanelets & route_lanelets);
+
+  // The same value as lanelet::geometry::inside(route_lanelets.at(lanelet_idx), point)
+  bool is_inside(const size_t lanelet_idx, const geometry_msgs::msg::Point & point) const;
+
+  // Index of the first lanelet in the route which contains the point
+  std::optional<size_t> find_first_lanelet(const geometry_msgs::msg::Point & point) const;
+
+private:
+  std::vector<lanelet::BasicPolygon2d> polygons_;
+  std::vector<Box2d> envelopes_;
+  boost::geometry::index::rtree<std::pair<Box2d, size_t>, boost::geometry::index::rstar<16>>
+    rtree_;
+};
+
 }  // namespace utils
 }  // namespace autoware::static_centerline_generator
 
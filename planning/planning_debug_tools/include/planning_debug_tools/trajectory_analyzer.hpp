@@ -18,6 +18,7 @@
 #include "autoware/motion_utils/trajectory/trajectory.hpp"
 #include "autoware/universe_utils/geometry/geometry.hpp"
 #include "planning_debug_tools/msg/trajectory_debug_info.hpp"
+#include "planning_debug_tools/msg/trajectory_debug_info_compressed.hpp"
 #include "planning_debug_tools/util.hpp"
 #include "rclcpp/rclcpp.hpp"
 
@@ -27,6 +28,7 @@
 #include "autoware_planning_msgs/msg/trajectory.hpp"
 #include "nav_msgs/msg/odometry.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -40,26 +42,77 @@ using autoware_planning_msgs::msg::Path;
 using autoware_planning_msgs::msg::Trajectory;
 using nav_msgs::msg::Odometry;
 using planning_debug_tools::msg::TrajectoryDebugInfo;
+using planning_debug_tools::msg::TrajectoryDebugInfoCompressed;
+
+// Resolutions of the metrics in TrajectoryDebugInfoCompressed
+struct CompressionResolutions
+{
+  double arclength{0.01};
+  double curvature{1e-4};
+  double velocity{0.01};
+  double acceleration{0.01};
+  double yaw{1e-3};
+};
+
+struct AnalyzerOptions
+{
+  MetricSelection metrics;
+  // Analyze only one of every decimation messages.
+  size_t decimation{1};
+  // Minimum arc length between the published points. 0 publishes all the points.
+  double resampling_interval{0.0};
+  // Increase of the interval per meter from ego, e.g. 0.1 doubles the interval at 10 m.
+  double resampling_interval_increase_rate{0.0};
+  // Publish TrajectoryDebugInfoCompressed instead of TrajectoryDebugInfo.
+  bool compressed{false};
+  CompressionResolutions resolutions;
+};
 
 template <typename T>
 class TrajectoryAnalyzer
 {
   using SubscriberType = typename rclcpp::Subscription<T>::SharedPtr;
   using PublisherType = rclcpp::Publisher<TrajectoryDebugInfo>::SharedPtr;
+  using CompressedPublisherType = rclcpp::Publisher<TrajectoryDebugInfoCompressed>::SharedPtr;
   using T_ConstSharedPtr = typename T::ConstSharedPtr;
 
 public:
-  TrajectoryAnalyzer(rclcpp::Node * node, const std::string & sub_name)
-  : node_(node), name_(sub_name)
+  TrajectoryAnalyzer(
+    rclcpp::Node * node, const std::string & sub_name,
+    const AnalyzerOptions & options = AnalyzerOptions{})
+  : node_(node), name_(sub_name), options_(options), metric_selection_(options.metrics)
   {
-    const auto pub_name = sub_name + "/debug_info";
-    pub_ = node->create_publisher<TrajectoryDebugInfo>(pub_name, 1);
+    // NOTE: Each analyzer has its own callback group so that the analyzers run in parallel on a
+    //       multi-threaded executor.
+    callback_group_ = node->create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+    rclcpp::SubscriptionOptions sub_options;
+    sub_options.callback_group = callback_group_;
+    // NOTE: The paths of the planners in the same container are received without a copy.
+    sub_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+
+    if (options_.compressed) {
+      const auto pub_name = sub_name + "/debug_info_compressed";
+      compressed_pub_ = node->create_publisher<TrajectoryDebugInfoCompressed>(pub_name, 1);
+    } else {
+      const auto pub_name = sub_name + "/debug_info";
+      pub_ = node->create_publisher<TrajectoryDebugInfo>(pub_name, 1);
+    }
     sub_ = node->create_subscription<T>(
-      sub_name, 1, [this](const T_ConstSharedPtr msg) { run(msg->points); });
+      sub_name, 1,
+      [this](const T_ConstSharedPtr msg) {
+        if (msg_count_++ % std::max<size_t>(options_.decimation, 1) != 0) return;
+        run(msg->points);
+      },
+      sub_options);
   }
   ~TrajectoryAnalyzer() = default;
 
-  void setKinematics(const Odometry::ConstSharedPtr input) { ego_kinematics_ = input; }
+  // NOTE: The kinematics is set and read by different threads, so the pointer is exchanged
+  //       atomically.
+  void setKinematics(const Odometry::ConstSharedPtr input)
+  {
+    std::atomic_store(&ego_kinematics_, input);
+  }
 
   // Note: the lambda used in the subscriber captures "this", so any operations that change the
   // address of "this" are prohibited.
@@ -69,38 +122,82 @@ public:
   auto operator=(TrajectoryAnalyzer &&) -> TrajectoryAnalyzer & = delete;       // move assignment
 
 public:
-  std::shared_ptr<rclcpp::Node> node_;
+  rclcpp::Node * node_;
   std::string name_;
+  AnalyzerOptions options_;
+  MetricSelection metric_selection_;
+  rclcpp::CallbackGroup::SharedPtr callback_group_;
   PublisherType pub_;
+  CompressedPublisherType compressed_pub_;
   SubscriberType sub_;
+  size_t msg_count_{0};
   Odometry::ConstSharedPtr ego_kinematics_;
 
+  // NOTE: The message is reused so that the buffers of the arrays are not allocated every time.
+  TrajectoryDebugInfo data_;
+  TrajectoryDebugInfoCompressed compressed_data_;
+  std::vector<size_t> resampled_indices_;
+
   template <typename P>
   void run(const P & points)
   {
-    if (!ego_kinematics_) return;
+    const auto ego_kinematics = std::atomic_load(&ego_kinematics_);
+    if (!ego_kinematics) return;
     if (points.size() < 3) return;
 
-    const auto & ego_p = ego_kinematics_->pose.pose.position;
+    const auto & ego_p = ego_kinematics->pose.pose.position;
 
-    TrajectoryDebugInfo data;
+    auto & data = data_;
     data.stamp = node_->now();
     data.size = points.size();
-    data.curvature = autoware::motion_utils::calcCurvature(points);
-    const auto arclength_offset = autoware::motion_utils::calcSignedArcLength(points, 0, ego_p);
-    data.arclength = calcPathArcLengthArray(points, -arclength_offset);
-    data.velocity = getVelocityArray(points);
-    data.acceleration = getAccelerationArray(points);
-    data.yaw = getYawArray(points);
+    const bool is_resampled = 0.0 < options_.resampling_interval;
+    const auto arclength_offset = metric_selection_.arclength || is_resampled
+                                    ? autoware::motion_utils::calcSignedArcLength(points, 0, ego_p)
+                                    : 0.0;
+    calcTrajectoryMetrics(
+      points, -arclength_offset, metric_selection_, data.arclength, data.curvature, data.velocity,
+      data.acceleration, data.yaw);
 
     if (
-      data.size != data.arclength.size() || data.size != data.velocity.size() ||
-      data.size != data.yaw.size()) {
+      (metric_selection_.arclength && data.size != data.arclength.size()) ||
+      (metric_selection_.velocity && data.size != data.velocity.size()) ||
+      (metric_selection_.yaw && data.size != data.yaw.size())) {
       RCLCPP_ERROR(node_->get_logger(), "computation failed.");
       return;
     }
 
-    pub_->publish(data);
+    // NOTE: The metrics are calculated with all the points before resampling, so that the
+    //       curvature and acceleration are not changed by the resampling.
+    if (is_resampled) {
+      calcResampledIndices(
+        points, arclength_offset, options_.resampling_interval,
+        options_.resampling_interval_increase_rate, resampled_indices_);
+      for (auto * arr :
+           {&data.arclength, &data.curvature, &data.velocity, &data.acceleration, &data.yaw}) {
+        extractIndices(resampled_indices_, *arr);
+      }
+      data.size = resampled_indices_.size();
+    }
+
+    if (!options_.compressed) {
+      pub_->publish(data);
+      return;
+    }
+
+    auto & compressed = compressed_data_;
+    compressed.stamp = data.stamp;
+    compressed.size = data.size;
+    compressed.arclength_resolution = options_.resolutions.arclength;
+    compressed.curvature_resolution = options_.resolutions.curvature;
+    compressed.velocity_resolution = options_.resolutions.velocity;
+    compressed.acceleration_resolution = options_.resolutions.acceleration;
+    compressed.yaw_resolution = options_.resolutions.yaw;
+    deltaEncode(data.arclength, compressed.arclength_resolution, compressed.arclength);
+    deltaEncode(data.curvature, compressed.curvature_resolution, compressed.curvature);
+    deltaEncode(data.velocity, compressed.velocity_resolution, compressed.velocity);
+    deltaEncode(data.acceleration, compressed.acceleration_resolution, compressed.acceleration);
+    deltaEncode(data.yaw, compressed.yaw_resolution, compressed.yaw);
+    compressed_pub_->publish(compressed);
   }
 };
 
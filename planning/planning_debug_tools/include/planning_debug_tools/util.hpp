@@ -23,6 +23,11 @@
 #include "autoware_planning_msgs/msg/path.hpp"
 #include "autoware_planning_msgs/msg/trajectory.hpp"
 
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
 namespace planning_debug_tools
@@ -131,6 +136,188 @@ std::vector<double> calcPathArcLengthArray(const T & points, const double offset
   return out;
 }
 
+// Metrics of TrajectoryDebugInfo to be calculated
+struct MetricSelection
+{
+  bool arclength{true};
+  bool curvature{true};
+  bool velocity{true};
+  bool acceleration{true};
+  bool yaw{true};
+};
+
+// Parse the metrics separated by commas, e.g. "velocity,arclength". "all" selects all the metrics.
+inline MetricSelection parseMetricSelection(const std::string & metrics)
+{
+  if (metrics == "all") {
+    return MetricSelection{};
+  }
+
+  MetricSelection selection{false, false, false, false, false};
+  std::stringstream ss(metrics);
+  std::string metric;
+  while (std::getline(ss, metric, ',')) {
+    if (metric == "arclength") {
+      selection.arclength = true;
+    } else if (metric == "curvature") {
+      selection.curvature = true;
+    } else if (metric == "velocity") {
+      selection.velocity = true;
+    } else if (metric == "acceleration") {
+      selection.acceleration = true;
+    } else if (metric == "yaw") {
+      selection.yaw = true;
+    } else {
+      throw std::invalid_argument("unknown metric: " + metric);
+    }
+  }
+  return selection;
+}
+
+// Calculate the selected metrics of all the points in a single pass. The results are the same as
+// those of calcPathArcLengthArray, motion_utils::calcCurvature, getVelocityArray,
+// getAccelerationArray and getYawArray, and the arrays of the metrics not selected are cleared.
+// The arrays are resized in place so that their buffers are reused.
+template <class T>
+void calcTrajectoryMetrics(
+  const T & points, const double arclength_offset, const MetricSelection & selection,
+  std::vector<double> & arclength, std::vector<double> & curvature, std::vector<double> & velocity,
+  std::vector<double> & acceleration, std::vector<double> & yaw)
+{
+  const size_t size = points.size();
+  const auto resize = [&](const bool is_selected, std::vector<double> & arr) {
+    arr.resize(is_selected ? size : 0);
+  };
+  resize(selection.arclength, arclength);
+  resize(selection.curvature, curvature);
+  resize(selection.velocity, velocity);
+  resize(selection.acceleration, acceleration);
+  resize(selection.yaw, yaw);
+  if (size < 3) {
+    arclength.clear();
+    curvature.clear();
+    velocity.clear();
+    acceleration.clear();
+    yaw.clear();
+    return;
+  }
+
+  double sum = arclength_offset;
+  double prev_segment_length = 0.0;
+  double prev_segment_acc = 0.0;
+  for (size_t i = 0; i < size; ++i) {
+    const auto p = getPoint(points.at(i));
+    const double vel = getVelocity(points.at(i));
+
+    // values of the segment from the point to the next one
+    const bool has_next = i + 1 < size;
+    const double segment_length = has_next ? calcDistance2d(p, getPoint(points.at(i + 1))) : 0.0;
+    const double segment_acc = [&]() {
+      if (!has_next || segment_length == 0.0) {
+        return 0.0;
+      }
+      const double next_vel = getVelocity(points.at(i + 1));
+      return (std::pow(next_vel, 2) - std::pow(vel, 2)) / 2.0 / segment_length;
+    }();
+
+    if (selection.arclength) {
+      arclength[i] = sum;
+      sum += segment_length;
+    }
+    if (selection.velocity) {
+      velocity[i] = vel;
+    }
+    if (selection.yaw) {
+      yaw[i] = getYaw(points.at(i));
+    }
+    if (selection.acceleration) {
+      if (i == 0) {
+        acceleration[i] = segment_acc;
+      } else if (i == size - 1 || i == size - 2) {
+        // Ignore the last two acceleration values as getAccelerationArray does.
+        acceleration[i] = 0.0;
+      } else {
+        acceleration[i] = (prev_segment_acc + segment_acc) / 2.0;
+      }
+    }
+    if (selection.curvature && 0 < i && has_next) {
+      // same as autoware::universe_utils::calcCurvature with the segment lengths reused
+      const auto p1 = getPoint(points.at(i - 1));
+      const auto p3 = getPoint(points.at(i + 1));
+      const double denominator = prev_segment_length * segment_length * calcDistance2d(p3, p1);
+      if (std::fabs(denominator) < 1e-10) {
+        throw std::runtime_error("points are too close for curvature calculation.");
+      }
+      curvature[i] =
+        2.0 * ((p.x - p1.x) * (p3.y - p1.y) - (p.y - p1.y) * (p3.x - p1.x)) / denominator;
+    }
+
+    prev_segment_length = segment_length;
+    prev_segment_acc = segment_acc;
+  }
+
+  if (selection.curvature) {
+    curvature.front() = curvature.at(1);
+    curvature.back() = curvature.at(size - 2);
+  }
+}
+
+// Select the indices of the points to be kept so that the arc length between the kept points is
+// at least the interval. The interval increases by increase_rate per meter from ego_arclength, so
+// that the points around ego keep the finest resolution. The first and last points are always kept.
+template <class T>
+void calcResampledIndices(
+  const T & points, const double ego_arclength, const double interval, const double increase_rate,
+  std::vector<size_t> & indices)
+{
+  indices.clear();
+  if (points.empty()) {
+    return;
+  }
+
+  indices.push_back(0);
+  double arclength = 0.0;
+  double last_kept_arclength = 0.0;
+  for (size_t i = 1; i < points.size(); ++i) {
+    arclength += calcDistance2d(getPoint(points.at(i - 1)), getPoint(points.at(i)));
+    const double current_interval =
+      interval * (1.0 + increase_rate * std::abs(arclength - ego_arclength));
+    if (i + 1 == points.size() || current_interval <= arclength - last_kept_arclength) {
+      indices.push_back(i);
+      last_kept_arclength = arclength;
+    }
+  }
+}
+
+// Keep only the elements at the indices, which must be in ascending order.
+inline void extractIndices(const std::vector<size_t> & indices, std::vector<double> & arr)
+{
+  if (arr.empty()) {
+    return;
+  }
+  for (size_t i = 0; i < indices.size(); ++i) {
+    arr[i] = arr[indices[i]];
+  }
+  arr.resize(indices.size());
+}
+
+// Quantize the values by the resolution and encode each of them as the difference from the
+// previous one. See TrajectoryDebugInfoCompressed.msg for the format.
+inline void deltaEncode(
+  const std::vector<double> & values, const double resolution, std::vector<int32_t> & out)
+{
+  out.resize(values.size());
+  int64_t prev_q = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    // NOTE: A value which is not finite is encoded as the same as the previous one.
+    const auto q = std::isfinite(values[i])
+                     ? static_cast<int64_t>(std::llround(values[i] / resolution))
+                     : prev_q;
+    out[i] = static_cast<int32_t>(q - prev_q);
+    prev_q = q;
+  }
+}
+
 }  // namespace planning_debug_tools
 
 #endif  // PLANNING_DEBUG_TOOLS__UTIL_HPP_
@@ -21,10 +21,13 @@
 #include <visualization_msgs/msg/marker.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace planning_debug_tools
 {
@@ -41,20 +44,83 @@ public:
   : Node("stop_reason_visualizer", options)
   {
     pub_stop_reasons_marker_ = create_publisher<MarkerArray>("~/debug/markers", 1);
+    // NOTE: The stop reasons of the planners in the same container are received without a copy.
+    rclcpp::SubscriptionOptions sub_options;
+    sub_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
     sub_stop_reasons_ = create_subscription<StopReasonArray>(
       "/planning/scenario_planning/status/stop_reasons", rclcpp::QoS{1},
-      std::bind(&StopReasonVisualizerNode::onStopReasonArray, this, _1));
+      std::bind(&StopReasonVisualizerNode::onStopReasonArray, this, _1), sub_options);
+
+    // NOTE: The markers are published at most at this rate, with the latest stop reasons.
+    const double publish_rate = declare_parameter<double>("publish_rate", 10.0);
+    timer_ = rclcpp::create_timer(
+      this, get_clock(), rclcpp::Rate(std::max(publish_rate, 1e-3)).period(),
+      std::bind(&StopReasonVisualizerNode::onTimer, this));
   }
 
 private:
-  void onStopReasonArray(const StopReasonArray::ConstSharedPtr msg)
+  // Marker published last time, and whether it is still in the latest stop reasons.
+  struct PooledMarker
+  {
+    Marker marker;
+    bool is_used{false};
+  };
+  using MarkerKey = std::pair<std::string, int32_t>;
+
+  void onStopReasonArray(const StopReasonArray::ConstSharedPtr msg) { stop_reasons_ = msg; }
+
+  void onTimer()
+  {
+    if (!stop_reasons_) return;
+    const auto msg = stop_reasons_;
+    stop_reasons_ = nullptr;
+
+    changed_markers_.markers.clear();
+    publishMarkers(msg);
+  }
+
+  static bool isSameMarker(const Marker & a, const Marker & b)
+  {
+    return a.type == b.type && a.header.frame_id == b.header.frame_id && a.pose == b.pose &&
+           a.scale == b.scale && a.color == b.color && a.points == b.points && a.text == b.text;
+  }
+
+  // Add the marker to the changed markers unless the same marker was published last time.
+  void updateMarker(const Marker & marker)
+  {
+    auto & pooled = marker_pool_[MarkerKey{marker.ns, marker.id}];
+    pooled.is_used = true;
+    if (!pooled.marker.ns.empty() && isSameMarker(pooled.marker, marker)) return;
+    pooled.marker = marker;
+    changed_markers_.markers.push_back(marker);
+  }
+
+  // Delete the markers which are not in the latest stop reasons, and publish the changed markers.
+  void flushMarkers(const rclcpp::Time & current_time)
+  {
+    for (auto it = marker_pool_.begin(); it != marker_pool_.end();) {
+      if (it->second.is_used) {
+        it->second.is_used = false;
+        ++it;
+        continue;
+      }
+      auto delete_marker = it->second.marker;
+      delete_marker.header.stamp = current_time;
+      delete_marker.action = Marker::DELETE;
+      changed_markers_.markers.push_back(delete_marker);
+      it = marker_pool_.erase(it);
+    }
+
+    if (changed_markers_.markers.empty()) return;
+    pub_stop_reasons_marker_->publish(changed_markers_);
+  }
+
+  void publishMarkers(const StopReasonArray::ConstSharedPtr msg)
   {
-    using autoware::universe_utils::appendMarkerArray;
     using autoware::universe_utils::createDefaultMarker;
     using autoware::universe_utils::createMarkerColor;
     using autoware::universe_utils::createMarkerScale;
 
-    MarkerArray all_marker_array;
     const auto header = msg->header;
     const double offset_z = 1.0;
     for (auto stop_reason : msg->stop_reasons) {
@@ -62,7 +128,6 @@ private:
       if (reason.empty()) continue;
       const auto current_time = this->now();
       int id = 0;
-      MarkerArray marker_array;
       for (auto stop_factor : stop_reason.stop_factors) {
         if (stop_factor.stop_factor_points.empty()) continue;
         std::string prefix = reason + "[" + std::to_string(id) + "]";
@@ -73,7 +138,7 @@ private:
             "map", current_time, prefix + ":stop_factor_point", id, Marker::SPHERE,
             createMarkerScale(0.25, 0.25, 0.25), createMarkerColor(1.0, 0.0, 0.0, 0.999));
           stop_point_marker.pose.position = stop_factor_point;
-          marker_array.markers.emplace_back(stop_point_marker);
+          updateMarker(stop_point_marker);
         }
         // attention ! marker
         {
@@ -84,7 +149,7 @@ private:
           attention_text_marker.pose.position = stop_factor_point;
           attention_text_marker.pose.position.z += offset_z;
           attention_text_marker.text = "!";
-          marker_array.markers.emplace_back(attention_text_marker);
+          updateMarker(attention_text_marker);
         }
         // point to pose
         {
@@ -93,7 +158,7 @@ private:
             createMarkerScale(0.02, 0.0, 0.0), createMarkerColor(0.0, 1.0, 1.0, 0.999));
           stop_to_pose_marker.points.emplace_back(stop_factor.stop_factor_points.front());
           stop_to_pose_marker.points.emplace_back(stop_factor.stop_pose.position);
-          marker_array.markers.emplace_back(stop_to_pose_marker);
+          updateMarker(stop_to_pose_marker);
         }
         // point to pose
         {
@@ -101,7 +166,7 @@ private:
             "map", current_time, prefix + ":stop_pose", id, Marker::ARROW,
             createMarkerScale(0.4, 0.2, 0.2), createMarkerColor(1.0, 0.0, 0.0, 0.999));
           stop_pose_marker.pose = stop_factor.stop_pose;
-          marker_array.markers.emplace_back(stop_pose_marker);
+          updateMarker(stop_pose_marker);
         }
         // add view distance text
         {
@@ -110,17 +175,21 @@ private:
             createMarkerScale(0.0, 0.0, 0.2), createMarkerColor(1.0, 1.0, 1.0, 0.999));
           reason_text_marker.pose = stop_factor.stop_pose;
           reason_text_marker.text = prefix;
-          marker_array.markers.emplace_back(reason_text_marker);
+          updateMarker(reason_text_marker);
         }
         id++;
       }
-      if (!marker_array.markers.empty())
-        appendMarkerArray(marker_array, &all_marker_array, current_time);
     }
-    pub_stop_reasons_marker_->publish(all_marker_array);
+    flushMarkers(this->now());
   }
   rclcpp::Publisher<MarkerArray>::SharedPtr pub_stop_reasons_marker_;
   rclcpp::Subscription<StopReasonArray>::SharedPtr sub_stop_reasons_;
+  rclcpp::TimerBase::SharedPtr timer_;
+
+  StopReasonArray::ConstSharedPtr stop_reasons_;
+  std::map<MarkerKey, PooledMarker> marker_pool_;
+  // NOTE: The array is reused so that its buffer is not allocated every time.
+  MarkerArray changed_markers_;
 };
 }  // namespace planning_debug_tools
 
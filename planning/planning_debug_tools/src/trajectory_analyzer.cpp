@@ -14,12 +14,42 @@
 
 #include "planning_debug_tools/trajectory_analyzer.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 namespace planning_debug_tools
 {
+namespace
+{
+// The options of each topic. The metrics and decimations are given per topic, and if they are not
+// given, all the metrics of all the messages are calculated.
+std::vector<AnalyzerOptions> getAnalyzerOptions(
+  const std::vector<std::string> & topics, const std::vector<std::string> & metrics,
+  const std::vector<int64_t> & decimations, const AnalyzerOptions & common_options)
+{
+  if (!metrics.empty() && metrics.size() != topics.size()) {
+    throw std::invalid_argument("the sizes of the topics and their metrics are different.");
+  }
+  if (!decimations.empty() && decimations.size() != topics.size()) {
+    throw std::invalid_argument("the sizes of the topics and their decimations are different.");
+  }
+
+  std::vector<AnalyzerOptions> options(topics.size(), common_options);
+  for (size_t i = 0; i < topics.size(); ++i) {
+    if (!metrics.empty()) {
+      options.at(i).metrics = parseMetricSelection(metrics.at(i));
+    }
+    if (!decimations.empty()) {
+      options.at(i).decimation = static_cast<size_t>(std::max<int64_t>(decimations.at(i), 1));
+    }
+  }
+  return options;
+}
+}  // namespace
+
 TrajectoryAnalyzerNode::TrajectoryAnalyzerNode(const rclcpp::NodeOptions & options)
 : Node("trajectory_analyzer", options)
 {
@@ -28,24 +58,64 @@ TrajectoryAnalyzerNode::TrajectoryAnalyzerNode(const rclcpp::NodeOptions & optio
   const auto path_with_lane_id_topics = declare_parameter<TopicNames>("path_with_lane_id_topics");
   const auto trajectory_topics = declare_parameter<TopicNames>("trajectory_topics");
 
-  for (const auto & s : path_topics) {
-    path_analyzers_.push_back(std::make_shared<TrajectoryAnalyzer<Path>>(this, s));
+  // the options common to all the topics
+  AnalyzerOptions common_options;
+  common_options.resampling_interval = declare_parameter<double>("resampling.interval", 0.0);
+  common_options.resampling_interval_increase_rate =
+    declare_parameter<double>("resampling.interval_increase_rate", 0.0);
+  common_options.compressed = declare_parameter<bool>("compression.enable", false);
+  auto & resolutions = common_options.resolutions;
+  resolutions.arclength =
+    declare_parameter<double>("compression.resolution.arclength", resolutions.arclength);
+  resolutions.curvature =
+    declare_parameter<double>("compression.resolution.curvature", resolutions.curvature);
+  resolutions.velocity =
+    declare_parameter<double>("compression.resolution.velocity", resolutions.velocity);
+  resolutions.acceleration =
+    declare_parameter<double>("compression.resolution.acceleration", resolutions.acceleration);
+  resolutions.yaw = declare_parameter<double>("compression.resolution.yaw", resolutions.yaw);
+
+  // the metrics of each topic, e.g. "velocity,arclength", and the decimation of each topic
+  using Decimations = std::vector<int64_t>;
+  const auto path_options = getAnalyzerOptions(
+    path_topics, declare_parameter<TopicNames>("path_metrics", TopicNames{}),
+    declare_parameter<Decimations>("path_decimations", Decimations{}), common_options);
+  const auto path_with_lane_id_options = getAnalyzerOptions(
+    path_with_lane_id_topics,
+    declare_parameter<TopicNames>("path_with_lane_id_metrics", TopicNames{}),
+    declare_parameter<Decimations>("path_with_lane_id_decimations", Decimations{}),
+    common_options);
+  const auto trajectory_options = getAnalyzerOptions(
+    trajectory_topics, declare_parameter<TopicNames>("trajectory_metrics", TopicNames{}),
+    declare_parameter<Decimations>("trajectory_decimations", Decimations{}), common_options);
+
+  for (size_t i = 0; i < path_topics.size(); ++i) {
+    const auto & s = path_topics.at(i);
+    path_analyzers_.push_back(
+      std::make_shared<TrajectoryAnalyzer<Path>>(this, s, path_options.at(i)));
     RCLCPP_INFO(get_logger(), "path_topics: %s", s.c_str());
   }
-  for (const auto & s : path_with_lane_id_topics) {
+  for (size_t i = 0; i < path_with_lane_id_topics.size(); ++i) {
+    const auto & s = path_with_lane_id_topics.at(i);
     path_with_lane_id_analyzers_.push_back(
-      std::make_shared<TrajectoryAnalyzer<PathWithLaneId>>(this, s));
+      std::make_shared<TrajectoryAnalyzer<PathWithLaneId>>(
+        this, s, path_with_lane_id_options.at(i)));
     RCLCPP_INFO(get_logger(), "path_with_lane_id_topics: %s", s.c_str());
   }
 
-  for (const auto & s : trajectory_topics) {
-    trajectory_analyzers_.push_back(std::make_shared<TrajectoryAnalyzer<Trajectory>>(this, s));
+  for (size_t i = 0; i < trajectory_topics.size(); ++i) {
+    const auto & s = trajectory_topics.at(i);
+    trajectory_analyzers_.push_back(
+      std::make_shared<TrajectoryAnalyzer<Trajectory>>(this, s, trajectory_options.at(i)));
     RCLCPP_INFO(get_logger(), "trajectory_topics: %s", s.c_str());
   }
 
   using std::placeholders::_1;
+  rclcpp::SubscriptionOptions sub_options;
+  sub_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   sub_ego_kinematics_ = create_subscription<Odometry>(
-    "ego_kinematics", 1, std::bind(&TrajectoryAnalyzerNode::onEgoKinematics, this, _1));
+    "ego_kinematics", 1, std::bind(&TrajectoryAnalyzerNode::onEgoKinematics, this, _1),
+    sub_options);
 }
 
 void TrajectoryAnalyzerNode::onEgoKinematics(const Odometry::ConstSharedPtr msg)
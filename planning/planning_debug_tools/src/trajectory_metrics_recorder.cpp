@@ -0,0 +1,344 @@
+// Copyright 2024 TIER IV, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Calculate the metrics of the trajectory analyzer for every message of the Path, PathWithLaneId
+// and Trajectory topics of a bag without playing it back. The messages are read in order and
+// processed in batches by parallel threads, and the metrics of each topic are written to
+// <output_dir>/<topic>.metrics in columns:
+//   char[8]  magic "TRJMET1"
+//   uint32   selected metrics, bit 0 to 4 for arclength, curvature, velocity, acceleration and yaw
+//   uint32   reserved
+//   uint64   number of messages N
+//   uint64   number of points P
+//   int64[N] receive times of the messages [ns]
+//   uint32[N] numbers of points of the messages
+//   float64[P] one column per selected metric in the order of the bits
+
+#include "planning_debug_tools/util.hpp"
+
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/metadata_io.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include "nav_msgs/msg/odometry.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using autoware_internal_planning_msgs::msg::PathWithLaneId;
+using autoware_planning_msgs::msg::Path;
+using autoware_planning_msgs::msg::Trajectory;
+using nav_msgs::msg::Odometry;
+using planning_debug_tools::MetricSelection;
+using SerializedBagMessage = rosbag2_storage::SerializedBagMessage;
+
+enum class TopicType { PATH, PATH_WITH_LANE_ID, TRAJECTORY };
+
+// the metrics in the order of the columns
+constexpr size_t metric_num = 5;
+using Metrics = std::array<std::vector<double>, metric_num>;
+
+std::array<bool, metric_num> toArray(const MetricSelection & s)
+{
+  return {s.arclength, s.curvature, s.velocity, s.acceleration, s.yaw};
+}
+
+struct TopicColumns
+{
+  std::string name;
+  TopicType type;
+  std::vector<int64_t> stamps;
+  std::vector<uint32_t> sizes;
+  Metrics metrics;
+};
+
+struct Job
+{
+  size_t topic;
+  std::shared_ptr<SerializedBagMessage> message;
+  Odometry::ConstSharedPtr kinematics;
+  Metrics metrics;
+  size_t size{0};
+  bool is_valid{false};
+};
+
+template <typename T>
+T deserialize(const SerializedBagMessage & bag_message)
+{
+  rclcpp::SerializedMessage msg(*bag_message.serialized_data);
+  T out;
+  rclcpp::Serialization<T>().deserialize_message(&msg, &out);
+  return out;
+}
+
+// the same metrics as TrajectoryAnalyzer::run before resampling, with the arc length from the
+// start of the points if no kinematics is given
+template <typename P>
+bool analyzePoints(
+  const P & points, const Odometry * kinematics, const MetricSelection & selection, Job & job)
+{
+  if (points.size() < 3) return false;
+  auto & m = job.metrics;
+  const auto offset = selection.arclength && kinematics
+                        ? autoware::motion_utils::calcSignedArcLength(
+                            points, 0, kinematics->pose.pose.position)
+                        : 0.0;
+  planning_debug_tools::calcTrajectoryMetrics(
+    points, -offset, selection, m[0], m[1], m[2], m[3], m[4]);
+  job.size = points.size();
+  return true;
+}
+
+void analyze(const TopicType type, const MetricSelection & selection, Job & job)
+{
+  const auto * kinematics = job.kinematics.get();
+  try {
+    if (type == TopicType::PATH) {
+      const auto msg = deserialize<Path>(*job.message);
+      job.is_valid = analyzePoints(msg.points, kinematics, selection, job);
+    } else if (type == TopicType::PATH_WITH_LANE_ID) {
+      const auto msg = deserialize<PathWithLaneId>(*job.message);
+      job.is_valid = analyzePoints(msg.points, kinematics, selection, job);
+    } else {
+      const auto msg = deserialize<Trajectory>(*job.message);
+      job.is_valid = analyzePoints(msg.points, kinematics, selection, job);
+    }
+  } catch (const std::exception &) {
+    // e.g. the points are too close for the curvature
+    job.is_valid = false;
+  }
+}
+
+bool writeColumns(
+  const std::string & path, const TopicColumns & columns, const MetricSelection & selection)
+{
+  std::ofstream ofs(path, std::ios::binary);
+  if (!ofs) return false;
+
+  const auto selected = toArray(selection);
+  uint32_t mask = 0;
+  for (size_t i = 0; i < metric_num; ++i) {
+    mask |= selected[i] ? 1u << i : 0u;
+  }
+  const uint32_t reserved = 0;
+  const uint64_t message_num = columns.stamps.size();
+  uint64_t point_num = 0;
+  for (const auto size : columns.sizes) {
+    point_num += size;
+  }
+
+  const auto write = [&ofs](const void * data, const size_t size) {
+    ofs.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+  };
+  const char magic[8] = "TRJMET1";
+  write(magic, sizeof(magic));
+  write(&mask, sizeof(mask));
+  write(&reserved, sizeof(reserved));
+  write(&message_num, sizeof(message_num));
+  write(&point_num, sizeof(point_num));
+  write(columns.stamps.data(), columns.stamps.size() * sizeof(int64_t));
+  write(columns.sizes.data(), columns.sizes.size() * sizeof(uint32_t));
+  for (size_t i = 0; i < metric_num; ++i) {
+    if (selected[i]) {
+      write(columns.metrics[i].data(), columns.metrics[i].size() * sizeof(double));
+    }
+  }
+  return static_cast<bool>(ofs);
+}
+
+// /planning/scenario_planning/trajectory -> planning__scenario_planning__trajectory
+std::string toFileName(const std::string & topic)
+{
+  std::string name;
+  for (const auto c : topic.substr(topic.find_first_not_of('/'))) {
+    if (c == '/') {
+      name += "__";
+    } else {
+      name += c;
+    }
+  }
+  return name;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t thread_num = std::max(std::thread::hardware_concurrency(), 1u);
+  std::string metrics = "all";
+  std::string kinematics_topic;
+  std::vector<std::string> positional_args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      thread_num = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg == "-m" && i + 1 < argc) {
+      metrics = argv[++i];
+    } else if (arg == "-k" && i + 1 < argc) {
+      kinematics_topic = argv[++i];
+    } else {
+      positional_args.push_back(arg);
+    }
+  }
+  if (positional_args.size() < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " [-j thread_num] [-m metrics] [-k kinematics_topic] <bag> <output_dir> <topic>..."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string bag_path = positional_args.at(0);
+  const std::string output_dir = positional_args.at(1);
+  const std::vector<std::string> topics(positional_args.begin() + 2, positional_args.end());
+
+  MetricSelection selection;
+  try {
+    selection = planning_debug_tools::parseMetricSelection(metrics);
+  } catch (const std::exception & e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_path;
+  rosbag2_storage::MetadataIo metadata_io;
+  storage_options.storage_id = metadata_io.metadata_file_exists(bag_path)
+                                 ? metadata_io.read_metadata(bag_path).storage_identifier
+                                 : "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  // the type of each topic is given by the bag
+  std::vector<TopicColumns> columns;
+  const auto & all_topics = reader.get_all_topics_and_types();
+  for (const auto & topic : topics) {
+    const auto itr = std::find_if(all_topics.begin(), all_topics.end(), [&](const auto & t) {
+      return t.name == topic;
+    });
+    if (itr == all_topics.end()) {
+      std::cerr << topic << " is not in " << bag_path << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (itr->type == "autoware_planning_msgs/msg/Path") {
+      columns.push_back({topic, TopicType::PATH, {}, {}, {}});
+    } else if (itr->type == "autoware_internal_planning_msgs/msg/PathWithLaneId") {
+      columns.push_back({topic, TopicType::PATH_WITH_LANE_ID, {}, {}, {}});
+    } else if (itr->type == "autoware_planning_msgs/msg/Trajectory") {
+      columns.push_back({topic, TopicType::TRAJECTORY, {}, {}, {}});
+    } else {
+      std::cerr << topic << " is of an unsupported type " << itr->type << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = topics;
+  if (!kinematics_topic.empty()) {
+    storage_filter.topics.push_back(kinematics_topic);
+  }
+  reader.set_filter(storage_filter);
+
+  // The messages are given the kinematics before them as the analyzer subscribes to them, and a
+  // batch of them is analyzed in parallel and appended to the columns in order
+  const size_t batch_size = 64 * thread_num;
+  std::vector<Job> batch;
+  batch.reserve(batch_size);
+  Odometry::ConstSharedPtr kinematics;
+  size_t skipped_num = 0;
+  size_t failed_num = 0;
+
+  const auto process_batch = [&]() {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < std::min(thread_num, batch.size()); ++i) {
+      workers.emplace_back([&]() {
+        for (size_t j = next++; j < batch.size(); j = next++) {
+          analyze(columns.at(batch[j].topic).type, selection, batch[j]);
+        }
+      });
+    }
+    for (auto & worker : workers) {
+      worker.join();
+    }
+
+    const auto selected = toArray(selection);
+    for (const auto & job : batch) {
+      if (!job.is_valid) {
+        ++failed_num;
+        continue;
+      }
+      auto & c = columns.at(job.topic);
+      c.stamps.push_back(job.message->time_stamp);
+      c.sizes.push_back(static_cast<uint32_t>(job.size));
+      for (size_t i = 0; i < metric_num; ++i) {
+        if (selected[i]) {
+          c.metrics[i].insert(c.metrics[i].end(), job.metrics[i].begin(), job.metrics[i].end());
+        }
+      }
+    }
+    batch.clear();
+  };
+
+  while (reader.has_next()) {
+    auto message = reader.read_next();
+    if (message->topic_name == kinematics_topic) {
+      kinematics = std::make_shared<const Odometry>(deserialize<Odometry>(*message));
+      continue;
+    }
+    // the analyzer does not run before the kinematics is received
+    if (!kinematics_topic.empty() && !kinematics) {
+      ++skipped_num;
+      continue;
+    }
+
+    const auto topic = static_cast<size_t>(std::distance(
+      topics.begin(), std::find(topics.begin(), topics.end(), message->topic_name)));
+    batch.push_back(Job{topic, std::move(message), kinematics, {}, 0, false});
+    if (batch.size() == batch_size) {
+      process_batch();
+    }
+  }
+  process_batch();
+
+  std::filesystem::create_directories(output_dir);
+  for (const auto & c : columns) {
+    const auto path =
+      (std::filesystem::path(output_dir) / (toFileName(c.name) + ".metrics")).string();
+    if (!writeColumns(path, c, selection)) {
+      std::cerr << "Failed to write " << path << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "Wrote " << c.stamps.size() << " messages of " << c.name << " to " << path
+              << std::endl;
+  }
+  std::cout << "Skipped " << skipped_num << " messages before the kinematics, and failed "
+            << failed_num << " messages" << std::endl;
+  return EXIT_SUCCESS;
+}
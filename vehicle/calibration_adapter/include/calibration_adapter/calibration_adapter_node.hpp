@@ -19,6 +19,7 @@
 
 #include "calibration_adapter/calibration_adapter_node_base.hpp"
 #include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/ring_buffer.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 #include "autoware_control_msgs/msg/control.hpp"
@@ -26,7 +27,7 @@
 #include "geometry_msgs/msg/twist_stamped.hpp"
 #include "tier4_calibration_msgs/msg/float32_stamped.hpp"
 
-#include <vector>
+#include <cstddef>
 
 class CalibrationAdapterNode : public CalibrationAdapterNodeBase
 {
@@ -34,28 +35,34 @@ class CalibrationAdapterNode : public CalibrationAdapterNodeBase
   using ControlCommandStamped = autoware_control_msgs::msg::Control;
   using TwistStamped = geometry_msgs::msg::TwistStamped;
 
+  // only the stamp and the velocity of a twist are kept, so that the history does not allocate
+  struct VelocitySample
+  {
+    double stamp;
+    double velocity;
+  };
+
 public:
-  CalibrationAdapterNode();
+  explicit CalibrationAdapterNode(const rclcpp::NodeOptions & node_options);
 
 private:
   double acceleration_ = 0.0;
   const double dif_twist_time_ = 0.2;  // 200ms
   const std::size_t twist_vec_max_size_ = 100;
   double lowpass_cutoff_value_;
-  std::vector<TwistStamped> twist_vec_;
+  math_utils::RingBuffer<VelocitySample> twist_vec_;
+  math_utils::MovingAverage raw_acceleration_average_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_acceleration_status_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_acceleration_cmd_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_steering_angle_cmd_;
   rclcpp::Publisher<TwistStamped>::SharedPtr pub_vehicle_twist_;
   rclcpp::Subscription<ControlCommandStamped>::SharedPtr sub_control_cmd_;
   rclcpp::Subscription<Velocity>::SharedPtr sub_twist_;
-  template <class T>
-  T getNearestTimeDataFromVec(
-    const T base_data, const double back_time, const std::vector<T> & vec);
+  const VelocitySample & getNearestTimeDataFromVec(
+    const double base_stamp, const double back_time,
+    const math_utils::RingBuffer<VelocitySample> & vec) const;
   double getAccel(
-    const TwistStamped & prev_twist, const TwistStamped & current_twist, const double dt);
-  template <class T>
-  void pushDataToVec(const T data, const std::size_t max_size, std::vector<T> * vec);
+    const VelocitySample & prev_twist, const VelocitySample & current_twist, const double dt);
   void callbackControlCmd(const ControlCommandStamped::ConstSharedPtr msg);
   void callbackTwistStatus(const Velocity::ConstSharedPtr msg);
 };
@@ -21,7 +21,9 @@
 
 #include "autoware_vehicle_msgs/msg/engage.hpp"
 #include "autoware_vehicle_msgs/msg/steering_report.hpp"
+#include "std_msgs/msg/header.hpp"
 #include "tier4_calibration_msgs/msg/bool_stamped.hpp"
+#include "tier4_calibration_msgs/msg/calibration_signals.hpp"
 #include "tier4_calibration_msgs/msg/float32_stamped.hpp"
 #include "tier4_vehicle_msgs/msg/actuation_command_stamped.hpp"
 #include "tier4_vehicle_msgs/msg/actuation_status_stamped.hpp"
@@ -33,9 +35,28 @@ public:
   using ActuationStatusStamped = tier4_vehicle_msgs::msg::ActuationStatusStamped;
   using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
   using BoolStamped = tier4_calibration_msgs::msg::BoolStamped;
+  using CalibrationSignals = tier4_calibration_msgs::msg::CalibrationSignals;
   using EngageStatus = autoware_vehicle_msgs::msg::Engage;
   using SteeringAngleStatus = autoware_vehicle_msgs::msg::SteeringReport;
-  CalibrationAdapterNodeBase();
+  explicit CalibrationAdapterNodeBase(const rclcpp::NodeOptions & node_options);
+
+protected:
+  /**
+   * @brief the QoS of the outputs. They are latched, except with the intra-process communication
+   * that supports only the volatile durability.
+   */
+  rclcpp::QoS getOutputQoS() const;
+
+  /**
+   * @brief publish a Float32Stamped by a unique pointer, which is moved to an intra-process
+   * subscriber without a copy
+   */
+  static void publishFloat32Stamped(
+    const rclcpp::Publisher<Float32Stamped>::SharedPtr & pub, const std_msgs::msg::Header & header,
+    const double data);
+
+  // the latest signals, which are published together by the timer if publish_signals is set
+  CalibrationSignals signals_;
 
 private:
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_accel_status_;
@@ -46,6 +67,8 @@ private:
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_steer_cmd_;
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_steering_angle_status_;
   rclcpp::Publisher<BoolStamped>::SharedPtr pub_is_engage_;
+  rclcpp::Publisher<CalibrationSignals>::SharedPtr pub_signals_;
+  rclcpp::TimerBase::SharedPtr timer_signals_;
 
   rclcpp::Subscription<ActuationCommandStamped>::SharedPtr sub_actuation_command_;
   rclcpp::Subscription<ActuationStatusStamped>::SharedPtr sub_actuation_status_;
@@ -55,6 +78,7 @@ private:
   void onActuationCmd(const ActuationCommandStamped::ConstSharedPtr msg);
   void onActuationStatus(const ActuationStatusStamped::ConstSharedPtr msg);
   void onEngageStatus(const EngageStatus::SharedPtr msg);
+  void onSignalsTimer();
 };
 
 #endif  // CALIBRATION_ADAPTER__CALIBRATION_ADAPTER_NODE_BASE_HPP_
@@ -27,7 +27,7 @@ class PacmodCalibrationAdapterNode : public CalibrationAdapterNodeBase
 {
 public:
   using SteeringWheelStatusStamped = tier4_vehicle_msgs::msg::SteeringWheelStatusStamped;
-  PacmodCalibrationAdapterNode();
+  explicit PacmodCalibrationAdapterNode(const rclcpp::NodeOptions & node_options);
 
 private:
   rclcpp::Publisher<Float32Stamped>::SharedPtr pub_handle_status_;
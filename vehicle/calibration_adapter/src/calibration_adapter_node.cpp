@@ -18,27 +18,32 @@
 
 #include <tf2/utils.h>
 
-#include <limits>
+#include <algorithm>
+#include <cmath>
 #include <memory>
-#include <vector>
+#include <utility>
 
-CalibrationAdapterNode::CalibrationAdapterNode()
+CalibrationAdapterNode::CalibrationAdapterNode(const rclcpp::NodeOptions & node_options)
+: CalibrationAdapterNodeBase(node_options)
 {
   using std::placeholders::_1;
 
   // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
+  const auto output_qos = getOutputQoS();
   lowpass_cutoff_value_ = this->declare_parameter<double>("lowpass_cutoff_value", 0.033);
+  // the raw accelerations are averaged over this number of twists before the lowpass filter
+  raw_acceleration_average_.setWindow(static_cast<std::size_t>(
+    std::max(this->declare_parameter<int>("acceleration_average_size", 1), 1)));
+  twist_vec_.setCapacity(twist_vec_max_size_);
 
   pub_steering_angle_cmd_ =
-    create_publisher<Float32Stamped>("~/output/steering_angle_cmd", durable_qos);
+    create_publisher<Float32Stamped>("~/output/steering_angle_cmd", output_qos);
   pub_acceleration_status_ =
-    create_publisher<Float32Stamped>("~/output/acceleration_status", durable_qos);
+    create_publisher<Float32Stamped>("~/output/acceleration_status", output_qos);
   pub_acceleration_cmd_ =
-    create_publisher<Float32Stamped>("~/output/acceleration_cmd", durable_qos);
-  pub_vehicle_twist_ = create_publisher<TwistStamped>("~/output/vehicle_twist", durable_qos);
+    create_publisher<Float32Stamped>("~/output/acceleration_cmd", output_qos);
+  pub_vehicle_twist_ = create_publisher<TwistStamped>("~/output/vehicle_twist", output_qos);
 
   sub_control_cmd_ = create_subscription<ControlCommandStamped>(
     "~/input/control_cmd", queue_size,
@@ -48,88 +53,78 @@ CalibrationAdapterNode::CalibrationAdapterNode()
     std::bind(&CalibrationAdapterNode::callbackTwistStatus, this, _1));
 }
 
-template <class T>
-T CalibrationAdapterNode::getNearestTimeDataFromVec(
-  const T base_data, const double back_time, const std::vector<T> & vec)
+// The stamps in vec are sorted, so the nearest one is next to the lower bound of the target
+const CalibrationAdapterNode::VelocitySample & CalibrationAdapterNode::getNearestTimeDataFromVec(
+  const double base_stamp, const double back_time,
+  const math_utils::RingBuffer<VelocitySample> & vec) const
 {
-  double nearest_time = std::numeric_limits<double>::max();
-  const double target_time = rclcpp::Time(base_data.header.stamp).seconds() - back_time;
-  T nearest_time_data;
-  for (const auto & data : vec) {
-    const double data_time = rclcpp::Time(data.header.stamp).seconds();
-    const auto delta_time = std::abs(target_time - data_time);
-    if (nearest_time > delta_time) {
-      nearest_time_data = data;
-      nearest_time = delta_time;
-    }
+  const double target_time = base_stamp - back_time;
+  const auto iter = std::lower_bound(
+    vec.begin(), vec.end(), target_time,
+    [](const VelocitySample & data, const double t) { return data.stamp < t; });
+  if (iter == vec.begin()) {
+    return *iter;
   }
-  return nearest_time_data;
+  if (iter == vec.end()) {
+    return vec.back();
+  }
+  const auto prev = iter - 1;
+  return std::abs(target_time - prev->stamp) <= std::abs(target_time - iter->stamp) ? *prev : *iter;
 }
 
 double CalibrationAdapterNode::getAccel(
-  const TwistStamped & prev_twist, const TwistStamped & current_twist, const double dt)
+  const VelocitySample & prev_twist, const VelocitySample & current_twist, const double dt)
 {
   if (dt < 1e-03) {
     // invalid twist. return prev acceleration
     return acceleration_;
   }
-  const double dv = current_twist.twist.linear.x - prev_twist.twist.linear.x;
+  const double dv = current_twist.velocity - prev_twist.velocity;
   return dv / dt;
 }
 
-template <class T>
-void CalibrationAdapterNode::pushDataToVec(
-  const T data, const std::size_t max_size, std::vector<T> * vec)
-{
-  vec->emplace_back(data);
-  while (vec->size() > max_size) {
-    vec->erase(vec->begin());
-  }
-}
-
 void CalibrationAdapterNode::callbackControlCmd(const ControlCommandStamped::ConstSharedPtr msg)
 {
-  Float32Stamped steer_angle_msg;
-  steer_angle_msg.header.stamp = msg->stamp;
-  steer_angle_msg.header.frame_id = "base_link";
-  steer_angle_msg.data = msg->lateral.steering_tire_angle;
-  pub_steering_angle_cmd_->publish(steer_angle_msg);
-
-  Float32Stamped accel_msg;
-  accel_msg.header.stamp = msg->stamp;
-  accel_msg.header.frame_id = "base_link";
-  accel_msg.data = msg->longitudinal.acceleration;
-  pub_acceleration_cmd_->publish(accel_msg);
+  std_msgs::msg::Header header;
+  header.stamp = msg->stamp;
+  header.frame_id = "base_link";
+  publishFloat32Stamped(pub_steering_angle_cmd_, header, msg->lateral.steering_tire_angle);
+  publishFloat32Stamped(pub_acceleration_cmd_, header, msg->longitudinal.acceleration);
+  signals_.steering_angle_cmd = msg->lateral.steering_tire_angle;
+  signals_.acceleration_cmd = msg->longitudinal.acceleration;
 }
 
 void CalibrationAdapterNode::callbackTwistStatus(const Velocity::ConstSharedPtr msg)
 {
-  TwistStamped twist;
-  twist.header = msg->header;
-  twist.twist.linear.x = msg->longitudinal_velocity;
-  twist.twist.linear.y = msg->lateral_velocity;
-  twist.twist.angular.z = msg->heading_rate;
-  pub_vehicle_twist_->publish(twist);
+  auto twist = std::make_unique<TwistStamped>();
+  twist->header = msg->header;
+  twist->twist.linear.x = msg->longitudinal_velocity;
+  twist->twist.linear.y = msg->lateral_velocity;
+  twist->twist.angular.z = msg->heading_rate;
+  pub_vehicle_twist_->publish(std::move(twist));
+  const VelocitySample sample{
+    rclcpp::Time(msg->header.stamp).seconds(), msg->longitudinal_velocity};
+  // The history is sorted by the stamps, so it is restarted if the time goes back, e.g. by a rosbag
+  if (!twist_vec_.empty() && sample.stamp < twist_vec_.back().stamp) {
+    twist_vec_.clear();
+    raw_acceleration_average_.clear();
+  }
   if (!twist_vec_.empty()) {
-    const auto past_msg = getNearestTimeDataFromVec(twist, dif_twist_time_, twist_vec_);
-    const double dt =
-      (rclcpp::Time(msg->header.stamp) - rclcpp::Time(past_msg.header.stamp)).seconds();
-    const double raw_acceleration = getAccel(past_msg, twist, dt);
-    acceleration_ =
-      math_utils::lowpassFilter(acceleration_, raw_acceleration, lowpass_cutoff_value_, dt);
+    const auto & past_msg = getNearestTimeDataFromVec(sample.stamp, dif_twist_time_, twist_vec_);
+    const double dt = sample.stamp - past_msg.stamp;
+    const double raw_acceleration = getAccel(past_msg, sample, dt);
+    raw_acceleration_average_.push(raw_acceleration);
+    acceleration_ = math_utils::lowpassFilter(
+      acceleration_, raw_acceleration_average_.mean(), lowpass_cutoff_value_, dt);
   }
-  pushDataToVec(twist, twist_vec_max_size_, &twist_vec_);
+  twist_vec_.push_back(sample);
 
-  Float32Stamped accel_status_msg;
-  accel_status_msg.header.stamp = msg->header.stamp;
-  accel_status_msg.data = acceleration_;
-  pub_acceleration_status_->publish(accel_status_msg);
+  std_msgs::msg::Header header;
+  header.stamp = msg->header.stamp;
+  publishFloat32Stamped(pub_acceleration_status_, header, acceleration_);
+  signals_.acceleration_status = acceleration_;
+  signals_.velocity = msg->longitudinal_velocity;
 }
 
-int main(int argc, char ** argv)
-{
-  rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<CalibrationAdapterNode>());
-  rclcpp::shutdown();
-  return 0;
-}
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(CalibrationAdapterNode)
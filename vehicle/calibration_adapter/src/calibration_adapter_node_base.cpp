@@ -18,39 +18,42 @@
 
 #include <tf2/utils.h>
 
+#include <chrono>
+#include <limits>
 #include <memory>
+#include <utility>
 
-CalibrationAdapterNodeBase::CalibrationAdapterNodeBase() : Node("calibration_adapter")
+CalibrationAdapterNodeBase::CalibrationAdapterNodeBase(const rclcpp::NodeOptions & node_options)
+: Node("calibration_adapter", node_options)
 {
   using std::placeholders::_1;
 
   // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
+  const auto output_qos = getOutputQoS();
 
   pub_accel_status_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
-    "~/output/accel_status", durable_qos);
+    "~/output/accel_status", output_qos);
   pub_brake_status_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
-    "~/output/brake_status", durable_qos);
+    "~/output/brake_status", output_qos);
   pub_steer_status_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
-    "~/output/steer_status", durable_qos);
+    "~/output/steer_status", output_qos);
   pub_accel_cmd_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
-    "~/output/accel_cmd", durable_qos);
+    "~/output/accel_cmd", output_qos);
   pub_brake_cmd_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
-    "~/output/brake_cmd", durable_qos);
+    "~/output/brake_cmd", output_qos);
   pub_steer_cmd_ = create_publisher<tier4_calibration_msgs::msg::Float32Stamped>(
-    "~/output/steer_cmd", durable_qos);
+    "~/output/steer_cmd", output_qos);
 
   // steering angle
   pub_steering_angle_status_ =
-    create_publisher<Float32Stamped>("~/output/steering_angle_status", durable_qos);
+    create_publisher<Float32Stamped>("~/output/steering_angle_status", output_qos);
   sub_steering_angle_status_ = create_subscription<SteeringAngleStatus>(
     "~/input/steering_angle_status", queue_size,
     std::bind(&CalibrationAdapterNodeBase::callbackSteeringAngleStatus, this, _1));
 
   pub_is_engage_ =
-    create_publisher<tier4_calibration_msgs::msg::BoolStamped>("~/output/is_engage", durable_qos);
+    create_publisher<tier4_calibration_msgs::msg::BoolStamped>("~/output/is_engage", output_qos);
 
   sub_engage_status_ = create_subscription<autoware_vehicle_msgs::msg::Engage>(
     "~/input/is_engage", queue_size,
@@ -61,56 +64,86 @@ CalibrationAdapterNodeBase::CalibrationAdapterNodeBase() : Node("calibration_ada
   sub_actuation_command_ = create_subscription<ActuationCommandStamped>(
     "~/input/actuation_command", queue_size,
     std::bind(&CalibrationAdapterNodeBase::onActuationCmd, this, _1));
+
+  // all the signals in a message, sampled at the same time instead of synchronized by consumers
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  signals_.accel_cmd = signals_.brake_cmd = signals_.steer_cmd = nan;
+  signals_.accel_status = signals_.brake_status = signals_.steer_status = nan;
+  signals_.steering_angle_status = signals_.steering_angle_cmd = nan;
+  signals_.acceleration_cmd = signals_.acceleration_status = signals_.velocity = nan;
+  signals_.handle_status = nan;
+  signals_.is_engage = false;
+  if (declare_parameter<bool>("publish_signals", false)) {
+    const double signals_publish_hz = declare_parameter<double>("signals_publish_hz", 30.0);
+    pub_signals_ = create_publisher<CalibrationSignals>("~/output/signals", output_qos);
+    const auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(1.0 / signals_publish_hz));
+    timer_signals_ = rclcpp::create_timer(
+      this, get_clock(), period_ns, std::bind(&CalibrationAdapterNodeBase::onSignalsTimer, this));
+  }
+}
+
+rclcpp::QoS CalibrationAdapterNodeBase::getOutputQoS() const
+{
+  static constexpr std::size_t queue_size = 1;
+  rclcpp::QoS qos(queue_size);
+  if (!get_node_options().use_intra_process_comms()) {
+    qos.transient_local();  // option for latching
+  }
+  return qos;
+}
+
+void CalibrationAdapterNodeBase::publishFloat32Stamped(
+  const rclcpp::Publisher<Float32Stamped>::SharedPtr & pub, const std_msgs::msg::Header & header,
+  const double data)
+{
+  auto msg = std::make_unique<Float32Stamped>();
+  msg->header = header;
+  msg->data = data;
+  pub->publish(std::move(msg));
 }
 
 void CalibrationAdapterNodeBase::callbackSteeringAngleStatus(
   const SteeringAngleStatus::ConstSharedPtr msg)
 {
-  Float32Stamped steer_status_msg;
-  steer_status_msg.header.stamp = msg->stamp;
-  steer_status_msg.data = msg->steering_tire_angle;
-  pub_steering_angle_status_->publish(steer_status_msg);
+  std_msgs::msg::Header header;
+  header.stamp = msg->stamp;
+  publishFloat32Stamped(pub_steering_angle_status_, header, msg->steering_tire_angle);
+  signals_.steering_angle_status = msg->steering_tire_angle;
 }
 
 void CalibrationAdapterNodeBase::onActuationCmd(const ActuationCommandStamped::ConstSharedPtr msg)
 {
-  Float32Stamped brake_msgs;
-  brake_msgs.header = msg->header;
-  brake_msgs.data = msg->actuation.brake_cmd;
-  pub_brake_cmd_->publish(brake_msgs);
-
-  Float32Stamped accel_msgs;
-  accel_msgs.header = msg->header;
-  accel_msgs.data = msg->actuation.accel_cmd;
-  pub_accel_cmd_->publish(accel_msgs);
-
-  Float32Stamped steer_msgs;
-  steer_msgs.header = msg->header;
-  steer_msgs.data = msg->actuation.steer_cmd;
-  pub_steer_cmd_->publish(steer_msgs);
+  publishFloat32Stamped(pub_brake_cmd_, msg->header, msg->actuation.brake_cmd);
+  publishFloat32Stamped(pub_accel_cmd_, msg->header, msg->actuation.accel_cmd);
+  publishFloat32Stamped(pub_steer_cmd_, msg->header, msg->actuation.steer_cmd);
+  signals_.accel_cmd = msg->actuation.accel_cmd;
+  signals_.brake_cmd = msg->actuation.brake_cmd;
+  signals_.steer_cmd = msg->actuation.steer_cmd;
 }
 
 void CalibrationAdapterNodeBase::onActuationStatus(const ActuationStatusStamped::ConstSharedPtr msg)
 {
-  Float32Stamped accel_msgs;
-  accel_msgs.header = msg->header;
-  accel_msgs.data = msg->status.accel_status;
-  pub_accel_status_->publish(accel_msgs);
-
-  Float32Stamped brake_msgs;
-  brake_msgs.header = msg->header;
-  brake_msgs.data = msg->status.brake_status;
-  pub_brake_status_->publish(brake_msgs);
-
-  Float32Stamped steer_msgs;
-  steer_msgs.header = msg->header;
-  steer_msgs.data = msg->status.steer_status;
-  pub_steer_status_->publish(steer_msgs);
+  publishFloat32Stamped(pub_accel_status_, msg->header, msg->status.accel_status);
+  publishFloat32Stamped(pub_brake_status_, msg->header, msg->status.brake_status);
+  publishFloat32Stamped(pub_steer_status_, msg->header, msg->status.steer_status);
+  signals_.accel_status = msg->status.accel_status;
+  signals_.brake_status = msg->status.brake_status;
+  signals_.steer_status = msg->status.steer_status;
 }
 
 void CalibrationAdapterNodeBase::onEngageStatus(const EngageStatus::SharedPtr msg)
 {
-  BoolStamped engage_msgs;
-  engage_msgs.data = msg->engage;
-  pub_is_engage_->publish(engage_msgs);
+  auto engage_msg = std::make_unique<BoolStamped>();
+  engage_msg->data = msg->engage;
+  pub_is_engage_->publish(std::move(engage_msg));
+  signals_.is_engage = msg->engage;
+}
+
+void CalibrationAdapterNodeBase::onSignalsTimer()
+{
+  auto msg = std::make_unique<CalibrationSignals>(signals_);
+  msg->header.stamp = now();
+  msg->header.frame_id = "base_link";
+  pub_signals_->publish(std::move(msg));
 }
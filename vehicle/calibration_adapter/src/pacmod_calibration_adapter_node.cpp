@@ -20,16 +20,17 @@
 
 #include <memory>
 
-PacmodCalibrationAdapterNode::PacmodCalibrationAdapterNode()
+PacmodCalibrationAdapterNode::PacmodCalibrationAdapterNode(
+  const rclcpp::NodeOptions & node_options)
+: CalibrationAdapterNodeBase(node_options)
 {
   using std::placeholders::_1;
 
   // QoS setup
   static constexpr std::size_t queue_size = 1;
-  rclcpp::QoS durable_qos(queue_size);
-  durable_qos.transient_local();  // option for latching
+  const auto output_qos = getOutputQoS();
 
-  pub_handle_status_ = create_publisher<Float32Stamped>("~/output/handle_status", durable_qos);
+  pub_handle_status_ = create_publisher<Float32Stamped>("~/output/handle_status", output_qos);
   sub_handle_status_ = create_subscription<SteeringWheelStatusStamped>(
     "~/input/handle_status", queue_size,
     std::bind(&PacmodCalibrationAdapterNode::callbackSteeringWheelStatus, this, _1));
@@ -38,17 +39,12 @@ PacmodCalibrationAdapterNode::PacmodCalibrationAdapterNode()
 void PacmodCalibrationAdapterNode::callbackSteeringWheelStatus(
   const SteeringWheelStatusStamped::ConstSharedPtr msg)
 {
-  tier4_calibration_msgs::msg::Float32Stamped steer_msgs;
-  steer_msgs.header.stamp = msg->stamp;
-  steer_msgs.header.frame_id = "base_link";
-  steer_msgs.data = msg->data;
-  pub_handle_status_->publish(steer_msgs);
+  std_msgs::msg::Header header;
+  header.stamp = msg->stamp;
+  header.frame_id = "base_link";
+  publishFloat32Stamped(pub_handle_status_, header, msg->data);
+  signals_.handle_status = msg->data;
 }
 
-int main(int argc, char ** argv)
-{
-  rclcpp::init(argc, argv);
-  rclcpp::spin(std::make_shared<PacmodCalibrationAdapterNode>());
-  rclcpp::shutdown();
-  return 0;
-}
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(PacmodCalibrationAdapterNode)
@@ -0,0 +1,416 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/cross_correlation_utils.hpp"
+#include "estimator_utils/filter_utils.hpp"
+#include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/optimization_utils.hpp"
+
+#include <Eigen/Core>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cmath>
+#include <deque>
+#include <random>
+#include <vector>
+
+// Baselines of the math kernels over the window sizes of the estimators, which keep 1k to 100k
+// samples at 30 to 100 Hz. The kernels per sample are measured over a window of samples, so that
+// the items per second are the samples processed per second.
+
+namespace
+{
+// a delayed and noisy response of a sinusoidal input, like the signals of the delay estimators
+void generateSignals(
+  const size_t n, std::vector<double> & input, std::vector<double> & response, const int delay = 5)
+{
+  std::mt19937 engine(0);
+  std::normal_distribution<double> noise(0.0, 0.05);
+  input.resize(n);
+  response.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    input[i] = std::sin(0.01 * static_cast<double>(i)) + noise(engine);
+    response[i] =
+      0.8 * std::sin(0.01 * (static_cast<double>(i) - delay)) + noise(engine);
+  }
+}
+
+void setWindowSizes(benchmark::internal::Benchmark * b)
+{
+  b->RangeMultiplier(10)->Range(1000, 100000);
+}
+
+// the default of the time delay estimators
+constexpr double valid_delay_index_ratio = 0.1;
+}  // namespace
+
+static void BM_CalcCrossCorrelationCoefficient(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  const std::vector<double> weight(input.size(), 1.0);
+  for (auto _ : state) {
+    auto corr = math_utils::calcCrossCorrelationCoefficient(
+      input, response, weight, valid_delay_index_ratio);
+    benchmark::DoNotOptimize(corr.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+// O(N * max_lag), which takes seconds beyond 10k samples
+BENCHMARK(BM_CalcCrossCorrelationCoefficient)->RangeMultiplier(10)->Range(1000, 10000);
+
+static void BM_CrossCorrelationEngine(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  const std::vector<double> weight(input.size(), 1.0);
+  math_utils::CrossCorrelationEngine engine;
+  std::vector<double> corr;
+  for (auto _ : state) {
+    engine.calcCrossCorrelationCoefficient(
+      input, response, weight, valid_delay_index_ratio, corr);
+    benchmark::DoNotOptimize(corr.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CrossCorrelationEngine)->Apply(setWindowSizes);
+
+// a new sample and the coefficients of all the shifts, as in each period of the delay estimators
+static void BM_SlidingCrossCorrelation(benchmark::State & state)
+{
+  const auto n = static_cast<size_t>(state.range(0));
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(2 * n, input, response);
+  math_utils::SlidingCrossCorrelation correlation;
+  correlation.reset(n, static_cast<size_t>(n * valid_delay_index_ratio));
+  for (size_t i = 0; i < n; ++i) {
+    correlation.push(input[i], response[i]);
+  }
+  std::vector<double> corr;
+  size_t i = n;
+  for (auto _ : state) {
+    correlation.push(input[i], response[i]);
+    correlation.calcCrossCorrelationCoefficient(corr);
+    benchmark::DoNotOptimize(corr.data());
+    i = i + 1 < input.size() ? i + 1 : n;
+  }
+}
+BENCHMARK(BM_SlidingCrossCorrelation)->Apply(setWindowSizes);
+
+static void BM_CalcMAE(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(math_utils::calcMAE(input, response, 5));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CalcMAE)->Apply(setWindowSizes);
+
+static void BM_GetAveragedVector(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  const std::deque<double> buffer(input.begin(), input.end());
+  std::vector<double> averaged;
+  for (auto _ : state) {
+    math_utils::getAveragedVector(buffer, averaged);
+    benchmark::DoNotOptimize(averaged.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetAveragedVector)->Apply(setWindowSizes);
+
+static void BM_FitToTheSizeOfVector(benchmark::State & state)
+{
+  const auto n = static_cast<size_t>(state.range(0));
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(n + 1, input, response);
+  const std::deque<double> input_buffer(input.begin(), input.end());
+  const std::deque<double> response_buffer(response.begin(), response.end());
+  std::deque<double> input_stamp;
+  std::deque<double> response_stamp;
+  for (size_t i = 0; i < n + 1; ++i) {
+    input_stamp.push_back(0.01 * static_cast<double>(i));
+    response_stamp.push_back(0.01 * static_cast<double>(i) + 0.004);
+  }
+  for (auto _ : state) {
+    std::vector<double> fitted_input(input_buffer.begin(), input_buffer.end());
+    std::vector<double> fitted_response(response_buffer.begin(), response_buffer.end());
+    math_utils::fitToTheSizeOfVector(
+      input_stamp, response_stamp, fitted_input, fitted_response, static_cast<int>(n), 1);
+    benchmark::DoNotOptimize(fitted_input.data());
+    benchmark::DoNotOptimize(fitted_response.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FitToTheSizeOfVector)->Apply(setWindowSizes);
+
+static void BM_LowpassFilter(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    double filtered = input.front();
+    for (const double v : input) {
+      filtered = math_utils::lowpassFilter(v, filtered, 5.0, 0.01);
+    }
+    benchmark::DoNotOptimize(filtered);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LowpassFilter)->Apply(setWindowSizes);
+
+// 32 channels filtered at once, e.g. the signals of a CAN frame
+static void BM_BiquadFilterBank(benchmark::State & state)
+{
+  constexpr size_t channel_num = 32;
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  math_utils::BiquadFilterBank<channel_num> bank(
+    math_utils::IIRCoefficients::butterworthLowpass(5.0, 0.01));
+  std::array<double, channel_num> samples{};
+  for (auto _ : state) {
+    bank.reset();
+    for (const double v : input) {
+      samples.fill(v);
+      bank.filter(samples.data(), samples.data());
+    }
+    benchmark::DoNotOptimize(samples.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * channel_num);
+}
+BENCHMARK(BM_BiquadFilterBank)->Apply(setWindowSizes);
+
+static void BM_Filtfilt(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  const auto coefficients = math_utils::IIRCoefficients::butterworthLowpass(5.0, 0.01);
+  std::vector<double> filtered;
+  for (auto _ : state) {
+    math_utils::filtfilt(coefficients, input, filtered);
+    benchmark::DoNotOptimize(filtered.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Filtfilt)->Apply(setWindowSizes);
+
+static void BM_CalcSequentialStddev(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    math_utils::Statistics statistics(2);
+    for (size_t i = 0; i < input.size(); ++i) {
+      statistics.value = {input[i], response[i]};
+      math_utils::calcSequentialStddev(statistics);
+    }
+    benchmark::DoNotOptimize(statistics.stddev.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CalcSequentialStddev)->Apply(setWindowSizes);
+
+static void BM_StatisticCalcSequentialStddev(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    math_utils::Statistic statistic;
+    double stddev = 0.0;
+    for (const double v : input) {
+      stddev = statistic.calcSequentialStddev(v);
+    }
+    benchmark::DoNotOptimize(stddev);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StatisticCalcSequentialStddev)->Apply(setWindowSizes);
+
+static void BM_RunningStatisticAddBatch(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    math_utils::RunningStatistic statistic;
+    statistic.addBatch(input);
+    benchmark::DoNotOptimize(statistic.m2);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_RunningStatisticAddBatch)->Apply(setWindowSizes);
+
+static void BM_EstimateByRLSScalar(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    double est = 0.0;
+    double cov = 1.0;
+    for (size_t i = 0; i < input.size(); ++i) {
+      optimization_utils::estimateByRLS(est, cov, input[i], 0.999, response[i]);
+    }
+    benchmark::DoNotOptimize(est);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EstimateByRLSScalar)->Apply(setWindowSizes);
+
+// the two parameters of the estimators of the first order systems, on dynamic-size matrices
+static void BM_EstimateByRLSDynamic(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  const Eigen::MatrixXd ff = Eigen::MatrixXd::Constant(1, 1, 0.999);
+  for (auto _ : state) {
+    Eigen::MatrixXd est = Eigen::MatrixXd::Zero(2, 1);
+    Eigen::MatrixXd cov = Eigen::MatrixXd::Identity(2, 2);
+    Eigen::MatrixXd zn(2, 1);
+    Eigen::MatrixXd y(1, 1);
+    for (size_t i = 0; i < input.size(); ++i) {
+      zn << input[i], 1.0;
+      y << response[i];
+      optimization_utils::estimateByRLS(est, cov, zn, ff, y);
+    }
+    benchmark::DoNotOptimize(est.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EstimateByRLSDynamic)->Apply(setWindowSizes);
+
+static void BM_EstimateByRLSFixed(benchmark::State & state)
+{
+  std::vector<double> input;
+  std::vector<double> response;
+  generateSignals(static_cast<size_t>(state.range(0)), input, response);
+  for (auto _ : state) {
+    Eigen::Vector2d est = Eigen::Vector2d::Zero();
+    Eigen::Matrix2d cov = Eigen::Matrix2d::Identity();
+    for (size_t i = 0; i < input.size(); ++i) {
+      optimization_utils::estimateByRLS<2>(
+        est, cov, Eigen::Vector2d(input[i], 1.0), 0.999, response[i]);
+    }
+    benchmark::DoNotOptimize(est.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EstimateByRLSFixed)->Apply(setWindowSizes);
+
+static void BM_GetLeastSquaredError(benchmark::State & state)
+{
+  const auto n = static_cast<size_t>(state.range(0));
+  std::vector<double> x;
+  std::vector<double> u;
+  generateSignals(n, x, u);
+  std::vector<double> x_dot(n, 0.0);
+  for (size_t i = 1; i + 1 < n; ++i) {
+    x_dot[i] = optimization_utils::getSecondaryCentralDifference(x[i + 1], x[i - 1], 0.01);
+  }
+  for (auto _ : state) {
+    Eigen::VectorXd w;
+    benchmark::DoNotOptimize(optimization_utils::getLeastSquaredError(x_dot, x, u, w));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetLeastSquaredError)->Apply(setWindowSizes);
+
+static void BM_GetLeastSquaredErrorSecondOrder(benchmark::State & state)
+{
+  const auto n = static_cast<size_t>(state.range(0));
+  std::vector<double> x;
+  std::vector<double> u;
+  generateSignals(n, x, u);
+  std::vector<double> x_dot(n, 0.0);
+  std::vector<double> x2dot(n, 0.0);
+  for (size_t i = 1; i + 1 < n; ++i) {
+    x_dot[i] = optimization_utils::getSecondaryCentralDifference(x[i + 1], x[i - 1], 0.01);
+    x2dot[i] = optimization_utils::getSecondaryCentralDifference(x[i + 1], x[i], x[i - 1], 0.01);
+  }
+  for (auto _ : state) {
+    Eigen::VectorXd w;
+    benchmark::DoNotOptimize(optimization_utils::getLeastSquaredError(x2dot, x_dot, x, u, w));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetLeastSquaredErrorSecondOrder)->Apply(setWindowSizes);
+
+// The delay search of the time delay estimator, by copying the windows for getLeastSquaredError
+// and by LaggedLeastSquared
+static void BM_LeastSquaredDelaySearch(benchmark::State & state)
+{
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto num_sample = static_cast<size_t>(n * (1.0 - valid_delay_index_ratio));
+  std::vector<double> x;
+  std::vector<double> u;
+  generateSignals(n, x, u);
+  std::vector<double> x_dot(n, 0.0);
+  for (size_t i = 1; i + 1 < n; ++i) {
+    x_dot[i] = optimization_utils::getSecondaryCentralDifference(x[i + 1], x[i - 1], 0.01);
+  }
+  for (auto _ : state) {
+    const std::vector<double> y = {x.end() - num_sample, x.end()};
+    const std::vector<double> y_dot = {x_dot.end() - num_sample, x_dot.end()};
+    Eigen::VectorXd w;
+    for (size_t d = 0; d < n - num_sample; ++d) {
+      const std::vector<double> window = {u.end() - num_sample - d, u.end() - d};
+      benchmark::DoNotOptimize(optimization_utils::getLeastSquaredError(y_dot, y, window, w));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LeastSquaredDelaySearch)->RangeMultiplier(10)->Range(1000, 10000);
+
+static void BM_LaggedLeastSquaredDelaySearch(benchmark::State & state)
+{
+  const auto n = static_cast<size_t>(state.range(0));
+  const auto num_sample = static_cast<size_t>(n * (1.0 - valid_delay_index_ratio));
+  std::vector<double> x;
+  std::vector<double> u;
+  generateSignals(n, x, u);
+  std::vector<double> x_dot(n, 0.0);
+  for (size_t i = 1; i + 1 < n; ++i) {
+    x_dot[i] = optimization_utils::getSecondaryCentralDifference(x[i + 1], x[i - 1], 0.01);
+  }
+  for (auto _ : state) {
+    const optimization_utils::LaggedLeastSquared<2> least_squared({&x_dot, &x}, num_sample);
+    Eigen::Vector2d w;
+    for (size_t d = 0; d < n - num_sample; ++d) {
+      benchmark::DoNotOptimize(least_squared.solve(u, d, w));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_LaggedLeastSquaredDelaySearch)->RangeMultiplier(10)->Range(1000, 10000);
+
+BENCHMARK_MAIN();
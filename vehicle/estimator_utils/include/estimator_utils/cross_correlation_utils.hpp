@@ -0,0 +1,345 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__CROSS_CORRELATION_UTILS_HPP_
+#define ESTIMATOR_UTILS__CROSS_CORRELATION_UTILS_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <utility>
+#include <vector>
+
+namespace math_utils
+{
+/**
+ * @brief iterative radix-2 FFT. The twiddle factors and the bit-reversal permutation are kept
+ * while the size does not change.
+ */
+class FFT
+{
+public:
+  using Complex = std::complex<double>;
+
+  /**
+   * @param data : signal whose size is a power of 2, overwritten with its (inverse) transform
+   * @param inverse : inverse transform, scaled by 1 / size
+   */
+  void transform(std::vector<Complex> & data, const bool inverse)
+  {
+    const size_t n = data.size();
+    if (n != size_) {
+      setSize(n);
+    }
+    for (size_t i = 0; i < n; ++i) {
+      if (i < bit_reversed_[i]) {
+        std::swap(data[i], data[bit_reversed_[i]]);
+      }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+      const size_t half = len / 2;
+      const size_t step = n / len;
+      for (size_t i = 0; i < n; i += len) {
+        for (size_t j = 0; j < half; ++j) {
+          const Complex w = inverse ? std::conj(twiddles_[j * step]) : twiddles_[j * step];
+          const Complex u = data[i + j];
+          const Complex v = data[i + j + half] * w;
+          data[i + j] = u + v;
+          data[i + j + half] = u - v;
+        }
+      }
+    }
+    if (inverse) {
+      for (auto & d : data) {
+        d /= static_cast<double>(n);
+      }
+    }
+  }
+
+private:
+  void setSize(const size_t n)
+  {
+    size_ = n;
+    twiddles_.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k) {
+      twiddles_[k] = std::polar(1.0, -2.0 * M_PI * static_cast<double>(k) / n);
+    }
+    size_t num_bits = 0;
+    while ((static_cast<size_t>(1) << num_bits) < n) {
+      ++num_bits;
+    }
+    bit_reversed_.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      size_t reversed = 0;
+      for (size_t b = 0; b < num_bits; ++b) {
+        reversed |= ((i >> b) & 1) << (num_bits - 1 - b);
+      }
+      bit_reversed_[i] = reversed;
+    }
+  }
+
+  size_t size_ = 0;
+  std::vector<Complex> twiddles_;
+  std::vector<size_t> bit_reversed_;
+};
+
+/**
+ * @brief the same correlation coefficients as calcCrossCorrelationCoefficient with weights, in
+ * O(N log N) instead of O(N * max_lag). The weighted sums of the shifted input are correlations
+ * computed by FFT, and those of the response are prefix sums. The buffers, the FFT tables and the
+ * spectrum of the weights are reused across calls.
+ */
+class CrossCorrelationEngine
+{
+public:
+  using Complex = std::complex<double>;
+
+  /**
+   * @param input : input signal
+   * @param response : output signal, of the same size as input
+   * @param weight : weight for correlation, at least the size of input
+   * @param valid_delay_index_ratio : number of shift to compare rate
+   * @param corr_coeff : correlation value for each shift
+   */
+  template <class T>
+  void calcCrossCorrelationCoefficient(
+    const T & input, const T & response, const T & weight, const double valid_delay_index_ratio,
+    std::vector<double> & corr_coeff)
+  {
+    const size_t n = input.size();
+    const int T_interval = static_cast<int>(n * valid_delay_index_ratio);
+    corr_coeff.assign(std::max(T_interval, 0), 0.0);
+    if (T_interval < 2) {
+      return;
+    }
+    const size_t num_lag = T_interval - 1;
+    size_t fft_size = 1;
+    while (fft_size < n + num_lag) {
+      fft_size <<= 1;
+    }
+    updateWeight(weight, n, fft_size);
+
+    // The signals are reversed, i.e. sorted from the newest, as in calcCrossCorrelationCoefficient.
+    // input_spectrum_ has the input in the real part and its square in the imaginary part.
+    input_spectrum_.assign(fft_size, Complex(0.0, 0.0));
+    response_spectrum_.assign(fft_size, Complex(0.0, 0.0));
+    response_sum_.assign(n + 1, 0.0);
+    response_square_sum_.assign(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+      const double x = input[n - 1 - i];
+      const double y = response[n - 1 - i];
+      input_spectrum_[i] = Complex(x, x * x);
+      response_spectrum_[i] = Complex(weight[i] * y, 0.0);
+      response_sum_[i + 1] = response_sum_[i] + weight[i] * y;
+      response_square_sum_[i + 1] = response_square_sum_[i] + weight[i] * y * y;
+    }
+    fft_.transform(input_spectrum_, false);
+    fft_.transform(response_spectrum_, false);
+
+    // sum_i w_i * x_{i + tau} * y_i, where the spectrum of the input is separated from the packed
+    // one by the conjugate symmetry
+    for (size_t k = 0; k < fft_size; ++k) {
+      const Complex z = input_spectrum_[k];
+      const Complex z_mirror = std::conj(input_spectrum_[(fft_size - k) % fft_size]);
+      response_spectrum_[k] = 0.5 * (z + z_mirror) * std::conj(response_spectrum_[k]);
+    }
+    // sum_i w_i * x_{i + tau} and sum_i w_i * x_{i + tau}^2
+    for (size_t k = 0; k < fft_size; ++k) {
+      input_spectrum_[k] *= std::conj(weight_spectrum_[k]);
+    }
+    fft_.transform(response_spectrum_, true);
+    fft_.transform(input_spectrum_, true);
+
+    // The shifted signals are padded with zeros, which are weighted as well
+    for (size_t tau = 0; tau < num_lag; ++tau) {
+      const double x_avg = input_spectrum_[tau].real() / weight_sum_;
+      const double y_avg = response_sum_[n - tau] / weight_sum_;
+      const double x_var = std::max(input_spectrum_[tau].imag() / weight_sum_ - x_avg * x_avg, 0.0);
+      const double y_var =
+        std::max(response_square_sum_[n - tau] / weight_sum_ - y_avg * y_avg, 0.0);
+      const double xy_cov = response_spectrum_[tau].real() / weight_sum_ - x_avg * y_avg;
+      corr_coeff.at(tau) = xy_cov / (std::sqrt(x_var) * std::sqrt(y_var));
+    }
+  }
+
+private:
+  template <class T>
+  void updateWeight(const T & weight, const size_t n, const size_t fft_size)
+  {
+    if (
+      weight_.size() == n && weight_spectrum_.size() == fft_size &&
+      std::equal(weight_.begin(), weight_.end(), weight.begin())) {
+      return;
+    }
+    weight_.assign(weight.begin(), weight.begin() + n);
+    weight_sum_ = 0.0;
+    weight_spectrum_.assign(fft_size, Complex(0.0, 0.0));
+    for (size_t i = 0; i < n; ++i) {
+      weight_spectrum_[i] = Complex(weight_[i], 0.0);
+      weight_sum_ += weight_[i];
+    }
+    fft_.transform(weight_spectrum_, false);
+  }
+
+  FFT fft_;
+  std::vector<double> weight_;
+  double weight_sum_ = 0.0;
+  std::vector<Complex> weight_spectrum_;
+  std::vector<Complex> input_spectrum_;
+  std::vector<Complex> response_spectrum_;
+  std::vector<double> response_sum_;
+  std::vector<double> response_square_sum_;
+};
+
+/**
+ * @brief the same correlation coefficients as calcCrossCorrelationCoefficient with uniform
+ * weights, kept up to date while the window slides. A new sample is added in O(max_lag) with the
+ * running sums of the signals and of the lagged products, and the coefficients of all the shifts
+ * are obtained in O(max_lag). The sums are recomputed once per window to cancel rounding errors.
+ */
+class SlidingCrossCorrelation
+{
+public:
+  /**
+   * @param window_size : number of the latest samples used for correlation
+   * @param num_lag : number of shifts, i.e. T_interval - 1 of calcCrossCorrelationCoefficient
+   */
+  void reset(const size_t window_size, const size_t num_lag)
+  {
+    window_size_ = window_size;
+    num_lag_ = std::min(num_lag, window_size);
+    input_.assign(window_size, 0.0);
+    response_.assign(window_size, 0.0);
+    lagged_product_sum_.assign(num_lag_, 0.0);
+    head_ = 0;
+    size_ = 0;
+    num_push_since_sync_ = 0;
+    input_sum_ = input_square_sum_ = response_sum_ = response_square_sum_ = 0.0;
+  }
+
+  size_t size() const { return size_; }
+  size_t windowSize() const { return window_size_; }
+  size_t numLag() const { return num_lag_; }
+  // samples counted from the oldest one
+  double input(const size_t i) const { return input_[(head_ + i) % window_size_]; }
+  double response(const size_t i) const { return response_[(head_ + i) % window_size_]; }
+
+  void push(const double x, const double y)
+  {
+    if (window_size_ == 0) {
+      return;
+    }
+    if (size_ == window_size_) {
+      // remove the pairs of the oldest input
+      const double x_old = input(0);
+      const double y_old = response(0);
+      for (size_t tau = 0; tau < num_lag_; ++tau) {
+        lagged_product_sum_[tau] -= x_old * response(tau);
+      }
+      input_sum_ -= x_old;
+      input_square_sum_ -= x_old * x_old;
+      response_sum_ -= y_old;
+      response_square_sum_ -= y_old * y_old;
+      head_ = (head_ + 1) % window_size_;
+      --size_;
+    }
+
+    const size_t idx = (head_ + size_) % window_size_;
+    input_[idx] = x;
+    response_[idx] = y;
+    ++size_;
+    input_sum_ += x;
+    input_square_sum_ += x * x;
+    response_sum_ += y;
+    response_square_sum_ += y * y;
+    // add the pairs of the newest response
+    for (size_t tau = 0; tau < std::min(num_lag_, size_); ++tau) {
+      lagged_product_sum_[tau] += input(size_ - 1 - tau) * y;
+    }
+
+    if (++num_push_since_sync_ >= window_size_) {
+      sync();
+    }
+  }
+
+  /**
+   * @param corr_coeff : correlation value for each shift, in the same format as
+   * calcCrossCorrelationCoefficient
+   */
+  void calcCrossCorrelationCoefficient(std::vector<double> & corr_coeff) const
+  {
+    corr_coeff.assign(num_lag_ + (window_size_ > 0 ? 1 : 0), 0.0);
+    const size_t n = size_;
+    // The input is shifted to the past, so the newest inputs and the oldest responses are out of
+    // the pairs and replaced by zeros
+    double newest_input_sum = 0.0;
+    double newest_input_square_sum = 0.0;
+    double oldest_response_sum = 0.0;
+    double oldest_response_square_sum = 0.0;
+    for (size_t tau = 0; tau < std::min(num_lag_, n); ++tau) {
+      const double x_avg = (input_sum_ - newest_input_sum) / n;
+      const double y_avg = (response_sum_ - oldest_response_sum) / n;
+      const double x_var =
+        std::max((input_square_sum_ - newest_input_square_sum) / n - x_avg * x_avg, 0.0);
+      const double y_var =
+        std::max((response_square_sum_ - oldest_response_square_sum) / n - y_avg * y_avg, 0.0);
+      const double xy_cov = lagged_product_sum_[tau] / n - x_avg * y_avg;
+      corr_coeff.at(tau) = xy_cov / (std::sqrt(x_var) * std::sqrt(y_var));
+
+      const double x_newest = input(n - 1 - tau);
+      const double y_oldest = response(tau);
+      newest_input_sum += x_newest;
+      newest_input_square_sum += x_newest * x_newest;
+      oldest_response_sum += y_oldest;
+      oldest_response_square_sum += y_oldest * y_oldest;
+    }
+  }
+
+private:
+  void sync()
+  {
+    num_push_since_sync_ = 0;
+    input_sum_ = input_square_sum_ = response_sum_ = response_square_sum_ = 0.0;
+    for (size_t i = 0; i < size_; ++i) {
+      input_sum_ += input(i);
+      input_square_sum_ += input(i) * input(i);
+      response_sum_ += response(i);
+      response_square_sum_ += response(i) * response(i);
+    }
+    for (size_t tau = 0; tau < num_lag_; ++tau) {
+      lagged_product_sum_[tau] = 0.0;
+      for (size_t i = 0; i + tau < size_; ++i) {
+        lagged_product_sum_[tau] += input(i) * response(i + tau);
+      }
+    }
+  }
+
+  size_t window_size_ = 0;
+  size_t num_lag_ = 0;
+  std::vector<double> input_;
+  std::vector<double> response_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  size_t num_push_since_sync_ = 0;
+  double input_sum_ = 0.0;
+  double input_square_sum_ = 0.0;
+  double response_sum_ = 0.0;
+  double response_square_sum_ = 0.0;
+  std::vector<double> lagged_product_sum_;
+};
+}  // namespace math_utils
+
+#endif  // ESTIMATOR_UTILS__CROSS_CORRELATION_UTILS_HPP_
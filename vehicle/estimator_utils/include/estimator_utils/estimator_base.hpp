@@ -85,9 +85,9 @@ public:
    *  1. preprocess data
    *  2. estimate parameter
    *  3. post process output
-   *  publish output
+   *  publish output, unless publish is false
    **/
-  void Run()
+  void Run(const bool publish = true)
   {
     try {
       if (is_valid_data_) {
@@ -100,8 +100,10 @@ public:
           seq_++;
         }
       }
-      publishData();
-      publishResult();
+      if (publish) {
+        publishData();
+        publishResult();
+      }
     } catch (std::runtime_error & e) {  // Handle runtime errors
       std::cerr << "[parameter_estimator] runtime_error: " << e.what() << std::endl;
     } catch (std::logic_error & e) {
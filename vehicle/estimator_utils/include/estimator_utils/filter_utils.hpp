@@ -0,0 +1,197 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__FILTER_UTILS_HPP_
+#define ESTIMATOR_UTILS__FILTER_UTILS_HPP_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace math_utils
+{
+/**
+ * @brief coefficient of math_utils::lowpassFilter, computed once for a cutoff and a sampling time
+ */
+struct LowpassCoefficient
+{
+  LowpassCoefficient() = default;
+  LowpassCoefficient(const double cutoff, const double dt)
+  {
+    const double tau = 1 / (2 * M_PI * cutoff);
+    a = tau / (dt + tau);
+  }
+  double filter(const double current_value, const double prev_value) const
+  {
+    return prev_value * a + (1 - a) * current_value;
+  }
+  // weight of the previous value, 0 passes the current value through
+  double a = 0;
+};
+
+/**
+ * @brief coefficients of y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+ */
+struct IIRCoefficients
+{
+  double b0 = 1;
+  double b1 = 0;
+  double b2 = 0;
+  double a1 = 0;
+  double a2 = 0;
+
+  // the same filter as math_utils::lowpassFilter
+  static IIRCoefficients firstOrderLowpass(const double cutoff, const double dt)
+  {
+    const LowpassCoefficient lowpass(cutoff, dt);
+    IIRCoefficients c;
+    c.b0 = 1 - lowpass.a;
+    c.a1 = -lowpass.a;
+    return c;
+  }
+
+  // second order Butterworth by the bilinear transform with the cutoff prewarped
+  static IIRCoefficients butterworthLowpass(const double cutoff, const double dt)
+  {
+    const double k = std::tan(M_PI * cutoff * dt);
+    const double k2 = k * k;
+    const double norm = 1 / (1 + M_SQRT2 * k + k2);
+    IIRCoefficients c;
+    c.b0 = k2 * norm;
+    c.b1 = 2 * c.b0;
+    c.b2 = c.b0;
+    c.a1 = 2 * (k2 - 1) * norm;
+    c.a2 = (1 - M_SQRT2 * k + k2) * norm;
+    return c;
+  }
+
+  double dcGain() const { return (b0 + b1 + b2) / (1 + a1 + a2); }
+};
+
+/**
+ * @brief biquad filters of ChannelNum channels in the transposed direct form II. The coefficients
+ * and the states are stored per field (SoA), so that a step over all the channels is vectorized,
+ * and nothing is allocated after the construction.
+ */
+template <size_t ChannelNum>
+class BiquadFilterBank
+{
+public:
+  using Values = std::array<double, ChannelNum>;
+
+  BiquadFilterBank() { setCoefficients(IIRCoefficients{}); }
+  explicit BiquadFilterBank(const IIRCoefficients & coefficients)
+  {
+    setCoefficients(coefficients);
+  }
+
+  void setCoefficients(const IIRCoefficients & coefficients)
+  {
+    for (size_t i = 0; i < ChannelNum; ++i) {
+      setCoefficients(i, coefficients);
+    }
+  }
+
+  void setCoefficients(const size_t channel, const IIRCoefficients & coefficients)
+  {
+    b0_[channel] = coefficients.b0;
+    b1_[channel] = coefficients.b1;
+    b2_[channel] = coefficients.b2;
+    a1_[channel] = coefficients.a1;
+    a2_[channel] = coefficients.a2;
+  }
+
+  /**
+   * @brief set the states to the steady states of constant inputs, which avoids the transient from
+   * zero at the start
+   */
+  void reset(const Values & initial_values)
+  {
+    for (size_t i = 0; i < ChannelNum; ++i) {
+      const double x = initial_values[i];
+      const double y = x * (b0_[i] + b1_[i] + b2_[i]) / (1 + a1_[i] + a2_[i]);
+      s1_[i] = y - b0_[i] * x;
+      s2_[i] = b2_[i] * x - a2_[i] * y;
+    }
+  }
+
+  void reset()
+  {
+    s1_.fill(0.0);
+    s2_.fill(0.0);
+  }
+
+  /**
+   * @brief filter a sample of each channel
+   * @param input : samples of the channels
+   * @param output : filtered samples, which can be input itself
+   */
+  void filter(const double * input, double * output)
+  {
+    for (size_t i = 0; i < ChannelNum; ++i) {
+      const double x = input[i];
+      const double y = b0_[i] * x + s1_[i];
+      s1_[i] = b1_[i] * x - a1_[i] * y + s2_[i];
+      s2_[i] = b2_[i] * x - a2_[i] * y;
+      output[i] = y;
+    }
+  }
+
+  Values filter(const Values & input)
+  {
+    Values output;
+    filter(input.data(), output.data());
+    return output;
+  }
+
+private:
+  Values b0_;
+  Values b1_;
+  Values b2_;
+  Values a1_;
+  Values a2_;
+  Values s1_{};
+  Values s2_{};
+};
+
+/**
+ * @brief zero-phase filtering of a whole signal, forward and then backward, for the offline
+ * processing. Each pass starts from the steady state of the edge sample.
+ * @param input : vector like container
+ * @param output : filtered input, whose storage is reused
+ */
+template <class T>
+void filtfilt(const IIRCoefficients & coefficients, const T & input, std::vector<double> & output)
+{
+  output.assign(input.begin(), input.end());
+  if (output.empty()) {
+    return;
+  }
+  BiquadFilterBank<1> filter(coefficients);
+  filter.reset({output.front()});
+  for (auto & v : output) {
+    filter.filter(&v, &v);
+  }
+  filter.reset({output.back()});
+  for (auto itr = output.rbegin(); itr != output.rend(); ++itr) {
+    filter.filter(&*itr, &*itr);
+  }
+}
+
+}  // namespace math_utils
+
+#endif  // ESTIMATOR_UTILS__FILTER_UTILS_HPP_
@@ -19,7 +19,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <deque>
+#include <limits>
 #include <numeric>
 #include <utility>
 #include <vector>
@@ -40,9 +42,14 @@ inline double normalize(const double val, const double min, const double max)
   return (val - min) / (max - min);
 }
 
-inline std::vector<double> getLinearInterpolation(const std::vector<double> & arr, int num_interp)
+/**
+ * @param : arr vector like container
+ * @param : interp interpolated arr, whose storage is reused
+ */
+template <class T>
+void getLinearInterpolation(const T & arr, int num_interp, std::vector<double> & interp)
 {
-  std::vector<double> interp;
+  interp.clear();
   for (size_t i = 1; i < arr.size(); i++) {
     double a = arr[i - 1];
     double b = arr[i];
@@ -52,7 +59,13 @@ inline std::vector<double> getLinearInterpolation(const std::vector<double> & ar
       interp.emplace_back(val);
     }
   }
-  interp.emplace_back(arr.back());
+  interp.emplace_back(arr[arr.size() - 1]);
+}
+
+inline std::vector<double> getLinearInterpolation(const std::vector<double> & arr, int num_interp)
+{
+  std::vector<double> interp;
+  getLinearInterpolation(arr, num_interp, interp);
   return interp;
 }
 
@@ -166,6 +179,78 @@ double getCorrelationCoefficientFromVector(const T & x, const T & y, const T & w
   return xy_cov / (x_stddev * y_stddev);
 }
 
+// a * b + c, fused into 1 instruction where the target has FMA, and computed as is otherwise,
+// since std::fma is a slow library call without the instruction
+inline double multiplyAdd(const double a, const double b, const double c)
+{
+#if defined(__FMA__) || defined(__ARM_FEATURE_FMA)
+  return std::fma(a, b, c);
+#else
+  return a * b + c;
+#endif
+}
+
+/**
+ * @brief the same as getCorrelationCoefficientFromVector with weights, in a single pass over
+ * contiguous ranges, e.g. the shifted ranges of the same buffers for each shift. The samples are
+ * padded with zeros up to weight_sum, as the shifted signals of calcCrossCorrelationCoefficient.
+ * The moments are taken around the first samples to avoid the cancellation of E[x^2] - E[x]^2,
+ * and are accumulated in 4 independent lanes, so that the compiler can vectorize the pass.
+ * @param size : number of the samples in x, y and w
+ * @param weight_sum : sum of the weights of the samples and of the padding zeros
+ */
+inline double getCorrelationCoefficientFromRange(
+  const double * x, const double * y, const double * w, const size_t size, const double weight_sum)
+{
+  if (size == 0 || weight_sum == 0.0) {
+    return 0;
+  }
+  constexpr size_t lane = 4;
+  const size_t vec_size = size - size % lane;
+  const double x_ref = x[0];
+  const double y_ref = y[0];
+  double sum_w[lane] = {0, 0, 0, 0};
+  double sum_x[lane] = {0, 0, 0, 0};
+  double sum_y[lane] = {0, 0, 0, 0};
+  double sum_xx[lane] = {0, 0, 0, 0};
+  double sum_yy[lane] = {0, 0, 0, 0};
+  double sum_xy[lane] = {0, 0, 0, 0};
+  const auto accumulate = [&](const size_t i, const size_t j) {
+    const double dx = x[i] - x_ref;
+    const double dy = y[i] - y_ref;
+    const double w_dx = w[i] * dx;
+    const double w_dy = w[i] * dy;
+    sum_w[j] += w[i];
+    sum_x[j] += w_dx;
+    sum_y[j] += w_dy;
+    sum_xx[j] = multiplyAdd(w_dx, dx, sum_xx[j]);
+    sum_yy[j] = multiplyAdd(w_dy, dy, sum_yy[j]);
+    sum_xy[j] = multiplyAdd(w_dx, dy, sum_xy[j]);
+  };
+  for (size_t i = 0; i < vec_size; i += lane) {
+    for (size_t j = 0; j < lane; ++j) {
+      accumulate(i + j, j);
+    }
+  }
+  for (size_t i = vec_size; i < size; ++i) {
+    accumulate(i, i - vec_size);
+  }
+  const auto reduce = [](const double(&sum)[lane]) {
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+  };
+
+  // The padding zeros are -x_ref and -y_ref around the first samples
+  const double pad_w = weight_sum - reduce(sum_w);
+  const double x_avg = (reduce(sum_x) - pad_w * x_ref) / weight_sum;
+  const double y_avg = (reduce(sum_y) - pad_w * y_ref) / weight_sum;
+  const double x_var =
+    std::max((reduce(sum_xx) + pad_w * x_ref * x_ref) / weight_sum - x_avg * x_avg, 0.0);
+  const double y_var =
+    std::max((reduce(sum_yy) + pad_w * y_ref * y_ref) / weight_sum - y_avg * y_avg, 0.0);
+  const double xy_cov = (reduce(sum_xy) + pad_w * x_ref * y_ref) / weight_sum - x_avg * y_avg;
+  return xy_cov / (std::sqrt(x_var) * std::sqrt(y_var));
+}
+
 inline double lowpassFilter(
   const double current_value, const double prev_value, double cutoff, const double dt)
 {
@@ -176,19 +261,30 @@ inline double lowpassFilter(
 
 /**
  * @param : arr vector like container
- * @return : avg_arr processed arr vector
+ * @param : avg_arr processed arr vector, whose storage is reused
  */
 template <class T>
-std::vector<double> getAveragedVector(const T & arr)
+void getAveragedVector(const T & arr, std::vector<double> & avg_arr)
 {
+  avg_arr.assign(arr.begin(), arr.end());
   if (arr.empty()) {
-    return arr;
+    return;
   }
-  std::vector<double> avg_arr = {arr.begin(), arr.end()};
   double avg = std::accumulate((arr).begin(), (arr).end(), 0.0) / static_cast<double>(arr.size());
   for (auto & v : avg_arr) {
     v -= avg;
   }
+}
+
+/**
+ * @param : arr vector like container
+ * @return : avg_arr processed arr vector
+ */
+template <class T>
+std::vector<double> getAveragedVector(const T & arr)
+{
+  std::vector<double> avg_arr;
+  getAveragedVector(arr, avg_arr);
   return avg_arr;
 }
 
@@ -282,57 +378,284 @@ T calcCrossCorrelationCoefficient(
 }
 
 /**
- *
+ * @brief the weighted version, whose shifts are computed by getCorrelationCoefficientFromRange on
+ * the ranges of the signals reversed once
  * @param input : input signal
  * @param response : output signal
- * @param weight : weight for correlation
+ * @param weight : weight for correlation, of the reversed signals. The missing weights are 0
  * @param valid_delay_index_ratio : number of shift to compare rate
+ * @param parallel_for : called as parallel_for(num_shift, func) to call func(tau) for all the
+ * shifts, e.g. on the threads of a scheduler
  * @return corr : size of (input+num_shift) , type T correlation value
  */
-template <class T>
+template <class T, class ParallelFor>
 T calcCrossCorrelationCoefficient(
-  const T & input, const T & response, const T & weight, const double valid_delay_index_ratio)
+  const T & input, const T & response, const T & weight, const double valid_delay_index_ratio,
+  const ParallelFor & parallel_for)
 {
-  T r_input = input;
-  T r_response = response;
-  std::reverse(r_input.begin(), r_input.end());
-  std::reverse(r_response.begin(), r_response.end());
-  int T_interval = static_cast<int>(input.size() * valid_delay_index_ratio);
-  T CorrCoeff(T_interval, 0.0);
+  const size_t n = input.size();
+  const std::vector<double> r_input(input.rbegin(), input.rend());
+  const std::vector<double> r_response(response.rbegin(), response.rend());
+  std::vector<double> r_weight(n, 0.0);
+  std::copy_n(weight.begin(), std::min(n, static_cast<size_t>(weight.size())), r_weight.begin());
+  const double weight_sum = std::accumulate(r_weight.begin(), r_weight.end(), 0.0);
+  int T_interval = static_cast<int>(n * valid_delay_index_ratio);
+  T CorrCoeff(std::max(T_interval, 0), 0.0);
   /**
    * Correlation Coefficient Method
    * CorrCoeff = Cov(x1x2)/Stddev(x1)*Stddev(x2)
    */
-  for (int tau = 0; tau < T_interval - 1; tau++) {
-    T cmp_input(input.size());
-    T cmp_response(response.size());
-    copy(r_input.begin() + tau, r_input.end(), cmp_input.begin());
-    copy(r_response.begin(), r_response.end() - tau, cmp_response.begin());
-    CorrCoeff.at(tau) = getCorrelationCoefficientFromVector(cmp_input, cmp_response, weight);
+  if (T_interval < 2 || response.size() < n) {
+    return CorrCoeff;
   }
+  parallel_for(static_cast<size_t>(T_interval - 1), [&](const size_t tau) {
+    CorrCoeff[tau] = getCorrelationCoefficientFromRange(
+      r_input.data() + tau, r_response.data(), r_weight.data(), n - tau, weight_sum);
+  });
   return CorrCoeff;
 }
 
+/**
+ *
+ * @param input : input signal
+ * @param response : output signal
+ * @param weight : weight for correlation
+ * @param valid_delay_index_ratio : number of shift to compare rate
+ * @return corr : size of (input+num_shift) , type T correlation value
+ */
+template <class T>
+T calcCrossCorrelationCoefficient(
+  const T & input, const T & response, const T & weight, const double valid_delay_index_ratio)
+{
+  return calcCrossCorrelationCoefficient(
+    input, response, weight, valid_delay_index_ratio,
+    [](const size_t size, const auto & func) {
+      for (size_t i = 0; i < size; ++i) {
+        func(i);
+      }
+    });
+}
+
 template <class T>
 double calcMAE(const T & input, const T & response, const int delay_index)
 {
   size_t sz = input.size() / 2;
-  T r_input = input;
-  T r_response = response;
-  std::reverse(r_input.begin(), r_input.end());
-  std::reverse(r_response.begin(), r_response.end());
-  std::vector<double> errors;  // input - response
-  for (size_t i = 0; i < sz; i++) {
-    errors.emplace_back(r_input[i + delay_index] - r_response[i]);
-  }
+  // compare from the newest samples, without copying the reversed signals
+  const size_t last = input.size() - 1;
   double abs_sum = 0;
   for (size_t i = 0; i < sz; i++) {
-    abs_sum += std::abs(errors[i]);
+    abs_sum += std::abs(input[last - i - delay_index] - response[last - i]);
   }
   double mae = abs_sum / static_cast<double>(sz);
   return mae;
 }
 
+/**
+ * @brief the correlation coefficient at the shift tau of calcCrossCorrelationCoefficient with
+ * weight, without computing the other shifts
+ * @param cmp_input : buffer of the reversed input, whose storage is reused
+ * @param cmp_response : buffer of the reversed response, whose storage is reused
+ */
+template <class T>
+double calcCrossCorrelationCoefficientAt(
+  const T & input, const T & response, const std::vector<double> & weight, const int tau,
+  std::vector<double> & cmp_input, std::vector<double> & cmp_response)
+{
+  const size_t n = input.size();
+  if (static_cast<size_t>(tau) >= n) {
+    return 0;
+  }
+  cmp_input.assign(input.rbegin(), input.rend());
+  cmp_response.assign(response.rbegin(), response.rbegin() + n);
+  const size_t num_weight = std::min(n, weight.size());
+  const double weight_sum = std::accumulate(weight.begin(), weight.begin() + num_weight, 0.0);
+  return getCorrelationCoefficientFromRange(
+    cmp_input.data() + tau, cmp_response.data(), weight.data(), std::min(n - tau, num_weight),
+    weight_sum);
+}
+
+/**
+ * @param x : signal
+ * @param first : index of the first sample taken
+ * @param step : the samples are taken every step from first
+ * @param decimated : the taken samples, whose storage is reused
+ */
+template <class T>
+void decimate(const T & x, const size_t first, const size_t step, std::vector<double> & decimated)
+{
+  decimated.clear();
+  for (size_t i = first; i < x.size(); i += std::max<size_t>(step, 1)) {
+    decimated.push_back(x[i]);
+  }
+}
+
+/**
+ * @brief offset of the vertex of the parabola through 3 samples from the middle one, in [-0.5, 0.5]
+ */
+inline double getParabolicPeakOffset(const double prev, const double peak, const double next)
+{
+  const double curvature = prev - 2.0 * peak + next;
+  if (curvature == 0.0) {
+    return 0.0;
+  }
+  return saturation(0.5 * (prev - next) / curvature, -0.5, 0.5);
+}
+
+/**
+ * @brief coarse to fine search of the shift of the highest score in [0, num_shift). The
+ * num_candidates highest coarse scores, whose j-th is of the shift j * decimation, are refined by
+ * scoring every shift closer than decimation to them. The best shift is then climbed to a local
+ * maximum, and its sub-sample offset is interpolated with the parabola through its neighbors.
+ * All the shifts are scored if there is no coarse score.
+ * @param score : score of a shift at full resolution
+ * @param scores : the scores of the evaluated shifts, and the lowest double at the others
+ * @return : the best shift and its sub-sample offset
+ */
+template <class Score>
+std::pair<int, double> searchShiftCoarseToFine(
+  const std::vector<double> & coarse_scores, const int decimation, const size_t num_candidates,
+  const int num_shift, const Score & score, std::vector<double> & scores)
+{
+  scores.assign(std::max(num_shift, 0), std::numeric_limits<double>::lowest());
+  if (num_shift <= 0) {
+    return {0, 0.0};
+  }
+  std::vector<bool> is_evaluated(num_shift, false);
+  const auto evaluate = [&](const int shift) {
+    if (0 <= shift && shift < num_shift && !is_evaluated[shift]) {
+      scores[shift] = score(shift);
+      is_evaluated[shift] = true;
+    }
+  };
+
+  if (coarse_scores.empty()) {
+    for (int shift = 0; shift < num_shift; ++shift) {
+      evaluate(shift);
+    }
+  }
+  std::vector<size_t> candidates(coarse_scores.size());
+  std::iota(candidates.begin(), candidates.end(), 0);
+  const size_t num = std::min(num_candidates, candidates.size());
+  std::partial_sort(
+    candidates.begin(), candidates.begin() + num, candidates.end(),
+    [&](const size_t a, const size_t b) { return coarse_scores[a] > coarse_scores[b]; });
+  const int step = std::max(decimation, 1);
+  for (size_t i = 0; i < num; ++i) {
+    const int center = static_cast<int>(candidates[i]) * step;
+    for (int shift = center - step + 1; shift < center + step; ++shift) {
+      evaluate(shift);
+    }
+  }
+
+  int best = getMaximumIndexFromVector(scores);
+  while (true) {
+    evaluate(best - 1);
+    evaluate(best + 1);
+    if (best > 0 && scores[best - 1] > scores[best]) {
+      --best;
+    } else if (best + 1 < num_shift && scores[best + 1] > scores[best]) {
+      ++best;
+    } else {
+      break;
+    }
+  }
+  if (best == 0 || best + 1 == num_shift) {
+    return {best, 0.0};
+  }
+  return {best, getParabolicPeakOffset(scores[best - 1], scores[best], scores[best + 1])};
+}
+
+/**
+ * @brief running mean and variance with the Welford update, which is numerically stable for
+ * long runs and large offsets, unlike E[x^2] - E[x]^2
+ */
+struct RunningStatistic
+{
+  size_t count = 0;
+  double mean = 0;
+  // sum of the squared deviations from the mean
+  double m2 = 0;
+
+  void add(const double val)
+  {
+    ++count;
+    const double delta = val - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (val - mean);
+  }
+
+  /**
+   * @brief add the samples of a contiguous range at once. Each pass keeps 4 independent
+   * accumulators, so that the compiler can vectorize it without reordering the sums
+   */
+  void addBatch(const double * data, const size_t size)
+  {
+    if (size == 0) {
+      return;
+    }
+    constexpr size_t lane = 4;
+    const size_t vec_size = size - size % lane;
+    double sum[lane] = {0, 0, 0, 0};
+    for (size_t i = 0; i < vec_size; i += lane) {
+      for (size_t j = 0; j < lane; ++j) {
+        sum[j] += data[i + j];
+      }
+    }
+    double batch_sum = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (size_t i = vec_size; i < size; ++i) {
+      batch_sum += data[i];
+    }
+    const double batch_mean = batch_sum / static_cast<double>(size);
+
+    double sq[lane] = {0, 0, 0, 0};
+    for (size_t i = 0; i < vec_size; i += lane) {
+      for (size_t j = 0; j < lane; ++j) {
+        const double d = data[i + j] - batch_mean;
+        sq[j] += d * d;
+      }
+    }
+    double batch_m2 = (sq[0] + sq[1]) + (sq[2] + sq[3]);
+    for (size_t i = vec_size; i < size; ++i) {
+      const double d = data[i] - batch_mean;
+      batch_m2 += d * d;
+    }
+
+    RunningStatistic batch;
+    batch.count = size;
+    batch.mean = batch_mean;
+    batch.m2 = batch_m2;
+    merge(batch);
+  }
+
+  void addBatch(const std::vector<double> & data) { addBatch(data.data(), data.size()); }
+
+  /**
+   * @brief combine the statistic of other samples with Chan's formula, e.g. for the partial
+   * results of a parallel reduction
+   */
+  void merge(const RunningStatistic & other)
+  {
+    if (other.count == 0) {
+      return;
+    }
+    if (count == 0) {
+      *this = other;
+      return;
+    }
+    const double n_a = static_cast<double>(count);
+    const double n_b = static_cast<double>(other.count);
+    const double n = n_a + n_b;
+    const double delta = other.mean - mean;
+    mean += delta * n_b / n;
+    m2 += other.m2 + delta * delta * n_a * n_b / n;
+    count += other.count;
+  }
+
+  // population variance, as the other statistics of this file
+  double variance() const { return count == 0 ? 0.0 : m2 / static_cast<double>(count); }
+  double stddev() const { return std::sqrt(variance()); }
+};
+
 struct Statistics
 {
   Statistics() {}
@@ -352,18 +675,17 @@ struct Statistics
 
 inline void calcSequentialStddev(Statistics & stat)
 {
+  // the Welford update of each dimension, whose sum of the squared deviations is variance * count
   auto & cnt = stat.count;
-  double seq = static_cast<double>(cnt);
   for (size_t i = 0; i < stat.value.size(); i++) {
-    auto & mean = stat.mean[i];
-    auto & variance = stat.variance[i];
-    auto & val = stat.value[i];
-    auto & stddev = stat.stddev[i];
-    const auto old_avg = stat.mean[i];
-    mean = (seq * mean + val) / (seq + 1.0);
-    variance = (seq * (variance + std::pow(old_avg, 2)) + std::pow(val, 2)) / (seq + 1.0) -
-               std::pow(mean, 2);
-    stddev = std::sqrt(variance);
+    RunningStatistic running;
+    running.count = static_cast<size_t>(cnt);
+    running.mean = stat.mean[i];
+    running.m2 = stat.variance[i] * static_cast<double>(cnt);
+    running.add(stat.value[i]);
+    stat.mean[i] = running.mean;
+    stat.variance[i] = running.variance();
+    stat.stddev[i] = running.stddev();
   }
   cnt++;
 }
@@ -379,13 +701,15 @@ struct Statistic
   // O(1) speed stddev & mean
   double calcSequentialStddev(const double val)
   {
-    double old_avg = mean;
-    double seq = static_cast<double>(cnt);
-    mean = (seq * mean + val) / (seq + 1.0);
-    variance = (seq * (variance + std::pow(old_avg, 2)) + std::pow(val, 2)) / (seq + 1.0) -
-               std::pow(mean, 2);
+    RunningStatistic running;
+    running.count = static_cast<size_t>(cnt);
+    running.mean = mean;
+    running.m2 = variance * static_cast<double>(cnt);
+    running.add(val);
+    mean = running.mean;
+    variance = running.variance();
     cnt++;
-    return std::sqrt(variance);
+    return running.stddev();
   }
 };
 }  // namespace math_utils
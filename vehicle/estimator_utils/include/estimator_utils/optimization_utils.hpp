@@ -22,6 +22,9 @@
 #include <eigen3/Eigen/Geometry>
 #include <eigen3/Eigen/LU>
 
+#include <array>
+#include <cmath>
+#include <cstddef>
 #include <vector>
 
 namespace optimization_utils
@@ -52,6 +55,163 @@ inline void estimateByRLS(
   est = est + coef * error(0, 0);
 }
 
+/**
+ * @brief RLS of N parameters on fixed-size matrices, which allocates nothing. The covariance is
+ * updated in the Joseph form and symmetrized, so it stays symmetric positive semi-definite under
+ * rounding errors even with a small forgetting factor
+ */
+template <int N>
+void estimateByRLS(
+  Eigen::Matrix<double, N, 1> & est, Eigen::Matrix<double, N, N> & cov,
+  const Eigen::Matrix<double, N, 1> & zn, const double ff, const double y)
+{
+  /**
+   * coef_n=(cov_n-1*zn_n)/(rho_n+zn^T_n*cov_n-1*zn_n)
+   * cov_n=[(I-coef*zn^T)*cov_n-1*(I-coef*zn^T)^T+rho_n*coef*coef^T]/rho_n
+   * th_n=th_n-1+coef_n*epsilon_n
+   * eps_n=y_n-zn^T_n*th_n-1
+   */
+  const Eigen::Matrix<double, N, 1> cov_zn = cov * zn;
+  const Eigen::Matrix<double, N, 1> coef = cov_zn / (ff + zn.dot(cov_zn));
+  const Eigen::Matrix<double, N, N> i_kz =
+    Eigen::Matrix<double, N, N>::Identity() - coef * zn.transpose();
+  const Eigen::Matrix<double, N, N> joseph =
+    (i_kz * cov * i_kz.transpose() + ff * coef * coef.transpose()) / ff;
+  cov = 0.5 * (joseph + joseph.transpose());
+  const double error = y - zn.dot(est);
+  est += coef * error;
+}
+
+/**
+ * @brief bank of RLS hypotheses of N parameters, each with its forgetting factor and initial
+ * covariance. An entry of the parameters or the covariances of all the hypotheses is a contiguous
+ * row, so an update of all of them is vectorized over the hypotheses. The update is the Joseph form
+ * of estimateByRLS<N>, and the a priori errors of each hypothesis are accumulated to select the one
+ * predicting best
+ */
+template <int N>
+class RLSBank
+{
+public:
+  using Vector = Eigen::Matrix<double, N, 1>;
+  using Matrix = Eigen::Matrix<double, N, N>;
+
+  /**
+   * @param initial_covariance : initial covariance of a hypothesis, which is scaled by its
+   * covariance_scales
+   * @param forgetting_factors : forgetting factor of each hypothesis
+   * @param covariance_scales : scale of the initial covariance of each hypothesis
+   */
+  RLSBank(
+    const Vector & initial_estimate, const Matrix & initial_covariance,
+    const std::vector<double> & forgetting_factors, const std::vector<double> & covariance_scales)
+  : est_(N, forgetting_factors.size()),
+    cov_(N * N, forgetting_factors.size()),
+    ff_(forgetting_factors.size()),
+    covariance_scales_(forgetting_factors.size()),
+    sum_squared_error_(Row::Zero(forgetting_factors.size())),
+    cov_zn_(N, forgetting_factors.size()),
+    coef_(N, forgetting_factors.size())
+  {
+    for (size_t m = 0; m < size(); ++m) {
+      est_.col(m) = initial_estimate.array();
+      ff_(m) = forgetting_factors[m];
+      covariance_scales_(m) = covariance_scales.at(m);
+      const Matrix cov = initial_covariance * covariance_scales.at(m);
+      for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+          cov_(i * N + j, m) = cov(i, j);
+        }
+      }
+    }
+  }
+
+  size_t size() const { return static_cast<size_t>(ff_.size()); }
+
+  void update(const Vector & zn, const double y)
+  {
+    denominator_ = ff_;
+    error_ = Row::Constant(size(), y);
+    for (int i = 0; i < N; ++i) {
+      cov_zn_.row(i).setZero();
+      for (int j = 0; j < N; ++j) {
+        cov_zn_.row(i) += zn(j) * cov_.row(i * N + j);
+      }
+      denominator_ += zn(i) * cov_zn_.row(i);
+      error_ -= zn(i) * est_.row(i);
+    }
+    for (int i = 0; i < N; ++i) {
+      coef_.row(i) = cov_zn_.row(i) / denominator_;
+    }
+    // (I - coef zn^T) cov (I - coef zn^T)^T + ff coef coef^T
+    // = cov - coef cov_zn^T - cov_zn coef^T + (ff + zn^T cov zn) coef coef^T, which is symmetric
+    for (int i = 0; i < N; ++i) {
+      for (int j = i; j < N; ++j) {
+        cov_.row(i * N + j) = (cov_.row(i * N + j) - coef_.row(i) * cov_zn_.row(j) -
+                               cov_zn_.row(i) * coef_.row(j) +
+                               denominator_ * coef_.row(i) * coef_.row(j)) /
+                              ff_;
+        cov_.row(j * N + i) = cov_.row(i * N + j);
+      }
+      est_.row(i) += coef_.row(i) * error_;
+    }
+    sum_squared_error_ += error_.square();
+    ++num_update_;
+  }
+
+  Vector estimate(const size_t m) const { return est_.col(m).matrix(); }
+
+  Matrix covariance(const size_t m) const
+  {
+    Matrix cov;
+    for (int i = 0; i < N; ++i) {
+      for (int j = 0; j < N; ++j) {
+        cov(i, j) = cov_(i * N + j, m);
+      }
+    }
+    return cov;
+  }
+
+  double forgettingFactor(const size_t m) const { return ff_(m); }
+
+  double covarianceScale(const size_t m) const { return covariance_scales_(m); }
+
+  /**
+   * @brief mean of the squared a priori errors y - zn^T est of the updates so far
+   */
+  double meanSquaredError(const size_t m) const
+  {
+    return num_update_ == 0 ? 0.0 : sum_squared_error_(m) / static_cast<double>(num_update_);
+  }
+
+  /**
+   * @brief the hypothesis of the least mean squared a priori error
+   */
+  size_t best() const
+  {
+    Eigen::Index m = 0;
+    if (size() > 0) {
+      sum_squared_error_.minCoeff(&m);
+    }
+    return static_cast<size_t>(m);
+  }
+
+private:
+  using Row = Eigen::Array<double, 1, Eigen::Dynamic>;
+  using Rows = Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  Rows est_;
+  Rows cov_;
+  Row ff_;
+  Row covariance_scales_;
+  Row sum_squared_error_;
+  size_t num_update_{0};
+  // buffers of update
+  Rows cov_zn_;
+  Rows coef_;
+  Row denominator_;
+  Row error_;
+};
+
 /**
  * @param x_t latter value
  * @param t_x previous value
@@ -163,6 +323,70 @@ inline double getLeastSquaredError(
   return getErrorNorm(X, Y, w);
 }
 
+/**
+ * @brief least squared solutions of u = X w for the lags of the window of u, where the regressors
+ * X are fixed. X^T X is the same for all the lags and is inverted once in closed form, so a lag
+ * only costs X^T u and the error norm on fixed-size matrices without any allocation. A singular
+ * X^T X is solved by FullPivLU as getSolutionByLeastSquared does
+ */
+template <int N>
+class LaggedLeastSquared
+{
+public:
+  using Vector = Eigen::Matrix<double, N, 1>;
+  using Matrix = Eigen::Matrix<double, N, N>;
+
+  /**
+   * @param regressors : the columns of X, e.g. {&x_dot, &x}
+   * @param num_sample : the number of the last samples of the regressors used as X
+   */
+  LaggedLeastSquared(
+    const std::array<const std::vector<double> *, N> & regressors, const size_t num_sample)
+  : rows_(num_sample)
+  {
+    Matrix xtx = Matrix::Zero();
+    for (size_t i = 0; i < num_sample; ++i) {
+      for (int j = 0; j < N; ++j) {
+        const auto & regressor = *regressors[j];
+        rows_[i](j) = regressor[regressor.size() - num_sample + i];
+      }
+      xtx += rows_[i] * rows_[i].transpose();
+    }
+    xtx.computeInverseWithCheck(xtx_inverse_, is_invertible_);
+    if (!is_invertible_) {
+      lu_.compute(xtx);
+    }
+  }
+
+  size_t size() const { return rows_.size(); }
+
+  /**
+   * @brief solve with the window [u.end() - size() - lag, u.end() - lag) of u
+   * @return : the normalized error as getLeastSquaredError
+   */
+  double solve(const std::vector<double> & u, const size_t lag, Vector & w) const
+  {
+    const size_t offset = u.size() - size() - lag;
+    Vector xtu = Vector::Zero();
+    for (size_t i = 0; i < size(); ++i) {
+      xtu += rows_[i] * u[offset + i];
+    }
+    w = is_invertible_ ? Vector(xtx_inverse_ * xtu) : Vector(lu_.solve(xtu));
+
+    double error = 0.0;
+    for (size_t i = 0; i < size(); ++i) {
+      error += std::abs(rows_[i].dot(w) - u[offset + i]);
+    }
+    return error / static_cast<double>(size());
+  }
+
+private:
+  std::vector<Vector, Eigen::aligned_allocator<Vector>> rows_;
+  Matrix xtx_inverse_;
+  bool is_invertible_{false};
+  Eigen::FullPivLU<Matrix> lu_;
+};
+
 template <class T>
 bool change_abs_min(T & a, const T & b)
 {
@@ -0,0 +1,167 @@
+//
+//  Copyright 2021 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef ESTIMATOR_UTILS__RING_BUFFER_HPP_
+#define ESTIMATOR_UTILS__RING_BUFFER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace math_utils
+{
+/**
+ * @brief read-only view of contiguous elements, which works with the templates of math_utils
+ */
+template <class T>
+class Span
+{
+public:
+  Span() = default;
+  Span(const T * data, const size_t size) : data_(data), size_(size) {}
+  const T * data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const T * begin() const { return data_; }
+  const T * end() const { return data_ + size_; }
+  const T & operator[](const size_t i) const { return data_[i]; }
+  const T & front() const { return data_[0]; }
+  const T & back() const { return data_[size_ - 1]; }
+
+private:
+  const T * data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/**
+ * @brief ring buffer of a fixed capacity. Each element is written twice in the storage of twice
+ * the capacity, so the elements from the oldest to the newest are always contiguous and can be
+ * used as a Span without copying. Pushing to a full buffer overwrites the oldest element.
+ */
+template <class T>
+class RingBuffer
+{
+public:
+  RingBuffer() = default;
+  explicit RingBuffer(const size_t capacity) { setCapacity(capacity); }
+
+  // clear the buffer and allocate the storage for capacity elements
+  void setCapacity(const size_t capacity)
+  {
+    capacity_ = capacity;
+    storage_.assign(2 * capacity, T());
+    clear();
+  }
+
+  void clear()
+  {
+    head_ = 0;
+    size_ = 0;
+  }
+
+  void push_back(const T & value)
+  {
+    if (capacity_ == 0) {
+      return;
+    }
+    if (size_ == capacity_) {
+      pop_front();
+    }
+    const size_t idx = (head_ + size_) % capacity_;
+    storage_[idx] = value;
+    storage_[idx + capacity_] = value;
+    ++size_;
+  }
+  void emplace_back(const T & value) { push_back(value); }
+
+  void pop_front()
+  {
+    if (size_ == 0) {
+      return;
+    }
+    head_ = (head_ + 1) % capacity_;
+    --size_;
+  }
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  const T * begin() const { return storage_.data() + head_; }
+  const T * end() const { return begin() + size_; }
+  const T & operator[](const size_t i) const { return begin()[i]; }
+  const T & front() const { return *begin(); }
+  const T & back() const { return *(end() - 1); }
+  Span<T> span() const { return Span<T>(begin(), size_); }
+
+private:
+  std::vector<T> storage_;
+  size_t capacity_ = 0;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+/**
+ * @brief mean of the latest samples of a fixed window, updated in O(1) per sample. The running sum
+ * is recomputed once per window to keep the rounding errors from accumulating.
+ */
+class MovingAverage
+{
+public:
+  MovingAverage() = default;
+  explicit MovingAverage(const size_t window) { setWindow(window); }
+
+  void setWindow(const size_t window)
+  {
+    samples_.setCapacity(window);
+    clear();
+  }
+
+  void clear()
+  {
+    samples_.clear();
+    sum_ = 0.0;
+    num_pushed_ = 0;
+  }
+
+  void push(const double value)
+  {
+    if (samples_.capacity() == 0) {
+      return;
+    }
+    if (samples_.size() == samples_.capacity()) {
+      sum_ -= samples_.front();
+    }
+    samples_.push_back(value);
+    sum_ += value;
+    if (++num_pushed_ % samples_.capacity() == 0) {
+      sum_ = 0.0;
+      for (const auto & sample : samples_) {
+        sum_ += sample;
+      }
+    }
+  }
+
+  size_t size() const { return samples_.size(); }
+  bool empty() const { return samples_.empty(); }
+  double mean() const { return samples_.empty() ? 0.0 : sum_ / samples_.size(); }
+
+private:
+  RingBuffer<double> samples_;
+  double sum_ = 0.0;
+  size_t num_pushed_ = 0;
+};
+}  // namespace math_utils
+
+#endif  // ESTIMATOR_UTILS__RING_BUFFER_HPP_
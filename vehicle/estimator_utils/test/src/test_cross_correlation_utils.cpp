@@ -0,0 +1,108 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/cross_correlation_utils.hpp"
+#include "estimator_utils/math_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+TEST(cross_correlation_utils, FFT)
+{
+  using Complex = math_utils::FFT::Complex;
+  std::vector<Complex> data = {1, 2, 3, 4, 0, 0, 0, 0};
+  const auto original = data;
+  math_utils::FFT fft;
+  fft.transform(data, false);
+  EXPECT_NEAR(data[0].real(), 10.0, 1e-12);
+  EXPECT_NEAR(data[4].real(), -2.0, 1e-12);
+  fft.transform(data, true);
+  for (size_t i = 0; i < data.size(); ++i) {
+    EXPECT_NEAR(data[i].real(), original[i].real(), 1e-12);
+    EXPECT_NEAR(data[i].imag(), 0.0, 1e-12);
+  }
+}
+
+TEST(cross_correlation_utils, calcCrossCorrelationCoefficient)
+{
+  std::mt19937 engine(0);
+  std::normal_distribution<> noise(0.0, 0.05);
+  math_utils::CrossCorrelationEngine cc_engine;
+
+  for (const bool use_weight : {false, true}) {
+    for (const int size : {6, 100, 451}) {
+      // The response is the input delayed by 7 samples with noise
+      std::vector<double> input;
+      std::vector<double> response;
+      std::vector<double> weights;
+      for (int i = 0; i < size; ++i) {
+        input.push_back(0.5 + 0.4 * std::sin(0.05 * i));
+        response.push_back(0.5 + 0.4 * std::sin(0.05 * (i - 7)) + noise(engine));
+        weights.push_back(use_weight ? static_cast<double>(size - i) : 1.0);
+      }
+
+      const auto expected =
+        math_utils::calcCrossCorrelationCoefficient(input, response, weights, 0.1);
+      std::vector<double> output;
+      cc_engine.calcCrossCorrelationCoefficient(input, response, weights, 0.1, output);
+      ASSERT_EQ(output.size(), expected.size());
+      for (size_t i = 0; i < output.size(); ++i) {
+        EXPECT_NEAR(output[i], expected[i], 1e-9);
+      }
+      EXPECT_EQ(
+        math_utils::getMaximumIndexFromVector(output),
+        math_utils::getMaximumIndexFromVector(expected));
+    }
+  }
+}
+
+TEST(cross_correlation_utils, SlidingCrossCorrelation)
+{
+  std::mt19937 engine(0);
+  std::normal_distribution<> noise(0.0, 0.05);
+  const size_t window_size = 100;
+  const double valid_delay_index_ratio = 0.1;
+  const size_t num_lag = static_cast<size_t>(window_size * valid_delay_index_ratio) - 1;
+  math_utils::SlidingCrossCorrelation sliding_cc;
+  sliding_cc.reset(window_size, num_lag);
+
+  // The coefficients of the sliding window are the same as those of the latest samples
+  std::vector<double> input;
+  std::vector<double> response;
+  const std::vector<double> weights(window_size, 1.0);
+  for (int i = 0; i < 350; ++i) {
+    input.push_back(0.5 + 0.4 * std::sin(0.05 * i));
+    response.push_back(0.5 + 0.4 * std::sin(0.05 * (i - 5)) + noise(engine));
+    sliding_cc.push(input.back(), response.back());
+    if (input.size() < window_size || i % 25 != 0) {
+      continue;
+    }
+
+    const std::vector<double> input_window(input.end() - window_size, input.end());
+    const std::vector<double> response_window(response.end() - window_size, response.end());
+    const auto expected = math_utils::calcCrossCorrelationCoefficient(
+      input_window, response_window, weights, valid_delay_index_ratio);
+    std::vector<double> output;
+    sliding_cc.calcCrossCorrelationCoefficient(output);
+    ASSERT_EQ(output.size(), expected.size());
+    for (size_t j = 0; j < output.size(); ++j) {
+      EXPECT_NEAR(output[j], expected[j], 1e-9);
+    }
+  }
+}
@@ -0,0 +1,80 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/filter_utils.hpp"
+#include "estimator_utils/math_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+TEST(filter_utils, firstOrderLowpassMatchesLowpassFilter)
+{
+  const double cutoff = 0.5;
+  const double dt = 0.01;
+  const math_utils::LowpassCoefficient lowpass(cutoff, dt);
+  math_utils::BiquadFilterBank<2> bank(math_utils::IIRCoefficients::firstOrderLowpass(cutoff, dt));
+  bank.reset({1.0, -1.0});
+  double prev0 = 1.0;
+  double prev1 = -1.0;
+  for (int i = 0; i < 100; ++i) {
+    const double x0 = std::sin(0.1 * i);
+    const double x1 = std::cos(0.1 * i);
+    const auto y = bank.filter({x0, x1});
+    prev0 = math_utils::lowpassFilter(x0, prev0, cutoff, dt);
+    prev1 = lowpass.filter(x1, prev1);
+    EXPECT_NEAR(y[0], prev0, 1e-12);
+    EXPECT_NEAR(y[1], prev1, 1e-12);
+  }
+}
+
+TEST(filter_utils, butterworthLowpass)
+{
+  const auto c = math_utils::IIRCoefficients::butterworthLowpass(1.0, 0.01);
+  EXPECT_NEAR(c.dcGain(), 1.0, 1e-12);
+
+  // a high frequency is attenuated and a constant passes through from the steady state
+  math_utils::BiquadFilterBank<2> bank(c);
+  bank.reset({0.0, 3.0});
+  double max_high = 0.0;
+  for (int i = 0; i < 1000; ++i) {
+    const auto y = bank.filter({std::sin(2 * M_PI * 20.0 * 0.01 * i), 3.0});
+    if (i > 100) {
+      max_high = std::max(max_high, std::abs(y[0]));
+    }
+    EXPECT_NEAR(y[1], 3.0, 1e-9);
+  }
+  EXPECT_LT(max_high, 0.01);
+}
+
+TEST(filter_utils, filtfilt)
+{
+  // the zero-phase filter does not delay the peak of a slow signal
+  std::vector<double> x;
+  for (int i = 0; i < 400; ++i) {
+    x.push_back(std::exp(-std::pow((i - 200) / 30.0, 2)));
+  }
+  std::vector<double> y;
+  math_utils::filtfilt(math_utils::IIRCoefficients::butterworthLowpass(2.0, 0.01), x, y);
+  ASSERT_EQ(y.size(), x.size());
+  EXPECT_EQ(math_utils::getMaximumIndexFromVector(y), 200);
+
+  std::vector<double> empty;
+  math_utils::filtfilt(math_utils::IIRCoefficients{}, std::vector<double>{}, empty);
+  EXPECT_TRUE(empty.empty());
+}
@@ -23,6 +23,7 @@
 #include <chrono>
 #include <cmath>
 #include <deque>
+#include <limits>
 #include <numeric>
 #include <random>
 #include <utility>
@@ -82,6 +83,47 @@ TEST(math_utils, Statistics)
   }
 }
 
+TEST(math_utils, RunningStatistic)
+{
+  // a large offset, with which E[x^2] - E[x]^2 loses all the digits
+  std::vector<double> x;
+  for (int i = 0; i < 1003; ++i) {
+    x.push_back(1e9 + (i % 7));
+  }
+  const double mean = math_utils::getAverageFromVector(x);
+  const double stddev = math_utils::getStddevFromVector(x);
+
+  math_utils::RunningStatistic sequential;
+  for (const double v : x) {
+    sequential.add(v);
+  }
+  EXPECT_EQ(sequential.count, x.size());
+  EXPECT_NEAR(sequential.mean, mean, 1e-6);
+  EXPECT_NEAR(sequential.stddev(), stddev, 1e-6);
+
+  math_utils::RunningStatistic batch;
+  batch.addBatch(x);
+  EXPECT_EQ(batch.count, x.size());
+  EXPECT_NEAR(batch.mean, mean, 1e-6);
+  EXPECT_NEAR(batch.stddev(), stddev, 1e-6);
+
+  // merged partial results, as in a parallel reduction
+  math_utils::RunningStatistic first;
+  math_utils::RunningStatistic second;
+  first.addBatch(x.data(), 500);
+  second.addBatch(x.data() + 500, x.size() - 500);
+  first.merge(second);
+  first.merge(math_utils::RunningStatistic{});
+  EXPECT_EQ(first.count, x.size());
+  EXPECT_NEAR(first.mean, mean, 1e-6);
+  EXPECT_NEAR(first.stddev(), stddev, 1e-6);
+
+  math_utils::RunningStatistic empty;
+  empty.addBatch(x.data(), 0);
+  EXPECT_EQ(empty.count, 0u);
+  EXPECT_DOUBLE_EQ(empty.stddev(), 0.0);
+}
+
 TEST(math_utils, getAveragedVector)
 {
   using ::testing::ElementsAre;
@@ -109,3 +151,121 @@ TEST(math_utils, fitToTheSizeOfVector)
   math_utils::fitToTheSizeOfVector(input_stamp, response_stamp, input, response, 5, 1);
   ASSERT_THAT(input, testing::ElementsAre(3, 4, 5, 5, 6));
 }
+
+TEST(math_utils, calcCrossCorrelationCoefficientAt)
+{
+  std::vector<double> input = {0, 1, 3, 2, -1, 0, 2, 4, 1, -2};
+  std::vector<double> response = {0, 0, 0, 1, 3, 2, -1, 0, 2, 4};
+  std::vector<double> weight = {10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+  const auto corr = math_utils::calcCrossCorrelationCoefficient(input, response, weight, 0.5);
+  std::vector<double> cmp_input;
+  std::vector<double> cmp_response;
+  for (int tau = 0; tau + 1 < static_cast<int>(corr.size()); ++tau) {
+    EXPECT_DOUBLE_EQ(
+      math_utils::calcCrossCorrelationCoefficientAt(
+        input, response, weight, tau, cmp_input, cmp_response),
+      corr.at(tau));
+  }
+}
+
+TEST(math_utils, getCorrelationCoefficientFromRange)
+{
+  // large offsets, whose moments would cancel without the reference samples
+  std::mt19937 engine(0);
+  std::normal_distribution<double> noise(0.0, 0.1);
+  const size_t n = 103;
+  const size_t size = 90;
+  std::vector<double> x(n, 0.0);
+  std::vector<double> y(n, 0.0);
+  std::vector<double> w(n);
+  for (size_t i = 0; i < n; ++i) {
+    if (i < size) {
+      x[i] = 1000.0 + std::sin(0.1 * static_cast<double>(i)) + noise(engine);
+      y[i] = -500.0 + std::cos(0.1 * static_cast<double>(i)) + noise(engine);
+    }
+    w[i] = 1.0 + 0.5 * std::cos(0.3 * static_cast<double>(i));
+  }
+  const double weight_sum = std::accumulate(w.begin(), w.end(), 0.0);
+  EXPECT_NEAR(
+    math_utils::getCorrelationCoefficientFromRange(x.data(), y.data(), w.data(), size, weight_sum),
+    math_utils::getCorrelationCoefficientFromVector(x, y, w), 1e-9);
+  EXPECT_DOUBLE_EQ(
+    math_utils::getCorrelationCoefficientFromRange(x.data(), y.data(), w.data(), 0, 1.0), 0.0);
+}
+
+TEST(math_utils, calcCrossCorrelationCoefficientParallel)
+{
+  std::vector<double> input = {0, 1, 3, 2, -1, 0, 2, 4, 1, -2, 0, 1, 3, 2, -1, 0};
+  std::vector<double> response = {0, 0, 0, 1, 3, 2, -1, 0, 2, 4, 1, -2, 0, 1, 3, 2};
+  std::vector<double> weight(input.size(), 1.0);
+  const auto corr = math_utils::calcCrossCorrelationCoefficient(input, response, weight, 0.5);
+  // the shifts in the reverse order, as if they were taken by other threads
+  std::vector<size_t> computed;
+  const auto parallel_corr = math_utils::calcCrossCorrelationCoefficient(
+    input, response, weight, 0.5, [&](const size_t size, const auto & func) {
+      for (size_t i = size; i > 0; --i) {
+        func(i - 1);
+        computed.push_back(i - 1);
+      }
+    });
+  ASSERT_EQ(parallel_corr.size(), corr.size());
+  EXPECT_EQ(computed.size(), corr.size() - 1);
+  for (size_t tau = 0; tau < corr.size(); ++tau) {
+    EXPECT_DOUBLE_EQ(parallel_corr[tau], corr[tau]);
+  }
+}
+
+TEST(math_utils, decimate)
+{
+  std::vector<double> x = {0, 1, 2, 3, 4, 5, 6};
+  std::vector<double> decimated = {9};
+  math_utils::decimate(x, 0, 3, decimated);
+  ASSERT_THAT(decimated, testing::ElementsAre(0, 3, 6));
+  math_utils::decimate(x, 2, 2, decimated);
+  ASSERT_THAT(decimated, testing::ElementsAre(2, 4, 6));
+}
+
+TEST(math_utils, getParabolicPeakOffset)
+{
+  // the parabola -(x - 0.25)^2 sampled at -1, 0 and 1
+  EXPECT_DOUBLE_EQ(math_utils::getParabolicPeakOffset(-1.5625, -0.0625, -0.5625), 0.25);
+  EXPECT_DOUBLE_EQ(math_utils::getParabolicPeakOffset(1.0, 1.0, 1.0), 0.0);
+  EXPECT_DOUBLE_EQ(math_utils::getParabolicPeakOffset(-1.0, 1.0, 2.0), 0.5);
+}
+
+TEST(math_utils, searchShiftCoarseToFine)
+{
+  const double peak = 37.3;
+  const auto score = [&](const int shift) { return -(shift - peak) * (shift - peak); };
+  const int decimation = 4;
+  std::vector<double> coarse_scores;
+  for (int shift = 0; shift < 100; shift += decimation) {
+    coarse_scores.push_back(score(shift));
+  }
+  int num_evaluated = 0;
+  std::vector<double> scores;
+  const auto result = math_utils::searchShiftCoarseToFine(
+    coarse_scores, decimation, 2, 100,
+    [&](const int shift) {
+      ++num_evaluated;
+      return score(shift);
+    },
+    scores);
+  EXPECT_EQ(result.first, 37);
+  EXPECT_NEAR(result.first + result.second, peak, 1e-9);
+  EXPECT_LE(num_evaluated, 2 * (2 * decimation - 1));
+  EXPECT_DOUBLE_EQ(scores.at(37), score(37));
+  EXPECT_EQ(scores.at(0), std::numeric_limits<double>::lowest());
+
+  // all the shifts are evaluated without the coarse scores
+  num_evaluated = 0;
+  const auto full = math_utils::searchShiftCoarseToFine(
+    {}, decimation, 2, 100,
+    [&](const int shift) {
+      ++num_evaluated;
+      return score(shift);
+    },
+    scores);
+  EXPECT_EQ(full.first, 37);
+  EXPECT_EQ(num_evaluated, 100);
+}
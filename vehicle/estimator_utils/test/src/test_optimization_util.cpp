@@ -101,3 +101,127 @@ TEST(optimization_utils, getSecondaryCentralDifference)
   EXPECT_DOUBLE_EQ(xd, 2);
   EXPECT_DOUBLE_EQ(xdd, 0);
 }
+
+TEST(optimization_utils, estimateByRLSFixedSize)
+{
+  // The fixed-size RLS gives the same estimation as the dynamic one and converges to the truth
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<> dist(-1.0, 1.0);
+  const Eigen::Vector3d truth(15.7, 0.053, 0.047);
+  const double ff = 0.99;
+  Eigen::Vector3d est = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d cov = Eigen::Matrix3d::Identity() * 100.0;
+  Eigen::MatrixXd est_dynamic = est;
+  Eigen::MatrixXd cov_dynamic = cov;
+  const Eigen::MatrixXd ff_dynamic = Eigen::MatrixXd::Identity(1, 1) * ff;
+  for (int i = 0; i < 500; ++i) {
+    const Eigen::Vector3d zn(1.0, 10.0 * dist(engine), 5.0 * dist(engine));
+    const double y = zn.dot(truth);
+    optimization_utils::estimateByRLS<3>(est, cov, zn, ff, y);
+    const Eigen::MatrixXd zn_dynamic = zn;
+    const Eigen::MatrixXd y_dynamic = Eigen::MatrixXd::Constant(1, 1, y);
+    optimization_utils::estimateByRLS(est_dynamic, cov_dynamic, zn_dynamic, ff_dynamic, y_dynamic);
+    for (int j = 0; j < 3; ++j) {
+      ASSERT_NEAR(est(j), est_dynamic(j, 0), 1e-6);
+    }
+  }
+  for (int j = 0; j < 3; ++j) {
+    EXPECT_NEAR(est(j), truth(j), 1e-4);
+  }
+  EXPECT_TRUE(cov.isApprox(cov.transpose()));
+}
+
+TEST(optimization_utils, RLSBank)
+{
+  // Each hypothesis gives the same estimation as its own fixed-size RLS
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<> dist(-1.0, 1.0);
+  std::normal_distribution<> noise(0.0, 0.01);
+  const Eigen::Vector3d truth(15.7, 0.053, 0.047);
+  const std::vector<double> ffs = {0.9, 0.99, 0.999, 0.99};
+  const std::vector<double> scales = {1.0, 10.0, 100.0, 1e-6};
+  const Eigen::Matrix3d initial_cov = Eigen::Matrix3d::Identity() + 0.1 * Eigen::Matrix3d::Ones();
+  optimization_utils::RLSBank<3> bank(Eigen::Vector3d::Zero(), initial_cov, ffs, scales);
+  ASSERT_EQ(bank.size(), 4u);
+  std::vector<Eigen::Vector3d> ests(ffs.size(), Eigen::Vector3d::Zero());
+  std::vector<Eigen::Matrix3d> covs;
+  for (const double scale : scales) {
+    covs.push_back(initial_cov * scale);
+  }
+  for (int i = 0; i < 500; ++i) {
+    const Eigen::Vector3d zn(1.0, 10.0 * dist(engine), 5.0 * dist(engine));
+    const double y = zn.dot(truth) + noise(engine);
+    bank.update(zn, y);
+    for (size_t m = 0; m < ffs.size(); ++m) {
+      optimization_utils::estimateByRLS<3>(ests[m], covs[m], zn, ffs[m], y);
+      ASSERT_TRUE(bank.estimate(m).isApprox(ests[m], 1e-6));
+      ASSERT_TRUE(bank.covariance(m).isApprox(covs[m], 1e-6));
+    }
+  }
+  // The small initial covariance cannot leave the initial estimate, and the small forgetting
+  // factor follows the noise
+  EXPECT_EQ(bank.best(), 2u);
+  EXPECT_DOUBLE_EQ(bank.forgettingFactor(bank.best()), 0.999);
+  EXPECT_GT(bank.meanSquaredError(3), bank.meanSquaredError(2));
+}
+
+TEST(optimization_utils, LaggedLeastSquared)
+{
+  // Each lag gives the same solution and error as getLeastSquaredError on the copied window
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<> dist(-1.0, 1.0);
+  const size_t n = 200;
+  const size_t num_sample = 150;
+  std::vector<double> x2dot(n);
+  std::vector<double> x_dot(n);
+  std::vector<double> x(n);
+  std::vector<double> u(n);
+  for (size_t i = 0; i < n; ++i) {
+    x2dot[i] = dist(engine);
+    x_dot[i] = dist(engine);
+    x[i] = std::sin(0.1 * i) + 0.1 * dist(engine);
+    u[i] = std::sin(0.1 * i - 0.5);
+  }
+  const std::vector<double> y2dot = {x2dot.end() - num_sample, x2dot.end()};
+  const std::vector<double> y_dot = {x_dot.end() - num_sample, x_dot.end()};
+  const std::vector<double> y = {x.end() - num_sample, x.end()};
+
+  const optimization_utils::LaggedLeastSquared<2> first_order({&x_dot, &x}, num_sample);
+  const optimization_utils::LaggedLeastSquared<3> second_order({&x2dot, &x_dot, &x}, num_sample);
+  for (size_t d = 0; d < n - num_sample; ++d) {
+    const std::vector<double> window = {u.end() - num_sample - d, u.end() - d};
+
+    Eigen::VectorXd w_expected;
+    Eigen::Vector2d w;
+    const double error_expected =
+      optimization_utils::getLeastSquaredError(y_dot, y, window, w_expected);
+    EXPECT_NEAR(first_order.solve(u, d, w), error_expected, 1e-9);
+    EXPECT_NEAR(w(0), w_expected(0), 1e-9);
+    EXPECT_NEAR(w(1), w_expected(1), 1e-9);
+
+    Eigen::VectorXd w2_expected;
+    Eigen::Vector3d w2;
+    const double error2_expected =
+      optimization_utils::getLeastSquaredError(y2dot, y_dot, y, window, w2_expected);
+    EXPECT_NEAR(second_order.solve(u, d, w2), error2_expected, 1e-9);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(w2(j), w2_expected(j), 1e-9);
+    }
+  }
+}
+
+TEST(optimization_utils, LaggedLeastSquaredSingular)
+{
+  // A singular X^T X falls back to FullPivLU and still fits u = X w
+  const std::vector<double> x = {1.0, 2.0, 3.0, 4.0};
+  const std::vector<double> u = {0.0, 2.0, 4.0, 6.0, 8.0};
+  const optimization_utils::LaggedLeastSquared<2> least_squared({&x, &x}, 4);
+  Eigen::Vector2d w;
+  EXPECT_NEAR(least_squared.solve(u, 0, w), 0.0, 1e-12);
+  EXPECT_NEAR(w(0) + w(1), 2.0, 1e-12);
+
+  const std::vector<double> window = {u.begin(), u.end() - 1};
+  Eigen::VectorXd w_expected;
+  const double expected = optimization_utils::getLeastSquaredError(x, x, window, w_expected);
+  EXPECT_NEAR(least_squared.solve(u, 1, w), expected, 1e-12);
+}
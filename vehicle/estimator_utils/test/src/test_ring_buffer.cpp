@@ -0,0 +1,112 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "estimator_utils/math_utils.hpp"
+#include "estimator_utils/ring_buffer.hpp"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+TEST(ring_buffer, pushAndPop)
+{
+  using testing::ElementsAre;
+  math_utils::RingBuffer<double> buffer(3);
+  EXPECT_TRUE(buffer.empty());
+  buffer.push_back(1);
+  buffer.push_back(2);
+  buffer.push_back(3);
+  buffer.push_back(4);  // overwrites 1
+  ASSERT_EQ(buffer.size(), 3u);
+  EXPECT_DOUBLE_EQ(buffer.front(), 2);
+  EXPECT_DOUBLE_EQ(buffer.back(), 4);
+  const std::vector<double> elements(buffer.begin(), buffer.end());
+  ASSERT_THAT(elements, ElementsAre(2, 3, 4));
+  buffer.pop_front();
+  buffer.push_back(5);
+  buffer.push_back(6);
+  const auto span = buffer.span();
+  ASSERT_THAT(std::vector<double>(span.begin(), span.end()), ElementsAre(4, 5, 6));
+  buffer.clear();
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.capacity(), 3u);
+}
+
+TEST(ring_buffer, sameAsDeque)
+{
+  // The contiguous elements are the same as a deque over many turns of the buffer
+  const size_t capacity = 7;
+  math_utils::RingBuffer<double> buffer(capacity);
+  std::deque<double> expected;
+  for (int i = 0; i < 100; ++i) {
+    buffer.push_back(i);
+    expected.push_back(i);
+    if (expected.size() > capacity) {
+      expected.pop_front();
+    }
+    if (i % 3 == 0) {
+      buffer.pop_front();
+      expected.pop_front();
+    }
+    ASSERT_EQ(buffer.size(), expected.size());
+    for (size_t j = 0; j < expected.size(); ++j) {
+      EXPECT_DOUBLE_EQ(buffer[j], expected[j]);
+    }
+  }
+}
+
+TEST(ring_buffer, mathUtilsWithSpan)
+{
+  using testing::ElementsAre;
+  math_utils::RingBuffer<double> buffer(2);
+  buffer.push_back(-3);
+  buffer.push_back(0);
+  buffer.push_back(3);
+  const auto span = buffer.span();
+  std::vector<double> output;
+  math_utils::getLinearInterpolation(span, 3, output);
+  ASSERT_THAT(output, ElementsAre(0, 1, 2, 3));
+  math_utils::getAveragedVector(span, output);
+  ASSERT_THAT(output, ElementsAre(-1.5, 1.5));
+  EXPECT_DOUBLE_EQ(math_utils::getStddevFromVector(span), 1.5);
+}
+
+TEST(ring_buffer, movingAverage)
+{
+  math_utils::MovingAverage average(3);
+  EXPECT_DOUBLE_EQ(average.mean(), 0.0);
+  average.push(1);
+  average.push(2);
+  EXPECT_DOUBLE_EQ(average.mean(), 1.5);
+  std::deque<double> expected = {1, 2};
+  for (int i = 3; i < 50; ++i) {
+    average.push(i * 0.1);
+    expected.push_back(i * 0.1);
+    if (expected.size() > 3) {
+      expected.pop_front();
+    }
+    double sum = 0.0;
+    for (const auto & e : expected) {
+      sum += e;
+    }
+    ASSERT_EQ(average.size(), 3u);
+    EXPECT_NEAR(average.mean(), sum / 3.0, 1e-12);
+  }
+  average.clear();
+  EXPECT_TRUE(average.empty());
+}
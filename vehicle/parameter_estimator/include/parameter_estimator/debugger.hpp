@@ -17,6 +17,7 @@
 #ifndef PARAMETER_ESTIMATOR__DEBUGGER_HPP_
 #define PARAMETER_ESTIMATOR__DEBUGGER_HPP_
 
+#include "estimator_utils/optimization_utils.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 #include "autoware_internal_debug_msgs/msg/float32_multi_array_stamped.hpp"
@@ -41,6 +42,15 @@ struct Debugger
   rclcpp::Publisher<autoware_internal_debug_msgs::msg::Float32MultiArrayStamped>::SharedPtr
     pub_debug_;
   void publishDebugValue() { pub_debug_->publish(debug_values_); }
+  template <int N>
+  void setBestHypothesis(const optimization_utils::RLSBank<N> & hypotheses)
+  {
+    const size_t best = hypotheses.best();
+    debug_values_.data[10] = static_cast<float>(best);
+    debug_values_.data[11] = static_cast<float>(hypotheses.forgettingFactor(best));
+    debug_values_.data[12] = static_cast<float>(hypotheses.covarianceScale(best));
+    debug_values_.data[13] = static_cast<float>(hypotheses.meanSquaredError(best));
+  }
   static constexpr std::uint8_t num_debug_values_ = 20;
   mutable autoware_internal_debug_msgs::msg::Float32MultiArrayStamped debug_values_;
 };
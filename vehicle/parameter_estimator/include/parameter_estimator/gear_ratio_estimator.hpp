@@ -40,16 +40,23 @@ public:
     const std::vector<double> & est);
   ~GearRatioEstimator() {}
   void setData(const VehicleData & v) { data_ = v; }
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
 private:
+  static constexpr int max_dim_x_ = 4;
   VehicleData data_;
   Params params_;
   int dim_x_;
   std::unique_ptr<Debugger> debugger_;
-  Eigen::MatrixXd estimated_;
-  Eigen::MatrixXd covariance_;
-  Eigen::MatrixXd forgetting_factor_;
+  // fixed-size storage of at most max_dim_x_ parameters, of which dim_x_ are used
+  Eigen::Matrix<double, max_dim_x_, 1> estimated_;
+  Eigen::Matrix<double, max_dim_x_, max_dim_x_> covariance_;
+  double forgetting_factor_;
   double error_;
+  // the RLS hypotheses of Params, if any, of max_dim_x_ parameters of which dim_x_ are used
+  std::unique_ptr<optimization_utils::RLSBank<max_dim_x_>> hypotheses_;
+  template <int N>
+  void estimateModel(const Eigen::Matrix<double, N, 1> & zn, const double yn);
   bool estimate();
   bool checkIsValidData();
   void preprocessData() {}
@@ -22,6 +22,7 @@
 #include "parameter_estimator/gear_ratio_estimator.hpp"
 #include "parameter_estimator/parameters.hpp"
 #include "parameter_estimator/steer_offset_estimator.hpp"
+#include "parameter_estimator/timed_signal_buffer.hpp"
 #include "parameter_estimator/wheel_base_estimator.hpp"
 #include "rclcpp/rclcpp.hpp"
 
@@ -65,6 +66,14 @@ private:
   bool select_steer_offset_estimator;
   bool select_wheel_base_estimator;
   bool invert_imu_z;
+  bool use_synchronized_sampling_;
+
+  // samples for the synchronized sampling, which are interpolated at the stamps of the IMU
+  std::unique_ptr<TimedSignalBuffer> imu_buffer_;
+  std::unique_ptr<TimedSignalBuffer> velocity_buffer_;
+  std::unique_ptr<TimedSignalBuffer> steer_buffer_;
+  std::unique_ptr<TimedSignalBuffer> steer_wheel_buffer_;
+  size_t num_synchronized_samples_ = 0;
 
   double auto_mode_duration_ = 0;
   double last_manual_time_ = 0;
@@ -80,6 +89,9 @@ private:
   void callbackControlModeReport(
     const autoware_vehicle_msgs::msg::ControlModeReport::ConstSharedPtr msg);
   void timerCallback();
+  void processSynchronizedSamples();
+  void runEstimators(const VehicleData & v, const bool publish);
+  void publishEstimators();
   bool updateGearRatio();
 
 public:
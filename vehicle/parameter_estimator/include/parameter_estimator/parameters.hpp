@@ -17,14 +17,36 @@
 #ifndef PARAMETER_ESTIMATOR__PARAMETERS_HPP_
 #define PARAMETER_ESTIMATOR__PARAMETERS_HPP_
 
+#include <utility>
+#include <vector>
+
 struct Params
 {
   double valid_max_steer_rad;
   double valid_min_velocity;
   double valid_min_angular_velocity;
   bool is_showing_debug_info;
+  // If both are not empty, the RLS of each estimator runs a hypothesis for each pair of them, and
+  // the results are those of the hypothesis of the least mean squared a priori error
+  std::vector<double> hypothesis_forgetting_factors;
+  std::vector<double> hypothesis_initial_covariances;
 };
 
+/**
+ * @return : the forgetting factors and the initial covariances of all the pairs of the hypotheses
+ **/
+inline std::pair<std::vector<double>, std::vector<double>> getHypotheses(const Params & p)
+{
+  std::pair<std::vector<double>, std::vector<double>> hypotheses;
+  for (const double ff : p.hypothesis_forgetting_factors) {
+    for (const double cov : p.hypothesis_initial_covariances) {
+      hypotheses.first.push_back(ff);
+      hypotheses.second.push_back(cov);
+    }
+  }
+  return hypotheses;
+}
+
 struct VehicleData
 {
   double velocity;
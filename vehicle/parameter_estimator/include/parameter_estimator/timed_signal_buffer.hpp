@@ -0,0 +1,89 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef PARAMETER_ESTIMATOR__TIMED_SIGNAL_BUFFER_HPP_
+#define PARAMETER_ESTIMATOR__TIMED_SIGNAL_BUFFER_HPP_
+
+#include "estimator_utils/ring_buffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+/**
+ * @brief : the latest samples of a signal with their stamps, to be interpolated at the stamps of
+ * another signal
+ **/
+class TimedSignalBuffer
+{
+public:
+  explicit TimedSignalBuffer(const size_t capacity) : stamps_(capacity), values_(capacity) {}
+
+  // samples older than the latest one are dropped to keep the stamps sorted
+  void push(const double stamp, const double value)
+  {
+    if (!stamps_.empty() && stamp <= stamps_.back()) {
+      return;
+    }
+    stamps_.push_back(stamp);
+    values_.push_back(value);
+  }
+
+  void pop_front()
+  {
+    stamps_.pop_front();
+    values_.pop_front();
+  }
+
+  void clear()
+  {
+    stamps_.clear();
+    values_.clear();
+  }
+
+  bool empty() const { return stamps_.empty(); }
+  double oldestStamp() const { return stamps_.front(); }
+  double latestStamp() const { return stamps_.back(); }
+  double oldestValue() const { return values_.front(); }
+
+  /**
+   * @brief : linear interpolation of the samples
+   * @param stamp : stamp to interpolate at
+   * @param value : interpolated value
+   * @return : false if the stamp is out of the buffered samples
+   **/
+  bool interpolate(const double stamp, double & value) const
+  {
+    if (stamps_.empty() || stamp < stamps_.front() || stamps_.back() < stamp) {
+      return false;
+    }
+    const auto iter = std::lower_bound(stamps_.begin(), stamps_.end(), stamp);
+    const size_t i = static_cast<size_t>(std::distance(stamps_.begin(), iter));
+    if (i == 0) {
+      value = values_[0];
+      return true;
+    }
+    const double ratio = (stamp - stamps_[i - 1]) / (stamps_[i] - stamps_[i - 1]);
+    value = values_[i - 1] + ratio * (values_[i] - values_[i - 1]);
+    return true;
+  }
+
+private:
+  math_utils::RingBuffer<double> stamps_;
+  math_utils::RingBuffer<double> values_;
+};
+
+#endif  // PARAMETER_ESTIMATOR__TIMED_SIGNAL_BUFFER_HPP_
@@ -42,6 +42,8 @@ private:
   double forgetting_factor_;
   double estimated_;
   double error_;
+  // the RLS hypotheses of Params, if any
+  std::unique_ptr<optimization_utils::RLSBank<1>> hypotheses_;
   bool estimate();
   bool checkIsValidData();
   void preprocessData() {}
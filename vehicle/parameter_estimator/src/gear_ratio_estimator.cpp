@@ -16,6 +16,7 @@
 
 #include "parameter_estimator/gear_ratio_estimator.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -24,58 +25,74 @@ GearRatioEstimator::GearRatioEstimator(
   const std::vector<double> & est)
 {
   error_ = 0;
-  dim_x_ = est.size();
-  estimated_ = Eigen::MatrixXd::Zero(dim_x_, 1);
-  for (size_t i = 0; i < est.size(); i++) {
+  dim_x_ = std::min(static_cast<int>(est.size()), max_dim_x_);
+  estimated_.setZero();
+  for (int i = 0; i < dim_x_; i++) {
     estimated_(i, 0) = est.at(i);
   }
-  covariance_ =
-    (Eigen::MatrixXd::Identity(dim_x_, dim_x_) + 0.1 * Eigen::MatrixXd::Ones(dim_x_, dim_x_)) * cov;
-  forgetting_factor_ = Eigen::MatrixXd::Identity(1, 1) * ff;
+  // The covariances of the unused parameters are zero, so they are never updated
+  Eigen::Matrix<double, max_dim_x_, max_dim_x_> initial_covariance;
+  initial_covariance.setZero();
+  initial_covariance.topLeftCorner(dim_x_, dim_x_) =
+    Eigen::MatrixXd::Identity(dim_x_, dim_x_) + 0.1 * Eigen::MatrixXd::Ones(dim_x_, dim_x_);
+  covariance_ = initial_covariance * cov;
+  forgetting_factor_ = ff;
   params_ = p;
   debugger_ = std::make_unique<Debugger>("gear_ratio", node);
+  const auto [forgetting_factors, covariances] = getHypotheses(p);
+  if (!forgetting_factors.empty()) {
+    hypotheses_ = std::make_unique<optimization_utils::RLSBank<max_dim_x_>>(
+      estimated_, initial_covariance, forgetting_factors, covariances);
+  }
   // in estimator_base.h
   createPublisher("gear_ratio", node);
   result_statistics_ = math_utils::Statistics(dim_x_);
   error_statistics_ = math_utils::Statistics(1);
 }
 
+template <int N>
+void GearRatioEstimator::estimateModel(const Eigen::Matrix<double, N, 1> & zn, const double yn)
+{
+  Eigen::Matrix<double, N, 1> est = estimated_.template head<N>();
+  if (hypotheses_) {
+    Eigen::Matrix<double, max_dim_x_, 1> zn_max = Eigen::Matrix<double, max_dim_x_, 1>::Zero();
+    zn_max.template head<N>() = zn;
+    hypotheses_->update(zn_max, yn);
+    const size_t best = hypotheses_->best();
+    estimated_ = hypotheses_->estimate(best);
+    covariance_ = hypotheses_->covariance(best);
+    est = estimated_.template head<N>();
+    debugger_->setBestHypothesis(*hypotheses_);
+  } else {
+    Eigen::Matrix<double, N, N> cov = covariance_.template topLeftCorner<N, N>();
+    optimization_utils::estimateByRLS<N>(est, cov, zn, forgetting_factor_, yn);
+    estimated_.template head<N>() = est;
+    covariance_.template topLeftCorner<N, N>() = cov;
+  }
+  const double gear = zn.dot(est);
+  error_ = yn - gear;
+  auto & de = debugger_->debug_values_;
+  de.data[0] = gear;
+  de.data[1] = yn;
+  if (N == 3) {
+    const Eigen::Vector3d th(15.713, 0.053, 0.042);
+    de.data[2] = zn.template head<3>().dot(th);
+  }
+}
+
 bool GearRatioEstimator::estimate()
 {
   const auto & vel = data_.velocity;
   const auto & wheel_base = data_.wheel_base;
   const auto & wz = data_.angular_velocity;
   const auto & handle = data_.handle;
-  const auto & ff = forgetting_factor_;
-  auto & est = estimated_;
-  auto & cov = covariance_;
   // steering = handle / gear_ratio
   // gear_ratio=(a+b*v^2-c*abs(handle))
-  Eigen::MatrixXd zn = Eigen::MatrixXd::Zero(dim_x_, 1);
-  Eigen::MatrixXd yn = Eigen::MatrixXd::Zero(1, 1);
-  Eigen::MatrixXd th = Eigen::MatrixXd::Zero(dim_x_, 1);
-
+  const double yn = handle / std::atan2(wz * wheel_base, vel);
   if (dim_x_ == 3) {
-    yn(0, 0) = handle / std::atan2(wz * wheel_base, vel);
-    zn(0, 0) = 1.0;
-    zn(1, 0) = vel * vel;
-    zn(2, 0) = -std::fabs(handle);
+    estimateModel<3>(Eigen::Vector3d(1.0, vel * vel, -std::fabs(handle)), yn);
   } else if (dim_x_ == 4) {
-    yn(0, 0) = handle / std::atan2(wz * wheel_base, vel);
-    zn(0, 0) = 1.0;
-    zn(1, 0) = vel;
-    zn(2, 0) = vel * vel;
-    zn(3, 0) = -std::fabs(handle);
-  }
-  optimization_utils::estimateByRLS(est, cov, zn, ff, yn);
-  error_ = (yn - zn.transpose() * est)(0, 0);
-  auto & de = debugger_->debug_values_;
-  {
-    th << 15.713, 0.053, 0.042;
-    double gear = (zn.transpose() * est)(0, 0);
-    de.data[0] = gear;
-    de.data[1] = yn(0, 0);
-    de.data[2] = (zn.transpose() * th)(0, 0);
+    estimateModel<4>(Eigen::Vector4d(1.0, vel, vel * vel, -std::fabs(handle)), yn);
   }
   // if (error > 1.0) return false;
   return true;
@@ -0,0 +1,412 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Estimate the parameters from rosbag2 files without replaying them. The latest messages are
+// sampled at update_hz of the bag time, as the timer of the live node does, so a bag is processed
+// as fast as the CPU allows. The bags are processed by parallel worker processes, and the results
+// are written per bag and per vehicle, where the vehicle is the directory containing the bag.
+
+#include "autoware_vehicle_info_utils/vehicle_info_utils.hpp"
+#include "parameter_estimator/gear_ratio_estimator.hpp"
+#include "parameter_estimator/parameters.hpp"
+#include "parameter_estimator/steer_offset_estimator.hpp"
+#include "parameter_estimator/wheel_base_estimator.hpp"
+
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/metadata_io.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include "autoware_vehicle_msgs/msg/control_mode_report.hpp"
+#include "geometry_msgs/msg/twist_stamped.hpp"
+#include "sensor_msgs/msg/imu.hpp"
+#include "tier4_calibration_msgs/msg/float32_stamped.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+using ControlModeReport = autoware_vehicle_msgs::msg::ControlModeReport;
+using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
+using Imu = sensor_msgs::msg::Imu;
+using TwistStamped = geometry_msgs::msg::TwistStamped;
+
+// the name of the directory containing the bag, which is the bag directory or the storage file
+std::string getVehicleName(std::string bag_path)
+{
+  while (bag_path.size() > 1 && bag_path.back() == '/') {
+    bag_path.pop_back();
+  }
+  const auto bag_pos = bag_path.find_last_of('/');
+  if (bag_pos == std::string::npos || bag_pos == 0) {
+    return "unknown";
+  }
+  const std::string parent = bag_path.substr(0, bag_pos);
+  const auto parent_pos = parent.find_last_of('/');
+  return parent_pos == std::string::npos ? parent : parent.substr(parent_pos + 1);
+}
+
+void writeResult(
+  std::ostream & os, const std::string & bag_path, const std::string & name,
+  const EstimatorBase & estimator)
+{
+  const auto & stat = estimator.result_statistics_;
+  for (size_t i = 0; i < stat.value.size(); ++i) {
+    os << bag_path << "," << getVehicleName(bag_path) << "," << name << "," << i << ","
+       << estimator.seq_ << "," << stat.value[i] << "," << stat.mean[i] << "," << stat.stddev[i]
+       << "\n";
+  }
+}
+
+// run the estimators over a bag and write a row for each estimated value to output_path
+int processBag(
+  const std::string & bag_path, const std::vector<std::string> & param_paths,
+  const std::string & output_path)
+{
+  // The node is only used for the parameters and the publishers of the estimators and is never
+  // spun
+  rclcpp::init(0, nullptr);
+  std::vector<std::string> arguments = {"--ros-args"};
+  for (const auto & param_path : param_paths) {
+    arguments.push_back("--params-file");
+    arguments.push_back(param_path);
+  }
+  rclcpp::NodeOptions node_options;
+  node_options.arguments(arguments);
+  auto node = std::make_shared<rclcpp::Node>("parameter_estimator_batch_tool", node_options);
+
+  const auto vehicle_info = autoware::vehicle_info_utils::VehicleInfoUtils(*node).getVehicleInfo();
+  const double wheel_base = vehicle_info.wheel_base_m;
+  const bool use_auto_mode = node->declare_parameter<bool>("use_auto_mode", true);
+  const double update_hz = node->declare_parameter<double>("update_hz", 10.0);
+  const double covariance = node->declare_parameter<double>("initial_covariance", 1.0);
+  const double forgetting_factor = node->declare_parameter<double>("forgetting_factor", 0.999);
+  const bool select_gear_ratio_estimator =
+    node->declare_parameter<bool>("select_gear_ratio_estimator", true);
+  const bool select_steer_offset_estimator =
+    node->declare_parameter<bool>("select_steer_offset_estimator", true);
+  const bool select_wheel_base_estimator =
+    node->declare_parameter<bool>("select_wheel_base_estimator", true);
+  const bool invert_imu_z = node->declare_parameter<bool>("invert_imu_z", true);
+  Params params;
+  params.valid_max_steer_rad = node->declare_parameter<double>("valid_max_steer_rad", 0.05);
+  params.valid_min_velocity = node->declare_parameter<double>("valid_min_velocity", 0.5);
+  params.valid_min_angular_velocity =
+    node->declare_parameter<double>("valid_min_angular_velocity", 0.1);
+  params.is_showing_debug_info = false;
+  if (node->declare_parameter<bool>("use_rls_hypotheses", false)) {
+    params.hypothesis_forgetting_factors = node->declare_parameter<std::vector<double>>(
+      "hypothesis_forgetting_factors", {0.99, 0.995, 0.999, 0.9995});
+    params.hypothesis_initial_covariances = node->declare_parameter<std::vector<double>>(
+      "hypothesis_initial_covariances", {0.1, 1.0, 10.0});
+  }
+  const auto estimated_gear_ratio =
+    node->declare_parameter<std::vector<double>>("gear_ratio", {15.7, 0.053, 0.047});
+  const auto imu_topic = node->declare_parameter<std::string>("imu_topic", "/sensing/imu/imu_data");
+  const auto vehicle_twist_topic = node->declare_parameter<std::string>(
+    "vehicle_twist_topic", "/calibration/vehicle/twist_status");
+  const auto steer_topic = node->declare_parameter<std::string>(
+    "steer_topic", "/calibration/vehicle/steering_angle_status");
+  const auto handle_topic =
+    node->declare_parameter<std::string>("handle_topic", "/calibration/vehicle/handle_status");
+  const auto control_mode_topic =
+    node->declare_parameter<std::string>("control_mode_topic", "/vehicle/status/control_mode");
+
+  SteerOffsetEstimator steer_offset_estimator(
+    node.get(), params, covariance, forgetting_factor, 0);
+  WheelBaseEstimator wheel_base_estimator(
+    node.get(), params, covariance, forgetting_factor, wheel_base);
+  GearRatioEstimator gear_ratio_estimator(
+    node.get(), params, covariance, forgetting_factor, estimated_gear_ratio);
+  const bool use_steer = select_steer_offset_estimator || select_wheel_base_estimator;
+
+  // Prepare rosbag reader
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = bag_path;
+  rosbag2_storage::MetadataIo metadata_io;
+  storage_options.storage_id = metadata_io.metadata_file_exists(bag_path)
+                                 ? metadata_io.read_metadata(bag_path).storage_identifier
+                                 : "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  // Read only the topics used for the estimation
+  rosbag2_storage::StorageFilter storage_filter;
+  storage_filter.topics = {imu_topic, vehicle_twist_topic};
+  if (use_steer) {
+    storage_filter.topics.push_back(steer_topic);
+  }
+  if (select_gear_ratio_estimator) {
+    storage_filter.topics.push_back(handle_topic);
+  }
+  if (use_auto_mode) {
+    storage_filter.topics.push_back(control_mode_topic);
+  }
+  reader.set_filter(storage_filter);
+
+  // The timer of the live node is replaced by the ticks of the bag time
+  const double update_dt = 1.0 / update_hz;
+  double next_update_time = -1.0;
+  double last_manual_time = -1.0;
+  double auto_mode_duration = 0.0;
+  bool has_imu = false;
+  bool has_vehicle_twist = false;
+  bool has_steer = false;
+  bool has_handle = false;
+  VehicleData v = {};
+  v.wheel_base = wheel_base;
+  const auto process_until = [&](const double t) {
+    for (; next_update_time <= t; next_update_time += update_dt) {
+      if (
+        !has_imu || !has_vehicle_twist || (use_steer && !has_steer) ||
+        (select_gear_ratio_estimator && !has_handle) ||
+        (auto_mode_duration < 0.5 && use_auto_mode)) {
+        continue;
+      }
+      if (select_steer_offset_estimator) {
+        steer_offset_estimator.setData(v);
+        steer_offset_estimator.processData();
+        steer_offset_estimator.Run(false);
+      }
+      if (select_wheel_base_estimator) {
+        wheel_base_estimator.setData(v);
+        wheel_base_estimator.processData();
+        wheel_base_estimator.Run(false);
+      }
+      if (select_gear_ratio_estimator) {
+        gear_ratio_estimator.setData(v);
+        gear_ratio_estimator.processData();
+        gear_ratio_estimator.Run(false);
+      }
+    }
+  };
+
+  rclcpp::Serialization<ControlModeReport> serialization_control_mode;
+  rclcpp::Serialization<Float32Stamped> serialization_float32;
+  rclcpp::Serialization<Imu> serialization_imu;
+  rclcpp::Serialization<TwistStamped> serialization_twist;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const double t = static_cast<double>(serialized_message->time_stamp) * 1e-9;
+    if (next_update_time < 0.0) {
+      next_update_time = t;
+      last_manual_time = t;
+    }
+    process_until(t);
+
+    rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    const auto & topic = serialized_message->topic_name;
+    if (topic == control_mode_topic) {
+      ControlModeReport control_mode_msg;
+      serialization_control_mode.deserialize_message(&msg, &control_mode_msg);
+      if (control_mode_msg.mode == ControlModeReport::AUTONOMOUS) {
+        auto_mode_duration = t - last_manual_time;
+      } else {
+        auto_mode_duration = 0.0;
+        last_manual_time = t;
+      }
+    } else if (topic == imu_topic) {
+      Imu imu_msg;
+      serialization_imu.deserialize_message(&msg, &imu_msg);
+      v.angular_velocity = imu_msg.angular_velocity.z * (invert_imu_z ? -1 : 1);
+      has_imu = true;
+    } else if (topic == vehicle_twist_topic) {
+      TwistStamped twist_msg;
+      serialization_twist.deserialize_message(&msg, &twist_msg);
+      v.velocity = twist_msg.twist.linear.x;
+      has_vehicle_twist = true;
+    } else {
+      Float32Stamped float32_msg;
+      serialization_float32.deserialize_message(&msg, &float32_msg);
+      if (topic == steer_topic) {
+        v.steer = float32_msg.data;
+        has_steer = true;
+      } else {
+        v.handle = float32_msg.data;
+        has_handle = true;
+      }
+    }
+  }
+
+  std::ofstream output_file(output_path);
+  output_file << std::fixed;
+  if (select_steer_offset_estimator) {
+    writeResult(output_file, bag_path, "steer_offset", steer_offset_estimator);
+  }
+  if (select_wheel_base_estimator) {
+    writeResult(output_file, bag_path, "wheel_base", wheel_base_estimator);
+  }
+  if (select_gear_ratio_estimator) {
+    writeResult(output_file, bag_path, "gear_ratio", gear_ratio_estimator);
+  }
+  rclcpp::shutdown();
+  return output_file.good() ? 0 : 1;
+}
+
+// the results of the bags of a vehicle, weighted by the number of the estimations
+struct VehicleResult
+{
+  size_t num_bags = 0;
+  double sum_weight = 0.0;
+  double sum_value = 0.0;
+  double sum_squared_value = 0.0;
+};
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t num_workers = 1;
+  std::vector<std::string> param_paths = {
+    ament_index_cpp::get_package_share_directory("parameter_estimator") +
+    "/config/parameter_estimator_batch_param.yaml"};
+  std::vector<std::string> positional_args;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-j" && i + 1 < argc) {
+      num_workers = std::max(std::stoul(argv[++i]), 1ul);
+    } else if (arg == "-p" && i + 1 < argc) {
+      param_paths.push_back(argv[++i]);
+    } else {
+      positional_args.push_back(arg);
+    }
+  }
+  if (positional_args.size() < 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [-j num_workers] [-p param_yaml]... <output_prefix> <rosbag_path>..."
+              << std::endl;
+    return 1;
+  }
+  const std::string output_prefix = positional_args.front();
+  const std::vector<std::string> bag_paths(positional_args.begin() + 1, positional_args.end());
+  const auto getPartPath = [&](const size_t i) {
+    return output_prefix + ".part" + std::to_string(i);
+  };
+
+  // Each bag is processed in a worker process, so that the estimators and rclcpp are not shared
+  std::map<pid_t, size_t> workers;
+  std::vector<bool> is_succeeded(bag_paths.size(), false);
+  const auto waitWorker = [&]() {
+    int status = 0;
+    const pid_t pid = wait(&status);
+    const auto iter = workers.find(pid);
+    if (iter == workers.end()) {
+      return;
+    }
+    is_succeeded[iter->second] = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if (!is_succeeded[iter->second]) {
+      std::cerr << "Failed to process " << bag_paths[iter->second] << std::endl;
+    }
+    workers.erase(iter);
+  };
+  for (size_t i = 0; i < bag_paths.size(); ++i) {
+    while (workers.size() >= num_workers) {
+      waitWorker();
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+      std::cerr << "Failed to fork a worker for " << bag_paths[i] << std::endl;
+      continue;
+    }
+    if (pid == 0) {
+      int ret = 1;
+      try {
+        ret = processBag(bag_paths[i], param_paths, getPartPath(i));
+      } catch (const std::exception & e) {
+        std::cerr << bag_paths[i] << ": " << e.what() << std::endl;
+      }
+      _exit(ret);
+    }
+    workers[pid] = i;
+  }
+  while (!workers.empty()) {
+    waitWorker();
+  }
+
+  // Merge the results of the workers in the order of the bags
+  const std::string bag_output_path = output_prefix + "_bags.csv";
+  std::ofstream bag_output(bag_output_path);
+  if (!bag_output) {
+    std::cerr << "Failed to open " << bag_output_path << std::endl;
+    return 1;
+  }
+  bag_output << "bag,vehicle,estimator,index,num_estimations,result,mean,stddev" << std::endl;
+  std::map<std::string, VehicleResult> vehicle_results;  // key: vehicle,estimator,index
+  size_t num_succeeded = 0;
+  for (size_t i = 0; i < bag_paths.size(); ++i) {
+    if (is_succeeded[i]) {
+      std::ifstream part(getPartPath(i));
+      std::string line;
+      while (std::getline(part, line)) {
+        bag_output << line << "\n";
+        std::vector<std::string> cols;
+        std::stringstream ss(line);
+        for (std::string col; std::getline(ss, col, ',');) {
+          cols.push_back(col);
+        }
+        const double weight = std::stod(cols.at(4));
+        if (weight <= 0.0) {
+          continue;
+        }
+        const double value = std::stod(cols.at(5));
+        auto & result = vehicle_results[cols.at(1) + "," + cols.at(2) + "," + cols.at(3)];
+        ++result.num_bags;
+        result.sum_weight += weight;
+        result.sum_value += weight * value;
+        result.sum_squared_value += weight * value * value;
+      }
+      ++num_succeeded;
+    }
+    std::remove(getPartPath(i).c_str());
+  }
+
+  const std::string vehicle_output_path = output_prefix + "_vehicles.csv";
+  std::ofstream vehicle_output(vehicle_output_path);
+  if (!vehicle_output) {
+    std::cerr << "Failed to open " << vehicle_output_path << std::endl;
+    return 1;
+  }
+  vehicle_output << "vehicle,estimator,index,num_bags,num_estimations,result,stddev" << std::endl;
+  vehicle_output << std::fixed;
+  for (const auto & vehicle_result : vehicle_results) {
+    const auto & r = vehicle_result.second;
+    const double mean = r.sum_value / r.sum_weight;
+    const double variance = std::max(r.sum_squared_value / r.sum_weight - mean * mean, 0.0);
+    vehicle_output << vehicle_result.first << "," << r.num_bags << ","
+                   << static_cast<size_t>(r.sum_weight) << "," << mean << ","
+                   << std::sqrt(variance) << "\n";
+  }
+
+  std::cout << "Processed " << num_succeeded << "/" << bag_paths.size() << " bags, wrote "
+            << bag_output_path << " and " << vehicle_output_path << std::endl;
+  return num_succeeded == bag_paths.size() ? 0 : 1;
+}
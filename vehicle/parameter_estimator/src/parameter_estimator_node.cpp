@@ -16,6 +16,7 @@
 
 #include "parameter_estimator/parameter_estimator_node.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -42,11 +43,20 @@ ParameterEstimatorNode::ParameterEstimatorNode(const rclcpp::NodeOptions & node_
     this->declare_parameter<bool>("select_steer_offset_estimator", true);
   select_wheel_base_estimator = this->declare_parameter<bool>("select_wheel_base_estimator", true);
   invert_imu_z = this->declare_parameter<bool>("invert_imu_z", true);
+  use_synchronized_sampling_ = this->declare_parameter<bool>("use_synchronized_sampling", false);
+  const auto sync_buffer_size =
+    static_cast<size_t>(this->declare_parameter<int>("synchronized_sampling_buffer_size", 100));
   params_.valid_max_steer_rad = this->declare_parameter<double>("valid_max_steer_rad", 0.05);
   params_.valid_min_velocity = this->declare_parameter<double>("valid_min_velocity", 0.5);
   params_.valid_min_angular_velocity =
     this->declare_parameter<double>("valid_min_angular_velocity", 0.1);
   params_.is_showing_debug_info = this->declare_parameter<bool>("is_showing_debug_info", true);
+  if (this->declare_parameter<bool>("use_rls_hypotheses", false)) {
+    params_.hypothesis_forgetting_factors = this->declare_parameter<std::vector<double>>(
+      "hypothesis_forgetting_factors", {0.99, 0.995, 0.999, 0.9995});
+    params_.hypothesis_initial_covariances = this->declare_parameter<std::vector<double>>(
+      "hypothesis_initial_covariances", {0.1, 1.0, 10.0});
+  }
 
   const auto estimated_gear_ratio =
     this->declare_parameter<std::vector<double>>("gear_ratio", {15.7, 0.053, 0.047});
@@ -57,22 +67,36 @@ ParameterEstimatorNode::ParameterEstimatorNode(const rclcpp::NodeOptions & node_
   gear_ratio_estimator_ = std::make_unique<GearRatioEstimator>(
     this, params_, covariance_, forgetting_factor_, estimated_gear_ratio);
 
+  // Every message is used in the synchronized sampling, so they are queued instead of replaced
+  const std::size_t input_queue_size = use_synchronized_sampling_ ? 10 : queue_size;
+  if (use_synchronized_sampling_) {
+    imu_buffer_ = std::make_unique<TimedSignalBuffer>(sync_buffer_size);
+    velocity_buffer_ = std::make_unique<TimedSignalBuffer>(sync_buffer_size);
+    steer_buffer_ = std::make_unique<TimedSignalBuffer>(sync_buffer_size);
+    steer_wheel_buffer_ = std::make_unique<TimedSignalBuffer>(sync_buffer_size);
+  }
+
   // subscriber
+  // The outputs of the calibration adapter in the same container are received without a copy,
+  // while the latched outputs of this node keep the inter-process communication.
+  rclcpp::SubscriptionOptions adapter_options;
+  adapter_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   sub_imu_ = create_subscription<sensor_msgs::msg::Imu>(
-    "input/imu_twist", queue_size, std::bind(&ParameterEstimatorNode::callbackImu, this, _1));
+    "input/imu_twist", input_queue_size, std::bind(&ParameterEstimatorNode::callbackImu, this, _1));
   sub_vehicle_twist_ = create_subscription<geometry_msgs::msg::TwistStamped>(
-    "input/vehicle_twist", queue_size,
-    std::bind(&ParameterEstimatorNode::callbackVehicleTwist, this, _1));
+    "input/vehicle_twist", input_queue_size,
+    std::bind(&ParameterEstimatorNode::callbackVehicleTwist, this, _1), adapter_options);
 
   if (select_gear_ratio_estimator) {
     sub_steer_wheel_ = create_subscription<tier4_calibration_msgs::msg::Float32Stamped>(
-      "input/handle_status", queue_size,
-      std::bind(&ParameterEstimatorNode::callbackSteerWheel, this, _1));
+      "input/handle_status", input_queue_size,
+      std::bind(&ParameterEstimatorNode::callbackSteerWheel, this, _1), adapter_options);
   }
 
   if (select_steer_offset_estimator || select_wheel_base_estimator) {
     sub_steer_ = create_subscription<tier4_calibration_msgs::msg::Float32Stamped>(
-      "input/steer", queue_size, std::bind(&ParameterEstimatorNode::callbackSteer, this, _1));
+      "input/steer", input_queue_size,
+      std::bind(&ParameterEstimatorNode::callbackSteer, this, _1), adapter_options);
   }
   sub_control_mode_report_ = create_subscription<autoware_vehicle_msgs::msg::ControlModeReport>(
     "input/control_mode", queue_size,
@@ -120,32 +144,99 @@ void ParameterEstimatorNode::timerCallback()
       rclcpp::get_logger("parameter_estimator"), clk, 5000, "running parameter estimator");
   }
 
-  {
-    VehicleData v = {};
-    v.velocity = vehicle_twist_ptr_->twist.linear.x;
-    v.angular_velocity = imu_ptr_->angular_velocity.z * (invert_imu_z ? -1 : 1);
-    if (select_steer_offset_estimator || select_wheel_base_estimator) {
-      v.steer = steer_ptr_->data;
-    }
-    if (select_gear_ratio_estimator) {
-      v.handle = steer_wheel_ptr_->data;
+  // The synchronized samples are estimated in the callbacks, and only published here
+  if (use_synchronized_sampling_) {
+    if (num_synchronized_samples_ > 0) {
+      publishEstimators();
     }
+    return;
+  }
+
+  VehicleData v = {};
+  v.velocity = vehicle_twist_ptr_->twist.linear.x;
+  v.angular_velocity = imu_ptr_->angular_velocity.z * (invert_imu_z ? -1 : 1);
+  if (select_steer_offset_estimator || select_wheel_base_estimator) {
+    v.steer = steer_ptr_->data;
+  }
+  if (select_gear_ratio_estimator) {
+    v.handle = steer_wheel_ptr_->data;
+  }
+  v.wheel_base = wheel_base_;
+  runEstimators(v, true);
+}
+
+void ParameterEstimatorNode::runEstimators(const VehicleData & v, const bool publish)
+{
+  if (select_steer_offset_estimator) {
+    steer_offset_estimator_->setData(v);
+    steer_offset_estimator_->processData();
+    steer_offset_estimator_->Run(publish);
+  }
+  if (select_wheel_base_estimator) {
+    wheel_base_estimator_->setData(v);
+    wheel_base_estimator_->processData();
+    wheel_base_estimator_->Run(publish);
+  }
+  if (select_gear_ratio_estimator) {
+    gear_ratio_estimator_->setData(v);
+    gear_ratio_estimator_->processData();
+    gear_ratio_estimator_->Run(publish);
+  }
+}
+
+void ParameterEstimatorNode::publishEstimators()
+{
+  if (select_steer_offset_estimator) {
+    steer_offset_estimator_->publishData();
+    steer_offset_estimator_->publishResult();
+  }
+  if (select_wheel_base_estimator) {
+    wheel_base_estimator_->publishData();
+    wheel_base_estimator_->publishResult();
+  }
+  if (select_gear_ratio_estimator) {
+    gear_ratio_estimator_->publishData();
+    gear_ratio_estimator_->publishResult();
+  }
+}
+
+void ParameterEstimatorNode::processSynchronizedSamples()
+{
+  const bool use_steer = select_steer_offset_estimator || select_wheel_base_estimator;
+  const bool use_steer_wheel = select_gear_ratio_estimator;
+  if (
+    imu_buffer_->empty() || velocity_buffer_->empty() || (use_steer && steer_buffer_->empty()) ||
+    (use_steer_wheel && steer_wheel_buffer_->empty())) {
+    return;
+  }
+  if (auto_mode_duration_ < 0.5 && use_auto_mode_) {
+    imu_buffer_->clear();
+    return;
+  }
+
+  // An IMU sample is used once all the other signals have samples after it
+  double ready_stamp = velocity_buffer_->latestStamp();
+  if (use_steer) {
+    ready_stamp = std::min(ready_stamp, steer_buffer_->latestStamp());
+  }
+  if (use_steer_wheel) {
+    ready_stamp = std::min(ready_stamp, steer_wheel_buffer_->latestStamp());
+  }
+  while (!imu_buffer_->empty() && imu_buffer_->oldestStamp() <= ready_stamp) {
+    const double stamp = imu_buffer_->oldestStamp();
+    VehicleData v = {};
+    v.angular_velocity = imu_buffer_->oldestValue() * (invert_imu_z ? -1 : 1);
     v.wheel_base = wheel_base_;
-    if (select_steer_offset_estimator) {
-      steer_offset_estimator_->setData(v);
-      steer_offset_estimator_->processData();
-      steer_offset_estimator_->Run();
-    }
-    if (select_wheel_base_estimator) {
-      wheel_base_estimator_->setData(v);
-      wheel_base_estimator_->processData();
-      wheel_base_estimator_->Run();
-    }
-    if (select_gear_ratio_estimator) {
-      gear_ratio_estimator_->setData(v);
-      gear_ratio_estimator_->processData();
-      gear_ratio_estimator_->Run();
+    imu_buffer_->pop_front();
+    // The IMU samples older than the buffered samples cannot be interpolated
+    if (
+      !velocity_buffer_->interpolate(stamp, v.velocity) ||
+      (use_steer && !steer_buffer_->interpolate(stamp, v.steer)) ||
+      (use_steer_wheel && !steer_wheel_buffer_->interpolate(stamp, v.handle))) {
+      continue;
     }
+    runEstimators(v, false);
+    ++num_synchronized_samples_;
   }
 }
 
@@ -153,23 +244,39 @@ void ParameterEstimatorNode::callbackVehicleTwist(
   const geometry_msgs::msg::TwistStamped::ConstSharedPtr msg)
 {
   vehicle_twist_ptr_ = msg;
+  if (use_synchronized_sampling_) {
+    velocity_buffer_->push(rclcpp::Time(msg->header.stamp).seconds(), msg->twist.linear.x);
+    processSynchronizedSamples();
+  }
 }
 
 void ParameterEstimatorNode::callbackImu(const sensor_msgs::msg::Imu::ConstSharedPtr msg)
 {
   imu_ptr_ = msg;
+  if (use_synchronized_sampling_) {
+    imu_buffer_->push(rclcpp::Time(msg->header.stamp).seconds(), msg->angular_velocity.z);
+    processSynchronizedSamples();
+  }
 }
 
 void ParameterEstimatorNode::callbackSteer(
   const tier4_calibration_msgs::msg::Float32Stamped::ConstSharedPtr msg)
 {
   steer_ptr_ = msg;
+  if (use_synchronized_sampling_) {
+    steer_buffer_->push(rclcpp::Time(msg->header.stamp).seconds(), msg->data);
+    processSynchronizedSamples();
+  }
 }
 
 void ParameterEstimatorNode::callbackSteerWheel(
   const tier4_calibration_msgs::msg::Float32Stamped::ConstSharedPtr msg)
 {
   steer_wheel_ptr_ = msg;
+  if (use_synchronized_sampling_) {
+    steer_wheel_buffer_->push(rclcpp::Time(msg->header.stamp).seconds(), msg->data);
+    processSynchronizedSamples();
+  }
 }
 
 void ParameterEstimatorNode::callbackControlModeReport(
@@ -190,3 +297,6 @@ void ParameterEstimatorNode::callbackControlModeReport(
       "[parameter_estimator] control mode : manual");
   }
 }
+
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(ParameterEstimatorNode)
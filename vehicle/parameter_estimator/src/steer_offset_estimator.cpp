@@ -27,6 +27,12 @@ SteerOffsetEstimator::SteerOffsetEstimator(
   estimated_ = est;
   params_ = p;
   debugger_ = std::make_unique<Debugger>("steer_offset", node);
+  const auto [forgetting_factors, covariances] = getHypotheses(p);
+  if (!forgetting_factors.empty()) {
+    hypotheses_ = std::make_unique<optimization_utils::RLSBank<1>>(
+      Eigen::Matrix<double, 1, 1>(est), Eigen::Matrix<double, 1, 1>::Identity(),
+      forgetting_factors, covariances);
+  }
   createPublisher("steer_offset", node);
   result_statistics_ = math_utils::Statistics(1);
   error_statistics_ = math_utils::Statistics(1);
@@ -44,7 +50,15 @@ bool SteerOffsetEstimator::estimate()
   auto & cov = covariance_;
   const auto & ff = forgetting_factor_;
   auto & est = estimated_;
-  optimization_utils::estimateByRLS(est, cov, phi, ff, yn);
+  if (hypotheses_) {
+    hypotheses_->update(Eigen::Matrix<double, 1, 1>(phi), yn);
+    const size_t best = hypotheses_->best();
+    est = hypotheses_->estimate(best)(0);
+    cov = hypotheses_->covariance(best)(0, 0);
+    debugger_->setBestHypothesis(*hypotheses_);
+  } else {
+    optimization_utils::estimateByRLS(est, cov, phi, ff, yn);
+  }
   error_ = yn - phi * est;
   // if (error > 1.0) return false;
   return true;
@@ -28,6 +28,12 @@ WheelBaseEstimator::WheelBaseEstimator(
   estimated_ = est;
   params_ = p;
   debugger_ = std::make_unique<Debugger>("wheel_base", node);
+  const auto [forgetting_factors, covariances] = getHypotheses(p);
+  if (!forgetting_factors.empty()) {
+    hypotheses_ = std::make_unique<optimization_utils::RLSBank<1>>(
+      Eigen::Matrix<double, 1, 1>(est), Eigen::Matrix<double, 1, 1>::Identity(),
+      forgetting_factors, covariances);
+  }
   createPublisher("wheel_base", node);
   result_statistics_ = math_utils::Statistics(1);
   error_statistics_ = math_utils::Statistics(1);
@@ -45,7 +51,15 @@ bool WheelBaseEstimator::estimate()
   const auto & ff = forgetting_factor_;
   auto & est = estimated_;
   // wz * wheel_base = vel * tan(steer)
-  optimization_utils::estimateByRLS(est, cov, zn, ff, yn);
+  if (hypotheses_) {
+    hypotheses_->update(Eigen::Matrix<double, 1, 1>(zn), yn);
+    const size_t best = hypotheses_->best();
+    est = hypotheses_->estimate(best)(0);
+    cov = hypotheses_->covariance(best)(0, 0);
+    debugger_->setBestHypothesis(*hypotheses_);
+  } else {
+    optimization_utils::estimateByRLS(est, cov, zn, ff, yn);
+  }
   error_ = yn - zn * est;
   auto & de = debugger_->debug_values_;
   de.data[0] = zn * wheel_base;
@@ -17,19 +17,20 @@
 #ifndef PITCH_CHECKER__PITCH_CHECKER_HPP_
 #define PITCH_CHECKER__PITCH_CHECKER_HPP_
 
+#include "pitch_checker/pitch_grid.hpp"
+#include "pitch_checker/pitch_map.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "tf2/utils.h"
 
 #include "geometry_msgs/msg/transform_stamped.hpp"
 #include "std_msgs/msg/bool.hpp"
 #include "std_srvs/srv/trigger.hpp"
+#include "tier4_calibration_msgs/srv/get_pitch.hpp"
 
 #include <fstream>
-#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
-#include <utility>
-#include <vector>
 #ifdef ROS_DISTRO_GALACTIC
 #include "tf2_geometry_msgs/tf2_geometry_msgs.h"
 #else
@@ -37,15 +38,6 @@
 #endif
 #include "autoware/universe_utils/ros/transform_listener.hpp"
 
-struct TfInfo
-{
-  double x;
-  double y;
-  double z;
-  double yaw;
-  double pitch;
-};
-
 class PitchChecker : public rclcpp::Node
 {
 public:
@@ -60,24 +52,26 @@ private:
 
   // Service
   rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr save_flag_server_;
+  rclcpp::Service<tier4_calibration_msgs::srv::GetPitch>::SharedPtr get_pitch_server_;
 
-  std::vector<TfInfo> tf_info_vec_;
-  std::map<std::pair<int, int>, std::vector<TfInfo>> tf_map_;
-  std::map<std::pair<int, int>, std::vector<TfInfo>> tf_map_unified_;
+  // the medians are updated with each tf, so the map can be saved or queried at any time
+  PitchMap pitch_map_;
+  std::mutex pitch_map_mutex_;
+  double query_yaw_threshold_;
   std::string output_file_;
+  std::string output_grid_file_;
   double update_hz_;
-  int get_tf_count_ = 0;
-  static constexpr int MAX_TF_COUNT_ = 1e08;
 
   void timerCallback();
   bool onSaveService(
     const std::shared_ptr<rmw_request_id_t> req_header,
     const std::shared_ptr<std_srvs::srv::Trigger::Request> req,
     const std::shared_ptr<std_srvs::srv::Trigger::Response> res);
+  void onGetPitchService(
+    const std::shared_ptr<tier4_calibration_msgs::srv::GetPitch::Request> req,
+    const std::shared_ptr<tier4_calibration_msgs::srv::GetPitch::Response> res);
   bool getTf();
-  void pitchInfoToMap();
   bool writeMap();
-  TfInfo getMedianPitchTfInfo(const std::vector<TfInfo> & tf_info_vec);
 };
 
 #endif  // PITCH_CHECKER__PITCH_CHECKER_HPP_
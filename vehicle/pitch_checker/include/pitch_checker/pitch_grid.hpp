@@ -0,0 +1,289 @@
+//
+// Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PITCH_CHECKER__PITCH_GRID_HPP_
+#define PITCH_CHECKER__PITCH_GRID_HPP_
+
+#include "pitch_checker/pitch_map.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * Binary pitch map, which is memory-mapped and looked up in O(1) without parsing. The 1m cells
+ * are stored in blocks of block_size x block_size cells, and only the blocks with samples are
+ * written. The file is a PitchGridHeader, followed by the block index of
+ * num_blocks_x * num_blocks_y uint32 (pitch_grid_empty_block if no block), followed by the
+ * blocks. Each cell of a block has two PitchGridRecords, one for each direction, whose pitch is
+ * NaN if the direction has no sample. All values are little endian.
+ **/
+struct PitchGridHeader
+{
+  char magic[8];  // "PITCHGD" and a null character
+  uint32_t version;
+  uint32_t block_size;
+  int32_t min_block_x;
+  int32_t min_block_y;
+  uint32_t num_blocks_x;
+  uint32_t num_blocks_y;
+  uint32_t num_blocks;
+  uint32_t reserved;
+};
+
+struct PitchGridRecord
+{
+  float z;
+  float yaw;
+  float pitch;
+};
+
+static_assert(sizeof(PitchGridHeader) == 40, "Unexpected size of PitchGridHeader");
+static_assert(sizeof(PitchGridRecord) == 12, "Unexpected size of PitchGridRecord");
+
+constexpr char pitch_grid_magic[8] = "PITCHGD";
+constexpr uint32_t pitch_grid_version = 1;
+constexpr uint32_t pitch_grid_block_size = 8;
+constexpr uint32_t pitch_grid_empty_block = std::numeric_limits<uint32_t>::max();
+
+inline int32_t floorDiv(const int32_t a, const int32_t b)
+{
+  return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// write the medians of a pitch map. Return false if the file cannot be written
+inline bool writePitchGrid(const std::string & path, const std::vector<PitchMapEntry> & entries)
+{
+  const int32_t bs = static_cast<int32_t>(pitch_grid_block_size);
+  PitchGridHeader header;
+  std::memcpy(header.magic, pitch_grid_magic, sizeof(header.magic));
+  header.version = pitch_grid_version;
+  header.block_size = pitch_grid_block_size;
+  header.reserved = 0;
+  int32_t max_block_x = 0;
+  int32_t max_block_y = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const int32_t bx = floorDiv(entries[i].x, bs);
+    const int32_t by = floorDiv(entries[i].y, bs);
+    if (i == 0 || bx < header.min_block_x) {
+      header.min_block_x = bx;
+    }
+    if (i == 0 || by < header.min_block_y) {
+      header.min_block_y = by;
+    }
+    max_block_x = (i == 0 || bx > max_block_x) ? bx : max_block_x;
+    max_block_y = (i == 0 || by > max_block_y) ? by : max_block_y;
+  }
+  if (entries.empty()) {
+    header.min_block_x = header.min_block_y = 0;
+    header.num_blocks_x = header.num_blocks_y = 0;
+  } else {
+    header.num_blocks_x = static_cast<uint32_t>(max_block_x - header.min_block_x + 1);
+    header.num_blocks_y = static_cast<uint32_t>(max_block_y - header.min_block_y + 1);
+  }
+
+  const size_t records_per_block = 2 * pitch_grid_block_size * pitch_grid_block_size;
+  const PitchGridRecord empty_record{0.0f, 0.0f, std::numeric_limits<float>::quiet_NaN()};
+  std::vector<uint32_t> block_index(
+    static_cast<size_t>(header.num_blocks_x) * header.num_blocks_y, pitch_grid_empty_block);
+  std::vector<PitchGridRecord> records;
+  for (const auto & entry : entries) {
+    const int32_t bx = floorDiv(entry.x, bs);
+    const int32_t by = floorDiv(entry.y, bs);
+    auto & block = block_index
+      [static_cast<size_t>(by - header.min_block_y) * header.num_blocks_x +
+       (bx - header.min_block_x)];
+    if (block == pitch_grid_empty_block) {
+      block = static_cast<uint32_t>(records.size() / records_per_block);
+      records.resize(records.size() + records_per_block, empty_record);
+    }
+    // the first entry of a cell is the direction of its first sample
+    const size_t cell = static_cast<size_t>(entry.y - by * bs) * pitch_grid_block_size +
+                        static_cast<size_t>(entry.x - bx * bs);
+    auto * record = &records[block * records_per_block + 2 * cell];
+    if (!std::isnan(record->pitch)) {
+      ++record;
+    }
+    *record = {
+      static_cast<float>(entry.z), static_cast<float>(entry.yaw), static_cast<float>(entry.pitch)};
+  }
+  header.num_blocks = static_cast<uint32_t>(records.size() / records_per_block);
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(
+    reinterpret_cast<const char *>(block_index.data()), block_index.size() * sizeof(uint32_t));
+  file.write(
+    reinterpret_cast<const char *>(records.data()), records.size() * sizeof(PitchGridRecord));
+  return file.good();
+}
+
+/**
+ * @brief : read-only memory-mapped pitch grid
+ **/
+class PitchGrid
+{
+public:
+  PitchGrid() = default;
+  PitchGrid(const PitchGrid &) = delete;
+  PitchGrid & operator=(const PitchGrid &) = delete;
+  ~PitchGrid() { close(); }
+
+  // true if the file starts with the magic of the pitch grid
+  static bool isPitchGridFile(const std::string & path)
+  {
+    char magic[sizeof(pitch_grid_magic)] = {};
+    std::ifstream file(path, std::ios::binary);
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, pitch_grid_magic, sizeof(magic)) == 0;
+  }
+
+  // Map a file. Return false if the file does not exist or is not a valid pitch grid
+  bool open(const std::string & path)
+  {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(PitchGridHeader)) {
+      ::close(fd);
+      return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void * data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      size_ = 0;
+      return false;
+    }
+    data_ = static_cast<const char *>(data);
+
+    header_ = reinterpret_cast<const PitchGridHeader *>(data_);
+    const size_t num_index = static_cast<size_t>(header_->num_blocks_x) * header_->num_blocks_y;
+    const size_t records_per_block = 2 * static_cast<size_t>(header_->block_size) *
+                                     header_->block_size;
+    const size_t expected_size = sizeof(PitchGridHeader) + num_index * sizeof(uint32_t) +
+                                 header_->num_blocks * records_per_block * sizeof(PitchGridRecord);
+    if (
+      std::memcmp(header_->magic, pitch_grid_magic, sizeof(header_->magic)) != 0 ||
+      header_->version != pitch_grid_version || header_->block_size == 0 ||
+      size_ != expected_size) {
+      close();
+      return false;
+    }
+    block_index_ = reinterpret_cast<const uint32_t *>(data_ + sizeof(PitchGridHeader));
+    records_ = reinterpret_cast<const PitchGridRecord *>(block_index_ + num_index);
+    return true;
+  }
+
+  void close()
+  {
+    if (data_) {
+      munmap(const_cast<char *>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    header_ = nullptr;
+  }
+
+  bool isOpen() const { return data_ != nullptr; }
+
+  // the two records of a cell, or nullptr if the cell is out of the stored blocks
+  const PitchGridRecord * findCell(const int32_t x, const int32_t y) const
+  {
+    if (!header_) {
+      return nullptr;
+    }
+    const int32_t bs = static_cast<int32_t>(header_->block_size);
+    const int64_t bx = static_cast<int64_t>(floorDiv(x, bs)) - header_->min_block_x;
+    const int64_t by = static_cast<int64_t>(floorDiv(y, bs)) - header_->min_block_y;
+    if (bx < 0 || by < 0 || bx >= header_->num_blocks_x || by >= header_->num_blocks_y) {
+      return nullptr;
+    }
+    const uint32_t block = block_index_[by * header_->num_blocks_x + bx];
+    if (block == pitch_grid_empty_block || block >= header_->num_blocks) {
+      return nullptr;
+    }
+    const size_t cell = static_cast<size_t>(y - floorDiv(y, bs) * bs) * header_->block_size +
+                        static_cast<size_t>(x - floorDiv(x, bs) * bs);
+    return records_ + (static_cast<size_t>(block) * header_->block_size * header_->block_size +
+                       cell) * 2;
+  }
+
+  /**
+   * @brief : bilinear interpolation of the pitch among the four cells around (x, y). Only the
+   * directions within yaw_thresh of yaw are used, and the weights are normalized over them.
+   * @return : false if none of the four cells has such a direction
+   **/
+  bool getPitch(
+    double * pitch, const double x, const double y, const double yaw,
+    const double yaw_thresh) const
+  {
+    const double x0 = std::floor(x);
+    const double y0 = std::floor(y);
+    const double fx = x - x0;
+    const double fy = y - y0;
+    double sum_weight = 0.0;
+    double sum_pitch = 0.0;
+    for (int dy = 0; dy < 2; ++dy) {
+      for (int dx = 0; dx < 2; ++dx) {
+        const double weight = (dx ? fx : 1.0 - fx) * (dy ? fy : 1.0 - fy);
+        const auto * records =
+          findCell(static_cast<int32_t>(x0) + dx, static_cast<int32_t>(y0) + dy);
+        if (!records || weight <= 0.0) {
+          continue;
+        }
+        for (int i = 0; i < 2; ++i) {
+          const auto & record = records[i];
+          const double dyaw = std::remainder(yaw - record.yaw, 2.0 * M_PI);
+          if (!std::isnan(record.pitch) && std::fabs(dyaw) < yaw_thresh) {
+            sum_weight += weight;
+            sum_pitch += weight * record.pitch;
+            break;
+          }
+        }
+      }
+    }
+    if (sum_weight <= 0.0) {
+      return false;
+    }
+    *pitch = sum_pitch / sum_weight;
+    return true;
+  }
+
+private:
+  const char * data_ = nullptr;
+  size_t size_ = 0;
+  const PitchGridHeader * header_ = nullptr;
+  const uint32_t * block_index_ = nullptr;
+  const PitchGridRecord * records_ = nullptr;
+};
+
+#endif  // PITCH_CHECKER__PITCH_GRID_HPP_
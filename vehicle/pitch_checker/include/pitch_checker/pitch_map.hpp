@@ -0,0 +1,227 @@
+//
+// Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef PITCH_CHECKER__PITCH_MAP_HPP_
+#define PITCH_CHECKER__PITCH_MAP_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief : streaming median by the P-square algorithm (Jain and Chlamtac, 1985), which keeps five
+ * markers instead of the samples. The median is exact while there are up to five samples.
+ **/
+class P2Median
+{
+public:
+  void add(const double x)
+  {
+    if (count_ < 5) {
+      q_[count_++] = x;
+      if (count_ == 5) {
+        std::sort(q_.begin(), q_.end());
+      }
+      return;
+    }
+    ++count_;
+    int k = 0;
+    if (x < q_[0]) {
+      q_[0] = x;
+    } else if (x >= q_[4]) {
+      q_[4] = x;
+      k = 3;
+    } else {
+      while (k < 3 && x >= q_[k + 1]) {
+        ++k;
+      }
+    }
+    for (int i = k + 1; i < 5; ++i) {
+      n_[i] += 1.0;
+    }
+    for (int i = 0; i < 5; ++i) {
+      desired_[i] += increment_[i];
+    }
+    // move the middle markers toward their desired positions
+    for (int i = 1; i < 4; ++i) {
+      const double d = desired_[i] - n_[i];
+      if ((d >= 1.0 && n_[i + 1] - n_[i] > 1.0) || (d <= -1.0 && n_[i - 1] - n_[i] < -1.0)) {
+        const int s = d > 0.0 ? 1 : -1;
+        const double q = parabolic(i, s);
+        q_[i] = (q_[i - 1] < q && q < q_[i + 1]) ? q : linear(i, s);
+        n_[i] += s;
+      }
+    }
+  }
+
+  bool empty() const { return count_ == 0; }
+
+  double get() const
+  {
+    if (count_ >= 5) {
+      return q_[2];
+    }
+    std::array<double, 5> sorted = q_;
+    std::sort(sorted.begin(), sorted.begin() + count_);
+    return count_ % 2 == 1 ? sorted[count_ / 2]
+                           : (sorted[count_ / 2 - 1] + sorted[count_ / 2]) / 2.0;
+  }
+
+private:
+  double parabolic(const int i, const int s) const
+  {
+    return q_[i] + s / (n_[i + 1] - n_[i - 1]) *
+                     ((n_[i] - n_[i - 1] + s) * (q_[i + 1] - q_[i]) / (n_[i + 1] - n_[i]) +
+                      (n_[i + 1] - n_[i] - s) * (q_[i] - q_[i - 1]) / (n_[i] - n_[i - 1]));
+  }
+  double linear(const int i, const int s) const
+  {
+    return q_[i] + s * (q_[i + s] - q_[i]) / (n_[i + s] - n_[i]);
+  }
+
+  std::array<double, 5> q_{};
+  std::array<double, 5> n_{{0.0, 1.0, 2.0, 3.0, 4.0}};
+  std::array<double, 5> desired_{{0.0, 1.0, 2.0, 3.0, 4.0}};
+  const std::array<double, 5> increment_{{0.0, 0.25, 0.5, 0.75, 1.0}};
+  int count_ = 0;
+};
+
+struct PitchMapEntry
+{
+  int x;
+  int y;
+  double z;
+  double yaw;
+  double pitch;
+};
+
+/**
+ * @brief : 1m grid of the medians of the pitch, z and yaw. The samples of a cell are split into
+ * those with the heading of the first sample and the others, so each direction of a road has its
+ * own medians. The memory is proportional to the number of the cells, not of the samples.
+ **/
+class PitchMap
+{
+public:
+  void add(const double x, const double y, const double z, const double yaw, const double pitch)
+  {
+    const int x_i = static_cast<int>(std::nearbyint(x));
+    const int y_i = static_cast<int>(std::nearbyint(y));
+    auto & cell = cells_[toKey(x_i, y_i)];
+    if (cell.directions[0].pitch.empty()) {
+      cell.reference_yaw = yaw;
+    }
+    auto & direction = cell.directions[std::fabs(yaw - cell.reference_yaw) < M_PI_2 ? 0 : 1];
+    direction.z.add(z);
+    direction.yaw.add(yaw);
+    direction.pitch.add(pitch);
+  }
+
+  size_t size() const { return cells_.size(); }
+  void clear() { cells_.clear(); }
+
+  /**
+   * @brief : bilinear interpolation of the pitch among the four cells around (x, y) as
+   * PitchGrid::getPitch, with the current medians
+   * @return : false if none of the four cells has a direction within yaw_thresh of yaw
+   **/
+  bool getPitch(
+    double * pitch, const double x, const double y, const double yaw,
+    const double yaw_thresh) const
+  {
+    const double x0 = std::floor(x);
+    const double y0 = std::floor(y);
+    const double fx = x - x0;
+    const double fy = y - y0;
+    double sum_weight = 0.0;
+    double sum_pitch = 0.0;
+    for (int dy = 0; dy < 2; ++dy) {
+      for (int dx = 0; dx < 2; ++dx) {
+        const double weight = (dx ? fx : 1.0 - fx) * (dy ? fy : 1.0 - fy);
+        if (weight <= 0.0) {
+          continue;
+        }
+        const auto cell = cells_.find(toKey(static_cast<int>(x0) + dx, static_cast<int>(y0) + dy));
+        if (cell == cells_.end()) {
+          continue;
+        }
+        for (const auto & direction : cell->second.directions) {
+          if (direction.pitch.empty()) {
+            continue;
+          }
+          const double dyaw = std::remainder(yaw - direction.yaw.get(), 2.0 * M_PI);
+          if (std::fabs(dyaw) < yaw_thresh) {
+            sum_weight += weight;
+            sum_pitch += weight * direction.pitch.get();
+            break;
+          }
+        }
+      }
+    }
+    if (sum_weight <= 0.0) {
+      return false;
+    }
+    *pitch = sum_pitch / sum_weight;
+    return true;
+  }
+
+  // the medians of the cells, sorted by x and y
+  std::vector<PitchMapEntry> getEntries() const
+  {
+    std::vector<PitchMapEntry> entries;
+    entries.reserve(cells_.size() * 2);
+    for (const auto & cell : cells_) {
+      const int x = static_cast<int32_t>(static_cast<uint32_t>(cell.first >> 32));
+      const int y = static_cast<int32_t>(static_cast<uint32_t>(cell.first));
+      for (const auto & direction : cell.second.directions) {
+        if (!direction.pitch.empty()) {
+          entries.push_back({x, y, direction.z.get(), direction.yaw.get(), direction.pitch.get()});
+        }
+      }
+    }
+    // stable so that the direction of the first sample comes first in a cell
+    std::stable_sort(
+      entries.begin(), entries.end(), [](const PitchMapEntry & a, const PitchMapEntry & b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+      });
+    return entries;
+  }
+
+private:
+  struct Direction
+  {
+    P2Median z;
+    P2Median yaw;
+    P2Median pitch;
+  };
+  struct Cell
+  {
+    double reference_yaw = 0.0;
+    std::array<Direction, 2> directions;
+  };
+
+  static uint64_t toKey(const int x, const int y)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+  }
+
+  std::unordered_map<uint64_t, Cell> cells_;
+};
+
+#endif  // PITCH_CHECKER__PITCH_MAP_HPP_
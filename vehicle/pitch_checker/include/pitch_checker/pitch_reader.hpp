@@ -17,6 +17,8 @@
 #ifndef PITCH_CHECKER__PITCH_READER_HPP_
 #define PITCH_CHECKER__PITCH_READER_HPP_
 
+#include "pitch_checker/pitch_grid.hpp"
+
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -46,6 +48,7 @@ public:
 
 private:
   std::vector<TfInfo> tf_infos_;
+  PitchGrid pitch_grid_;
   bool readCSV(const std::string csv_path, std::vector<TfInfo> * tf_infos);
   std::vector<std::string> split(const std::string & s, char delim);
   bool read_csv_ = false;
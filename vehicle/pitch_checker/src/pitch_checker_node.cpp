@@ -16,9 +16,9 @@
 
 #include "pitch_checker/pitch_checker.hpp"
 
+#include <limits>
 #include <memory>
 #include <string>
-#include <utility>
 #include <vector>
 
 PitchChecker::PitchChecker(const rclcpp::NodeOptions & node_options)
@@ -31,8 +31,13 @@ PitchChecker::PitchChecker(const rclcpp::NodeOptions & node_options)
 
   update_hz_ = this->declare_parameter<double>("update_hz", 10.0);
   output_file_ = this->declare_parameter<std::string>("output_file", "pitch.csv");
+  // the binary grid for PitchReader is also written unless this is empty
+  output_grid_file_ = this->declare_parameter<std::string>("output_grid_file", "");
+  query_yaw_threshold_ = this->declare_parameter<double>("query_yaw_threshold", M_PI_4);
   save_flag_server_ = this->create_service<std_srvs::srv::Trigger>(
     "/pitch_checker/save_flag", std::bind(&PitchChecker::onSaveService, this, _1, _2, _3));
+  get_pitch_server_ = this->create_service<tier4_calibration_msgs::srv::GetPitch>(
+    "/pitch_checker/get_pitch", std::bind(&PitchChecker::onGetPitchService, this, _1, _2));
   initTimer(1.0 / update_hz_);
 }
 
@@ -52,7 +57,6 @@ bool PitchChecker::onSaveService(
   [[maybe_unused]] const std::shared_ptr<std_srvs::srv::Trigger::Request> req,
   const std::shared_ptr<std_srvs::srv::Trigger::Response> res)
 {
-  pitchInfoToMap();
   if (writeMap()) {
     res->success = true;
     res->message = "Data has been successfully saved on " + output_file_;
@@ -64,16 +68,35 @@ bool PitchChecker::onSaveService(
   return true;
 }
 
+void PitchChecker::onGetPitchService(
+  const std::shared_ptr<tier4_calibration_msgs::srv::GetPitch::Request> req,
+  const std::shared_ptr<tier4_calibration_msgs::srv::GetPitch::Response> res)
+{
+  if (req->x.size() != req->y.size() || req->x.size() != req->yaw.size()) {
+    res->success = false;
+    res->message = "The sizes of x, y and yaw are different.";
+    return;
+  }
+  res->pitch.resize(req->x.size());
+  size_t num_found = 0;
+  {
+    std::lock_guard<std::mutex> lock(pitch_map_mutex_);
+    for (size_t i = 0; i < req->x.size(); ++i) {
+      double pitch = std::numeric_limits<double>::quiet_NaN();
+      if (pitch_map_.getPitch(&pitch, req->x[i], req->y[i], req->yaw[i], query_yaw_threshold_)) {
+        ++num_found;
+      }
+      res->pitch[i] = pitch;
+    }
+  }
+  res->success = true;
+  res->message = std::to_string(num_found) + " of " + std::to_string(req->x.size()) +
+                 " positions are in the pitch map.";
+}
+
 void PitchChecker::timerCallback()
 {
   getTf();
-  if (get_tf_count_ >= MAX_TF_COUNT_) {
-    RCLCPP_INFO_STREAM(
-      rclcpp::get_logger("pitch_compare"),
-      "Save data and stop recording due to capacity limitation.");
-    pitchInfoToMap();
-    writeMap();
-  }
 }
 
 bool PitchChecker::getTf()
@@ -91,83 +114,12 @@ bool PitchChecker::getTf()
   }
   double roll, pitch, yaw;
   tf2::getEulerYPR(transform->transform.rotation, roll, pitch, yaw);
-  TfInfo tf_info;
-  tf_info.pitch = pitch;
-  tf_info.yaw = yaw;
-  tf_info.x = transform->transform.translation.x;
-  tf_info.y = transform->transform.translation.y;
-  tf_info.z = transform->transform.translation.z;
-  tf_info_vec_.emplace_back(tf_info);
-  get_tf_count_++;
+  const auto & translation = transform->transform.translation;
+  std::lock_guard<std::mutex> lock(pitch_map_mutex_);
+  pitch_map_.add(translation.x, translation.y, translation.z, yaw, pitch);
   return true;
 }
 
-void PitchChecker::pitchInfoToMap()
-{
-  tf_map_.clear();
-  tf_map_unified_.clear();
-  for (const auto tf_info : tf_info_vec_) {
-    const int x_i = static_cast<int>(std::nearbyint(tf_info.x));
-    const int y_i = static_cast<int>(std::nearbyint(tf_info.y));
-    const auto xy_i = std::pair<int, int>(x_i, y_i);
-    // create new key
-    if (tf_map_.count(xy_i) == 0) {
-      tf_map_[xy_i] = std::vector<TfInfo>();
-    }
-    tf_map_[xy_i].emplace_back(tf_info);
-  }
-
-  for (const auto & map_val : tf_map_) {
-    const auto key = map_val.first;
-    const auto tf_info_vec = map_val.second;
-    if (tf_info_vec.empty()) {
-      continue;
-    }
-    std::vector<TfInfo> vec1;
-    std::vector<TfInfo> vec2;
-    // separate vec by yaw
-    for (const auto & tf_info : tf_info_vec) {
-      const double dyaw = std::fabs(tf_info.yaw - tf_info_vec.front().yaw);
-      if (dyaw < M_PI_2) {
-        vec1.emplace_back(tf_info);
-      } else {
-        vec2.emplace_back(tf_info);
-      }
-      tf_map_unified_[key] = std::vector<TfInfo>();
-      if (!vec1.empty()) {
-        tf_map_unified_[key].emplace_back(getMedianPitchTfInfo(vec1));
-      }
-      if (!vec2.empty()) {
-        tf_map_unified_[key].emplace_back(getMedianPitchTfInfo(vec2));
-      }
-    }
-  }
-}
-
-TfInfo PitchChecker::getMedianPitchTfInfo(const std::vector<TfInfo> & tf_info_vec)
-{
-  auto tf_info_vec_local = tf_info_vec;
-  std::sort(
-    tf_info_vec_local.begin(), tf_info_vec_local.end(),
-    [](const TfInfo & x, const TfInfo & y) { return x.pitch < y.pitch; });
-
-  if (tf_info_vec_local.size() % 2 == 0) {
-    const int mid_idx_1 = (tf_info_vec_local.size()) / 2;
-    const int mid_idx_2 = (tf_info_vec_local.size()) / 2 - 1;
-    TfInfo tf_info;
-    tf_info.x = (tf_info_vec_local.at(mid_idx_1).x + tf_info_vec_local.at(mid_idx_2).x) / 2.0;
-    tf_info.y = (tf_info_vec_local.at(mid_idx_1).y + tf_info_vec_local.at(mid_idx_2).y) / 2.0;
-    tf_info.z = (tf_info_vec_local.at(mid_idx_1).z + tf_info_vec_local.at(mid_idx_2).z) / 2.0;
-    tf_info.pitch =
-      (tf_info_vec_local.at(mid_idx_1).pitch + tf_info_vec_local.at(mid_idx_2).pitch) / 2.0;
-    tf_info.yaw = (tf_info_vec_local.at(mid_idx_1).yaw + tf_info_vec_local.at(mid_idx_2).yaw) / 2.0;
-    return tf_info;
-  } else {
-    const int mid_idx = (tf_info_vec_local.size() - 1) / 2;
-    return tf_info_vec_local.at(mid_idx);
-  }
-}
-
 bool PitchChecker::writeMap()
 {
   std::ofstream of(output_file_);
@@ -177,15 +129,21 @@ bool PitchChecker::writeMap()
     return false;
   }
 
+  std::vector<PitchMapEntry> entries;
+  {
+    std::lock_guard<std::mutex> lock(pitch_map_mutex_);
+    entries = pitch_map_.getEntries();
+  }
   of << "x,y,z,yaw,pitch" << std::endl;
-  for (const auto & map_val : tf_map_unified_) {
-    const auto key = map_val.first;
-    const int x = key.first;
-    const int y = key.second;
-    for (const auto tf_info : map_val.second) {
-      of << x << "," << y << "," << tf_info.z << "," << tf_info.yaw << "," << tf_info.pitch
-         << std::endl;
-    }
+  for (const auto & entry : entries) {
+    of << entry.x << "," << entry.y << "," << entry.z << "," << entry.yaw << "," << entry.pitch
+       << "\n";
+  }
+
+  if (!output_grid_file_.empty() && !writePitchGrid(output_grid_file_, entries)) {
+    RCLCPP_ERROR_STREAM(
+      rclcpp::get_logger("pitch_checker"), "cannot write the file: " << output_grid_file_);
+    return false;
   }
   return true;
 }
@@ -24,7 +24,12 @@
 
 PitchReader::PitchReader(const std::string input_file)
 {
-  read_csv_ = (readCSV(input_file, &tf_infos_));
+  // A binary pitch grid is memory-mapped, and a CSV is read into tf_infos_
+  if (PitchGrid::isPitchGridFile(input_file)) {
+    read_csv_ = pitch_grid_.open(input_file);
+  } else {
+    read_csv_ = (readCSV(input_file, &tf_infos_));
+  }
 }
 
 bool PitchReader::getPitch(
@@ -35,6 +40,11 @@ bool PitchReader::getPitch(
     return false;
   }
 
+  // The grid is interpolated among the neighboring cells instead of searching within dist_thresh
+  if (pitch_grid_.isOpen()) {
+    return pitch_grid_.getPitch(pitch, x, y, yaw, yaw_thresh);
+  }
+
   double min_dist = std::numeric_limits<double>::max();
   bool success_search = false;
   for (const auto & tf_info : tf_infos_) {
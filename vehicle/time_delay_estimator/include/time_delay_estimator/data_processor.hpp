@@ -19,6 +19,7 @@
 
 #include "estimator_utils/math_utils.hpp"
 #include "estimator_utils/optimization_utils.hpp"
+#include "estimator_utils/ring_buffer.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "time_delay_estimator/parameters.hpp"
 
@@ -26,7 +27,6 @@
 #include "std_msgs/msg/float64_multi_array.hpp"
 
 #include <cmath>
-#include <deque>
 #include <numeric>
 #include <string>
 #include <utility>
@@ -38,10 +38,10 @@ struct Data
   double value;
   double p_value = 0;
   double stamp = 0;
-  std::deque<double> stamps = {};
-  std::deque<double> validation = {};
-  std::deque<double> raw = {};
-  std::deque<double> filtered = {};
+  math_utils::RingBuffer<double> stamps;
+  math_utils::RingBuffer<double> validation;
+  math_utils::RingBuffer<double> raw;
+  math_utils::RingBuffer<double> filtered;
   std::vector<double> processed;
 
   void setValue(const double val, const double time)
@@ -49,6 +49,35 @@ struct Data
     value = val;
     stamp = time;
   }
+
+  /**
+   * @brief : allocate the buffers once, so that processing the data allocates nothing
+   * @param data_capacity : maximum size of stamps, raw and filtered
+   * @param validation_capacity : maximum size of validation
+   * @param processed_capacity : maximum size of processed
+   **/
+  void reserve(
+    const size_t data_capacity, const size_t validation_capacity, const size_t processed_capacity)
+  {
+    stamps.setCapacity(data_capacity);
+    validation.setCapacity(validation_capacity);
+    raw.setCapacity(data_capacity);
+    filtered.setCapacity(data_capacity);
+    processed.reserve(processed_capacity);
+  }
+
+  // clear the data and keep the buffers
+  void clear()
+  {
+    value = 0.0;
+    p_value = 0.0;
+    stamp = 0.0;
+    stamps.clear();
+    validation.clear();
+    raw.clear();
+    filtered.clear();
+    processed.clear();
+  }
 };
 
 struct Result
@@ -23,14 +23,33 @@
 #include "std_msgs/msg/float32_multi_array.hpp"
 #include "std_msgs/msg/float64_multi_array.hpp"
 
+#include <array>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 // ros pkg depend
 #include "time_delay_estimator/parameters.hpp"
 
 class Debugger
 {
 public:
-  Debugger(rclcpp::Node * node, const std::string & name)
+  enum class Topic : std::uint8_t {
+    VALUES = 0,
+    INPUT = 1,
+    RESPONSE = 2,
+    ESTIMATED = 3,
+    CORRELATION = 4,
+  };
+
+  /**
+   * @param values_publish_period : minimum period [s] of debug_values, 0 for every estimation
+   * @param arrays_publish_period : minimum period [s] of each of the other topics
+   **/
+  Debugger(
+    rclcpp::Node * node, const std::string & name, const double values_publish_period = 0.0,
+    const double arrays_publish_period = 0.0)
+  : clock_(node->get_clock())
   {
     // QoS setup
     static constexpr std::size_t queue_size = 1;
@@ -48,6 +67,50 @@ public:
     pub_debug_corr_ = node->create_publisher<std_msgs::msg::Float64MultiArray>(
       "~/debug_values/" + name + "_correlation", durable_qos);
     debug_values_.data.resize(num_debug_values_, 0.0);
+    publish_periods_.fill(arrays_publish_period);
+    publish_periods_[static_cast<size_t>(Topic::VALUES)] = values_publish_period;
+  }
+
+  /**
+   * @brief : the topic is published only if it has subscribers and its period has passed, so that
+   * the arrays are not even filled otherwise. A late subscriber gets the latched message of the
+   * next publication.
+   **/
+  bool shouldPublish(const Topic topic)
+  {
+    const auto & pub = getPublisher(topic);
+    if (pub.get_subscription_count() + pub.get_intra_process_subscription_count() == 0) {
+      return false;
+    }
+    const auto index = static_cast<size_t>(topic);
+    auto & last_publish_time = last_publish_times_[index];
+    const rclcpp::Time now = clock_->now();
+    // publish at once if the time jumps back, e.g. when a rosbag is replayed again
+    if (
+      last_publish_time && now >= *last_publish_time &&
+      (now - *last_publish_time).seconds() < publish_periods_[index]) {
+      return false;
+    }
+    last_publish_time = now;
+    return true;
+  }
+
+  /**
+   * @brief : publish the message filled by fill, in a loaned message if the middleware can loan
+   * it and by unique_ptr otherwise so that intra process subscribers do not copy it
+   **/
+  template <class MessageT, class Fill>
+  static void publish(const typename rclcpp::Publisher<MessageT>::SharedPtr & pub, Fill && fill)
+  {
+    if (pub->can_loan_messages()) {
+      auto loaned_message = pub->borrow_loaned_message();
+      fill(loaned_message.get());
+      pub->publish(std::move(loaned_message));
+    } else {
+      auto message = std::make_unique<MessageT>();
+      fill(*message);
+      pub->publish(std::move(message));
+    }
   }
 
   /* Debug */
@@ -96,8 +159,34 @@ public:
     LS2_DELAY = 31,        // [31] estimate delay
     LS2_MAE_AT_TIME = 33,  // [33] root squared error
   };
-  void publishDebugValue() { pub_debug_->publish(debug_values_); }
+  void publishDebugValue()
+  {
+    if (shouldPublish(Topic::VALUES)) {
+      pub_debug_->publish(debug_values_);
+    }
+  }
   ~Debugger() {}
+
+private:
+  rclcpp::Clock::SharedPtr clock_;
+  std::array<double, 5> publish_periods_{};
+  std::array<std::optional<rclcpp::Time>, 5> last_publish_times_;
+
+  const rclcpp::PublisherBase & getPublisher(const Topic topic) const
+  {
+    switch (topic) {
+      case Topic::INPUT:
+        return *pub_debug_input_;
+      case Topic::RESPONSE:
+        return *pub_debug_response_;
+      case Topic::ESTIMATED:
+        return *pub_debug_estimated_;
+      case Topic::CORRELATION:
+        return *pub_debug_corr_;
+      default:
+        return *pub_debug_;
+    }
+  }
 };
 
 #endif  // TIME_DELAY_ESTIMATOR__DEBUGGER_HPP_
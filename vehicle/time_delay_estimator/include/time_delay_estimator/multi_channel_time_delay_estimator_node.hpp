@@ -0,0 +1,109 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef TIME_DELAY_ESTIMATOR__MULTI_CHANNEL_TIME_DELAY_ESTIMATOR_NODE_HPP_
+#define TIME_DELAY_ESTIMATOR__MULTI_CHANNEL_TIME_DELAY_ESTIMATOR_NODE_HPP_
+
+#include "rclcpp/rclcpp.hpp"
+#include "time_delay_estimator/data_processor.hpp"
+#include "time_delay_estimator/parameters.hpp"
+#include "time_delay_estimator/time_delay_estimator.hpp"
+#include "time_delay_estimator/worker_pool.hpp"
+
+#include "autoware_vehicle_msgs/msg/control_mode_report.hpp"
+#include "std_msgs/msg/float32_multi_array.hpp"
+#include "tier4_calibration_msgs/msg/bool_stamped.hpp"
+#include "tier4_calibration_msgs/msg/float32_stamped.hpp"
+#include "tier4_calibration_msgs/msg/time_delay.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief : estimate the delays of several (cmd, status) pairs in one node. The data of all the
+ * channels is collected by one timer, and the channels are estimated in parallel by a pool of
+ * threads
+ **/
+class MultiChannelTimeDelayEstimatorNode : public rclcpp::Node
+{
+  using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
+  using ControlModeReport = autoware_vehicle_msgs::msg::ControlModeReport;
+  using IsEngaged = tier4_calibration_msgs::msg::BoolStamped;
+  using TimeDelay = tier4_calibration_msgs::msg::TimeDelay;
+  using Float32MultiArray = std_msgs::msg::Float32MultiArray;
+
+  struct Channel
+  {
+    std::string name;
+    MinMax valid_input;
+    double offset;
+    rclcpp::Subscription<Float32Stamped>::SharedPtr sub_input_cmd;
+    rclcpp::Subscription<Float32Stamped>::SharedPtr sub_input_status;
+    rclcpp::Publisher<TimeDelay>::SharedPtr pub_time_delay;
+    Float32Stamped::ConstSharedPtr input_cmd_ptr;
+    Float32Stamped::ConstSharedPtr input_status_ptr;
+    std::unique_ptr<TimeDelayEstimator> estimator;
+    TimeDelay time_delay;  // result of the last estimation
+  };
+
+  // values of each channel in the aggregated debug message
+  enum DEBUG_VALUE : std::uint8_t {
+    TIME_DELAY = 0,
+    MEAN = 1,
+    STDDEV = 2,
+    CORRELATION_PEAK = 3,
+    IS_VALID_DATA = 4,
+    NUM_DEBUG_VALUES = 5,
+  };
+
+private:
+  rclcpp::Subscription<ControlModeReport>::SharedPtr sub_control_mode_report_;
+  rclcpp::Subscription<IsEngaged>::SharedPtr sub_is_engaged_;
+  rclcpp::Publisher<Float32MultiArray>::SharedPtr pub_debug_;
+
+  // Timer
+  rclcpp::TimerBase::SharedPtr timer_estimation_;
+  rclcpp::TimerBase::SharedPtr timer_data_processing_;
+
+  std::vector<Channel> channels_;
+  std::unique_ptr<WorkerPool> worker_pool_;
+  std::string estimator_type_;
+  Float32MultiArray debug_values_;
+
+  double auto_mode_duration_ = 0;
+  double last_manual_time_;
+  double last_disengage_time_ = 0;
+  double engage_duration_ = 0;
+  bool detect_manual_engage_;
+
+  // for ros parameters
+  Params params_;
+
+  void callbackInputCmd(const size_t channel_idx, const Float32Stamped::ConstSharedPtr msg);
+  void callbackInputStatus(const size_t channel_idx, const Float32Stamped::ConstSharedPtr msg);
+  void callbackControlModeReport(const ControlModeReport::ConstSharedPtr msg);
+  void callbackEngage(const IsEngaged::ConstSharedPtr msg);
+  bool isEngaged() const;
+  void timerDataCollector();
+  void timerEstimation();
+
+public:
+  explicit MultiChannelTimeDelayEstimatorNode(const rclcpp::NodeOptions & node_options);
+  ~MultiChannelTimeDelayEstimatorNode() {}
+};
+
+#endif  // TIME_DELAY_ESTIMATOR__MULTI_CHANNEL_TIME_DELAY_ESTIMATOR_NODE_HPP_
@@ -17,6 +17,8 @@
 #ifndef TIME_DELAY_ESTIMATOR__PARAMETERS_HPP_
 #define TIME_DELAY_ESTIMATOR__PARAMETERS_HPP_
 
+#include "estimator_utils/filter_utils.hpp"
+
 struct Params
 {
   double sampling_hz;
@@ -32,12 +34,33 @@ struct Params
   double estimation_delta_time;
   double cutoff_hz_input;
   double cutoff_hz_output;
+  // coefficients of cutoff_hz_input at sampling_delta_time and cutoff_hz_output at
+  // estimation_delta_time, computed once with setFilterCoefficients
+  math_utils::LowpassCoefficient input_lowpass;
+  math_utils::LowpassCoefficient output_lowpass;
   bool reset_at_disengage;
   bool is_showing_debug_info;
+  // minimum periods [s] of the debug topics, which are published only with subscribers
+  double debug_values_publish_period;
+  double debug_arrays_publish_period;
   bool use_interpolation;
   int num_interpolation;
   int estimation_method;
+  bool use_fft_for_cross_correlation;
+  bool use_incremental_cross_correlation;
+  // search the delays of the decimated data, and then the delays around the best ones
+  bool use_coarse_to_fine_search;
+  int coarse_search_decimation;
+  int num_coarse_search_candidates;
   bool is_test_mode;
 };
 
+inline void setFilterCoefficients(Params & params)
+{
+  params.input_lowpass =
+    math_utils::LowpassCoefficient(params.cutoff_hz_input, params.sampling_delta_time);
+  params.output_lowpass =
+    math_utils::LowpassCoefficient(params.cutoff_hz_output, params.estimation_delta_time);
+}
+
 #endif  // TIME_DELAY_ESTIMATOR__PARAMETERS_HPP_
@@ -17,6 +17,7 @@
 #ifndef TIME_DELAY_ESTIMATOR__TIME_DELAY_ESTIMATOR_HPP_
 #define TIME_DELAY_ESTIMATOR__TIME_DELAY_ESTIMATOR_HPP_
 
+#include "estimator_utils/cross_correlation_utils.hpp"
 #include "estimator_utils/math_utils.hpp"
 #include "estimator_utils/optimization_utils.hpp"
 #include "rclcpp/rclcpp.hpp"
@@ -45,6 +46,7 @@ private:
     SLEEP = 1,
     DETECTED = 2,
   };
+  static constexpr int data_buffer_size_ = 2;  // extra data kept for fitting
   bool has_enough_input_ = false;
   bool has_enough_response_ = false;
   tier4_calibration_msgs::msg::TimeDelay time_delay_;
@@ -53,6 +55,10 @@ private:
   Estimator ls_estimator_;
   Estimator ls2_estimator_;
   std::vector<double> weights_for_data_;
+  math_utils::CrossCorrelationEngine cross_correlation_engine_;
+  math_utils::SlidingCrossCorrelation sliding_cross_correlation_;
+  bool use_incremental_cross_correlation_ = false;
+  size_t num_new_samples_ = 0;  // processed samples added since the last estimation
   std::string name_;
   bool is_valid_data_ = false;
   double max_current_stddev_ = 0;
@@ -78,6 +84,13 @@ private:
     rclcpp::Node * node, const std::vector<double> & input, const std::vector<double> & response,
     Estimator & corr, std::string name, const Params & params);
 
+  /**
+   * @brief : slide the window of sliding_cross_correlation_ to the latest input & response, or
+   * rebuild it if they are not the continuation of the window
+   **/
+  void updateSlidingCrossCorrelation(
+    const std::vector<double> & input, const std::vector<double> & response, const Params & params);
+
   enum DetectionResult estimateDelayByLeastSquared(
     const std::vector<double> & x2dot, const std::vector<double> & x_dot,
     const std::vector<double> & x, const std::vector<double> & u, const Params & params);
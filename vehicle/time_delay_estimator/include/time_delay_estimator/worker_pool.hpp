@@ -0,0 +1,129 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#ifndef TIME_DELAY_ESTIMATOR__WORKER_POOL_HPP_
+#define TIME_DELAY_ESTIMATOR__WORKER_POOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief : persistent threads to run independent tasks. The tasks of a run are claimed one by one
+ * by the workers and the calling thread, so a slow task does not hold the others back
+ **/
+class WorkerPool
+{
+public:
+  // num_threads includes the calling thread
+  explicit WorkerPool(const size_t num_threads)
+  {
+    for (size_t i = 1; i < std::max<size_t>(num_threads, 1); ++i) {
+      workers_.emplace_back([this]() { workerLoop(); });
+    }
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_stopped_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto & worker : workers_) {
+      worker.join();
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool & operator=(const WorkerPool &) = delete;
+
+  size_t numThreads() const { return workers_.size() + 1; }
+
+  /**
+   * @brief : run task(0), ..., task(num_tasks - 1) and wait for all of them
+   * @param num_tasks : number of tasks
+   * @param task : function called with the index of a task, which must not throw
+   **/
+  void run(const size_t num_tasks, const std::function<void(size_t)> & task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      task_ = &task;
+      num_tasks_ = num_tasks;
+      next_task_ = 0;
+      num_running_workers_ = workers_.size();
+      ++generation_;
+    }
+    start_cv_.notify_all();
+    runTasks(task, num_tasks);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return num_running_workers_ == 0; });
+    task_ = nullptr;
+  }
+
+private:
+  void runTasks(const std::function<void(size_t)> & task, const size_t num_tasks)
+  {
+    for (size_t i = next_task_++; i < num_tasks; i = next_task_++) {
+      task(i);
+    }
+  }
+
+  void workerLoop()
+  {
+    size_t generation = 0;
+    while (true) {
+      const std::function<void(size_t)> * task = nullptr;
+      size_t num_tasks = 0;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_cv_.wait(lock, [&]() { return is_stopped_ || generation_ != generation; });
+        if (is_stopped_) {
+          return;
+        }
+        generation = generation_;
+        task = task_;
+        num_tasks = num_tasks_;
+      }
+      runTasks(*task, num_tasks);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --num_running_workers_;
+      }
+      done_cv_.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  const std::function<void(size_t)> * task_ = nullptr;
+  size_t num_tasks_ = 0;
+  std::atomic<size_t> next_task_{0};
+  size_t num_running_workers_ = 0;
+  size_t generation_ = 0;
+  bool is_stopped_ = false;
+};
+
+#endif  // TIME_DELAY_ESTIMATOR__WORKER_POOL_HPP_
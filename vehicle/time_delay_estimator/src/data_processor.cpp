@@ -29,12 +29,11 @@ bool checkIsValidData(
     input.validation.emplace_back(input.value);
     response.validation.emplace_back(response.value);
   } else {
-    const double filtered_input = math_utils::lowpassFilter(
-      input.value, input.validation.back(), params.cutoff_hz_input, params.sampling_delta_time);
+    const double filtered_input =
+      params.input_lowpass.filter(input.value, input.validation.back());
     input.validation.emplace_back(filtered_input);
-    const double filtered_response = math_utils::lowpassFilter(
-      response.value, response.validation.back(), params.cutoff_hz_input,
-      params.sampling_delta_time);
+    const double filtered_response =
+      params.input_lowpass.filter(response.value, response.validation.back());
     response.validation.emplace_back(filtered_response);
   }
 
@@ -65,14 +64,14 @@ bool processInputData(Data & input, const Params & params, const int buffer)
   if (input.filtered.size() == 0) {
     input.filtered.emplace_back(input.value);
   } else {
-    const double filt = math_utils::lowpassFilter(
-      input.raw.back(), input.filtered.back(), params.cutoff_hz_input, params.sampling_delta_time);
+    const double filt = params.input_lowpass.filter(input.raw.back(), input.filtered.back());
     // Filtered
     input.filtered.emplace_back(filt);
-    input.processed = math_utils::arrToVector(input.filtered);
-    if (params.num_interpolation > 1 && input.processed.size() > 5) {
-      input.processed =
-        math_utils::getLinearInterpolation(input.processed, params.num_interpolation);
+    const auto filtered = input.filtered.span();
+    if (params.num_interpolation > 1 && filtered.size() > 5) {
+      math_utils::getLinearInterpolation(filtered, params.num_interpolation, input.processed);
+    } else {
+      input.processed.assign(filtered.begin(), filtered.end());
     }
   }
 
@@ -106,13 +105,14 @@ bool processResponseData(
   if (data.filtered.size() == 0) {
     data.filtered.emplace_back(data.value);
   } else {
-    const double filt = math_utils::lowpassFilter(
-      data.raw.back(), data.filtered.back(), params.cutoff_hz_input, params.sampling_delta_time);
+    const double filt = params.input_lowpass.filter(data.raw.back(), data.filtered.back());
     // Filtered
     data.filtered.emplace_back(filt);
-    data.processed = math_utils::arrToVector(data.filtered);
-    if (params.num_interpolation > 1 && data.processed.size() > 5) {
-      data.processed = math_utils::getLinearInterpolation(data.processed, params.num_interpolation);
+    const auto filtered = data.filtered.span();
+    if (params.num_interpolation > 1 && filtered.size() > 5) {
+      math_utils::getLinearInterpolation(filtered, params.num_interpolation, data.processed);
+    } else {
+      data.processed.assign(filtered.begin(), filtered.end());
     }
   }
   if (data.filtered.size() < 3) {
@@ -135,12 +135,10 @@ bool processResponseData(
     data_dot.filtered.emplace_back(diff);
     data_2dot.filtered.emplace_back(diff2);
     // Filtered
-    data_dot.processed = math_utils::arrToVector(data_dot.filtered);
-    data_2dot.processed = math_utils::arrToVector(data_2dot.filtered);
-    data_dot.processed =
-      math_utils::getLinearInterpolation(data_dot.processed, params.num_interpolation);
-    data_2dot.processed =
-      math_utils::getLinearInterpolation(data_2dot.processed, params.num_interpolation);
+    math_utils::getLinearInterpolation(
+      data_dot.filtered.span(), params.num_interpolation, data_dot.processed);
+    math_utils::getLinearInterpolation(
+      data_2dot.filtered.span(), params.num_interpolation, data_2dot.processed);
   }
 
   const auto data_raw_size = static_cast<int>(data.raw.size());
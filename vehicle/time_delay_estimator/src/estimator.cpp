@@ -17,35 +17,154 @@
 #include "estimator_utils/math_utils.hpp"
 #include "time_delay_estimator/time_delay_estimator.hpp"
 
+#include <autoware/task_scheduler/task_scheduler.hpp>
+
+#include <algorithm>
+#include <array>
+#include <functional>
 #include <limits>
+#include <numeric>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+namespace
+{
+// The shifts of the weighted cross correlation are computed on the threads of the shared scheduler
+void parallelForShifts(const size_t num_shift, const std::function<void(size_t)> & func)
+{
+  autoware::task_scheduler::TaskScheduler::global().parallel_for(num_shift, func);
+}
+
+// The delays of the least error searched by math_utils::searchShiftCoarseToFine, whose coarse
+// errors are of the regressors and u decimated from their newest samples
+template <int N>
+std::pair<int, double> searchLeastSquaredDelayCoarseToFine(
+  const std::array<const std::vector<double> *, N> & regressors, const std::vector<double> & u,
+  const size_t num_sample, const int maximum_delay, const Params & params,
+  Eigen::Matrix<double, N, 1> & w, double & min_error)
+{
+  if (maximum_delay <= 0) {
+    return {0, 0.0};
+  }
+  const int decimation = std::max(params.coarse_search_decimation, 1);
+  std::array<std::vector<double>, N> coarse_regressors;
+  std::array<const std::vector<double> *, N> coarse_regressor_ptrs;
+  for (int j = 0; j < N; ++j) {
+    const auto & regressor = *regressors[j];
+    math_utils::decimate(
+      regressor, (regressor.size() - 1) % decimation, decimation, coarse_regressors[j]);
+    coarse_regressor_ptrs[j] = &coarse_regressors[j];
+  }
+  std::vector<double> coarse_u;
+  math_utils::decimate(u, (u.size() - 1) % decimation, decimation, coarse_u);
+
+  const optimization_utils::LaggedLeastSquared<N> coarse_least_squared(
+    coarse_regressor_ptrs, num_sample / decimation);
+  std::vector<double> coarse_scores((maximum_delay - 1) / decimation + 1);
+  Eigen::Matrix<double, N, 1> coarse_w;
+  for (size_t d = 0; d < coarse_scores.size(); ++d) {
+    coarse_scores[d] = -coarse_least_squared.solve(coarse_u, d, coarse_w);
+  }
+
+  const optimization_utils::LaggedLeastSquared<N> least_squared(regressors, num_sample);
+  const size_t num_candidates =
+    static_cast<size_t>(std::max(params.num_coarse_search_candidates, 1));
+  std::vector<double> scores;
+  const auto delay = math_utils::searchShiftCoarseToFine(
+    coarse_scores, decimation, num_candidates, maximum_delay,
+    [&](const int d) {
+      Eigen::Matrix<double, N, 1> w_d;
+      return -least_squared.solve(u, d, w_d);
+    },
+    scores);
+  min_error = least_squared.solve(u, delay.first, w);
+  return delay;
+}
+
+// The peak of the weighted cross correlation searched by math_utils::searchShiftCoarseToFine, whose
+// coarse correlations are of the signals decimated from their newest samples
+std::pair<int, double> searchCrossCorrelationPeakCoarseToFine(
+  const std::vector<double> & input, const std::vector<double> & response,
+  const std::vector<double> & weights, const Params & params, std::vector<double> & cross_corr)
+{
+  const int num_shift =
+    std::max(static_cast<int>(input.size() * params.valid_delay_index_ratio) - 1, 0);
+  if (num_shift == 0 || input.size() != response.size()) {
+    cross_corr = math_utils::calcCrossCorrelationCoefficient(
+      input, response, weights, params.valid_delay_index_ratio, parallelForShifts);
+    return {math_utils::getMaximumIndexFromVector(cross_corr), 0.0};
+  }
+  const int decimation = std::max(params.coarse_search_decimation, 1);
+  const size_t first = (input.size() - 1) % decimation;
+  std::vector<double> coarse_input;
+  std::vector<double> coarse_response;
+  std::vector<double> coarse_weights;
+  math_utils::decimate(input, first, decimation, coarse_input);
+  math_utils::decimate(response, first, decimation, coarse_response);
+  // The weights are of the reversed signals, whose first sample is the newest one
+  math_utils::decimate(weights, 0, decimation, coarse_weights);
+  auto coarse_scores = math_utils::calcCrossCorrelationCoefficient(
+    coarse_input, coarse_response, coarse_weights, params.valid_delay_index_ratio,
+    parallelForShifts);
+  // The last coefficient is not computed
+  coarse_scores.resize(std::max(static_cast<int>(coarse_scores.size()) - 1, 0));
+
+  const size_t num_candidates =
+    static_cast<size_t>(std::max(params.num_coarse_search_candidates, 1));
+  // The signals are reversed once, and each shift is a range of them
+  const std::vector<double> r_input(input.rbegin(), input.rend());
+  const std::vector<double> r_response(response.rbegin(), response.rend());
+  const size_t num_weight = std::min(input.size(), weights.size());
+  const double weight_sum = std::accumulate(weights.begin(), weights.begin() + num_weight, 0.0);
+  const auto peak = math_utils::searchShiftCoarseToFine(
+    coarse_scores, decimation, num_candidates, num_shift,
+    [&](const int tau) {
+      return math_utils::getCorrelationCoefficientFromRange(
+        r_input.data() + tau, r_response.data(), weights.data(),
+        std::min(input.size() - tau, num_weight), weight_sum);
+    },
+    cross_corr);
+  // The coefficients which are not evaluated are 0 as the ones which are not computed
+  std::replace(cross_corr.begin(), cross_corr.end(), std::numeric_limits<double>::lowest(), 0.0);
+  cross_corr.push_back(0.0);
+  return peak;
+}
+}  // namespace
+
 TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSquared(
   const std::vector<double> & x_dot, const std::vector<double> & x, const std::vector<double> & u,
   const Params & params)
 {
   int num_sample = static_cast<int>(u.size() * (1.0 - params.valid_delay_index_ratio));
   int maximum_delay = static_cast<int>(u.size() * params.valid_delay_index_ratio);
-  std::vector<double> resample_y = {x.end() - num_sample, x.end()};
-  std::vector<double> resample_y_dot = {x_dot.end() - num_sample, x_dot.end()};
-  std::vector<double> resample_x;
+  Eigen::Vector2d w = Eigen::Vector2d::Zero();
   double min_error = std::numeric_limits<double>::max();
 
   int min_error_index = 0;
-  for (int d = 0; d < maximum_delay; d++) {
-    // assume std::vector(old,....,new)
-    resample_x = {u.end() - num_sample - d, u.end() - d};
-    double error_norm = optimization_utils::getLeastSquaredError(
-      resample_y_dot, resample_y, resample_x, ls_estimator_.w);
-    if (optimization_utils::change_abs_min(min_error, error_norm)) {
-      min_error = error_norm;
-      min_error_index = d;
+  double sub_sample_offset = 0.0;
+  if (params.use_coarse_to_fine_search) {
+    std::tie(min_error_index, sub_sample_offset) = searchLeastSquaredDelayCoarseToFine<2>(
+      {&x_dot, &x}, u, num_sample, maximum_delay, params, w, min_error);
+  } else {
+    // The regressors are the same for all the delays, and only the window of u slides
+    const optimization_utils::LaggedLeastSquared<2> least_squared({&x_dot, &x}, num_sample);
+    for (int d = 0; d < maximum_delay; d++) {
+      // assume std::vector(old,....,new)
+      double error_norm = least_squared.solve(u, d, w);
+      if (optimization_utils::change_abs_min(min_error, error_norm)) {
+        min_error = error_norm;
+        min_error_index = d;
+      }
     }
   }
+  if (maximum_delay > 0) {
+    ls_estimator_.w = w;
+  }
   ls_estimator_.mae = min_error;
   ls_estimator_.estimated_delay_index = min_error_index;
-  ls_estimator_.time_delay = static_cast<double>(min_error_index) * params.sampling_delta_time /
+  ls_estimator_.time_delay = (min_error_index + sub_sample_offset) * params.sampling_delta_time /
                              static_cast<double>(params.num_interpolation);
   const double valid_mae_threshold = 0.1;
   if (ls_estimator_.mae < valid_mae_threshold) {
@@ -60,26 +179,32 @@ TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSqua
 {
   int num_sample = static_cast<int>(u.size() * (1.0 - params.valid_delay_index_ratio));
   int maximum_delay = static_cast<int>(u.size() * params.valid_delay_index_ratio);
-  std::vector<double> resample_y = {x.end() - num_sample, x.end()};
-  std::vector<double> resample_y_dot = {x_dot.end() - num_sample, x_dot.end()};
-  std::vector<double> resample_y2dot = {x2dot.end() - num_sample, x2dot.end()};
-  std::vector<double> resample_x;
+  Eigen::Vector3d w = Eigen::Vector3d::Zero();
   double min_error = std::numeric_limits<double>::max();
   int min_error_index = 0;
-  min_error = std::numeric_limits<double>::max();
-  for (int d = 0; d < maximum_delay; d++) {
-    //  assume std::vector(old,....,new)
-    resample_x = {u.end() - num_sample - d, u.end() - d};
-    double error_norm = optimization_utils::getLeastSquaredError(
-      resample_y2dot, resample_y_dot, resample_y, resample_x, ls2_estimator_.w);
-    if (optimization_utils::change_abs_min(min_error, error_norm)) {
-      min_error = error_norm;
-      min_error_index = d;
+  double sub_sample_offset = 0.0;
+  if (params.use_coarse_to_fine_search) {
+    std::tie(min_error_index, sub_sample_offset) = searchLeastSquaredDelayCoarseToFine<3>(
+      {&x2dot, &x_dot, &x}, u, num_sample, maximum_delay, params, w, min_error);
+  } else {
+    // The regressors are the same for all the delays, and only the window of u slides
+    const optimization_utils::LaggedLeastSquared<3> least_squared(
+      {&x2dot, &x_dot, &x}, num_sample);
+    for (int d = 0; d < maximum_delay; d++) {
+      //  assume std::vector(old,....,new)
+      double error_norm = least_squared.solve(u, d, w);
+      if (optimization_utils::change_abs_min(min_error, error_norm)) {
+        min_error = error_norm;
+        min_error_index = d;
+      }
     }
   }
+  if (maximum_delay > 0) {
+    ls2_estimator_.w = w;
+  }
   ls2_estimator_.mae = min_error;
   ls2_estimator_.estimated_delay_index = min_error_index;
-  ls2_estimator_.time_delay = static_cast<double>(min_error_index) * params.sampling_delta_time /
+  ls2_estimator_.time_delay = (min_error_index + sub_sample_offset) * params.sampling_delta_time /
                               static_cast<double>(params.num_interpolation);
   const double valid_mae_threshold = 0.1;
   if (ls2_estimator_.mae < valid_mae_threshold) {
@@ -88,15 +213,58 @@ TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByLeastSqua
   return DetectionResult::BELOW_THRESH;
 }
 
+void TimeDelayEstimator::updateSlidingCrossCorrelation(
+  const std::vector<double> & input, const std::vector<double> & response, const Params & params)
+{
+  auto & sliding_cc = sliding_cross_correlation_;
+  const size_t n = input.size();
+  const size_t num_lag =
+    static_cast<size_t>(std::max(static_cast<int>(n * params.valid_delay_index_ratio) - 1, 0));
+  const size_t num_new = num_new_samples_;
+  num_new_samples_ = 0;
+  if (sliding_cc.windowSize() == n && sliding_cc.numLag() == num_lag && num_new < n) {
+    for (size_t i = n - num_new; i < n; ++i) {
+      sliding_cc.push(input[i], response[i]);
+    }
+    // The interpolated points are the same if no filtered data was dropped
+    const bool is_continuous = sliding_cc.size() == n && sliding_cc.input(0) == input.front() &&
+                               sliding_cc.response(0) == response.front() &&
+                               sliding_cc.input(n - 1) == input.back() &&
+                               sliding_cc.response(n - 1) == response.back();
+    if (is_continuous) {
+      return;
+    }
+  }
+  sliding_cc.reset(n, num_lag);
+  for (size_t i = 0; i < n; ++i) {
+    sliding_cc.push(input[i], response[i]);
+  }
+}
+
 TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByCrossCorrelation(
   rclcpp::Node * node, const std::vector<double> & input, const std::vector<double> & response,
   Estimator & cc_estimator, std::string name, const Params & params)
 {
   auto & cross_corr = cc_estimator.cross_correlation;
-  cross_corr = math_utils::calcCrossCorrelationCoefficient(
-    input, response, weights_for_data_, params.valid_delay_index_ratio);
   auto & peak_index = cc_estimator.estimated_delay_index;
-  peak_index = math_utils::getMaximumIndexFromVector(cross_corr);
+  double sub_sample_offset = 0.0;
+  if (use_incremental_cross_correlation_ && input.size() == response.size()) {
+    updateSlidingCrossCorrelation(input, response, params);
+    sliding_cross_correlation_.calcCrossCorrelationCoefficient(cross_corr);
+    peak_index = math_utils::getMaximumIndexFromVector(cross_corr);
+  } else if (params.use_coarse_to_fine_search) {
+    std::tie(peak_index, sub_sample_offset) = searchCrossCorrelationPeakCoarseToFine(
+      input, response, weights_for_data_, params, cross_corr);
+  } else {
+    if (params.use_fft_for_cross_correlation) {
+      cross_correlation_engine_.calcCrossCorrelationCoefficient(
+        input, response, weights_for_data_, params.valid_delay_index_ratio, cross_corr);
+    } else {
+      cross_corr = math_utils::calcCrossCorrelationCoefficient(
+        input, response, weights_for_data_, params.valid_delay_index_ratio, parallelForShifts);
+    }
+    peak_index = math_utils::getMaximumIndexFromVector(cross_corr);
+  }
   auto & peak_corr = cc_estimator.peak_correlation;
   peak_corr = cross_corr[peak_index];
   if (peak_corr < params.valid_peak_cross_correlation_threshold) {
@@ -107,7 +275,7 @@ TimeDelayEstimator::DetectionResult TimeDelayEstimator::estimateDelayByCrossCorr
     return DetectionResult::BELOW_THRESH;
   }
   cc_estimator.mae = math_utils::calcMAE(input, response, cc_estimator.estimated_delay_index);
-  cc_estimator.time_delay = static_cast<double>(peak_index) * params.sampling_delta_time /
+  cc_estimator.time_delay = (peak_index + sub_sample_offset) * params.sampling_delta_time /
                             static_cast<double>(params.num_interpolation);
   return DetectionResult::DETECTED;
 }
@@ -64,13 +64,27 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   params_.cutoff_hz_input = this->declare_parameter<double>("filter/cutoff_hz_input", 0.5);
   params_.cutoff_hz_output = this->declare_parameter<double>("filter/cutoff_hz_output", 0.1);
   params_.is_showing_debug_info = this->declare_parameter<bool>("is_showing_debug_info", true);
+  params_.debug_values_publish_period =
+    this->declare_parameter<double>("debug_values_publish_period", 0.0);
+  params_.debug_arrays_publish_period =
+    this->declare_parameter<double>("debug_arrays_publish_period", 0.0);
   // params_.is_test_mode = this->declare_parameter<bool>("test/is_test_mode", false);
   params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 3);
   params_.reset_at_disengage = this->declare_parameter<bool>("reset_at_disengage", false);
   bool use_weight_for_cross_correlation =
     this->declare_parameter<bool>("use_weight_for_cross_correlation", false);
+  params_.use_fft_for_cross_correlation =
+    this->declare_parameter<bool>("use_fft_for_cross_correlation", false);
+  params_.use_incremental_cross_correlation =
+    this->declare_parameter<bool>("use_incremental_cross_correlation", false);
+  params_.use_coarse_to_fine_search =
+    this->declare_parameter<bool>("use_coarse_to_fine_search", false);
+  params_.coarse_search_decimation = this->declare_parameter<int>("coarse_search_decimation", 4);
+  params_.num_coarse_search_candidates =
+    this->declare_parameter<int>("num_coarse_search_candidates", 3);
   params_.sampling_delta_time = 1.0 / params_.sampling_hz;
   params_.estimation_delta_time = 1.0 / params_.estimation_hz;
+  setFilterCoefficients(params_);
   params_.data_size = static_cast<int>(params_.sampling_hz * params_.sampling_duration);
   params_.validation_size = static_cast<int>(params_.sampling_hz * params_.validation_duration);
   valid_input_.min = this->declare_parameter<double>("min_valid_value", 0.05);
@@ -0,0 +1,297 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "time_delay_estimator/multi_channel_time_delay_estimator_node.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+double validateRange(
+  rclcpp::Node * node, const double min, const double max, const double val, std::string name)
+{
+  auto & clk = *node->get_clock();
+  if (min < std::abs(val) && std::abs(val) < max) {
+    RCLCPP_DEBUG_STREAM_THROTTLE(
+      rclcpp::get_logger("time_delay_estimator"), clk, 5000,
+      "[time_delay_estimator] " << name << ": " << val);
+    return val;
+  }
+  RCLCPP_DEBUG_STREAM_THROTTLE(
+    rclcpp::get_logger("time_delay_estimator"), clk, 5000, name << " is out of range: " << val);
+  return 0.0;
+}
+}  // namespace
+
+MultiChannelTimeDelayEstimatorNode::MultiChannelTimeDelayEstimatorNode(
+  const rclcpp::NodeOptions & node_options)
+: Node("multi_channel_time_delay_estimator", node_options)
+{
+  using std::placeholders::_1;
+
+  // QoS setup
+  static constexpr std::size_t queue_size = 1;
+  rclcpp::QoS durable_qos(queue_size);
+  durable_qos.transient_local();  // option for latching
+
+  // get parameter
+  detect_manual_engage_ = this->declare_parameter<bool>("detect_manual_engage", true);
+  params_.sampling_hz = this->declare_parameter<double>("data/sampling_hz", 30.0);
+  params_.estimation_hz = this->declare_parameter<double>("data/estimation_hz", 10.0);
+  params_.sampling_duration = this->declare_parameter<double>("data/sampling_duration", 5.0);
+  params_.validation_duration = this->declare_parameter<double>("data/validation_duration", 1.0);
+  params_.valid_peak_cross_correlation_threshold =
+    this->declare_parameter<double>("data/valid_peak_cross_correlation_threshold", 0.8);
+  params_.valid_delay_index_ratio =
+    this->declare_parameter<double>("data/valid_delay_index_ratio", 0.1);
+  params_.cutoff_hz_input = this->declare_parameter<double>("filter/cutoff_hz_input", 0.5);
+  params_.cutoff_hz_output = this->declare_parameter<double>("filter/cutoff_hz_output", 0.1);
+  params_.is_showing_debug_info = this->declare_parameter<bool>("is_showing_debug_info", true);
+  params_.debug_values_publish_period =
+    this->declare_parameter<double>("debug_values_publish_period", 0.0);
+  params_.debug_arrays_publish_period =
+    this->declare_parameter<double>("debug_arrays_publish_period", 0.0);
+  params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 3);
+  params_.reset_at_disengage = this->declare_parameter<bool>("reset_at_disengage", false);
+  bool use_weight_for_cross_correlation =
+    this->declare_parameter<bool>("use_weight_for_cross_correlation", false);
+  params_.use_fft_for_cross_correlation =
+    this->declare_parameter<bool>("use_fft_for_cross_correlation", false);
+  params_.use_incremental_cross_correlation =
+    this->declare_parameter<bool>("use_incremental_cross_correlation", false);
+  params_.use_coarse_to_fine_search =
+    this->declare_parameter<bool>("use_coarse_to_fine_search", false);
+  params_.coarse_search_decimation = this->declare_parameter<int>("coarse_search_decimation", 4);
+  params_.num_coarse_search_candidates =
+    this->declare_parameter<int>("num_coarse_search_candidates", 3);
+  params_.is_test_mode = false;
+  params_.sampling_delta_time = 1.0 / params_.sampling_hz;
+  params_.estimation_delta_time = 1.0 / params_.estimation_hz;
+  setFilterCoefficients(params_);
+  params_.data_size = static_cast<int>(params_.sampling_hz * params_.sampling_duration);
+  params_.validation_size = static_cast<int>(params_.sampling_hz * params_.validation_duration);
+  params_.total_data_size =
+    static_cast<int>(params_.sampling_duration * params_.sampling_hz * params_.num_interpolation) +
+    1;
+  estimator_type_ = this->declare_parameter<std::string>("estimator_type", "cc");
+  const auto channel_names =
+    this->declare_parameter<std::vector<std::string>>("channels", std::vector<std::string>{});
+  const int num_threads = this->declare_parameter<int>("num_threads", 0);
+
+  if (channel_names.empty()) {
+    RCLCPP_ERROR(get_logger(), "[time_delay_estimator] no channel is given by the channels param");
+  }
+
+  last_manual_time_ = this->now().seconds();
+  sub_control_mode_report_ = create_subscription<ControlModeReport>(
+    "~/input/control_mode", queue_size,
+    std::bind(&MultiChannelTimeDelayEstimatorNode::callbackControlModeReport, this, _1));
+  sub_is_engaged_ = create_subscription<IsEngaged>(
+    "~/input/is_engage", queue_size,
+    std::bind(&MultiChannelTimeDelayEstimatorNode::callbackEngage, this, _1));
+
+  // channels, each of which is a pair of cmd and status topics
+  // The outputs of the calibration adapter in the same container are received without a copy,
+  // while the latched outputs of this node keep the inter-process communication.
+  rclcpp::SubscriptionOptions input_options;
+  input_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  channels_.resize(channel_names.size());
+  for (size_t i = 0; i < channel_names.size(); ++i) {
+    auto & channel = channels_[i];
+    const auto & name = channel_names[i];
+    channel.name = name;
+    channel.valid_input.min = this->declare_parameter<double>(name + "/min_valid_value", 0.05);
+    channel.valid_input.max = this->declare_parameter<double>(name + "/max_valid_value", 1.00);
+    channel.offset = this->declare_parameter<double>(name + "/offset_value", 0.0);
+    const auto input_cmd_topic =
+      this->declare_parameter<std::string>(name + "/input_cmd_topic", "~/input/" + name + "/cmd");
+    const auto input_status_topic = this->declare_parameter<std::string>(
+      name + "/input_status_topic", "~/input/" + name + "/status");
+
+    channel.estimator = std::make_unique<TimeDelayEstimator>(
+      this, params_, name, params_.total_data_size, use_weight_for_cross_correlation);
+    channel.sub_input_cmd = create_subscription<Float32Stamped>(
+      input_cmd_topic, queue_size,
+      [this, i](const Float32Stamped::ConstSharedPtr msg) { callbackInputCmd(i, msg); },
+      input_options);
+    channel.sub_input_status = create_subscription<Float32Stamped>(
+      input_status_topic, queue_size,
+      [this, i](const Float32Stamped::ConstSharedPtr msg) { callbackInputStatus(i, msg); },
+      input_options);
+    channel.pub_time_delay =
+      create_publisher<TimeDelay>("~/output/" + name + "/time_delay", durable_qos);
+    RCLCPP_INFO(
+      get_logger(), "[time_delay_estimator] channel %zu: %s (%s, %s)", i, name.c_str(),
+      input_cmd_topic.c_str(), input_status_topic.c_str());
+  }
+
+  // The estimation of each channel is independent, so the channels are run in parallel
+  const size_t max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  const size_t pool_size = num_threads > 0 ? static_cast<size_t>(num_threads)
+                                           : std::min(max_threads, channels_.size());
+  worker_pool_ = std::make_unique<WorkerPool>(pool_size);
+
+  // debug values of all the channels in the order of the channels param
+  pub_debug_ = create_publisher<Float32MultiArray>("~/debug_values/time_delay", durable_qos);
+  debug_values_.layout.dim.resize(2);
+  debug_values_.layout.dim[0].label = "channel";
+  debug_values_.layout.dim[0].size = channels_.size();
+  debug_values_.layout.dim[0].stride = channels_.size() * NUM_DEBUG_VALUES;
+  debug_values_.layout.dim[1].label = "value";
+  debug_values_.layout.dim[1].size = NUM_DEBUG_VALUES;
+  debug_values_.layout.dim[1].stride = NUM_DEBUG_VALUES;
+  debug_values_.data.assign(channels_.size() * NUM_DEBUG_VALUES, 0.0);
+
+  // data processing callback
+  {
+    auto data_processing_callback =
+      std::bind(&MultiChannelTimeDelayEstimatorNode::timerDataCollector, this);
+    const auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(params_.sampling_delta_time));
+    timer_data_processing_ =
+      std::make_shared<rclcpp::GenericTimer<decltype(data_processing_callback)>>(
+        this->get_clock(), period_ns, std::move(data_processing_callback),
+        this->get_node_base_interface()->get_context());
+    this->get_node_timers_interface()->add_timer(timer_data_processing_, nullptr);
+  }
+  // estimation callback
+  {
+    auto estimation_callback =
+      std::bind(&MultiChannelTimeDelayEstimatorNode::timerEstimation, this);
+    const auto period_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(params_.estimation_delta_time));
+    timer_estimation_ = std::make_shared<rclcpp::GenericTimer<decltype(estimation_callback)>>(
+      this->get_clock(), period_ns, std::move(estimation_callback),
+      this->get_node_base_interface()->get_context());
+    this->get_node_timers_interface()->add_timer(timer_estimation_, nullptr);
+  }
+}
+
+bool MultiChannelTimeDelayEstimatorNode::isEngaged() const
+{
+  return !(std::min(auto_mode_duration_, engage_duration_) < 5.0 && detect_manual_engage_);
+}
+
+void MultiChannelTimeDelayEstimatorNode::timerDataCollector()
+{
+  if (!isEngaged()) {
+    if (params_.reset_at_disengage) {
+      for (auto & channel : channels_) {
+        channel.estimator->resetEstimator();
+      }
+    }
+    return;
+  }
+  for (auto & channel : channels_) {
+    if (channel.input_cmd_ptr && channel.input_status_ptr) {
+      channel.estimator->preprocessData(this);
+    }
+  }
+}
+
+void MultiChannelTimeDelayEstimatorNode::timerEstimation()
+{
+  if (!isEngaged()) {
+    return;
+  }
+  std::chrono::system_clock::time_point start, end;
+  start = std::chrono::system_clock::now();
+
+  // Each task only touches its own channel, and the subscriptions wait for the end of run()
+  worker_pool_->run(channels_.size(), [this](const size_t i) {
+    auto & channel = channels_[i];
+    if (channel.input_cmd_ptr && channel.input_status_ptr) {
+      channel.time_delay = channel.estimator->estimateTimeDelay(this, estimator_type_);
+    }
+  });
+
+  for (size_t i = 0; i < channels_.size(); ++i) {
+    const auto & channel = channels_[i];
+    if (channel.input_cmd_ptr && channel.input_status_ptr) {
+      channel.pub_time_delay->publish(channel.time_delay);
+    }
+    auto * values = &debug_values_.data[i * NUM_DEBUG_VALUES];
+    values[TIME_DELAY] = channel.time_delay.time_delay;
+    values[MEAN] = channel.time_delay.mean;
+    values[STDDEV] = channel.time_delay.stddev;
+    values[CORRELATION_PEAK] = channel.time_delay.correlation_peak;
+    values[IS_VALID_DATA] = static_cast<float>(channel.time_delay.is_valid_data);
+  }
+  pub_debug_->publish(debug_values_);
+
+  end = std::chrono::system_clock::now();
+  double elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  RCLCPP_DEBUG_STREAM_THROTTLE(
+    rclcpp::get_logger("time_delay_estimator"), *this->get_clock(), 10000,
+    "duration[microSec]: " << elapsed);
+}
+
+void MultiChannelTimeDelayEstimatorNode::callbackInputCmd(
+  const size_t channel_idx, const Float32Stamped::ConstSharedPtr msg)
+{
+  auto & channel = channels_[channel_idx];
+  channel.input_cmd_ptr = msg;
+  const auto & t = this->get_clock()->now().seconds();
+  const double input = validateRange(
+    this, channel.valid_input.min, channel.valid_input.max, msg->data, channel.name);
+  channel.estimator->input_.setValue(input + channel.offset, t);
+}
+
+void MultiChannelTimeDelayEstimatorNode::callbackInputStatus(
+  const size_t channel_idx, const Float32Stamped::ConstSharedPtr msg)
+{
+  auto & channel = channels_[channel_idx];
+  channel.input_status_ptr = msg;
+  const auto & t = this->get_clock()->now().seconds();
+  const double response = validateRange(
+    this, channel.valid_input.min, channel.valid_input.max, msg->data, channel.name + " response");
+  channel.estimator->response_.setValue(response + channel.offset, t);
+}
+
+void MultiChannelTimeDelayEstimatorNode::callbackControlModeReport(
+  const ControlModeReport::ConstSharedPtr msg)
+{
+  if (msg->mode == ControlModeReport::AUTONOMOUS) {
+    auto_mode_duration_ = (this->now().seconds() - last_manual_time_);
+  } else {
+    auto_mode_duration_ = 0;
+    last_manual_time_ = this->now().seconds();
+  }
+}
+
+void MultiChannelTimeDelayEstimatorNode::callbackEngage(const IsEngaged::ConstSharedPtr msg)
+{
+  auto & clk = *this->get_clock();
+  if (msg->data) {
+    engage_duration_ = (this->now().seconds() - last_disengage_time_);
+  } else {
+    engage_duration_ = 0;
+    last_disengage_time_ = this->now().seconds();
+    RCLCPP_INFO_STREAM_THROTTLE(
+      rclcpp::get_logger("time_delay_estimator"), clk, 5000,
+      "[time_delay_estimator] engage mode : disengage");
+  }
+}
+
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(MultiChannelTimeDelayEstimatorNode)
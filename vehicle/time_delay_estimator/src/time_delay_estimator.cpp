@@ -19,6 +19,7 @@
 #include "time_delay_estimator/data_processor.hpp"
 #include "time_delay_estimator/parameters.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -28,7 +29,8 @@ TimeDelayEstimator::TimeDelayEstimator(
   bool use_weight_for_cross_correlation)
 {
   params_ = params;
-  debugger_ = std::make_unique<Debugger>(node, name);
+  debugger_ = std::make_unique<Debugger>(
+    node, name, params.debug_values_publish_period, params.debug_arrays_publish_period);
   this->name_ = name;
   ignore_thresh_ = node->declare_parameter<double>(name + "/min_stddev_threshold", 0.005);
   weights_for_data_.clear();
@@ -39,6 +41,23 @@ TimeDelayEstimator::TimeDelayEstimator(
       weights_for_data_.emplace_back(static_cast<double>(1.0));
     }
   }
+  // The data is pushed before the old data is popped, and the fail safe pops one more
+  const size_t data_capacity = static_cast<size_t>(params.data_size + data_buffer_size_ + 1);
+  const size_t validation_capacity = static_cast<size_t>(params.validation_size + 1);
+  const size_t processed_capacity =
+    data_capacity * static_cast<size_t>(std::max(params.num_interpolation, 1));
+  for (auto * data : {&input_, &response_, &response_dot_, &response_2dot_}) {
+    data->reserve(data_capacity, validation_capacity, processed_capacity);
+  }
+  // The running sums of the sliding window hold only for uniform weights
+  use_incremental_cross_correlation_ = params.use_incremental_cross_correlation;
+  if (use_incremental_cross_correlation_ && use_weight_for_cross_correlation) {
+    RCLCPP_WARN(
+      node->get_logger(),
+      "[time_delay_estimator] %s: incremental cross correlation is not available with weights",
+      name.c_str());
+    use_incremental_cross_correlation_ = false;
+  }
 }
 
 void TimeDelayEstimator::resetEstimator()
@@ -50,11 +69,13 @@ void TimeDelayEstimator::resetEstimator()
   has_enough_input_ = false;
   has_enough_response_ = false;
   max_current_stddev_ = 0;
-  input_ = {};
-  response_ = {};
-  response_dot_ = {};
-  response_2dot_ = {};
+  input_.clear();
+  response_.clear();
+  response_dot_.clear();
+  response_2dot_.clear();
   time_delay_ = tier4_calibration_msgs::msg::TimeDelay();
+  sliding_cross_correlation_.reset(0, 0);
+  num_new_samples_ = 0;
 }
 
 void TimeDelayEstimator::preprocessData(rclcpp::Node * node)
@@ -63,10 +84,10 @@ void TimeDelayEstimator::preprocessData(rclcpp::Node * node)
     is_valid_data_ = data_processor::checkIsValidData(
       input_, response_, params_, max_current_stddev_, ignore_thresh_);
     if (is_valid_data_) {
-      const int buffer = 2;
-      has_enough_input_ = data_processor::processInputData(input_, params_, buffer);
+      has_enough_input_ = data_processor::processInputData(input_, params_, data_buffer_size_);
       has_enough_response_ = data_processor::processResponseData(
-        node, response_, response_dot_, response_2dot_, params_, buffer);
+        node, response_, response_dot_, response_2dot_, params_, data_buffer_size_);
+      num_new_samples_ += static_cast<size_t>(std::max(params_.num_interpolation, 1));
     }
   } catch (std::runtime_error & e) {  // Handle runtime errors
     std::cerr << "[time_delay_estimator] at preprocessData runtime_error: " << e.what()
@@ -112,52 +133,45 @@ void TimeDelayEstimator::processDebugData(rclcpp::Node * node)
     de.data[debugger_->LEAST_SQUARED_SECOND::LS2_DELAY] = ls2_estimator_.time_delay;
     de.data[debugger_->LEAST_SQUARED_SECOND::LS2_MAE_AT_TIME] = ls2_estimator_.mae;
     debugger_->publishDebugValue();
-    std_msgs::msg::Float32MultiArray input_data;
-    std_msgs::msg::Float32MultiArray response_data;
-    std_msgs::msg::Float32MultiArray estimated_data;
-    auto & input_dim = input_data.layout.dim;
-    input_dim.resize(1);
-    input_dim[0].size = params_.total_data_size;
-    auto & response_dim = response_data.layout.dim;
-    response_dim.resize(1);
-    response_dim[0].size = params_.total_data_size;
-    auto & estimated_dim = estimated_data.layout.dim;
-    estimated_dim.resize(1);
-    estimated_dim[0].size = params_.total_data_size;
-    int size = static_cast<int>(input_.processed.size() * (1.0 + params_.valid_delay_index_ratio));
-    if (params_.is_showing_debug_info) {
-      // for input & response
-      for (int i = 0; i < size; i += 1) {
-        if (i < static_cast<int>(input_.processed.size())) {
-          input_data.data.emplace_back(input_.processed[i]);
-          response_data.data.emplace_back(response_.processed[i]);
-        } else {
-          input_data.data.emplace_back(0);
-          response_data.data.emplace_back(0);
-        }
-        int slide_index = i + cc_estimator_.estimated_delay_index;
-        if (slide_index < static_cast<int>(response_.processed.size())) {
-          estimated_data.data.emplace_back(response_.processed[slide_index]);
-        } else {
-          estimated_data.data.emplace_back(0);
-        }
+    if (!params_.is_showing_debug_info || cc_estimator_.cross_correlation.empty()) {
+      return;
+    }
+    // The arrays are filled only for the topics to publish
+    const size_t size = static_cast<size_t>(
+      static_cast<int>(input_.processed.size() * (1.0 + params_.valid_delay_index_ratio)));
+    using Float32MultiArray = std_msgs::msg::Float32MultiArray;
+    const auto fill_data = [&](Float32MultiArray & msg, const auto & data, const size_t offset) {
+      msg.layout.dim.resize(1);
+      msg.layout.dim[0].size = params_.total_data_size;
+      msg.data.assign(size, 0.0f);
+      for (size_t i = 0; i < size && i + offset < data.size(); ++i) {
+        msg.data[i] = static_cast<float>(data[i + offset]);
       }
-      // for cross correlation
-      std_msgs::msg::Float64MultiArray corr_data;
-      if (cc_estimator_.cross_correlation.size() > 0) {
-        for (int i = 0; i < size; i += 1) {
-          if (i == cc_estimator_.estimated_delay_index) {
-            corr_data.data.emplace_back(1);
-          } else {
-            corr_data.data.emplace_back(0);
+    };
+    if (debugger_->shouldPublish(Debugger::Topic::INPUT)) {
+      Debugger::publish<Float32MultiArray>(
+        debugger_->pub_debug_input_, [&](auto & msg) { fill_data(msg, input_.processed, 0); });
+    }
+    if (debugger_->shouldPublish(Debugger::Topic::RESPONSE)) {
+      Debugger::publish<Float32MultiArray>(
+        debugger_->pub_debug_response_,
+        [&](auto & msg) { fill_data(msg, response_.processed, 0); });
+    }
+    if (debugger_->shouldPublish(Debugger::Topic::ESTIMATED)) {
+      Debugger::publish<Float32MultiArray>(
+        debugger_->pub_debug_estimated_, [&](auto & msg) {
+          fill_data(msg, response_.processed, cc_estimator_.estimated_delay_index);
+        });
+    }
+    // for cross correlation
+    if (debugger_->shouldPublish(Debugger::Topic::CORRELATION)) {
+      Debugger::publish<std_msgs::msg::Float64MultiArray>(
+        debugger_->pub_debug_corr_, [&](auto & msg) {
+          msg.data.assign(size, 0.0);
+          if (static_cast<size_t>(cc_estimator_.estimated_delay_index) < size) {
+            msg.data[cc_estimator_.estimated_delay_index] = 1.0;
           }
-        }
-        // cross correlation
-        debugger_->pub_debug_input_->publish(input_data);
-        debugger_->pub_debug_response_->publish(response_data);
-        debugger_->pub_debug_estimated_->publish(estimated_data);
-        debugger_->pub_debug_corr_->publish(corr_data);
-      }
+        });
     }
   }
 }
@@ -166,9 +180,8 @@ void TimeDelayEstimator::postprocessOutput(Estimator & estimator)
 {
   // stash initial result
   const int ignore_count = 50;
-  estimator.time_delay = math_utils::lowpassFilter(
-    estimator.time_delay, estimator.time_delay_prev, params_.cutoff_hz_output,
-    params_.estimation_delta_time);
+  estimator.time_delay =
+    params_.output_lowpass.filter(estimator.time_delay, estimator.time_delay_prev);
   if (loop_count_ < ignore_count) {
     estimator.time_delay_prev = cc_estimator_.time_delay;
   } else {
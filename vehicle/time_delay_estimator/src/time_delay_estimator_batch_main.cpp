@@ -0,0 +1,265 @@
+//
+//  Copyright 2024 Tier IV, Inc. All rights reserved.
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+// Estimate the time delays from a rosbag2 file without replaying it. The messages are read in
+// order, and the data processing and the estimation of the live nodes are called at their
+// periods of the bag time, so a bag is processed as fast as the CPU allows.
+
+#include "time_delay_estimator/data_processor.hpp"
+#include "time_delay_estimator/parameters.hpp"
+#include "time_delay_estimator/time_delay_estimator.hpp"
+
+#include <ament_index_cpp/get_package_share_directory.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rosbag2_cpp/readers/sequential_reader.hpp>
+#include <rosbag2_storage/metadata_io.hpp>
+#include <rosbag2_storage/storage_filter.hpp>
+
+#include "autoware_vehicle_msgs/msg/control_mode_report.hpp"
+#include "tier4_calibration_msgs/msg/float32_stamped.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+using Float32Stamped = tier4_calibration_msgs::msg::Float32Stamped;
+using ControlModeReport = autoware_vehicle_msgs::msg::ControlModeReport;
+
+struct Channel
+{
+  std::string name;
+  std::string input_cmd_topic;
+  std::string input_status_topic;
+  MinMax valid_input;
+  double offset;
+  bool has_input_cmd = false;
+  bool has_input_status = false;
+  std::unique_ptr<TimeDelayEstimator> estimator;
+};
+
+// the same as validateRange of the nodes, without logging
+double validateRange(const double min, const double max, const double val)
+{
+  return (min < std::abs(val) && std::abs(val) < max) ? val : 0.0;
+}
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  if (argc < 3 || 4 < argc) {
+    std::cout << "Usage: " << argv[0] << " <rosbag_path> <output_csv> [param_yaml]" << std::endl;
+    return 1;
+  }
+  const std::string rosbag_path = argv[1];
+  const std::string output_path = argv[2];
+  const std::string param_path =
+    argc >= 4 ? argv[3]
+              : ament_index_cpp::get_package_share_directory("time_delay_estimator") +
+                  "/config/time_delay_estimator_batch_param.yaml";
+
+  // The node is only used for the parameters of TimeDelayEstimator and is never spun
+  rclcpp::init(1, argv);
+  rclcpp::NodeOptions node_options;
+  node_options.arguments({"--ros-args", "--params-file", param_path});
+  auto node = std::make_shared<rclcpp::Node>("time_delay_estimator_batch_tool", node_options);
+
+  Params params;
+  const bool detect_manual_engage = node->declare_parameter<bool>("detect_manual_engage", true);
+  params.sampling_hz = node->declare_parameter<double>("data/sampling_hz", 30.0);
+  params.estimation_hz = node->declare_parameter<double>("data/estimation_hz", 10.0);
+  params.sampling_duration = node->declare_parameter<double>("data/sampling_duration", 5.0);
+  params.validation_duration = node->declare_parameter<double>("data/validation_duration", 1.0);
+  params.valid_peak_cross_correlation_threshold =
+    node->declare_parameter<double>("data/valid_peak_cross_correlation_threshold", 0.8);
+  params.valid_delay_index_ratio =
+    node->declare_parameter<double>("data/valid_delay_index_ratio", 0.1);
+  params.cutoff_hz_input = node->declare_parameter<double>("filter/cutoff_hz_input", 0.5);
+  params.cutoff_hz_output = node->declare_parameter<double>("filter/cutoff_hz_output", 0.1);
+  params.is_showing_debug_info = node->declare_parameter<bool>("is_showing_debug_info", false);
+  params.debug_values_publish_period =
+    node->declare_parameter<double>("debug_values_publish_period", 0.0);
+  params.debug_arrays_publish_period =
+    node->declare_parameter<double>("debug_arrays_publish_period", 0.0);
+  params.num_interpolation = node->declare_parameter<int>("data/num_interpolation", 3);
+  params.reset_at_disengage = node->declare_parameter<bool>("reset_at_disengage", false);
+  const bool use_weight_for_cross_correlation =
+    node->declare_parameter<bool>("use_weight_for_cross_correlation", false);
+  params.use_fft_for_cross_correlation =
+    node->declare_parameter<bool>("use_fft_for_cross_correlation", false);
+  params.use_incremental_cross_correlation =
+    node->declare_parameter<bool>("use_incremental_cross_correlation", false);
+  params.use_coarse_to_fine_search =
+    node->declare_parameter<bool>("use_coarse_to_fine_search", false);
+  params.coarse_search_decimation = node->declare_parameter<int>("coarse_search_decimation", 4);
+  params.num_coarse_search_candidates =
+    node->declare_parameter<int>("num_coarse_search_candidates", 3);
+  params.is_test_mode = false;
+  params.sampling_delta_time = 1.0 / params.sampling_hz;
+  params.estimation_delta_time = 1.0 / params.estimation_hz;
+  setFilterCoefficients(params);
+  params.data_size = static_cast<int>(params.sampling_hz * params.sampling_duration);
+  params.validation_size = static_cast<int>(params.sampling_hz * params.validation_duration);
+  params.total_data_size =
+    static_cast<int>(params.sampling_duration * params.sampling_hz * params.num_interpolation) + 1;
+  const auto estimator_type = node->declare_parameter<std::string>("estimator_type", "cc");
+  const auto control_mode_topic =
+    node->declare_parameter<std::string>("control_mode_topic", "/vehicle/status/control_mode");
+  const auto channel_names =
+    node->declare_parameter<std::vector<std::string>>("channels", std::vector<std::string>{});
+
+  std::vector<Channel> channels(channel_names.size());
+  std::map<std::string, std::pair<size_t, bool>> topic_to_channel;  // index and is_cmd
+  for (size_t i = 0; i < channel_names.size(); ++i) {
+    auto & channel = channels[i];
+    const auto & name = channel_names[i];
+    channel.name = name;
+    channel.input_cmd_topic = node->declare_parameter<std::string>(name + "/input_cmd_topic");
+    channel.input_status_topic =
+      node->declare_parameter<std::string>(name + "/input_status_topic");
+    channel.valid_input.min = node->declare_parameter<double>(name + "/min_valid_value", 0.05);
+    channel.valid_input.max = node->declare_parameter<double>(name + "/max_valid_value", 1.00);
+    channel.offset = node->declare_parameter<double>(name + "/offset_value", 0.0);
+    channel.estimator = std::make_unique<TimeDelayEstimator>(
+      node.get(), params, name, params.total_data_size, use_weight_for_cross_correlation);
+    topic_to_channel[channel.input_cmd_topic] = {i, true};
+    topic_to_channel[channel.input_status_topic] = {i, false};
+  }
+  if (channels.empty()) {
+    std::cerr << "No channel is given by the channels param in " << param_path << std::endl;
+    return 1;
+  }
+
+  // Prepare rosbag reader
+  rosbag2_storage::StorageOptions storage_options;
+  storage_options.uri = rosbag_path;
+  rosbag2_storage::MetadataIo metadata_io;
+  storage_options.storage_id = metadata_io.metadata_file_exists(rosbag_path)
+                                 ? metadata_io.read_metadata(rosbag_path).storage_identifier
+                                 : "sqlite3";
+  rosbag2_cpp::ConverterOptions converter_options;
+  converter_options.input_serialization_format = "cdr";
+  converter_options.output_serialization_format = "cdr";
+  rosbag2_cpp::readers::SequentialReader reader;
+  reader.open(storage_options, converter_options);
+
+  // Read only the topics used for the estimation
+  rosbag2_storage::StorageFilter storage_filter;
+  for (const auto & topic : topic_to_channel) {
+    storage_filter.topics.push_back(topic.first);
+  }
+  if (detect_manual_engage) {
+    storage_filter.topics.push_back(control_mode_topic);
+  }
+  reader.set_filter(storage_filter);
+
+  std::ofstream output_file(output_path);
+  if (!output_file) {
+    std::cerr << "Failed to open " << output_path << std::endl;
+    return 1;
+  }
+  output_file << "time,channel,time_delay,mean,stddev,correlation_peak,is_valid_data" << std::endl;
+
+  // The timers of the live nodes are replaced by the ticks of the bag time
+  double next_sampling_time = -1.0;
+  double next_estimation_time = -1.0;
+  double last_manual_time = -1.0;
+  double auto_mode_duration = 0.0;
+  const auto is_engaged = [&]() { return !detect_manual_engage || auto_mode_duration >= 5.0; };
+  const auto process_until = [&](const double t) {
+    while (next_sampling_time <= t || next_estimation_time <= t) {
+      if (next_sampling_time <= next_estimation_time) {
+        for (auto & channel : channels) {
+          if (!is_engaged()) {
+            if (params.reset_at_disengage) {
+              channel.estimator->resetEstimator();
+            }
+          } else if (channel.has_input_cmd && channel.has_input_status) {
+            channel.estimator->preprocessData(node.get());
+          }
+        }
+        next_sampling_time += params.sampling_delta_time;
+        continue;
+      }
+      for (auto & channel : channels) {
+        if (!is_engaged() || !channel.has_input_cmd || !channel.has_input_status) {
+          continue;
+        }
+        const auto time_delay = channel.estimator->estimateTimeDelay(node.get(), estimator_type);
+        output_file << std::fixed << next_estimation_time << "," << channel.name << ","
+                    << time_delay.time_delay << "," << time_delay.mean << ","
+                    << time_delay.stddev << "," << time_delay.correlation_peak << ","
+                    << static_cast<int>(time_delay.is_valid_data) << "\n";
+      }
+      next_estimation_time += params.estimation_delta_time;
+    }
+  };
+
+  rclcpp::Serialization<Float32Stamped> serialization_float32;
+  rclcpp::Serialization<ControlModeReport> serialization_control_mode;
+  size_t num_messages = 0;
+  while (reader.has_next()) {
+    const auto serialized_message = reader.read_next();
+    const double t = static_cast<double>(serialized_message->time_stamp) * 1e-9;
+    if (next_sampling_time < 0.0) {
+      next_sampling_time = t;
+      next_estimation_time = t;
+      last_manual_time = t;
+    }
+    process_until(t);
+
+    rclcpp::SerializedMessage msg(*serialized_message->serialized_data);
+    if (serialized_message->topic_name == control_mode_topic) {
+      ControlModeReport control_mode_msg;
+      serialization_control_mode.deserialize_message(&msg, &control_mode_msg);
+      if (control_mode_msg.mode == ControlModeReport::AUTONOMOUS) {
+        auto_mode_duration = t - last_manual_time;
+      } else {
+        auto_mode_duration = 0.0;
+        last_manual_time = t;
+      }
+      continue;
+    }
+    const auto iter = topic_to_channel.find(serialized_message->topic_name);
+    if (iter == topic_to_channel.end()) {
+      continue;
+    }
+    Float32Stamped float32_msg;
+    serialization_float32.deserialize_message(&msg, &float32_msg);
+    auto & channel = channels[iter->second.first];
+    const double value =
+      validateRange(channel.valid_input.min, channel.valid_input.max, float32_msg.data) +
+      channel.offset;
+    if (iter->second.second) {
+      channel.has_input_cmd = true;
+      channel.estimator->input_.setValue(value, t);
+    } else {
+      channel.has_input_status = true;
+      channel.estimator->response_.setValue(value, t);
+    }
+    ++num_messages;
+  }
+
+  std::cout << "Processed " << num_messages << " messages, wrote " << output_path << std::endl;
+  rclcpp::shutdown();
+  return 0;
+}
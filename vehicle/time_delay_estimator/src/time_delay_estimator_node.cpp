@@ -64,14 +64,28 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
   params_.cutoff_hz_input = this->declare_parameter<double>("filter/cutoff_hz_input", 0.5);
   params_.cutoff_hz_output = this->declare_parameter<double>("filter/cutoff_hz_output", 0.1);
   params_.is_showing_debug_info = this->declare_parameter<bool>("is_showing_debug_info", true);
+  params_.debug_values_publish_period =
+    this->declare_parameter<double>("debug_values_publish_period", 0.0);
+  params_.debug_arrays_publish_period =
+    this->declare_parameter<double>("debug_arrays_publish_period", 0.0);
   params_.is_test_mode = this->declare_parameter<bool>("test/is_test_mode", false);
   params_.num_interpolation = this->declare_parameter<int>("data/num_interpolation", 3);
   params_.reset_at_disengage = this->declare_parameter<bool>("reset_at_disengage", false);
   estimator_type_ = this->declare_parameter<std::string>("estimator_type", "cc");
   bool use_weight_for_cross_correlation =
     this->declare_parameter<bool>("use_weight_for_cross_correlation", false);
+  params_.use_fft_for_cross_correlation =
+    this->declare_parameter<bool>("use_fft_for_cross_correlation", false);
+  params_.use_incremental_cross_correlation =
+    this->declare_parameter<bool>("use_incremental_cross_correlation", false);
+  params_.use_coarse_to_fine_search =
+    this->declare_parameter<bool>("use_coarse_to_fine_search", false);
+  params_.coarse_search_decimation = this->declare_parameter<int>("coarse_search_decimation", 4);
+  params_.num_coarse_search_candidates =
+    this->declare_parameter<int>("num_coarse_search_candidates", 3);
   params_.sampling_delta_time = 1.0 / params_.sampling_hz;
   params_.estimation_delta_time = 1.0 / params_.estimation_hz;
+  setFilterCoefficients(params_);
   params_.data_size = static_cast<int>(params_.sampling_hz * params_.sampling_duration);
   params_.validation_size = static_cast<int>(params_.sampling_hz * params_.validation_duration);
   valid_steer_.min = this->declare_parameter<double>("steer/valid_min_steer", 0.05);
@@ -91,24 +105,28 @@ TimeDelayEstimatorNode::TimeDelayEstimatorNode(const rclcpp::NodeOptions & node_
     std::bind(&TimeDelayEstimatorNode::callbackControlModeReport, this, _1));
 
   // response
+  // The outputs of the calibration adapter in the same container are received without a copy,
+  // while the latched outputs of this node keep the inter-process communication.
+  rclcpp::SubscriptionOptions input_options;
+  input_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   sub_accel_cmd_ = create_subscription<Float32Stamped>(
     "~/input/accel_cmd", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackAccelCmd, this, _1));
+    std::bind(&TimeDelayEstimatorNode::callbackAccelCmd, this, _1), input_options);
   sub_brake_cmd_ = create_subscription<Float32Stamped>(
     "~/input/brake_cmd", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackBrakeCmd, this, _1));
+    std::bind(&TimeDelayEstimatorNode::callbackBrakeCmd, this, _1), input_options);
   sub_steer_cmd_ = create_subscription<Float32Stamped>(
     "~/input/steer_cmd", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackSteerCmd, this, _1));
+    std::bind(&TimeDelayEstimatorNode::callbackSteerCmd, this, _1), input_options);
   sub_accel_status_ = create_subscription<Float32Stamped>(
     "~/input/accel_status", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackAccelStatus, this, _1));
+    std::bind(&TimeDelayEstimatorNode::callbackAccelStatus, this, _1), input_options);
   sub_brake_status_ = create_subscription<Float32Stamped>(
     "~/input/brake_status", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackBrakeStatus, this, _1));
+    std::bind(&TimeDelayEstimatorNode::callbackBrakeStatus, this, _1), input_options);
   sub_steer_status_ = create_subscription<Float32Stamped>(
     "~/input/steer_status", queue_size,
-    std::bind(&TimeDelayEstimatorNode::callbackSteerStatus, this, _1));
+    std::bind(&TimeDelayEstimatorNode::callbackSteerStatus, this, _1), input_options);
   sub_is_engaged_ = create_subscription<BoolStamped>(
     "~/input/is_engage", queue_size, std::bind(&TimeDelayEstimatorNode::callbackEngage, this, _1));
 
@@ -356,3 +374,6 @@ void TimeDelayEstimatorNode::callbackTestData()
   test_data_->input_.setValue(input, t);
   test_data_->response_.setValue(response, t);
 }
+
+#include <rclcpp_components/register_node_macro.hpp>
+RCLCPP_COMPONENTS_REGISTER_NODE(TimeDelayEstimatorNode)